@@ -0,0 +1,109 @@
+# Allocation test, run via 'make alloc-test' or directly:
+#
+#   openmsx -script build/alloc_test.tcl
+#
+# Needs a build with heap allocation tracking (meson option 'alloctracking' or
+# 'make OPENMSX_ALLOC_TRACKING=true'). Runs a reference machine and checks
+# that, once it runs in a steady state, the emulation doesn't do any heap
+# allocations anymore. The allocations done by Tcl scripts (including this
+# one) and on other threads (e.g. the host audio driver) are reported, but
+# don't make the test fail. Exits with code 1 when the test fails.
+#
+# Environment variables:
+#   OPENMSX_ALLOC_TEST_MACHINE  machine to test (default: C-BIOS_MSX2+)
+
+namespace eval alloc_test {
+
+variable machine [expr {[info exists ::env(OPENMSX_ALLOC_TEST_MACHINE)]
+                        ? $::env(OPENMSX_ALLOC_TEST_MACHINE) : "C-BIOS_MSX2+"}]
+variable warmup   2  ;# emulated seconds before measuring
+variable duration 10 ;# emulated seconds that are measured
+variable frames   0
+variable ignored  {tcl other_threads}
+
+# Write the PSG sound registers over and over, with changing values (the same
+# program as the 'sound' workload in build/bench.tcl).
+#     di
+#     ld   e,0
+# 1:  ld   b,14
+# 2:  ld   a,b
+#     dec  a
+#     out  (0xA0),a
+#     ld   a,e
+#     out  (0xA1),a
+#     inc  e
+#     djnz 2b
+#     jr   1b
+variable program {0xF3 0x1E 0x00 0x06 14 0x78 0x3D 0xD3 0xA0
+                  0x7B 0xD3 0xA1 0x1C 0x10 -10 0x18 -14}
+
+proc fail {message} {
+	puts stderr "Allocation test FAILED: $message"
+	exit 1
+}
+
+proc count_frame {} {
+	variable frames
+	incr frames
+	after frame [namespace code count_frame]
+}
+
+proc start {} {
+	variable machine
+	if {[catch {openmsx_info performance heap} error_result]} {
+		fail $error_result
+	}
+	if {[catch {machine $machine} error_result]} {
+		fail $error_result
+	}
+	after time 5 [namespace code warmup]
+}
+
+proc warmup {} {
+	variable program
+	variable warmup
+	debug write_block memory 0xC000 [binary format c* $program]
+	reg PC 0xC000
+	after time $warmup [namespace code measure]
+}
+
+proc measure {} {
+	variable duration
+	variable frames 0
+	count_frame
+	set before [openmsx_info performance heap]
+	after time $duration [namespace code [list report $before]]
+}
+
+proc report {before} {
+	variable frames
+	variable ignored
+	set now [openmsx_info performance heap]
+	set failed false
+	puts "Heap allocations during $frames frames:"
+	dict for {stage count} $now {
+		set delta [expr {$count - ([dict exists $before $stage] ? [dict get $before $stage] : 0)}]
+		if {$delta == 0} continue
+		set perFrame [format %.2f [expr {double($delta) / max($frames, 1)}]]
+		if {$stage in $ignored} {
+			puts "  $stage: $delta ($perFrame per frame, ignored)"
+		} else {
+			puts "  $stage: $delta ($perFrame per frame)"
+			set failed true
+		}
+	}
+	if {$failed} {
+		fail "the emulation allocates in a steady state"
+	}
+	puts "Allocation test passed."
+	exit
+}
+
+set ::save_settings_on_exit false
+set ::throttle off
+set ::renderer none
+set ::auto_enable_reverse off
+
+after realtime 0 [namespace code start]
+
+} ;# namespace alloc_test
@@ -0,0 +1,339 @@
+# Benchmark suite, run via 'make bench' or directly:
+#
+#   openmsx -script build/bench.tcl
+#
+# Runs a fixed set of emulation workloads with the throttle disabled and
+# writes the results as JSON. Everything is reproducible: the same machine,
+# the same MSX programs and no host input, only the real time differs.
+#
+# Environment variables:
+#   OPENMSX_BENCH_OUTPUT        result file (default: bench.json)
+#   OPENMSX_BENCH_MACHINE       machine for the workloads (default: C-BIOS_MSX2+)
+#   OPENMSX_BENCH_R800_MACHINE  turbo R machine for the R800 workload (skipped
+#                               when not set, C-BIOS has no turbo R machine)
+#   OPENMSX_BENCH_SCALERS       when set to 1 also benchmark the scalers (this
+#                               opens a window)
+
+namespace eval bench {
+
+proc getenv {name default} {
+	expr {[info exists ::env($name)] ? $::env($name) : $default}
+}
+
+variable output   [getenv OPENMSX_BENCH_OUTPUT bench.json]
+variable machine  [getenv OPENMSX_BENCH_MACHINE C-BIOS_MSX2+]
+variable r800     [getenv OPENMSX_BENCH_R800_MACHINE ""]
+variable scalers  [getenv OPENMSX_BENCH_SCALERS 0]
+variable duration 20 ;# emulated seconds per timed workload
+variable results  [list]
+variable queue    [list]
+
+# Helpers
+
+proc json_value {value} {
+	if {[string is double -strict $value]} {
+		return $value
+	}
+	return "\"[string map {\\ \\\\ \" \\\" \n \\n} $value]\""
+}
+
+proc add_result {name args} {
+	variable results
+	set fields [list "\"name\": [json_value $name]"]
+	foreach {key value} $args {
+		lappend fields "\"$key\": [json_value $value]"
+	}
+	lappend results "    \{[join $fields {, }]\}"
+	puts stderr "bench: $name $args"
+}
+
+proc write_results {} {
+	variable output
+	variable machine
+	variable results
+	set f [open $output w]
+	puts $f "\{"
+	puts $f "  \"version\": [json_value [openmsx_info version]],"
+	puts $f "  \"machine\": [json_value $machine],"
+	puts $f "  \"results\": \["
+	puts $f [join $results ",\n"]
+	puts $f "  \]"
+	puts $f "\}"
+	close $f
+}
+
+# Run the next workload. Workloads either call 'measure' (which continues
+# with the next workload once enough emulated time has passed), or call
+# 'next_workload' themselves.
+proc next_workload {} {
+	variable queue
+	if {[llength $queue] == 0} {
+		write_results
+		exit
+	}
+	set queue [lassign $queue workload]
+	after realtime 0 [namespace code [list run $workload]]
+}
+
+proc run {workload} {
+	if {[catch $workload error_result]} {
+		add_result [join [lrange $workload 0 1] _] skipped $error_result
+		next_workload
+	}
+}
+
+# Switch to the given machine and wait till it has booted.
+proc boot {config cmd} {
+	machine $config
+	after time 5 [namespace code [list run $cmd]]
+}
+
+# Copy a program into RAM (page 3 is RAM on all machines) and run it.
+proc start_program {bytes} {
+	debug write_block memory 0xC000 [binary format c* $bytes]
+	reg PC 0xC000
+}
+
+proc measure {name} {
+	variable duration
+	set start [clock microseconds]
+	after time $duration [namespace code [list measure_done $name $start]]
+}
+
+proc measure_done {name start} {
+	variable duration
+	set real [expr {([clock microseconds] - $start) / 1e6}]
+	add_result $name emu_seconds $duration real_seconds $real \
+	                 speed [expr {$duration / $real}]
+	next_workload
+}
+
+# Run a (synchronous) command 'count' times and report the time per call.
+proc measure_calls {name count cmd} {
+	set start [clock microseconds]
+	for {set i 0} {$i < $count} {incr i} {
+		uplevel 1 $cmd
+	}
+	set ms [expr {([clock microseconds] - $start) / 1e3 / $count}]
+	add_result $name iterations $count ms_per_iteration $ms
+}
+
+# MSX programs (loaded at 0xC000)
+
+#     di
+#     ld   hl,0
+# 1:  ld   a,(hl)
+#     inc  hl
+#     add  a,b
+#     ld   b,a
+#     jr   1b
+variable cpu_loop {0xF3 0x21 0x00 0x00 0x7E 0x23 0x80 0x47 0x18 -6}
+
+#     ld   a,5
+#     call CHGMOD
+#     di
+# 1:  ld   a,2              ; select S#2
+#     out  (0x99),a
+#     ld   a,0x8F
+#     out  (0x99),a
+# 2:  in   a,(0x99)         ; wait till CE is reset
+#     rrca
+#     jr   c,2b
+#     ld   a,36             ; R#17 = 36, auto increment
+#     out  (0x99),a
+#     ld   a,0x91
+#     out  (0x99),a
+#     ld   hl,params
+#     ld   bc,0x0B9B
+#     otir                  ; HMMV 256x212
+#     jp   1b
+# params: dx=0, dy=0, nx=256, ny=212, clr=0xAA, arg=0, cmd=HMMV
+variable vdp_storm {
+	0x3E 0x05 0xCD 0x5F 0x00 0xF3
+	0x3E 0x02 0xD3 0x99 0x3E 0x8F 0xD3 0x99
+	0xDB 0x99 0x0F 0x38 -5
+	0x3E 0x24 0xD3 0x99 0x3E 0x91 0xD3 0x99
+	0x21 0x28 0xC0 0x01 0x9B 0x0B 0xED 0xB3 0xC3 0x06 0xC0
+	0x00 0x00
+	0x00 0x00 0x00 0x00 0x00 0x01 0xD4 0x00 0xAA 0x00 0xC0
+}
+
+# Write all registers of a sound chip over and over, with changing values.
+#     di
+#     ld   e,0
+# 1:  ld   b,<num-regs>
+# 2:  ld   a,b
+#     dec  a
+#     out  (<addr-port>),a
+#     ld   a,e
+#     out  (<data-port>),a
+#     inc  e
+#     djnz 2b
+#     jr   1b
+proc sound_program {addr_port data_port num_regs} {
+	list 0xF3 0x1E 0x00 0x06 $num_regs 0x78 0x3D 0xD3 $addr_port \
+	     0x7B 0xD3 $data_port 0x1C 0x10 -10 0x18 -14
+}
+
+# Workloads
+
+proc z80_loop {} {
+	variable machine
+	boot $machine z80_loop2
+}
+proc z80_loop2 {} {
+	variable cpu_loop
+	start_program $cpu_loop
+	measure z80_loop
+}
+
+proc r800_loop {} {
+	variable r800
+	if {$r800 eq ""} {error "OPENMSX_BENCH_R800_MACHINE not set"}
+	boot $r800 r800_loop2
+}
+proc r800_loop2 {} {
+	variable cpu_loop
+	# S1990 register 6: switch to R800 ROM mode
+	debug write ioports 0xE4 6
+	debug write ioports 0xE5 0x40
+	start_program $cpu_loop
+	measure r800_loop
+}
+
+proc vdp_commands {} {
+	variable machine
+	boot $machine vdp_commands2
+}
+proc vdp_commands2 {} {
+	variable vdp_storm
+	start_program $vdp_storm
+	measure vdp_commands
+}
+
+# name, extension (empty for built-in), address port, data port, #registers
+variable sound_chips {
+	PSG     ""        0xA0 0xA1 14
+	YM2413  ""        0x7C 0x7D 0x39
+	Y8950   audio     0xC0 0xC1 0xC9
+	YMF278  moonsound 0xC4 0xC5 0xF6
+}
+
+proc sound {} {
+	variable sound_chips
+	variable queue
+	set workloads [list]
+	foreach {chip ext addr data regs} $sound_chips {
+		lappend workloads [list sound_chip $chip $ext $addr $data $regs]
+	}
+	set queue [concat $workloads $queue]
+	next_workload
+}
+proc sound_chip {chip ext addr data regs} {
+	variable machine
+	machine $machine
+	if {$ext ne ""} {
+		ext $ext
+	}
+	after time 5 [namespace code [list run [list sound_chip2 $chip $addr $data $regs]]]
+}
+proc sound_chip2 {chip addr data regs} {
+	start_program [sound_program $addr $data $regs]
+	measure "sound_$chip"
+}
+
+proc scalers {} {
+	variable scalers
+	variable machine
+	variable queue
+	if {!$scalers} {error "OPENMSX_BENCH_SCALERS not set"}
+	set ::renderer SDL
+	set ::minframeskip 0
+	set ::maxframeskip 0
+	set workloads [list]
+	foreach alg [lindex [openmsx_info setting scale_algorithm] 2] {
+		foreach factor {2 3} {
+			lappend workloads [list scaler $alg $factor]
+		}
+	}
+	lappend workloads scalers_done
+	set queue [concat $workloads $queue]
+	boot $machine vdp_commands_program
+}
+proc vdp_commands_program {} {
+	variable vdp_storm
+	start_program $vdp_storm
+	next_workload
+}
+proc scaler {alg factor} {
+	set ::scale_algorithm $alg
+	set ::scale_factor $factor
+	measure "scaler_${alg}_x$factor"
+}
+proc scalers_done {} {
+	set ::renderer none
+	next_workload
+}
+
+proc reverse {} {
+	variable machine
+	boot $machine reverse2
+}
+proc reverse2 {} {
+	variable vdp_storm
+	::reverse start
+	start_program $vdp_storm
+	variable duration
+	set start [clock microseconds]
+	after time $duration [namespace code [list reverse3 $start]]
+}
+proc reverse3 {start} {
+	measure_done reverse_recording $start
+	# measure_done already scheduled the next workload, but that only
+	# runs after this proc returns
+	set begin [dict get [::reverse status] begin]
+	set end   [dict get [::reverse status] end]
+	set i 0
+	measure_calls reverse_goto 20 {
+		::reverse goto [expr {$begin + ($end - $begin) * (($i * 7) % 20) / 20.0}]
+		incr i
+	}
+	::reverse stop
+}
+
+proc savestate {} {
+	variable machine
+	boot $machine savestate2
+}
+proc savestate2 {} {
+	variable vdp_storm
+	start_program $vdp_storm
+	after time 1 [namespace code [list run savestate3]]
+}
+proc savestate3 {} {
+	variable output
+	set file [file rootname $output].state
+	set id [machine]
+	foreach format {xml binary} {
+		measure_calls "savestate_save_$format" 10 {
+			store_machine -format $format $id $file
+		}
+		measure_calls "savestate_load_$format" 10 {
+			delete_machine [restore_machine $file]
+		}
+	}
+	file delete $file
+	next_workload
+}
+
+# Main
+
+set ::save_settings_on_exit false
+set ::throttle off
+set ::renderer none
+set ::auto_enable_reverse off
+
+set queue [list z80_loop r800_loop vdp_commands sound scalers reverse savestate]
+after realtime 0 [namespace code next_workload]
+
+} ;# namespace bench
@@ -10,5 +10,12 @@ ifneq ($(OPENMSX_TARGET_OS),mingw32)
 CXXFLAGS+=-fomit-frame-pointer
 endif
 
+# Use threaded-code dispatch (computed goto's) in the Z80/R800 emulation on
+# CPUs that have good indirect branch prediction. See the comments in
+# src/cpu/CPUCore.cc and build/flavour-super-opt.mk for the trade-offs.
+ifneq ($(filter x86 x86_64,$(OPENMSX_TARGET_CPU)),)
+CXXFLAGS+=-DUSE_COMPUTED_GOTO
+endif
+
 # Strip executable?
 OPENMSX_STRIP:=true
@@ -0,0 +1,33 @@
+# This flavour uses profile guided optimization (PGO): the compiler uses
+# profile data, collected while running an instrumented build, to decide which
+# code to optimize for speed, how to lay out the code, which branches are
+# likely, etc.
+# This currently only works with gcc. Building takes three steps:
+#
+#   make OPENMSX_FLAVOUR=pgo PGO=generate
+#   make OPENMSX_FLAVOUR=pgo PGO=generate bench
+#   make OPENMSX_FLAVOUR=pgo clean
+#   make OPENMSX_FLAVOUR=pgo PGO=use
+#
+# The 'bench' target runs the benchmark workloads (see build/bench.tcl), any
+# other use of the instrumented executable adds to the profile as well. The
+# profile data is stored outside the build directory, so it survives the
+# 'clean' step. Delete that directory to start a new profile. Without PGO set
+# this flavour is the same as the 'opt' flavour.
+
+# Start with generic optimisation flags.
+include build/flavour-opt.mk
+
+PGO_PROFILE_DIR:=$(CURDIR)/derived/pgo-profile
+
+ifeq ($(PGO),generate)
+COMPILE_FLAGS+=-fprofile-generate=$(PGO_PROFILE_DIR)
+LINK_FLAGS+=-fprofile-generate=$(PGO_PROFILE_DIR)
+else ifeq ($(PGO),use)
+# - partial-training: code that wasn't executed during training is still
+#   optimized normally (instead of for size), the benchmarks don't cover
+#   everything.
+# - missing-profile: don't warn for files that didn't run at all.
+COMPILE_FLAGS+=-fprofile-use=$(PGO_PROFILE_DIR) -fprofile-partial-training \
+               -Wno-missing-profile
+endif
@@ -19,4 +19,7 @@ CXXFLAGS+=-march=native -mtune=native
 # - Compiling src/cpu/CPUCore.cc with computed goto's enabled is very demanding
 #   on the compiler. On older gcc versions it requires upto 1.5GB of memory.
 #   But even on more recent gcc versions it still requires around 700MB.
+# Note: on x86 and x86_64 the generic opt flavour already enables this.
+ifeq ($(filter x86 x86_64,$(OPENMSX_TARGET_CPU)),)
 CXXFLAGS+=-DUSE_COMPUTED_GOTO
+endif
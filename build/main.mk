@@ -53,7 +53,7 @@ endif
 # TODO: "dist" and "createsubs" are missing
 # TODO: more missing?
 # Logical targets which require dependency files.
-DEPEND_TARGETS:=all default install run bindist
+DEPEND_TARGETS:=all default install run bench alloc-test bindist
 # Logical targets which do not require dependency files.
 NODEPEND_TARGETS:=clean config probe 3rdparty run-3rdparty staticbindist
 # Mark all logical targets as such.
@@ -364,6 +364,14 @@ else
 endif
 endif
 
+# Count the heap allocations per emulation stage (see src/utils/AllocCounters.hh
+# and the 'alloc-test' target)? Do a 'make clean' when changing this.
+OPENMSX_ALLOC_TRACKING?=false
+$(call BOOLCHECK,OPENMSX_ALLOC_TRACKING)
+ifeq ($(OPENMSX_ALLOC_TRACKING),true)
+  COMPILE_FLAGS+=-DOPENMSX_ALLOC_TRACKING
+endif
+
 # Strip binary?
 OPENMSX_STRIP?=false
 $(call BOOLCHECK,OPENMSX_STRIP)
@@ -543,6 +551,18 @@ run: all
 	$(SUM) "Running $(notdir $(BINARY_FULL))..."
 	$(CMD)$(BINARY_FULL)
 
+# Run the benchmark suite, see build/bench.tcl for the details.
+BENCH_OUTPUT:=$(BUILD_PATH)/bench.json
+bench: all
+	$(SUM) "Running benchmarks, results go to $(BENCH_OUTPUT)..."
+	$(CMD)OPENMSX_BENCH_OUTPUT=$(BENCH_OUTPUT) $(BINARY_FULL) -script build/bench.tcl
+
+# Check that the emulation doesn't allocate once it runs in a steady state, see
+# build/alloc_test.tcl. Needs a build with OPENMSX_ALLOC_TRACKING=true.
+alloc-test: all
+	$(SUM) "Running allocation test..."
+	$(CMD)$(BINARY_FULL) -script build/alloc_test.tcl
+
 
 # Installation and Binary Packaging
 # =================================
@@ -7,6 +7,7 @@ variable tabcompletion_proc_insensitive
 variable help_text
 variable help_proc
 variable lazy [dict create]
+variable lazy_registered [dict create] ;# also the already executed scripts
 
 # Only execute this script once. Below we source other Tcl script,
 # so this makes sure we don't get in an infinite loop.
@@ -24,7 +25,9 @@ proc dbg {msg} {
 # 'procs' is about to be executed. See also 'lazy.tcl'.
 proc register_lazy {script procs} {
 	variable lazy
+	variable lazy_registered
 	dict set lazy $script $procs
+	dict set lazy_registered $script 1
 }
 
 # Lookup the script associated with the given proc name. If found that script
@@ -218,4 +221,36 @@ if 0 {
 	foreach e [lsort -integer -index 0 $profile_list] { puts stderr $e }
 }
 
+# Scripts that start with a '_' character but that are not (yet) listed in
+# 'lazy.tcl' (e.g. scripts the user added): derive the names to register from
+# the script itself, that's still a lot cheaper than executing it. Only the
+# exported procs and the procs defined at the top level are found. Note that
+# settings (user_setting) only exist after the script got loaded, so scripts
+# that create settings should not start with a '_' character.
+proc lazy_procs_in_script {filename} {
+	if {[catch {set f [open $filename]}]} {return}
+	set text [read $f]
+	close $f
+	set result [list]
+	foreach {- names} [regexp -all -inline -line {^\s*namespace\s+export\s+(.*)$} $text] {
+		# skip comments and patterns
+		set names [lindex [split [string map {\\ ""} $names] ";#"] 0]
+		foreach name $names {
+			if {![string match {*[*?]*} $name]} {lappend result $name}
+		}
+	}
+	foreach {- name} [regexp -all -inline -line {^proc\s+(?:::)?([^\s:]+)\s} $text] {
+		lappend result $name
+	}
+	lsort -unique $result
+}
+foreach script [lsort -unique [concat $user_scripts $system_scripts]] {
+	if {[string index $script 0] ne "_"} continue
+	if {[dict exists $lazy_registered $script]} continue
+	set procs [lazy_procs_in_script [data_file scripts/$script]]
+	if {[llength $procs] == 0} continue
+	dbg "auto registering lazy script $script: $procs"
+	register_lazy $script $procs
+}
+
 } ;# namespace openmsx
@@ -28,35 +28,36 @@ Examples:
 namespace eval cheat_finder {
 
 variable max_num_results 15 ;# maximum to display cheats
-variable mem
+variable started false
 
-# build translation dictionary for convenience expressions
+# The actual search is done by 'debug cheat', this translates the
+# convenience expressions into its relations.
 variable translate [dict create \
-	""         "true"       \
+	""         "any"        \
 	                        \
-	"smaller"  "new < old"  \
-	"less"     "new < old"  \
-	"bigger"   "new > old"  \
-	"more"     "new > old"  \
-	"greater"  "new > old"  \
+	"smaller"  "<"          \
+	"less"     "<"          \
+	"bigger"   ">"          \
+	"more"     ">"          \
+	"greater"  ">"          \
 	                        \
-	"le"       "new <= old" \
-	"loe"      "new <= old" \
-	"ge"       "new >= old" \
-	"goe"      "new >= old" \
-	"moe"      "new >= old" \
+	"le"       "<="         \
+	"loe"      "<="         \
+	"ge"       ">="         \
+	"goe"      ">="         \
+	"moe"      ">="         \
 	                        \
-	"equal"    "new == old" \
-	"eq"       "new == old" \
-	"notequal" "new != old" \
-	"ne"       "new != old" \
+	"equal"    "=="         \
+	"eq"       "=="         \
+	"notequal" "!="         \
+	"ne"       "!="         \
 	                        \
-	"<="       "new <= old" \
-	">="       "new >= old" \
-	"<"        "new <  old" \
-	">"        "new >  old" \
-	"=="       "new == old" \
-	"!="       "new != old"]
+	"<="       "<="         \
+	">="       ">="         \
+	"<"        "<"          \
+	">"        ">"          \
+	"=="       "=="         \
+	"!="       "!="]
 
 set_tabcompletion_proc findcheat [namespace code tab_cheat_type]
 
@@ -70,44 +71,36 @@ proc tab_cheat_type {args} {
 
 # Restart cheat finder.
 proc start {} {
-	variable mem [dict create]
-
-	set mymem [debug read_block memory 0 0x10000]
-	binary scan $mymem c* values
-	set addr 0
-	foreach val $values {
-		dict append mem $addr $val
-		incr addr
-	}
+	variable started
+	debug cheat start memory
+	set started true
 }
 
-# Helper function to do the actual search.
-# Returns a list of triplets (addr, old, new)
-proc search {expression} {
-	variable mem
+# Helper function for expressions that are not simple relations, in there
+# 'old', 'new' and 'addr' are variables.
+proc search_expression {expression} {
+	# read all memory at once, much faster than 'debug read' per address
+	binary scan [debug snapshot memory] cu* current
 
-	set result [list]
-	dict for {addr old} $mem {
-		set new [debug read memory $addr]
+	set keep [list]
+	foreach candidate [debug cheat list] {
+		lassign $candidate addr prev old
+		set new [lindex $current $addr]
 		#note: NO braces around $expression
 		if $expression {
-			dict set mem $addr $new
-			lappend result [list $addr $old $new]
-		} else {
-			dict unset mem $addr
+			lappend keep $addr
 		}
 	}
-	return $result
+	debug cheat keep $keep
 }
 
 # main routine
 proc findcheat {args} {
-	variable mem
+	variable started
 	variable max_num_results
 	variable translate
 
-	# create mem dictionary
-	if {![info exists mem]} start
+	if {!$started} start
 
 	# parse options
 	while (1) {
@@ -128,27 +121,24 @@ proc findcheat {args} {
 	set expression [join $args]
 
 	if {[dict exists $translate $expression]} {
-		# translate a convenience expression into a real expression
-		set expression [dict get $translate $expression]
+		# convenience expression
+		set num [debug cheat narrow [dict get $translate $expression]]
 	} elseif {[string is integer $expression]} {
 		# search for a specific value
-		set expression "new == $expression"
+		set num [debug cheat narrow == $expression]
+	} else {
+		# prefix 'old', 'new' and 'addr' with '$'
+		set expression [string map {old $old new $new addr $addr} $expression]
+		set num [search_expression $expression]
 	}
 
-	# prefix 'old', 'new' and 'addr' with '$'
-	set expression [string map {old $old new $new addr $addr} $expression]
-
-	# search memory
-	set result [search $expression]
-
 	# display the result
-	set num [llength $result]
 	if {$num == 0} {
 		return "No results left"
 	} elseif {$num <= $max_num_results} {
 		set output ""
-		set sorted [lsort -integer -index 0 $result]
-		foreach {addr old new} [join $sorted] {
+		foreach candidate [debug cheat list] {
+			lassign $candidate addr old new
 			append output [format "0x%04X : %d -> %d\n" $addr $old $new]
 		}
 		return $output
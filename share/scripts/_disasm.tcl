@@ -136,10 +136,9 @@ Usage:
 }
 proc disasm {{address -1} {num 8}} {
 	if {$address == -1} {set address [reg PC]}
-	for {set i 0} {$i < int($num)} {incr i} {
-		set l [debug disasm $address]
-		append result [format "%04X  %s\n" $address [join $l]]
-		set address [expr {($address + [llength $l] - 1) & 0xFFFF}]
+	set result ""
+	foreach l [debug disasm_block $address [expr {int($num)}]] {
+		append result [format "%04X  %s\n" [lindex $l 0] [join [lrange $l 1 end]]]
 	}
 	return $result
 }
@@ -272,6 +271,11 @@ executed. Note that this operation is relatively slow (compared to the other
 step functions). Also the reverse feature must be enabled for this to work
 (normally it's enabled by default).}
 proc step_back {} {
+	# When the previous instruction was recorded (this happens while
+	# stepping or while there are breakpoints), we know exactly where it
+	# started, so we can go there directly.
+	if {![catch {debug step_back}]} return
+
 	# In the past this proc was implemented totally different. It's worth
 	# mentioning this old algorithm and explain why it wasn't good enough.
 	# The old algorithm went like this:
@@ -0,0 +1,72 @@
+namespace eval frame_hashes {
+
+set_help_text frame_hashes \
+{Report a hash of the (raw) MSX screen after every frame.
+
+Usage:
+ frame_hashes start [-doublesize]
+ frame_hashes stop
+
+Each frame a 'frame_hash <number> <hash>' message is logged, so a client
+(e.g. an automated test) can compare the frames with known good ones without
+any image being encoded or written. The hash is the same as returned by
+'screenshot -hash'.
+}
+
+variable after_id
+variable frame_nr 0
+variable hash_args
+
+proc frame_hashes {{cmd "start"} args} {
+	variable after_id
+	variable frame_nr
+	variable hash_args
+	switch -- $cmd {
+		"start" {
+			if {[info exists after_id]} {
+				error "Already reporting frame hashes."
+			}
+			if {$args ni [list "" "-doublesize"]} {
+				error "Unknown option: $args"
+			}
+			set hash_args $args
+			set frame_nr 0
+			set after_id [after frame [namespace code do_frame]]
+		}
+		"stop" {
+			if {[info exists after_id]} {
+				after cancel $after_id
+				unset after_id
+			}
+		}
+		default {
+			error "Unknown subcommand: $cmd, should be start or stop."
+		}
+	}
+	return ""
+}
+
+proc do_frame {} {
+	variable after_id
+	variable frame_nr
+	variable hash_args
+	if {[catch {screenshot -hash {*}$hash_args} hash]} {
+		if {$hash ne "No frame available yet"} {
+			unset after_id
+			message "frame_hashes stopped: $hash" error
+			return
+		}
+		# nothing painted yet (e.g. right after a machine switch), only
+		# skip this frame
+	} else {
+		message "frame_hash $frame_nr $hash"
+	}
+	incr frame_nr
+	set after_id [after frame [namespace code do_frame]]
+}
+
+namespace export frame_hashes
+
+} ;# namespace frame_hashes
+
+namespace import frame_hashes::*
@@ -1277,7 +1277,7 @@ proc menu_create_load_machine_list {{mode "replace"}} {
 }
 
 proc menu_load_machine_exec_replace {item} {
-	if {[catch {machine $item} errorText]} {
+	if {[catch {switch_machine $item} errorText]} {
 		osd::display_message $errorText error
 	} else {
 		menu_close_all
@@ -1509,20 +1509,20 @@ proc menu_toys_exec {toy} {
 
 proc ls {directory extensions} {
 	set dirs [list]
-	set specialdir [list]
 	set items [list]
 	if {[catch {
-		set files [glob -nocomplain -tails -directory $directory -types {f r} *]
-		set items [lsearch -regexp -all -inline -nocase $files .*\\.($extensions)]
-		set dirs [glob -nocomplain -tails -directory $directory -types {d r x} *]
-		set specialdir [glob -nocomplain -tails -directory $directory -types {hidden d} ".openMSX"]
+		lassign [list_dir $directory $extensions] dirs items
 	} errorText]} {
 		osd::display_message "Unable to read dir $directory: $errorText" error
 	}
 	set dirs2 [list]
-	foreach dir [concat $dirs $specialdir] {
+	set subdirs [list]
+	foreach dir $dirs {
 		lappend dirs2 "$dir/"
+		lappend subdirs [file join $directory $dir]
 	}
+	# most likely the user browses to one of these next
+	list_dir prefetch {*}$subdirs
 	set extra_entries [list]
 	set volumes [file volumes]
 	if {$directory ni $volumes} {
@@ -1539,20 +1539,10 @@ proc ls {directory extensions} {
 }
 
 proc is_empty_dir {directory extensions} {
-	set files [list]
-	catch {set files [glob -nocomplain -tails -directory $directory -types {f r} *]}
-	set items [lsearch -regexp -all -inline -nocase $files .*\\.($extensions)]
-	if {[llength $items] != 0} {return false}
-
-	set dirs [list]
-	catch {set dirs [glob -nocomplain -tails -directory $directory -types {d r x} *]}
-	if {[llength $dirs] != 0} {return false}
-
-	set specialdir [list]
-	catch {set specialdir [glob -nocomplain -tails -directory $directory -types {hidden d} ".openMSX"]}
-	if {[llength $specialdir] != 0} {return false}
-
-	return true
+	if {[catch {lassign [list_dir $directory $extensions] dirs items}]} {
+		return true
+	}
+	expr {[llength $items] == 0 && [llength $dirs] == 0}
 }
 
 proc get_non_empty_pools {type extensions exclude_path} {
@@ -1755,7 +1745,7 @@ proc menu_create_disk_list {path drive} {
 		header { textexpr "Disks $::osd_disk_path" \
 			font-size 10 \
 			post-spacing 6 }]
-	set extensions "dsk|zip|gz|xsa|dmk|di1|di2|fd?|1|2|3|4|5|6|7|8|9"
+	set extensions "dsk|zip|gz|xsa|dmk|di1|di2|f|fd|1|2|3|4|5|6|7|8|9"
 	set items [list]
 	set presentation [list]
 	if {[lindex [$drive] 2] ne "empty readonly"} {
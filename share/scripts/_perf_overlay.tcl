@@ -0,0 +1,62 @@
+namespace eval perf_overlay {
+
+set_help_text toggle_performance_overlay \
+{Enable/disable an overlay that shows where the time goes: for each stage of
+the emulation (CPU, device callbacks, VDP rendering, sound, post-processing,
+OSD, Tcl scripts) the percentage of the real time that was spent in it during
+the last second. Only the most expensive stages are shown.
+See also 'openmsx_info performance'.}
+
+variable after_id
+variable prev [dict create]
+variable max_lines 12
+
+proc toggle_performance_overlay {} {
+	variable after_id
+	variable prev
+	if {[info exists after_id]} {
+		after cancel $after_id
+		osd destroy perf_overlay
+		unset after_id
+	} else {
+		variable max_lines
+		osd create rectangle perf_overlay -x 5 -y 30 -z 0 -w 220 \
+			-h [expr {$max_lines * 9 + 6}] -rgba 0x00000080
+		osd create text perf_overlay.text -x 4 -y 3 -z 1 -size 8 -rgba 0xffffffff
+		set prev [openmsx_info performance]
+		set after_id [after realtime 1 [namespace code refresh]]
+	}
+	return ""
+}
+
+proc refresh {} {
+	variable after_id
+	variable prev
+	variable max_lines
+
+	set times [openmsx_info performance]
+	set deltas [list]
+	set total 0.0
+	dict for {name t} $times {
+		set old [expr {[dict exists $prev $name] ? [dict get $prev $name] : 0.0}]
+		set d [expr {$t - $old}]
+		lappend deltas [list $name $d]
+		set total [expr {$total + $d}]
+	}
+	set prev $times
+
+	set lines [list]
+	foreach entry [lrange [lsort -real -decreasing -index 1 $deltas] 0 $max_lines-1] {
+		lassign $entry name d
+		if {$d <= 0.0} break
+		lappend lines [format "%5.1f%% %s" [expr {($total > 0.0) ? (100.0 * $d / $total) : 0.0}] $name]
+	}
+	osd configure perf_overlay.text -text [join $lines "\n"]
+	set after_id [after realtime 1 [namespace code refresh]]
+}
+
+namespace export toggle_performance_overlay
+
+} ;# namespace perf_overlay
+
+namespace import perf_overlay::*
@@ -0,0 +1,129 @@
+namespace eval render_audio {
+
+set_help_text render_audio \
+{Renders the sound of the running MSX machine to a wav file, as fast as
+possible instead of in real time.
+
+Usage:
+    render_audio [-channels] [-keepvideo] [-exit] <filename> <seconds>
+    render_audio stop
+
+This records <seconds> of emulated time (audio only, see 'record'). While
+rendering, throttle is turned off, the host sound output is muted and (unless
+-keepvideo is given) the renderer is set to 'none'. So the speed is only
+limited by the emulation itself, typically a 3 minute tune renders in a few
+seconds. Afterwards the original settings are restored.
+
+Options:
+    -channels   also record all channels of all sound devices in separate
+                files (see 'record_channels'), using <filename> as prefix
+    -keepvideo  keep the current renderer (e.g. to watch the progress)
+    -exit       exit openMSX when done, useful for batch rendering, e.g.
+                openmsx -machine Boosted_MSX2_EN -carta tune.rom \
+                        -command "render_audio -exit tune.wav 180"
+
+Example:
+    render_audio music.wav 180
+        Renders the next 3 minutes of emulated time to music.wav.
+}
+
+set_tabcompletion_proc render_audio [namespace code render_audio_tab]
+proc render_audio_tab {args} {
+	if {[llength $args] == 2} {
+		return [list "stop" "-channels" "-keepvideo" "-exit"]
+	}
+	return [list "-channels" "-keepvideo" "-exit"]
+}
+
+variable after_id ""
+variable saved_settings [list]
+variable channels false
+variable exit_when_done false
+
+proc render_audio {args} {
+	variable after_id
+	variable saved_settings
+	variable channels
+	variable exit_when_done
+
+	if {$args eq [list "stop"]} {
+		if {$after_id eq ""} {
+			error "Not rendering."
+		}
+		after cancel $after_id
+		finish
+		return
+	}
+
+	set channels false
+	set keep_video false
+	set exit_when_done false
+	while {[string match "-*" [lindex $args 0]]} {
+		switch -- [lindex $args 0] {
+			"-channels"  {set channels true}
+			"-keepvideo" {set keep_video true}
+			"-exit"      {set exit_when_done true}
+			default {
+				error "Unknown option: [lindex $args 0]"
+			}
+		}
+		set args [lrange $args 1 end]
+	}
+	if {[llength $args] != 2} {
+		error "Expected a filename and a duration (in seconds)."
+	}
+	lassign $args filename seconds
+	if {![string is double -strict $seconds] || $seconds <= 0} {
+		error "Invalid duration: $seconds"
+	}
+	if {$after_id ne ""} {
+		error "Already rendering!"
+	}
+	if {[dict get [record status] status] ne "idle"} {
+		error "Already recording!"
+	}
+
+	record start -audioonly $filename
+	if {$channels} {
+		record_channels start all -prefix [file rootname $filename]
+	}
+
+	# Save the settings we're about to change (restored in 'finish').
+	set saved_settings [list throttle $::throttle mute $::mute]
+	set ::throttle off
+	set ::mute on
+	if {!$keep_video && $::renderer ne "none"} {
+		lappend saved_settings renderer $::renderer
+		set ::renderer none
+	}
+
+	set after_id [after time $seconds [namespace code finish]]
+	puts "Rendering [utils::format_time $seconds] of audio to $filename..."
+}
+
+proc finish {} {
+	variable after_id
+	variable saved_settings
+	variable channels
+	variable exit_when_done
+
+	set after_id ""
+	record stop
+	if {$channels} {
+		record_channels stop
+	}
+	foreach {setting value} $saved_settings {
+		set ::$setting $value
+	}
+	set saved_settings [list]
+	puts "Rendering done."
+	if {$exit_when_done} {
+		exit
+	}
+}
+
+namespace export render_audio
+
+} ;# namespace render_audio
+
+namespace import render_audio::*
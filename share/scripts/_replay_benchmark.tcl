@@ -0,0 +1,75 @@
+namespace eval replay_benchmark {
+
+set_help_text replay_benchmark \
+{Usage: replay_benchmark <filename>
+
+Loads the given replay and plays it back as fast as possible (throttle off,
+no sound output). When the end of the replay is reached, some statistics are
+printed (including the time per emulation stage) and openMSX exits. Because replays are deterministic, this is a
+reproducible benchmark based on a real session. This is what the '-bench'
+command line option uses. It's best used with the 'none' renderer (which
+'-bench' selects), otherwise rendering is measured as well.
+}
+
+variable start_real
+variable start_emu
+variable end_emu
+variable start_perf
+
+proc replay_benchmark {filename} {
+	variable start_real
+	variable start_emu
+	variable end_emu
+	variable start_perf
+
+	set ::save_settings_on_exit false
+	set ::throttle off
+	set ::sound_driver null
+
+	reverse loadreplay -viewonly $filename
+	set status [reverse status]
+	set start_emu [dict get $status current]
+	set end_emu   [dict get $status end]
+	set start_perf [openmsx_info performance]
+	set start_real [clock microseconds]
+	after time [expr {$end_emu - $start_emu}] [namespace code done]
+	return ""
+}
+
+proc done {} {
+	variable start_real
+	variable start_emu
+	variable end_emu
+	variable start_perf
+
+	set real [expr {([clock microseconds] - $start_real) / 1e6}]
+	set emu  [expr {$end_emu - $start_emu}]
+	# the 'none' renderer doesn't produce frames, so calculate the number
+	# of emulated frames from the VDP frame rate (PAL or NTSC)
+	set rate [expr {([vdpreg 9] & 2) ? 50 : 60}]
+	puts [format "emulated time: %.3f s" $emu]
+	puts [format "real time:     %.3f s" $real]
+	puts [format "speed:         %.2f x realtime" [expr {$emu / $real}]]
+	puts [format "frames/sec:    %.1f" [expr {$emu * $rate / $real}]]
+
+	# the most expensive stages (see 'openmsx_info performance')
+	set stages [list]
+	dict for {name t} [openmsx_info performance] {
+		if {[dict exists $start_perf $name]} {
+			set t [expr {$t - [dict get $start_perf $name]}]
+		}
+		lappend stages [list $name $t]
+	}
+	puts "time per stage:"
+	foreach stage [lrange [lsort -real -decreasing -index 1 $stages] 0 9] {
+		lassign $stage name t
+		puts [format "  %8.3f s  %5.1f%%  %s" $t [expr {100.0 * $t / $real}] $name]
+	}
+	exit
+}
+
+namespace export replay_benchmark
+
+} ;# namespace replay_benchmark
+
+namespace import replay_benchmark::*
@@ -19,7 +19,19 @@ proc savestate_common {} {
 	}
 }
 
-proc savestate {{name ""}} {
+proc savestate {args} {
+	set format xml
+	set name ""
+	while {[llength $args] > 0} {
+		set args [lassign $args arg]
+		if {$arg eq "-format"} {
+			set args [lassign $args format]
+		} elseif {$name eq ""} {
+			set name $arg
+		} else {
+			error "Usage: savestate \[-format xml|binary\] \[<name>\]"
+		}
+	}
 	savestate_common
 	file mkdir $directory
 	if {[catch {screenshot -raw -doublesize $png}]} {
@@ -32,7 +44,7 @@ proc savestate {{name ""}} {
 	}
 	set currentID [machine]
 	# always save using the new (.oms) name
-	store_machine $currentID $fullname_oms
+	store_machine -format $format $currentID $fullname_oms
 	# if successful, delete the old (.gz) filename (deleting a non-exiting
 	# file is not an error)
 	file delete -- $fullname_gz
@@ -112,12 +124,14 @@ proc savestate_list_tab {args} {
 
 # savestate
 set_help_text savestate \
-{savestate [<name>]
+{savestate [-format xml|binary] [<name>]
 
 Create a snapshot of the current emulated MSX machine.
 
 Optionally you can specify a name for the savestate. If you omit this the default name 'quicksave' will be taken.
 
+With '-format binary' the savestate is written in a compact binary format, which is faster to save and load (especially for machines with a lot of RAM). Such a savestate can only be loaded on the same type of platform (e.g. not on a big-endian machine if it was created on a little-endian one). The default is the portable XML format. 'loadstate' detects the format automatically.
+
 See also 'loadstate', 'list_savestates', 'delete_savestate'.
 }
 set_tabcompletion_proc savestate [namespace code savestate_tab]
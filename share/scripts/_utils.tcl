@@ -81,7 +81,11 @@ proc format_time_subseconds {time} {
 }
 
 proc get_ordered_machine_list {} {
-	lsort -dictionary [list_machines]
+	# skip the idle machines in the pool of pre-loaded machines
+	lsort -dictionary [lmap m [list_machines] {
+		if {[machine_pool::is_pooled $m]} continue
+		set m
+	}]
 }
 
 proc get_random_number {max} {
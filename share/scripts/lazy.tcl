@@ -15,6 +15,7 @@ register_lazy "_disasm.tcl" {
 	step_back step_out step_in step skip_instruction}
 register_lazy "_example_tools.tcl" {get_screen listing get_color_count toggle_tron}
 register_lazy "_filepool.tcl" {filepool get_paths_for_type}
+register_lazy "_frame_hashes.tcl" frame_hashes
 register_lazy "_guess_title.tcl" {guess_title guess_rom_title guess_rom_device}
 register_lazy "_info_panel.tcl" toggle_info_panel
 register_lazy "_metal_gear_overlay.tcl" {toggle_metal_gear_overlay}
@@ -30,6 +31,7 @@ register_lazy "_osd_nemesis.tcl" toggle_nemesis_1_shield
 register_lazy "_osd_widgets.tcl" {
 	toggle_fps msx_init msx_update box text_box create_power_bar
 	update_power_bar hide_power_bar volume_control}
+register_lazy "_perf_overlay.tcl" toggle_performance_overlay
 register_lazy "_psg_log.tcl" psg_log
 register_lazy "_psg_profile.tcl" psg_profile
 register_lazy "_quitmenu.tcl" quit_menu
@@ -38,6 +40,7 @@ register_lazy "_record_channels.tcl" {
 register_lazy "_record_chunks.tcl" {
 	record_chunks record_chunks_on_framerate_changes}
 register_lazy "_reg_log.tcl" reg_log
+register_lazy "_replay_benchmark.tcl" replay_benchmark
 register_lazy "_reverse.tcl" {
 	reverse_prev reverse_next goto_time_delta go_back_one_step
 	go_forward_one_step reverse_bookmarks
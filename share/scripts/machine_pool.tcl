@@ -0,0 +1,103 @@
+namespace eval machine_pool {
+
+# Machine pool: keep the machines listed in 'preloaded_machines' loaded (but
+# idle) in the background. Switching to such a machine with 'switch_machine'
+# then only has to activate it, it doesn't have to construct all devices and
+# load all ROM images anymore. Creating a machine can't be done on another
+# thread (it creates commands, settings, ...), so the pool is (re)filled one
+# machine at a time from the main loop after a switch.
+
+user_setting create string preloaded_machines \
+"List of machine configurations that are kept loaded in the background, so
+that switching to one of them with 'switch_machine' is almost instant. Note
+that each of these machines takes extra memory." ""
+
+set_help_text switch_machine \
+{Switch to a different MSX machine, like the 'machine' command does. When a
+machine with the given configuration is available in the pool of pre-loaded
+machines (see the 'preloaded_machines' setting), that machine is used, which
+is a lot faster than creating a new one.
+}
+
+set_tabcompletion_proc switch_machine [namespace code tab_switch_machine]
+
+proc tab_switch_machine {args} {
+	openmsx_info machines
+}
+
+variable pool [dict create] ;# config name -> ID of the idle machine
+variable fill_after ""
+
+# Is the given machine one of the idle machines in the pool? Those are not
+# meant to be shown to the user (e.g. by 'cycle_machine').
+proc is_pooled {id} {
+	variable pool
+	expr {$id in [dict values $pool]}
+}
+
+proc fill_pool {} {
+	variable pool
+	variable fill_after
+	set fill_after ""
+
+	dict for {config id} $pool {
+		if {$config ni $::preloaded_machines} {
+			catch {delete_machine $id}
+			dict unset pool $config
+		}
+	}
+	foreach config $::preloaded_machines {
+		if {[dict exists $pool $config]} continue
+		set id [create_machine]
+		if {[catch {${id}::load_machine $config} error_result]} {
+			delete_machine $id
+			message "Couldn't preload machine $config: $error_result" warning
+			continue
+		}
+		dict set pool $config $id
+		# only one machine per call, keep the UI responsive
+		schedule_fill
+		break
+	}
+}
+
+proc schedule_fill {} {
+	variable fill_after
+	if {$fill_after eq ""} {
+		set fill_after [after realtime 0.1 [namespace code fill_pool]]
+	}
+}
+
+proc switch_machine {config} {
+	variable pool
+	if {![dict exists $pool $config]} {
+		return [machine $config]
+	}
+	set id [dict get $pool $config]
+	dict unset pool $config
+	if {$id ni [list_machines]} {
+		# deleted in the mean time
+		schedule_fill
+		return [machine $config]
+	}
+	set old [activate_machine]
+	activate_machine $id
+	if {$old ne ""} {
+		delete_machine $old
+	}
+	schedule_fill
+	return $id
+}
+
+proc preloaded_changed {name1 name2 op} {
+	schedule_fill
+}
+
+trace add variable ::preloaded_machines write [namespace code preloaded_changed]
+schedule_fill
+
+namespace export switch_machine
+
+} ;# namespace machine_pool
+
+namespace import machine_pool::*
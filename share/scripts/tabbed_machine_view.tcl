@@ -3,6 +3,11 @@
 # It only shows when there is more than one machine currently running.
 # Because of that, it shouldn't be necessary to turn it off.
 #
+# Normally the other machines are paused. With the setting
+# 'tabbed_machine_view_background_speed' they keep running (slower than the
+# active machine, in short slices from the main loop, see 'run_machines') and
+# a thumbnail of their screen is shown below their tab.
+#
 # Feel free to tune/improve the color scheme :)
 
 # TODO:
@@ -12,6 +17,12 @@
 
 namespace eval tabbed_machine_view {
 
+user_setting create float tabbed_machine_view_background_speed \
+{Speed at which the machines that are not the active one keep running, \
+relative to real time: 0 means they're paused, 0.5 means they run at half \
+speed. When they run, a thumbnail of their screen is shown below their tab.
+} 0.0 0.0 1.0
+
 variable curtab_bgcolor 0x4040D0C0
 variable curtab_text_color 0xFFFFFF
 variable inactive_tab_bgcolor 0x202040A0
@@ -22,6 +33,13 @@ variable tab_margin 2
 variable tab_main_spacing 3 ;# the width of the space between tab-row and main content
 variable total_height 20
 variable top_spacing 2
+variable thumbnail_width 80
+variable thumbnail_height 60
+variable background_slice 0.1 ;# real time (in seconds) between background runs
+variable thumbnail_interval 5 ;# in background runs
+variable thumbnail_dir [file normalize $::env(OPENMSX_USER_DATA)/../thumbnails]
+variable thumbnails [dict create] ;# machine ID -> last thumbnail file
+variable background_count 0
 
 
 proc update {} {
@@ -35,6 +53,9 @@ proc update {} {
 	variable total_height
 	variable top_spacing
 	variable text_size
+	variable thumbnail_width
+	variable thumbnail_height
+	variable thumbnails
 
 	osd destroy tabbed_machine_view
 
@@ -74,6 +95,18 @@ proc update {} {
 				-size $text_size \
 				-rgb $text_color \
 				-x 1
+			if {$machine ne [activate_machine] &&
+			    $::tabbed_machine_view_background_speed > 0} {
+				set image [expr {[dict exists $thumbnails $machine] ?
+				                 [dict get $thumbnails $machine] : ""}]
+				osd create rectangle tabbed_machine_view.${machine}_thumb \
+					-relx [expr {$tab_count * $rel_width}] \
+					-x [expr {2 * $tab_margin}] \
+					-y $total_height \
+					-w $thumbnail_width \
+					-h $thumbnail_height \
+					-image $image
+			}
 			incr tab_count
 		}
 		# create the bottom 'line' for the visual tab effect
@@ -85,7 +118,62 @@ proc update {} {
 			-h $tab_main_spacing \
 			-rgba $curtab_bgcolor
 	}
-	after machine_switch [namespace code update]
+}
+
+proc on_machine_switch {} {
+	update
+	after machine_switch [namespace code on_machine_switch]
+}
+
+proc on_background_speed_change {name1 name2 op} {
+	update
+}
+
+# Let the other machines run for a short while, with rendering, and from time
+# to time update their thumbnails.
+proc background_run {} {
+	variable background_slice
+	variable thumbnail_interval
+	variable background_count
+
+	set speed $::tabbed_machine_view_background_speed
+	set machines [lmap m [utils::get_ordered_machine_list] {
+		if {$m eq [activate_machine]} continue
+		set m
+	}]
+	if {$speed > 0 && [llength $machines] > 0} {
+		set duration [expr {$background_slice * $speed}]
+		if {[catch {run_machines -render $duration {*}$machines}]} {
+			# e.g. a machine that is not powered on, run the others
+			foreach m $machines {
+				catch {run_machines -render $duration $m}
+			}
+		}
+		if {[incr background_count] >= $thumbnail_interval} {
+			set background_count 0
+			update_thumbnails $machines
+		}
+	}
+	after realtime $background_slice [namespace code background_run]
+}
+
+proc update_thumbnails {machines} {
+	variable thumbnail_dir
+	variable thumbnails
+
+	file mkdir $thumbnail_dir
+	foreach m $machines {
+		# Alternate between two files: the OSD only reloads the image when
+		# the file name changes.
+		set old [expr {[dict exists $thumbnails $m] ? [dict get $thumbnails $m] : ""}]
+		set n [expr {[string match *_0.png $old] ? 1 : 0}]
+		set file [file join $thumbnail_dir ${m}_${n}.png]
+		if {[catch {screenshot -raw -machine $m -compression fast $file}]} continue
+		dict set thumbnails $m $file
+		if {[osd exists tabbed_machine_view.${m}_thumb]} {
+			osd configure tabbed_machine_view.${m}_thumb -image $file
+		}
+	}
 }
 
 proc on_mouse_click {} {
@@ -102,7 +190,9 @@ proc on_mouse_click {} {
 	after "mouse button1 up" [namespace code on_mouse_click]
 }
 
-after realtime 0.01 [namespace code update]
+after realtime 0.01 [namespace code on_machine_switch]
+trace add variable ::tabbed_machine_view_background_speed write [namespace code on_background_speed_change]
+after realtime $background_slice [namespace code background_run]
 after "mouse button1 up" [namespace code on_mouse_click]
 
 } ;# namespace tabbed_machine_view
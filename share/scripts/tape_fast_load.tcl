@@ -0,0 +1,73 @@
+namespace eval tape_fast_load {
+
+# Loads tapes that use the BIOS routines (TAPION/TAPIN) in an instant. Unlike
+# 'fast_cas_load_hack_enabled', this works via the normal cassetteplayer: the
+# tape position moves along, so when a program switches to its own loader
+# (which reads the signal), that loader continues at the right position.
+
+user_setting create boolean tape_fast_load \
+"When enabled, loading a CAS image via the BIOS routines (e.g. with BLOAD,
+CLOAD or RUN) is done instantly, also the tape position is moved while doing
+so. Loaders that read the cassette signal themselves still run at normal speed.
+For WAV images this setting has no effect." false
+
+variable bps [list]
+
+proc install {} {
+	uninstall
+	if {!$::tape_fast_load} return
+	if {[catch {machine_info connector cassetteport}]} return
+	if {[machine_info type] eq "SVI"} return ;# only MSX BIOS routines
+
+	# The BIOS jump table contains 'JP <routine>', break on the routine
+	# itself so that also direct calls from within the BIOS are handled.
+	variable bps
+	foreach {addr func} {0x00E2 tapion 0x00E5 tapin} {
+		if {[catch {peek16 $addr "slotted memory"} target]} return
+		lappend bps [debug set_bp $target {[pc_in_slot 0 0]} [namespace code $func]]
+	}
+}
+
+proc uninstall {} {
+	variable bps
+	foreach bp $bps {
+		catch {debug remove_bp $bp}
+	}
+	set bps [list]
+}
+
+proc ret {} {
+	reg PC [peek16 [reg SP]]
+	reg SP [expr {[reg SP] + 2}]
+}
+
+proc tapion {} {
+	# TAPION: read the header, carry set on error. When the tape can't
+	# skip the header (e.g. a WAV image) the BIOS reads the signal.
+	if {[catch {cassetteplayer fastload header} ok] || !$ok} return
+	reg F 0x40 ;# ok, clear carry flag
+	ret
+}
+
+proc tapin {} {
+	# TAPIN: read a byte in A, carry set on error
+	if {[catch {cassetteplayer fastload byte} val] || ($val eq "")} return
+	reg A $val
+	reg F 0x40 ;# ok, clear carry flag
+	ret
+}
+
+proc machine_switched {} {
+	install
+	after machine_switch [namespace code machine_switched]
+}
+
+proc setting_changed {name1 name2 op} {
+	install
+}
+
+trace add variable ::tape_fast_load write [namespace code setting_changed]
+after machine_switch [namespace code machine_switched]
+after realtime 0 [namespace code install]
+
+} ;# namespace tape_fast_load
@@ -7,6 +7,7 @@
 #include "FileOperations.hh"
 #include "GlobalCliComm.hh"
 #include "StdioMessages.hh"
+#include "TclObject.hh"
 #include "Version.hh"
 #include "CliConnection.hh"
 #include "ConfigException.hh"
@@ -60,12 +61,14 @@ CommandLineParser::CommandLineParser(Reactor& reactor_)
 	registerOption("-v",          versionOption, PHASE_BEFORE_INIT, 1);
 	registerOption("--version",   versionOption, PHASE_BEFORE_INIT, 1);
 	registerOption("-bash",       bashOption,    PHASE_BEFORE_INIT, 1);
+	registerOption("-startup-profile", startupProfileOption, PHASE_BEFORE_INIT, 1);
 
 	registerOption("-setting",    settingOption, PHASE_BEFORE_SETTINGS);
 	registerOption("-control",    controlOption, PHASE_BEFORE_SETTINGS, 1);
 	registerOption("-script",     scriptOption,  PHASE_BEFORE_SETTINGS, 1); // correct phase?
 	registerOption("-command",    commandOption, PHASE_BEFORE_SETTINGS, 1); // same phase as -script
 	registerOption("-testconfig", testConfigOption, PHASE_BEFORE_SETTINGS, 1);
+	registerOption("-bench",      benchOption,   PHASE_BEFORE_SETTINGS, 2);
 
 	registerOption("-machine",    machineOption, PHASE_LOAD_MACHINE);
 
@@ -279,7 +282,7 @@ void CommandLineParser::parse(int argc, char** argv)
 
 bool CommandLineParser::isHiddenStartup() const
 {
-	return parseStatus == one_of(CONTROL, TEST);
+	return parseStatus == one_of(CONTROL, TEST, BENCH);
 }
 
 CommandLineParser::ParseStatus CommandLineParser::getParseStatus() const
@@ -570,6 +573,37 @@ string_view CommandLineParser::TestConfigOption::optionHelp() const
 	return "Test if the specified config works and exit";
 }
 
+// Bench option
+
+void CommandLineParser::BenchOption::parseOption(
+	const string& option, span<string>& cmdLine)
+{
+	// Keeps the 'none' renderer (hidden startup), the actual work is done
+	// by the 'replay_benchmark' script.
+	auto& parser = OUTER(CommandLineParser, benchOption);
+	parser.parseStatus = CommandLineParser::BENCH;
+	parser.commandOption.commands.push_back(std::string(
+		makeTclList("replay_benchmark", getArgument(option, cmdLine)).getString()));
+}
+
+string_view CommandLineParser::BenchOption::optionHelp() const
+{
+	return "Run the given replay as fast as possible, print statistics and exit";
+}
+
+// class StartupProfileOption
+
+void CommandLineParser::StartupProfileOption::parseOption(
+	const string& /*option*/, span<string>& /*cmdLine*/)
+{
+	enabled = true;
+}
+
+string_view CommandLineParser::StartupProfileOption::optionHelp() const
+{
+	return "Print the time spent in the different startup stages";
+}
+
 // class BashOption
 
 void CommandLineParser::BashOption::parseOption(
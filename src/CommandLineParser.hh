@@ -34,7 +34,7 @@ class Interpreter;
 class CommandLineParser
 {
 public:
-	enum ParseStatus { UNPARSED, RUN, CONTROL, TEST, EXIT };
+	enum ParseStatus { UNPARSED, RUN, CONTROL, TEST, BENCH, EXIT };
 	enum ParsePhase {
 		PHASE_BEFORE_INIT,       // --help, --version, -bash
 		PHASE_INIT,              // calls Reactor::init()
@@ -69,6 +69,9 @@ public:
 	  */
 	[[nodiscard]] bool isHiddenStartup() const;
 
+	/** Print the time spent in the startup stages? (-startup-profile) */
+	[[nodiscard]] bool isStartupProfile() const { return startupProfileOption.enabled; }
+
 private:
 	struct OptionData {
 		std::string_view name;
@@ -142,6 +145,18 @@ private:
 		[[nodiscard]] std::string_view optionHelp() const override;
 	} testConfigOption;
 
+	struct BenchOption final : CLIOption {
+		void parseOption(const std::string& option, span<std::string>& cmdLine) override;
+		[[nodiscard]] std::string_view optionHelp() const override;
+	} benchOption;
+
+	struct StartupProfileOption final : CLIOption {
+		void parseOption(const std::string& option, span<std::string>& cmdLine) override;
+		[[nodiscard]] std::string_view optionHelp() const override;
+
+		bool enabled = false;
+	} startupProfileOption;
+
 	struct BashOption final : CLIOption {
 		void parseOption(const std::string& option, span<std::string>& cmdLine) override;
 		[[nodiscard]] std::string_view optionHelp() const override;
@@ -18,6 +18,9 @@ GlobalSettings::GlobalSettings(GlobalCommandController& commandController_)
 	        "turn power on/off", false, Setting::DONT_SAVE)
 	, autoSaveSetting(commandController, "save_settings_on_exit",
 	        "automatically save settings when openMSX exits", true)
+	, framePacingSetting(commandController, "frame_pacing",
+	        "slightly adjust the emulation speed to align the MSX frames "
+	        "with the host display refresh (only useful with vsync)", false)
 	, umrCallBackSetting(commandController, "umr_callback",
 		"Tcl proc to call when an UMR is detected", {})
 	, invalidPsgDirectionsSetting(commandController,
@@ -43,6 +46,15 @@ GlobalSettings::GlobalSettings(GlobalCommandController& commandController_)
 			{"hq",   ResampledSoundDevice::RESAMPLE_HQ},
 			{"fast", ResampledSoundDevice::RESAMPLE_LQ},
 			{"blip", ResampledSoundDevice::RESAMPLE_BLIP}})
+	, reverseMemoryBudgetSetting(commandController, "reverse_memory_budget",
+		"maximum amount of memory (in MB) the reverse history of a machine "
+		"may use, older snapshots are thinned out to stay within it "
+		"(0 means unlimited)", 0, 0, 1 << 20)
+	, lowMemorySetting(commandController, "low_memory",
+		"use less memory, for devices with little RAM: no deflicker, "
+		"free unused video frames and limit the reverse history when "
+		"reverse_memory_budget is 0",
+		PLATFORM_DINGUX)
 	, speedManager(commandController)
 	, throttleManager(commandController)
 {
@@ -36,6 +36,9 @@ public:
 	[[nodiscard]] BooleanSetting& getAutoSaveSetting() {
 		return autoSaveSetting;
 	}
+	[[nodiscard]] BooleanSetting& getFramePacingSetting() {
+		return framePacingSetting;
+	}
 	[[nodiscard]] StringSetting& getUMRCallBackSetting() {
 		return umrCallBackSetting;
 	}
@@ -48,6 +51,12 @@ public:
 	[[nodiscard]] EnumSetting<ResampledSoundDevice::ResampleType>& getResampleSetting() {
 		return resampleSetting;
 	}
+	[[nodiscard]] IntegerSetting& getReverseMemoryBudgetSetting() {
+		return reverseMemoryBudgetSetting;
+	}
+	[[nodiscard]] BooleanSetting& getLowMemorySetting() {
+		return lowMemorySetting;
+	}
 	[[nodiscard]] IntegerSetting& getJoyDeadzoneSetting(int i) {
 		return *deadzoneSettings[i];
 	}
@@ -68,10 +77,13 @@ private:
 	BooleanSetting pauseSetting;
 	BooleanSetting powerSetting;
 	BooleanSetting autoSaveSetting;
+	BooleanSetting framePacingSetting;
 	StringSetting  umrCallBackSetting;
 	StringSetting  invalidPsgDirectionsSetting;
 	StringSetting  invalidPpiModeSetting;
 	EnumSetting<ResampledSoundDevice::ResampleType> resampleSetting;
+	IntegerSetting reverseMemoryBudgetSetting;
+	BooleanSetting lowMemorySetting;
 	std::vector<std::unique_ptr<IntegerSetting>> deadzoneSettings;
 	SpeedManager speedManager;
 	ThrottleManager throttleManager;
@@ -442,6 +442,11 @@ byte MSXDevice::peekMem(word address, EmuTime::param /*time*/) const
 	}
 }
 
+unsigned MSXDevice::getCoverageOffset(word address) const
+{
+	return address;
+}
+
 void MSXDevice::globalWrite(word /*address*/, byte /*value*/,
                             EmuTime::param /*time*/)
 {
@@ -186,6 +186,14 @@ public:
 	 */
 	[[nodiscard]] virtual byte peekMem(word address, EmuTime::param time) const;
 
+	/** Translate a CPU address (in the slot of this device) to an offset
+	  * in the memory of this device, taking the currently selected memory
+	  * mapper segment or ROM bank into account. This is only used to
+	  * collect code coverage (see CodeCoverage).
+	  * The default implementation returns the address unchanged.
+	  */
+	[[nodiscard]] virtual unsigned getCoverageOffset(word address) const;
+
 	/** Global writes.
 	  * Some devices violate the MSX standard by ignoring the SLOT-SELECT
 	  * signal; they react to writes to a certain address in _any_ slot.
@@ -28,6 +28,7 @@
 #include "MSXEventDistributor.hh"
 #include "StateChangeDistributor.hh"
 #include "EventDelay.hh"
+#include "PerfTimers.hh"
 #include "RealTime.hh"
 #include "DeviceFactory.hh"
 #include "BooleanSetting.hh"
@@ -234,7 +235,7 @@ MSXMotherBoard::MSXMotherBoard(Reactor& reactor_)
 	//       EventDelay creates a setting, calling getMSXCliComm()
 	//       on MSXMotherBoard, so "pimpl" has to be set up already.
 	eventDelay = make_unique<EventDelay>(
-		*scheduler, *msxCommandController,
+		*scheduler, *msxCommandController, getMachineInfoCommand(),
 		reactor.getEventDistributor(), *msxEventDistributor,
 		*reverseManager);
 	realTime = make_unique<RealTime>(
@@ -512,6 +513,7 @@ bool MSXMotherBoard::execute()
 	}
 	assert(getMachineConfig()); // otherwise powered cannot be true
 
+	PerfTimers::Scope perf(PerfTimers::CPU);
 	getCPU().execute(false);
 	return true;
 }
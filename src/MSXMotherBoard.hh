@@ -94,8 +94,17 @@ public:
 	void doReset();
 	void activate(bool active);
 	[[nodiscard]] bool isActive() const { return active; }
+	[[nodiscard]] bool isPowered() const { return powered; }
 	[[nodiscard]] bool isFastForwarding() const { return fastForwarding; }
 
+	/** Should the renderers produce frames? Normally only for the active
+	  * machine, but background machines can also render (e.g. to show
+	  * thumbnails of them). Never while fast-forwarding. */
+	[[nodiscard]] bool needRender() const {
+		return (active || backgroundRender) && !fastForwarding;
+	}
+	void setBackgroundRender(bool enable) { backgroundRender = enable; }
+
 	[[nodiscard]] byte readIRQVector();
 
 	[[nodiscard]] const HardwareConfig* getMachineConfig() const { return machineConfig; }
@@ -274,6 +283,7 @@ private:
 	bool powered;
 	bool active;
 	bool fastForwarding;
+	bool backgroundRender = false;
 };
 SERIALIZE_CLASS_VERSION(MSXMotherBoard, 5);
 
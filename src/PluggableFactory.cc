@@ -19,6 +19,7 @@
 #include "PrinterPortLogger.hh"
 #include "PrinterPortSimpl.hh"
 #include "Printer.hh"
+#include "RS232Net.hh"
 #include "RS232Tester.hh"
 #include "WavAudioInput.hh"
 #include "components.hh"
@@ -42,6 +43,7 @@ void PluggableFactory::createAll(PluggingController& controller,
 {
 	auto& reactor                = motherBoard.getReactor();
 	auto& scheduler              = motherBoard.getScheduler();
+	auto& realTime               = motherBoard.getRealTime();
 	auto& commandController      = motherBoard.getCommandController();
 	auto& msxEventDistributor    = motherBoard.getMSXEventDistributor();
 	auto& stateChangeDistributor = motherBoard.getStateChangeDistributor();
@@ -91,6 +93,8 @@ void PluggableFactory::createAll(PluggingController& controller,
 	// Serial communication:
 	controller.registerPluggable(std::make_unique<RS232Tester>(
 		eventDistributor, scheduler, commandController));
+	controller.registerPluggable(std::make_unique<RS232Net>(
+		eventDistributor, scheduler, commandController));
 
 	// Sampled audio:
 	controller.registerPluggable(std::make_unique<PrinterPortSimpl>(
@@ -104,16 +108,16 @@ void PluggableFactory::createAll(PluggingController& controller,
 	// reads all data as soon as it becomes available, so this pluggable is
 	// not useful on Windows.
 	controller.registerPluggable(std::make_unique<MidiInReader>(
-		eventDistributor, scheduler, commandController));
+		eventDistributor, scheduler, realTime, commandController));
 #endif
 #if defined(_WIN32)
-	MidiInWindows::registerAll(eventDistributor, scheduler, controller);
+	MidiInWindows::registerAll(eventDistributor, scheduler, realTime, controller);
 	MidiOutWindows::registerAll(controller);
 #endif
 #if defined(__APPLE__)
 	controller.registerPluggable(std::make_unique<MidiInCoreMIDIVirtual>(
-		eventDistributor, scheduler));
-	MidiInCoreMIDI::registerAll(eventDistributor, scheduler, controller);
+		eventDistributor, scheduler, realTime));
+	MidiInCoreMIDI::registerAll(eventDistributor, scheduler, realTime, controller);
 	controller.registerPluggable(std::make_unique<MidiOutCoreMIDIVirtual>());
 	MidiOutCoreMIDI::registerAll(controller);
 #endif
@@ -1,5 +1,6 @@
 #include "Printer.hh"
 #include "PNG.hh"
+#include "File.hh"
 #include "FileOperations.hh"
 #include "IntegerSetting.hh"
 #include "MSXMotherBoard.hh"
@@ -264,6 +265,10 @@ void ImagePrinter::ensurePrintPage()
 
 void ImagePrinter::flushEmulatedPrinter()
 {
+	for (const auto& error : PNG::takeAsyncErrors()) {
+		motherBoard.getMSXCliComm().printWarning(
+			"Failed to print: ", error);
+	}
 	if (paper) {
 		if (printAreaBottom > printAreaTop) {
 			try {
@@ -1649,11 +1654,17 @@ std::string Paper::save() const
 {
 	auto filename = FileOperations::getNextNumberedFileName(
 		"prints", "page", ".png");
+	// Encoding a full page takes long, do that in the background. But
+	// already create the (empty) file, so that the next page gets a
+	// different number.
+	File(filename, File::TRUNCATE);
 	VLA(const void*, rowPointers, sizeY);
 	for (auto y : xrange(sizeY)) {
 		rowPointers[y] = &buf[sizeX * y];
 	}
-	PNG::saveGrayscale(sizeX, sizeY, rowPointers, filename);
+	PNG::SaveOptions options;
+	options.async = true;
+	PNG::saveGrayscale(sizeX, sizeY, rowPointers, filename, options);
 	return filename;
 }
 
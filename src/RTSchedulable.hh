@@ -1,6 +1,7 @@
 #ifndef RTSCHEDULABLE_HH
 #define RTSCHEDULABLE_HH
 
+#include <cstddef>
 #include <cstdint>
 
 namespace openmsx {
@@ -24,7 +25,11 @@ protected:
 	~RTSchedulable();
 
 private:
+	friend class RTScheduler;
+	static constexpr size_t NOT_PENDING = size_t(-1);
+
 	RTScheduler& scheduler;
+	size_t rtIndex = NOT_PENDING; // position in the RTScheduler queue
 };
 
 } // namespace openmsx
@@ -1,36 +1,39 @@
 #include "RTScheduler.hh"
 #include "RTSchedulable.hh"
-#include "ranges.hh"
-#include <limits>
+#include <cassert>
 
 namespace openmsx {
 
-struct EqualRTSchedulable {
-	explicit EqualRTSchedulable(const RTSchedulable& schedulable_)
-		: schedulable(schedulable_) {}
-	bool operator()(const RTSyncPoint& sp) const {
-		return sp.schedulable == &schedulable;
+[[nodiscard]] static bool before(const RTSyncPoint& x, const RTSyncPoint& y)
+{
+	return (x.time != y.time) ? (x.time < y.time) : (x.seq < y.seq);
+}
+
+RTScheduler::~RTScheduler()
+{
+	for (auto& sp : heap) {
+		sp.schedulable->rtIndex = RTSchedulable::NOT_PENDING;
 	}
-	const RTSchedulable& schedulable;
-};
+}
 
 void RTScheduler::add(uint64_t delta, RTSchedulable& schedulable)
 {
-	queue.insert(RTSyncPoint{Timer::getTime() + delta, &schedulable},
-	             [](RTSyncPoint& sp) {
-	                     sp.time = std::numeric_limits<uint64_t>::max(); },
-	             [](const RTSyncPoint& x, const RTSyncPoint& y) {
-	                     return x.time < y.time; });
+	assert(!isPending(schedulable));
+	heap.push_back(RTSyncPoint{Timer::getTime() + delta, nextSeq++, &schedulable});
+	schedulable.rtIndex = heap.size() - 1;
+	siftUp(heap.size() - 1);
 }
 
 bool RTScheduler::remove(RTSchedulable& schedulable)
 {
-	return queue.remove(EqualRTSchedulable(schedulable));
+	if (!isPending(schedulable)) return false;
+	removeAt(schedulable.rtIndex);
+	return true;
 }
 
 bool RTScheduler::isPending(const RTSchedulable& schedulable) const
 {
-	return ranges::any_of(queue, EqualRTSchedulable(schedulable));
+	return schedulable.rtIndex != RTSchedulable::NOT_PENDING;
 }
 
 void RTScheduler::scheduleHelper(uint64_t limit)
@@ -38,19 +41,69 @@ void RTScheduler::scheduleHelper(uint64_t limit)
 	// Process at most this many events to prevent getting stuck in an
 	// infinite loop when a RTSchedulable keeps on rescheduling itself in
 	// the (too) near future.
-	auto count = queue.size();
+	auto count = heap.size();
 	while (true) {
-		auto* schedulable = queue.front().schedulable;
-		queue.remove_front();
+		auto* schedulable = heap.front().schedulable;
+		removeAt(0);
 
 		schedulable->executeRT();
 
 		// It's possible RTSchedulables are canceled in the mean time,
 		// so we can't rely on 'count' to replace this empty check.
-		if (queue.empty()) break;
-		if (likely(queue.front().time > limit)) break;
+		if (heap.empty()) break;
+		if (likely(heap.front().time > limit)) break;
 		if (--count == 0) break;
 	}
 }
 
+void RTScheduler::removeAt(size_t index)
+{
+	assert(index < heap.size());
+	heap[index].schedulable->rtIndex = RTSchedulable::NOT_PENDING;
+	auto last = heap.back();
+	heap.pop_back();
+	if (index == heap.size()) return; // removed the last element
+	place(index, last);
+	if ((index > 0) && before(last, heap[(index - 1) / 2])) {
+		siftUp(index);
+	} else {
+		siftDown(index);
+	}
+}
+
+void RTScheduler::siftUp(size_t index)
+{
+	auto sp = heap[index];
+	while (index > 0) {
+		auto parent = (index - 1) / 2;
+		if (!before(sp, heap[parent])) break;
+		place(index, heap[parent]);
+		index = parent;
+	}
+	place(index, sp);
+}
+
+void RTScheduler::siftDown(size_t index)
+{
+	auto sp = heap[index];
+	auto size = heap.size();
+	while (true) {
+		auto child = 2 * index + 1;
+		if (child >= size) break;
+		if (((child + 1) < size) && before(heap[child + 1], heap[child])) {
+			++child;
+		}
+		if (!before(heap[child], sp)) break;
+		place(index, heap[child]);
+		index = child;
+	}
+	place(index, sp);
+}
+
+void RTScheduler::place(size_t index, const RTSyncPoint& sp)
+{
+	heap[index] = sp;
+	sp.schedulable->rtIndex = index;
+}
+
 } // namespace openmsx
@@ -1,10 +1,11 @@
 #ifndef RTSCHEDULER_HH
 #define RTSCHEDULER_HH
 
-#include "SchedulerQueue.hh"
 #include "Timer.hh"
 #include "likely.hh"
 #include <cstdint>
+#include <optional>
+#include <vector>
 
 namespace openmsx {
 
@@ -13,21 +14,44 @@ class RTSchedulable;
 struct RTSyncPoint
 {
 	uint64_t time;
+	uint64_t seq; // among equal times, execute in order of scheduling
 	RTSchedulable* schedulable;
 };
 
+/** Executes RTSchedulables at a given (host) time.
+  *
+  * The pending RTSchedulables are stored in a binary min-heap. Each
+  * RTSchedulable is in the queue at most once and knows its position in the
+  * heap, so adding, canceling and executing are all O(log n), and checking
+  * whether it's pending is O(1).
+  */
 class RTScheduler
 {
 public:
+	RTScheduler() = default;
+	RTScheduler(const RTScheduler&) = delete;
+	RTScheduler& operator=(const RTScheduler&) = delete;
+	~RTScheduler();
+
 	/** Execute all expired RTSchedulables. */
 	inline void execute()
 	{
+		if (heap.empty()) return;
 		auto limit = Timer::getTime();
-		if (!queue.empty() && unlikely(limit >= queue.front().time)) {
+		if (unlikely(limit >= heap.front().time)) {
 			scheduleHelper(limit); // slow path not inlined
 		}
 	}
 
+	/** The (host) time of the earliest pending RTSchedulable, or nothing
+	  * when there are none. The main loop uses this to not sleep longer
+	  * than needed. */
+	[[nodiscard]] std::optional<uint64_t> getNextDeadline() const
+	{
+		if (heap.empty()) return {};
+		return heap.front().time;
+	}
+
 private:
 	// These are called by RTSchedulable
 	friend class RTSchedulable;
@@ -37,8 +61,14 @@ private:
 
 	void scheduleHelper(uint64_t limit);
 
+	void removeAt(size_t index);
+	void siftUp(size_t index);
+	void siftDown(size_t index);
+	void place(size_t index, const RTSyncPoint& sp);
+
 private:
-	SchedulerQueue<RTSyncPoint> queue;
+	std::vector<RTSyncPoint> heap;
+	uint64_t nextSeq = 0;
 };
 
 } // namespace openmsx
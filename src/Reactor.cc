@@ -9,11 +9,13 @@
 #include "DiskManipulator.hh"
 #include "DiskChanger.hh"
 #include "FilePool.hh"
+#include "ListDirCommand.hh"
 #include "UserSettings.hh"
 #include "RomDatabase.hh"
 #include "RomInfo.hh"
 #include "TclCallbackMessages.hh"
 #include "MSXMotherBoard.hh"
+#include "MSXException.hh"
 #include "StateChangeDistributor.hh"
 #include "Command.hh"
 #include "AfterCommand.hh"
@@ -25,9 +27,11 @@
 #include "VideoSystem.hh"
 #include "Mixer.hh"
 #include "AviRecorder.hh"
+#include "FrameStreamer.hh"
 #include "GlobalSettings.hh"
 #include "BooleanSetting.hh"
 #include "EnumSetting.hh"
+#include "TclArgParser.hh"
 #include "TclObject.hh"
 #include "HardwareConfig.hh"
 #include "XMLElement.hh"
@@ -36,8 +40,16 @@
 #include "FileException.hh"
 #include "FileOperations.hh"
 #include "foreach_file.hh"
+#include "one_of.hh"
 #include "Thread.hh"
 #include "Timer.hh"
+#include "PerfTimers.hh"
+#include "PostProcessor.hh"
+#include "ReverseManager.hh"
+#include "WorkerPool.hh"
+#include "AllocCounters.hh"
+#include "DeltaBlock.hh"
+#include "MemBuffer.hh"
 #include "serialize.hh"
 #include "ranges.hh"
 #include "statp.hh"
@@ -45,9 +57,20 @@
 #include "StringOp.hh"
 #include "unreachable.hh"
 #include "view.hh"
+#include "xrange.hh"
 #include "build-info.hh"
+#include <algorithm>
+#include <array>
 #include <cassert>
+#include <fstream>
+#include <iostream>
 #include <memory>
+#include <mutex>
+#include <optional>
+
+#if defined(__linux__)
+#include <unistd.h>
+#endif
 
 using std::make_unique;
 using std::string;
@@ -155,6 +178,63 @@ private:
 	Reactor& reactor;
 };
 
+class CloneMachineCommand final : public Command
+{
+public:
+	CloneMachineCommand(CommandController& commandController, Reactor& reactor);
+	void execute(span<const TclObject> tokens, TclObject& result) override;
+	[[nodiscard]] string help(span<const TclObject> tokens) const override;
+	void tabCompletion(vector<string>& tokens) const override;
+private:
+	Reactor& reactor;
+};
+
+class QuickSlotCommand final : public Command
+{
+public:
+	QuickSlotCommand(CommandController& commandController, Reactor& reactor);
+	void execute(span<const TclObject> tokens, TclObject& result) override;
+	[[nodiscard]] string help(span<const TclObject> tokens) const override;
+	void tabCompletion(vector<string>& tokens) const override;
+private:
+	void save(span<const TclObject> tokens, TclObject& result);
+	void load(span<const TclObject> tokens, TclObject& result);
+	void persist(MSXMotherBoard& board, const string& filename);
+	void reportPersistErrors();
+	[[nodiscard]] vector<string> getSlotNames() const;
+
+private:
+	struct Slot {
+		string name;
+		MemBuffer<uint8_t> buf;
+		size_t size;
+		vector<std::shared_ptr<DeltaBlock>> deltaBlocks;
+	};
+	Reactor& reactor;
+	vector<Slot> slots;
+	// Shared by all slots: the blobs (e.g. RAM) are delta-compressed
+	// against the previously saved slot.
+	LastDeltaBlocks lastDeltaBlocks;
+
+	// Errors from the background writes, reported on the next command.
+	struct PersistErrors {
+		std::mutex mutex;
+		vector<string> messages;
+	};
+	std::shared_ptr<PersistErrors> persistErrors;
+};
+
+class RunMachinesCommand final : public Command
+{
+public:
+	RunMachinesCommand(CommandController& commandController, Reactor& reactor);
+	void execute(span<const TclObject> tokens, TclObject& result) override;
+	[[nodiscard]] string help(span<const TclObject> tokens) const override;
+	void tabCompletion(vector<string>& tokens) const override;
+private:
+	Reactor& reactor;
+};
+
 class GetClipboardCommand final : public Command
 {
 public:
@@ -198,6 +278,27 @@ private:
 	const uint64_t reference;
 };
 
+class PerformanceInfo final : public InfoTopic
+{
+public:
+	explicit PerformanceInfo(InfoCommand& openMSXInfoCommand);
+	void execute(span<const TclObject> tokens,
+	             TclObject& result) const override;
+	[[nodiscard]] string help(span<const TclObject> tokens) const override;
+	void tabCompletion(vector<string>& tokens) const override;
+};
+
+class MemoryInfo final : public InfoTopic
+{
+public:
+	MemoryInfo(InfoCommand& openMSXInfoCommand, Reactor& reactor);
+	void execute(span<const TclObject> tokens,
+	             TclObject& result) const override;
+	[[nodiscard]] string help(span<const TclObject> tokens) const override;
+private:
+	Reactor& reactor;
+};
+
 class SoftwareInfoTopic final : InfoTopic
 {
 public:
@@ -230,6 +331,7 @@ void Reactor::init()
 	virtualDrive = make_unique<DiskChanger>(
 		*this, "virtual_drive");
 	filePool = make_unique<FilePool>(*globalCommandController, *this);
+	listDirCommand = make_unique<ListDirCommand>(*globalCommandController);
 	userSettings = make_unique<UserSettings>(
 		*globalCommandController);
 	afterCommand = make_unique<AfterCommand>(
@@ -254,17 +356,28 @@ void Reactor::init()
 		*globalCommandController, *this);
 	restoreMachineCommand = make_unique<RestoreMachineCommand>(
 		*globalCommandController, *this);
+	cloneMachineCommand = make_unique<CloneMachineCommand>(
+		*globalCommandController, *this);
+	quickSlotCommand = make_unique<QuickSlotCommand>(
+		*globalCommandController, *this);
+	runMachinesCommand = make_unique<RunMachinesCommand>(
+		*globalCommandController, *this);
 	getClipboardCommand = make_unique<GetClipboardCommand>(
 		*globalCommandController, *this);
 	setClipboardCommand = make_unique<SetClipboardCommand>(
 		*globalCommandController, *this);
 	aviRecordCommand = make_unique<AviRecorder>(*this);
+	frameStreamer = make_unique<FrameStreamer>(*this);
 	extensionInfo = make_unique<ConfigInfo>(
 		getOpenMSXInfoCommand(), "extensions");
 	machineInfo   = make_unique<ConfigInfo>(
 		getOpenMSXInfoCommand(), "machines");
 	realTimeInfo = make_unique<RealTimeInfo>(
 		getOpenMSXInfoCommand());
+	performanceInfo = make_unique<PerformanceInfo>(
+		getOpenMSXInfoCommand());
+	memoryInfo = make_unique<MemoryInfo>(
+		getOpenMSXInfoCommand(), *this);
 	softwareInfoTopic = make_unique<SoftwareInfoTopic>(
 		getOpenMSXInfoCommand(), *this);
 	tclCallbackMessages = make_unique<TclCallbackMessages>(
@@ -297,6 +410,7 @@ Reactor::~Reactor()
 Mixer& Reactor::getMixer()
 {
 	if (!mixer) {
+		PerfTimers::Scope perf(PerfTimers::AUDIO_INIT);
 		mixer = make_unique<Mixer>(*this, *globalCommandController);
 	}
 	return *mixer;
@@ -427,6 +541,7 @@ void Reactor::replaceBoard(MSXMotherBoard& oldBoard_, Board newBoard)
 void Reactor::switchMachine(const string& machine)
 {
 	if (!display) {
+		PerfTimers::Scope perf(PerfTimers::VIDEO_INIT);
 		display = make_unique<Display>(*this);
 		// TODO: Currently it is not possible to move this call into the
 		//       constructor of Display because the call to createVideoSystem()
@@ -507,10 +622,29 @@ void Reactor::enterMainLoop()
 	}
 }
 
+static void printStartupProfile()
+{
+	// The stages that (mostly) happen during startup. Measured by the
+	// always active PerfTimers, so (unless switching machines) this is
+	// also what 'openmsx_info performance' shows for them.
+	static constexpr std::string_view stages[] = {
+		"config", "rom_load", "filepool", "tcl", "video_init", "audio_init"
+	};
+	double total = 0.0;
+	std::cerr << "Startup profile:\n";
+	for (const auto& [name, seconds] : PerfTimers::getTimes()) {
+		total += seconds;
+		if (!contains(stages, name)) continue;
+		std::cerr << strCat("  ", name, ": ", int(seconds * 1000.0 + 0.5), "ms\n");
+	}
+	std::cerr << strCat("  total: ", int(total * 1000.0 + 0.5), "ms\n");
+}
+
 void Reactor::run(CommandLineParser& parser)
 {
 	auto& commandController = *globalCommandController;
 
+	std::optional<PerfTimers::Scope> tclPerf(std::in_place, PerfTimers::TCL);
 	// execute init.tcl
 	try {
 		commandController.source(
@@ -536,6 +670,7 @@ void Reactor::run(CommandLineParser& parser)
 			                 '\n', e.getMessage());
 		}
 	}
+	tclPerf.reset();
 
 	// At this point openmsx is fully started, it's OK now to start
 	// accepting external commands
@@ -553,6 +688,9 @@ void Reactor::run(CommandLineParser& parser)
 			activeBoard->powerUp();
 		}
 	}
+	if (parser.isStartupProfile()) {
+		printStartupProfile();
+	}
 
 	while (doOneIteration()) {
 		// nothing
@@ -562,6 +700,11 @@ void Reactor::run(CommandLineParser& parser)
 bool Reactor::doOneIteration()
 {
 	eventDistributor->deliverEvents();
+	// Commands from external (CliComm) connections, they get a limited
+	// amount of time per iteration (so roughly per frame), so that a client
+	// that sends a big batch of commands doesn't stall the emulation.
+	constexpr uint64_t CLI_COMMAND_BUDGET = 3000; // us
+	bool commandsPending = globalCliComm->executeCommands(CLI_COMMAND_BUDGET);
 	bool blocked = (blockedCounter > 0) || !activeBoard;
 	if (!blocked) {
 		// copy shared_ptr to keep Board alive (e.g. in case of Tcl
@@ -570,13 +713,20 @@ bool Reactor::doOneIteration()
 		blocked = !copy->execute();
 	}
 	if (blocked) {
-		// At first sight a better alternative is to use the
-		// SDL_WaitEvent() function. Though when inspecting
-		// the implementation of that function, it turns out
-		// to also use a sleep/poll loop, with even shorter
-		// sleep periods as we use here. Maybe in future
-		// SDL implementations this will be improved.
-		eventDistributor->sleep(20 * 1000);
+		// Nothing to emulate: sleep till a host event arrives, another
+		// thread calls distributeEvent() (e.g. a CliComm command) or
+		// the next RTSchedulable deadline (e.g. an OSD fade or a
+		// delayed repaint). When SDL can't block till the next host
+		// event, idleSleep() falls back to polling every 20ms. The
+		// limit of 1s is only a safety net (Tcl's own event loop, see
+		// Interpreter::poll()).
+		uint64_t sleep = 1000 * 1000;
+		if (auto deadline = rtScheduler->getNextDeadline()) {
+			auto now = Timer::getTime();
+			sleep = (*deadline > now) ? std::min(sleep, *deadline - now) : 0;
+		}
+		if (commandsPending) sleep = 0;
+		if (sleep) eventDistributor->idleSleep(unsigned(sleep));
 	}
 	return running;
 }
@@ -891,29 +1041,48 @@ StoreMachineCommand::StoreMachineCommand(
 
 void StoreMachineCommand::execute(span<const TclObject> tokens, TclObject& result)
 {
-	checkNumArgs(tokens, Between{1, 3}, Prefix{1}, "?id? ?filename?");
+	string_view format = "xml";
+	ArgsInfo info[] = { valueArg("-format", format) };
+	auto args = parseTclArgs(getInterpreter(), tokens.subspan(1), info);
+	if (args.size() > 2) {
+		throw SyntaxError();
+	}
+	bool binary = false;
+	if (format == "binary") {
+		binary = true;
+	} else if (format != "xml") {
+		throw CommandException("Unknown format '", format,
+		                       "', must be 'xml' or 'binary'.");
+	}
+
 	string filename;
 	string_view machineID;
-	switch (tokens.size()) {
-	case 1:
+	switch (args.size()) {
+	case 0:
 		machineID = reactor.getMachineID();
-		filename = FileOperations::getNextNumberedFileName("savestates", "openmsxstate", ".xml.gz");
+		filename = FileOperations::getNextNumberedFileName("savestates", "openmsxstate", binary ? ".oms" : ".xml.gz");
 		break;
-	case 2:
-		machineID = tokens[1].getString();
-		filename = FileOperations::getNextNumberedFileName("savestates", "openmsxstate", ".xml.gz");
+	case 1:
+		machineID = args[0].getString();
+		filename = FileOperations::getNextNumberedFileName("savestates", "openmsxstate", binary ? ".oms" : ".xml.gz");
 		break;
-	case 3:
-		machineID = tokens[1].getString();
-		filename = tokens[2].getString();
+	case 2:
+		machineID = args[0].getString();
+		filename = args[1].getString();
 		break;
 	}
 
 	auto& board = *reactor.getMachine(machineID);
 
-	XmlOutputArchive out(filename);
-	out.serialize("machine", board);
-	out.close();
+	if (binary) {
+		BinaryOutputArchive out(filename);
+		out.serialize("machine", board);
+		out.close();
+	} else {
+		XmlOutputArchive out(filename);
+		out.serialize("machine", board);
+		out.close();
+	}
 	result = filename;
 }
 
@@ -924,6 +1093,10 @@ string StoreMachineCommand::help(span<const TclObject> /*tokens*/) const
 		"store_machine machineID             Save state of machine \"machineID\" to file \"openmsxNNNN.xml.gz\"\n"
 		"store_machine machineID <filename>  Save state of machine \"machineID\" to indicated file\n"
 		"\n"
+		"With the option '-format binary' a compact binary file is written\n"
+		"instead of the (default) XML format. Binary files are faster to\n"
+		"save and load, but can only be loaded on the same type of platform.\n"
+		"\n"
 		"This is a low-level command, the 'savestate' script is easier to use.";
 }
 
@@ -975,8 +1148,13 @@ void RestoreMachineCommand::execute(span<const TclObject> tokens,
 
 	//std::cerr << "Loading " << filename << '\n';
 	try {
-		XmlInputArchive in(filename);
-		in.serialize("machine", *newBoard);
+		if (BinaryInputArchive::isBinaryFile(filename)) {
+			BinaryInputArchive in(filename);
+			in.serialize("machine", *newBoard);
+		} else {
+			XmlInputArchive in(filename);
+			in.serialize("machine", *newBoard);
+		}
 	} catch (XMLException& e) {
 		throw CommandException("Cannot load state, bad file format: ",
 		                       e.getMessage());
@@ -1008,6 +1186,340 @@ void RestoreMachineCommand::tabCompletion(vector<string>& tokens) const
 }
 
 
+// class CloneMachineCommand
+
+CloneMachineCommand::CloneMachineCommand(
+	CommandController& commandController_, Reactor& reactor_)
+	: Command(commandController_, "clone_machine")
+	, reactor(reactor_)
+{
+}
+
+void CloneMachineCommand::execute(span<const TclObject> tokens,
+                                  TclObject& result)
+{
+	checkNumArgs(tokens, Between{1, 2}, Prefix{1}, "?id?");
+	auto& board = (tokens.size() == 1)
+	            ? *reactor.getMachine(reactor.getMachineID())
+	            : *reactor.getMachine(tokens[1].getString());
+
+	// Like a reverse snapshot, but without touching the dirty-page
+	// tracking of the reverse snapshots of 'board' (own deltaBlocks).
+	auto newBoard = reactor.createEmptyMotherBoard();
+	try {
+		LastDeltaBlocks lastDeltaBlocks;
+		std::vector<std::shared_ptr<DeltaBlock>> deltaBlocks;
+		MemOutputArchive out(lastDeltaBlocks, deltaBlocks, false);
+		out.serialize("machine", board);
+		size_t size;
+		auto buf = out.releaseBuffer(size);
+		MemInputArchive in(buf.data(), size, deltaBlocks);
+		in.serialize("machine", *newBoard);
+	} catch (MSXException& e) {
+		throw CommandException("Cannot clone machine: ", e.getMessage());
+	}
+
+	// Same as for restore_machine: the clone should see the actual host
+	// keyboard state, not the one stored in the state.
+	newBoard->getStateChangeDistributor().stopReplay(newBoard->getCurrentTime());
+
+	result = newBoard->getMachineID();
+	reactor.boards.push_back(move(newBoard));
+}
+
+string CloneMachineCommand::help(span<const TclObject> /*tokens*/) const
+{
+	return "clone_machine       Make a copy of the current machine\n"
+	       "clone_machine <id>  Make a copy of the indicated machine\n"
+	       "\n"
+	       "The copy gets a new machine ID (the result of this command). "
+	       "This is like 'store_machine' followed by 'restore_machine', "
+	       "but much faster because the state isn't written to a file.";
+}
+
+void CloneMachineCommand::tabCompletion(vector<string>& tokens) const
+{
+	completeString(tokens, reactor.getMachineIDs());
+}
+
+
+// class QuickSlotCommand
+
+QuickSlotCommand::QuickSlotCommand(
+	CommandController& commandController_, Reactor& reactor_)
+	: Command(commandController_, "quickslot")
+	, reactor(reactor_)
+	, persistErrors(std::make_shared<PersistErrors>())
+{
+}
+
+void QuickSlotCommand::execute(span<const TclObject> tokens, TclObject& result)
+{
+	reportPersistErrors();
+	checkNumArgs(tokens, AtLeast{2}, "subcommand ?arg ...?");
+	executeSubCommand(tokens[1].getString(),
+		"save", [&]{ save(tokens, result); },
+		"load", [&]{ load(tokens, result); },
+		"list", [&]{
+			checkNumArgs(tokens, 2, "");
+			result.addListElements(getSlotNames());
+		},
+		"delete", [&]{
+			checkNumArgs(tokens, 3, "slot");
+			auto name = tokens[2].getString();
+			auto it = ranges::find(slots, name, &Slot::name);
+			if (it == end(slots)) {
+				throw CommandException("No such slot: ", name);
+			}
+			slots.erase(it);
+		});
+}
+
+void QuickSlotCommand::save(span<const TclObject> tokens, TclObject& result)
+{
+	string_view persistName;
+	ArgsInfo info[] = { valueArg("-persist", persistName) };
+	auto args = parseTclArgs(getInterpreter(), tokens.subspan(2), info);
+	if (args.size() > 1) throw SyntaxError();
+	string name = args.empty() ? string("0") : string(args[0].getString());
+
+	auto* board = reactor.getMotherBoard();
+	if (!board) throw CommandException("No machine.");
+
+	Slot slot{name, {}, 0, {}};
+	try {
+		// Same as for clone_machine: own deltaBlocks, so the dirty-page
+		// tracking of the reverse snapshots isn't disturbed.
+		MemOutputArchive out(lastDeltaBlocks, slot.deltaBlocks, false);
+		out.serialize("machine", *board);
+		slot.buf = out.releaseBuffer(slot.size);
+	} catch (MSXException& e) {
+		throw CommandException("Cannot save slot: ", e.getMessage());
+	}
+	if (auto it = ranges::find(slots, name, &Slot::name); it != end(slots)) {
+		*it = std::move(slot);
+	} else {
+		slots.push_back(std::move(slot));
+	}
+
+	if (!persistName.empty()) {
+		persist(*board, FileOperations::expandTilde(string(persistName)));
+	}
+	result = name;
+}
+
+void QuickSlotCommand::persist(MSXMotherBoard& board, const string& filename)
+{
+	// Only the serialization needs the emulator state. The (relatively
+	// slow) compression and writing is done in the background.
+	MemBuffer<uint8_t> buf;
+	size_t size;
+	try {
+		BinaryOutputArchive out(filename);
+		out.serialize("machine", board);
+		buf = out.releaseBuffer(size);
+	} catch (MSXException& e) {
+		throw CommandException("Cannot persist slot: ", e.getMessage());
+	}
+	// (std::function requires a copyable functor)
+	auto data = std::make_shared<MemBuffer<uint8_t>>(std::move(buf));
+	WorkerPool::background().post(
+		[filename, data, size, errors = persistErrors] {
+			try {
+				BinaryOutputArchive::writeFile(
+					filename, span<const uint8_t>(data->data(), size));
+			} catch (MSXException& e) {
+				std::lock_guard lock(errors->mutex);
+				errors->messages.push_back(e.getMessage());
+			}
+		});
+}
+
+void QuickSlotCommand::reportPersistErrors()
+{
+	vector<string> messages;
+	{
+		std::lock_guard lock(persistErrors->mutex);
+		std::swap(messages, persistErrors->messages);
+	}
+	for (const auto& m : messages) {
+		reactor.getCliComm().printWarning("Couldn't persist quickslot: ", m);
+	}
+}
+
+void QuickSlotCommand::load(span<const TclObject> tokens, TclObject& result)
+{
+	checkNumArgs(tokens, Between{2, 3}, "?slot?");
+	string_view name = (tokens.size() == 3) ? tokens[2].getString() : "0";
+	auto it = ranges::find(slots, name, &Slot::name);
+	if (it == end(slots)) {
+		throw CommandException("No such slot: ", name);
+	}
+	auto* oldBoard = reactor.getMotherBoard();
+	if (!oldBoard) throw CommandException("No machine.");
+
+	auto newBoard = reactor.createEmptyMotherBoard();
+	try {
+		MemInputArchive in(it->buf.data(), it->size, it->deltaBlocks);
+		in.serialize("machine", *newBoard);
+	} catch (MSXException& e) {
+		throw CommandException("Cannot load slot: ", e.getMessage());
+	}
+	// Same as for restore_machine: use the actual host keyboard state.
+	newBoard->getStateChangeDistributor().stopReplay(newBoard->getCurrentTime());
+
+	result = newBoard->getMachineID();
+	reactor.replaceBoard(*oldBoard, std::move(newBoard));
+}
+
+vector<string> QuickSlotCommand::getSlotNames() const
+{
+	return to_vector<string>(view::transform(slots, &Slot::name));
+}
+
+string QuickSlotCommand::help(span<const TclObject> /*tokens*/) const
+{
+	return
+		"quickslot save [-persist <filename>] [<slot>]  Save the current machine in the given slot (default '0')\n"
+		"quickslot load [<slot>]                        Replace the current machine by the one in the slot\n"
+		"quickslot list                                 List the used slots\n"
+		"quickslot delete <slot>                        Free the memory of a slot\n"
+		"\n"
+		"The slots are kept in memory (delta-compressed against the previously "
+		"saved slot), so this is a lot faster than savestate/loadstate. With "
+		"'-persist' the state is additionally written as a binary savestate "
+		"(see store_machine), the compression and writing is done in the "
+		"background. Errors of that are reported on the next quickslot command.";
+}
+
+void QuickSlotCommand::tabCompletion(vector<string>& tokens) const
+{
+	if (tokens.size() == 2) {
+		static constexpr const char* const subCmds[] = {
+			"save", "load", "list", "delete"
+		};
+		completeString(tokens, subCmds);
+	} else if (tokens.size() == 3) {
+		if (tokens[1] == one_of("load", "delete", "save")) {
+			completeString(tokens, getSlotNames());
+		}
+	}
+}
+
+
+// class RunMachinesCommand
+
+RunMachinesCommand::RunMachinesCommand(
+	CommandController& commandController_, Reactor& reactor_)
+	: Command(commandController_, "run_machines")
+	, reactor(reactor_)
+{
+}
+
+void RunMachinesCommand::execute(span<const TclObject> tokens, TclObject& result)
+{
+	checkNumArgs(tokens, AtLeast{2}, "?-render? duration ?id ...?");
+	bool render = false;
+	ArgsInfo info[] = { flagArg("-render", render) };
+	auto arguments = parseTclArgs(getInterpreter(), tokens.subspan(1), info);
+	if (arguments.empty()) throw SyntaxError();
+	double duration = arguments[0].getDouble(getInterpreter());
+	if (duration < 0.0) {
+		throw CommandException("Duration must be positive");
+	}
+
+	vector<Reactor::Board> batch;
+	if (arguments.size() == 1) {
+		// all machines, except the active one
+		for (auto& b : reactor.boards) {
+			if ((b != reactor.activeBoard) && b->isPowered()) {
+				batch.push_back(b);
+			}
+		}
+	} else {
+		for (const auto& t : view::drop(arguments, 1)) {
+			auto b = reactor.getMachine(t.getString());
+			if (b == reactor.activeBoard) {
+				throw CommandException(
+					"Can't run the active machine: ", b->getMachineID());
+			}
+			if (!b->isPowered()) {
+				throw CommandException(
+					"Machine is not powered on: ", b->getMachineID());
+			}
+			if (!contains(batch, b)) batch.push_back(b);
+		}
+	}
+
+	// The emulation core (scheduler, mixer, events, Tcl) can only be used
+	// from the main thread, so the machines run one after the other. They
+	// take turns in slices of emulated time, so that all of them make
+	// progress at about the same rate.
+	constexpr double SLICE = 0.1; // emulated seconds
+	vector<EmuTime> endTimes;
+	endTimes.reserve(batch.size());
+	for (auto& b : batch) {
+		endTimes.push_back(b->getCurrentTime() + EmuDuration(duration));
+	}
+	vector<string> errors(batch.size());
+	vector<bool> done(batch.size(), false);
+	bool busy = true;
+	while (busy) {
+		busy = false;
+		for (auto i : xrange(batch.size())) {
+			if (done[i]) continue;
+			auto& board = *batch[i];
+			auto start = board.getCurrentTime();
+			auto time = std::min(endTimes[i], start + EmuDuration(SLICE));
+			board.setBackgroundRender(render);
+			try {
+				board.fastForward(time, !render);
+			} catch (MSXException& e) {
+				errors[i] = e.getMessage();
+			}
+			board.setBackgroundRender(false);
+			// also stop when the machine doesn't advance (e.g. when
+			// it's stopped by the debugger)
+			done[i] = !errors[i].empty() ||
+			          (board.getCurrentTime() >= endTimes[i]) ||
+			          (board.getCurrentTime() == start);
+			busy |= !done[i];
+		}
+	}
+
+	for (auto i : xrange(batch.size())) {
+		auto& board = *batch[i];
+		auto time = strCat((board.getCurrentTime() - EmuTime::zero()).toDouble());
+		board.getMSXCliComm().update(CliComm::STATUS, "run_machines",
+		                             errors[i].empty() ? time : errors[i]);
+		result.addDictKeyValue(board.getMachineID(), time);
+	}
+}
+
+string RunMachinesCommand::help(span<const TclObject> /*tokens*/) const
+{
+	return "run_machines <duration>            Run all machines, except the active one, for the given amount of (emulated) seconds\n"
+	       "run_machines <duration> <id> ...   Run the given machines for the given amount of (emulated) seconds\n"
+	       "run_machines -render <duration> ?<id> ...?\n"
+	       "                                   Same, but also render the frames of these machines, e.g. for 'screenshot -raw -machine <id>'\n"
+	       "\n"
+	       "The machines run without throttling, without sound and (unless -render is given) without rendering. "
+	       "The machines take turns in slices of 0.1 emulated seconds. "
+	       "This command only returns when all machines are done, it returns a dictionary "
+	       "of machine ID with the reached emulation time.";
+}
+
+void RunMachinesCommand::tabCompletion(vector<string>& tokens) const
+{
+	if (tokens.size() == 2) {
+		static constexpr const char* const options[] = {"-render"};
+		completeString(tokens, options);
+	} else if (tokens.size() > 2) {
+		completeString(tokens, reactor.getMachineIDs());
+	}
+}
+
+
 // class GetClipboardCommand
 
 GetClipboardCommand::GetClipboardCommand(
@@ -1124,6 +1636,136 @@ string RealTimeInfo::help(span<const TclObject> /*tokens*/) const
 }
 
 
+// class PerformanceInfo
+
+PerformanceInfo::PerformanceInfo(InfoCommand& openMSXInfoCommand)
+	: InfoTopic(openMSXInfoCommand, "performance")
+{
+}
+
+void PerformanceInfo::execute(span<const TclObject> tokens,
+                              TclObject& result) const
+{
+	switch (tokens.size()) {
+	case 2:
+		for (const auto& [name, seconds] : PerfTimers::getTimes()) {
+			result.addDictKeyValue(name, seconds);
+		}
+		break;
+	case 3:
+		if (tokens[2] == "heap") {
+			if (!AllocCounters::HEAP_TRACKING) {
+				throw CommandException(
+					"Heap allocation tracking is not enabled in "
+					"this build, see OPENMSX_ALLOC_TRACKING.");
+			}
+			for (auto slot : xrange(PerfTimers::getNumSlots())) {
+				result.addDictKeyValue(PerfTimers::getName(slot),
+					int64_t(AllocCounters::getHeapCount(slot)));
+			}
+			result.addDictKeyValue("other_threads",
+				int64_t(AllocCounters::getOtherThreadsHeapCount()));
+			break;
+		}
+		if (tokens[2] != "allocations") {
+			throw CommandException("Unknown subtopic: ", tokens[2].getString());
+		}
+		for (auto kind : xrange(unsigned(AllocCounters::NUM_KINDS))) {
+			auto k = AllocCounters::Kind(kind);
+			auto totals = AllocCounters::get(k);
+			result.addDictKeyValue(AllocCounters::getName(k),
+				makeTclDict("count", int64_t(totals.count),
+				            "bytes", int64_t(totals.bytes)));
+		}
+		break;
+	default:
+		throw CommandException("Too many parameters");
+	}
+}
+
+string PerformanceInfo::help(span<const TclObject> /*tokens*/) const
+{
+	return "Returns a dict with the (real) time in seconds spent in each "
+	       "stage of the emulation since openMSX was started: CPU "
+	       "emulation, the device callbacks (per type), VDP rendering, "
+	       "sound generation, post-processing, OSD, Tcl scripts and "
+	       "'other' for the rest (e.g. waiting). Time spent in nested "
+	       "stages is not counted in the enclosing stage.\n"
+	       "'info performance allocations' returns a dict with the "
+	       "number of heap allocations and the allocated bytes since "
+	       "openMSX was started, for creating in-memory snapshots and "
+	       "for XML documents (configs, XML savestates).\n"
+	       "'info performance heap' returns a dict with the number of "
+	       "heap allocations per stage (and for all other threads "
+	       "together) since openMSX was started. Only available in builds "
+	       "with allocation tracking enabled.";
+}
+
+void PerformanceInfo::tabCompletion(vector<string>& tokens) const
+{
+	if (tokens.size() == 3) {
+		using namespace std::literals;
+		static constexpr std::array subTopics = {"allocations"sv, "heap"sv};
+		completeString(tokens, subTopics);
+	}
+}
+
+
+// class MemoryInfo
+
+MemoryInfo::MemoryInfo(InfoCommand& openMSXInfoCommand, Reactor& reactor_)
+	: InfoTopic(openMSXInfoCommand, "memory")
+	, reactor(reactor_)
+{
+}
+
+// Resident set size of the whole process (in bytes), nullopt when unknown.
+[[nodiscard]] static std::optional<int64_t> getResidentMemory()
+{
+#if defined(__linux__)
+	std::ifstream statm("/proc/self/statm");
+	int64_t size, resident;
+	if (statm >> size >> resident) {
+		return resident * sysconf(_SC_PAGESIZE);
+	}
+#endif
+	return {};
+}
+
+void MemoryInfo::execute(span<const TclObject> /*tokens*/,
+                         TclObject& result) const
+{
+	if (auto resident = getResidentMemory()) {
+		result.addDictKeyValue("resident", *resident);
+	}
+
+	size_t reverse = 0;
+	for (const auto& board : reactor.boards) {
+		reverse += board->getReverseManager().getMemoryUsage();
+	}
+	result.addDictKeyValue("reverse", int64_t(reverse));
+
+	size_t frames = 0;
+	if (reactor.display) {
+		for (auto* l : reactor.display->getAllLayers()) {
+			if (auto* pp = dynamic_cast<PostProcessor*>(l)) {
+				frames += pp->getFrameMemoryUsage();
+			}
+		}
+	}
+	result.addDictKeyValue("video_frames", int64_t(frames));
+}
+
+string MemoryInfo::help(span<const TclObject> /*tokens*/) const
+{
+	return "Returns a dict with the memory (in bytes) used by openMSX: "
+	       "'resident' is the resident memory of the whole process (only "
+	       "on Linux), 'reverse' the snapshots in the reverse history of "
+	       "all machines and 'video_frames' the unscaled frames kept by "
+	       "the renderers (e.g. for deinterlace or deflicker).";
+}
+
+
 // SoftwareInfoTopic
 
 SoftwareInfoTopic::SoftwareInfoTopic(InfoCommand& openMSXInfoCommand, Reactor& reactor_)
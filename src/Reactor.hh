@@ -28,6 +28,7 @@ class DiskFactory;
 class DiskManipulator;
 class DiskChanger;
 class FilePool;
+class ListDirCommand;
 class UserSettings;
 class RomDatabase;
 class TclCallbackMessages;
@@ -45,11 +46,17 @@ class ListMachinesCommand;
 class ActivateMachineCommand;
 class StoreMachineCommand;
 class RestoreMachineCommand;
+class CloneMachineCommand;
+class QuickSlotCommand;
+class RunMachinesCommand;
 class GetClipboardCommand;
 class SetClipboardCommand;
 class AviRecorder;
+class FrameStreamer;
 class ConfigInfo;
 class RealTimeInfo;
+class PerformanceInfo;
+class MemoryInfo;
 class SoftwareInfoTopic;
 template<typename T> class EnumSetting;
 
@@ -88,6 +95,7 @@ public:
 	[[nodiscard]] DiskManipulator& getDiskManipulator() { return *diskManipulator; }
 	[[nodiscard]] EnumSetting<int>& getMachineSetting() { return *machineSetting; }
 	[[nodiscard]] FilePool& getFilePool() { return *filePool; }
+	[[nodiscard]] FrameStreamer& getFrameStreamer() { return *frameStreamer; }
 
 	[[nodiscard]] RomDatabase& getSoftwareDatabase();
 
@@ -150,6 +158,7 @@ private:
 	std::unique_ptr<DiskManipulator> diskManipulator;
 	std::unique_ptr<DiskChanger> virtualDrive;
 	std::unique_ptr<FilePool> filePool;
+	std::unique_ptr<ListDirCommand> listDirCommand;
 
 	std::unique_ptr<EnumSetting<int>> machineSetting;
 	std::unique_ptr<UserSettings> userSettings;
@@ -166,12 +175,18 @@ private:
 	std::unique_ptr<ActivateMachineCommand> activateMachineCommand;
 	std::unique_ptr<StoreMachineCommand> storeMachineCommand;
 	std::unique_ptr<RestoreMachineCommand> restoreMachineCommand;
+	std::unique_ptr<CloneMachineCommand> cloneMachineCommand;
+	std::unique_ptr<QuickSlotCommand> quickSlotCommand;
+	std::unique_ptr<RunMachinesCommand> runMachinesCommand;
 	std::unique_ptr<GetClipboardCommand> getClipboardCommand;
 	std::unique_ptr<SetClipboardCommand> setClipboardCommand;
 	std::unique_ptr<AviRecorder> aviRecordCommand;
+	std::unique_ptr<FrameStreamer> frameStreamer;
 	std::unique_ptr<ConfigInfo> extensionInfo;
 	std::unique_ptr<ConfigInfo> machineInfo;
 	std::unique_ptr<RealTimeInfo> realTimeInfo;
+	std::unique_ptr<PerformanceInfo> performanceInfo;
+	std::unique_ptr<MemoryInfo> memoryInfo;
 	std::unique_ptr<SoftwareInfoTopic> softwareInfoTopic;
 	std::unique_ptr<TclCallbackMessages> tclCallbackMessages;
 
@@ -205,6 +220,9 @@ private:
 	friend class ActivateMachineCommand;
 	friend class StoreMachineCommand;
 	friend class RestoreMachineCommand;
+	friend class CloneMachineCommand;
+	friend class RunMachinesCommand;
+	friend class MemoryInfo;
 };
 
 } // namespace openmsx
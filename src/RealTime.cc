@@ -6,9 +6,14 @@
 #include "GlobalSettings.hh"
 #include "MSXMotherBoard.hh"
 #include "Reactor.hh"
+#include "InputEventGenerator.hh"
 #include "BooleanSetting.hh"
+#include "Display.hh"
 #include "ThrottleManager.hh"
+#include "TclObject.hh"
+#include "outer.hh"
 #include "unreachable.hh"
+#include <algorithm>
 
 namespace openmsx {
 
@@ -16,6 +21,24 @@ const double   SYNC_INTERVAL = 0.08;  // s
 const int64_t  MAX_LAG       = 200000; // us
 const uint64_t ALLOWED_LAG   =  20000; // us
 
+// Frame pacing: aim to have the frame ready this long before the host
+// vertical retrace, and never change the speed by more than 0.5%.
+const int64_t  PACING_MARGIN    = 1000; // us
+const double   PACING_GAIN      = 0.05;
+const double   MAX_PACE_ADJUST  = 0.005;
+// The achieved emulation speed is measured over (at least) this period (us).
+const uint64_t SPEED_INTERVAL = 500000;
+
+// The busy-wait at the end of a sleep is twice the average lateness of the OS
+// wake-ups plus this extra (us), but never longer than MAX_SPIN (us).
+const double   SPIN_EXTRA = 50.0;
+const double   MAX_SPIN   = 2000.0;
+
+// After this many frames where the flush didn't block, we assume the swap
+// isn't synchronized with the retrace (vsync off or a VRR display). Then
+// there's nothing to align with.
+const unsigned MAX_NON_BLOCKING = 64;
+
 RealTime::RealTime(
 		MSXMotherBoard& motherBoard_, GlobalSettings& globalSettings,
 		EventDelay& eventDelay_)
@@ -27,6 +50,9 @@ RealTime::RealTime(
 	, throttleManager(globalSettings.getThrottleManager())
 	, pauseSetting   (globalSettings.getPauseSetting())
 	, powerSetting   (globalSettings.getPowerSetting())
+	, framePacingSetting(globalSettings.getFramePacingSetting())
+	, wakeupInfo(motherBoard.getMachineInfoCommand())
+	, speedInfo(motherBoard.getMachineInfoCommand())
 	, emuTime(EmuTime::zero())
 	, enabled(true)
 {
@@ -34,6 +60,7 @@ RealTime::RealTime(
 	throttleManager.attach(*this);
 	pauseSetting.attach(*this);
 	powerSetting.attach(*this);
+	framePacingSetting.attach(*this);
 
 	resync();
 
@@ -46,6 +73,7 @@ RealTime::~RealTime()
 	eventDistributor.unregisterEventListener(EventType::FRAME_DRAWN,  *this);
 	eventDistributor.unregisterEventListener(EventType::FINISH_FRAME, *this);
 
+	framePacingSetting.detach(*this);
 	powerSetting.detach(*this);
 	pauseSetting.detach(*this);
 	throttleManager.detach(*this);
@@ -54,12 +82,12 @@ RealTime::~RealTime()
 
 double RealTime::getRealDuration(EmuTime::param time1, EmuTime::param time2)
 {
-	return (time2 - time1).toDouble() / speedManager.getSpeed();
+	return (time2 - time1).toDouble() * (1.0 + paceAdjust) / speedManager.getSpeed();
 }
 
 EmuDuration RealTime::getEmuDuration(double realDur)
 {
-	return EmuDuration(realDur * speedManager.getSpeed());
+	return EmuDuration(realDur * speedManager.getSpeed() / (1.0 + paceAdjust));
 }
 
 bool RealTime::timeLeft(uint64_t us, EmuTime::param time)
@@ -92,15 +120,14 @@ void RealTime::internalSync(EmuTime::param time, bool allowSleep)
 		int64_t sleep = idealRealTime - currentRealTime;
 		if (allowSleep) {
 			// want to sleep for 'sleep' us
-			sleep += static_cast<int64_t>(sleepAdjust);
-			int64_t delta = 0;
 			if (sleep > 0) {
-				Timer::sleep(sleep); // request to sleep for 'sleep+sleepAdjust'
-				int64_t slept = Timer::getTime() - currentRealTime;
-				delta = sleep - slept; // actually slept for 'slept' us
+				preciseSleep(currentRealTime + sleep);
+				if (eventDelay.isLowLatency()) {
+					// Don't let the events that arrived while
+					// we slept wait till the next frame.
+					motherBoard.getReactor().getInputEventGenerator().poll();
+				}
 			}
-			const double ALPHA = 0.2;
-			sleepAdjust = sleepAdjust * (1 - ALPHA) + delta * ALPHA;
 		}
 		if (-sleep > MAX_LAG) {
 			idealRealTime = currentRealTime - MAX_LAG / 2;
@@ -110,9 +137,34 @@ void RealTime::internalSync(EmuTime::param time, bool allowSleep)
 		eventDelay.sync(time);
 	}
 
+	auto now = Timer::getTime();
+	if ((now - speedRealStart) >= SPEED_INTERVAL) {
+		measuredSpeed = (time - speedEmuStart).toDouble() /
+		                (double(now - speedRealStart) / 1000000.0);
+		speedRealStart = now;
+		speedEmuStart = time;
+	}
+
 	emuTime = time;
 }
 
+void RealTime::preciseSleep(uint64_t target)
+{
+	// Let the OS wake us up a bit early and busy-wait for the rest. The
+	// length of that busy-wait is calibrated on the measured lateness of
+	// the OS wake-ups: enough to (nearly) always wake up in time, but not
+	// more, to not waste CPU time (battery).
+	auto spin = static_cast<uint64_t>(std::clamp(2.0 * osLateness + SPIN_EXTRA, 0.0, MAX_SPIN));
+	auto woken = Timer::sleepUntil(target, spin);
+	auto now = Timer::getTime();
+	wakeupError.add(uint32_t(std::min<uint64_t>(now - target, 0xFFFFFFFF)));
+
+	auto late = int64_t(woken) - int64_t(target - std::min(spin, target));
+	const double ALPHA = 0.1;
+	osLateness = osLateness * (1 - ALPHA) + double(std::max<int64_t>(late, 0)) * ALPHA;
+	spinDuration = spin;
+}
+
 void RealTime::executeUntil(EmuTime::param time)
 {
 	internalSync(time, true);
@@ -135,6 +187,7 @@ int RealTime::signalEvent(const Event& event) noexcept
 		},
 		[&](const FrameDrawnEvent&) {
 			// sync and possibly sleep
+			updateFramePacing();
 			sync(getCurrentTime(), true);
 		},
 		[&](const EventBase /*e*/) {
@@ -144,6 +197,40 @@ int RealTime::signalEvent(const Event& event) noexcept
 	return 0;
 }
 
+void RealTime::updateFramePacing()
+{
+	auto now = Timer::getTime();
+	auto frameDuration = now - prevFrameDrawn; // us
+	prevFrameDrawn = now;
+
+	if (!framePacingSetting.getBoolean() || !throttleManager.isThrottled()) {
+		paceAdjust = 0.0;
+		return;
+	}
+	// With vsync the flush of the frame that was just drawn blocks till the host
+	// vertical retrace. If it waited long, the frame was ready too early,
+	// so slow down a tiny bit to shift the MSX frame end closer to the
+	// retrace. If it (almost) didn't wait, we're close to missing the
+	// retrace, so speed up a tiny bit. When the MSX frame rate is close
+	// to (a divisor of) the host refresh rate, this locks both together:
+	// no more judder, and the frame is shown as soon as it's ready.
+	auto wait = int64_t(motherBoard.getReactor().getDisplay().getPresentWait());
+	if (wait < (PACING_MARGIN / 4)) {
+		if (++nonBlockingFrames >= MAX_NON_BLOCKING) {
+			nonBlockingFrames = MAX_NON_BLOCKING;
+			paceAdjust = 0.0;
+			return;
+		}
+	} else {
+		nonBlockingFrames = 0;
+	}
+	if ((frameDuration == 0) || (frameDuration > 100000)) {
+		return; // not a regular frame (e.g. after a pause)
+	}
+	double error = double(wait - PACING_MARGIN) / double(frameDuration);
+	paceAdjust = std::clamp(PACING_GAIN * error, -MAX_PACE_ADJUST, MAX_PACE_ADJUST);
+}
+
 void RealTime::update(const Setting& /*setting*/) noexcept
 {
 	resync();
@@ -164,7 +251,8 @@ void RealTime::resync()
 	if (!enabled) return;
 
 	idealRealTime = Timer::getTime();
-	sleepAdjust = 0.0;
+	speedRealStart = idealRealTime;
+	speedEmuStart = getCurrentTime();
 	removeSyncPoint();
 	emuTime = getCurrentTime();
 	setSyncPoint(emuTime + getEmuDuration(SYNC_INTERVAL));
@@ -182,4 +270,66 @@ void RealTime::disable()
 	removeSyncPoint();
 }
 
+
+
+// class WakeupInfo
+
+RealTime::WakeupInfo::WakeupInfo(InfoCommand& machineInfoCommand)
+	: InfoTopic(machineInfoCommand, "realtime_wakeup")
+{
+}
+
+void RealTime::WakeupInfo::execute(
+	span<const TclObject> /*tokens*/, TclObject& result) const
+{
+	const auto& rt = OUTER(RealTime, wakeupInfo);
+	const auto& histogram = rt.wakeupError;
+	auto count = histogram.getCount();
+	result.addDictKeyValues(
+		"count", int64_t(count),
+		"min", int64_t(histogram.getMin()),
+		"max", int64_t(histogram.getMax()),
+		"average", count ? int64_t(histogram.getSum() / count) : int64_t(0),
+		"spin", int64_t(rt.spinDuration));
+	const auto& buckets = histogram.getBuckets();
+	size_t num = buckets.size();
+	while ((num > 0) && (buckets[num - 1] == 0)) --num;
+	TclObject list;
+	for (size_t i = 0; i < num; ++i) {
+		list.addListElement(int64_t(buckets[i]));
+	}
+	result.addDictKeyValue("buckets", list);
+}
+
+std::string RealTime::WakeupInfo::help(span<const TclObject> /*tokens*/) const
+{
+	return "Returns a dict with statistics about how late (in microseconds)\n"
+	       "openMSX woke up after sleeping to stay in sync with real time:\n"
+	       "'count', 'min', 'max', 'average' and a histogram 'buckets',\n"
+	       "where bucket 0 counts the value 0 and bucket n counts the values\n"
+	       "in [2^(n-1), 2^n). 'spin' is the current length of the busy-wait\n"
+	       "at the end of each sleep.\n";
+}
+
+
+// class SpeedInfo
+
+RealTime::SpeedInfo::SpeedInfo(InfoCommand& machineInfoCommand)
+	: InfoTopic(machineInfoCommand, "emulation_speed")
+{
+}
+
+void RealTime::SpeedInfo::execute(
+	span<const TclObject> /*tokens*/, TclObject& result) const
+{
+	result = OUTER(RealTime, speedInfo).measuredSpeed;
+}
+
+std::string RealTime::SpeedInfo::help(span<const TclObject> /*tokens*/) const
+{
+	return "Returns the measured emulation speed, as a multiple of the speed\n"
+	       "of a real MSX (e.g. 1.0 when throttled at normal speed, much\n"
+	       "higher when fast forwarding).\n";
+}
+
 } // namespace openmsx
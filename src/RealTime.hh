@@ -5,6 +5,8 @@
 #include "EventListener.hh"
 #include "Observer.hh"
 #include "EmuTime.hh"
+#include "InfoTopic.hh"
+#include "LatencyHistogram.hh"
 #include <cstdint>
 
 namespace openmsx {
@@ -71,6 +73,8 @@ private:
 	void update(const ThrottleManager& throttleManager) noexcept override;
 
 	void internalSync(EmuTime::param time, bool allowSleep);
+	void updateFramePacing();
+	void preciseSleep(uint64_t target);
 
 	MSXMotherBoard& motherBoard;
 	EventDistributor& eventDistributor;
@@ -79,10 +83,33 @@ private:
 	ThrottleManager& throttleManager;
 	BooleanSetting& pauseSetting;
 	BooleanSetting& powerSetting;
+	BooleanSetting& framePacingSetting;
+
+	struct WakeupInfo final : InfoTopic {
+		explicit WakeupInfo(InfoCommand& machineInfoCommand);
+		void execute(span<const TclObject> tokens,
+		             TclObject& result) const override;
+		[[nodiscard]] std::string help(span<const TclObject> tokens) const override;
+	} wakeupInfo;
+
+	struct SpeedInfo final : InfoTopic {
+		explicit SpeedInfo(InfoCommand& machineInfoCommand);
+		void execute(span<const TclObject> tokens,
+		             TclObject& result) const override;
+		[[nodiscard]] std::string help(span<const TclObject> tokens) const override;
+	} speedInfo;
 
 	uint64_t idealRealTime;
 	EmuTime emuTime;
-	double sleepAdjust;
+	LatencyHistogram wakeupError; // us
+	double osLateness = 0.0; // average, us
+	uint64_t spinDuration = 0; // us
+	uint64_t speedRealStart = 0;
+	EmuTime speedEmuStart = EmuTime::zero();
+	double measuredSpeed = 0.0;
+	double paceAdjust = 0.0; // relative adjustment of the real duration
+	uint64_t prevFrameDrawn = 0;
+	unsigned nonBlockingFrames = 0;
 	bool enabled;
 };
 
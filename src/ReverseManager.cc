@@ -1,8 +1,12 @@
 #include "ReverseManager.hh"
 #include "Event.hh"
 #include "MSXMotherBoard.hh"
+#include "InstructionIndex.hh"
+#include "MSXCPU.hh"
+#include "MSXCPUInterface.hh"
 #include "EventDistributor.hh"
 #include "StateChangeDistributor.hh"
+#include "StateChangeCodec.hh"
 #include "Keyboard.hh"
 #include "Debugger.hh"
 #include "EventDelay.hh"
@@ -18,6 +22,9 @@
 #include "CliComm.hh"
 #include "Display.hh"
 #include "Reactor.hh"
+#include "GlobalSettings.hh"
+#include "RecordedCommand.hh"
+#include "RTSchedulable.hh"
 #include "CommandException.hh"
 #include "MemBuffer.hh"
 #include "one_of.hh"
@@ -25,8 +32,11 @@
 #include "serialize.hh"
 #include "serialize_meta.hh"
 #include "view.hh"
+#include "xrange.hh"
 #include <cassert>
 #include <cmath>
+#include <cstring>
+#include <functional>
 #include <iomanip>
 
 namespace openmsx {
@@ -45,6 +55,18 @@ constexpr auto MAX_DIST_1_BEFORE_LAST_SNAPSHOT = EmuDuration(30.0);
 
 constexpr const char* const REPLAY_DIR = "replays";
 
+// Memory budget for the reverse history when the 'low_memory' setting is
+// enabled and 'reverse_memory_budget' is 0 (in bytes)
+constexpr size_t LOW_MEMORY_BUDGET = size_t(16) << 20;
+
+// After a 'reverse goto', missing snapshots within this distance of the new
+// position are filled in in the background (makes scrubbing faster). This is
+// done in slices of emulated time, one slice every SPECULATION_INTERVAL
+// microseconds (real time).
+constexpr auto SPECULATION_WINDOW = EmuDuration(10.0);
+constexpr auto SPECULATION_SLICE = EmuDuration(0.02);
+constexpr uint64_t SPECULATION_INTERVAL = 10000;
+
 // A replay is a struct that contains a vector of motherboards and an MSX event
 // log. Those combined are a replay, because you can replay the events from an
 // existing motherboard state: the vector has to have at least one motherboard
@@ -60,7 +82,11 @@ struct Replay
 	Reactor& reactor;
 
 	ReverseManager::Events* events;
-	std::vector<Reactor::Board> motherBoards;
+	std::vector<Reactor::Board> motherBoards; // only used for loading
+	// Only used for saving: instead of having all snapshots in memory at
+	// once (as motherboards), restore them one by one while writing.
+	std::function<Reactor::Board(unsigned)> restoreSnapshot;
+	unsigned numSnapshots = 0;
 	EmuTime currentTime;
 	// this is the amount of times the reverse goto command was used, which
 	// is interesting for the TAS community (see tasvideos.org). It's an
@@ -71,7 +97,16 @@ struct Replay
 	template<typename Archive>
 	void serialize(Archive& ar, unsigned version)
 	{
-		if (ar.versionAtLeast(version, 2)) {
+		if constexpr (!Archive::IS_LOADER) {
+			// same format as 'serializeWithID("snapshots", motherBoards)'
+			ar.beginTag("snapshots");
+			for (auto i : xrange(numSnapshots)) {
+				auto board = restoreSnapshot(i);
+				ar.serializeWithID("item", board);
+				ar.forgetIds(); // 'board' gets destroyed
+			}
+			ar.endTag("snapshots");
+		} else if (ar.versionAtLeast(version, 2)) {
 			ar.serializeWithID("snapshots", motherBoards, std::ref(reactor));
 		} else {
 			Reactor::Board newBoard = reactor.createEmptyMotherBoard();
@@ -79,7 +114,11 @@ struct Replay
 			motherBoards.push_back(std::move(newBoard));
 		}
 
-		ar.serialize("events", *events);
+		if (ar.versionAtLeast(version, 5)) {
+			serializeEvents(ar);
+		} else {
+			ar.serialize("events", *events);
+		}
 
 		if (ar.versionAtLeast(version, 3)) {
 			ar.serialize("currentTime", currentTime);
@@ -93,8 +132,74 @@ struct Replay
 			ar.serialize("reRecordCount", reRecordCount);
 		}
 	}
+
+	// The frequent input device events are stored in a compact
+	// binary blob, only the others are serialized polymorphically.
+	template<typename Archive>
+	void serializeEvents(Archive& ar)
+	{
+		if constexpr (!Archive::IS_LOADER) {
+			std::vector<uint8_t> data;
+			std::vector<StateChange*> others;
+			StateChangeCodec::encode(*events, data, others);
+			ar.serialize("events", others);
+			auto size = uint32_t(data.size());
+			ar.serialize("compactEventsSize", size);
+			ar.serialize_blob("compactEvents", data.data(), data.size());
+		} else {
+			ReverseManager::Events others;
+			ar.serialize("events", others);
+			uint32_t size = 0;
+			ar.serialize("compactEventsSize", size);
+			std::vector<uint8_t> data(size);
+			ar.serialize_blob("compactEvents", data.data(), data.size());
+			*events = StateChangeCodec::decode(data, others);
+		}
+	}
 };
-SERIALIZE_CLASS_VERSION(Replay, 4);
+// version 5: compact encoding for the frequent events, see StateChangeCodec
+SERIALIZE_CLASS_VERSION(Replay, 5);
+
+
+// struct ReverseManager::Speculation
+
+struct ReverseManager::Speculation final : RTSchedulable
+{
+	explicit Speculation(RTScheduler& rtScheduler) : RTSchedulable(rtScheduler) {}
+	void executeRT() override;
+
+	Reactor::Board board; // restored from a snapshot
+	std::vector<EmuTime> targets; // times of the missing snapshots
+	size_t nextTarget = 0;
+	unsigned startEventCount;
+	std::vector<ReverseChunk> chunks; // result
+	LastDeltaBlocks lastDeltaBlocks;
+};
+
+void ReverseManager::Speculation::executeRT()
+{
+	auto& rm = board->getReverseManager();
+	try {
+		auto target = targets[nextTarget];
+		board->fastForward(std::min(target,
+			board->getCurrentTime() + SPECULATION_SLICE), true);
+		if (board->getCurrentTime() >= target) {
+			ReverseChunk& newChunk = chunks.emplace_back();
+			MemOutputArchive out(lastDeltaBlocks, newChunk.deltaBlocks, true);
+			out.serialize("machine", *board);
+			newChunk.time = board->getCurrentTime();
+			newChunk.savestate = out.releaseBuffer(newChunk.size);
+			newChunk.eventCount = startEventCount + rm.replayIndex;
+			++nextTarget;
+		}
+	} catch (MSXException&) {
+		// stop, the snapshots taken so far are still fine
+		nextTarget = targets.size();
+	}
+	if (nextTarget < targets.size()) {
+		scheduleRT(SPECULATION_INTERVAL);
+	}
+}
 
 
 // struct ReverseHistory
@@ -178,6 +283,7 @@ void ReverseManager::start()
 void ReverseManager::stop()
 {
 	if (isCollecting()) {
+		finishSpeculation(false);
 		motherBoard.getStateChangeDistributor().unregisterRecorder(*this);
 		syncNewSnapshot.removeSyncPoint(); // don't schedule new snapshot takings
 		syncInputEvent .removeSyncPoint(); // stop any pending replay actions
@@ -227,6 +333,9 @@ void ReverseManager::status(TclObject& result) const
 	}));
 	result.addDictKeyValue("snapshots", snapshots);
 
+	result.addDictKeyValue("memory", double(history.getMemoryUsage()));
+	result.addDictKeyValue("memory_budget", double(getMemoryBudget()));
+
 	auto lastEvent = rbegin(history.events);
 	if (lastEvent != rend(history.events) && dynamic_cast<const EndLogEvent*>(lastEvent->get())) {
 		++lastEvent;
@@ -292,14 +401,14 @@ void ReverseManager::goTo(span<const TclObject> tokens)
 	goTo(target, novideo);
 }
 
-void ReverseManager::goTo(EmuTime::param target, bool novideo)
+MSXMotherBoard& ReverseManager::goTo(EmuTime::param target, bool novideo)
 {
 	if (!isCollecting()) {
 		throw CommandException(
 			"Reverse was not enabled. First execute the 'reverse "
 			"start' command to start collecting data.");
 	}
-	goTo(target, novideo, history, true); // move in current time-line
+	return goTo(target, novideo, history, true); // move in current time-line
 }
 
 // this function is used below, but factored out, because it's already way too long
@@ -316,7 +425,7 @@ static void reportProgress(Reactor& reactor, const EmuTime& targetTime, int perc
 	reactor.getDisplay().repaint();
 }
 
-void ReverseManager::goTo(
+MSXMotherBoard& ReverseManager::goTo(
 	EmuTime::param target, bool novideo, ReverseHistory& hist,
 	bool sameTimeLine)
 {
@@ -331,6 +440,10 @@ void ReverseManager::goTo(
 		// already mute the current MSXMotherBoard.
 		mixer.mute();
 
+		// Snapshots from a previous speculation are still valid in the
+		// current time-line, and may be closer to the target.
+		finishSpeculation(sameTimeLine);
+
 		// -- Locate destination snapshot --
 		// We can't go back further in the past than the first snapshot.
 		assert(!hist.chunks.empty());
@@ -379,6 +492,7 @@ void ReverseManager::goTo(
 		EmuTime currentTime = getCurrentTime();
 		MSXMotherBoard* newBoard;
 		Reactor::Board newBoard_; // either nullptr or the same as newBoard
+		InstructionIndex instructionIndex; // only used for a new board
 		if (sameTimeLine &&
 		    (currentTime <= preTarget) &&
 		    ((snapshotTime <= currentTime) ||
@@ -416,6 +530,13 @@ void ReverseManager::goTo(
 
 			// transfer (or copy) state from old to new machine
 			transferState(*newBoard);
+			// The recently executed instructions are still valid in
+			// the new board (up to the target time). But only hand
+			// them over after fast-forwarding, that would record
+			// older instructions.
+			if (sameTimeLine) {
+				instructionIndex = std::move(motherBoard.getCPU().getInstructionIndex());
+			}
 
 			// In case of load-replay it's possible we are not collecting,
 			// but calling stop() anyway is ok.
@@ -480,6 +601,10 @@ void ReverseManager::goTo(
 		// This makes sure the video output gets rendered.
 		newBoard->fastForward(targetTime, false);
 
+		auto& newIndex = newBoard->getCPU().getInstructionIndex();
+		if (!unmute) newIndex = std::move(instructionIndex); // new board
+		newIndex.truncate(newBoard->getCurrentTime());
+
 		// In case we didn't actually create a new board, don't leave
 		// the (old) board muted.
 		if (unmute) {
@@ -487,7 +612,10 @@ void ReverseManager::goTo(
 		}
 
 		//assert(!isCollecting()); // can't access 'this->' members anymore!
-		assert(newBoard->getReverseManager().isCollecting());
+		auto& newManager = newBoard->getReverseManager();
+		assert(newManager.isCollecting());
+		newManager.startSpeculation(newBoard->getCurrentTime());
+		return *newBoard;
 	} catch (MSXException&) {
 		// Make sure mixer doesn't stay muted in case of error.
 		mixer.unmute();
@@ -495,6 +623,104 @@ void ReverseManager::goTo(
 	}
 }
 
+/* Scrubbing (many 'reverse goto' commands in a short time) is only fast when
+ * there are snapshots close to the target times. Far from the current time
+ * most snapshots have been dropped (see dropOldSnapshots()). So after a goTo(),
+ * restore the last snapshot before the gap into a separate board and emulate
+ * that forward, taking the missing snapshots along the way. The emulation core
+ * is main-thread only, so this happens in small slices from the main loop
+ * (see Speculation::executeRT()). The next goTo() collects the snapshots taken
+ * so far and drops the rest of the work.
+ *
+ * Debugger hooks (breakpoints, conditions) would also trigger in this hidden
+ * board, so then there's no speculation. The check is only done at the start.
+ */
+void ReverseManager::startSpeculation(EmuTime::param time)
+{
+	assert(!speculation);
+	if (!isCollecting() ||
+	    MSXCPUInterface::anyBreakPoints() ||
+	    !MSXCPUInterface::getConditions().empty()) {
+		return;
+	}
+
+	// find snapshot slots without snapshot in the window around 'time'
+	assert(!history.chunks.empty());
+	auto firstTime = begin(history.chunks)->second.time;
+	auto windowStart = ((time - firstTime) > SPECULATION_WINDOW)
+	                 ? time - SPECULATION_WINDOW : firstTime;
+	auto windowEnd = std::min(time + SPECULATION_WINDOW, getEndTime(history));
+	std::vector<EmuTime> targets;
+	for (auto seqNum : xrange(history.getNextSeqNum(windowStart),
+	                          history.getNextSeqNum(windowEnd) + 1)) {
+		auto t = firstTime + EmuDuration(seqNum * SNAPSHOT_PERIOD);
+		if ((t <= firstTime) || (t >= windowEnd)) continue;
+		if (history.chunks.find(seqNum) == end(history.chunks)) {
+			targets.push_back(t);
+		}
+	}
+	if (targets.empty()) return;
+
+	// start from the last snapshot before the first gap
+	auto it = ranges::find_if(history.chunks, [&](auto& p) {
+		return p.second.time > targets.front();
+	});
+	assert(it != begin(history.chunks));
+	const auto& chunk = std::prev(it)->second;
+
+	// copy the events up to the last target (via serialization, the
+	// history keeps owning the originals)
+	std::vector<StateChange*> toCopy;
+	for (auto i : xrange(size_t(chunk.eventCount), history.events.size())) {
+		auto* event = history.events[i].get();
+		if ((event->getTime() > targets.back()) ||
+		    dynamic_cast<const EndLogEvent*>(event)) {
+			break;
+		}
+		if (dynamic_cast<const MSXCommandEvent*>(event)) {
+			return; // replaying Tcl commands could affect the real board
+		}
+		toCopy.push_back(event);
+	}
+	Events events;
+	{
+		LastDeltaBlocks lastDeltaBlocks;
+		std::vector<std::shared_ptr<DeltaBlock>> deltaBlocks;
+		MemOutputArchive out(lastDeltaBlocks, deltaBlocks, false);
+		out.serialize("events", toCopy);
+		size_t size;
+		auto buf = out.releaseBuffer(size);
+		MemInputArchive in(buf.data(), size, deltaBlocks);
+		in.serialize("events", events);
+	}
+
+	auto spec = std::make_unique<Speculation>(
+		motherBoard.getReactor().getRTScheduler());
+	spec->board = motherBoard.getReactor().createEmptyMotherBoard();
+	MemInputArchive in(chunk.savestate.data(), chunk.size, chunk.deltaBlocks);
+	in.serialize("machine", *spec->board);
+	spec->board->getReverseManager().startSegmentReplay(std::move(events));
+	spec->targets = std::move(targets);
+	spec->startEventCount = chunk.eventCount;
+
+	spec->scheduleRT(SPECULATION_INTERVAL);
+	speculation = std::move(spec);
+}
+
+void ReverseManager::finishSpeculation(bool keepResults)
+{
+	if (!speculation) return;
+	if (keepResults) {
+		for (auto& chunk : speculation->chunks) {
+			// never replace an existing snapshot
+			history.chunks.try_emplace(history.getNextSeqNum(chunk.time),
+			                           std::move(chunk));
+		}
+	}
+	speculation->board->getReverseManager().stopSegmentReplay();
+	speculation.reset(); // deletes the board
+}
+
 void ReverseManager::transferState(MSXMotherBoard& newBoard)
 {
 	// Transfer viewonly mode
@@ -529,7 +755,11 @@ void ReverseManager::saveReplay(
 
 	std::string_view filenameArg;
 	int maxNofExtraSnapshots = MAX_NOF_SNAPSHOTS;
-	ArgsInfo info[] = { valueArg("-maxnofextrasnapshots", maxNofExtraSnapshots) };
+	double snapshotInterval = 0.0;
+	ArgsInfo info[] = {
+		valueArg("-maxnofextrasnapshots", maxNofExtraSnapshots),
+		valueArg("-snapshotinterval", snapshotInterval),
+	};
 	auto args = parseTclArgs(interp, tokens.subspan(2), info);
 	switch (args.size()) {
 		case 0: break; // nothing
@@ -539,6 +769,9 @@ void ReverseManager::saveReplay(
 	if (maxNofExtraSnapshots < 0) {
 		throw CommandException("Maximum number of snapshots should be at least 0");
 	}
+	if (snapshotInterval < 0.0) {
+		throw CommandException("Snapshot interval should be positive");
+	}
 
 	auto filename = FileOperations::parseCommandFileArgument(
 		filenameArg, REPLAY_DIR, "openmsx", ".omr");
@@ -551,15 +784,29 @@ void ReverseManager::saveReplay(
 	// so that on load we can go back there
 	replay.currentTime = getCurrentTime();
 
-	// restore first snapshot to be able to serialize it to a file
-	auto initialBoard = reactor.createEmptyMotherBoard();
-	MemInputArchive in(begin(chunks)->second.savestate.data(),
-	                   begin(chunks)->second.size,
-			   begin(chunks)->second.deltaBlocks);
-	in.serialize("machine", *initialBoard);
-	replay.motherBoards.push_back(std::move(initialBoard));
-
-	if (maxNofExtraSnapshots > 0) {
+	// The first snapshot is always stored, the others are extra
+	// snapshots to make seeking faster after loading the replay. These
+	// are only restored (one at a time) while writing the file.
+	std::vector<const ReverseChunk*> snapshots;
+	snapshots.push_back(&begin(chunks)->second);
+	if (snapshotInterval > 0.0) {
+		// Put snapshots at (roughly) fixed intervals in the replay.
+		// On load these become key frames (see ReverseChunk), this
+		// bounds the seek time, independent of the replay length. We
+		// can only store snapshots that are still in the history, so
+		// for older parts of the history the actual interval can be
+		// larger.
+		EmuDuration interval(snapshotInterval);
+		auto lastAddedIt = begin(chunks); // already added
+		for (auto it = std::next(begin(chunks)); it != end(chunks); ++it) {
+			auto next = std::next(it);
+			bool isLast = next == end(chunks);
+			if (isLast || ((next->second.time - lastAddedIt->second.time) > interval)) {
+				snapshots.push_back(&it->second);
+				lastAddedIt = it;
+			}
+		}
+	} else if (maxNofExtraSnapshots > 0) {
 		// determine which extra snapshots to put in the replay
 		const auto& startTime = begin(chunks)->second.time;
 		// for the end time, try to take MAX_DIST_1_BEFORE_LAST_SNAPSHOT
@@ -581,12 +828,7 @@ void ReverseManager::saveReplay(
 				assert(it->second.time <= nextPartitionEnd);
 				if (it != lastAddedIt) {
 					// this is a new one, add it to the list of snapshots
-					Reactor::Board board = reactor.createEmptyMotherBoard();
-					MemInputArchive in2(it->second.savestate.data(),
-							    it->second.size,
-							    it->second.deltaBlocks);
-					in2.serialize("machine", *board);
-					replay.motherBoards.push_back(std::move(board));
+					snapshots.push_back(&it->second);
 					lastAddedIt = it;
 				}
 				++it;
@@ -606,6 +848,15 @@ void ReverseManager::saveReplay(
 		history.events.push_back(std::make_unique<EndLogEvent>(
 			getCurrentTime()));
 	}
+	replay.numSnapshots = unsigned(snapshots.size());
+	replay.restoreSnapshot = [&](unsigned i) {
+		auto board = reactor.createEmptyMotherBoard();
+		const auto& chunk = *snapshots[i];
+		MemInputArchive in(chunk.savestate.data(), chunk.size,
+		                   chunk.deltaBlocks);
+		in.serialize("machine", *board);
+		return board;
+	};
 	try {
 		XmlOutputArchive out(filename);
 		replay.events = &history.events;
@@ -629,42 +880,27 @@ void ReverseManager::saveReplay(
 	result = tmpStrCat("Saved replay to ", filename);
 }
 
-void ReverseManager::loadReplay(
-	Interpreter& interp, span<const TclObject> tokens, TclObject& result)
+static std::string resolveReplayFilename(std::string_view fileNameArg)
 {
-	bool enableViewOnly = false;
-	std::optional<TclObject> where;
-	ArgsInfo info[] = {
-		flagArg("-viewonly", enableViewOnly),
-		valueArg("-goto", where),
-	};
-	auto arguments = parseTclArgs(interp, tokens.subspan(2), info);
-	if (arguments.size() != 1) throw SyntaxError();
-
-	// resolve the filename
 	auto context = userDataFileContext(REPLAY_DIR);
-	std::string fileNameArg(arguments[0].getString());
-	std::string filename;
 	try {
 		// Try filename as typed by user.
-		filename = context.resolve(fileNameArg);
+		return context.resolve(fileNameArg);
 	} catch (MSXException& /*e1*/) { try {
 		// Not found, try adding '.omr'.
-		filename = context.resolve(tmpStrCat(fileNameArg, ".omr"));
+		return context.resolve(tmpStrCat(fileNameArg, ".omr"));
 	} catch (MSXException& e2) { try {
 		// Again not found, try adding '.gz'.
 		// (this is for backwards compatibility).
-		filename = context.resolve(tmpStrCat(fileNameArg, ".gz"));
+		return context.resolve(tmpStrCat(fileNameArg, ".gz"));
 	} catch (MSXException& /*e3*/) {
 		// Show error message that includes the default extension.
 		throw e2;
 	}}}
+}
 
-	// restore replay
-	auto& reactor = motherBoard.getReactor();
-	Replay replay(reactor);
-	Events events;
-	replay.events = &events;
+static void readReplay(const std::string& filename, Replay& replay)
+{
 	try {
 		XmlInputArchive in(filename);
 		in.serialize("replay", replay);
@@ -674,6 +910,27 @@ void ReverseManager::loadReplay(
 	} catch (MSXException& e) {
 		throw CommandException("Cannot load replay: ", e.getMessage());
 	}
+}
+
+void ReverseManager::loadReplay(
+	Interpreter& interp, span<const TclObject> tokens, TclObject& result)
+{
+	bool enableViewOnly = false;
+	std::optional<TclObject> where;
+	ArgsInfo info[] = {
+		flagArg("-viewonly", enableViewOnly),
+		valueArg("-goto", where),
+	};
+	auto arguments = parseTclArgs(interp, tokens.subspan(2), info);
+	if (arguments.size() != 1) throw SyntaxError();
+
+	// restore replay
+	auto filename = resolveReplayFilename(arguments[0].getString());
+	auto& reactor = motherBoard.getReactor();
+	Replay replay(reactor);
+	Events events;
+	replay.events = &events;
+	readReplay(filename, replay);
 
 	// get destination time index
 	auto destination = EmuTime::zero();
@@ -718,6 +975,13 @@ void ReverseManager::loadReplay(
 		                     newChunk.deltaBlocks, false);
 		out.serialize("machine", *m);
 		newChunk.savestate = out.releaseBuffer(newChunk.size);
+		newChunk.keyFrame = true;
+		if (&m != &replay.motherBoards.front()) {
+			// No longer needed (the first board owns 'newHistory'),
+			// free it already, long replays can contain many
+			// snapshots.
+			m.reset();
+		}
 
 		// update replayIdx
 		// TODO: should we use <= instead??
@@ -740,6 +1004,132 @@ void ReverseManager::loadReplay(
 	result = tmpStrCat("Loaded replay from ", filename);
 }
 
+void ReverseManager::verifyReplay(span<const TclObject> tokens, TclObject& result)
+{
+	if (tokens.size() != 3) throw SyntaxError();
+
+	auto filename = resolveReplayFilename(tokens[2].getString());
+	auto& reactor = motherBoard.getReactor();
+	Replay replay(reactor);
+	Events events;
+	replay.events = &events;
+	readReplay(filename, replay);
+
+	// Each pair of consecutive snapshots forms a segment. Re-emulating the
+	// segment from its first snapshot, with the events in between, should
+	// exactly end up in the second snapshot. The part after the last
+	// snapshot has nothing to compare against.
+	auto& boards = replay.motherBoards;
+	assert(!boards.empty());
+	auto numSegments = boards.size() - 1;
+	if (numSegments == 0) {
+		throw CommandException(
+			"Replay contains only one snapshot, nothing to verify. "
+			"Save it with the -maxnofextrasnapshots option to get "
+			"more snapshots.");
+	}
+
+	// Split the event log at the snapshot times (same boundaries as in
+	// loadReplay()).
+	std::vector<Events> segments(numSegments);
+	auto it = begin(events);
+	for (auto i : xrange(numSegments)) {
+		auto startTime = boards[i    ]->getCurrentTime();
+		auto endTime   = boards[i + 1]->getCurrentTime();
+		while ((it != end(events)) && ((*it)->getTime() < startTime)) ++it;
+		while ((it != end(events)) && ((*it)->getTime() < endTime) &&
+		       !dynamic_cast<const EndLogEvent*>(it->get())) {
+			segments[i].push_back(std::move(*it));
+			++it;
+		}
+	}
+
+	auto getState = [](MSXMotherBoard& board, size_t& size) {
+		BinaryOutputArchive out({}); // not written to a file
+		out.serialize("machine", board);
+		return out.releaseBuffer(size);
+	};
+	enum Status : uint8_t { OK, DIFFERENT_TIME, DIFFERENT_STATE, FAILED };
+	std::vector<Status> status(numSegments, OK);
+	std::vector<std::string> errors(numSegments);
+	auto run = [&](size_t i) {
+		auto& board = *boards[i];
+		auto& rm = board.getReverseManager();
+		auto endTime = boards[i + 1]->getCurrentTime();
+		try {
+			rm.startSegmentReplay(std::move(segments[i]));
+			board.fastForward(endTime, true);
+			rm.stopSegmentReplay();
+			if (board.getCurrentTime() != endTime) {
+				status[i] = DIFFERENT_TIME;
+				return;
+			}
+			size_t size1, size2;
+			auto state1 = getState(board,          size1);
+			auto state2 = getState(*boards[i + 1], size2);
+			if ((size1 != size2) ||
+			    (memcmp(state1.data(), state2.data(), size1) != 0)) {
+				status[i] = DIFFERENT_STATE;
+			}
+		} catch (MSXException& e) {
+			rm.stopSegmentReplay();
+			status[i] = FAILED;
+			errors[i] = e.getMessage();
+		}
+	};
+	// The emulation core can only be used from the main thread, so the
+	// segments are verified one after the other.
+	for (auto i : xrange(numSegments)) run(i);
+
+	auto firstBad = ranges::find_if(status, [](auto s) { return s != OK; });
+	if (firstBad == end(status)) {
+		result = strCat("Verified replay ", filename, ": ", numSegments,
+		                " segment(s) OK");
+		return;
+	}
+	auto i = size_t(firstBad - begin(status));
+	auto from = (boards[i    ]->getCurrentTime() - EmuTime::zero()).toDouble();
+	auto to   = (boards[i + 1]->getCurrentTime() - EmuTime::zero()).toDouble();
+	auto where = strCat("segment ", i + 1, " of ", numSegments,
+	                    " (from ", from, "s to ", to, "s)");
+	switch (*firstBad) {
+	case DIFFERENT_TIME:
+		throw CommandException("Replay diverges in ", where,
+		                       ": emulation didn't stop at the snapshot time");
+	case DIFFERENT_STATE:
+		throw CommandException("Replay diverges in ", where,
+		                       ": machine state differs from the snapshot");
+	default:
+		throw CommandException("Error while verifying ", where, ": ", errors[i]);
+	}
+}
+
+void ReverseManager::startSegmentReplay(Events&& events)
+{
+	// Like transferHistory(), but without collecting: this only replays
+	// the given events, no new snapshots are taken. The sentinel is never
+	// reached, because that would end the replay, and input devices reset
+	// their state on that.
+	assert(!isCollecting());
+	assert(!isReplaying());
+	history.events = std::move(events);
+	history.events.push_back(std::make_unique<EndLogEvent>(EmuTime::infinity()));
+	motherBoard.getStateChangeDistributor().registerRecorder(*this);
+	replayIndex = 0;
+	replayNextEvent();
+}
+
+void ReverseManager::stopSegmentReplay()
+{
+	assert(!isCollecting());
+	if (!isReplaying()) return;
+	motherBoard.getStateChangeDistributor().unregisterRecorder(*this);
+	syncInputEvent.removeSyncPoint();
+	history.clear();
+	replayIndex = 0;
+	assert(!isReplaying());
+}
+
 void ReverseManager::transferHistory(ReverseHistory& oldHistory,
                                      unsigned oldEventCount)
 {
@@ -842,6 +1232,30 @@ unsigned ReverseManager::ReverseHistory::getNextSeqNum(EmuTime::param time) cons
 	return lrint(duration / SNAPSHOT_PERIOD);
 }
 
+size_t ReverseManager::ReverseHistory::getMemoryUsage() const
+{
+	// Delta blocks are shared between snapshots (unchanged blocks, and
+	// the reference block of a diff), each block must be counted once.
+	size_t result = 0;
+	std::vector<const DeltaBlock*> blocks;
+	for (const auto& [idx, chunk] : chunks) {
+		result += chunk.size;
+		for (const auto& b : chunk.deltaBlocks) {
+			if (!b) continue;
+			blocks.push_back(b.get());
+			if (const auto* diff = dynamic_cast<const DeltaBlockDiff*>(b.get())) {
+				blocks.push_back(diff->getPrev());
+			}
+		}
+	}
+	ranges::sort(blocks);
+	blocks.erase(ranges::unique(blocks), end(blocks));
+	for (const auto* b : blocks) {
+		result += b->getMemoryUsage();
+	}
+	return result;
+}
+
 void ReverseManager::takeSnapshot(EmuTime::param time)
 {
 	// (possibly) drop old snapshots
@@ -863,6 +1277,8 @@ void ReverseManager::takeSnapshot(EmuTime::param time)
 	newChunk.time = time;
 	newChunk.savestate = out.releaseBuffer(newChunk.size);
 	newChunk.eventCount = replayIndex;
+
+	enforceMemoryBudget();
 }
 
 void ReverseManager::replayNextEvent()
@@ -883,6 +1299,8 @@ void ReverseManager::signalStopReplay(EmuTime::param time)
 void ReverseManager::stopReplay(EmuTime::param time) noexcept
 {
 	if (isReplaying()) {
+		// the future changes, speculated snapshots may no longer be valid
+		finishSpeculation(false);
 		// if we're replaying, stop it and erase remainder of event log
 		syncInputEvent.removeSyncPoint();
 		Events& events = history.events;
@@ -903,6 +1321,7 @@ void ReverseManager::stopReplay(EmuTime::param time) noexcept
  * more snapshots of recent history and less of distant history. It has the
  * following properties:
  *  - the very oldest snapshot is never deleted
+ *  - neither are snapshots loaded from a replay (key frames)
  *  - it keeps the N or N+1 most recent snapshots (snapshot distance = 1)
  *  - then it keeps N or N+1 with snapshot distance 2
  *  - then N or N+1 with snapshot distance 4
@@ -919,12 +1338,67 @@ void ReverseManager::dropOldSnapshots(unsigned count)
 	while (true) {
 		y >>= 1;
 		if ((y == 0) || (count < d)) return;
-		history.chunks.erase(count - d);
+		auto it = history.chunks.find(count - d);
+		if ((it != end(history.chunks)) && !it->second.keyFrame) {
+			history.chunks.erase(it);
+		}
 		d += d2;
 		d2 *= 2;
 	}
 }
 
+size_t ReverseManager::getMemoryBudget() const
+{
+	auto& settings = motherBoard.getReactor().getGlobalSettings();
+	auto budget = size_t(settings.getReverseMemoryBudgetSetting().getInt()) << 20;
+	if ((budget == 0) && settings.getLowMemorySetting().getBoolean()) {
+		budget = LOW_MEMORY_BUDGET;
+	}
+	return budget;
+}
+
+size_t ReverseManager::getMemoryUsage() const
+{
+	return history.getMemoryUsage();
+}
+
+/* When the history uses more memory than the budget allows (the
+ * 'reverse_memory_budget' setting, or a default with 'low_memory'), drop
+ * snapshots until it fits again (or until there's nothing left that may be
+ * dropped). Which snapshot is dropped is chosen so that the
+ * distribution stays similar to the one of dropOldSnapshots(): the gap that
+ * remains after dropping it, relative to its distance to the newest snapshot,
+ * is the smallest. So both recent and old history get thinned, but the recent
+ * history stays the densest.
+ * Dropping a snapshot doesn't necessarily free memory (its blocks can be
+ * shared with the neighbouring snapshots), hence the usage is re-measured
+ * after each step.
+ */
+void ReverseManager::enforceMemoryBudget()
+{
+	auto budget = getMemoryBudget();
+	if (budget == 0) return; // unlimited
+
+	auto& chunks = history.chunks;
+	while ((chunks.size() > 2) && (history.getMemoryUsage() > budget)) {
+		// never drop the oldest or the newest snapshot, nor key frames
+		auto newest = std::prev(end(chunks))->first;
+		auto best = end(chunks);
+		double bestScore = 0.0;
+		for (auto it = std::next(begin(chunks)); it != std::prev(end(chunks)); ++it) {
+			if (it->second.keyFrame) continue;
+			auto gap = std::next(it)->first - std::prev(it)->first;
+			double score = double(gap) / double(newest - it->first);
+			if ((best == end(chunks)) || (score < bestScore)) {
+				best = it;
+				bestScore = score;
+			}
+		}
+		if (best == end(chunks)) break;
+		chunks.erase(best);
+	}
+}
+
 void ReverseManager::schedule(EmuTime::param time)
 {
 	syncNewSnapshot.setSyncPoint(time + EmuDuration(SNAPSHOT_PERIOD));
@@ -952,6 +1426,7 @@ void ReverseManager::ReverseCmd::execute(span<const TclObject> tokens, TclObject
 		"goto",       [&]{ manager.goTo(tokens); },
 		"savereplay", [&]{ manager.saveReplay(interp, tokens, result); },
 		"loadreplay", [&]{ manager.loadReplay(interp, tokens, result); },
+		"verify",     [&]{ manager.verifyReplay(tokens, result); },
 		"viewonlymode", [&]{
 			auto& distributor = manager.motherBoard.getStateChangeDistributor();
 			switch (tokens.size()) {
@@ -979,8 +1454,9 @@ std::string ReverseManager::ReverseCmd::help(span<const TclObject> /*tokens*/) c
 	       "goto <time>         go to an absolute moment in time\n"
 	       "viewonlymode <bool> switch viewonly mode on or off\n"
 	       "truncatereplay      stop replaying and remove all 'future' data\n"
-	       "savereplay [<name>] save the first snapshot and all replay data as a 'replay' (with optional name)\n"
-	       "loadreplay [-goto <begin|end|savetime|<n>>] [-viewonly] <name>   load a replay (snapshot and replay data) with given name and start replaying\n";
+	       "savereplay [-maxnofextrasnapshots <n>] [-snapshotinterval <s>] [<name>]   save the first snapshot and all replay data as a 'replay' (with optional name)\n"
+	       "loadreplay [-goto <begin|end|savetime|<n>>] [-viewonly] <name>   load a replay (snapshot and replay data) with given name and start replaying\n"
+	       "verify <name>       re-emulate the replay with given name between each pair of snapshots and report the first difference\n";
 }
 
 void ReverseManager::ReverseCmd::tabCompletion(std::vector<std::string>& tokens) const
@@ -990,14 +1466,19 @@ void ReverseManager::ReverseCmd::tabCompletion(std::vector<std::string>& tokens)
 		static constexpr std::array subCommands = {
 			"start"sv, "stop"sv, "status"sv, "goback"sv, "goto"sv,
 			"savereplay"sv, "loadreplay"sv, "viewonlymode"sv,
-			"truncatereplay"sv,
+			"truncatereplay"sv, "verify"sv,
 		};
 		completeString(tokens, subCommands);
 	} else if ((tokens.size() == 3) || (tokens[1] == "loadreplay")) {
-		if (tokens[1] == one_of("loadreplay", "savereplay")) {
-			static constexpr std::array cmds = {"-goto"sv, "-viewonly"sv};
+		if (tokens[1] == "verify") {
+			completeFileName(tokens, userDataFileContext(REPLAY_DIR));
+		} else if (tokens[1] == one_of("loadreplay", "savereplay")) {
+			static constexpr std::array loadCmds = {"-goto"sv, "-viewonly"sv};
+			static constexpr std::array saveCmds = {
+				"-maxnofextrasnapshots"sv, "-snapshotinterval"sv};
 			completeFileName(tokens, userDataFileContext(REPLAY_DIR),
-				(tokens[1] == "loadreplay") ? cmds : span<const std::string_view>{});
+				(tokens[1] == "loadreplay") ? span<const std::string_view>(loadCmds)
+				                            : span<const std::string_view>(saveCmds));
 		} else if (tokens[1] == "viewonlymode") {
 			static constexpr std::array options = {"true"sv, "false"sv};
 			completeString(tokens, options);
@@ -51,9 +51,18 @@ public:
 		reRecordCount = count;
 	}
 
+	/** Go to the given time in the current time-line (like 'reverse goto').
+	  * Note that this may replace the active MSXMotherBoard, and thus
+	  * destroy this object. Only use the returned (new) board afterwards.
+	  * @throws CommandException when reverse is not enabled. */
+	MSXMotherBoard& goTo(EmuTime::param targetTime, bool novideo);
+
 	[[nodiscard]] bool isReplaying() const;
 	void stopReplay(EmuTime::param time) noexcept;
 
+	/** Memory used by the snapshots in the history (in bytes). */
+	[[nodiscard]] size_t getMemoryUsage() const;
+
 	template<typename T, typename... Args>
 	StateChange& record(EmuTime::param time, Args&& ...args) {
 		assert(!isReplaying());
@@ -75,6 +84,12 @@ private:
 		// snapshot was created. So when going back replay should
 		// start at this index.
 		unsigned eventCount;
+
+		// Snapshot that was loaded from a replay file. These are never
+		// dropped by dropOldSnapshots(), so that seeking in a (long)
+		// replay never re-emulates more than the distance between two
+		// such snapshots.
+		bool keyFrame = false;
 	};
 	using Chunks = std::map<unsigned, ReverseChunk>;
 	using Events = std::deque<std::unique_ptr<StateChange>>;
@@ -83,6 +98,7 @@ private:
 		void swap(ReverseHistory& other) noexcept;
 		void clear();
 		[[nodiscard]] unsigned getNextSeqNum(EmuTime::param time) const;
+		[[nodiscard]] size_t getMemoryUsage() const;
 
 		Chunks chunks;
 		Events events;
@@ -101,12 +117,14 @@ private:
 	                span<const TclObject> tokens, TclObject& result);
 	void loadReplay(Interpreter& interp,
 	                span<const TclObject> tokens, TclObject& result);
+	void verifyReplay(span<const TclObject> tokens, TclObject& result);
+	void startSegmentReplay(Events&& events);
+	void stopSegmentReplay();
 
 	void signalStopReplay(EmuTime::param time);
 	[[nodiscard]] EmuTime::param getEndTime(const ReverseHistory& history) const;
-	void goTo(EmuTime::param targetTime, bool novideo);
-	void goTo(EmuTime::param targetTime, bool novideo,
-	          ReverseHistory& history, bool sameTimeLine);
+	MSXMotherBoard& goTo(EmuTime::param targetTime, bool novideo,
+	                     ReverseHistory& history, bool sameTimeLine);
 	void transferHistory(ReverseHistory& oldHistory,
 	                     unsigned oldEventCount);
 	void transferState(MSXMotherBoard& newBoard);
@@ -114,6 +132,10 @@ private:
 	void schedule(EmuTime::param time);
 	void replayNextEvent();
 	template<unsigned N> void dropOldSnapshots(unsigned count);
+	[[nodiscard]] size_t getMemoryBudget() const;
+	void enforceMemoryBudget();
+	void startSpeculation(EmuTime::param time);
+	void finishSpeculation(bool keepResults);
 
 	// Schedulable
 	struct SyncNewSnapshot final : Schedulable {
@@ -160,6 +182,11 @@ private:
 
 	unsigned reRecordCount;
 
+	// Background emulation that fills in missing snapshots around the
+	// position of the last goTo(), see startSpeculation().
+	struct Speculation;
+	std::unique_ptr<Speculation> speculation;
+
 	friend struct Replay;
 };
 
@@ -1,5 +1,6 @@
 #include "Schedulable.hh"
 #include "Scheduler.hh"
+#include "PerfTimers.hh"
 #include <iostream>
 
 namespace openmsx {
@@ -20,6 +21,11 @@ void Schedulable::schedulerDeleted()
 	          << "\" failed to unregister.\n";
 }
 
+unsigned Schedulable::lookupPerfSlot() const
+{
+	return PerfTimers::getSchedulableSlot(typeid(*this));
+}
+
 void Schedulable::setSyncPoint(EmuTime::param timestamp)
 {
 	scheduler.setSyncPoint(timestamp, *this);
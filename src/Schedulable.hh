@@ -57,6 +57,12 @@ public:
 
 	[[nodiscard]] Scheduler& getScheduler() const { return scheduler; }
 
+	/** The PerfTimers slot for (the dynamic type of) this object. */
+	[[nodiscard]] unsigned getPerfSlot() const {
+		if (!perfSlot) perfSlot = lookupPerfSlot();
+		return perfSlot;
+	}
+
 	/** Convenience method:
 	  * This is the same as getScheduler().getCurrentTime(). */
 	[[nodiscard]] EmuTime::param getCurrentTime() const;
@@ -97,8 +103,12 @@ protected:
 	[[nodiscard]] bool pendingSyncPoint() const;
 	[[nodiscard]] bool pendingSyncPoint(EmuTime& result) const;
 
+private:
+	[[nodiscard]] unsigned lookupPerfSlot() const;
+
 private:
 	Scheduler& scheduler;
+	mutable unsigned perfSlot = 0; // 0 -> not yet looked up
 };
 REGISTER_BASE_CLASS(Schedulable, "Schedulable");
 
@@ -2,6 +2,7 @@
 #include "Schedulable.hh"
 #include "Thread.hh"
 #include "MSXCPU.hh"
+#include "PerfTimers.hh"
 #include "ranges.hh"
 #include "serialize.hh"
 #include "stl.hh"
@@ -39,8 +40,7 @@ void Scheduler::setSyncPoint(EmuTime::param time, Schedulable& device)
 	// Push sync point into queue.
 	queue.insert(SynchronizationPoint(time, &device),
 	             [](SynchronizationPoint& sp) { sp.setTime(EmuTime::infinity()); },
-	             [](const SynchronizationPoint& x, const SynchronizationPoint& y) {
-	                     return x.getTime() < y.getTime(); });
+	             LessSyncPoint());
 
 	if (!scheduleInProgress && cpu) {
 		// only when scheduleHelper() is not being executed
@@ -54,6 +54,10 @@ Scheduler::SyncPoints Scheduler::getSyncPoints(const Schedulable& device) const
 {
 	SyncPoints result;
 	ranges::copy_if(queue, back_inserter(result), EqualSchedulable(device));
+	if constexpr (!decltype(queue)::IS_SORTED) {
+		// keep savestates identical for both queue implementations
+		ranges::stable_sort(result, LessSyncPoint());
+	}
 	return result;
 }
 
@@ -73,12 +77,25 @@ bool Scheduler::pendingSyncPoint(const Schedulable& device,
                                  EmuTime& result) const
 {
 	assert(Thread::isMainThread());
-	if (auto it = ranges::find(queue, &device, &SynchronizationPoint::getDevice);
-	    it != std::end(queue)) {
-		result = it->getTime();
-		return true;
+	if constexpr (decltype(queue)::IS_SORTED) {
+		// first match is the earliest
+		if (auto it = ranges::find(queue, &device, &SynchronizationPoint::getDevice);
+		    it != std::end(queue)) {
+			result = it->getTime();
+			return true;
+		}
+		return false;
+	} else {
+		bool found = false;
+		for (const auto& sp : queue) {
+			if ((sp.getDevice() == &device) &&
+			    (!found || (sp.getTime() < result))) {
+				result = sp.getTime();
+				found = true;
+			}
+		}
+		return found;
 	}
-	return false;
 }
 
 EmuTime::param Scheduler::getCurrentTime() const
@@ -100,6 +117,7 @@ void Scheduler::scheduleHelper(EmuTime::param limit, EmuTime next)
 
 		queue.remove_front();
 
+		PerfTimers::Scope perf(device->getPerfSlot());
 		device->executeUntil(next);
 
 		next = getNext();
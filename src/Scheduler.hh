@@ -2,8 +2,10 @@
 #define SCHEDULER_HH
 
 #include "EmuTime.hh"
+#include "SchedulerHeap.hh"
 #include "SchedulerQueue.hh"
 #include "likely.hh"
+#include <type_traits>
 #include <vector>
 
 namespace openmsx {
@@ -30,6 +32,20 @@ private:
 };
 
 
+// Select the container for the pending sync points: 'false' -> SchedulerQueue
+// (sorted array), 'true' -> SchedulerHeap (binary heap). Both give the same
+// emulation results. For the typical number of sync points (a few dozen) the
+// sorted array is faster.
+constexpr bool USE_SCHEDULER_HEAP = false;
+
+struct LessSyncPoint {
+	[[nodiscard]] bool operator()(const SynchronizationPoint& x,
+	                              const SynchronizationPoint& y) const {
+		return x.getTime() < y.getTime();
+	}
+};
+
+
 class Scheduler
 {
 public:
@@ -109,10 +125,12 @@ private:
 	void scheduleHelper(EmuTime::param limit, EmuTime next);
 
 private:
-	/** Vector used as heap, not a priority queue because that
-	  * doesn't allow removal of non-top element.
+	/** Not a std::priority_queue because that doesn't allow removal of
+	  * non-top element.
 	  */
-	SchedulerQueue<SynchronizationPoint> queue;
+	std::conditional_t<USE_SCHEDULER_HEAP,
+	                   SchedulerHeap<SynchronizationPoint, LessSyncPoint>,
+	                   SchedulerQueue<SynchronizationPoint>> queue;
 	EmuTime scheduleTime = EmuTime::zero();
 	MSXCPU* cpu = nullptr;
 	bool scheduleInProgress = false;
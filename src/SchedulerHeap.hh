@@ -0,0 +1,154 @@
+#ifndef SCHEDULERHEAP_HH
+#define SCHEDULERHEAP_HH
+
+#include <cassert>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace openmsx {
+
+// Alternative for SchedulerQueue: a binary min-heap. Inserting and removing
+// an element is O(log N) instead of O(N) (with a small constant, see the
+// comment in SchedulerQueue), finding an element for removal is still O(N).
+// Because the underlying storage isn't sorted, begin()/end() iterate in an
+// unspecified order.
+//
+// Like SchedulerQueue, elements that are equivalent according to 'LESS' are
+// returned in insertion order (so the two implementations are exchangeable
+// without changing emulation results). For this each element gets an
+// insertion sequence number.
+template<typename T, typename LESS> class SchedulerHeap
+{
+public:
+	static constexpr bool IS_SORTED = false;
+
+	[[nodiscard]] size_t size()  const { return items.size(); }
+	[[nodiscard]] bool   empty() const { return items.empty(); }
+
+	// Returns reference to the smallest element.
+	[[nodiscard]]       T& front()       { assert(!empty()); return items.front(); }
+	[[nodiscard]] const T& front() const { assert(!empty()); return items.front(); }
+
+	[[nodiscard]]       T* begin()       { return items.data(); }
+	[[nodiscard]] const T* begin() const { return items.data(); }
+	[[nodiscard]]       T* end()         { return items.data() + items.size(); }
+	[[nodiscard]] const T* end()   const { return items.data() + items.size(); }
+
+	// Same interface as SchedulerQueue::insert(), but this implementation
+	// doesn't need a sentinel, and the order is taken from the 'LESS'
+	// template parameter (the 'less' argument must be equivalent).
+	template<typename SET_SENTINEL, typename LESS2>
+	void insert(const T& t, SET_SENTINEL /*setSentinel*/, LESS2 /*less*/)
+	{
+		items.push_back(t);
+		seqs.push_back(nextSeq++);
+		siftUp(items.size() - 1);
+	}
+
+	// Remove the smallest element.
+	void remove_front()
+	{
+		assert(!empty());
+		removeAt(0);
+	}
+
+	// Remove the smallest element for which the given predicate returns
+	// true, so the same element as SchedulerQueue::remove() removes (the
+	// storage order of the heap is not the sorted order).
+	template<typename PRED> bool remove(PRED p)
+	{
+		size_t n = items.size();
+		size_t found = n;
+		for (size_t i = 0; i < n; ++i) {
+			if (!p(items[i])) continue;
+			if ((found == n) || less(i, found)) found = i;
+		}
+		if (found == n) return false;
+		removeAt(found);
+		return true;
+	}
+
+	// Remove all elements for which the given predicate returns true.
+	template<typename PRED> void remove_all(PRED p)
+	{
+		size_t out = 0;
+		for (size_t i = 0; i < items.size(); ++i) {
+			if (p(items[i])) continue;
+			items[out] = items[i];
+			seqs [out] = seqs [i];
+			++out;
+		}
+		if (out == items.size()) return;
+		items.resize(out);
+		seqs .resize(out);
+		for (size_t i = out / 2; i-- > 0; ) {
+			siftDown(i);
+		}
+	}
+
+private:
+	[[nodiscard]] bool less(size_t i, size_t j) const
+	{
+		LESS l;
+		if (l(items[i], items[j])) return true;
+		if (l(items[j], items[i])) return false;
+		return seqs[i] < seqs[j];
+	}
+
+	void swapElements(size_t i, size_t j)
+	{
+		std::swap(items[i], items[j]);
+		std::swap(seqs [i], seqs [j]);
+	}
+
+	void siftUp(size_t i)
+	{
+		while (i != 0) {
+			size_t parent = (i - 1) / 2;
+			if (!less(i, parent)) break;
+			swapElements(i, parent);
+			i = parent;
+		}
+	}
+
+	void siftDown(size_t i)
+	{
+		size_t n = items.size();
+		while (true) {
+			size_t smallest = i;
+			size_t l = 2 * i + 1;
+			size_t r = l + 1;
+			if ((l < n) && less(l, smallest)) smallest = l;
+			if ((r < n) && less(r, smallest)) smallest = r;
+			if (smallest == i) break;
+			swapElements(i, smallest);
+			i = smallest;
+		}
+	}
+
+	void removeAt(size_t i)
+	{
+		size_t last = items.size() - 1;
+		if (i != last) {
+			items[i] = items[last];
+			seqs [i] = seqs [last];
+			items.pop_back();
+			seqs .pop_back();
+			siftDown(i);
+			siftUp(i);
+		} else {
+			items.pop_back();
+			seqs .pop_back();
+		}
+	}
+
+private:
+	std::vector<T> items;
+	std::vector<uint64_t> seqs; // insertion order, parallel to 'items'
+	uint64_t nextSeq = 0;
+};
+
+} // namespace openmsx
+
+#endif // SCHEDULERHEAP_HH
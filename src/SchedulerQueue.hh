@@ -19,6 +19,7 @@ namespace openmsx {
 template<typename T> class SchedulerQueue
 {
 public:
+	static constexpr bool IS_SORTED = true;
 	static constexpr int CAPACITY = 32; // initial capacity
 	static constexpr int SPARE_FRONT = 1;
 	SchedulerQueue()
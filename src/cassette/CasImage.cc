@@ -4,9 +4,13 @@
 #include "Filename.hh"
 #include "CliComm.hh"
 #include "MSXException.hh"
+#include "ranges.hh"
 #include "span.hh"
 #include "stl.hh"
+#include "unreachable.hh"
 #include "xrange.hh"
+#include <algorithm>
+#include <cassert>
 #include <cstring> // for memcmp
 
 static constexpr std::array<uint8_t, 10> ASCII_HEADER  = { 0xEA,0xEA,0xEA,0xEA,0xEA,0xEA,0xEA,0xEA,0xEA,0xEA };
@@ -30,20 +34,44 @@ namespace openmsx {
 // So every sample repeated 4 times.
 constexpr unsigned AUDIO_OVERSAMPLE = 4;
 
-static void append(std::vector<int8_t>& wave, size_t count, int8_t value)
+template<typename Array>
+static bool compare(const uint8_t* p, const Array& array)
 {
-	wave.insert(wave.end(), count, value);
+	return memcmp(p, array.data(), array.size()) == 0;
 }
 
-static void writeSilence(std::vector<int8_t>& wave, unsigned s)
+// The MSX waveform is very regular, so instead of synthesizing it all upfront
+// (44 samples per byte in the .cas file) only its structure is stored, as a
+// list of segments. Samples are calculated on demand (see getSample()).
+void CasImage::Builder::silence(size_t count)
 {
-	append(wave, s, 0);
+	add(Segment::SILENCE, 0, count);
 }
 
-template<typename Array>
-static bool compare(const uint8_t* p, const Array& array)
+void CasImage::Builder::header(size_t count)
 {
-	return memcmp(p, array.data(), array.size()) == 0;
+	add(Segment::HEADER, 0, count * 4);
+}
+
+void CasImage::Builder::bytes(size_t begin, size_t end)
+{
+	if (begin >= end) return;
+	add(Segment::BYTES, begin, (end - begin) * SAMPLES_PER_BYTE);
+}
+
+void CasImage::Builder::append(size_t count, int8_t value)
+{
+	if (data.segments.empty() || (data.segments.back().kind != Segment::WAVE)) {
+		add(Segment::WAVE, data.wave.size(), 0);
+	}
+	data.wave.insert(data.wave.end(), count, value);
+	data.length += count;
+}
+
+void CasImage::Builder::add(Segment::Kind kind, size_t offset, size_t count)
+{
+	data.segments.push_back({data.length, offset, kind});
+	data.length += count;
 }
 
 namespace MSX_CAS {
@@ -69,54 +97,23 @@ constexpr unsigned SHORT_HEADER =  4000 / 2;
 // headers definitions
 constexpr std::array<uint8_t, 8> CAS_HEADER = { 0x1F,0xA6,0xDE,0xBA,0xCC,0x13,0x7D,0x74 };
 
-static void write0(std::vector<int8_t>& wave)
-{
-	::append(wave, {127, 127, -127, -127});
-}
-static void write1(std::vector<int8_t>& wave)
-{
-	::append(wave, {127, -127, 127, -127});
-}
-
-static void writeHeader(std::vector<int8_t>& wave, unsigned s)
-{
-	repeat(s, [&] { write1(wave); });
-}
-
-static void writeByte(std::vector<int8_t>& wave, uint8_t b)
-{
-	// one start bit
-	write0(wave);
-	// eight data bits
-	for (auto i : xrange(8)) {
-		if (b & (1 << i)) {
-			write1(wave);
-		} else {
-			write0(wave);
-		}
-	}
-	// two stop bits
-	write1(wave);
-	write1(wave);
-}
-
 // write data until a header is detected
-static bool writeData(std::vector<int8_t>& wave, span<const uint8_t> cas, size_t& pos)
+static bool writeData(CasImage::Builder& wave, span<const uint8_t> cas, size_t& pos)
 {
 	bool eof = false;
+	auto begin = pos;
 	while ((pos + CAS_HEADER.size()) <= cas.size()) {
 		if (compare(&cas[pos], CAS_HEADER)) {
+			wave.bytes(begin, pos);
 			return eof;
 		}
-		writeByte(wave, cas[pos]);
 		if (cas[pos] == 0x1A) {
 			eof = true;
 		}
 		pos++;
 	}
-	while (pos < cas.size()) {
-		writeByte(wave, cas[pos++]);
-	}
+	pos = std::max(pos, cas.size());
+	wave.bytes(begin, cas.size());
 	return false;
 }
 
@@ -125,7 +122,7 @@ static CasImage::Data convert(span<const uint8_t> cas, const std::string& filena
 {
 	CasImage::Data data;
 	data.frequency = OUTPUT_FREQUENCY;
-	auto& wave = data.wave;
+	CasImage::Builder wave(data);
 
 	// search for a header in the .cas file
 	bool issueWarning = false;
@@ -139,8 +136,8 @@ static CasImage::Data convert(span<const uint8_t> cas, const std::string& filena
 			// them, we do also (hence a lot of code).
 			headerFound = true;
 			pos += CAS_HEADER.size();
-			writeSilence(wave, LONG_SILENCE);
-			writeHeader(wave, LONG_HEADER);
+			wave.silence(LONG_SILENCE);
+			wave.header(LONG_HEADER);
 			if ((pos + ASCII_HEADER.size()) <= cas.size()) {
 				// determine file type
 				auto type = [&] {
@@ -161,16 +158,16 @@ static CasImage::Data convert(span<const uint8_t> cas, const std::string& filena
 						bool eof;
 						do {
 							pos += CAS_HEADER.size();
-							writeSilence(wave, SHORT_SILENCE);
-							writeHeader(wave, SHORT_HEADER);
+							wave.silence(SHORT_SILENCE);
+							wave.header(SHORT_HEADER);
 							eof = writeData(wave, cas, pos);
 						} while (!eof && ((pos + CAS_HEADER.size()) <= cas.size()));
 						break;
 					case CassetteImage::BINARY:
 					case CassetteImage::BASIC:
 						writeData(wave, cas, pos);
-						writeSilence(wave, SHORT_SILENCE);
-						writeHeader(wave, SHORT_HEADER);
+						wave.silence(SHORT_SILENCE);
+						wave.header(SHORT_HEADER);
 						pos += CAS_HEADER.size();
 						writeData(wave, cas, pos);
 						break;
@@ -197,6 +194,7 @@ static CasImage::Data convert(span<const uint8_t> cas, const std::string& filena
 		 cliComm.printWarning("Skipped unhandled data in ", filename);
 	}
 
+	data.cas.assign(cas.begin(), cas.end());
 	return data;
 }
 
@@ -210,23 +208,25 @@ static constexpr std::array<uint8_t, 17> header = {
 	0x7f,
 };
 
-static void writeBit(std::vector<int8_t>& wave, bool bit)
+// The SVI waveform has bits of different lengths, it's (still) synthesized
+// upfront. SVI tapes are small.
+static void writeBit(CasImage::Builder& wave, bool bit)
 {
 	size_t count = bit ? 1 : 2;
-	append(wave, count,  127);
-	append(wave, count, -127);
+	wave.append(count,  127);
+	wave.append(count, -127);
 }
 
-static void writeByte(std::vector<int8_t>& wave, uint8_t byte)
+static void writeByte(CasImage::Builder& wave, uint8_t byte)
 {
 	for (int i = 7; i >= 0; --i) {
 		writeBit(wave, (byte >> i) & 1);
 	}
 }
 
-static void processBlock(span<const uint8_t> subBuf, std::vector<int8_t>& wave)
+static void processBlock(span<const uint8_t> subBuf, CasImage::Builder& wave)
 {
-	writeSilence(wave, 1200);
+	wave.silence(1200);
 	writeBit(wave, true);
 	repeat(199, [&] { writeByte(wave, 0x55); });
 	writeByte(wave, 0x7f);
@@ -240,6 +240,7 @@ static CasImage::Data convert(span<const uint8_t> cas, CassetteImage::FileType&
 {
 	CasImage::Data data;
 	data.frequency = 4800;
+	CasImage::Builder wave(data);
 
 	if (cas.size() >= (header.size() + ASCII_HEADER.size())) {
 		if (compare(&cas[header.size()], ASCII_HEADER)) {
@@ -255,7 +256,7 @@ static CasImage::Data convert(span<const uint8_t> cas, CassetteImage::FileType&
 	while (true) {
 		auto nextHeader = std::search(prevHeader, cas.end(),
 		                              header.begin(), header.end());
-		processBlock(span(prevHeader, nextHeader), data.wave);
+		processBlock(span(prevHeader, nextHeader), wave);
 		if (nextHeader == cas.end()) break;
 		prevHeader = nextHeader + header.size();
 	}
@@ -291,16 +292,52 @@ CasImage::CasImage(const Filename& filename, FilePool& filePool, CliComm& cliCom
 {
 }
 
+size_t CasImage::findSegment(size_t pos) const
+{
+	assert(!data.segments.empty() && (pos < data.length));
+	auto it = ranges::upper_bound(data.segments, pos, {}, &Segment::start);
+	assert(it != begin(data.segments));
+	return (it - begin(data.segments)) - 1;
+}
+
+int8_t CasImage::getSample(const Segment& segment, size_t pos) const
+{
+	// a 0-bit is {127, 127, -127, -127}, a 1-bit is {127, -127, 127, -127}
+	auto bitSample = [](bool bit, size_t i) -> int8_t {
+		return (bit ? (i & 1) : (i & 2)) ? -127 : 127;
+	};
+	auto offset = pos - segment.start;
+	switch (segment.kind) {
+	case Segment::SILENCE:
+		return 0;
+	case Segment::HEADER:
+		return bitSample(true, offset);
+	case Segment::BYTES: {
+		// one start bit (0), eight data bits (LSB first), two stop bits (1)
+		uint8_t b = data.cas[segment.offset + offset / SAMPLES_PER_BYTE];
+		auto bitNum = (offset % SAMPLES_PER_BYTE) / 4;
+		bool bit = (bitNum == 0) ? false
+		         : (bitNum <= 8) ? ((b >> (bitNum - 1)) & 1)
+		         : true;
+		return bitSample(bit, offset);
+	}
+	case Segment::WAVE:
+		return data.wave[segment.offset + offset];
+	default:
+		UNREACHABLE; return 0;
+	}
+}
+
 int16_t CasImage::getSampleAt(EmuTime::param time) const
 {
 	EmuDuration d = time - EmuTime::zero();
 	unsigned pos = d.getTicksAt(data.frequency);
-	return pos < data.wave.size() ? data.wave[pos] * 256 : 0;
+	return pos < data.length ? getSample(data.segments[findSegment(pos)], pos) * 256 : 0;
 }
 
 EmuTime CasImage::getEndTime() const
 {
-	EmuDuration d = EmuDuration::hz(data.frequency) * data.wave.size();
+	EmuDuration d = EmuDuration::hz(data.frequency) * data.length;
 	return EmuTime::zero() + d;
 }
 
@@ -311,12 +348,20 @@ unsigned CasImage::getFrequency() const
 
 void CasImage::fillBuffer(unsigned pos, float** bufs, unsigned num) const
 {
-	size_t nbSamples = data.wave.size();
+	size_t nbSamples = data.length;
 	if ((pos / AUDIO_OVERSAMPLE) < nbSamples) {
+		auto s = findSegment(pos / AUDIO_OVERSAMPLE);
 		for (auto i : xrange(num)) {
-			bufs[0][i] = ((pos / AUDIO_OVERSAMPLE) < nbSamples)
-			           ? data.wave[pos / AUDIO_OVERSAMPLE]
-			           : 0.0f;
+			size_t p = pos / AUDIO_OVERSAMPLE;
+			if (p < nbSamples) {
+				while (((s + 1) < data.segments.size()) &&
+				       (data.segments[s + 1].start <= p)) {
+					++s;
+				}
+				bufs[0][i] = getSample(data.segments[s], p);
+			} else {
+				bufs[0][i] = 0.0f;
+			}
 			++pos;
 		}
 	} else {
@@ -329,4 +374,62 @@ float CasImage::getAmplificationFactorImpl() const
 	return 1.0f / 128;
 }
 
+size_t CasImage::getSegmentEnd(size_t s) const
+{
+	return ((s + 1) < data.segments.size()) ? data.segments[s + 1].start
+	                                        : data.length;
+}
+
+size_t CasImage::toSample(EmuTime::param time) const
+{
+	return (time - EmuTime::zero()).getTicksAt(data.frequency);
+}
+
+EmuTime CasImage::toTime(size_t sample) const
+{
+	return EmuTime::zero() + EmuDuration::hz(data.frequency) * sample;
+}
+
+std::optional<EmuTime> CasImage::fastSkipHeader(EmuTime::param time) const
+{
+	// the end of the first header that's not yet passed
+	auto pos = toSample(time);
+	if (pos >= data.length) return {};
+	for (auto s : xrange(findSegment(pos), data.segments.size())) {
+		if (data.segments[s].kind == Segment::HEADER) {
+			return toTime(getSegmentEnd(s));
+		}
+	}
+	return {};
+}
+
+std::optional<std::pair<uint8_t, EmuTime>> CasImage::fastReadByte(EmuTime::param time) const
+{
+	auto pos = toSample(time);
+	if (pos >= data.length) return {};
+	auto s = findSegment(pos);
+	if (data.segments[s].kind == Segment::HEADER) {
+		// the data right after a header
+		++s;
+		if (s == data.segments.size()) return {};
+		pos = data.segments[s].start;
+	}
+	const auto& segment = data.segments[s];
+	if (segment.kind != Segment::BYTES) {
+		// silence (read error) or SVI: use the normal signal
+		return {};
+	}
+	// When we're still in the start bit, this is the byte to read.
+	// Otherwise (typically in the stop bits) it's the next one.
+	auto offset = pos - segment.start;
+	auto index = offset / SAMPLES_PER_BYTE;
+	if ((offset % SAMPLES_PER_BYTE) >= 4) ++index;
+	if (segment.start + (index + 1) * SAMPLES_PER_BYTE > getSegmentEnd(s)) {
+		// at the end of this block, the next one starts with silence
+		return {};
+	}
+	return std::pair{data.cas[segment.offset + index],
+	                 toTime(segment.start + (index + 1) * SAMPLES_PER_BYTE)};
+}
+
 } // namespace openmsx
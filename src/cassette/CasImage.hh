@@ -25,14 +25,55 @@ public:
 	[[nodiscard]] unsigned getFrequency() const override;
 	void fillBuffer(unsigned pos, float** bufs, unsigned num) const override;
 	[[nodiscard]] float getAmplificationFactorImpl() const override;
+	[[nodiscard]] std::optional<EmuTime> fastSkipHeader(
+		EmuTime::param pos) const override;
+	[[nodiscard]] std::optional<std::pair<uint8_t, EmuTime>> fastReadByte(
+		EmuTime::param pos) const override;
+
+	// 4 samples per bit: one start bit, eight data bits, two stop bits
+	static constexpr unsigned SAMPLES_PER_BYTE = 11 * 4;
+
+	/** A part of the waveform, starting at sample 'start'. */
+	struct Segment {
+		enum Kind : uint8_t {
+			SILENCE, // all zero
+			HEADER,  // 1-bits
+			BYTES,   // the bytes starting at data.cas[offset]
+			WAVE,    // the samples starting at data.wave[offset]
+		};
+		size_t start;
+		size_t offset;
+		Kind kind;
+	};
 
 	struct Data {
-		std::vector<int8_t> wave;
+		std::vector<uint8_t> cas; // only used by BYTES segments
+		std::vector<int8_t> wave; // only used by WAVE segments
+		std::vector<Segment> segments; // sorted on start
+		size_t length = 0; // in samples
 		unsigned frequency;
 	};
 
+	/** Helper to construct the segments. */
+	class Builder {
+	public:
+		explicit Builder(Data& data_) : data(data_) {}
+		void silence(size_t count);
+		void header(size_t count); // number of 1-bits
+		void bytes(size_t begin, size_t end); // range in data.cas
+		void append(size_t count, int8_t value);
+	private:
+		void add(Segment::Kind kind, size_t offset, size_t count);
+		Data& data;
+	};
+
 private:
 	Data init(const Filename& filename, FilePool& filePool, CliComm& cliComm);
+	[[nodiscard]] size_t findSegment(size_t pos) const;
+	[[nodiscard]] int8_t getSample(const Segment& segment, size_t pos) const;
+	[[nodiscard]] size_t getSegmentEnd(size_t s) const;
+	[[nodiscard]] size_t toSample(EmuTime::param time) const;
+	[[nodiscard]] EmuTime toTime(size_t sample) const;
 
 private:
 	const Data data;
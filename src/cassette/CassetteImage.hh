@@ -4,7 +4,9 @@
 #include "EmuTime.hh"
 #include "sha1.hh"
 #include <cstdint>
+#include <optional>
 #include <string>
+#include <utility>
 
 namespace openmsx {
 
@@ -32,6 +34,19 @@ public:
 	 */
 	[[nodiscard]] const Sha1Sum& getSha1Sum() const;
 
+	/** Support for fast loading via the BIOS tape routines (see the
+	 * 'tape_fast_load' setting). Only possible when the image knows the
+	 * bytes on the tape, by default it's not supported.
+	 * @param pos Current position on the tape.
+	 * @return The position right after the next header (TAPION), or
+	 *         the next byte and the position right after it (TAPIN).
+	 *         Nothing when this should be done via the normal signal.
+	 */
+	[[nodiscard]] virtual std::optional<EmuTime> fastSkipHeader(
+		EmuTime::param /*pos*/) const { return {}; }
+	[[nodiscard]] virtual std::optional<std::pair<uint8_t, EmuTime>> fastReadByte(
+		EmuTime::param /*pos*/) const { return {}; }
+
 protected:
 	CassetteImage() = default;
 	void setFirstFileType(FileType type) { firstFileType = type; }
@@ -452,6 +452,39 @@ void CassettePlayer::setSignal(bool output, EmuTime::param time)
 	lastOutput = output;
 }
 
+bool CassettePlayer::fastSkipHeader(EmuTime::param time)
+{
+	if (getState() != PLAY) return false;
+	sync(time);
+	auto newPos = playImage->fastSkipHeader(tapePos);
+	if (!newPos) return false;
+	moveTape(*newPos, time);
+	return true;
+}
+
+std::optional<uint8_t> CassettePlayer::fastReadByte(EmuTime::param time)
+{
+	if (getState() != PLAY) return {};
+	sync(time);
+	auto r = playImage->fastReadByte(tapePos);
+	if (!r) return {};
+	moveTape(r->second, time);
+	return r->first;
+}
+
+void CassettePlayer::moveTape(EmuTime::param newPos, EmuTime::param time)
+{
+	assert(getState() == PLAY);
+	assert(newPos <= playImage->getEndTime());
+	updateStream(time); // sound for the old position
+	sync(time);
+	tapePos = newPos;
+	DynamicClock clk(EmuTime::zero());
+	clk.setFreq(playImage->getFrequency());
+	audioPos = clk.getTicksTill(tapePos);
+	updateLoadingState(time); // end-of-tape moved
+}
+
 void CassettePlayer::sync(EmuTime::param time)
 {
 	EmuDuration duration = time - prevSyncTime;
@@ -678,6 +711,18 @@ void CassettePlayer::TapeCommand::execute(
 			throw SyntaxError();
 		}
 
+	} else if (tokens[1] == "fastload" && tokens.size() == 3) {
+		// used by the 'tape_fast_load' script, see there
+		if (tokens[2] == "header") {
+			result = cassettePlayer.fastSkipHeader(time);
+		} else if (tokens[2] == "byte") {
+			if (auto b = cassettePlayer.fastReadByte(time)) {
+				result = int(*b);
+			}
+		} else {
+			throw SyntaxError();
+		}
+
 	} else if (tokens.size() != 2) {
 		throw SyntaxError();
 
@@ -794,6 +839,15 @@ string CassettePlayer::TapeCommand::help(span<const TclObject> tokens) const
 		} else if (tokens[1] == "getlength") {
 			helptext =
 			    "Return the length of the tape in seconds.";
+		} else if (tokens[1] == "fastload") {
+			helptext =
+			    "Used by the 'tape_fast_load' setting. 'fastload "
+			    "header' moves the tape to the end of the next "
+			    "header and returns true, 'fastload byte' returns "
+			    "the next byte and moves the tape past it. When "
+			    "that's not possible (e.g. for WAV images) these "
+			    "return false or an empty string and the tape "
+			    "isn't moved.";
 		}
 	} else {
 		helptext =
@@ -841,7 +895,8 @@ void CassettePlayer::TapeCommand::tabCompletion(std::vector<string>& tokens) con
 
 bool CassettePlayer::TapeCommand::needRecord(span<const TclObject> tokens) const
 {
-	return tokens.size() > 1;
+	// 'fastload' is executed from a breakpoint, so also during a replay
+	return (tokens.size() > 1) && (tokens[1] != "fastload");
 }
 
 
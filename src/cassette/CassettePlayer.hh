@@ -14,6 +14,7 @@
 #include "serialize_meta.hh"
 #include <string>
 #include <memory>
+#include <optional>
 
 namespace openmsx {
 
@@ -103,6 +104,15 @@ private:
 	  * continuously). */
 	double getTapeLength(EmuTime::param time);
 
+	/** Fast loading, called from the BIOS TAPION/TAPIN breakpoints of
+	  * the 'tape_fast_load' script. These move the tape to the position
+	  * where reading the signal would have ended, so that (custom)
+	  * loaders that read the signal can continue from there.
+	  * @return false/nothing when it should be done via the signal. */
+	bool fastSkipHeader(EmuTime::param time);
+	std::optional<uint8_t> fastReadByte(EmuTime::param time);
+	void moveTape(EmuTime::param newPos, EmuTime::param time);
+
 	void sync(EmuTime::param time);
 	void updateTapePosition(EmuDuration::param duration, EmuTime::param time);
 	void generateRecordOutput(EmuDuration::param duration);
@@ -3,10 +3,16 @@
 #include "Filename.hh"
 #include "FilePool.hh"
 #include "Math.hh"
+#include "MSXException.hh"
+#include "WavData.hh"
 #include "ranges.hh"
 #include "xrange.hh"
+#include <algorithm>
 #include <cassert>
 #include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
 
 namespace openmsx {
 
@@ -25,17 +31,123 @@ public:
 		t0 = t1;
 		return y;
 	}
+	[[nodiscard]] float getState() const { return t0; }
+	void setState(float state) { t0 = state; }
 private:
 	float R;
 	float t0 = 0.0f;
 };
 
 
+// The (filtered) samples of a .wav file, decoded on demand, per block. An
+// hour of tape at 44kHz would otherwise take more than 300MB. To get exactly
+// the same result as when filtering the whole file in one go, the state of
+// the DC filter at the start of each block is recorded in a first pass.
+// Shared by all WavImages of the same file (the state is immutable, except
+// for the file position, that's protected by a mutex).
+class WavStream
+{
+public:
+	static constexpr unsigned BLOCK_SIZE = 4096; // in samples
+
+	explicit WavStream(File& file);
+
+	[[nodiscard]] unsigned getFreq() const { return format.freq; }
+	[[nodiscard]] unsigned getSize() const { return format.length; }
+
+	/** Decode the given block, writes BLOCK_SIZE samples (the last block
+	  * is padded with zeros). */
+	void decode(unsigned block, int16_t* out) const;
+
+private:
+	template<typename F> void read(size_t first, size_t num, F f) const;
+
+private:
+	mutable File file;
+	mutable std::mutex mutex;
+	WavData::Format format;
+	unsigned bytesPerFrame;
+	std::vector<float> filterStates; // one per block
+};
+
+WavStream::WavStream(File& file_)
+	: file(std::move(file_))
+{
+	file.munmap(); // possibly mapped to calculate the sha1sum
+
+	// Normally the sample data starts within the first few hundred bytes,
+	// only read more when there are large chunks before it.
+	auto parse = [&](size_t size) {
+		std::vector<uint8_t> header(size);
+		file.seek(0);
+		file.read(header.data(), header.size());
+		return WavData::parseHeader(header);
+	};
+	auto fileSize = file.getSize();
+	auto headerSize = std::min<size_t>(fileSize, 64 * 1024);
+	try {
+		format = parse(headerSize);
+	} catch (MSXException&) {
+		if (headerSize == fileSize) throw;
+		format = parse(fileSize);
+	}
+	bytesPerFrame = (format.bits / 8) * format.channels;
+	if ((format.dataOffset + size_t(format.length) * bytesPerFrame) > fileSize) {
+		throw MSXException("Read beyond end of wav file.");
+	}
+
+	DCFilter filter;
+	filter.setFreq(format.freq);
+	filterStates.reserve(format.length / BLOCK_SIZE + 1);
+	read(0, format.length, [&](unsigned i, int16_t x) {
+		if ((i % BLOCK_SIZE) == 0) filterStates.push_back(filter.getState());
+		(void)filter(x);
+	});
+}
+
+// Calls f(index, sample) for the (unfiltered) samples [first, first + num).
+template<typename F> void WavStream::read(size_t first, size_t num, F f) const
+{
+	constexpr size_t CHUNK = 16 * 1024; // in samples
+	std::vector<uint8_t> buf(std::min(num, CHUNK) * bytesPerFrame);
+	std::lock_guard lock(mutex);
+	file.seek(format.dataOffset + first * bytesPerFrame);
+	while (num) {
+		auto n = std::min(num, CHUNK);
+		file.read(buf.data(), n * bytesPerFrame);
+		const uint8_t* in = buf.data();
+		for (auto i : xrange(n)) {
+			int16_t x = (format.bits == 8)
+			          ? int16_t((int16_t(in[0]) - 0x80) << 8)
+			          : int16_t(in[0] | (in[1] << 8));
+			f(unsigned(first + i), x);
+			in += bytesPerFrame; // discard all but the first channel
+		}
+		first += n;
+		num -= n;
+	}
+}
+
+void WavStream::decode(unsigned block, int16_t* out) const
+{
+	assert(block < filterStates.size());
+	DCFilter filter;
+	filter.setFreq(format.freq);
+	filter.setState(filterStates[block]);
+	size_t first = size_t(block) * BLOCK_SIZE;
+	auto num = std::min<size_t>(BLOCK_SIZE, format.length - first);
+	read(first, num, [&](unsigned i, int16_t x) {
+		out[i - first] = filter(x);
+	});
+	std::fill(out + num, out + BLOCK_SIZE, int16_t(0));
+}
+
+
 class WavImageCache
 {
 public:
 	struct WavInfo {
-		WavData wav;
+		std::unique_ptr<WavStream> wav;
 		Sha1Sum sum;
 	};
 
@@ -44,7 +156,7 @@ public:
 
 	static WavImageCache& instance();
 	const WavInfo& get(const Filename& filename, FilePool& filePool);
-	void release(const WavData* wav);
+	void release(const WavStream* wav);
 
 private:
 	WavImageCache() = default;
@@ -78,7 +190,7 @@ const WavImageCache::WavInfo& WavImageCache::get(const Filename& filename, FileP
 		File file(filename);
 		Entry entry;
 		entry.info.sum = filePool.getSha1Sum(file);
-		entry.info.wav = WavData(std::move(file), DCFilter{});
+		entry.info.wav = std::make_unique<WavStream>(file);
 		it = cache.try_emplace(filename.getResolved(), std::move(entry)).first;
 	}
 	auto& entry = it->second;
@@ -87,10 +199,10 @@ const WavImageCache::WavInfo& WavImageCache::get(const Filename& filename, FileP
 
 }
 
-void WavImageCache::release(const WavData* wav)
+void WavImageCache::release(const WavStream* wav)
 {
 	// cache contains very few entries, so linear search is ok
-	auto it = ranges::find(cache, wav, [](auto& pr) { return &pr.second.info.wav; });
+	auto it = ranges::find(cache, wav, [](auto& pr) { return pr.second.info.wav.get(); });
 	assert(it != end(cache));
 	auto& entry = it->second;
 	--entry.refCount; // decrease reference count
@@ -104,8 +216,9 @@ void WavImageCache::release(const WavData* wav)
 WavImage::WavImage(const Filename& filename, FilePool& filePool)
 	: clock(EmuTime::zero())
 {
+	static_assert(std::tuple_size_v<decltype(CachedBlock::samples)> == WavStream::BLOCK_SIZE);
 	const auto& entry = WavImageCache::instance().get(filename, filePool);
-	wav = &entry.wav;
+	wav = entry.wav.get();
 	setSha1Sum(entry.sum);
 	clock.setFreq(wav->getFreq());
 }
@@ -129,10 +242,10 @@ int16_t WavImage::getSampleAt(EmuTime::param time) const
 	// work in openMSX (with sample-and-hold it didn't work).
 	auto [sample, x] = clock.getTicksTillAsIntFloat(time);
 	float p[4] = {
-		float(wav->getSample(unsigned(sample) - 1)), // intentional: underflow wraps to UINT_MAX
-		float(wav->getSample(sample + 0)),
-		float(wav->getSample(sample + 1)),
-		float(wav->getSample(sample + 2))
+		float(getSample(unsigned(sample) - 1)), // intentional: underflow wraps to UINT_MAX
+		float(getSample(sample + 0)),
+		float(getSample(sample + 1)),
+		float(getSample(sample + 2))
 	};
 	return Math::clipIntToShort(int(Math::cubicHermite(p + 1, x)));
 }
@@ -152,14 +265,55 @@ unsigned WavImage::getFrequency() const
 void WavImage::fillBuffer(unsigned pos, float** bufs, unsigned num) const
 {
 	if (pos < wav->getSize()) {
-		for (auto i : xrange(num)) {
-			bufs[0][i] = wav->getSample(pos + i);
+		unsigned i = 0;
+		while (i < num) {
+			unsigned p = pos + i;
+			if (p >= wav->getSize()) {
+				bufs[0][i++] = 0.0f;
+				continue;
+			}
+			const auto* block = getBlock(p / WavStream::BLOCK_SIZE);
+			unsigned offset = p % WavStream::BLOCK_SIZE;
+			unsigned n = std::min(num - i, WavStream::BLOCK_SIZE - offset);
+			for (auto j : xrange(n)) {
+				bufs[0][i + j] = block[offset + j];
+			}
+			i += n;
 		}
 	} else {
 		bufs[0] = nullptr;
 	}
 }
 
+int16_t WavImage::getSample(unsigned pos) const
+{
+	if (pos >= wav->getSize()) return 0;
+	return getBlock(pos / WavStream::BLOCK_SIZE)[pos % WavStream::BLOCK_SIZE];
+}
+
+const int16_t* WavImage::getBlock(unsigned block) const
+{
+	auto& mru = cache.front();
+	if (mru.block == block) return mru.samples.data();
+
+	auto it = ranges::find(cache, block, &CachedBlock::block);
+	if (it == end(cache)) {
+		// replace the least recently used block
+		it = std::prev(end(cache));
+		try {
+			wav->decode(block, it->samples.data());
+			it->block = block;
+		} catch (MSXException&) {
+			// the file became unreadable (e.g. it was truncated), play
+			// silence instead of aborting the emulation
+			ranges::fill(it->samples, int16_t(0));
+			it->block = block;
+		}
+	}
+	std::rotate(begin(cache), it, std::next(it)); // move to front
+	return cache.front().samples.data();
+}
+
 float WavImage::getAmplificationFactorImpl() const
 {
 	return 1.0f / 32768;
@@ -2,14 +2,15 @@
 #define WAVIMAGE_HH
 
 #include "CassetteImage.hh"
-#include "WavData.hh"
 #include "DynamicClock.hh"
+#include <array>
 #include <cstdint>
 
 namespace openmsx {
 
 class Filename;
 class FilePool;
+class WavStream;
 
 class WavImage final : public CassetteImage
 {
@@ -26,8 +27,21 @@ public:
 	[[nodiscard]] float getAmplificationFactorImpl() const override;
 
 private:
-	const WavData* wav;
+	[[nodiscard]] int16_t getSample(unsigned pos) const;
+	[[nodiscard]] const int16_t* getBlock(unsigned block) const;
+
+private:
+	const WavStream* wav;
 	DynamicClock clock;
+
+	// The few most recently decoded blocks, most recently used first.
+	// Enough for the cubic interpolation around a block boundary and for
+	// the sound generation that lags a bit behind the emulation.
+	struct CachedBlock {
+		unsigned block = unsigned(-1);
+		std::array<int16_t, 4096> samples; // WavStream::BLOCK_SIZE
+	};
+	mutable std::array<CachedBlock, 4> cache;
 };
 
 } // namespace openmsx
@@ -115,9 +115,7 @@ bool Completer::completeImpl(string& str, vector<string_view> matches,
 	out:
 	if (!expanded && output) {
 		// print all possibilities
-		for (auto& line : formatListInColumns(matches)) {
-			output->output(line);
-		}
+		output->outputLines(formatListInColumns(matches));
 	}
 	return false;
 }
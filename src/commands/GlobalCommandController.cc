@@ -40,13 +40,19 @@ GlobalCommandController::GlobalCommandController(
 	, helpCmd(*this)
 	, tabCompletionCmd(*this)
 	, updateCmd(*this)
+	, protocolCmd(*this)
 	, platformInfo(getOpenMSXInfoCommand())
 	, versionInfo (getOpenMSXInfoCommand())
 	, romInfoTopic(getOpenMSXInfoCommand())
+	, scriptProfiler(*this, eventDistributor)
 {
+	interpreter.setProfiler(&scriptProfiler);
 }
 
-GlobalCommandController::~GlobalCommandController() = default;
+GlobalCommandController::~GlobalCommandController()
+{
+	interpreter.setProfiler(nullptr);
+}
 
 GlobalCommandControllerBase::~GlobalCommandControllerBase()
 {
@@ -303,6 +309,7 @@ TclObject GlobalCommandController::executeCommand(
 	zstring_view command, CliConnection* connection_)
 {
 	ScopedAssign sa(connection, connection_);
+	ScriptProfiler::Scope scope(&scriptProfiler, "execute", command);
 	return interpreter.execute(command);
 }
 
@@ -545,11 +552,15 @@ CliConnection& GlobalCommandController::UpdateCmd::getConnection()
 void GlobalCommandController::UpdateCmd::execute(
 	span<const TclObject> tokens, TclObject& /*result*/)
 {
-	checkNumArgs(tokens, 3, Prefix{1}, "enable|disable type");
+	checkNumArgs(tokens, 3, Prefix{1}, "enable|disable type, or coalesce ms");
 	if (tokens[1] == "enable") {
 		getConnection().setUpdateEnable(getType(tokens[2]), true);
 	} else if (tokens[1] == "disable") {
 		getConnection().setUpdateEnable(getType(tokens[2]), false);
+	} else if (tokens[1] == "coalesce") {
+		int ms = tokens[2].getInt(getInterpreter());
+		if (ms < 0) throw CommandException("Time must be non-negative");
+		getConnection().setUpdateCoalescing(unsigned(ms));
 	} else {
 		throw SyntaxError();
 	}
@@ -557,7 +568,8 @@ void GlobalCommandController::UpdateCmd::execute(
 
 string GlobalCommandController::UpdateCmd::help(span<const TclObject> /*tokens*/) const
 {
-	return "Enable or disable update events for external applications. See doc/openmsx-control-xml.txt.";
+	return "Enable or disable update events for external applications. See doc/openmsx-control-xml.txt.\n"
+	       "'openmsx_update coalesce <ms>' only sends the last value of each update at most once per <ms> milliseconds (0 sends all updates immediately).";
 }
 
 void GlobalCommandController::UpdateCmd::tabCompletion(vector<string>& tokens) const
@@ -565,17 +577,58 @@ void GlobalCommandController::UpdateCmd::tabCompletion(vector<string>& tokens) c
 	switch (tokens.size()) {
 	case 2: {
 		using namespace std::literals;
-		static constexpr std::array ops = {"enable"sv, "disable"sv};
+		static constexpr std::array ops = {"enable"sv, "disable"sv, "coalesce"sv};
 		completeString(tokens, ops);
 		break;
 	}
 	case 3:
-		completeString(tokens, CliComm::getUpdateStrings());
+		if (tokens[1] != "coalesce") {
+			completeString(tokens, CliComm::getUpdateStrings());
+		}
 		break;
 	}
 }
 
 
+// class ProtocolCmd
+
+GlobalCommandController::ProtocolCmd::ProtocolCmd(CommandController& commandController_)
+	: Command(commandController_, "openmsx_protocol")
+{
+}
+
+void GlobalCommandController::ProtocolCmd::execute(
+	span<const TclObject> tokens, TclObject& /*result*/)
+{
+	checkNumArgs(tokens, 2, "binary");
+	if (tokens[1] != "binary") throw SyntaxError();
+	auto& controller = OUTER(GlobalCommandController, protocolCmd);
+	auto* connection = controller.getConnection();
+	if (!connection) {
+		throw CommandException("This command only makes sense when "
+		                       "it's used from an external application.");
+	}
+	connection->requestBinaryProtocol();
+}
+
+string GlobalCommandController::ProtocolCmd::help(span<const TclObject> /*tokens*/) const
+{
+	return "openmsx_protocol binary\n"
+	       "  For external applications: after the reply to this command, switch "
+	       "this connection from XML to length-prefixed binary frames. "
+	       "See doc/manual/openmsx-control.html.";
+}
+
+void GlobalCommandController::ProtocolCmd::tabCompletion(vector<string>& tokens) const
+{
+	if (tokens.size() == 2) {
+		using namespace std::literals;
+		static constexpr std::array ops = {"binary"sv};
+		completeString(tokens, ops);
+	}
+}
+
+
 // Platform info
 
 GlobalCommandController::PlatformInfo::PlatformInfo(InfoCommand& openMSXInfoCommand_)
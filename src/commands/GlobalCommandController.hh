@@ -9,6 +9,7 @@
 #include "HotKey.hh"
 #include "SettingsConfig.hh"
 #include "RomInfoTopic.hh"
+#include "ScriptProfiler.hh"
 #include "TclObject.hh"
 #include "hash_map.hh"
 #include "xxhash.hh"
@@ -130,6 +131,13 @@ private:
 		CliConnection& getConnection();
 	} updateCmd;
 
+	struct ProtocolCmd final : Command {
+		explicit ProtocolCmd(CommandController& commandController);
+		void execute(span<const TclObject> tokens, TclObject& result) override;
+		[[nodiscard]] std::string help(span<const TclObject> tokens) const override;
+		void tabCompletion(std::vector<std::string>& tokens) const override;
+	} protocolCmd;
+
 	struct PlatformInfo final : InfoTopic {
 		explicit PlatformInfo(InfoCommand& openMSXInfoCommand);
 		void execute(span<const TclObject> tokens,
@@ -145,6 +153,7 @@ private:
 	} versionInfo;
 
 	RomInfoTopic romInfoTopic;
+	ScriptProfiler scriptProfiler;
 
 	struct NameFromProxy {
 		template<typename Pair>
@@ -6,6 +6,7 @@
 #include "MSXMotherBoard.hh"
 #include "Setting.hh"
 #include "InterpreterOutput.hh"
+#include "ScriptProfiler.hh"
 #include "MSXCPUInterface.hh"
 #include "FileOperations.hh"
 #include "ranges.hh"
@@ -175,6 +176,8 @@ int Interpreter::commandProc(ClientData clientData, Tcl_Interp* interp,
 			objc);
 		int res = TCL_OK;
 		TclObject result;
+		ScriptProfiler::Scope scope(command.getInterpreter().getProfiler(),
+		                            "command", tokens[0].getString());
 		try {
 			if (!command.isAllowedInEmptyMachine()) {
 				if (auto* controller =
@@ -13,6 +13,7 @@ namespace openmsx {
 class Command;
 class BaseSetting;
 class InterpreterOutput;
+class ScriptProfiler;
 
 class Interpreter
 {
@@ -24,6 +25,8 @@ public:
 	~Interpreter();
 
 	void setOutput(InterpreterOutput* output_) { output = output_; }
+	void setProfiler(ScriptProfiler* profiler_) { profiler = profiler_; }
+	[[nodiscard]] ScriptProfiler* getProfiler() const { return profiler; }
 
 	void init(const char* programName);
 	bool hasCommand(zstring_view name) const;
@@ -66,6 +69,7 @@ private:
 	static Tcl_ChannelType channelType;
 	Tcl_Interp* interp;
 	InterpreterOutput* output;
+	ScriptProfiler* profiler = nullptr;
 
 	friend class TclObject;
 };
@@ -1,6 +1,8 @@
 #ifndef INTERPRETEROUTPUT_HH
 #define INTERPRETEROUTPUT_HH
 
+#include "span.hh"
+#include <string>
 #include <string_view>
 
 namespace openmsx {
@@ -9,6 +11,12 @@ class InterpreterOutput
 {
 public:
 	virtual void output(std::string_view text) = 0;
+	/** Output many lines at once (each without trailing newline). This
+	  * allows the implementation to e.g. skip lines that would anyway
+	  * immediately scroll out of view. */
+	virtual void outputLines(span<const std::string> lines) {
+		for (const auto& line : lines) output(line);
+	}
 	[[nodiscard]] virtual unsigned getOutputColumns() const = 0;
 
 protected:
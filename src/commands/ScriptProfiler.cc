@@ -0,0 +1,193 @@
+#include "ScriptProfiler.hh"
+#include "CliComm.hh"
+#include "CommandController.hh"
+#include "CommandException.hh"
+#include "Event.hh"
+#include "EventDistributor.hh"
+#include "TclObject.hh"
+#include "Timer.hh"
+#include "outer.hh"
+#include "ranges.hh"
+#include "strCat.hh"
+#include <vector>
+
+namespace openmsx {
+
+ScriptProfiler::ScriptProfiler(CommandController& commandController,
+                               EventDistributor& eventDistributor_)
+	: cmd(commandController)
+	, eventDistributor(eventDistributor_)
+{
+	eventDistributor.registerEventListener(EventType::FINISH_FRAME, *this);
+}
+
+ScriptProfiler::~ScriptProfiler()
+{
+	eventDistributor.unregisterEventListener(EventType::FINISH_FRAME, *this);
+}
+
+// Only the command name (first word) is used, otherwise e.g. each
+// 'after time' callback with different arguments gets its own entry.
+[[nodiscard]] static std::string_view getCommandName(std::string_view command)
+{
+	auto first = command.find_first_not_of(" \t\n");
+	if (first == std::string_view::npos) return {};
+	command.remove_prefix(first);
+	return command.substr(0, command.find_first_of(" \t\n;"));
+}
+
+ScriptProfiler::Scope::Scope(
+		ScriptProfiler* profiler_, std::string_view kind, std::string_view command)
+{
+	if (!profiler_ || !profiler_->running) return;
+	profiler = profiler_;
+	name = strCat(kind, ' ', getCommandName(command));
+	++profiler->depth;
+	start = Timer::getTime();
+}
+
+ScriptProfiler::Scope::~Scope()
+{
+	if (!profiler) return;
+	auto duration = Timer::getTime() - start;
+	--profiler->depth;
+	profiler->record(name, duration);
+}
+
+void ScriptProfiler::record(const std::string& name, uint64_t duration)
+{
+	if (!running) return; // stopped during this invocation
+	auto& s = stats[name];
+	++s.calls;
+	s.total += duration;
+	s.max = std::max(s.max, duration);
+	if (depth == 0) frameTime += duration;
+}
+
+void ScriptProfiler::start(uint64_t budget_)
+{
+	budget = budget_;
+	running = true;
+}
+
+void ScriptProfiler::stop()
+{
+	if (!running) return;
+	running = false;
+	if (numFrames) {
+		cmd.getCommandController().getCliComm().printInfo(
+			"Script profile: ", numFrames, " frames, average ",
+			(totalFrameTime / numFrames), "us per frame, maximum ",
+			maxFrameTime, "us, ", overBudget, " frames over the budget of ",
+			budget, "us.");
+	}
+}
+
+void ScriptProfiler::clear()
+{
+	stats.clear();
+	frameTime = 0;
+	numFrames = 0;
+	totalFrameTime = 0;
+	maxFrameTime = 0;
+	overBudget = 0;
+}
+
+void ScriptProfiler::getStatus(TclObject& result) const
+{
+	result.addDictKeyValues(
+		"running", running,
+		"budget", int64_t(budget),
+		"frames", int64_t(numFrames),
+		"average", int64_t(numFrames ? (totalFrameTime / numFrames) : 0),
+		"maximum", int64_t(maxFrameTime),
+		"over_budget", int64_t(overBudget));
+}
+
+void ScriptProfiler::getReport(TclObject& result, unsigned maxEntries) const
+{
+	std::vector<std::pair<std::string_view, Stats>> sorted(stats.begin(), stats.end());
+	ranges::sort(sorted, [](auto& x, auto& y) { return x.second.total > y.second.total; });
+	if (sorted.size() > maxEntries) sorted.resize(maxEntries);
+	for (const auto& [name, s] : sorted) {
+		result.addListElement(makeTclList(
+			name, int64_t(s.calls), int64_t(s.total), int64_t(s.max)));
+	}
+}
+
+int ScriptProfiler::signalEvent(const Event& /*event*/) noexcept
+{
+	if (!running) return 0;
+	++numFrames;
+	totalFrameTime += frameTime;
+	maxFrameTime = std::max(maxFrameTime, frameTime);
+	if (frameTime > budget) ++overBudget;
+	frameTime = 0;
+	return 0;
+}
+
+
+// class ScriptProfiler::Cmd
+
+ScriptProfiler::Cmd::Cmd(CommandController& commandController_)
+	: Command(commandController_, "script_profile")
+{
+}
+
+void ScriptProfiler::Cmd::execute(span<const TclObject> tokens, TclObject& result)
+{
+	checkNumArgs(tokens, AtLeast{2}, "subcommand ?arg ...?");
+	auto& profiler = OUTER(ScriptProfiler, cmd);
+	executeSubCommand(tokens[1].getString(),
+		"start", [&]{
+			checkNumArgs(tokens, Between{2, 3}, "?budget?");
+			double budget = (tokens.size() == 3)
+			              ? tokens[2].getDouble(getInterpreter())
+			              : 5.0;
+			if (budget <= 0.0) {
+				throw CommandException("Budget must be positive");
+			}
+			profiler.start(uint64_t(budget * 1000.0));
+		},
+		"stop",   [&]{ profiler.stop(); },
+		"clear",  [&]{ profiler.clear(); },
+		"status", [&]{ profiler.getStatus(result); },
+		"report", [&]{
+			checkNumArgs(tokens, Between{2, 3}, "?count?");
+			unsigned count = (tokens.size() == 3)
+			               ? tokens[2].getInt(getInterpreter())
+			               : 100;
+			profiler.getReport(result, count);
+		});
+}
+
+std::string ScriptProfiler::Cmd::help(span<const TclObject> /*tokens*/) const
+{
+	return "script_profile <subcommand> [<arguments>]\n"
+	       "  Measure the (real) time spent in Tcl scripts, to find scripts "
+	       "that slow down openMSX.\n"
+	       "  Possible subcommands are:\n"
+	       "    start [<budget>]  start measuring, <budget> is the allowed script time\n"
+	       "                      per frame in milliseconds (default 5)\n"
+	       "    stop              stop measuring and print a summary, results are kept\n"
+	       "    clear             remove all results\n"
+	       "    status            returns a dict with the per-frame totals (in microseconds)\n"
+	       "    report [<count>]  returns the <count> (default 100) most expensive entries,\n"
+	       "                      as a list of {name calls total max} elements (times in\n"
+	       "                      microseconds). The name is the kind of invocation\n"
+	       "                      (execute, command, after, callback or bind) followed\n"
+	       "                      by the command name.\n";
+}
+
+void ScriptProfiler::Cmd::tabCompletion(std::vector<std::string>& tokens) const
+{
+	if (tokens.size() == 2) {
+		using namespace std::literals;
+		static constexpr std::array subCmds = {
+			"start"sv, "stop"sv, "clear"sv, "status"sv, "report"sv,
+		};
+		completeString(tokens, subCmds);
+	}
+}
+
+} // namespace openmsx
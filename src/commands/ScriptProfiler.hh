@@ -0,0 +1,93 @@
+#ifndef SCRIPTPROFILER_HH
+#define SCRIPTPROFILER_HH
+
+#include "Command.hh"
+#include "EventListener.hh"
+#include "PerfTimers.hh"
+#include "hash_map.hh"
+#include "xxhash.hh"
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace openmsx {
+
+class CommandController;
+class EventDistributor;
+class TclObject;
+
+/** Measures the (wall clock) time spent in Tcl scripts.
+  *
+  * Time is attributed to the places where scripts are entered: commands
+  * executed from the console or an external connection, 'after' callbacks,
+  * setting/watchpoint callbacks (TclCallback), key bindings and the
+  * openMSX commands invoked from Tcl. These measurements are inclusive (a
+  * callback that executes openMSX commands is charged for those as well).
+  * Only the outermost invocations are added to the per-frame total, which
+  * is checked against a budget at the end of each frame.
+  *
+  * When not running, the only cost is checking a flag per invocation.
+  */
+class ScriptProfiler final : private EventListener
+{
+public:
+	ScriptProfiler(CommandController& commandController,
+	               EventDistributor& eventDistributor);
+	~ScriptProfiler();
+
+	/** Measures the lifetime of this object. */
+	class Scope {
+	public:
+		Scope(ScriptProfiler* profiler, std::string_view kind, std::string_view command);
+		~Scope();
+		Scope(const Scope&) = delete;
+		Scope& operator=(const Scope&) = delete;
+	private:
+		PerfTimers::Scope perf{PerfTimers::TCL};
+		ScriptProfiler* profiler = nullptr; // only set when running
+		std::string name;
+		uint64_t start = 0;
+	};
+
+	[[nodiscard]] bool isRunning() const { return running; }
+
+private:
+	void start(uint64_t budget);
+	void stop();
+	void clear();
+	void record(const std::string& name, uint64_t duration);
+	void getStatus(TclObject& result) const;
+	void getReport(TclObject& result, unsigned maxEntries) const;
+
+	// EventListener
+	int signalEvent(const Event& event) noexcept override;
+
+private:
+	struct Cmd final : Command {
+		explicit Cmd(CommandController& commandController);
+		void execute(span<const TclObject> tokens, TclObject& result) override;
+		[[nodiscard]] std::string help(span<const TclObject> tokens) const override;
+		void tabCompletion(std::vector<std::string>& tokens) const override;
+	} cmd;
+
+	struct Stats {
+		uint64_t calls = 0;
+		uint64_t total = 0; // all times in us
+		uint64_t max = 0;
+	};
+	hash_map<std::string, Stats, XXHasher> stats;
+
+	EventDistributor& eventDistributor;
+	uint64_t budget = 5000;
+	uint64_t frameTime = 0; // outermost invocations in the current frame
+	uint64_t numFrames = 0;
+	uint64_t totalFrameTime = 0;
+	uint64_t maxFrameTime = 0;
+	uint64_t overBudget = 0;
+	unsigned depth = 0;
+	bool running = false;
+};
+
+} // namespace openmsx
+
+#endif
@@ -2,6 +2,8 @@
 #include "CommandController.hh"
 #include "CliComm.hh"
 #include "CommandException.hh"
+#include "Interpreter.hh"
+#include "ScriptProfiler.hh"
 #include <iostream>
 #include <memory>
 
@@ -79,8 +81,11 @@ TclObject TclCallback::execute(std::string_view arg1, std::string_view arg2)
 
 TclObject TclCallback::executeCommon(TclObject& command)
 {
+	auto& interp = callbackSetting.getInterpreter();
+	ScriptProfiler::Scope scope(interp.getProfiler(), "callback",
+	                            command.empty() ? std::string_view{} : *command.begin());
 	try {
-		return command.executeCommand(callbackSetting.getInterpreter());
+		return command.executeCommand(interp);
 	} catch (CommandException& e) {
 		auto message = strCat(
 			"Error executing callback function \"",
@@ -115,6 +115,17 @@ zstring_view TclObject::getString() const
 	return zstring_view(buf, length);
 }
 
+span<uint8_t> TclObject::allocateBinary(size_t size)
+{
+	// Start from a fresh (empty) object, converting the current value to a
+	// byte array would be wasted work.
+	Tcl_DecrRefCount(obj);
+	obj = Tcl_NewObj();
+	Tcl_IncrRefCount(obj);
+	auto* buf = Tcl_SetByteArrayLength(obj, int(size));
+	return {buf, size};
+}
+
 span<const uint8_t> TclObject::getBinary() const
 {
 	int length;
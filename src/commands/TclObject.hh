@@ -12,6 +12,7 @@
 #include <iterator>
 #include <optional>
 #include <string_view>
+#include <vector>
 
 struct Tcl_Obj;
 
@@ -138,6 +139,12 @@ public:
 		addListElementsImpl({newObj(std::forward<Args>(args))...});
 	}
 
+	/** Replace this object by a byte array of the given size and return
+	  * its (uninitialized) content. Lets the caller fill in binary data
+	  * without first building it in a temporary buffer.
+	  */
+	[[nodiscard]] span<uint8_t> allocateBinary(size_t size);
+
 	// add key-value pair(s) to a Tcl dict
 	template<typename Key, typename Value>
 	void addDictKeyValue(const Key& key, const Value& value) {
@@ -216,6 +223,9 @@ private:
 	[[nodiscard]] static Tcl_Obj* newObj(unsigned u) {
 		return Tcl_NewIntObj(u);
 	}
+	[[nodiscard]] static Tcl_Obj* newObj(int64_t i) {
+		return Tcl_NewWideIntObj(i);
+	}
 	[[nodiscard]] static Tcl_Obj* newObj(float f) {
 		return Tcl_NewDoubleObj(double(f));
 	}
@@ -247,6 +257,9 @@ private:
 	void assign(unsigned u) {
 		Tcl_SetIntObj(obj, u);
 	}
+	void assign(int64_t i) {
+		Tcl_SetWideIntObj(obj, i);
+	}
 	void assign(float f) {
 		Tcl_SetDoubleObj(obj, double(f));
 	}
@@ -259,16 +272,28 @@ private:
 
 	template<typename ITER>
 	void addListElementsImpl(ITER first, ITER last, std::input_iterator_tag) {
+		// Collect all elements first, so that the list only grows once.
+		std::vector<Tcl_Obj*> objv;
 		for (ITER it = first; it != last; ++it) {
-			addListElement(*it);
+			objv.push_back(newObj(*it));
 		}
+		if (objv.empty()) return;
+		addListElementsImpl(int(objv.size()), objv.data());
 	}
 	template<typename ITER>
 	void addListElementsImpl(ITER first, ITER last, std::random_access_iterator_tag) {
 		auto objc = last - first;
 		if (objc == 0) return; // because 0-length VLAs are not allowed (but gcc/clang allow it as an extension)
+		auto convert = [](const auto& t) { return newObj(t); };
+		if (objc > 1024) {
+			// don't put huge arrays on the stack
+			std::vector<Tcl_Obj*> objv(objc);
+			std::transform(first, last, objv.data(), convert);
+			addListElementsImpl(int(objc), objv.data());
+			return;
+		}
 		VLA(Tcl_Obj*, objv, objc);
-		std::transform(first, last, objv, [](const auto& t) { return newObj(t); });
+		std::transform(first, last, objv, convert);
 		addListElementsImpl(objc, objv);
 	}
 
@@ -7,14 +7,19 @@
 #include "MSXCPUInterface.hh"
 #include "CommandController.hh"
 #include "DeviceFactory.hh"
+#include "Rom.hh"
+#include "PerfTimers.hh"
 #include "TclArgParser.hh"
+#include "hash_map.hh"
 #include "serialize.hh"
 #include "serialize_stl.hh"
 #include "unreachable.hh"
 #include "xrange.hh"
+#include "xxhash.hh"
 #include <cassert>
 #include <iostream>
 #include <memory>
+#include <vector>
 
 using std::string;
 
@@ -217,15 +222,46 @@ const XMLElement& HardwareConfig::getDevicesElem() const
 	return getConfig().getChild("devices");
 }
 
-static void loadHelper(XMLDocument& doc, std::string filename)
+static void loadHelper(XMLDocument& doc, const std::string& filename)
 {
-	try {
-		doc.load(filename, "msxconfig2.dtd");
-	} catch (XMLException& e) {
-		throw MSXException(
-			"Loading of hardware configuration failed: ",
-			e.getMessage());
+	PerfTimers::Scope perf(PerfTimers::CONFIG);
+	// Machine and extension configs are loaded repeatedly (switching
+	// machines, re-inserting extensions). Parse each file only once (per
+	// modification time) and let the HardwareConfig objects share the
+	// strings of that parsed document. Those documents are never deleted,
+	// because an older version might still be in use.
+	struct Cached {
+		time_t modificationDate;
+		std::unique_ptr<XMLDocument> doc;
+	};
+	static hash_map<std::string, Cached, XXHasher> cache;
+	static std::vector<std::unique_ptr<XMLDocument>> retired;
+
+	FileOperations::Stat st;
+	if (!FileOperations::getStat(filename, st)) {
+		throw MSXException("Loading of hardware configuration failed: "
+		                   "can't stat ", filename);
+	}
+	auto date = FileOperations::getModificationDate(st);
+	auto* cached = lookup(cache, filename);
+	if (!cached || (cached->modificationDate != date)) {
+		auto newDoc = std::make_unique<XMLDocument>(8192);
+		try {
+			newDoc->load(filename, "msxconfig2.dtd");
+		} catch (XMLException& e) {
+			throw MSXException(
+				"Loading of hardware configuration failed: ",
+				e.getMessage());
+		}
+		if (cached) {
+			retired.push_back(std::move(cached->doc));
+			*cached = Cached{date, std::move(newDoc)};
+		} else {
+			cached = &cache.emplace_noDuplicateCheck(
+				filename, Cached{date, std::move(newDoc)})->second;
+		}
 	}
+	doc.loadShared(*cached->doc);
 }
 
 static string getFilename(std::string_view type, std::string_view name)
@@ -350,6 +386,8 @@ byte HardwareConfig::parseSlotMap() const
 
 void HardwareConfig::createDevices()
 {
+	// Load the ROM files in parallel while the devices are being created.
+	RomPrefetch prefetch(getDevicesElem(), getFileContext());
 	createDevices(getDevicesElem(), nullptr, nullptr);
 }
 
@@ -6,6 +6,7 @@
 #include "FileException.hh"
 #include "FileOperations.hh"
 #include "MemBuffer.hh"
+#include "PerfTimers.hh"
 #include "CliComm.hh"
 #include "HotKey.hh"
 #include "CommandException.hh"
@@ -87,6 +88,7 @@ SettingsConfig::~SettingsConfig()
 
 void SettingsConfig::loadSetting(const FileContext& context, std::string_view filename)
 {
+	PerfTimers::Scope perf(PerfTimers::CONFIG);
 	string resolved = context.resolve(filename);
 
 	MemBuffer<char> buf;
@@ -325,6 +325,7 @@ void XMLDocument::load(const std::string& filename, std::string_view systemID)
 		File file(filename);
 		auto size = file.getSize();
 		buf.resize(size + rapidsax::EXTRA_BUFFER_SPACE);
+		AllocCounters::add(AllocCounters::XML, size + rapidsax::EXTRA_BUFFER_SPACE);
 		file.read(buf.data(), size);
 		buf[size] = 0;
 	} catch (FileException& e) {
@@ -352,7 +353,8 @@ void XMLDocument::load(const std::string& filename, std::string_view systemID)
 	}
 }
 
-XMLElement* XMLDocument::loadElement(MemInputArchive& ar)
+template<typename Archive>
+XMLElement* XMLDocument::loadElement(Archive& ar)
 {
 	auto name = ar.loadStr();
 	if (name.empty()) return nullptr; // should only happen for empty document
@@ -391,7 +393,8 @@ void XMLDocument::serialize(MemInputArchive& ar, unsigned /*version*/)
 	root = loadElement(ar);
 }
 
-static void saveElement(MemOutputArchive& ar, const XMLElement& elem)
+template<typename Archive> // MemOutputArchive or BinaryOutputArchive
+static void saveElement(Archive& ar, const XMLElement& elem)
 {
 	ar.save(elem.getName());
 
@@ -422,6 +425,21 @@ void XMLDocument::serialize(MemOutputArchive& ar, unsigned /*version*/)
 	}
 }
 
+void XMLDocument::serialize(BinaryInputArchive& ar, unsigned /*version*/)
+{
+	root = loadElement(ar);
+}
+
+void XMLDocument::serialize(BinaryOutputArchive& ar, unsigned /*version*/)
+{
+	if (root) {
+		saveElement(ar, *root);
+	} else {
+		std::string_view empty;
+		ar.save(empty);
+	}
+}
+
 XMLElement* XMLDocument::clone(const XMLElement& inElem)
 {
 	auto* outElem = allocateElement(allocateString(inElem.getName()));
@@ -449,6 +467,33 @@ XMLElement* XMLDocument::clone(const XMLElement& inElem)
 	return outElem;
 }
 
+void XMLDocument::loadShared(const XMLDocument& source)
+{
+	assert(!root);
+	if (source.root) root = cloneShared(*source.root);
+}
+
+XMLElement* XMLDocument::cloneShared(const XMLElement& inElem)
+{
+	auto* outElem = allocateElement(inElem.name, inElem.data);
+
+	auto** attrPtr = &outElem->firstAttribute;
+	for (const auto& inAttr : inElem.getAttributes()) {
+		auto* outAttr = allocateAttribute(inAttr.name, inAttr.value);
+		*attrPtr = outAttr;
+		attrPtr = &outAttr->nextAttribute;
+	}
+
+	auto** childPtr = &outElem->firstChild;
+	for (const auto& inChild : inElem.getChildren()) {
+		auto* outChild = cloneShared(inChild);
+		*childPtr = outChild;
+		childPtr = &outChild->nextSibling;
+	}
+
+	return outElem;
+}
+
 void XMLDocument::serialize(XmlInputArchive& ar, unsigned /*version*/)
 {
 	const auto* current = ar.currentElement();
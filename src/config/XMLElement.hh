@@ -1,6 +1,7 @@
 #ifndef XMLELEMENT_HH
 #define XMLELEMENT_HH
 
+#include "AllocCounters.hh"
 #include "MemBuffer.hh"
 #include "serialize_meta.hh"
 #include <cassert>
@@ -260,10 +261,13 @@ public:
 	}
 
 	// Create an empty XMLDocument (root == nullptr).  All constructor
-	// arguments are delegated to the monotonic allocator constructor.
+	// arguments are delegated to the monotonic allocator constructor. When
+	// that allocator needs more memory it's counted as an XML allocation
+	// (see AllocCounters).
 	template<typename ...Args>
 	XMLDocument(Args&& ...args)
-		: allocator(std::forward<Args>(args)...) {}
+		: allocator(std::forward<Args>(args)...,
+		            AllocCounters::getResource(AllocCounters::XML)) {}
 
 	// Load/parse an xml file. Requires that the document is still empty.
 	void load(const std::string& filename, std::string_view systemID);
@@ -294,15 +298,24 @@ public:
 
 	void load(OldXMLElement& elem); // bw compat
 
+	// Make this (still empty) document a copy of 'source'. Only the
+	// element and attribute objects are copied, the strings are shared.
+	// So 'source' must outlive this document and must not be modified.
+	void loadShared(const XMLDocument& source);
+
 	void serialize(MemInputArchive&  ar, unsigned version);
 	void serialize(MemOutputArchive& ar, unsigned version);
 	void serialize(XmlInputArchive&  ar, unsigned version);
 	void serialize(XmlOutputArchive& ar, unsigned version);
+	void serialize(BinaryInputArchive&  ar, unsigned version);
+	void serialize(BinaryOutputArchive& ar, unsigned version);
 
 private:
-	XMLElement* loadElement(MemInputArchive& ar);
+	template<typename Archive> // MemInputArchive or BinaryInputArchive
+	XMLElement* loadElement(Archive& ar);
 	XMLElement* clone(const XMLElement& inElem);
 	XMLElement* clone(const OldXMLElement& elem);
+	XMLElement* cloneShared(const XMLElement& inElem);
 
 private:
 	XMLElement* root = nullptr;
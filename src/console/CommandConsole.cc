@@ -16,6 +16,7 @@
 #include "unreachable.hh"
 #include "utf8_unchecked.hh"
 #include "StringOp.hh"
+#include "ranges.hh"
 #include "ScopedAssign.hh"
 #include "view.hh"
 #include "xrange.hh"
@@ -32,6 +33,7 @@ namespace openmsx {
 
 ConsoleLine::ConsoleLine(string line_, uint32_t rgb)
 	: line(std::move(line_))
+	, chars(utf8::unchecked::size(line))
 	, chunks(1, {rgb, 0})
 {
 }
@@ -40,11 +42,7 @@ void ConsoleLine::addChunk(string_view text, uint32_t rgb)
 {
 	chunks.emplace_back(Chunk{rgb, line.size()});
 	line.append(text.data(), text.size());
-}
-
-size_t ConsoleLine::numChars() const
-{
-	return utf8::unchecked::size(line);
+	chars += utf8::unchecked::size(text);
 }
 
 uint32_t ConsoleLine::chunkColor(size_t i) const
@@ -375,6 +373,17 @@ void CommandConsole::output(string_view text)
 	print(text);
 }
 
+void CommandConsole::outputLines(span<const std::string> newLines)
+{
+	// only the last lines remain in the history
+	if (newLines.size() > LINESHISTORY) {
+		newLines = newLines.last(LINESHISTORY);
+	}
+	for (const auto& line : newLines) {
+		newLineConsole(ConsoleLine(line));
+	}
+}
+
 unsigned CommandConsole::getOutputColumns() const
 {
 	return getColumns();
@@ -382,6 +391,15 @@ unsigned CommandConsole::getOutputColumns() const
 
 void CommandConsole::print(string_view text, unsigned rgb)
 {
+	// When a script prints a lot of output at once, don't bother storing
+	// the lines that would immediately scroll out of the history again.
+	auto numLines = size_t(ranges::count(text, '\n')) +
+	                (StringOp::endsWith(text, '\n') ? 0 : 1);
+	for (auto skip = numLines - std::min<size_t>(numLines, LINESHISTORY);
+	     skip; --skip) {
+		text = text.substr(text.find('\n') + 1);
+	}
+
 	while (true) {
 		auto pos = text.find('\n');
 		newLineConsole(ConsoleLine(string(text.substr(0, pos)), rgb));
@@ -35,7 +35,7 @@ public:
 
 	/** Get the number of UTF8 characters in this line. So multi-byte
 	  * characters are counted as a single character. */
-	[[nodiscard]] size_t numChars() const;
+	[[nodiscard]] size_t numChars() const { return chars; }
 	/** Get the total string, ignoring color differences. */
 	[[nodiscard]] const std::string& str() const { return line; }
 
@@ -51,6 +51,7 @@ public:
 
 private:
 	std::string line;
+	size_t chars = 0; // cached, used a lot while rendering
 	struct Chunk {
 		uint32_t rgb;
 		std::string_view::size_type pos;
@@ -83,6 +84,7 @@ public:
 private:
 	// InterpreterOutput
 	void output(std::string_view text) override;
+	void outputLines(span<const std::string> lines) override;
 	[[nodiscard]] unsigned getOutputColumns() const override;
 
 	// EventListener
@@ -374,8 +374,10 @@ void OSDConsoleRenderer::insertInCache(
 	std::string text, uint32_t rgb, std::unique_ptr<BaseImage> image,
 	unsigned width)
 {
-	constexpr unsigned MAX_TEXT_CACHE_SIZE = 250;
-	if (textCache.size() == MAX_TEXT_CACHE_SIZE) {
+	// Should be big enough to hold all (differently colored) chunks of
+	// the visible console lines, otherwise every frame re-renders all.
+	auto maxSize = std::max<size_t>(250, 4 * console.getRows());
+	while (textCache.size() >= maxSize) {
 		// flush the least recently used entry
 		if (auto it = std::prev(std::end(textCache)); it == cacheHint) {
 			cacheHint = begin(textCache);
@@ -114,7 +114,7 @@ void OSDGUI::OSDCommand::destroy(span<const TclObject> tokens, TclObject& result
 		throw CommandException("Can't destroy the top widget.");
 	}
 
-	if (widget->isVisible()) {
+	if (widget->isRecursiveVisible()) {
 		gui.refresh();
 	}
 	top.removeName(*widget);
@@ -159,8 +159,10 @@ void OSDGUI::OSDCommand::configure(span<const TclObject> tokens, TclObject& /*re
 {
 	checkNumArgs(tokens, AtLeast{3}, "name ?property value ...?");
 	auto& widget = getWidget(tokens[2].getString());
+	// also repaint when the widget (or its children) just became hidden
+	bool wasVisible = widget.isRecursiveVisible();
 	configure(widget, tokens.subspan(3));
-	if (widget.isVisible()) {
+	if (wasVisible || widget.isRecursiveVisible()) {
 		auto& gui = OUTER(OSDGUI, osdCommand);
 		gui.refresh();
 	}
@@ -29,7 +29,9 @@ SDLOSDGUILayer::SDLOSDGUILayer(OSDGUI& gui_)
 void SDLOSDGUILayer::paint(OutputSurface& output)
 {
 	auto& top = getGUI().getTopWidget();
-	top.paintSDLRecursive(output);
+	if (top.isRecursiveVisible()) {
+		top.paintSDLRecursive(output);
+	}
 	top.showAllErrors();
 }
 
@@ -45,7 +47,9 @@ GLOSDGUILayer::GLOSDGUILayer(OSDGUI& gui_)
 void GLOSDGUILayer::paint(OutputSurface& output)
 {
 	auto& top = getGUI().getTopWidget();
-	top.paintGLRecursive(output);
+	if (top.isRecursiveVisible()) {
+		top.paintGLRecursive(output);
+	}
 	top.showAllErrors();
 }
 
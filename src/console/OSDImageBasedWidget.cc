@@ -105,7 +105,12 @@ void OSDImageBasedWidget::setRGBA(const uint32_t newRGBA[4])
 		// not changed
 		return;
 	}
-	invalidateLocal();
+	bool onlyAlpha = ranges::all_of(xrange(4), [&](auto i) {
+		return (rgba[i] & 0xffffff00) == (newRGBA[i] & 0xffffff00);
+	});
+	if (!onlyAlpha || isAlphaInImage()) {
+		invalidateLocal();
+	}
 	for (auto i : xrange(4)) {
 		rgba[i] = newRGBA[i];
 	}
@@ -36,6 +36,9 @@ protected:
 	void paintGL (OutputSurface& output) override;
 	[[nodiscard]] virtual std::unique_ptr<BaseImage> createSDL(OutputSurface& output) = 0;
 	[[nodiscard]] virtual std::unique_ptr<BaseImage> createGL (OutputSurface& output) = 0;
+	// Is the alpha component of 'rgba' part of the created image, or is
+	// it only applied while drawing?
+	[[nodiscard]] virtual bool isAlphaInImage() const { return true; }
 
 	void setError(std::string message);
 	[[nodiscard]] bool hasError() const { return error; }
@@ -149,6 +149,20 @@ vec2 OSDRectangle::getSize(const OutputSurface& output) const
 	//std::cout << "rectangle getWH " << getName() << "  " << width << " x " << height << '\n';
 }
 
+bool OSDRectangle::isTransparent() const
+{
+	return imageName.empty() &&
+	       hasConstantAlpha() && ((getRGBA(0) & 0xff) == 0) &&
+	       (((borderRGBA & 0xFF) == 0) || (borderSize == 0.0f));
+}
+
+bool OSDRectangle::isVisible() const
+{
+	// A rectangle that only exists as a parent for sub-widgets is never
+	// drawn (fading doesn't change that).
+	return !isTransparent() && OSDImageBasedWidget::isVisible();
+}
+
 uint8_t OSDRectangle::getFadedAlpha() const
 {
 	return uint8_t(255 * getRecursiveFadeValue());
@@ -158,9 +172,7 @@ template<typename IMAGE> std::unique_ptr<BaseImage> OSDRectangle::create(
 	OutputSurface& output)
 {
 	if (imageName.empty()) {
-		bool constAlpha = hasConstantAlpha();
-		if (constAlpha && ((getRGBA(0) & 0xff) == 0) &&
-		    (((borderRGBA & 0xFF) == 0) || (borderSize == 0.0f))) {
+		if (isTransparent()) {
 			// optimization: Sometimes it's useful to have a
 			//   rectangle that will never be drawn, it only exists
 			//   as a parent for sub-widgets. For those cases
@@ -18,9 +18,11 @@ public:
 	                 std::string_view name, const TclObject& value) override;
 	void getProperty(std::string_view name, TclObject& result) const override;
 	[[nodiscard]] std::string_view getType() const override;
+	[[nodiscard]] bool isVisible() const override;
 
 private:
 	[[nodiscard]] bool takeImageDimensions() const;
+	[[nodiscard]] bool isTransparent() const;
 
 	[[nodiscard]] gl::vec2 getSize(const OutputSurface& output) const override;
 	[[nodiscard]] uint8_t getFadedAlpha() const override;
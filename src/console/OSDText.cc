@@ -166,6 +166,12 @@ uint8_t OSDText::getFadedAlpha() const
 	return byte((getRGBA(0) & 0xff) * getRecursiveFadeValue());
 }
 
+bool OSDText::isAlphaInImage() const
+{
+	// the text is rendered opaque, alpha is applied in getFadedAlpha()
+	return false;
+}
+
 template<typename IMAGE> std::unique_ptr<BaseImage> OSDText::create(
 	OutputSurface& output)
 {
@@ -22,6 +22,7 @@ private:
 	void invalidateLocal() override;
 	[[nodiscard]] gl::vec2 getSize(const OutputSurface& output) const override;
 	[[nodiscard]] uint8_t getFadedAlpha() const override;
+	[[nodiscard]] bool isAlphaInImage() const override;
 	[[nodiscard]] std::unique_ptr<BaseImage> createSDL(OutputSurface& output) override;
 	[[nodiscard]] std::unique_ptr<BaseImage> createGL (OutputSurface& output) override;
 	template<typename IMAGE> [[nodiscard]] std::unique_ptr<BaseImage> create(
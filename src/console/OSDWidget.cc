@@ -311,6 +311,12 @@ void OSDWidget::invalidateChildren()
 	}
 }
 
+bool OSDWidget::isRecursiveVisible() const
+{
+	return isVisible() ||
+	       ranges::any_of(subWidgets, [](auto& s) { return s->isRecursiveVisible(); });
+}
+
 bool OSDWidget::needSuppressErrors() const
 {
 	if (suppressErrors) return true;
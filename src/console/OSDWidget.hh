@@ -51,6 +51,8 @@ public:
 
 	// Is visible? Or may become visible (fading-in).
 	[[nodiscard]] virtual bool isVisible() const = 0;
+	// Is this widget or any of its (grand)children visible?
+	[[nodiscard]] bool isRecursiveVisible() const;
 
 	[[nodiscard]] Display& getDisplay() const { return display; }
 
@@ -2,12 +2,16 @@
 #include "LocalFileReference.hh"
 #include "MSXException.hh"
 #include "StringOp.hh"
+#include "hash_map.hh"
 #include "ranges.hh"
 #include "stl.hh"
 #include "xrange.hh"
+#include "xxhash.hh"
 #include "zstring_view.hh"
 #include <SDL_ttf.h>
+#include <algorithm>
 #include <cassert>
+#include <cstdint>
 #include <vector>
 
 namespace openmsx {
@@ -135,11 +139,83 @@ void TTFFontPool::release(TTF_Font* font)
 
 // class TTFFont
 
+// OSD widgets often only change part of their text (e.g. one line of a
+// multi-line text), or they change it back and forth between a few values.
+struct TTFFont::Cache
+{
+	static constexpr size_t MAX_LINES = 32;
+	static constexpr unsigned MAX_SIZES = 1024;
+
+	struct Line {
+		std::string text;
+		uint32_t rgb;
+		SDLSurfacePtr surface;
+		uint64_t lastUse;
+	};
+	std::vector<Line> lines;
+	uint64_t useCounter = 0;
+
+	hash_map<std::string, gl::ivec2, XXHasher> sizes;
+};
+
+TTFFont::Cache& TTFFont::getCache() const
+{
+	if (!cache) cache = std::make_unique<Cache>();
+	return *cache;
+}
+
+// Returns a surface that remains owned by the cache.
+SDL_Surface* TTFFont::renderLine(const std::string& line, byte r, byte g, byte b) const
+{
+	auto& c = getCache();
+	uint32_t rgb = (r << 16) | (g << 8) | (b << 0);
+	++c.useCounter;
+	auto it = ranges::find_if(c.lines, [&](auto& l) {
+		return (l.rgb == rgb) && (l.text == line);
+	});
+	if (it == end(c.lines)) {
+		SDL_Color color = { r, g, b, 0 };
+		SDLSurfacePtr surface(TTF_RenderUTF8_Blended(
+			static_cast<TTF_Font*>(font), line.c_str(), color));
+		if (!surface) {
+			throw MSXException(TTF_GetError());
+		}
+		if (c.lines.size() < Cache::MAX_LINES) {
+			it = c.lines.emplace(end(c.lines));
+		} else {
+			it = std::min_element(begin(c.lines), end(c.lines), [](auto& x, auto& y) {
+				return x.lastUse < y.lastUse;
+			});
+		}
+		it->text = line;
+		it->rgb = rgb;
+		it->surface = std::move(surface);
+	}
+	it->lastUse = c.useCounter;
+	return it->surface.get();
+}
+
+TTFFont::TTFFont() = default;
+
 TTFFont::TTFFont(const std::string& filename, int ptSize)
 {
 	font = TTFFontPool::instance().get(filename, ptSize);
 }
 
+TTFFont::TTFFont(TTFFont&& other) noexcept
+	: font(other.font)
+	, cache(std::move(other.cache))
+{
+	other.font = nullptr;
+}
+
+TTFFont& TTFFont::operator=(TTFFont&& other) noexcept
+{
+	std::swap(font, other.font);
+	std::swap(cache, other.cache);
+	return *this;
+}
+
 TTFFont::~TTFFont()
 {
 	if (!font) return;
@@ -148,8 +224,6 @@ TTFFont::~TTFFont()
 
 SDLSurfacePtr TTFFont::render(std::string text, byte r, byte g, byte b) const
 {
-	SDL_Color color = { r, g, b, 0 };
-
 	// Optimization: remove trailing empty lines
 	StringOp::trimRight(text, " \n");
 	if (text.empty()) return SDLSurfacePtr(nullptr);
@@ -160,13 +234,12 @@ SDLSurfacePtr TTFFont::render(std::string text, byte r, byte g, byte b) const
 
 	if (lines.size() == 1) {
 		// Special case for a single line: we can avoid the
-		// copy to an extra SDL_Surface
+		// blit to an extra SDL_Surface, only a copy of the cached one
 		assert(!text.empty());
-		SDLSurfacePtr surface(
-			TTF_RenderUTF8_Blended(static_cast<TTF_Font*>(font),
-			                       text.c_str(), color));
+		auto* line = renderLine(text, r, g, b);
+		SDLSurfacePtr surface(SDL_ConvertSurface(line, line->format, 0));
 		if (!surface) {
-			throw MSXException(TTF_GetError());
+			throw MSXException("Couldn't allocate surface for text.");
 		}
 		return surface;
 	}
@@ -201,19 +274,17 @@ SDLSurfacePtr TTFFont::render(std::string text, byte r, byte g, byte b) const
 			// simply skip such lines
 			continue;
 		}
-		SDLSurfacePtr line(TTF_RenderUTF8_Blended(
-			static_cast<TTF_Font*>(font),
-			std::string(lines[i]).c_str(), color));
-		if (!line) {
-			throw MSXException(TTF_GetError());
-		}
+		auto* line = renderLine(std::string(lines[i]), r, g, b);
 
 		// Copy line to destination surface
 		SDL_Rect rect;
 		rect.x = 0;
 		rect.y = Sint16(i * lineSkip);
-		SDL_SetSurfaceBlendMode(line.get(), SDL_BLENDMODE_NONE); // no blending during copy
-		SDL_BlitSurface(line.get(), nullptr, destination.get(), &rect);
+		SDL_BlendMode mode;
+		SDL_GetSurfaceBlendMode(line, &mode);
+		SDL_SetSurfaceBlendMode(line, SDL_BLENDMODE_NONE); // no blending during copy
+		SDL_BlitSurface(line, nullptr, destination.get(), &rect);
+		SDL_SetSurfaceBlendMode(line, mode); // the cached one stays as rendered
 	}
 	return destination;
 }
@@ -243,12 +314,18 @@ unsigned TTFFont::getWidth() const
 
 gl::ivec2 TTFFont::getSize(zstring_view text) const
 {
+	auto& sizes = getCache().sizes;
+	if (auto* s = lookup(sizes, std::string_view(text))) return *s;
+
 	int width, height;
 	if (TTF_SizeUTF8(static_cast<TTF_Font*>(font), text.c_str(),
 	                 &width, &height)) {
 		throw MSXException(TTF_GetError());
 	}
-	return {width, height};
+	if (sizes.size() >= Cache::MAX_SIZES) sizes.clear();
+	gl::ivec2 result(width, height);
+	sizes.emplace_noDuplicateCheck(std::string(text), result);
+	return result;
 }
 
 } // namespace openmsx
@@ -5,6 +5,7 @@
 #include "openmsx.hh"
 #include "gl_vec.hh"
 #include "zstring_view.hh"
+#include <memory>
 #include <string>
 #include <utility>
 
@@ -22,7 +23,7 @@ public:
 	  *  - destruct the object
 	  * post-condition: empty()
 	  */
-	TTFFont() = default;
+	TTFFont();
 
 	/** Construct new TTFFont object.
 	  * @param filename Filename of font (.fft file, possibly (g)zipped).
@@ -32,18 +33,10 @@ public:
 	TTFFont(const std::string& filename, int ptSize);
 
 	/** Move construct. */
-	TTFFont(TTFFont&& other) noexcept
-		: font(other.font)
-	{
-		other.font = nullptr;
-	}
+	TTFFont(TTFFont&& other) noexcept;
 
 	/** Move assignment. */
-	TTFFont& operator=(TTFFont&& other) noexcept
-	{
-		std::swap(font, other.font);
-		return *this;
-	}
+	TTFFont& operator=(TTFFont&& other) noexcept;
 
 	~TTFFont();
 
@@ -53,6 +46,8 @@ public:
 	/** Render the given text to a new SDL_Surface.
 	  * The text must be UTF-8 encoded.
 	  * The result is a 32bpp RGBA SDL_Surface.
+	  * The most recently rendered lines are cached, so when only some
+	  * lines of a multi-line text change, only those are rendered again.
 	  */
 	[[nodiscard]] SDLSurfacePtr render(std::string text, byte r, byte g, byte b) const;
 
@@ -71,11 +66,18 @@ public:
 	[[nodiscard]] unsigned getWidth() const;
 
 	/** Return the size in pixels of the text if it would be rendered.
+	 * Cached, text wrapping asks this for many substrings (repeatedly).
 	 */
 	[[nodiscard]] gl::ivec2 getSize(zstring_view text) const;
 
+private:
+	struct Cache;
+	[[nodiscard]] Cache& getCache() const;
+	[[nodiscard]] SDL_Surface* renderLine(const std::string& line, byte r, byte g, byte b) const;
+
 private:
 	void* font = nullptr;  // TTF_Font*
+	mutable std::unique_ptr<Cache> cache; // created on first use
 };
 
 } // namespace openmsx
@@ -1,16 +1,58 @@
 #include "BreakPointBase.hh"
 #include "CommandException.hh"
+#include "CPURegs.hh"
 #include "GlobalCliComm.hh"
+#include "MSXCPU.hh"
+#include "MSXCPUInterface.hh"
+#include "MSXMotherBoard.hh"
 #include "ScopedAssign.hh"
 
 namespace openmsx {
 
-bool BreakPointBase::isTrue(GlobalCliComm& cliComm, Interpreter& interp) const
+namespace {
+
+// Gives CompiledCondition access to the machine, equivalent to what the
+// 'reg', 'peek' and 'pc_in_slot' Tcl procs do.
+struct ConditionEnv {
+	MSXMotherBoard& motherBoard;
+
+	[[nodiscard]] uint8_t readReg(unsigned index) {
+		return motherBoard.getCPU().peekRegister(index);
+	}
+	[[nodiscard]] uint8_t peek(uint16_t address) {
+		return motherBoard.getCPUInterface().peekMem(
+			address, motherBoard.getCurrentTime());
+	}
+	// Reads the slot selection like 'get_selected_slot' in _slot.tcl: the
+	// value of I/O port 0xA8 and of the secondary slot register.
+	[[nodiscard]] bool inSlot(int ps, int ss) {
+		const auto& interface = motherBoard.getCPUInterface();
+		auto time = motherBoard.getCurrentTime();
+		unsigned page = motherBoard.getCPU().getRegisters().getPC() >> 14;
+		int pcPs = (interface.peekIO(0xA8, time) >> (2 * page)) & 3;
+		if (pcPs != ps) return false;
+		if ((ss != -1) && interface.isExpanded(pcPs)) {
+			int ssReg = interface.peekSlottedMem(0x40000 * pcPs + 0xFFFF, time) ^ 255;
+			if (((ssReg >> (2 * page)) & 3) != ss) return false;
+		}
+		return true;
+	}
+};
+
+} // anonymous namespace
+
+bool BreakPointBase::isTrue(GlobalCliComm& cliComm, Interpreter& interp,
+                            MSXMotherBoard& motherBoard) const
 {
 	if (condition.getString().empty()) {
 		// unconditional bp
 		return true;
 	}
+	if (compiled.isValid()) {
+		ConditionEnv env{motherBoard};
+		if (auto r = compiled.evaluate(env)) return *r;
+		// else fall back to Tcl (e.g. to get the same error message)
+	}
 	try {
 		return condition.evalBool(interp);
 	} catch (CommandException& e) {
@@ -19,14 +61,15 @@ bool BreakPointBase::isTrue(GlobalCliComm& cliComm, Interpreter& interp) const
 	}
 }
 
-void BreakPointBase::checkAndExecute(GlobalCliComm& cliComm, Interpreter& interp)
+void BreakPointBase::checkAndExecute(GlobalCliComm& cliComm, Interpreter& interp,
+                                     MSXMotherBoard& motherBoard)
 {
 	if (executing) {
 		// no recursive execution
 		return;
 	}
 	ScopedAssign sa(executing, true);
-	if (isTrue(cliComm, interp)) {
+	if (isTrue(cliComm, interp, motherBoard)) {
 		try {
 			command.executeCommand(interp, true); // compile command
 		} catch (CommandException& e) {
@@ -1,6 +1,7 @@
 #ifndef BREAKPOINTBASE_HH
 #define BREAKPOINTBASE_HH
 
+#include "CompiledCondition.hh"
 #include "TclObject.hh"
 #include <string_view>
 
@@ -8,6 +9,7 @@ namespace openmsx {
 
 class Interpreter;
 class GlobalCliComm;
+class MSXMotherBoard;
 
 /** Base class for CPU break and watch points.
  */
@@ -20,7 +22,12 @@ public:
 	[[nodiscard]] TclObject getCommandObj()   const { return command; }
 	[[nodiscard]] bool onlyOnce() const { return once; }
 
-	void checkAndExecute(GlobalCliComm& cliComm, Interpreter& interp);
+	void checkAndExecute(GlobalCliComm& cliComm, Interpreter& interp,
+	                     MSXMotherBoard& motherBoard);
+
+	/** Evaluate the condition (an empty condition is always true). */
+	[[nodiscard]] bool isTrue(GlobalCliComm& cliComm, Interpreter& interp,
+	                          MSXMotherBoard& motherBoard) const;
 
 protected:
 	// Note: we require GlobalCliComm here because breakpoint objects can
@@ -29,14 +36,13 @@ protected:
 	BreakPointBase(TclObject command_, TclObject condition_, bool once_)
 		: command(std::move(command_))
 		, condition(std::move(condition_))
+		, compiled(condition.getString())
 		, once(once_) {}
 
-private:
-	[[nodiscard]] bool isTrue(GlobalCliComm& cliComm, Interpreter& interp) const;
-
 private:
 	TclObject command;
 	TclObject condition;
+	CompiledCondition compiled; // native version of 'condition' (if possible)
 	bool once;
 	bool executing = false;
 };
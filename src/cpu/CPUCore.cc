@@ -44,9 +44,9 @@
 // INSTRUCTION EMULATION
 // ---------------------
 //
-// UPDATE: the 'threaded interpreter model' is not enabled by default
-//         main reason is the huge memory requirement while compiling
-//         and that it doesn't work on non-gcc compilers
+// UPDATE: the 'threaded interpreter model' is only enabled by default in the
+//         (x86) opt flavours, main reasons are the huge memory requirement
+//         while compiling and that it doesn't work on non-gcc compilers
 //
 // The current implementation is based on a 'threaded interpreter model'. In
 // the text below I'll call the older implementation the 'traditional
@@ -163,7 +163,10 @@
 #include "Scheduler.hh"
 #include "MSXMotherBoard.hh"
 #include "CliComm.hh"
+#include "CPUTraceRecorder.hh"
+#include "InstructionIndex.hh"
 #include "TclCallback.hh"
+#include "TimingStats.hh"
 #include "Dasm.hh"
 #include "Z80.hh"
 #include "R800.hh"
@@ -279,14 +282,18 @@ struct CondTrue { bool operator()(byte /*f*/) const { return true; } };
 template<typename T> CPUCore<T>::CPUCore(
 		MSXMotherBoard& motherboard_, const std::string& name,
 		const BooleanSetting& traceSetting_,
-		TclCallback& diHaltCallback_, EmuTime::param time)
+		InstructionIndex& instructionIndex_,
+		TclCallback& diHaltCallback_, TimingStats& timingStats_,
+		EmuTime::param time)
 	: CPURegs(T::IS_R800)
 	, T(time, motherboard_.getScheduler())
 	, motherboard(motherboard_)
 	, scheduler(motherboard.getScheduler())
 	, interface(nullptr)
 	, traceSetting(traceSetting_)
+	, instructionIndex(instructionIndex_)
 	, diHaltCallback(diHaltCallback_)
+	, timingStats(timingStats_)
 	, IRQStatus(motherboard.getDebugger(), name + ".pendingIRQ",
 	            "Non-zero if there are pending IRQs (thus CPU would enter "
 	            "interrupt routine in EI mode).",
@@ -430,6 +437,8 @@ template<typename T> void CPUCore<T>::raiseIRQ()
 	assert(IRQStatus >= 0);
 	if (IRQStatus == 0) {
 		setSlowInstructions();
+		irqRaiseTime = scheduler.getCurrentTime();
+		irqLatencyPending = true;
 	}
 	IRQStatus = IRQStatus + 1;
 }
@@ -438,6 +447,7 @@ template<typename T> void CPUCore<T>::lowerIRQ()
 {
 	IRQStatus = IRQStatus - 1;
 	assert(IRQStatus >= 0);
+	if (IRQStatus == 0) irqLatencyPending = false;
 }
 
 template<typename T> void CPUCore<T>::raiseNMI()
@@ -495,41 +505,35 @@ template<typename T> void CPUCore<T>::setNextSyncPoint(EmuTime::param time)
 }
 
 
-static constexpr char toHex(byte x)
+template<typename T> void CPUCore<T>::update(const Setting& setting) noexcept
 {
-	return (x < 10) ? (x + '0') : (x - 10 + 'A');
+	if (&setting == &freqLocked) {
+		doSetFreq();
+	} else if (&setting == &freqValue) {
+		doSetFreq();
+	} else if (&setting == &traceSetting) {
+		updateTracingEnabled();
+	}
 }
-static constexpr void toHex(byte x, char* buf)
+
+template<typename T> void CPUCore<T>::updateTracingEnabled()
 {
-	buf[0] = toHex(x / 16);
-	buf[1] = toHex(x & 15);
+	tracingEnabled = traceSetting.getBoolean() || traceRecorder || coverageEnabled;
 }
 
-template<typename T> void CPUCore<T>::disasmCommand(
-	Interpreter& interp, span<const TclObject> tokens, TclObject& result) const
+template<typename T> void CPUCore<T>::setTraceRecorder(CPUTraceRecorder* recorder)
 {
-	word address = (tokens.size() < 3) ? getPC() : tokens[2].getInt(interp);
-	byte outBuf[4];
-	std::string dasmOutput;
-	unsigned len = dasm(*interface, address, outBuf, dasmOutput,
-	               T::getTimeFast());
-	result.addListElement(dasmOutput);
-	char tmp[3]; tmp[2] = 0;
-	for (auto i : xrange(len)) {
-		toHex(outBuf[i], tmp);
-		result.addListElement(tmp);
-	}
+	traceRecorder = recorder;
+	updateTracingEnabled();
+	// re-evaluate the choice between the fast and the tracing loop
+	exitCPULoopSync();
 }
 
-template<typename T> void CPUCore<T>::update(const Setting& setting) noexcept
+template<typename T> void CPUCore<T>::setCoverage(bool enabled)
 {
-	if (&setting == &freqLocked) {
-		doSetFreq();
-	} else if (&setting == &freqValue) {
-		doSetFreq();
-	} else if (&setting == &traceSetting) {
-		tracingEnabled = traceSetting.getBoolean();
-	}
+	coverageEnabled = enabled;
+	updateTracingEnabled();
+	exitCPULoopSync();
 }
 
 template<typename T> void CPUCore<T>::setFreq(unsigned freq_)
@@ -2433,6 +2437,10 @@ xx_cb: {
 template<typename T> inline void CPUCore<T>::cpuTracePre()
 {
 	start_pc = getPC();
+	instructionIndex.record(T::getTimeFast(), start_pc);
+	if (unlikely(coverageEnabled)) {
+		interface->markCoverage(CodeCoverage::EXEC, start_pc);
+	}
 }
 template<typename T> inline void CPUCore<T>::cpuTracePost()
 {
@@ -2442,6 +2450,19 @@ template<typename T> inline void CPUCore<T>::cpuTracePost()
 }
 template<typename T> void CPUCore<T>::cpuTracePost_slow()
 {
+	if (traceRecorder) {
+		EmuTime time = T::getTimeFast();
+		byte opcode[4];
+		for (auto i : xrange(4)) {
+			opcode[i] = interface->peekMem(word(start_pc + i), time);
+		}
+		traceRecorder->record(
+			(time - EmuTime::zero()).length(), start_pc, opcode,
+			{word(getAF()),  word(getBC()),  word(getDE()),  word(getHL()),
+			 word(getAF2()), word(getBC2()), word(getDE2()), word(getHL2()),
+			 word(getIX()),  word(getIY()),  word(getSP())});
+	}
+	if (!traceSetting.getBoolean()) return;
 	byte opBuf[4];
 	std::string dasmOutput;
 	dasm(*interface, start_pc, opBuf, dasmOutput, T::getTimeFast());
@@ -2494,6 +2515,12 @@ template<typename T> void CPUCore<T>::executeSlow(ExecIRQ execIRQ)
 			setF(getF() & ~V_FLAG);
 		}
 		IRQAccept.signal();
+		if (irqLatencyPending) {
+			irqLatencyPending = false;
+			auto now = T::getTimeFast();
+			timingStats.irqLatency.add((now > irqRaiseTime)
+				? TimingStats::toCycles(now - irqRaiseTime) : 0);
+		}
 		switch (getIM()) {
 			case 0: irq0();
 				break;
@@ -2560,6 +2587,18 @@ template<typename T> void CPUCore<T>::execute2(bool fastForward)
 	if (fastForward ||
 	    (!interface->anyBreakPoints() && !tracingEnabled)) {
 		// fast path, no breakpoints, no tracing
+		//
+		// Note: this already is the 'run till the next sync point'
+		// bulk path. enableLimit() sets the clock limit to
+		// Scheduler::getNext(), and executeInstructions() then runs
+		// (possibly many thousands of) instructions with only a single
+		// limitReached() test per instruction. The exit-request and
+		// slow-instruction flags are only checked here, between such
+		// blocks. Device code that needs attention earlier (IRQ, new
+		// sync point, exitCPULoopSync()) calls disableLimit(), which
+		// makes limitReached() return true. So adding a separate
+		// specialized loop wouldn't remove any additional tests from
+		// the per-instruction path.
 		do {
 			if (slowInstructions) {
 				--slowInstructions;
@@ -2574,6 +2613,7 @@ template<typename T> void CPUCore<T>::execute2(bool fastForward)
 						// note: pipeline only shifted one
 						// step for multiple instructions
 						endInstruction();
+						instructionIndex.markGap();
 					}
 					scheduler.schedule(T::getTimeFast());
 					if (needExitCPULoop()) return;
@@ -15,12 +15,13 @@
 
 namespace openmsx {
 
+class CPUTraceRecorder;
+class InstructionIndex;
 class MSXCPUInterface;
 class Scheduler;
 class MSXMotherBoard;
 class TclCallback;
-class TclObject;
-class Interpreter;
+class TimingStats;
 enum Reg8  : int;
 enum Reg16 : int;
 
@@ -56,10 +57,19 @@ class CPUCore final : public CPUBase, public CPURegs, public CPU_POLICY
 public:
 	CPUCore(MSXMotherBoard& motherboard, const std::string& name,
 	        const BooleanSetting& traceSetting,
-	        TclCallback& diHaltCallback, EmuTime::param time);
+	        InstructionIndex& instructionIndex,
+	        TclCallback& diHaltCallback, TimingStats& timingStats,
+	        EmuTime::param time);
 
 	void setInterface(MSXCPUInterface* interf) { interface = interf; }
 
+	/** Record the executed instructions in the given recorder, or stop
+	  * recording when nullptr. */
+	void setTraceRecorder(CPUTraceRecorder* recorder);
+
+	/** Report each executed instruction to MSXCPUInterface::markCoverage(). */
+	void setCoverage(bool enabled);
+
 	/**
 	 * Reset the CPU.
 	 */
@@ -89,10 +99,6 @@ public:
 	}
 	[[nodiscard]] bool isM1Cycle(unsigned address) const;
 
-	void disasmCommand(Interpreter& interp,
-	                   span<const TclObject> tokens,
-	                   TclObject& result) const;
-
 	/**
 	 * Raises the maskable interrupt count.
 	 * Devices should call MSXCPU::raiseIRQ instead, or use the IRQHelper class.
@@ -144,10 +150,18 @@ private:
 	MSXCPUInterface* interface;
 
 	const BooleanSetting& traceSetting;
+	CPUTraceRecorder* traceRecorder = nullptr;
+	bool coverageEnabled = false;
+	InstructionIndex& instructionIndex;
 	TclCallback& diHaltCallback;
+	TimingStats& timingStats;
 
 	Probe<int> IRQStatus;
 	Probe<void> IRQAccept;
+	/** Time of the last rising edge of IRQStatus, only valid while
+	  * 'irqLatencyPending', see TimingStats::irqLatency. */
+	EmuTime irqRaiseTime = EmuTime::zero();
+	bool irqLatencyPending = false;
 
 	// dynamic freq
 	BooleanSetting freqLocked;
@@ -167,13 +181,15 @@ private:
 
 	std::atomic<bool> exitLoop;
 
-	/** In sync with traceSetting.getBoolean(). */
+	/** In sync with traceSetting.getBoolean() || traceRecorder ||
+	  * coverageEnabled. */
 	bool tracingEnabled;
 
 	/** 'normal' Z80 and Z80 in a turboR behave slightly different */
 	const bool isTurboR;
 
 private:
+	void updateTracingEnabled();
 	inline void cpuTracePre();
 	inline void cpuTracePost();
 	void cpuTracePost_slow();
@@ -0,0 +1,269 @@
+#include "CPUTraceRecorder.hh"
+#include "Dasm.hh"
+#include "EmuDuration.hh"
+#include "File.hh"
+#include "MSXException.hh"
+#include "endian.hh"
+#include "lz4.hh"
+#include "ranges.hh"
+#include "strCat.hh"
+#include "xrange.hh"
+#include "xxhash.hh"
+#include <cassert>
+#include <cstdio>
+#include <cstring>
+#include <string_view>
+
+namespace openmsx {
+
+static constexpr std::string_view MAGIC = "openMSX cputrace";
+static constexpr uint32_t VERSION = 1;
+static constexpr size_t FILE_HEADER_SIZE = 16 + 4;
+static constexpr size_t CHUNK_HEADER_SIZE = 4 * 4;
+static constexpr unsigned PC_FLAG = 1 << CPUTraceRecorder::NUM_REGS;
+// flags + time + pc + opcode + registers
+static constexpr size_t MAX_RECORD_SIZE = 2 + 10 + 2 + 4 + 2 * CPUTraceRecorder::NUM_REGS;
+
+[[nodiscard]] static uint32_t checksum(span<const uint8_t> data)
+{
+	return xxhash(std::string_view(reinterpret_cast<const char*>(data.data()), data.size()));
+}
+
+[[noreturn]] static void corrupt()
+{
+	throw MSXException("Corrupt CPU trace file.");
+}
+
+void CPUTraceRecorder::start(size_t maxMemory_)
+{
+	maxMemory = maxMemory_;
+	raw.resize(CHUNK_SIZE);
+	recording = true;
+}
+
+void CPUTraceRecorder::stop()
+{
+	flush();
+	recording = false;
+}
+
+void CPUTraceRecorder::clear()
+{
+	chunks.clear();
+	rawSize = 0;
+	numRawRecords = 0;
+	numRecords = 0;
+	numDropped = 0;
+	memory = 0;
+	prevTime = 0;
+}
+
+void CPUTraceRecorder::record(
+	uint64_t time, word pc, span<const byte, 4> opcode, const Regs& regs)
+{
+	assert(raw.size() == CHUNK_SIZE);
+	// On a reverse or savestate load the time goes backwards, deltas
+	// can't express that, so start a new chunk.
+	if ((rawSize + MAX_RECORD_SIZE > CHUNK_SIZE) || (time < prevTime)) {
+		flush();
+	}
+	bool first = numRawRecords == 0;
+	uint8_t* p = &raw[rawSize];
+
+	unsigned flags = (first || (pc != nextPC)) ? PC_FLAG : 0;
+	for (auto i : xrange(NUM_REGS)) {
+		if (first || (regs[i] != prevRegs[i])) flags |= 1 << i;
+	}
+	Endian::write_UA_L16(p, flags); p += 2;
+
+	uint64_t delta = time - prevTime;
+	while (delta >= 0x80) {
+		*p++ = uint8_t(delta | 0x80);
+		delta >>= 7;
+	}
+	*p++ = uint8_t(delta);
+
+	if (flags & PC_FLAG) {
+		Endian::write_UA_L16(p, pc); p += 2;
+	}
+	unsigned len = instructionLength(opcode);
+	ranges::copy(opcode.first(len), p); p += len;
+	for (auto i : xrange(NUM_REGS)) {
+		if (flags & (1 << i)) {
+			Endian::write_UA_L16(p, regs[i]); p += 2;
+		}
+	}
+
+	rawSize = p - raw.data();
+	++numRawRecords;
+	prevTime = time;
+	prevRegs = regs;
+	nextPC = word(pc + len);
+}
+
+CPUTraceRecorder::Chunk CPUTraceRecorder::compress() const
+{
+	Chunk chunk;
+	chunk.data.resize(LZ4::compressBound(int(rawSize)));
+	chunk.data.resize(LZ4::compress(raw.data(), chunk.data.data(), int(rawSize)));
+	chunk.data.shrink_to_fit();
+	chunk.rawSize = uint32_t(rawSize);
+	chunk.numRecords = numRawRecords;
+	chunk.checksum = checksum(chunk.data);
+	return chunk;
+}
+
+void CPUTraceRecorder::flush()
+{
+	if (numRawRecords == 0) return;
+	chunks.push_back(compress());
+	memory += chunks.back().data.size();
+	numRecords += numRawRecords;
+	while ((memory > maxMemory) && (chunks.size() > 1)) {
+		auto& oldest = chunks.front();
+		memory -= oldest.data.size();
+		numRecords -= oldest.numRecords;
+		numDropped += oldest.numRecords;
+		chunks.pop_front();
+	}
+	rawSize = 0;
+	numRawRecords = 0;
+	prevTime = 0;
+}
+
+void CPUTraceRecorder::write(const std::function<void(span<const uint8_t>)>& output) const
+{
+	uint8_t header[FILE_HEADER_SIZE];
+	memcpy(header, MAGIC.data(), MAGIC.size());
+	Endian::write_UA_L32(header + MAGIC.size(), VERSION);
+	output(header);
+
+	auto writeChunk = [&](const Chunk& chunk) {
+		uint8_t chunkHeader[CHUNK_HEADER_SIZE];
+		Endian::write_UA_L32(chunkHeader +  0, chunk.rawSize);
+		Endian::write_UA_L32(chunkHeader +  4, uint32_t(chunk.data.size()));
+		Endian::write_UA_L32(chunkHeader +  8, chunk.numRecords);
+		Endian::write_UA_L32(chunkHeader + 12, chunk.checksum);
+		output(chunkHeader);
+		output(chunk.data);
+	};
+	for (const auto& chunk : chunks) writeChunk(chunk);
+	if (numRawRecords) writeChunk(compress());
+}
+
+void CPUTraceRecorder::save(const std::string& filename) const
+{
+	File file(filename, File::TRUNCATE);
+	write([&](span<const uint8_t> data) { file.write(data.data(), data.size()); });
+}
+
+void CPUTraceRecorder::decode(span<const uint8_t> trace,
+                              const std::function<void(const Entry&)>& callback)
+{
+	if ((trace.size() < FILE_HEADER_SIZE) ||
+	    (memcmp(trace.data(), MAGIC.data(), MAGIC.size()) != 0)) {
+		throw MSXException("Not an openMSX CPU trace file.");
+	}
+	if (auto version = Endian::read_UA_L32(&trace[MAGIC.size()]); version != VERSION) {
+		throw MSXException("Unsupported CPU trace version: ", version);
+	}
+	std::vector<uint8_t> buffer(CHUNK_SIZE);
+	trace = trace.subspan(FILE_HEADER_SIZE);
+	while (!trace.empty()) {
+		if (trace.size() < CHUNK_HEADER_SIZE) corrupt();
+		auto rawSize        = Endian::read_UA_L32(&trace[ 0]);
+		auto compressedSize = Endian::read_UA_L32(&trace[ 4]);
+		auto count          = Endian::read_UA_L32(&trace[ 8]);
+		auto sum            = Endian::read_UA_L32(&trace[12]);
+		trace = trace.subspan(CHUNK_HEADER_SIZE);
+		if ((rawSize > CHUNK_SIZE) || (compressedSize > trace.size())) corrupt();
+		auto compressed = trace.first(compressedSize);
+		trace = trace.subspan(compressedSize);
+		// LZ4::decompress() doesn't validate its input, so only pass
+		// it data that's identical to what LZ4::compress() produced.
+		if (checksum(compressed) != sum) corrupt();
+		if (LZ4::decompress(compressed.data(), buffer.data(), int(compressedSize),
+		                    int(rawSize)) != int(rawSize)) {
+			corrupt();
+		}
+
+		const uint8_t* p = buffer.data();
+		const uint8_t* end = p + rawSize;
+		Entry entry = {};
+		for (auto n : xrange(count)) {
+			if ((end - p) < 3) corrupt();
+			unsigned flags = Endian::read_UA_L16(p); p += 2;
+			if ((n == 0) && ((flags & (2 * PC_FLAG - 1)) != (2 * PC_FLAG - 1))) corrupt();
+
+			uint64_t delta = 0;
+			for (unsigned shift = 0; ; shift += 7) {
+				if ((p == end) || (shift > 63)) corrupt();
+				uint8_t b = *p++;
+				delta |= uint64_t(b & 0x7f) << shift;
+				if (!(b & 0x80)) break;
+			}
+			entry.time = (n == 0) ? delta : (entry.time + delta);
+
+			if (flags & PC_FLAG) {
+				if ((end - p) < 2) corrupt();
+				entry.pc = Endian::read_UA_L16(p); p += 2;
+			} else {
+				entry.pc = word(entry.pc + entry.length);
+			}
+
+			entry.length = instructionLength(span<const uint8_t>(p, end - p));
+			if (unsigned(end - p) < entry.length) corrupt();
+			entry.opcode = {};
+			ranges::copy(span<const uint8_t>(p, entry.length), entry.opcode.data());
+			p += entry.length;
+
+			for (auto i : xrange(NUM_REGS)) {
+				if (flags & (1 << i)) {
+					if ((end - p) < 2) corrupt();
+					entry.regs[i] = Endian::read_UA_L16(p); p += 2;
+				}
+			}
+			callback(entry);
+		}
+		if (p != end) corrupt();
+	}
+}
+
+uint64_t CPUTraceRecorder::decodeToText(const std::string& traceFile,
+                                        const std::string& textFile)
+{
+	File in(traceFile);
+	auto trace = in.mmap();
+	File out(textFile, File::TRUNCATE);
+
+	std::string text;
+	std::string dasmOutput;
+	uint64_t count = 0;
+	decode(trace, [&](const Entry& e) {
+		byte buf[4];
+		dasmOutput.clear();
+		dasm(span<const byte>(e.opcode.data(), e.length), e.pc, buf, dasmOutput);
+		char time[32];
+		snprintf(time, sizeof(time), "%.9f",
+		         double(e.time) / double(MAIN_FREQ));
+		strAppend(text, time, ' ', hex_string<4>(e.pc),
+		          " : ", dasmOutput,
+		          " AF=", hex_string<4>(e.regs[0]),
+		          " BC=", hex_string<4>(e.regs[1]),
+		          " DE=", hex_string<4>(e.regs[2]),
+		          " HL=", hex_string<4>(e.regs[3]),
+		          " IX=", hex_string<4>(e.regs[8]),
+		          " IY=", hex_string<4>(e.regs[9]),
+		          " SP=", hex_string<4>(e.regs[10]),
+		          '\n');
+		if (text.size() > 1024 * 1024) {
+			out.write(text.data(), text.size());
+			text.clear();
+		}
+		++count;
+	});
+	out.write(text.data(), text.size());
+	return count;
+}
+
+} // namespace openmsx
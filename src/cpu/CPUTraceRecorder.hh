@@ -0,0 +1,131 @@
+#ifndef CPUTRACERECORDER_HH
+#define CPUTRACERECORDER_HH
+
+#include "openmsx.hh"
+#include "span.hh"
+#include <array>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace openmsx {
+
+/** Records a binary trace of the executed CPU instructions.
+  *
+  * This is the binary counterpart of the 'cputrace' setting. Instead of
+  * disassembling (and printing) every instruction, a small record is
+  * stored: the time, the PC (only when it's not the address following the
+  * previous instruction), the opcode bytes and the registers that changed
+  * since the previous instruction. These records are collected in chunks
+  * of CHUNK_SIZE bytes. Full chunks are compressed with LZ4 and kept in a
+  * ring: when the total memory exceeds the limit, the oldest chunks are
+  * dropped. So the recording can run for hours, at the end it contains
+  * the most recent part of the trace.
+  *
+  * The trace can be saved to a file and later (offline) be decoded to the
+  * same text format as produced by the 'cputrace' setting.
+  *
+  * File format (all numbers are little endian):
+  *   header: 16 bytes "openMSX cputrace", 4 bytes version (1)
+  *   followed by zero or more chunks, each chunk has:
+  *     4 bytes uncompressed size, 4 bytes compressed size,
+  *     4 bytes number of records, 4 bytes xxhash of the compressed data,
+  *     the LZ4 compressed data
+  *   The uncompressed data is a sequence of records:
+  *     2 bytes flags: bit 0-10 register changed (in the order of 'Regs'),
+  *                    bit 11 PC is stored
+  *     LEB128 time delta (in EmuTime units) since the previous record
+  *     (present when flagged) 2 bytes PC
+  *     1-4 opcode bytes (see 'instructionLength()' in Dasm.hh)
+  *     (present when flagged) 2 bytes for each changed register
+  *   The first record in a chunk stores PC and all registers and its time
+  *   delta is relative to zero. So each chunk can be decoded on its own.
+  */
+class CPUTraceRecorder
+{
+public:
+	// AF BC DE HL AF' BC' DE' HL' IX IY SP (registers after the instruction)
+	static constexpr unsigned NUM_REGS = 11;
+	using Regs = std::array<word, NUM_REGS>;
+	static constexpr size_t CHUNK_SIZE = 64 * 1024;
+
+	struct Entry {
+		uint64_t time;
+		word pc;
+		unsigned length;
+		std::array<byte, 4> opcode;
+		Regs regs;
+	};
+
+	/** Start recording, keep at most (approximately) 'maxMemory' bytes
+	  * of compressed data. Previously recorded data is kept. */
+	void start(size_t maxMemory);
+	/** Stop recording, the recorded data is kept. */
+	void stop();
+	/** Remove all recorded data (recording continues if active). */
+	void clear();
+
+	[[nodiscard]] bool isRecording() const { return recording; }
+	[[nodiscard]] uint64_t getNumRecords() const { return numRecords + numRawRecords; }
+	[[nodiscard]] uint64_t getNumDropped() const { return numDropped; }
+	[[nodiscard]] size_t getNumChunks() const { return chunks.size(); }
+	[[nodiscard]] size_t getMemoryUsage() const { return memory + raw.size(); }
+
+	/** Add one instruction to the trace.
+	  * @param time The (EmuTime) time at the end of the instruction.
+	  * @param pc The address of the instruction.
+	  * @param opcode The 4 bytes at 'pc', only the first
+	  *               'instructionLength()' bytes are stored.
+	  * @param regs The registers after the instruction.
+	  */
+	void record(uint64_t time, word pc, span<const byte, 4> opcode, const Regs& regs);
+
+	/** Produce the content of a trace file, in one or more pieces. */
+	void write(const std::function<void(span<const uint8_t>)>& output) const;
+	/** Write the trace to a file.
+	  * @throws FileException */
+	void save(const std::string& filename) const;
+
+	/** Decode the content of a trace file.
+	  * @throws MSXException when the data is not a valid trace. */
+	static void decode(span<const uint8_t> trace,
+	                   const std::function<void(const Entry&)>& callback);
+	/** Decode a trace file into a text file.
+	  * @return The number of decoded instructions.
+	  * @throws MSXException */
+	static uint64_t decodeToText(const std::string& traceFile,
+	                             const std::string& textFile);
+
+private:
+	struct Chunk {
+		std::vector<uint8_t> data; // compressed
+		uint32_t rawSize;
+		uint32_t numRecords;
+		uint32_t checksum;
+	};
+	[[nodiscard]] Chunk compress() const;
+	void flush();
+
+private:
+	std::deque<Chunk> chunks;
+	std::vector<uint8_t> raw; // current (uncompressed) chunk
+	size_t rawSize = 0;
+	uint32_t numRawRecords = 0;
+	uint64_t numRecords = 0; // in 'chunks'
+	uint64_t numDropped = 0;
+	size_t memory = 0; // compressed size of 'chunks'
+	size_t maxMemory = 0;
+
+	// state of the previous record (in the current chunk)
+	uint64_t prevTime = 0;
+	Regs prevRegs = {};
+	word nextPC = 0;
+
+	bool recording = false;
+};
+
+} // namespace openmsx
+
+#endif
@@ -0,0 +1,133 @@
+#include "CodeCoverage.hh"
+#include "File.hh"
+#include "MSXException.hh"
+#include "Math.hh"
+#include "endian.hh"
+#include "ranges.hh"
+#include "xrange.hh"
+#include <cstring>
+#include <string_view>
+
+namespace openmsx {
+
+static constexpr std::string_view MAGIC = "openMSX coverage";
+static constexpr uint32_t VERSION = 1;
+static constexpr size_t FILE_HEADER_SIZE = 16 + 4 + 4;
+static constexpr size_t BITMAP_HEADER_SIZE = 4 + 4;
+
+[[nodiscard]] static uint64_t countBits(span<const uint8_t> bits)
+{
+	uint64_t result = 0;
+	for (auto b : bits) {
+		for (; b; b &= b - 1) ++result;
+	}
+	return result;
+}
+
+void CodeCoverage::grow(std::vector<uint8_t>& bits, unsigned index)
+{
+	bits.resize(std::max<size_t>(INITIAL_SIZE, Math::ceil2(index + 1)));
+}
+
+uint64_t CodeCoverage::count(Kind kind, unsigned ps, unsigned ss) const
+{
+	return countBits(getBitmap(kind, ps, ss));
+}
+
+uint64_t CodeCoverage::count(Kind kind) const
+{
+	uint64_t result = 0;
+	for (const auto& slot : bitmaps) {
+		result += countBits(slot[kind]);
+	}
+	return result;
+}
+
+void CodeCoverage::clear()
+{
+	for (auto& slot : bitmaps) {
+		for (auto& bits : slot) {
+			ranges::fill(bits, 0);
+		}
+	}
+}
+
+void CodeCoverage::write(const std::function<void(span<const uint8_t>)>& output) const
+{
+	auto isUsed = [](const std::vector<uint8_t>& bits) {
+		return ranges::any_of(bits, [](uint8_t b) { return b != 0; });
+	};
+	uint32_t num = 0;
+	for (const auto& slot : bitmaps) {
+		for (const auto& bits : slot) {
+			if (isUsed(bits)) ++num;
+		}
+	}
+
+	uint8_t header[FILE_HEADER_SIZE];
+	memcpy(header, MAGIC.data(), MAGIC.size());
+	Endian::write_UA_L32(header + MAGIC.size() + 0, VERSION);
+	Endian::write_UA_L32(header + MAGIC.size() + 4, num);
+	output(header);
+
+	for (auto slot : xrange(NUM_SLOTS)) {
+		for (auto kind : xrange(unsigned(NUM_KINDS))) {
+			const auto& bits = bitmaps[slot][kind];
+			if (!isUsed(bits)) continue;
+			uint8_t bitmapHeader[BITMAP_HEADER_SIZE];
+			bitmapHeader[0] = uint8_t(slot / 4);
+			bitmapHeader[1] = uint8_t(slot % 4);
+			bitmapHeader[2] = uint8_t(kind);
+			bitmapHeader[3] = 0;
+			Endian::write_UA_L32(bitmapHeader + 4, uint32_t(bits.size()));
+			output(bitmapHeader);
+			output(bits);
+		}
+	}
+}
+
+void CodeCoverage::save(const std::string& filename) const
+{
+	File file(filename, File::TRUNCATE);
+	write([&](span<const uint8_t> data) { file.write(data.data(), data.size()); });
+}
+
+std::vector<CodeCoverage::Bitmap> CodeCoverage::parse(span<const uint8_t> data)
+{
+	if ((data.size() < FILE_HEADER_SIZE) ||
+	    (memcmp(data.data(), MAGIC.data(), MAGIC.size()) != 0)) {
+		throw MSXException("Not an openMSX coverage file.");
+	}
+	if (auto version = Endian::read_UA_L32(&data[MAGIC.size()]); version != VERSION) {
+		throw MSXException("Unsupported coverage file version: ", version);
+	}
+	auto num = Endian::read_UA_L32(&data[MAGIC.size() + 4]);
+	data = data.subspan(FILE_HEADER_SIZE);
+
+	std::vector<Bitmap> result;
+	repeat(num, [&] {
+		if (data.size() < BITMAP_HEADER_SIZE) {
+			throw MSXException("Corrupt coverage file.");
+		}
+		Bitmap bitmap;
+		bitmap.ps = data[0];
+		bitmap.ss = data[1];
+		auto kind = data[2];
+		auto size = Endian::read_UA_L32(&data[4]);
+		data = data.subspan(BITMAP_HEADER_SIZE);
+		if ((bitmap.ps >= 4) || (bitmap.ss >= 4) || (kind >= NUM_KINDS) ||
+		    (size > data.size())) {
+			throw MSXException("Corrupt coverage file.");
+		}
+		bitmap.kind = Kind(kind);
+		bitmap.bits.assign(data.begin(), data.begin() + size);
+		data = data.subspan(size);
+		result.push_back(std::move(bitmap));
+	});
+	if (!data.empty()) {
+		throw MSXException("Corrupt coverage file.");
+	}
+	return result;
+}
+
+} // namespace openmsx
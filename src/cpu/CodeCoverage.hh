@@ -0,0 +1,90 @@
+#ifndef CODECOVERAGE_HH
+#define CODECOVERAGE_HH
+
+#include "span.hh"
+#include "likely.hh"
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace openmsx {
+
+/** Keeps track of which memory locations were executed, read and written.
+  *
+  * There's one bitmap per (primary slot, secondary slot) and per kind of
+  * access. Bit 'n' in such a bitmap corresponds to offset 'n' in the memory
+  * of the device in that slot (see MSXDevice::getCoverageOffset()), so for
+  * a memory mapper or a bank switched ROM, offset 'n' is byte 'n % 0x4000'
+  * in segment 'n / 0x4000'. A bitmap initially covers 64kB and grows when
+  * higher offsets are touched.
+  *
+  * For execution only the address of the first opcode byte of each
+  * instruction is marked. The opcode fetches themselves are (also) marked
+  * as reads.
+  *
+  * File format (all numbers are little endian):
+  *   header: 16 bytes "openMSX coverage", 4 bytes version (1),
+  *           4 bytes number of bitmaps
+  *   followed by that many bitmaps, each bitmap has:
+  *     1 byte primary slot, 1 byte secondary slot,
+  *     1 byte kind (0 = exec, 1 = read, 2 = write), 1 byte zero,
+  *     4 bytes size (in bytes), the bitmap itself (bit 0 of byte 0
+  *     corresponds to offset 0)
+  *   Bitmaps without any bit set are not stored.
+  */
+class CodeCoverage
+{
+public:
+	enum Kind { EXEC, READ, WRITE, NUM_KINDS };
+	static constexpr unsigned NUM_SLOTS = 4 * 4;
+	static constexpr unsigned INITIAL_SIZE = 0x10000 / 8;
+
+	struct Bitmap {
+		unsigned ps;
+		unsigned ss;
+		Kind kind;
+		std::vector<uint8_t> bits;
+	};
+
+	void mark(Kind kind, unsigned ps, unsigned ss, unsigned offset) {
+		auto& bits = bitmaps[4 * ps + ss][kind];
+		unsigned index = offset / 8;
+		if (unlikely(index >= bits.size())) grow(bits, index);
+		bits[index] |= 1 << (offset & 7);
+	}
+
+	[[nodiscard]] span<const uint8_t> getBitmap(Kind kind, unsigned ps, unsigned ss) const {
+		return bitmaps[4 * ps + ss][kind];
+	}
+	[[nodiscard]] span<uint8_t> getBitmap(Kind kind, unsigned ps, unsigned ss) {
+		return bitmaps[4 * ps + ss][kind];
+	}
+
+	/** Number of marked locations. */
+	[[nodiscard]] uint64_t count(Kind kind, unsigned ps, unsigned ss) const;
+	[[nodiscard]] uint64_t count(Kind kind) const;
+
+	/** Unmark all locations (the size of the bitmaps is kept). */
+	void clear();
+
+	/** Produce the content of a coverage file, in one or more pieces. */
+	void write(const std::function<void(span<const uint8_t>)>& output) const;
+	/** Write the coverage data to a file.
+	  * @throws FileException */
+	void save(const std::string& filename) const;
+
+	/** Parse the content of a coverage file.
+	  * @throws MSXException when the data is not a valid coverage file. */
+	[[nodiscard]] static std::vector<Bitmap> parse(span<const uint8_t> data);
+
+private:
+	static void grow(std::vector<uint8_t>& bits, unsigned index);
+
+private:
+	std::vector<uint8_t> bitmaps[NUM_SLOTS][NUM_KINDS];
+};
+
+} // namespace openmsx
+
+#endif
@@ -0,0 +1,304 @@
+#include "CompiledCondition.hh"
+#include "StringOp.hh"
+#include <array>
+#include <utility>
+
+namespace openmsx {
+
+namespace {
+
+using Op = CompiledCondition::Op;
+using Instruction = CompiledCondition::Instruction;
+
+struct RegName {
+	std::string_view name;
+	int index;
+	bool word;
+};
+// Same names and indices as the 'reg' proc in _cpuregs.tcl (which maps on
+// the 'CPU regs' debuggable).
+constexpr RegName regNames[] = {
+	{"A",    0, false}, {"F",    1, false}, {"B",    2, false}, {"C",    3, false},
+	{"D",    4, false}, {"E",    5, false}, {"H",    6, false}, {"L",    7, false},
+	{"A2",   8, false}, {"F2",   9, false}, {"B2",  10, false}, {"C2",  11, false},
+	{"D2",  12, false}, {"E2",  13, false}, {"H2",  14, false}, {"L2",  15, false},
+	{"IXH", 16, false}, {"IXL", 17, false}, {"IYH", 18, false}, {"IYL", 19, false},
+	{"PCH", 20, false}, {"PCL", 21, false}, {"SPH", 22, false}, {"SPL", 23, false},
+	{"I",   24, false}, {"R",   25, false}, {"IM",  26, false}, {"IFF", 27, false},
+	{"AF",   0, true }, {"BC",   2, true }, {"DE",   4, true }, {"HL",   6, true },
+	{"AF2",  8, true }, {"BC2", 10, true }, {"DE2", 12, true }, {"HL2", 14, true },
+	{"IX",  16, true }, {"IY",  18, true }, {"PC",  20, true }, {"SP",  22, true },
+};
+
+[[nodiscard]] const RegName* lookupReg(std::string_view name)
+{
+	auto upper = [](char c) { return ((c >= 'a') && (c <= 'z')) ? char(c - 'a' + 'A') : c; };
+	for (const auto& r : regNames) {
+		if (r.name.size() != name.size()) continue;
+		bool match = true;
+		for (size_t i = 0; i < name.size(); ++i) {
+			if (upper(name[i]) != r.name[i]) { match = false; break; }
+		}
+		if (match) return &r;
+	}
+	return nullptr;
+}
+
+// Binary operators, grouped per precedence level (lowest first). Within a
+// level, longer operators must come before their prefixes.
+struct BinOp {
+	std::string_view str;
+	Op op;
+};
+constexpr BinOp level0[] = {{"||", Op::LOG_OR}};
+constexpr BinOp level1[] = {{"&&", Op::LOG_AND}};
+constexpr BinOp level2[] = {{"|",  Op::BIT_OR}};
+constexpr BinOp level3[] = {{"^",  Op::BIT_XOR}};
+constexpr BinOp level4[] = {{"&",  Op::BIT_AND}};
+constexpr BinOp level5[] = {{"==", Op::EQ}, {"!=", Op::NE}};
+constexpr BinOp level6[] = {{"<=", Op::LE}, {">=", Op::GE}, {"<", Op::LT}, {">", Op::GT}};
+constexpr BinOp level7[] = {{"<<", Op::SHL}, {">>", Op::SHR}};
+constexpr BinOp level8[] = {{"+",  Op::ADD}, {"-", Op::SUB}};
+constexpr BinOp level9[] = {{"*",  Op::MUL}};
+
+struct Level {
+	const BinOp* begin;
+	const BinOp* end;
+};
+constexpr Level levels[] = {
+	{std::begin(level0), std::end(level0)}, {std::begin(level1), std::end(level1)},
+	{std::begin(level2), std::end(level2)}, {std::begin(level3), std::end(level3)},
+	{std::begin(level4), std::end(level4)}, {std::begin(level5), std::end(level5)},
+	{std::begin(level6), std::end(level6)}, {std::begin(level7), std::end(level7)},
+	{std::begin(level8), std::end(level8)}, {std::begin(level9), std::end(level9)},
+};
+constexpr unsigned NUM_LEVELS = std::size(levels);
+
+class Compiler
+{
+public:
+	Compiler(std::string_view input_, Instruction* out_, unsigned capacity_)
+		: input(input_), out(out_), capacity(capacity_) {}
+
+	// Returns the number of generated instructions, 0 on failure.
+	[[nodiscard]] unsigned compile()
+	{
+		if (!parseExpr(0)) return 0;
+		skipSpace();
+		if (!input.empty()) return 0;
+		return size;
+	}
+
+private:
+	[[nodiscard]] bool emit(Op op, int32_t value = 0)
+	{
+		if (size == capacity) return false;
+		switch (op) {
+		case Op::LITERAL: case Op::REG8: case Op::REG16: case Op::IN_SLOT:
+			isSlotResult[depth++] = (op == Op::IN_SLOT);
+			break;
+		case Op::NOT:
+			isSlotResult[depth - 1] = false;
+			break;
+		case Op::PEEK: case Op::PEEK16: case Op::BIT_NOT: case Op::NEG:
+			if (isSlotResult[depth - 1]) return false;
+			break;
+		case Op::LOG_AND: case Op::LOG_OR:
+			--depth;
+			isSlotResult[depth - 1] = false;
+			break;
+		default: // the other binary operators
+			--depth;
+			if (isSlotResult[depth - 1] || isSlotResult[depth]) return false;
+			break;
+		}
+		out[size++] = Instruction{op, value};
+		return true;
+	}
+
+	void skipSpace()
+	{
+		while (!input.empty() && isSpace(input.front())) {
+			input.remove_prefix(1);
+		}
+	}
+	[[nodiscard]] static bool isSpace(char c)
+	{
+		return (c == ' ') || (c == '\t') || (c == '\n') || (c == '\r');
+	}
+
+	[[nodiscard]] bool consume(std::string_view token)
+	{
+		skipSpace();
+		if (!StringOp::startsWith(input, token)) return false;
+		input.remove_prefix(token.size());
+		return true;
+	}
+
+	// Binary operator at the given precedence level. Make sure e.g. '&'
+	// doesn't match the first half of '&&' and '<' not the first half
+	// of '<<'.
+	[[nodiscard]] const BinOp* matchBinOp(unsigned level)
+	{
+		skipSpace();
+		for (const auto* b = levels[level].begin; b != levels[level].end; ++b) {
+			if (!StringOp::startsWith(input, b->str)) continue;
+			if (input.size() > b->str.size()) {
+				char next = input[b->str.size()];
+				char last = b->str.back();
+				if ((b->str.size() == 1) && (next == last) &&
+				    ((last == '&') || (last == '|') || (last == '<') || (last == '>'))) {
+					continue;
+				}
+				if ((b->str.size() == 1) && (next == '=') &&
+				    ((last == '<') || (last == '>'))) {
+					continue;
+				}
+			}
+			input.remove_prefix(b->str.size());
+			return b;
+		}
+		return nullptr;
+	}
+
+	[[nodiscard]] bool parseExpr(unsigned level)
+	{
+		if (level == NUM_LEVELS) return parseUnary();
+		if (!parseExpr(level + 1)) return false;
+		while (const auto* b = matchBinOp(level)) {
+			if (!parseExpr(level + 1)) return false;
+			if (!emit(b->op)) return false;
+		}
+		return true;
+	}
+
+	[[nodiscard]] bool parseUnary()
+	{
+		skipSpace();
+		if (input.empty()) return false;
+		char c = input.front();
+		if ((c == '!') && !StringOp::startsWith(input, "!=")) {
+			input.remove_prefix(1);
+			return parseUnary() && emit(Op::NOT);
+		} else if (c == '~') {
+			input.remove_prefix(1);
+			return parseUnary() && emit(Op::BIT_NOT);
+		} else if (c == '-') {
+			input.remove_prefix(1);
+			return parseUnary() && emit(Op::NEG);
+		} else if (c == '+') {
+			input.remove_prefix(1);
+			return parseUnary() && !isSlotResult[depth - 1];
+		}
+		return parsePrimary();
+	}
+
+	[[nodiscard]] bool parsePrimary()
+	{
+		skipSpace();
+		if (consume("(")) {
+			return parseExpr(0) && consume(")");
+		} else if (consume("[")) {
+			return parseCommand();
+		} else {
+			auto n = parseNumber();
+			return n && emit(Op::LITERAL, *n);
+		}
+	}
+
+	// A Tcl word consisting of only 'simple' characters, so no quoting,
+	// variable or command substitution.
+	[[nodiscard]] std::string_view parseWord()
+	{
+		skipSpace();
+		size_t i = 0;
+		while (i < input.size()) {
+			char c = input[i];
+			bool ok = ((c >= '0') && (c <= '9')) ||
+			          ((c >= 'a') && (c <= 'z')) ||
+			          ((c >= 'A') && (c <= 'Z')) ||
+			          (c == '_');
+			if (!ok) break;
+			++i;
+		}
+		auto result = input.substr(0, i);
+		input.remove_prefix(i);
+		return result;
+	}
+
+	[[nodiscard]] std::optional<int32_t> parseNumber()
+	{
+		auto word = parseWord();
+		if (word.empty()) return {};
+		// Tcl interprets a leading '0' as octal, StringOp::stringTo()
+		// as decimal. Avoid that difference.
+		if ((word.size() > 1) && (word[0] == '0') &&
+		    (word[1] >= '0') && (word[1] <= '9')) {
+			return {};
+		}
+		return StringOp::stringTo<int32_t>(word);
+	}
+
+	// Command substitution, the opening '[' is already consumed.
+	[[nodiscard]] bool parseCommand()
+	{
+		auto name = parseWord();
+		if ((name == "peek") || (name == "peek8") || (name == "peek_u8")) {
+			return parseArgument() && emit(Op::PEEK) && consume("]");
+		} else if ((name == "peek16") || (name == "peek_u16")) {
+			return parseArgument() && emit(Op::PEEK16) && consume("]");
+		} else if (name == "reg") {
+			const auto* r = lookupReg(parseWord());
+			return r && emit(r->word ? Op::REG16 : Op::REG8, r->index) &&
+			       consume("]");
+		} else if (name == "pc_in_slot") {
+			auto ps = parseNumber();
+			if (!ps || (*ps < 0) || (*ps > 3)) return false;
+			int ss = 0xff;
+			skipSpace();
+			if (!StringOp::startsWith(input, "]")) {
+				auto w = parseWord();
+				if (w != "X") {
+					auto s = StringOp::stringTo<int>(w);
+					if (!s || (*s < 0) || (*s > 3)) return false;
+					ss = *s;
+				}
+			}
+			// the optional 'mapper' argument is not supported
+			return consume("]") && emit(Op::IN_SLOT, *ps | (ss << 8));
+		}
+		return false;
+	}
+
+	// A command argument: a number or a nested command substitution.
+	[[nodiscard]] bool parseArgument()
+	{
+		skipSpace();
+		if (consume("[")) return parseCommand();
+		auto n = parseNumber();
+		return n && emit(Op::LITERAL, *n);
+	}
+
+private:
+	std::string_view input;
+	Instruction* out;
+	unsigned capacity;
+	unsigned size = 0;
+
+	// For each value on the stack (while evaluating): is it the result of
+	// 'pc_in_slot'? The Tcl proc returns the string "true" (or 0), that
+	// only acts like 1 as a boolean: for '!', '&&', '||' or as the final
+	// result. Any other use is left to Tcl.
+	std::array<bool, CompiledCondition::MAX_INSTRUCTIONS> isSlotResult = {};
+	unsigned depth = 0;
+};
+
+} // anonymous namespace
+
+CompiledCondition::CompiledCondition(std::string_view expression)
+{
+	Compiler compiler(expression, code.data(), MAX_INSTRUCTIONS);
+	size = uint8_t(compiler.compile());
+}
+
+} // namespace openmsx
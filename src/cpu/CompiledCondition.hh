@@ -0,0 +1,167 @@
+#ifndef COMPILEDCONDITION_HH
+#define COMPILEDCONDITION_HH
+
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <string_view>
+
+namespace openmsx {
+
+/** Native version of a (simple) breakpoint/condition Tcl expression.
+ *
+ * Evaluating a condition via Tcl on every emulated instruction is slow. Many
+ * conditions only use a small subset of Tcl, for example
+ *     [reg A] == 0x12 && [peek [reg HL]] != 0
+ *     [pc_in_slot 3 1]
+ * Such expressions are translated into a short sequence of stack-machine
+ * instructions. Anything outside that subset (variables, string operators,
+ * other commands, ...) is rejected at compile time, the caller should then
+ * keep using Tcl.
+ *
+ * Supported:
+ *  - integer literals (decimal, 0x.., 0b..)
+ *  - unary  ! ~ - +
+ *  - binary * + - << >> < <= > >= == != & ^ | && ||  (with Tcl precedence)
+ *  - parentheses
+ *  - [reg <name>]  (same register names as the 'reg' Tcl proc)
+ *  - [peek <addr>], [peek16 <addr>]
+ *  - [pc_in_slot <ps> ?<ss>?]  (only as a boolean: operand of ! && || or
+ *    as the result, the Tcl proc returns "true" which isn't a number)
+ *  where <addr> is an integer literal or again one of these commands.
+ *
+ * This class is trivially copyable (no heap allocation): breakpoints are
+ * copied before they get checked.
+ */
+class CompiledCondition
+{
+public:
+	static constexpr unsigned MAX_INSTRUCTIONS = 32;
+
+	enum class Op : uint8_t {
+		LITERAL, // push value
+		REG8,    // push 8-bit register, value is 'CPU regs' debuggable index
+		REG16,   // idem for 16-bit register pair (index of the high byte)
+		PEEK,    // replace top with 8-bit memory value
+		PEEK16,  // replace top with 16-bit (little endian) memory value
+		IN_SLOT, // push pc_in_slot result, value = ps | (ss << 8), ss=0xff: any
+		NOT, BIT_NOT, NEG,
+		MUL, ADD, SUB, SHL, SHR,
+		LT, LE, GT, GE, EQ, NE,
+		BIT_AND, BIT_XOR, BIT_OR, LOG_AND, LOG_OR,
+	};
+	struct Instruction {
+		Op op;
+		int32_t value;
+	};
+
+	/** Try to compile the given expression. Check the result with
+	  * isValid(). */
+	explicit CompiledCondition(std::string_view expression);
+
+	[[nodiscard]] bool isValid() const { return size != 0; }
+
+	/** Evaluate the compiled expression.
+	  * The environment must provide:
+	  *   uint8_t readReg(unsigned index);  // see 'CPU regs' debuggable
+	  *   uint8_t peek(uint16_t address);
+	  *   bool inSlot(int ps, int ss);      // ss == -1: any subslot
+	  * Returns an empty optional when evaluation hit a case that would
+	  * behave differently than in Tcl (e.g. out-of-range address), the
+	  * caller should then evaluate the expression via Tcl. */
+	template<typename Env>
+	[[nodiscard]] std::optional<bool> evaluate(Env& env) const;
+
+private:
+	std::array<Instruction, MAX_INSTRUCTIONS> code;
+	uint8_t size = 0;
+};
+
+
+template<typename Env>
+std::optional<bool> CompiledCondition::evaluate(Env& env) const
+{
+	// Intermediate values are kept in the 32-bit range, outside that
+	// range Tcl would switch to wide/big integers.
+	auto inRange = [](int64_t v) { return (INT32_MIN <= v) && (v <= INT32_MAX); };
+	auto validAddr = [](int64_t a) { return (0 <= a) && (a <= 0xffff); };
+
+	std::array<int64_t, MAX_INSTRUCTIONS> stack;
+	unsigned sp = 0;
+	for (unsigned i = 0; i < size; ++i) {
+		const auto& instr = code[i];
+		switch (instr.op) {
+		case Op::LITERAL:
+			stack[sp++] = instr.value;
+			break;
+		case Op::REG8:
+			stack[sp++] = env.readReg(instr.value);
+			break;
+		case Op::REG16:
+			stack[sp++] = 256 * env.readReg(instr.value + 0) +
+			                    env.readReg(instr.value + 1);
+			break;
+		case Op::PEEK: {
+			auto addr = stack[sp - 1];
+			if (!validAddr(addr)) return {};
+			stack[sp - 1] = env.peek(uint16_t(addr));
+			break;
+		}
+		case Op::PEEK16: {
+			// like the Tcl proc: two separate peeks, 0xffff+1 is an error
+			auto addr = stack[sp - 1];
+			if (!validAddr(addr) || !validAddr(addr + 1)) return {};
+			stack[sp - 1] = env.peek(uint16_t(addr + 0)) +
+			          256 * env.peek(uint16_t(addr + 1));
+			break;
+		}
+		case Op::IN_SLOT: {
+			int ps = instr.value & 0xff;
+			int ss = (instr.value >> 8) & 0xff;
+			stack[sp++] = env.inSlot(ps, (ss == 0xff) ? -1 : ss);
+			break;
+		}
+		case Op::NOT:     stack[sp - 1] = !stack[sp - 1]; break;
+		case Op::BIT_NOT: stack[sp - 1] = ~stack[sp - 1]; break;
+		case Op::NEG:     stack[sp - 1] = -stack[sp - 1]; break;
+		default: {
+			--sp;
+			auto a = stack[sp - 1];
+			auto b = stack[sp];
+			int64_t r = 0;
+			switch (instr.op) {
+			case Op::MUL: r = a * b; break;
+			case Op::ADD: r = a + b; break;
+			case Op::SUB: r = a - b; break;
+			case Op::SHL:
+				if ((b < 0) || (b > 31)) return {};
+				r = a * (int64_t(1) << b); // no UB for negative 'a'
+				break;
+			case Op::SHR:
+				if ((b < 0) || (b > 31)) return {};
+				r = a >> b; // arithmetic shift, same as Tcl
+				break;
+			case Op::LT:      r = a <  b; break;
+			case Op::LE:      r = a <= b; break;
+			case Op::GT:      r = a >  b; break;
+			case Op::GE:      r = a >= b; break;
+			case Op::EQ:      r = a == b; break;
+			case Op::NE:      r = a != b; break;
+			case Op::BIT_AND: r = a & b; break;
+			case Op::BIT_XOR: r = a ^ b; break;
+			case Op::BIT_OR:  r = a | b; break;
+			case Op::LOG_AND: r = a && b; break;
+			case Op::LOG_OR:  r = a || b; break;
+			default: return {};
+			}
+			stack[sp - 1] = r;
+		}
+		}
+		if (!inRange(stack[sp - 1])) return {};
+	}
+	return stack[0] != 0;
+}
+
+} // namespace openmsx
+
+#endif
@@ -15,29 +15,30 @@ static constexpr int abs(unsigned char a)
 	return (a & 128) ? (256 - a) : a;
 }
 
-unsigned dasm(const MSXCPUInterface& interf, word pc, byte buf[4],
-              std::string& dest, EmuTime::param time)
+// 'fetch(i)' returns the i-th byte of the instruction.
+template<typename FETCH>
+static unsigned dasmImpl(FETCH fetch, word pc, byte buf[4], std::string& dest)
 {
 	const char* r = nullptr;
 
-	buf[0] = interf.peekMem(pc, time);
+	buf[0] = fetch(0);
 	auto [s, i] = [&]() -> std::pair<const char*, unsigned> {
 		switch (buf[0]) {
 			case 0xCB:
-				buf[1] = interf.peekMem(pc + 1, time);
+				buf[1] = fetch(1);
 				return {mnemonic_cb[buf[1]], 2};
 			case 0xED:
-				buf[1] = interf.peekMem(pc + 1, time);
+				buf[1] = fetch(1);
 				return {mnemonic_ed[buf[1]], 2};
 			case 0xDD:
 			case 0xFD:
 				r = (buf[0] == 0xDD) ? "ix" : "iy";
-				buf[1] = interf.peekMem(pc + 1, time);
+				buf[1] = fetch(1);
 				if (buf[1] != 0xcb) {
 					return {mnemonic_xx[buf[1]], 2};
 				} else {
-					buf[2] = interf.peekMem(pc + 2, time);
-					buf[3] = interf.peekMem(pc + 3, time);
+					buf[2] = fetch(2);
+					buf[3] = fetch(3);
 					return {mnemonic_xx_cb[buf[3]], 4};
 				}
 			default:
@@ -48,25 +49,25 @@ unsigned dasm(const MSXCPUInterface& interf, word pc, byte buf[4],
 	for (int j = 0; s[j]; ++j) {
 		switch (s[j]) {
 		case 'B':
-			buf[i] = interf.peekMem(pc + i, time);
+			buf[i] = fetch(i);
 			strAppend(dest, '#', hex_string<2>(
 				static_cast<uint16_t>(buf[i])));
 			i += 1;
 			break;
 		case 'R':
-			buf[i] = interf.peekMem(pc + i, time);
+			buf[i] = fetch(i);
 			strAppend(dest, '#', hex_string<4>(
 				pc + 2 + static_cast<int8_t>(buf[i])));
 			i += 1;
 			break;
 		case 'W':
-			buf[i + 0] = interf.peekMem(pc + i + 0, time);
-			buf[i + 1] = interf.peekMem(pc + i + 1, time);
+			buf[i + 0] = fetch(i + 0);
+			buf[i + 1] = fetch(i + 1);
 			strAppend(dest, '#', hex_string<4>(buf[i] + buf[i + 1] * 256));
 			i += 2;
 			break;
 		case 'X':
-			buf[i] = interf.peekMem(pc + i, time);
+			buf[i] = fetch(i);
 			strAppend(dest, '(', r, sign(buf[i]), '#',
 			     hex_string<2>(abs(buf[i])), ')');
 			i += 1;
@@ -103,4 +104,47 @@ unsigned dasm(const MSXCPUInterface& interf, word pc, byte buf[4],
 	return i;
 }
 
+unsigned dasm(const MSXCPUInterface& interf, word pc, byte buf[4],
+              std::string& dest, EmuTime::param time)
+{
+	return dasmImpl([&](unsigned i) { return interf.peekMem(pc + i, time); },
+	                pc, buf, dest);
+}
+
+unsigned dasm(span<const byte> opcode, word pc, byte buf[4], std::string& dest)
+{
+	return dasmImpl([&](unsigned i) -> byte { return (i < opcode.size()) ? opcode[i] : 0; },
+	                pc, buf, dest);
+}
+
+unsigned instructionLength(span<const byte> opcode)
+{
+	auto fetch = [&](unsigned i) -> byte { return (i < opcode.size()) ? opcode[i] : 0; };
+	auto [s, i] = [&]() -> std::pair<const char*, unsigned> {
+		switch (fetch(0)) {
+			case 0xCB: return {mnemonic_cb[fetch(1)], 2};
+			case 0xED: return {mnemonic_ed[fetch(1)], 2};
+			case 0xDD:
+			case 0xFD:
+				if (fetch(1) != 0xcb) {
+					return {mnemonic_xx[fetch(1)], 2};
+				} else {
+					return {mnemonic_xx_cb[fetch(3)], 4};
+				}
+			default:
+				return {mnemonic_main[fetch(0)], 1};
+		}
+	}();
+	for (int j = 0; s[j]; ++j) {
+		switch (s[j]) {
+			case 'B': case 'R': case 'X': i += 1; break;
+			case 'W': i += 2; break;
+			case '!': case '#': return 2;
+			case '@': return 1;
+			default: break;
+		}
+	}
+	return i;
+}
+
 } // namespace openmsx
@@ -3,6 +3,7 @@
 
 #include "EmuTime.hh"
 #include "openmsx.hh"
+#include "span.hh"
 #include <string>
 
 namespace openmsx {
@@ -21,6 +22,17 @@ class MSXCPUInterface;
 unsigned dasm(const MSXCPUInterface& interf, word pc, byte buf[4],
               std::string& dest, EmuTime::param time);
 
+/** Same as above, but disassemble the given opcode bytes instead of
+  * reading them from memory (e.g. when decoding a recorded CPU trace).
+  * Missing bytes (beyond the end of 'opcode') are taken as zero.
+  */
+unsigned dasm(span<const byte> opcode, word pc, byte buf[4], std::string& dest);
+
+/** Length (in bytes) of the instruction starting with the given bytes.
+  * This is the same value as returned by dasm(), but it's a lot cheaper.
+  */
+[[nodiscard]] unsigned instructionLength(span<const byte> opcode);
+
 } // namespace openmsx
 
 #endif
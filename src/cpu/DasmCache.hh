@@ -0,0 +1,83 @@
+#ifndef DASMCACHE_HH
+#define DASMCACHE_HH
+
+#include "Dasm.hh"
+#include "openmsx.hh"
+#include "xrange.hh"
+#include <array>
+#include <string>
+#include <vector>
+
+namespace openmsx {
+
+/** Remembers the disassembly of recently disassembled instructions.
+  *
+  * Debugger GUIs typically disassemble the same memory region over and over
+  * again (e.g. on every screen refresh). The text of a disassembled
+  * instruction only depends on its address and on its opcode bytes. So
+  * instead of tracking all memory writes and bank switches, the cached
+  * result is re-validated by comparing the opcode bytes with the current
+  * memory content. That's a lot cheaper than disassembling again.
+  */
+class DasmCache
+{
+public:
+	/** Number of entries, the cache is direct mapped on the address. */
+	static constexpr unsigned SIZE = 4096;
+
+	struct Entry {
+		std::string text;
+		std::array<byte, 4> bytes;
+		word pc;
+		byte length = 0; // '0' means not (yet) valid
+	};
+
+	/** Disassemble the instruction at 'pc'.
+	  * @param pc The address of the instruction.
+	  * @param peek Function to read a byte from memory (without side
+	  *             effects), 'peek(address)'.
+	  * @return The disassembled instruction, this reference stays valid
+	  *         until the next call.
+	  */
+	template<typename PEEK>
+	const Entry& get(word pc, PEEK peek) {
+		if (entries.empty()) entries.resize(SIZE);
+		auto& e = entries[pc % SIZE];
+		if (isValid(e, pc, peek)) {
+			++hits;
+			return e;
+		}
+		++misses;
+		std::array<byte, 4> opcode;
+		for (auto i : xrange(4)) opcode[i] = peek(word(pc + i));
+		e.text.clear();
+		e.length = byte(dasm(opcode, pc, e.bytes.data(), e.text));
+		e.pc = pc;
+		return e;
+	}
+
+	/** Forget everything (e.g. to free the memory). */
+	void clear() { entries.clear(); }
+
+	[[nodiscard]] uint64_t getHits()   const { return hits; }
+	[[nodiscard]] uint64_t getMisses() const { return misses; }
+
+private:
+	template<typename PEEK>
+	[[nodiscard]] static bool isValid(const Entry& e, word pc, PEEK peek) {
+		if ((e.length == 0) || (e.pc != pc)) return false;
+		for (auto i : xrange(e.length)) {
+			if (peek(word(pc + i)) != e.bytes[i]) return false;
+		}
+		return true;
+	}
+
+private:
+	std::vector<Entry> entries; // allocated on first use
+	uint64_t hits = 0;
+	uint64_t misses = 0;
+};
+
+} // namespace openmsx
+
+#endif
@@ -0,0 +1,102 @@
+#ifndef INSTRUCTIONINDEX_HH
+#define INSTRUCTIONINDEX_HH
+
+#include "EmuTime.hh"
+#include "circular_buffer.hh"
+#include "openmsx.hh"
+#include <optional>
+
+namespace openmsx {
+
+/** Remembers the start time and address of the most recently executed
+  * instructions.
+  *
+  * This is only recorded while the CPU runs in its slow (one instruction at
+  * a time) loop, that is while there are breakpoints or conditions (this
+  * includes stepping in the debugger) or while tracing. Instructions
+  * executed in the fast loop are not recorded, instead the next recorded
+  * instruction gets marked as 'after a gap'.
+  *
+  * The times are points in the current reverse time-line. Because 'reverse
+  * goto' to such a time lands exactly on the start of that instruction,
+  * this allows to step back one instruction (or to the last time a
+  * breakpoint was passed) with a single 'reverse goto'.
+  */
+class InstructionIndex
+{
+public:
+	/** Number of remembered instructions (the buffer is only allocated
+	  * on first use). */
+	static constexpr size_t CAPACITY = 256 * 1024;
+
+	struct Entry {
+		EmuTime time;
+		word pc;
+		bool afterGap; // unrecorded instructions right before this one
+	};
+
+	/** Record the start of an instruction. */
+	void record(EmuTime::param time, word pc) {
+		if (buffer.full()) {
+			if (buffer.capacity() == 0) {
+				buffer.set_capacity(CAPACITY);
+			} else {
+				buffer.pop_front();
+			}
+		}
+		buffer.push_back(Entry{time, pc, gap});
+		gap = false;
+	}
+
+	/** Some instructions were executed without being recorded. */
+	void markGap() { gap = true; }
+
+	/** Forget everything. */
+	void clear() {
+		buffer.clear();
+		gap = true;
+	}
+
+	/** The start time of the instruction right before the current CPU
+	  * position, if that one was recorded. */
+	[[nodiscard]] std::optional<EmuTime> getPrevious() const {
+		if (gap || buffer.empty()) return {};
+		return buffer.back().time;
+	}
+
+	/** The most recent recorded instruction, that started before the
+	  * given time and for which 'pred(entry)' returns true. */
+	template<typename PRED>
+	[[nodiscard]] std::optional<Entry> findLast(EmuTime::param before, PRED pred) const {
+		for (size_t i = buffer.size(); i-- > 0; ) {
+			const auto& e = buffer[i];
+			if ((e.time < before) && pred(e)) return e;
+		}
+		return {};
+	}
+
+	/** Called after the CPU jumped (e.g. via 'reverse goto') to the given
+	  * time in the same time-line: drop the instructions that didn't happen
+	  * yet. When the new position is the start of a recorded instruction
+	  * (that followed its predecessor without a gap), the remaining entries
+	  * are still directly in front of the current position.
+	  */
+	void truncate(EmuTime::param time) {
+		std::optional<Entry> firstDropped;
+		while (!buffer.empty() && (buffer.back().time >= time)) {
+			firstDropped = buffer.back();
+			buffer.pop_back();
+		}
+		gap = !firstDropped || (firstDropped->time != time) || firstDropped->afterGap;
+	}
+
+	[[nodiscard]] size_t size() const { return buffer.size(); }
+
+private:
+	circular_buffer<Entry> buffer;
+	bool gap = true;
+};
+
+} // namespace openmsx
+
+#endif
@@ -2,12 +2,16 @@
 #include "MSXCPUInterface.hh"
 #include "MSXMotherBoard.hh"
 #include "Debugger.hh"
+#include "FileContext.hh"
+#include "FileOperations.hh"
 #include "Scheduler.hh"
 #include "IntegerSetting.hh"
 #include "CPUCore.hh"
 #include "Z80.hh"
 #include "R800.hh"
 #include "TclObject.hh"
+#include "CommandException.hh"
+#include "one_of.hh"
 #include "outer.hh"
 #include "ranges.hh"
 #include "serialize.hh"
@@ -26,13 +30,14 @@ MSXCPU::MSXCPU(MSXMotherBoard& motherboard_)
 	, diHaltCallback(
 		motherboard.getCommandController(), "di_halt_callback",
 		"Tcl proc called when the CPU executed a DI/HALT sequence")
+	, timingStats(motherboard)
 	, z80(std::make_unique<CPUCore<Z80TYPE>>(
-		motherboard, "z80", traceSetting,
-		diHaltCallback, EmuTime::zero()))
+		motherboard, "z80", traceSetting, instructionIndex,
+		diHaltCallback, timingStats, EmuTime::zero()))
 	, r800(motherboard.isTurboR()
 		? std::make_unique<CPUCore<R800TYPE>>(
-			motherboard, "r800", traceSetting,
-			diHaltCallback, EmuTime::zero())
+			motherboard, "r800", traceSetting, instructionIndex,
+			diHaltCallback, timingStats, EmuTime::zero())
 		: nullptr)
 	, timeInfo(motherboard.getMachineInfoCommand())
 	, z80FreqInfo(motherboard.getMachineInfoCommand(), "z80_freq", *z80)
@@ -41,6 +46,7 @@ MSXCPU::MSXCPU(MSXMotherBoard& motherboard_)
 			motherboard.getMachineInfoCommand(), "r800_freq", *r800)
 		: nullptr)
 	, debuggable(motherboard_)
+	, traceRecordCmd(motherboard.getCommandController())
 	, reference(EmuTime::zero())
 {
 	z80Active = true; // setActiveCPU(CPU_Z80);
@@ -177,20 +183,44 @@ void MSXCPU::updateVisiblePage(byte page, byte primarySlot, byte secondarySlot)
 	if (r800) r800->updateVisiblePage(page, primarySlot, secondarySlot);
 }
 
-void MSXCPU::invalidateAllSlotsRWCache(word start, unsigned size)
+void MSXCPU::setCoverage(bool enabled)
+{
+	          z80 ->setCoverage(enabled);
+	if (r800) r800->setCoverage(enabled);
+}
+
+template<bool READ, bool WRITE>
+void MSXCPU::invalidateAllSlots(word start, unsigned size)
 {
-	if (interface) interface->tick(CacheLineCounters::InvalidateAllSlots);
 	auto [cpuReadLines, cpuWriteLines] = z80Active ? z80->getCacheLines() : r800->getCacheLines();
 
 	unsigned first = start / CacheLine::SIZE;
 	unsigned num = (size + CacheLine::SIZE - 1) / CacheLine::SIZE;
-	std::fill_n(cpuReadLines  + first, num, nullptr); // nullptr: means not a valid entry and not
-	std::fill_n(cpuWriteLines + first, num, nullptr); //   yet attempted to fill this entry
+	// nullptr: means not a valid entry and not yet attempted to fill this entry
+	if constexpr (READ)  std::fill_n(cpuReadLines  + first, num, nullptr);
+	if constexpr (WRITE) std::fill_n(cpuWriteLines + first, num, nullptr);
 
 	for (auto i : xrange(16)) {
-		std::fill_n(slotReadLines [i] + first, num, nullptr);
-		std::fill_n(slotWriteLines[i] + first, num, nullptr);
+		if constexpr (READ)  std::fill_n(slotReadLines [i] + first, num, nullptr);
+		if constexpr (WRITE) std::fill_n(slotWriteLines[i] + first, num, nullptr);
 	}
+	if (interface) interface->tick(CacheLineCounters::InvalidatedLines, (READ + WRITE) * 17 * num);
+}
+
+void MSXCPU::invalidateAllSlotsRWCache(word start, unsigned size)
+{
+	if (interface) interface->tick(CacheLineCounters::InvalidateAllSlots);
+	invalidateAllSlots<true, true>(start, size);
+}
+void MSXCPU::invalidateAllSlotsRCache(word start, unsigned size)
+{
+	if (interface) interface->tick(CacheLineCounters::InvalidateAllSlots);
+	invalidateAllSlots<true, false>(start, size);
+}
+void MSXCPU::invalidateAllSlotsWCache(word start, unsigned size)
+{
+	if (interface) interface->tick(CacheLineCounters::InvalidateAllSlots);
+	invalidateAllSlots<false, true>(start, size);
 }
 
 template<bool READ, bool WRITE, bool SUB_START>
@@ -229,6 +259,14 @@ void MSXCPU::setRWCache(unsigned start, unsigned size, const byte* rData, byte*
 	disallowWrite += first;
 	unsigned num = size / CacheLine::SIZE;
 
+	if constexpr (PROFILE_CACHELINES) {
+		if (interface) {
+			interface->tick(SUB_START ? CacheLineCounters::FilledLines
+			                          : CacheLineCounters::InvalidatedLines,
+			                (READ + WRITE) * num);
+		}
+	}
+
 	static auto* const NON_CACHEABLE = reinterpret_cast<byte*>(1);
 	for (auto i : xrange(num)) {
 		if constexpr (READ)  readLines [i] = disallowRead [i] ? NON_CACHEABLE : rData;
@@ -350,12 +388,63 @@ void MSXCPU::update(const Setting& setting) noexcept
 
 // Command
 
+static constexpr char toHex(byte x)
+{
+	return (x < 10) ? (x + '0') : (x - 10 + 'A');
+}
+static constexpr void toHex(byte x, char* buf)
+{
+	buf[0] = toHex(x / 16);
+	buf[1] = toHex(x & 15);
+}
+
+// {text byte ...}, the bytes are 2-digit hex strings
+static void addDasmEntry(TclObject& result, const DasmCache::Entry& entry)
+{
+	result.addListElement(entry.text);
+	char tmp[3]; tmp[2] = 0;
+	for (auto i : xrange(entry.length)) {
+		toHex(entry.bytes[i], tmp);
+		result.addListElement(tmp);
+	}
+}
+
 void MSXCPU::disasmCommand(
 	Interpreter& interp, span<const TclObject> tokens,
-	TclObject& result) const
+	TclObject& result)
 {
-	z80Active ? z80 ->disasmCommand(interp, tokens, result)
-	          : r800->disasmCommand(interp, tokens, result);
+	word address = (tokens.size() < 3) ? getRegisters().getPC()
+	                                   : tokens[2].getInt(interp);
+	EmuTime::param time = getCurrentTime();
+	const auto& entry = dasmCache.get(address, [&](word addr) {
+		return interface->peekMem(addr, time);
+	});
+	addDasmEntry(result, entry);
+}
+
+void MSXCPU::disasmBlockCommand(
+	Interpreter& interp, span<const TclObject> tokens,
+	TclObject& result)
+{
+	if (tokens.size() != 4) throw SyntaxError();
+	word address = tokens[2].getInt(interp);
+	int num = tokens[3].getInt(interp);
+	if ((num < 0) || (num > 0x10000)) {
+		throw CommandException("Number of instructions must be in range 0..65536");
+	}
+	EmuTime::param time = getCurrentTime();
+	auto peek = [&](word addr) { return interface->peekMem(addr, time); };
+	std::vector<TclObject> entries;
+	entries.reserve(num);
+	repeat(num, [&] {
+		const auto& entry = dasmCache.get(address, peek);
+		TclObject line;
+		line.addListElement(address);
+		addDasmEntry(line, entry);
+		entries.push_back(std::move(line));
+		address = word(address + entry.length);
+	});
+	result.addListElements(entries);
 }
 
 void MSXCPU::setPaused(bool paused)
@@ -442,8 +531,13 @@ MSXCPU::Debuggable::Debuggable(MSXMotherBoard& motherboard_)
 byte MSXCPU::Debuggable::read(unsigned address)
 {
 	auto& cpu = OUTER(MSXCPU, debuggable);
-	const CPURegs& regs = cpu.getRegisters();
-	switch (address) {
+	return cpu.peekRegister(address);
+}
+
+byte MSXCPU::peekRegister(unsigned index)
+{
+	const CPURegs& regs = getRegisters();
+	switch (index) {
 	case  0: return regs.getA();
 	case  1: return regs.getF();
 	case  2: return regs.getB();
@@ -522,6 +616,93 @@ void MSXCPU::Debuggable::write(unsigned address, byte value)
 	}
 }
 
+
+// class TraceRecordCmd
+
+MSXCPU::TraceRecordCmd::TraceRecordCmd(CommandController& commandController_)
+	: Command(commandController_, "cputrace_record")
+{
+}
+
+void MSXCPU::TraceRecordCmd::execute(span<const TclObject> tokens, TclObject& result)
+{
+	checkNumArgs(tokens, AtLeast{2}, "subcommand ?arg ...?");
+	auto& cpu = OUTER(MSXCPU, traceRecordCmd);
+	auto& recorder = cpu.traceRecorder;
+	auto setRecorder = [&](CPUTraceRecorder* r) {
+		              cpu.z80 ->setTraceRecorder(r);
+		if (cpu.r800) cpu.r800->setTraceRecorder(r);
+	};
+	executeSubCommand(tokens[1].getString(),
+		"start", [&]{
+			checkNumArgs(tokens, Between{2, 3}, "?size?");
+			int size = (tokens.size() == 3) ? tokens[2].getInt(getInterpreter()) : 64;
+			if (size <= 0) {
+				throw CommandException("Size must be positive");
+			}
+			recorder.start(size_t(size) * 1024 * 1024);
+			setRecorder(&recorder);
+		},
+		"stop", [&]{
+			setRecorder(nullptr);
+			recorder.stop();
+		},
+		"clear", [&]{ recorder.clear(); },
+		"status", [&]{
+			result.addDictKeyValues(
+				"recording", recorder.isRecording(),
+				"instructions", int64_t(recorder.getNumRecords()),
+				"dropped", int64_t(recorder.getNumDropped()),
+				"chunks", int64_t(recorder.getNumChunks()),
+				"memory", int64_t(recorder.getMemoryUsage()));
+		},
+		"save", [&]{
+			checkNumArgs(tokens, 3, "filename");
+			recorder.save(FileOperations::expandTilde(std::string(tokens[2].getString())));
+		},
+		"decode", [&]{
+			checkNumArgs(tokens, 4, "tracefile textfile");
+			result = int64_t(CPUTraceRecorder::decodeToText(
+				FileOperations::expandTilde(std::string(tokens[2].getString())),
+				FileOperations::expandTilde(std::string(tokens[3].getString()))));
+		});
+}
+
+std::string MSXCPU::TraceRecordCmd::help(span<const TclObject> /*tokens*/) const
+{
+	return "cputrace_record <subcommand> [<arguments>]\n"
+	       "  Record a compact binary trace of all executed CPU instructions.\n"
+	       "  This is a lot faster than the 'cputrace' setting and the result is\n"
+	       "  compressed in memory. Only the most recent part of the trace (that\n"
+	       "  fits in the given amount of memory) is kept.\n"
+	       "  Possible subcommands are:\n"
+	       "    start [<size>]               start recording, keep at most <size> MB\n"
+	       "                                 of compressed data (default 64)\n"
+	       "    stop                         stop recording, the data is kept\n"
+	       "    clear                        remove all recorded data\n"
+	       "    status                       returns a dict with statistics\n"
+	       "    save <filename>              save the recorded data to a file\n"
+	       "    decode <tracefile> <textfile>\n"
+	       "                                 convert a saved trace to text, in the same\n"
+	       "                                 format as 'cputrace' (prefixed with the time\n"
+	       "                                 in seconds), returns the number of\n"
+	       "                                 instructions\n";
+}
+
+void MSXCPU::TraceRecordCmd::tabCompletion(std::vector<std::string>& tokens) const
+{
+	using namespace std::literals;
+	if (tokens.size() == 2) {
+		static constexpr std::array subCmds = {
+			"start"sv, "stop"sv, "clear"sv, "status"sv, "save"sv, "decode"sv,
+		};
+		completeString(tokens, subCmds);
+	} else if ((tokens.size() >= 3) && (tokens[1] == one_of("save", "decode"))) {
+		completeFileName(tokens, userFileContext());
+	}
+}
+
+
 // version 1: initial version
 // version 2: activeCPU,newCPU -> z80Active,newZ80Active
 template<typename Archive>
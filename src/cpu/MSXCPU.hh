@@ -1,8 +1,13 @@
 #ifndef MSXCPU_HH
 #define MSXCPU_HH
 
+#include "CPUTraceRecorder.hh"
+#include "DasmCache.hh"
+#include "Command.hh"
 #include "InfoTopic.hh"
+#include "InstructionIndex.hh"
 #include "SimpleDebuggable.hh"
+#include "TimingStats.hh"
 #include "Observer.hh"
 #include "BooleanSetting.hh"
 #include "CacheLine.hh"
@@ -53,6 +58,13 @@ public:
 	  * For example MSXMemoryMapper and MSXGameCartridge need to call this
 	  * method when a 'memory switch' occurs. */
 	void invalidateAllSlotsRWCache(word start, unsigned size);
+	/** As above, but only the read or only the write cache lines. */
+	void invalidateAllSlotsRCache(word start, unsigned size);
+	void invalidateAllSlotsWCache(word start, unsigned size);
+
+	/** Report all executed instructions to
+	  * MSXCPUInterface::markCoverage() (or stop doing that). */
+	void setCoverage(bool enabled);
 
 	/** Similar to the method above, but only invalidates one specific slot.
 	  * One small tweak: lines that are in 'disallowRead/Write' are
@@ -130,7 +142,10 @@ public:
 
 	void disasmCommand(Interpreter& interp,
 	                   span<const TclObject> tokens,
-	                   TclObject& result) const;
+	                   TclObject& result);
+	void disasmBlockCommand(Interpreter& interp,
+	                        span<const TclObject> tokens,
+	                        TclObject& result);
 
 	/** (un)pause CPU. During pause the CPU executes NOP instructions
 	  * continuously (just like during HALT). Used by turbor hw pause. */
@@ -144,6 +159,16 @@ public:
 
 	[[nodiscard]] CPURegs& getRegisters();
 
+	/** The recently executed instructions, see InstructionIndex. */
+	[[nodiscard]] InstructionIndex& getInstructionIndex() { return instructionIndex; }
+
+	/** Statistics about the time the CPU waits for IRQs and the VDP. */
+	[[nodiscard]] TimingStats& getTimingStats() { return timingStats; }
+
+	/** Read one byte of the register file, using the same layout as
+	  * the 'CPU regs' debuggable (index in [0..27]). */
+	[[nodiscard]] byte peekRegister(unsigned index);
+
 	template<typename Archive>
 	void serialize(Archive& ar, unsigned version);
 
@@ -160,10 +185,13 @@ private:
 	  * instead.
 	  * TODO is this comment still true? */
 	EmuTime::param getCurrentTime() const;
+	friend class ProbeRecorder; // only to timestamp samples
 
 	// Observer<Setting>
 	void update(const Setting& setting) noexcept override;
 
+	template<bool READ, bool WRITE>
+	void invalidateAllSlots(word start, unsigned size);
 	template<bool READ, bool WRITE, bool SUB_START>
 	void setRWCache(unsigned start, unsigned size, const byte* rData, byte* wData, int ps, int ss,
 	                const byte* disallowRead, const byte* disallowWrite);
@@ -171,7 +199,9 @@ private:
 private:
 	MSXMotherBoard& motherboard;
 	BooleanSetting traceSetting;
+	InstructionIndex instructionIndex;
 	TclCallback diHaltCallback;
+	TimingStats timingStats; // before z80 and r800
 	const std::unique_ptr<CPUCore<Z80TYPE>> z80;
 	const std::unique_ptr<CPUCore<R800TYPE>> r800; // can be nullptr
 
@@ -205,11 +235,20 @@ private:
 		void write(unsigned address, byte value) override;
 	} debuggable;
 
+	CPUTraceRecorder traceRecorder;
+	struct TraceRecordCmd final : Command {
+		explicit TraceRecordCmd(CommandController& commandController);
+		void execute(span<const TclObject> tokens, TclObject& result) override;
+		[[nodiscard]] std::string help(span<const TclObject> tokens) const override;
+		void tabCompletion(std::vector<std::string>& tokens) const override;
+	} traceRecordCmd;
+
 	EmuTime reference;
 	bool z80Active;
 	bool newZ80Active;
 
 	MSXCPUInterface* interface = nullptr; // only used for debug
+	DasmCache dasmCache; // only used for debug
 };
 SERIALIZE_CLASS_VERSION(MSXCPU, 2);
 
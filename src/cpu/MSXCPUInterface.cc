@@ -16,16 +16,20 @@
 #include "CartridgeSlotManager.hh"
 #include "EventDistributor.hh"
 #include "Event.hh"
+#include "FileOperations.hh"
 #include "HardwareConfig.hh"
 #include "DeviceFactory.hh"
+#include "Debugger.hh"
 #include "ReadOnlySetting.hh"
 #include "serialize.hh"
 #include "checked_cast.hh"
 #include "outer.hh"
 #include "ranges.hh"
 #include "stl.hh"
+#include "strCat.hh"
 #include "unreachable.hh"
 #include "xrange.hh"
+#include <array>
 #include <cstring>
 #include <iomanip>
 #include <iostream>
@@ -43,6 +47,7 @@ static unsigned breakedSettingCount = 0;
 constexpr byte SECONDARY_SLOT_BIT = 0x01;
 constexpr byte MEMORY_WATCH_BIT   = 0x02;
 constexpr byte GLOBAL_RW_BIT      = 0x04;
+constexpr byte COVERAGE_BIT       = 0x08;
 
 std::ostream& operator<<(std::ostream& os, EnumTypeName<CacheLineCounters>)
 {
@@ -66,6 +71,8 @@ std::ostream& operator<<(std::ostream& os, EnumValueName<CacheLineCounters> evn)
 		"FillReadWrite",
 		"FillRead",
 		"FillWrite",
+		"InvalidatedLines",
+		"FilledLines",
 	};
 	return os << names[size_t(evn.e)];
 }
@@ -79,6 +86,7 @@ MSXCPUInterface::MSXCPUInterface(MSXMotherBoard& motherBoard_)
 	, externalSlotInfo(motherBoard_.getMachineInfoCommand())
 	, inputPortInfo (motherBoard_.getMachineInfoCommand())
 	, outputPortInfo(motherBoard_.getMachineInfoCommand())
+	, coverageCmd(motherBoard_.getCommandController())
 	, dummyDevice(DeviceFactory::createDummyDevice(
 		*motherBoard_.getMachineConfig()))
 	, msxcpu(motherBoard_.getCPU())
@@ -138,6 +146,7 @@ MSXCPUInterface::~MSXCPUInterface()
 	}
 
 	removeAllWatchPoints();
+	if (coverageEnabled) setCoverage(false);
 
 	if (delayDevice) {
 		for (auto port : xrange(0x98, 0x9c)) {
@@ -195,6 +204,9 @@ byte MSXCPUInterface::readMemSlow(word address, EmuTime::param time)
 				g.device->globalRead(address, time);
 			}
 		}
+		if (unlikely(coverageEnabled)) {
+			markCoverage(CodeCoverage::READ, address);
+		}
 		// execute read watches before actual read
 		if (readWatchSet[address >> CacheLine::BITS]
 		                [address &  CacheLine::LOW]) {
@@ -229,6 +241,9 @@ void MSXCPUInterface::writeMemSlow(word address, byte value, EmuTime::param time
 				g.device->globalWrite(address, value, time);
 			}
 		}
+		if (unlikely(coverageEnabled)) {
+			markCoverage(CodeCoverage::WRITE, address);
+		}
 		// execute write watches after actual write
 		if (writeWatchSet[address >> CacheLine::BITS]
 		                 [address &  CacheLine::LOW]) {
@@ -237,6 +252,37 @@ void MSXCPUInterface::writeMemSlow(word address, byte value, EmuTime::param time
 	}
 }
 
+void MSXCPUInterface::setCoverage(bool enabled)
+{
+	if (enabled == coverageEnabled) return;
+	coverageEnabled = enabled;
+	if (enabled) createCoverageDebuggables();
+	for (auto i : xrange(CacheLine::NUM)) {
+		if (enabled) {
+			disallowReadCache [i] |=  COVERAGE_BIT;
+			disallowWriteCache[i] |=  COVERAGE_BIT;
+		} else {
+			disallowReadCache [i] &= ~COVERAGE_BIT;
+			disallowWriteCache[i] &= ~COVERAGE_BIT;
+		}
+	}
+	msxcpu.invalidateAllSlotsRWCache(0x0000, 0x10000);
+	msxcpu.setCoverage(enabled);
+}
+
+void MSXCPUInterface::markCoverage(CodeCoverage::Kind kind, word address)
+{
+	unsigned page = address >> 14;
+	unsigned ps = primarySlotState[page];
+	unsigned ss = 0;
+	if (isExpanded(ps)) {
+		// the secondary slot select register is not part of any device
+		if (unlikely((address == 0xFFFF) && (kind != CodeCoverage::EXEC))) return;
+		ss = secondarySlotState[page];
+	}
+	coverage.mark(kind, ps, ss, visibleDevices[page]->getCoverageOffset(address));
+}
+
 void MSXCPUInterface::setExpanded(int ps)
 {
 	if (expanded[ps] == 0) {
@@ -312,6 +358,8 @@ void MSXCPUInterface::unsetExpanded(int ps)
 
 void MSXCPUInterface::changeExpanded(bool newExpanded)
 {
+	// e.g. expanding a slot that's not visible in page 3
+	if (bool(disallowReadCache[0xFF] & SECONDARY_SLOT_BIT) == newExpanded) return;
 	if (newExpanded) {
 		disallowReadCache [0xFF] |=  SECONDARY_SLOT_BIT;
 		disallowWriteCache[0xFF] |=  SECONDARY_SLOT_BIT;
@@ -556,8 +604,10 @@ void MSXCPUInterface::registerGlobalWrite(MSXDevice& device, word address)
 {
 	globalWrites.push_back({&device, address});
 
-	disallowWriteCache[address >> CacheLine::BITS] |= GLOBAL_RW_BIT;
-	msxcpu.invalidateAllSlotsRWCache(address & CacheLine::HIGH, 0x100);
+	auto& disallow = disallowWriteCache[address >> CacheLine::BITS];
+	if (disallow & GLOBAL_RW_BIT) return; // already non-cacheable
+	disallow |= GLOBAL_RW_BIT;
+	msxcpu.invalidateAllSlotsWCache(address & CacheLine::HIGH, 0x100);
 }
 
 void MSXCPUInterface::unregisterGlobalWrite(MSXDevice& device, word address)
@@ -573,15 +623,17 @@ void MSXCPUInterface::unregisterGlobalWrite(MSXDevice& device, word address)
 		}
 	}
 	disallowWriteCache[address >> CacheLine::BITS] &= ~GLOBAL_RW_BIT;
-	msxcpu.invalidateAllSlotsRWCache(address & CacheLine::HIGH, 0x100);
+	msxcpu.invalidateAllSlotsWCache(address & CacheLine::HIGH, 0x100);
 }
 
 void MSXCPUInterface::registerGlobalRead(MSXDevice& device, word address)
 {
 	globalReads.push_back({&device, address});
 
-	disallowReadCache[address >> CacheLine::BITS] |= GLOBAL_RW_BIT;
-	msxcpu.invalidateAllSlotsRWCache(address & CacheLine::HIGH, 0x100);
+	auto& disallow = disallowReadCache[address >> CacheLine::BITS];
+	if (disallow & GLOBAL_RW_BIT) return; // already non-cacheable
+	disallow |= GLOBAL_RW_BIT;
+	msxcpu.invalidateAllSlotsRCache(address & CacheLine::HIGH, 0x100);
 }
 
 void MSXCPUInterface::unregisterGlobalRead(MSXDevice& device, word address)
@@ -597,7 +649,7 @@ void MSXCPUInterface::unregisterGlobalRead(MSXDevice& device, word address)
 		}
 	}
 	disallowReadCache[address >> CacheLine::BITS] &= ~GLOBAL_RW_BIT;
-	msxcpu.invalidateAllSlotsRWCache(address & CacheLine::HIGH, 0x100);
+	msxcpu.invalidateAllSlotsRCache(address & CacheLine::HIGH, 0x100);
 }
 
 ALWAYS_INLINE void MSXCPUInterface::updateVisible(int page, int ps, int ss)
@@ -813,14 +865,14 @@ void MSXCPUInterface::checkBreakPoints(
 	auto& globalCliComm = motherBoard.getReactor().getGlobalCliComm();
 	auto& interp        = motherBoard.getReactor().getInterpreter();
 	for (auto& p : bpCopy) {
-		p.checkAndExecute(globalCliComm, interp);
+		p.checkAndExecute(globalCliComm, interp, motherBoard);
 		if (p.onlyOnce()) {
 			removeBreakPoint(p.getId());
 		}
 	}
 	auto condCopy = conditions;
 	for (auto& c : condCopy) {
-		c.checkAndExecute(globalCliComm, interp);
+		c.checkAndExecute(globalCliComm, interp, motherBoard);
 		if (c.onlyOnce()) {
 			removeCondition(c.getId());
 		}
@@ -935,6 +987,8 @@ void MSXCPUInterface::updateMemWatch(WatchPoint::Type type)
 	for (auto i : xrange(CacheLine::NUM)) {
 		watchSet[i].reset();
 	}
+	auto& index = (type == WatchPoint::READ_MEM) ? readWatchIndex : writeWatchIndex;
+	index.bounds.clear();
 	for (auto& w : watchPoints) {
 		if (w->getType() == type) {
 			unsigned beginAddr = w->getBeginAddress();
@@ -945,21 +999,47 @@ void MSXCPUInterface::updateMemWatch(WatchPoint::Type type)
 				watchSet[addr >> CacheLine::BITS].set(
 				         addr  & CacheLine::LOW);
 			}
+			index.bounds.push_back(beginAddr);
+			index.bounds.push_back(endAddr + 1);
 		}
 	}
-	for (auto i : xrange(CacheLine::NUM)) {
-		if (readWatchSet [i].any()) {
-			disallowReadCache [i] |=  MEMORY_WATCH_BIT;
-		} else {
-			disallowReadCache [i] &= ~MEMORY_WATCH_BIT;
+
+	// rebuild the index
+	ranges::sort(index.bounds);
+	index.bounds.erase(ranges::unique(index.bounds), end(index.bounds));
+	auto numRanges = index.bounds.empty() ? 0 : index.bounds.size() - 1;
+	std::vector<std::vector<std::shared_ptr<WatchPoint>>> perRange(numRanges);
+	for (auto& w : watchPoints) {
+		if (w->getType() != type) continue;
+		auto first = ranges::lower_bound(index.bounds, w->getBeginAddress());
+		auto last  = ranges::lower_bound(index.bounds, w->getEndAddress() + 1);
+		for (auto it = first; it != last; ++it) {
+			perRange[it - begin(index.bounds)].push_back(w);
 		}
-		if (writeWatchSet[i].any()) {
-			disallowWriteCache[i] |=  MEMORY_WATCH_BIT;
+	}
+	index.offsets.clear();
+	index.entries.clear();
+	for (auto& r : perRange) {
+		index.offsets.push_back(unsigned(index.entries.size()));
+		append(index.entries, std::move(r));
+	}
+	index.offsets.push_back(unsigned(index.entries.size()));
+
+	// Only invalidate the lines that (stop to) contain a watchpoint of
+	// this type, e.g. adding a write watchpoint in page 3 doesn't affect
+	// the (read or write) cache lines for the other pages.
+	byte* disallow = (type == WatchPoint::READ_MEM) ? disallowReadCache : disallowWriteCache;
+	for (auto i : xrange(CacheLine::NUM)) {
+		byte newDisallow = watchSet[i].any() ? (disallow[i] |  MEMORY_WATCH_BIT)
+		                                     : (disallow[i] & ~MEMORY_WATCH_BIT);
+		if (newDisallow == disallow[i]) continue;
+		disallow[i] = newDisallow;
+		if (type == WatchPoint::READ_MEM) {
+			msxcpu.invalidateAllSlotsRCache(word(i << CacheLine::BITS), CacheLine::SIZE);
 		} else {
-			disallowWriteCache[i] &= ~MEMORY_WATCH_BIT;
+			msxcpu.invalidateAllSlotsWCache(word(i << CacheLine::BITS), CacheLine::SIZE);
 		}
 	}
-	msxcpu.invalidateAllSlotsRWCache(0x0000, 0x10000);
 }
 
 void MSXCPUInterface::executeMemWatch(WatchPoint::Type type,
@@ -968,6 +1048,16 @@ void MSXCPUInterface::executeMemWatch(WatchPoint::Type type,
 	assert(!watchPoints.empty());
 	if (isFastForward()) return;
 
+	// Only copy the matching watchpoints: keeps them alive and allows the
+	// collection to change while executing them.
+	const auto& index = (type == WatchPoint::READ_MEM) ? readWatchIndex : writeWatchIndex;
+	auto it = ranges::upper_bound(index.bounds, address);
+	if ((it == begin(index.bounds)) || (it == end(index.bounds))) return;
+	auto i = (it - begin(index.bounds)) - 1;
+	std::vector<std::shared_ptr<WatchPoint>> wpCopy(
+		begin(index.entries) + index.offsets[i],
+		begin(index.entries) + index.offsets[i + 1]);
+
 	auto& globalCliComm = motherBoard.getReactor().getGlobalCliComm();
 	auto& interp        = motherBoard.getReactor().getInterpreter();
 	interp.setVariable(TclObject("wp_last_address"),
@@ -977,15 +1067,13 @@ void MSXCPUInterface::executeMemWatch(WatchPoint::Type type,
 		                   TclObject(int(value)));
 	}
 
-	auto wpCopy = watchPoints;
 	for (auto& w : wpCopy) {
-		if ((w->getBeginAddress() <= address) &&
-		    (w->getEndAddress()   >= address) &&
-		    (w->getType()         == type)) {
-			w->checkAndExecute(globalCliComm, interp);
-			if (w->onlyOnce()) {
-				removeWatchPoint(w);
-			}
+		assert((w->getBeginAddress() <= address) &&
+		       (w->getEndAddress()   >= address) &&
+		       (w->getType()         == type));
+		w->checkAndExecute(globalCliComm, interp, motherBoard);
+		if (w->onlyOnce()) {
+			removeWatchPoint(w);
 		}
 	}
 
@@ -1197,7 +1285,7 @@ MSXCPUInterface::IODebug::IODebug(MSXMotherBoard& motherBoard_)
 byte MSXCPUInterface::IODebug::read(unsigned address, EmuTime::param time)
 {
 	auto& interface = OUTER(MSXCPUInterface, ioDebug);
-	return interface.IO_In[address & 0xFF]->peekIO(address, time);
+	return interface.peekIO(address, time);
 }
 
 void MSXCPUInterface::IODebug::write(unsigned address, byte value, EmuTime::param time)
@@ -1243,6 +1331,158 @@ std::string MSXCPUInterface::IOInfo::help(span<const TclObject> /*tokens*/) cons
 }
 
 
+
+// class CoverageDebuggable
+
+static constexpr std::array<std::string_view, CodeCoverage::NUM_KINDS> coverageKindNames = {
+	"exec", "read", "write"
+};
+
+struct MSXCPUInterface::CoverageDebuggable final : Debuggable
+{
+	CoverageDebuggable(MSXCPUInterface& interface_, CodeCoverage::Kind kind_,
+	                   unsigned ps_, unsigned ss_)
+		: interface(interface_), kind(kind_), ps(ps_), ss(ss_)
+		, name(strCat("coverage ", coverageKindNames[kind], ' ', ps))
+	{
+		if (interface.isExpanded(ps)) strAppend(name, '-', ss);
+		description = strCat("Code coverage bitmap of slot ",
+		                     std::string_view(name).substr(name.rfind(' ') + 1),
+		                     ", one bit per ", coverageKindNames[kind],
+		                     " access, see 'help coverage'.");
+		interface.motherBoard.getDebugger().registerDebuggable(name, *this);
+	}
+
+	~CoverageDebuggable()
+	{
+		interface.motherBoard.getDebugger().unregisterDebuggable(name, *this);
+	}
+
+	[[nodiscard]] span<uint8_t> getBitmap() const
+	{
+		return interface.coverage.getBitmap(kind, ps, ss);
+	}
+
+	[[nodiscard]] unsigned getSize() const override
+	{
+		return std::max<unsigned>(CodeCoverage::INITIAL_SIZE, unsigned(getBitmap().size()));
+	}
+
+	[[nodiscard]] std::string_view getDescription() const override
+	{
+		return description;
+	}
+
+	[[nodiscard]] byte read(unsigned address) override
+	{
+		auto bits = getBitmap();
+		return (address < bits.size()) ? bits[address] : 0;
+	}
+
+	void write(unsigned address, byte value) override
+	{
+		// Only allow to modify the part that's already allocated.
+		if (auto bits = getBitmap(); address < bits.size()) {
+			bits[address] = value;
+		}
+	}
+
+	MSXCPUInterface& interface;
+	const CodeCoverage::Kind kind;
+	const unsigned ps;
+	const unsigned ss;
+	std::string name;
+	std::string description;
+};
+
+void MSXCPUInterface::createCoverageDebuggables()
+{
+	// (re)create them, the set of expanded slots may have changed
+	coverageDebuggables.clear();
+	for (auto ps : xrange(4u)) {
+		unsigned numSub = isExpanded(ps) ? 4 : 1;
+		for (auto ss : xrange(numSub)) {
+			for (auto kind : xrange(unsigned(CodeCoverage::NUM_KINDS))) {
+				coverageDebuggables.push_back(std::make_unique<CoverageDebuggable>(
+					*this, CodeCoverage::Kind(kind), ps, ss));
+			}
+		}
+	}
+}
+
+
+// class CoverageCmd
+
+MSXCPUInterface::CoverageCmd::CoverageCmd(CommandController& commandController_)
+	: Command(commandController_, "coverage")
+{
+}
+
+void MSXCPUInterface::CoverageCmd::execute(span<const TclObject> tokens, TclObject& result)
+{
+	checkNumArgs(tokens, AtLeast{2}, "subcommand ?arg ...?");
+	auto& interface = OUTER(MSXCPUInterface, coverageCmd);
+	auto& coverage = interface.coverage;
+	executeSubCommand(tokens[1].getString(),
+		"start", [&]{
+			checkNumArgs(tokens, 2, "");
+			interface.setCoverage(true);
+		},
+		"stop", [&]{
+			checkNumArgs(tokens, 2, "");
+			interface.setCoverage(false);
+		},
+		"clear", [&]{
+			checkNumArgs(tokens, 2, "");
+			coverage.clear();
+		},
+		"status", [&]{
+			checkNumArgs(tokens, 2, "");
+			result.addDictKeyValues(
+				"enabled", interface.isCoverageEnabled(),
+				"executed", int64_t(coverage.count(CodeCoverage::EXEC)),
+				"read", int64_t(coverage.count(CodeCoverage::READ)),
+				"written", int64_t(coverage.count(CodeCoverage::WRITE)));
+		},
+		"save", [&]{
+			checkNumArgs(tokens, 3, "filename");
+			coverage.save(FileOperations::expandTilde(std::string(tokens[2].getString())));
+		});
+}
+
+std::string MSXCPUInterface::CoverageCmd::help(span<const TclObject> /*tokens*/) const
+{
+	return "coverage <subcommand> [<arguments>]\n"
+	       "  Collect code coverage: remember which memory locations were\n"
+	       "  executed, read and written. The locations are tracked per slot and\n"
+	       "  for memory mappers and bank switched ROMs per segment (the offset\n"
+	       "  in the memory of the device). Only the first byte of an instruction\n"
+	       "  is marked as executed. While collecting, all memory accesses are\n"
+	       "  emulated via the slow path (this is a lot faster than watchpoints,\n"
+	       "  but slower than without coverage).\n"
+	       "  The data is available via the 'coverage <kind> <slot>' debuggables.\n"
+	       "  Possible subcommands are:\n"
+	       "    start            start collecting, previously collected data is kept\n"
+	       "    stop             stop collecting, the data is kept\n"
+	       "    clear            forget all collected data\n"
+	       "    status           returns a dict with the number of marked locations\n"
+	       "    save <filename>  save all bitmaps in a binary file\n";
+}
+
+void MSXCPUInterface::CoverageCmd::tabCompletion(std::vector<std::string>& tokens) const
+{
+	using namespace std::literals;
+	if (tokens.size() == 2) {
+		static constexpr std::array subCmds = {
+			"start"sv, "stop"sv, "clear"sv, "status"sv, "save"sv,
+		};
+		completeString(tokens, subCmds);
+	} else if ((tokens.size() == 3) && (tokens[1] == "save")) {
+		completeFileName(tokens, userFileContext());
+	}
+}
+
+
 template<typename Archive>
 void MSXCPUInterface::serialize(Archive& ar, unsigned /*version*/)
 {
@@ -4,6 +4,8 @@
 #include "DebugCondition.hh"
 #include "SimpleDebuggable.hh"
 #include "InfoTopic.hh"
+#include "Command.hh"
+#include "CodeCoverage.hh"
 #include "CacheLine.hh"
 #include "MSXDevice.hh"
 #include "BreakPoint.hh"
@@ -42,6 +44,8 @@ enum CacheLineCounters {
 	FillReadWrite,
 	FillRead,
 	FillWrite,
+	InvalidatedLines, // number of (read or write) cache line entries
+	FilledLines,      //    idem
 	NUM // must be last
 };
 std::ostream& operator<<(std::ostream& os, EnumTypeName<CacheLineCounters>);
@@ -144,11 +148,25 @@ public:
 	/**
 	 * This read a byte from the given IO-port
 	 * @see MSXDevice::readIO()
+	 *
+	 * Note: a table of (function pointer, device) pairs instead of these
+	 * virtual calls was measured to be no faster (both are one indirect
+	 * call, and the vtable is hot for the few busy ports). The wrappers
+	 * (MSXMultiIODevice, VDPIODelay, MSXWatchIODevice) are only inserted
+	 * for ports that need them, the common ports dispatch directly.
 	 */
 	inline byte readIO(word port, EmuTime::param time) {
 		return IO_In[port & 0xFF]->readIO(port, time);
 	}
 
+	/**
+	 * Peek the value of an IO-port (no side effects)
+	 * @see MSXDevice::peekIO()
+	 */
+	[[nodiscard]] byte peekIO(word port, EmuTime::param time) const {
+		return IO_In[port & 0xFF]->peekIO(port, time);
+	}
+
 	/**
 	 * This writes a byte to the given IO-port
 	 * @see MSXDevice::writeIO()
@@ -236,6 +254,12 @@ public:
 	[[nodiscard]] inline bool isExpanded(int ps) const { return expanded[ps] != 0; }
 	void changeExpanded(bool newExpanded);
 
+	/** Currently selected primary/secondary slot and the device that is
+	  * visible in the given page [0..3]. */
+	[[nodiscard]] byte getPrimarySlot  (unsigned page) const { return primarySlotState[page]; }
+	[[nodiscard]] byte getSecondarySlot(unsigned page) const { return secondarySlotState[page]; }
+	[[nodiscard]] MSXDevice* getVisibleMSXDevice(unsigned page) const { return visibleDevices[page]; }
+
 	[[nodiscard]] DummyDevice& getDummyDevice() { return *dummyDevice; }
 
 	static void insertBreakPoint(BreakPoint bp);
@@ -284,6 +308,17 @@ public:
 	void setFastForward(bool fastForward_) { fastForward = fastForward_; }
 	[[nodiscard]] bool isFastForward() const { return fastForward; }
 
+	/** Start or stop collecting code coverage data. While enabled, all
+	  * memory accesses go through the slow path (no CPU cache lines). */
+	void setCoverage(bool enabled);
+	[[nodiscard]] bool isCoverageEnabled() const { return coverageEnabled; }
+	[[nodiscard]] const CodeCoverage& getCoverage() const { return coverage; }
+
+	/** Mark the given address, in the currently selected slots, as
+	  * executed, read or written. Only call this when coverage is enabled.
+	  */
+	void markCoverage(CodeCoverage::Kind kind, word address);
+
 	template<typename Archive>
 	void serialize(Archive& ar, unsigned version);
 
@@ -375,6 +410,16 @@ private:
 		             TclObject& result) const override;
 	} outputPortInfo;
 
+	struct CoverageCmd final : Command {
+		explicit CoverageCmd(CommandController& commandController);
+		void execute(span<const TclObject> tokens, TclObject& result) override;
+		[[nodiscard]] std::string help(span<const TclObject> tokens) const override;
+		void tabCompletion(std::vector<std::string>& tokens) const override;
+	} coverageCmd;
+
+	struct CoverageDebuggable;
+	void createCoverageDebuggables();
+
 	/** Updated visibleDevices for a given page and clears the cache
 	  * on changes.
 	  * Should be called whenever PrimarySlotState or SecondarySlotState
@@ -397,6 +442,20 @@ private:
 	std::bitset<CacheLine::SIZE> readWatchSet [CacheLine::NUM];
 	std::bitset<CacheLine::SIZE> writeWatchSet[CacheLine::NUM];
 
+	// For addresses that pass the (bit)set test above, this finds the
+	// matching memory watchpoints without scanning all of them.
+	// The address space is split in elementary ranges
+	//   [bounds[i], bounds[i + 1])
+	// that are covered by the same set of watchpoints. Those are stored
+	// (in creation order) in 'entries[offsets[i] .. offsets[i + 1])'.
+	struct MemWatchIndex {
+		std::vector<unsigned> bounds;
+		std::vector<unsigned> offsets; // same size as 'bounds'
+		std::vector<std::shared_ptr<WatchPoint>> entries;
+	};
+	MemWatchIndex readWatchIndex;
+	MemWatchIndex writeWatchIndex;
+
 	struct GlobalRwInfo {
 		MSXDevice* device;
 		word addr;
@@ -420,6 +479,10 @@ private:
 
 	bool fastForward; // no need to serialize
 
+	CodeCoverage coverage; // not serialized
+	std::vector<std::unique_ptr<CoverageDebuggable>> coverageDebuggables;
+	bool coverageEnabled = false;
+
 	//  All CPUs (Z80 and R800) of all MSX machines share this state.
 	static inline BreakPoints breakPoints; // sorted on address
 	WatchPoints watchPoints; // ordered in creation order,  TODO must also be static
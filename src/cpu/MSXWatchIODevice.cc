@@ -43,7 +43,7 @@ void WatchIO::doReadCallback(unsigned port)
 	// keep this object alive by holding a shared_ptr to it, for the case
 	// this watchpoint deletes itself in checkAndExecute()
 	auto keepAlive = shared_from_this();
-	checkAndExecute(cliComm, interp);
+	checkAndExecute(cliComm, interp, motherboard);
 	if (onlyOnce()) {
 		cpuInterface.removeWatchPoint(keepAlive);
 	}
@@ -63,7 +63,7 @@ void WatchIO::doWriteCallback(unsigned port, unsigned value)
 
 	// see comment in doReadCallback() above
 	auto keepAlive = shared_from_this();
-	checkAndExecute(cliComm, interp);
+	checkAndExecute(cliComm, interp, motherboard);
 	if (onlyOnce()) {
 		cpuInterface.removeWatchPoint(keepAlive);
 	}
@@ -281,6 +281,12 @@ private:
 	Clock<CLOCK_FREQ> lastRefreshTime;
 	int lastPage;
 
+	// The (ROM/DRAM/external slot) wait states only depend on which
+	// slot is visible in a 16kB page, so they're precomputed per
+	// (page, slot, subslot) and copied per page on a slot switch (see
+	// updateVisiblePage()). The per-access cost is 'extraMemoryDelay'
+	// lookup plus the 'lastPage' compare, a per-CacheLine table would
+	// store the same values 64 times.
 	unsigned extraMemoryDelays[4][4][4];
 	unsigned extraMemoryDelay[4];
 };
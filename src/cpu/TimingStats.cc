@@ -0,0 +1,177 @@
+#include "TimingStats.hh"
+#include "MSXMotherBoard.hh"
+#include "CliComm.hh"
+#include "CommandException.hh"
+#include "TclObject.hh"
+#include "outer.hh"
+#include <array>
+
+namespace openmsx {
+
+TimingStats::TimingStats(MSXMotherBoard& motherBoard_)
+	: Schedulable(motherBoard_.getScheduler())
+	, motherBoard(motherBoard_)
+	, statsInfo(motherBoard.getMachineInfoCommand())
+	, statsCmd(motherBoard.getCommandController())
+{
+}
+
+TimingStats::~TimingStats()
+{
+	stopStream();
+}
+
+void TimingStats::clear()
+{
+	irqLatency.clear();
+	vdpIOStall.clear();
+	vramAccess.clear();
+	cmdDuration.clear();
+	vramTooFast = 0;
+	cmdSlots = 0;
+}
+
+[[nodiscard]] static TclObject toTcl(const LatencyHistogram& histogram)
+{
+	// buckets, without the trailing empty ones
+	const auto& buckets = histogram.getBuckets();
+	size_t num = buckets.size();
+	while ((num > 0) && (buckets[num - 1] == 0)) --num;
+	TclObject list;
+	for (size_t i = 0; i < num; ++i) {
+		list.addListElement(int64_t(buckets[i]));
+	}
+
+	TclObject result;
+	result.addDictKeyValues(
+		"count", int64_t(histogram.getCount()),
+		"sum", int64_t(histogram.getSum()),
+		"min", int64_t(histogram.getMin()),
+		"max", int64_t(histogram.getMax()),
+		"buckets", list);
+	return result;
+}
+
+void TimingStats::getStats(TclObject& result) const
+{
+	result.addDictKeyValues(
+		"irq_latency", toTcl(irqLatency),
+		"vdp_io_stall", toTcl(vdpIOStall),
+		"vram_access", toTcl(vramAccess),
+		"vram_too_fast", int64_t(vramTooFast),
+		"cmd_duration", toTcl(cmdDuration),
+		"cmd_slots", int64_t(cmdSlots));
+}
+
+void TimingStats::startStream(EmuDuration interval)
+{
+	streamInterval = interval;
+	removeSyncPoint();
+	setSyncPoint(getCurrentTime() + streamInterval);
+	streaming = true;
+}
+
+void TimingStats::stopStream()
+{
+	if (!streaming) return;
+	removeSyncPoint();
+	streaming = false;
+}
+
+void TimingStats::executeUntil(EmuTime::param time)
+{
+	TclObject stats;
+	getStats(stats);
+	motherBoard.getMSXCliComm().update(
+		CliComm::STATUS, "timing_stats", stats.getString());
+	setSyncPoint(time + streamInterval);
+}
+
+
+// class StatsInfo
+
+TimingStats::StatsInfo::StatsInfo(InfoCommand& machineInfoCommand)
+	: InfoTopic(machineInfoCommand, "timing_stats")
+{
+}
+
+void TimingStats::StatsInfo::execute(
+	span<const TclObject> /*tokens*/, TclObject& result) const
+{
+	auto& stats = OUTER(TimingStats, statsInfo);
+	stats.getStats(result);
+}
+
+std::string TimingStats::StatsInfo::help(span<const TclObject> /*tokens*/) const
+{
+	return "Returns a dict with statistics about the time the CPU waits for\n"
+	       "interrupts and for the VDP, see 'help timing_stats'.\n";
+}
+
+
+// class StatsCmd
+
+TimingStats::StatsCmd::StatsCmd(CommandController& commandController_)
+	: Command(commandController_, "timing_stats")
+{
+}
+
+void TimingStats::StatsCmd::execute(span<const TclObject> tokens, TclObject& /*result*/)
+{
+	checkNumArgs(tokens, AtLeast{2}, "subcommand ?arg ...?");
+	auto& stats = OUTER(TimingStats, statsCmd);
+	executeSubCommand(tokens[1].getString(),
+		"reset", [&]{
+			checkNumArgs(tokens, 2, "");
+			stats.clear();
+		},
+		"stream", [&]{
+			checkNumArgs(tokens, 3, "interval");
+			if (tokens[2] == "off") {
+				stats.stopStream();
+				return;
+			}
+			double interval = tokens[2].getDouble(getInterpreter());
+			if (interval <= 0.0) {
+				throw CommandException("Interval must be positive");
+			}
+			stats.startStream(EmuDuration(interval));
+		});
+}
+
+std::string TimingStats::StatsCmd::help(span<const TclObject> /*tokens*/) const
+{
+	return "timing_stats <subcommand> [<arguments>]\n"
+	       "  Statistics about the time the CPU waits for interrupts and for the\n"
+	       "  VDP. The statistics themselves are returned by\n"
+	       "  'machine_info timing_stats'. All durations are in cycles of a\n"
+	       "  3.58MHz clock, also for the R800. Each histogram is a dict with\n"
+	       "  'count', 'sum', 'min', 'max' and 'buckets', where bucket 0 counts\n"
+	       "  the value 0 and bucket n counts the values in [2^(n-1), 2^n).\n"
+	       "    irq_latency    from raising an IRQ till the CPU accepts it\n"
+	       "    vdp_io_stall   wait cycles the CPU gets on VDP I/O\n"
+	       "    vram_access    from a CPU VRAM access till its VDP access slot\n"
+	       "    vram_too_fast  number of CPU VRAM accesses that came too soon\n"
+	       "    cmd_duration   duration of the VDP commands\n"
+	       "    cmd_slots      number of VRAM slots used by the command engine\n"
+	       "  Possible subcommands are:\n"
+	       "    reset                 restart counting from zero\n"
+	       "    stream <interval>     every <interval> seconds (in emulated time)\n"
+	       "                          send the statistics as a 'timing_stats'\n"
+	       "                          status update to all connected controllers\n"
+	       "    stream off            stop sending the statistics\n";
+}
+
+void TimingStats::StatsCmd::tabCompletion(std::vector<std::string>& tokens) const
+{
+	using namespace std::literals;
+	if (tokens.size() == 2) {
+		static constexpr std::array subCmds = {"reset"sv, "stream"sv};
+		completeString(tokens, subCmds);
+	} else if ((tokens.size() == 3) && (tokens[1] == "stream")) {
+		static constexpr std::array args = {"off"sv};
+		completeString(tokens, args);
+	}
+}
+
+} // namespace openmsx
@@ -0,0 +1,89 @@
+#ifndef TIMINGSTATS_HH
+#define TIMINGSTATS_HH
+
+#include "Schedulable.hh"
+#include "InfoTopic.hh"
+#include "Command.hh"
+#include "EmuDuration.hh"
+#include "LatencyHistogram.hh"
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+
+namespace openmsx {
+
+class MSXMotherBoard;
+class TclObject;
+
+/** Statistics about the time the CPU loses by waiting for other hardware,
+  * mainly for the VDP.
+  *
+  * All durations are measured in cycles of a 3.58MHz clock (also for the
+  * R800 and for the VDP command engine), so that they can be compared with
+  * each other:
+  *  - irqLatency: from the moment an IRQ gets raised till the CPU accepts
+  *    it (only the first acceptance after each rising edge is counted).
+  *  - vdpIOStall: wait states the CPU gets inserted on VDP I/O, both the
+  *    fixed delay of some engines and the turboR (R800) I/O delay.
+  *  - vramAccess: from a CPU VRAM access till the access slot in which the
+  *    VDP actually executes it. 'vramTooFast' counts the accesses that
+  *    came too soon and overwrote the previous still pending access.
+  *  - cmdDuration: duration of each VDP command, 'cmdSlots' counts the
+  *    VRAM access slots used by the command engine.
+  *
+  * Collecting these is always on (it's cheap). The result can be queried
+  * via 'machine_info timing_stats' and can be periodically sent as a
+  * status update to all CliComm listeners via 'timing_stats stream'.
+  */
+class TimingStats final : private Schedulable
+{
+public:
+	explicit TimingStats(MSXMotherBoard& motherBoard);
+	~TimingStats();
+
+	/** Convert an emulated duration to 3.58MHz cycles (saturates at the
+	  * maximum 32-bit value, that's more than 20 minutes). */
+	[[nodiscard]] static uint32_t toCycles(EmuDuration d) {
+		return uint32_t(std::min<uint64_t>(d.length() / (MAIN_FREQ / 3579545),
+		                                   std::numeric_limits<uint32_t>::max()));
+	}
+
+	void clear();
+	void getStats(TclObject& result) const;
+
+	LatencyHistogram irqLatency;
+	LatencyHistogram vdpIOStall;
+	LatencyHistogram vramAccess;
+	LatencyHistogram cmdDuration;
+	uint64_t vramTooFast = 0;
+	uint64_t cmdSlots = 0;
+
+private:
+	void startStream(EmuDuration interval);
+	void stopStream();
+	void executeUntil(EmuTime::param time) override;
+
+private:
+	MSXMotherBoard& motherBoard;
+
+	struct StatsInfo final : InfoTopic {
+		explicit StatsInfo(InfoCommand& machineInfoCommand);
+		void execute(span<const TclObject> tokens,
+		             TclObject& result) const override;
+		[[nodiscard]] std::string help(span<const TclObject> tokens) const override;
+	} statsInfo;
+
+	struct StatsCmd final : Command {
+		explicit StatsCmd(CommandController& commandController);
+		void execute(span<const TclObject> tokens, TclObject& result) override;
+		[[nodiscard]] std::string help(span<const TclObject> tokens) const override;
+		void tabCompletion(std::vector<std::string>& tokens) const override;
+	} statsCmd;
+
+	EmuDuration streamInterval;
+	bool streaming = false;
+};
+
+} // namespace openmsx
+
+#endif
@@ -61,6 +61,8 @@ void VDPIODelay::delay(EmuTime::param time)
 		// See doc/turbor-vdp-io-timing.ods for details.
 		lastTime += 62; // 8us
 		if (time < lastTime.getTime()) {
+			cpu.getTimingStats().vdpIOStall.add(
+				TimingStats::toCycles(lastTime.getTime() - time));
 			cpu.wait(lastTime.getTime());
 			return;
 		}
@@ -0,0 +1,83 @@
+#include "CheatFinder.hh"
+#include "ranges.hh"
+#include <cassert>
+
+namespace openmsx {
+
+void CheatFinder::start(span<const byte> content)
+{
+	values.assign(content.begin(), content.end());
+	previous = values;
+	numCandidates = values.size();
+	bits.assign((values.size() + 31) / 32, ~uint32_t(0));
+	if (auto rest = values.size() % 32) {
+		bits.back() = (uint32_t(1) << rest) - 1;
+	}
+}
+
+template<typename Pred>
+static size_t filter(std::vector<uint32_t>& bits, Pred pred)
+{
+	size_t num = 0;
+	for (size_t w = 0; w < bits.size(); ++w) {
+		auto mask = bits[w];
+		for (auto todo = mask; todo; todo &= todo - 1) {
+			auto bit = Math::findFirstSet(todo) - 1;
+			if (pred(unsigned(32 * w + bit))) {
+				++num;
+			} else {
+				mask &= ~(uint32_t(1) << bit);
+			}
+		}
+		bits[w] = mask;
+	}
+	return num;
+}
+
+size_t CheatFinder::narrow(span<const byte> current, Relation rel,
+                           std::optional<byte> value)
+{
+	assert(current.size() == values.size());
+	auto doFilter = [&](auto cmp) {
+		numCandidates = filter(bits, [&](unsigned addr) {
+			return cmp(current[addr], value ? *value : values[addr]);
+		});
+	};
+	switch (rel) {
+		case Relation::EQUAL:         doFilter(std::equal_to<>());      break;
+		case Relation::NOT_EQUAL:     doFilter(std::not_equal_to<>());  break;
+		case Relation::LESS:          doFilter(std::less<>());          break;
+		case Relation::GREATER:       doFilter(std::greater<>());       break;
+		case Relation::LESS_EQUAL:    doFilter(std::less_equal<>());    break;
+		case Relation::GREATER_EQUAL: doFilter(std::greater_equal<>()); break;
+		case Relation::ANY: break;
+	}
+	update(current);
+	return numCandidates;
+}
+
+size_t CheatFinder::keep(span<const byte> current, span<const unsigned> addresses)
+{
+	assert(current.size() == values.size());
+	std::vector<uint32_t> keepBits(bits.size());
+	for (auto addr : addresses) {
+		if (addr < values.size()) {
+			keepBits[addr / 32] |= uint32_t(1) << (addr % 32);
+		}
+	}
+	numCandidates = filter(bits, [&](unsigned addr) {
+		return keepBits[addr / 32] & (uint32_t(1) << (addr % 32));
+	});
+	update(current);
+	return numCandidates;
+}
+
+void CheatFinder::update(span<const byte> current)
+{
+	// Both vectors are updated for all addresses, that's cheaper than
+	// only doing it for the candidates.
+	previous.swap(values);
+	ranges::copy(current, values.begin());
+}
+
+} // namespace openmsx
@@ -0,0 +1,74 @@
+#ifndef CHEATFINDER_HH
+#define CHEATFINDER_HH
+
+#include "openmsx.hh"
+#include "Math.hh"
+#include "span.hh"
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+namespace openmsx {
+
+/** Finds the memory locations that hold e.g. the number of lives in a game.
+  *
+  * Start with a snapshot of a debuggable; initially every address is a
+  * candidate. Each narrow() step compares the current content with the
+  * values of the previous step (or with a fixed value) and drops the
+  * candidates that don't satisfy the relation. The candidates are stored as
+  * a dense bitset, so a step only costs a few operations per remaining
+  * candidate.
+  */
+class CheatFinder
+{
+public:
+	enum class Relation {
+		EQUAL, NOT_EQUAL, LESS, GREATER, LESS_EQUAL, GREATER_EQUAL, ANY,
+	};
+
+	/** (Re)start the search, all addresses become candidates. */
+	void start(span<const byte> content);
+	[[nodiscard]] bool isStarted() const { return !values.empty(); }
+
+	/** Only keep the candidates for which 'current[addr] rel compareTo' is
+	  * true, where 'compareTo' is 'value' when given, or otherwise the
+	  * value of the previous step. 'current' must have the same size as
+	  * the initial snapshot.
+	  * @result the number of remaining candidates
+	  */
+	size_t narrow(span<const byte> current, Relation rel,
+	              std::optional<byte> value = {});
+
+	/** Only keep the given addresses (in as far as they are candidates).
+	  * For filters that can't be expressed as a Relation.
+	  */
+	size_t keep(span<const byte> current, span<const unsigned> addresses);
+
+	[[nodiscard]] size_t getSize() const { return values.size(); }
+	[[nodiscard]] size_t getNumCandidates() const { return numCandidates; }
+
+	/** Calls 'op(address, previous, value)' for each candidate (in
+	  * increasing address order), where 'value' is the value in the last
+	  * step and 'previous' the value in the step before that.
+	  */
+	template<typename Op> void forEachCandidate(Op op) const {
+		for (size_t w = 0; w < bits.size(); ++w) {
+			for (auto mask = bits[w]; mask; mask &= mask - 1) {
+				auto addr = unsigned(32 * w + Math::findFirstSet(mask) - 1);
+				op(addr, previous[addr], values[addr]);
+			}
+		}
+	}
+
+private:
+	void update(span<const byte> current);
+
+	std::vector<uint32_t> bits; // one bit per address, set for candidates
+	std::vector<byte> values;
+	std::vector<byte> previous;
+	size_t numCandidates = 0;
+};
+
+} // namespace openmsx
+
+#endif
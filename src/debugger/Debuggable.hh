@@ -2,6 +2,7 @@
 #define DEBUGGABLE_HH
 
 #include "openmsx.hh"
+#include "span.hh"
 #include <string_view>
 
 namespace openmsx {
@@ -17,6 +18,17 @@ public:
 	[[nodiscard]] virtual byte read(unsigned address) = 0;
 	virtual void write(unsigned address, byte value) = 0;
 
+	/** Read 'output.size()' bytes starting at 'start'. The caller must
+	  * make sure the whole range lies within this debuggable. The default
+	  * implementation calls read() for each byte, debuggables that are
+	  * backed by plain memory can do better.
+	  */
+	virtual void readBlock(unsigned start, span<byte> output) {
+		for (size_t i = 0; i < output.size(); ++i) {
+			output[i] = read(start + unsigned(i));
+		}
+	}
+
 protected:
 	Debuggable() = default;
 	~Debuggable() = default;
@@ -1,16 +1,20 @@
 #include "Debugger.hh"
 #include "Debuggable.hh"
 #include "ProbeBreakPoint.hh"
+#include "ProbeRecorder.hh"
 #include "MSXMotherBoard.hh"
 #include "MSXCPU.hh"
 #include "MSXCPUInterface.hh"
 #include "BreakPoint.hh"
 #include "DebugCondition.hh"
+#include "EventDistributor.hh"
+#include "GdbServer.hh"
 #include "MSXWatchIODevice.hh"
+#include "Reactor.hh"
+#include "ReverseManager.hh"
 #include "TclArgParser.hh"
 #include "TclObject.hh"
 #include "CommandException.hh"
-#include "MemBuffer.hh"
 #include "one_of.hh"
 #include "ranges.hh"
 #include "stl.hh"
@@ -31,6 +35,8 @@ Debugger::Debugger(MSXMotherBoard& motherBoard_)
 	, cmd(motherBoard.getCommandController(),
 	      motherBoard.getStateChangeDistributor(),
 	      motherBoard.getScheduler())
+	, profileSampler(motherBoard)
+	, sharedMemoryExporter(*this, motherBoard.getReactor().getEventDistributor())
 {
 }
 
@@ -137,6 +143,20 @@ void Debugger::removeProbeBreakPoint(ProbeBreakPoint& bp)
 		[](auto& v) { return v.get(); }));
 }
 
+ProbeRecorder* Debugger::findProbeRecorder(string_view probeName)
+{
+	auto it = ranges::find(probeRecorders, probeName, [](auto& r) {
+		return r->getProbe().getName();
+	});
+	return (it != std::end(probeRecorders)) ? it->get() : nullptr;
+}
+
+void Debugger::removeProbeRecorder(ProbeRecorder& recorder)
+{
+	move_pop_back(probeRecorders, rfind_unguarded(probeRecorders, &recorder,
+		[](auto& v) { return v.get(); }));
+}
+
 unsigned Debugger::setWatchPoint(TclObject command, TclObject condition,
                                  WatchPoint::Type type,
                                  unsigned beginAddr, unsigned endAddr,
@@ -177,6 +197,26 @@ void Debugger::transfer(Debugger& other)
 		}
 	}
 
+	// Continue probe recordings in the new machine.
+	assert(probeRecorders.empty());
+	for (auto& r : other.probeRecorders) {
+		if (ProbeBase* probe = findProbe(r->getProbe().getName())) {
+			auto& recorder = probeRecorders.emplace_back(
+				std::make_unique<ProbeRecorder>(*this, *probe, 0));
+			recorder->takeOver(*r);
+		}
+	}
+
+	// Keep the shared memory exports going, now with the content of the
+	// new machine.
+	sharedMemoryExporter.takeOver(other.sharedMemoryExporter);
+
+	// The gdb client stays connected, it now debugs the new machine.
+	if (other.gdbServer) {
+		gdbServer = std::move(other.gdbServer);
+		gdbServer->setDebugger(*this);
+	}
+
 	// Breakpoints and conditions are (currently) global, so no need to
 	// copy those.
 }
@@ -207,8 +247,20 @@ bool Debugger::Cmd::needRecord(span<const TclObject> tokens) const
 	// subcommands are recorded and replayed. The 'set_bp' command for
 	// example would allow to set a callback that can execute arbitrary Tcl
 	// code. See comments in RecordedCommand for more details.
+	// A 'batch' is recorded when it contains at least one of these. On
+	// replay it again only executes the data access subcommands.
 	if (tokens.size() < 2) return false;
-	return tokens[1].getString() == one_of("write", "write_block");
+	auto isWrite = [](std::string_view sub) {
+		return sub == one_of("write", "write_block");
+	};
+	if (tokens[1] == "batch") {
+		if (tokens.size() < 3) return false;
+		return ranges::any_of(tokens[2], [&](zstring_view request) {
+			TclObject r(request);
+			return !r.empty() && isWrite(*r.begin());
+		});
+	}
+	return isWrite(tokens[1].getString());
 }
 
 void Debugger::Cmd::execute(
@@ -220,12 +272,18 @@ void Debugger::Cmd::execute(
 		"read_block",        [&]{ readBlock(tokens, result); },
 		"write",             [&]{ write(tokens, result); },
 		"write_block",       [&]{ writeBlock(tokens, result); },
+		"batch",             [&]{ batch(tokens, result); },
+		"snapshot",          [&]{ snapshot(tokens, result); },
+		"diff",              [&]{ diff(tokens, result); },
 		"size",              [&]{ size(tokens, result); },
 		"desc",              [&]{ desc(tokens, result); },
 		"list",              [&]{ list(result); },
 		"step",              [&]{ debugger().motherBoard.getCPUInterface().doStep(); },
+		"step_back",         [&]{ stepBack(tokens); },
+		"reverse_continue",  [&]{ reverseContinue(tokens, result); },
 		"cont",              [&]{ debugger().motherBoard.getCPUInterface().doContinue(); },
 		"disasm",            [&]{ debugger().cpu->disasmCommand(getInterpreter(), tokens, result); },
+		"disasm_block",      [&]{ debugger().cpu->disasmBlockCommand(getInterpreter(), tokens, result); },
 		"break",             [&]{ debugger().motherBoard.getCPUInterface().doBreak(); },
 		"breaked",           [&]{ result = debugger().motherBoard.getCPUInterface().isBreaked(); },
 		"set_bp",            [&]{ setBreakPoint(tokens, result); },
@@ -237,7 +295,11 @@ void Debugger::Cmd::execute(
 		"set_condition",     [&]{ setCondition(tokens, result); },
 		"remove_condition",  [&]{ removeCondition(tokens, result); },
 		"list_conditions",   [&]{ listConditions(tokens, result); },
-		"probe",             [&]{ probe(tokens, result); });
+		"probe",             [&]{ probe(tokens, result); },
+		"profile",           [&]{ profile(tokens, result); },
+		"cheat",             [&]{ cheat(tokens, result); },
+		"export_shm",        [&]{ exportShm(tokens, result); },
+		"gdbserver",         [&]{ gdbServer(tokens, result); });
 }
 
 void Debugger::Cmd::list(TclObject& result)
@@ -285,11 +347,38 @@ void Debugger::Cmd::readBlock(span<const TclObject> tokens, TclObject& result)
 		throw CommandException("Invalid size");
 	}
 
-	MemBuffer<byte> buf(num);
-	for (auto i : xrange(num)) {
-		buf[i] = device.read(addr + i);
+	device.readBlock(addr, result.allocateBinary(num));
+}
+
+void Debugger::Cmd::snapshot(span<const TclObject> tokens, TclObject& result)
+{
+	checkNumArgs(tokens, 3, "debuggable");
+	Debuggable& device = debugger().getDebuggable(tokens[2].getString());
+	device.readBlock(0, result.allocateBinary(device.getSize()));
+}
+
+void Debugger::Cmd::diff(span<const TclObject> tokens, TclObject& result)
+{
+	checkNumArgs(tokens, 4, "debuggable snapshot");
+	Debuggable& device = debugger().getDebuggable(tokens[2].getString());
+	auto old = tokens[3].getBinary();
+	if (old.size() != device.getSize()) {
+		throw CommandException("Snapshot size doesn't match the size "
+		                       "of the debuggable");
+	}
+	std::vector<byte> current(old.size());
+	device.readBlock(0, current);
+
+	std::vector<TclObject> changed;
+	size_t i = 0, size = current.size();
+	while (true) {
+		while ((i < size) && (current[i] == old[i])) ++i;
+		if (i == size) break;
+		size_t start = i;
+		while ((i < size) && (current[i] != old[i])) ++i;
+		changed.push_back(makeTclList(int(start), int(i - start)));
 	}
-	result = span<byte>{buf.data(), num};
+	result.addListElements(changed);
 }
 
 void Debugger::Cmd::write(span<const TclObject> tokens, TclObject& /*result*/)
@@ -328,6 +417,34 @@ void Debugger::Cmd::writeBlock(span<const TclObject> tokens, TclObject& /*result
 	}
 }
 
+void Debugger::Cmd::batch(span<const TclObject> tokens, TclObject& result)
+{
+	checkNumArgs(tokens, 3, "requests");
+	auto& interp = getInterpreter();
+	const auto& requests = tokens[2];
+	std::vector<TclObject> subTokens;
+	for (auto i : xrange(requests.getListLength(interp))) {
+		auto request = requests.getListIndex(interp, i);
+		auto num = request.getListLength(interp);
+		if (num == 0) {
+			throw CommandException("Empty request in batch");
+		}
+		subTokens.clear();
+		subTokens.push_back(tokens[0]);
+		for (auto j : xrange(num)) {
+			subTokens.push_back(request.getListIndex(interp, j));
+		}
+		TclObject subResult;
+		executeSubCommand(subTokens[1].getString(),
+			"read",        [&]{ read      (subTokens, subResult); },
+			"read_block",  [&]{ readBlock (subTokens, subResult); },
+			"write",       [&]{ write     (subTokens, subResult); },
+			"write_block", [&]{ writeBlock(subTokens, subResult); },
+			"size",        [&]{ size      (subTokens, subResult); });
+		result.addListElement(subResult);
+	}
+}
+
 void Debugger::Cmd::setBreakPoint(span<const TclObject> tokens, TclObject& result)
 {
 	checkNumArgs(tokens, AtLeast{3}, "address ?-once? ?condition? ?command?");
@@ -608,8 +725,256 @@ void Debugger::Cmd::probe(span<const TclObject> tokens, TclObject& result)
 		"read",      [&]{ probeRead(tokens, result); },
 		"set_bp",    [&]{ probeSetBreakPoint(tokens, result); },
 		"remove_bp", [&]{ probeRemoveBreakPoint(tokens, result); },
-		"list_bp",   [&]{ probeListBreakPoints(tokens, result); });
+		"list_bp",   [&]{ probeListBreakPoints(tokens, result); },
+		"record",    [&]{ probeRecord(tokens, result); },
+		"stop_record", [&]{ probeStopRecord(tokens, result); },
+		"samples",   [&]{ probeSamples(tokens, result); },
+		"list_records", [&]{ probeListRecords(tokens, result); });
+}
+void Debugger::Cmd::stepBack(span<const TclObject> tokens)
+{
+	checkNumArgs(tokens, 2, "");
+	auto& motherBoard = debugger().motherBoard;
+	auto prev = motherBoard.getCPU().getInstructionIndex().getPrevious();
+	if (!prev) {
+		throw CommandException(
+			"The previous instruction was not recorded (this only "
+			"happens while stepping or while there are breakpoints).");
+	}
+	// Note: this may delete the current machine (and thus this object).
+	motherBoard.getReverseManager().goTo(*prev, true);
+}
+
+void Debugger::Cmd::reverseContinue(span<const TclObject> tokens, TclObject& result)
+{
+	checkNumArgs(tokens, 2, "");
+	auto& interp = getInterpreter();
+	const auto& breakPoints = MSXCPUInterface::getBreakPoints();
+	auto atBreakPoint = [&](const InstructionIndex::Entry& e) {
+		auto [first, last] = ranges::equal_range(breakPoints, e.pc, {}, &BreakPoint::getAddress);
+		return first != last;
+	};
+
+	// After a 'reverse goto' we're possibly in a new machine, so from here
+	// on don't access any members of this object.
+	MSXMotherBoard* board = &debugger().motherBoard;
+	EmuTime before = board->getCurrentTime();
+	while (true) {
+		auto entry = board->getCPU().getInstructionIndex().findLast(before, atBreakPoint);
+		if (!entry) {
+			throw CommandException(
+				"No earlier breakpoint found in the recorded instructions.");
+		}
+		board = &board->getReverseManager().goTo(entry->time, false);
+		// Now that we're at the right moment, we can evaluate the
+		// breakpoint conditions.
+		auto& cliComm = board->getReactor().getGlobalCliComm();
+		auto range = ranges::equal_range(breakPoints, entry->pc, {}, &BreakPoint::getAddress);
+		for (auto it = range.first; it != range.second; ++it) {
+			if (it->isTrue(cliComm, interp, *board)) {
+				result = tmpStrCat("bp#", it->getId());
+				return;
+			}
+		}
+		before = entry->time;
+	}
 }
+
+void Debugger::Cmd::profile(span<const TclObject> tokens, TclObject& result)
+{
+	checkNumArgs(tokens, AtLeast{3}, "subcommand ?arg ...?");
+	auto& sampler = debugger().profileSampler;
+	executeSubCommand(tokens[2].getString(),
+		"start", [&]{
+			checkNumArgs(tokens, Between{3, 4}, "?interval?");
+			double interval = (tokens.size() == 4)
+			                ? tokens[3].getDouble(getInterpreter())
+			                : 0.0001;
+			if (interval <= 0.0) {
+				throw CommandException("Interval must be positive");
+			}
+			sampler.start(EmuDuration(interval));
+		},
+		"stop",    [&]{ sampler.stop(); },
+		"clear",   [&]{ sampler.clear(); },
+		"status",  [&]{
+			result.addDictKeyValues("running", sampler.isRunning(),
+			                        "samples", int64_t(sampler.getNumSamples()));
+		},
+		"pcs",     [&]{
+			checkNumArgs(tokens, Between{3, 4}, "?count?");
+			int count = (tokens.size() == 4)
+			          ? tokens[3].getInt(getInterpreter())
+			          : 100;
+			if (count < 0) {
+				throw CommandException("Invalid count: ", count);
+			}
+			sampler.getPCs(result, unsigned(count));
+		},
+		"opcodes", [&]{ sampler.getOpcodes(result); });
+}
+
+void Debugger::Cmd::exportShm(span<const TclObject> tokens, TclObject& result)
+{
+	checkNumArgs(tokens, AtLeast{3}, "subcommand ?arg ...?");
+	auto& exporter = debugger().sharedMemoryExporter;
+	executeSubCommand(tokens[2].getString(),
+		"start", [&]{
+			checkNumArgs(tokens, AtLeast{5}, "name debuggable ?debuggable ...?");
+			exporter.start(tokens[3].getString(), to_vector(view::transform(
+				tokens.subspan(4),
+				[](auto& t) { return std::string(t.getString()); })));
+		},
+		"stop", [&]{
+			checkNumArgs(tokens, 4, "name");
+			auto name = tokens[3].getString();
+			if (!contains(exporter.getNames(), name)) {
+				throw CommandException("No such shared memory export: ", name);
+			}
+			exporter.stop(name);
+		},
+		"list", [&]{
+			checkNumArgs(tokens, 3, "");
+			exporter.list(result);
+		});
+}
+
+void Debugger::Cmd::gdbServer(span<const TclObject> tokens, TclObject& result)
+{
+	checkNumArgs(tokens, AtLeast{3}, "subcommand ?arg ...?");
+	auto& server = debugger().gdbServer;
+	executeSubCommand(tokens[2].getString(),
+		"start", [&]{
+			checkNumArgs(tokens, Between{3, 4}, "?port?");
+			unsigned port = (tokens.size() == 4)
+			              ? tokens[3].getInt(getInterpreter())
+			              : 2159;
+			if (port > 0xFFFF) {
+				throw CommandException("Invalid port number");
+			}
+			if (server) {
+				throw CommandException("GDB server is already running on port ",
+				                       server->getPort());
+			}
+			try {
+				server = std::make_unique<GdbServer>(
+					debugger(), debugger().motherBoard.getReactor().getEventDistributor(),
+					port);
+			} catch (MSXException& e) {
+				throw CommandException(std::move(e).getMessage());
+			}
+			result = int(server->getPort());
+		},
+		"stop", [&]{
+			checkNumArgs(tokens, 3, "");
+			if (server) {
+				server->removePoints();
+				server.reset();
+			}
+		},
+		"status", [&]{
+			checkNumArgs(tokens, 3, "");
+			result.addDictKeyValues(
+				"running", bool(server),
+				"port", server ? int(server->getPort()) : 0,
+				"connected", server && server->isConnected());
+		});
+}
+
+std::vector<byte> Debugger::Cmd::readCheatDebuggable()
+{
+	auto& finder = debugger().cheatFinder;
+	if (!finder.isStarted()) {
+		throw CommandException("No search in progress, use 'debug cheat start'");
+	}
+	auto* device = debugger().findDebuggable(debugger().cheatDebuggable);
+	if (!device || (device->getSize() != finder.getSize())) {
+		throw CommandException("Debuggable ", debugger().cheatDebuggable,
+		                       " changed, restart the search");
+	}
+	std::vector<byte> result(finder.getSize());
+	device->readBlock(0, result);
+	return result;
+}
+
+void Debugger::Cmd::cheat(span<const TclObject> tokens, TclObject& result)
+{
+	checkNumArgs(tokens, AtLeast{3}, "subcommand ?arg ...?");
+	auto& finder = debugger().cheatFinder;
+	auto& interp = getInterpreter();
+	executeSubCommand(tokens[2].getString(),
+		"start", [&]{
+			checkNumArgs(tokens, Between{3, 4}, "?debuggable?");
+			std::string name = (tokens.size() == 4)
+			                 ? std::string(tokens[3].getString())
+			                 : std::string("memory");
+			Debuggable& device = debugger().getDebuggable(name);
+			std::vector<byte> content(device.getSize());
+			device.readBlock(0, content);
+			finder.start(content);
+			debugger().cheatDebuggable = std::move(name);
+			result = int64_t(finder.getNumCandidates());
+		},
+		"narrow", [&]{
+			checkNumArgs(tokens, Between{4, 5}, "relation ?value?");
+			using R = CheatFinder::Relation;
+			auto relStr = tokens[3].getString();
+			bool valueAllowed = true;
+			R rel = [&] {
+				if (relStr == "==") return R::EQUAL;
+				if (relStr == "!=") return R::NOT_EQUAL;
+				if (relStr == "<")  return R::LESS;
+				if (relStr == ">")  return R::GREATER;
+				if (relStr == "<=") return R::LESS_EQUAL;
+				if (relStr == ">=") return R::GREATER_EQUAL;
+				valueAllowed = false;
+				if (relStr == "changed")   return R::NOT_EQUAL;
+				if (relStr == "unchanged") return R::EQUAL;
+				if (relStr == "any")       return R::ANY;
+				throw CommandException(
+					"Invalid relation, must be one of ==, !=, <, >, <=, >=, "
+					"changed, unchanged or any");
+			}();
+			std::optional<byte> value;
+			if (tokens.size() == 5) {
+				if (!valueAllowed) {
+					throw CommandException("Relation '", relStr,
+					                       "' doesn't take a value");
+				}
+				int v = tokens[4].getInt(interp);
+				if ((v < 0) || (v > 255)) {
+					throw CommandException("Value must be in range 0..255");
+				}
+				value = byte(v);
+			}
+			auto current = readCheatDebuggable();
+			result = int64_t(finder.narrow(current, rel, value));
+		},
+		"keep", [&]{
+			checkNumArgs(tokens, 4, "addresses");
+			std::vector<unsigned> addresses;
+			for (auto i : xrange(tokens[3].getListLength(interp))) {
+				addresses.push_back(tokens[3].getListIndex(interp, i).getInt(interp));
+			}
+			auto current = readCheatDebuggable();
+			result = int64_t(finder.keep(current, addresses));
+		},
+		"count", [&]{ result = int64_t(finder.getNumCandidates()); },
+		"list", [&]{
+			checkNumArgs(tokens, Between{3, 4}, "?max?");
+			size_t max = (tokens.size() == 4)
+			           ? size_t(std::max(0, tokens[3].getInt(interp)))
+			           : finder.getNumCandidates();
+			std::vector<TclObject> entries;
+			finder.forEachCandidate([&](unsigned addr, byte prev, byte value) {
+				if (entries.size() < max) {
+					entries.push_back(makeTclList(addr, prev, value));
+				}
+			});
+			result.addListElements(entries);
+		});
+}
+
 void Debugger::Cmd::probeList(span<const TclObject> /*tokens*/, TclObject& result)
 {
 	result.addListElements(view::transform(debugger().probes,
@@ -677,6 +1042,55 @@ void Debugger::Cmd::probeListBreakPoints(
 	}
 	result = res;
 }
+void Debugger::Cmd::probeRecord(span<const TclObject> tokens, TclObject& /*result*/)
+{
+	checkNumArgs(tokens, Between{4, 5}, "probe ?size?");
+	auto& probe = debugger().getProbe(tokens[3].getString());
+	int size = (tokens.size() == 5) ? tokens[4].getInt(getInterpreter()) : 65536;
+	if (size <= 0) {
+		throw CommandException("Size must be positive");
+	}
+	if (debugger().findProbeRecorder(probe.getName())) {
+		throw CommandException("Already recording probe: ", probe.getName());
+	}
+	debugger().probeRecorders.push_back(
+		std::make_unique<ProbeRecorder>(debugger(), probe, size_t(size)));
+}
+void Debugger::Cmd::probeStopRecord(span<const TclObject> tokens, TclObject& /*result*/)
+{
+	checkNumArgs(tokens, 4, "probe");
+	auto* recorder = debugger().findProbeRecorder(tokens[3].getString());
+	if (!recorder) {
+		throw CommandException("Not recording probe: ", tokens[3].getString());
+	}
+	debugger().removeProbeRecorder(*recorder);
+}
+void Debugger::Cmd::probeSamples(span<const TclObject> tokens, TclObject& result)
+{
+	checkNumArgs(tokens, Between{4, 5}, "probe ?max?");
+	auto* recorder = debugger().findProbeRecorder(tokens[3].getString());
+	if (!recorder) {
+		throw CommandException("Not recording probe: ", tokens[3].getString());
+	}
+	size_t max = (tokens.size() == 5)
+	           ? size_t(std::max(0, tokens[4].getInt(getInterpreter())))
+	           : recorder->getNumSamples();
+	std::vector<TclObject> elements;
+	elements.reserve(2 * std::min(max, recorder->getNumSamples()));
+	recorder->take(max, [&](const ProbeRecorder::Sample& sample) {
+		elements.emplace_back((sample.time - EmuTime::zero()).toDouble());
+		elements.emplace_back(sample.value);
+	});
+	result.addListElements(elements);
+}
+void Debugger::Cmd::probeListRecords(span<const TclObject> /*tokens*/, TclObject& result)
+{
+	for (auto& r : debugger().probeRecorders) {
+		result.addListElement(makeTclList(
+			r->getProbe().getName(), int64_t(r->getNumSamples()),
+			int64_t(r->getCapacity()), int64_t(r->getNumDropped())));
+	}
+}
 
 string Debugger::Cmd::help(span<const TclObject> tokens) const
 {
@@ -690,6 +1104,9 @@ string Debugger::Cmd::help(span<const TclObject> tokens) const
 		"    write             write a byte to a debuggable\n"
 		"    read_block        read a whole block at once\n"
 		"    write_block       write a whole block at once\n"
+		"    batch             execute many read/write requests at once\n"
+		"    snapshot          copy the whole content of a debuggable\n"
+		"    diff              compare a debuggable with a snapshot\n"
 		"    set_bp            insert a new breakpoint\n"
 		"    remove_bp         remove a certain breakpoint\n"
 		"    list_bp           list the active breakpoints\n"
@@ -700,11 +1117,18 @@ string Debugger::Cmd::help(span<const TclObject> tokens) const
 		"    remove_condition  remove a certain condition\n"
 		"    list_conditions   list the active conditions\n"
 		"    probe             probe related subcommands\n"
+		"    profile           sampling profiler related subcommands\n"
+		"    cheat             cheat finder related subcommands\n"
+		"    export_shm        mirror debuggables in shared memory\n"
+		"    gdbserver         GDB remote protocol server related subcommands\n"
 		"    cont              continue execution after break\n"
 		"    step              execute one instruction\n"
+		"    step_back         go back to the previous instruction\n"
+		"    reverse_continue  go back to the last breakpoint hit\n"
 		"    break             break CPU at current position\n"
 		"    breaked           query CPU breaked status\n"
 		"    disasm            disassemble instructions\n"
+		"    disasm_block      disassemble many instructions at once\n"
 		"  The arguments are specific for each subcommand.\n"
 		"  Type 'help debug <subcommand>' for help about a specific subcommand.\n";
 
@@ -749,6 +1173,29 @@ string Debugger::Cmd::help(span<const TclObject> tokens) const
 		"  The block has a size and an offset in the debuggable. The "
 		"complete block must fit in the debuggable (see the 'size' "
 		"subcommand).\n";
+	auto batchHelp =
+		"debug batch <requests>\n"
+		"  Execute a list of data access requests in one go. Each request "
+		"is itself a list: a 'read', 'read_block', 'write', 'write_block' "
+		"or 'size' subcommand followed by its arguments, e.g.\n"
+		"     debug batch {{read_block memory 0xc000 16} {read {VDP regs} 7}}\n"
+		"  The result is a list with the result of each request. This is "
+		"meant for external applications: it avoids one round trip (and one "
+		"command parse) per request. Requests are executed in order; when "
+		"one fails, the remaining requests are not executed.\n";
+	auto snapshotHelp =
+		"debug snapshot <name>\n"
+		"  Returns the complete content of the given debuggable as a Tcl "
+		"binary string. Same as 'debug read_block <name> 0 [debug size "
+		"<name>]'. Meant to be used with 'debug diff'.\n";
+	auto diffHelp =
+		"debug diff <name> <snapshot>\n"
+		"  Compares the current content of the debuggable with a snapshot "
+		"taken earlier with 'debug snapshot'. Returns a list of {<addr> "
+		"<length>} pairs, one for each range of bytes that changed. E.g.\n"
+		"     set s [debug snapshot memory]\n"
+		"     ...\n"
+		"     debug diff memory $s\n";
 	auto setBpHelp =
 		"debug set_bp [-once] <addr> [<cond>] [<cmd>]\n"
 		"  Insert a new breakpoint at given address. When the CPU is about "
@@ -839,7 +1286,78 @@ string Debugger::Cmd::help(span<const TclObject> tokens) const
 		"    read   <probe>                           returns the current value of this probe\n"
 		"    set_bp <probe> [-once] [<cond>] [<cmd>]  set a breakpoint on the given probe\n"
 		"    remove_bp <id>                           remove the given breakpoint\n"
-		"    list_bp                                  returns a list of breakpoints that are set on probes\n";
+		"    list_bp                                  returns a list of breakpoints that are set on probes\n"
+		"    record <probe> [<size>]                  record all changes of this probe (with their time)\n"
+		"                                             in a buffer of <size> (default 65536) samples\n"
+		"    stop_record <probe>                      stop recording, the samples are dropped\n"
+		"    samples <probe> [<max>]                  returns and removes the oldest (max) recorded\n"
+		"                                             samples, as a flat list {time value time value ...}\n"
+		"    list_records                             returns a list of {probe samples size dropped}\n"
+		"  Recording doesn't execute any Tcl code per change (unlike a probe\n"
+		"  breakpoint), so it can keep up with frequently changing probes. When\n"
+		"  the buffer is full the oldest samples are dropped. Probes without a\n"
+		"  numeric value (events) have value 0.\n";
+	auto profileHelp =
+		"debug profile <subcommand> [<arguments>]\n"
+		"  Statistical profiler: at regular (emulated) time intervals it "
+		"records the value of the program counter. Contrary to 'cpu trace' "
+		"this hardly slows down the emulation.\n"
+		"  Possible subcommands are:\n"
+		"    start [<interval>]  start sampling, default interval is 0.0001 (seconds, emulated time)\n"
+		"    stop                stop sampling, collected samples are kept\n"
+		"    clear               remove all collected samples\n"
+		"    status              returns a dict with running state and number of samples\n"
+		"    pcs [<count>]       returns the <count> (default 100) most sampled locations,\n"
+		"                        as a list of {slot subslot segment pc count} elements\n"
+		"                        (subslot and segment are -1 when not applicable)\n"
+		"    opcodes             returns a list of {opcode count} elements\n";
+	auto cheatHelp =
+		"debug cheat <subcommand> [<arguments>]\n"
+		"  Cheat finder: search for memory locations whose value changes in "
+		"a certain way (e.g. the number of lives in a game).\n"
+		"  Possible subcommands are:\n"
+		"    start [<debuggable>]      take a snapshot of the debuggable (default 'memory'),\n"
+		"                              all addresses become candidates\n"
+		"    narrow <relation> [<val>] only keep the candidates whose current value compares\n"
+		"                              to <val> or (without <val>) to the value in the\n"
+		"                              previous step, <relation> is one of ==, !=, <, >, <=,\n"
+		"                              >= or changed, unchanged, any (these take no <val>)\n"
+		"    keep <addresses>          only keep the given candidates\n"
+		"    count                     returns the number of candidates\n"
+		"    list [<max>]              returns a list of {addr previous value} elements\n"
+		"  'narrow' and 'keep' return the number of remaining candidates.\n";
+	auto exportShmHelp =
+		"debug export_shm <subcommand> [<arguments>]\n"
+		"  Mirror the content of debuggables in a named shared memory object, "
+		"so that external tools can read e.g. RAM and VRAM without using "
+		"'debug read_block' every frame. The content is updated at the end "
+		"of each frame.\n"
+		"  Possible subcommands are:\n"
+		"    start <name> <debuggable> [<debuggable> ...]  create (or replace) the object <name>\n"
+		"    stop <name>                                   remove the object <name>\n"
+		"    list                                          returns a list of {name debuggables updates}\n"
+		"  On Linux the object can be found as /dev/shm/<name>, on other POSIX "
+		"systems use shm_open(\"/<name>\"), on Windows OpenFileMapping(\"<name>\"). "
+		"It starts with a header: char magic[8] \"openMSX\", uint32 version (1), "
+		"uint32 number of regions, uint64 sequence. Then for each debuggable: "
+		"char name[48], uint32 offset, uint32 size. The sequence is odd while "
+		"an update is in progress, so a reader should retry when it was odd "
+		"or changed while copying.\n";
+	auto gdbServerHelp =
+		"debug gdbserver <subcommand> [<arguments>]\n"
+		"  Server for the GDB remote serial protocol, so that gdb (with Z80 "
+		"support) or a compatible frontend can debug the MSX CPU, e.g. with "
+		"'target remote localhost:2159'. It only accepts connections from "
+		"the local machine.\n"
+		"  Possible subcommands are:\n"
+		"    start [<port>]  start listening, default port is 2159, 0 picks a free port,\n"
+		"                    returns the port number\n"
+		"    stop            stop the server, removes the break/watchpoints set by the client\n"
+		"    status          returns a dict with running state, port and connected state\n"
+		"  Memory reads and writes go to the 'memory' debuggable (the CPU view), "
+		"registers to 'CPU regs' (order: af bc de hl sp pc ix iy af' bc' de' "
+		"hl' ir). Breakpoints and read/write/access watchpoints become normal "
+		"openMSX break- and watchpoints (see 'debug list_bp').\n";
 	auto contHelp =
 		"debug cont\n"
 		"  Continue execution after CPU was breaked.\n";
@@ -847,6 +1365,22 @@ string Debugger::Cmd::help(span<const TclObject> tokens) const
 		"debug step\n"
 		"  Execute one instruction. This command is only meaningful in "
 		"break mode.\n";
+	auto stepBackHelp =
+		"debug step_back\n"
+		"  Go back in time to the start of the previous instruction. This "
+		"requires that reverse is enabled and that the previous instruction "
+		"was recorded, which only happens while stepping or while there are "
+		"breakpoints or conditions. See also the 'step_back' Tcl proc, which "
+		"also works in other cases (but it's slower).\n";
+	auto reverseContinueHelp =
+		"debug reverse_continue\n"
+		"  Go back in time to the last moment a breakpoint was hit. Only the "
+		"recently executed instructions that were recorded (see 'help debug "
+		"step_back') are searched. The condition of a breakpoint is "
+		"evaluated after going back, so each breakpoint whose condition turns "
+		"out to be false costs an extra step back. Conditions without an "
+		"address and watchpoints are not considered. Returns the id of the "
+		"breakpoint.\n";
 	auto breakHelp =
 		"debug break\n"
 		"  Immediately break CPU execution. When CPU was already breaked "
@@ -865,6 +1399,15 @@ string Debugger::Cmd::help(span<const TclObject> tokens) const
 		"instruction).\n"
 		"  Note that openMSX comes with a 'disasm' Tcl script that is much "
 		"more convenient to use than this subcommand.";
+	auto disasmBlockHelp =
+		"debug disasm_block <addr> <num>\n"
+		"  Disassemble <num> consecutive instructions, starting at the "
+		"given address. The result is a Tcl list with an element "
+		"{address text byte ...} per instruction, which is the address "
+		"followed by the result of 'debug disasm' for that address. This "
+		"is a lot faster than calling 'debug disasm' <num> times. "
+		"Instructions that didn't change since they were last "
+		"disassembled are taken from a cache.\n";
 	auto unknownHelp =
 		"Unknown subcommand, use 'help debug' to see a list of valid "
 		"subcommands.\n";
@@ -885,6 +1428,12 @@ string Debugger::Cmd::help(span<const TclObject> tokens) const
 		return readBlockHelp;
 	} else if (tokens[1] == "write_block") {
 		return writeBlockHelp;
+	} else if (tokens[1] == "batch") {
+		return batchHelp;
+	} else if (tokens[1] == "snapshot") {
+		return snapshotHelp;
+	} else if (tokens[1] == "diff") {
+		return diffHelp;
 	} else if (tokens[1] == "set_bp") {
 		return setBpHelp;
 	} else if (tokens[1] == "remove_bp") {
@@ -905,16 +1454,30 @@ string Debugger::Cmd::help(span<const TclObject> tokens) const
 		return listCondHelp;
 	} else if (tokens[1] == "probe") {
 		return probeHelp;
+	} else if (tokens[1] == "profile") {
+		return profileHelp;
+	} else if (tokens[1] == "cheat") {
+		return cheatHelp;
+	} else if (tokens[1] == "export_shm") {
+		return exportShmHelp;
+	} else if (tokens[1] == "gdbserver") {
+		return gdbServerHelp;
 	} else if (tokens[1] == "cont") {
 		return contHelp;
 	} else if (tokens[1] == "step") {
 		return stepHelp;
+	} else if (tokens[1] == "step_back") {
+		return stepBackHelp;
+	} else if (tokens[1] == "reverse_continue") {
+		return reverseContinueHelp;
 	} else if (tokens[1] == "break") {
 		return breakHelp;
 	} else if (tokens[1] == "breaked") {
 		return breakedHelp;
 	} else if (tokens[1] == "disasm") {
 		return disasmHelp;
+	} else if (tokens[1] == "disasm_block") {
+		return disasmBlockHelp;
 	} else {
 		return unknownHelp;
 	}
@@ -943,17 +1506,18 @@ void Debugger::Cmd::tabCompletion(std::vector<string>& tokens) const
 {
 	using namespace std::literals;
 	static constexpr std::array singleArgCmds = {
-		"list"sv, "step"sv, "cont"sv, "break"sv, "breaked"sv,
+		"list"sv, "step"sv, "step_back"sv, "reverse_continue"sv,
+		"cont"sv, "break"sv, "breaked"sv,
 		"list_bp"sv, "list_watchpoints"sv, "list_conditions"sv,
 	};
 	static constexpr std::array debuggableArgCmds = {
 		"desc"sv, "size"sv, "read"sv, "read_block"sv,
-		"write"sv, "write_block"sv,
+		"write"sv, "write_block"sv, "snapshot"sv, "diff"sv,
 	};
 	static constexpr std::array otherCmds = {
-		"disasm"sv, "set_bp"sv, "remove_bp"sv, "set_watchpoint"sv,
+		"batch"sv, "disasm"sv, "disasm_block"sv, "set_bp"sv, "remove_bp"sv, "set_watchpoint"sv,
 		"remove_watchpoint"sv, "set_condition"sv, "remove_condition"sv,
-		"probe"sv,
+		"probe"sv, "profile"sv, "cheat"sv, "export_shm"sv, "gdbserver"sv,
 	};
 	switch (tokens.size()) {
 	case 2: {
@@ -984,19 +1548,57 @@ void Debugger::Cmd::tabCompletion(std::vector<string>& tokens) const
 			} else if (tokens[1] == "probe") {
 				static constexpr std::array subCmds = {
 					"list"sv, "desc"sv, "read"sv, "set_bp"sv,
-					"remove_bp"sv, "list_bp"sv,
+					"remove_bp"sv, "list_bp"sv, "record"sv,
+					"stop_record"sv, "samples"sv, "list_records"sv,
+				};
+				completeString(tokens, subCmds);
+			} else if (tokens[1] == "profile") {
+				static constexpr std::array subCmds = {
+					"start"sv, "stop"sv, "clear"sv, "status"sv,
+					"pcs"sv, "opcodes"sv,
+				};
+				completeString(tokens, subCmds);
+			} else if (tokens[1] == "cheat") {
+				static constexpr std::array subCmds = {
+					"start"sv, "narrow"sv, "keep"sv, "count"sv, "list"sv,
+				};
+				completeString(tokens, subCmds);
+			} else if (tokens[1] == "export_shm") {
+				static constexpr std::array subCmds = {
+					"start"sv, "stop"sv, "list"sv,
+				};
+				completeString(tokens, subCmds);
+			} else if (tokens[1] == "gdbserver") {
+				static constexpr std::array subCmds = {
+					"start"sv, "stop"sv, "status"sv,
 				};
 				completeString(tokens, subCmds);
 			}
 		}
 		break;
 	case 4:
-		if ((tokens[1] == "probe") &&
-		    (tokens[2] == one_of("desc", "read", "set_bp"))) {
+		if ((tokens[1] == "cheat") && (tokens[2] == "start")) {
+			completeString(tokens, view::keys(debugger().debuggables));
+		} else if ((tokens[1] == "cheat") && (tokens[2] == "narrow")) {
+			static constexpr std::array relations = {
+				"=="sv, "!="sv, "<"sv, ">"sv, "<="sv, ">="sv,
+				"changed"sv, "unchanged"sv, "any"sv,
+			};
+			completeString(tokens, relations);
+		} else if ((tokens[1] == "probe") &&
+		    (tokens[2] == one_of("desc", "read", "set_bp", "record",
+		                         "stop_record", "samples"))) {
 			auto probeNames = to_vector(view::transform(
 				debugger().probes,
 				[](auto* p) { return p->getName(); }));
 			completeString(tokens, probeNames);
+		} else if ((tokens[1] == "export_shm") && (tokens[2] == "stop")) {
+			completeString(tokens, debugger().sharedMemoryExporter.getNames());
+		}
+		break;
+	default:
+		if ((tokens[1] == "export_shm") && (tokens[2] == "start")) {
+			completeString(tokens, view::keys(debugger().debuggables));
 		}
 		break;
 	}
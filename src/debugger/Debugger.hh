@@ -1,8 +1,11 @@
 #ifndef DEBUGGER_HH
 #define DEBUGGER_HH
 
+#include "CheatFinder.hh"
 #include "Probe.hh"
+#include "ProfileSampler.hh"
 #include "RecordedCommand.hh"
+#include "SharedMemoryExporter.hh"
 #include "WatchPoint.hh"
 #include "hash_map.hh"
 #include "outer.hh"
@@ -15,8 +18,10 @@ namespace openmsx {
 
 class MSXMotherBoard;
 class Debuggable;
+class GdbServer;
 class ProbeBase;
 class ProbeBreakPoint;
+class ProbeRecorder;
 class MSXCPU;
 
 class Debugger
@@ -37,6 +42,7 @@ public:
 	[[nodiscard]] ProbeBase* findProbe(std::string_view name);
 
 	void removeProbeBreakPoint(ProbeBreakPoint& bp);
+	void removeProbeRecorder(ProbeRecorder& recorder);
 	void setCPU(MSXCPU* cpu_) { cpu = cpu_; }
 
 	void transfer(Debugger& other);
@@ -52,6 +58,8 @@ private:
 		ProbeBase& probe, bool once, unsigned newId = -1);
 	void removeProbeBreakPoint(std::string_view name);
 
+	[[nodiscard]] ProbeRecorder* findProbeRecorder(std::string_view probeName);
+
 	unsigned setWatchPoint(TclObject command, TclObject condition,
 	                       WatchPoint::Type type,
 	                       unsigned beginAddr, unsigned endAddr,
@@ -80,6 +88,9 @@ private:
 		void readBlock(span<const TclObject> tokens, TclObject& result);
 		void write(span<const TclObject> tokens, TclObject& result);
 		void writeBlock(span<const TclObject> tokens, TclObject& result);
+		void batch(span<const TclObject> tokens, TclObject& result);
+		void snapshot(span<const TclObject> tokens, TclObject& result);
+		void diff(span<const TclObject> tokens, TclObject& result);
 		void setBreakPoint(span<const TclObject> tokens, TclObject& result);
 		void removeBreakPoint(span<const TclObject> tokens, TclObject& result);
 		void listBreakPoints(span<const TclObject> tokens, TclObject& result);
@@ -99,6 +110,17 @@ private:
 		void probeSetBreakPoint(span<const TclObject> tokens, TclObject& result);
 		void probeRemoveBreakPoint(span<const TclObject> tokens, TclObject& result);
 		void probeListBreakPoints(span<const TclObject> tokens, TclObject& result);
+		void probeRecord(span<const TclObject> tokens, TclObject& result);
+		void probeStopRecord(span<const TclObject> tokens, TclObject& result);
+		void probeSamples(span<const TclObject> tokens, TclObject& result);
+		void probeListRecords(span<const TclObject> tokens, TclObject& result);
+		void stepBack(span<const TclObject> tokens);
+		void reverseContinue(span<const TclObject> tokens, TclObject& result);
+		void profile(span<const TclObject> tokens, TclObject& result);
+		void cheat(span<const TclObject> tokens, TclObject& result);
+		void exportShm(span<const TclObject> tokens, TclObject& result);
+		void gdbServer(span<const TclObject> tokens, TclObject& result);
+		[[nodiscard]] std::vector<byte> readCheatDebuggable();
 	} cmd;
 
 	struct NameFromProbe {
@@ -110,7 +132,13 @@ private:
 	hash_map<std::string, Debuggable*, XXHasher> debuggables;
 	hash_set<ProbeBase*, NameFromProbe, XXHasher> probes;
 	std::vector<std::unique_ptr<ProbeBreakPoint>> probeBreakPoints; // unordered
+	std::vector<std::unique_ptr<ProbeRecorder>> probeRecorders; // unordered
 	MSXCPU* cpu = nullptr;
+	ProfileSampler profileSampler;
+	CheatFinder cheatFinder;
+	std::string cheatDebuggable; // name of the debuggable searched by cheatFinder
+	SharedMemoryExporter sharedMemoryExporter;
+	std::unique_ptr<GdbServer> gdbServer; // only while running
 };
 
 } // namespace openmsx
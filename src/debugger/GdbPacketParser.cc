@@ -0,0 +1,111 @@
+#include "GdbPacketParser.hh"
+#include "one_of.hh"
+
+namespace openmsx {
+
+[[nodiscard]] static constexpr int hexDigit(char c)
+{
+	if (('0' <= c) && (c <= '9')) return c - '0';
+	if (('a' <= c) && (c <= 'f')) return c - 'a' + 10;
+	if (('A' <= c) && (c <= 'F')) return c - 'A' + 10;
+	return -1;
+}
+
+static void appendHexByte(std::string& result, uint8_t b)
+{
+	static constexpr const char* digits = "0123456789abcdef";
+	result += digits[b >> 4];
+	result += digits[b & 15];
+}
+
+GdbPacketParser::GdbPacketParser(Callback callback_)
+	: callback(std::move(callback_))
+{
+}
+
+void GdbPacketParser::parse(const char* buf, size_t n)
+{
+	for (auto c : std::string_view(buf, n)) {
+		switch (state) {
+		case IDLE:
+			if (c == '$') {
+				payload.clear();
+				sum = 0;
+				state = DATA;
+			} else if (c == '\x03') {
+				callback(INTERRUPT, {});
+			}
+			// ignore '+', '-' and garbage
+			break;
+		case DATA:
+			if (c == '#') {
+				state = CHECKSUM1;
+				break;
+			}
+			sum += uint8_t(c);
+			if (c == '}') {
+				state = ESCAPE;
+			} else {
+				payload += c;
+			}
+			break;
+		case ESCAPE:
+			sum += uint8_t(c);
+			payload += char(c ^ 0x20);
+			state = DATA;
+			break;
+		case CHECKSUM1:
+			expected = uint8_t(hexDigit(c) << 4);
+			if (hexDigit(c) < 0) expected = ~sum; // force mismatch
+			state = CHECKSUM2;
+			break;
+		case CHECKSUM2:
+			if ((hexDigit(c) >= 0) && (uint8_t(expected | hexDigit(c)) == sum)) {
+				callback(PACKET, payload);
+			} else {
+				callback(BAD_CHECKSUM, payload);
+			}
+			state = IDLE;
+			break;
+		}
+	}
+}
+
+void GdbPacketParser::appendPacket(std::string& result, std::string_view payload)
+{
+	result += '$';
+	uint8_t sum = 0;
+	auto add = [&](char c) { result += c; sum += uint8_t(c); };
+	for (auto c : payload) {
+		if (c == one_of('$', '#', '}', '*')) {
+			add('}');
+			add(char(c ^ 0x20));
+		} else {
+			add(c);
+		}
+	}
+	result += '#';
+	appendHexByte(result, sum);
+}
+
+void GdbPacketParser::appendHex(std::string& result, span<const uint8_t> data)
+{
+	result.reserve(result.size() + 2 * data.size());
+	for (auto b : data) appendHexByte(result, b);
+}
+
+std::optional<std::vector<uint8_t>> GdbPacketParser::parseHex(std::string_view hex)
+{
+	if (hex.size() & 1) return {};
+	std::vector<uint8_t> result;
+	result.reserve(hex.size() / 2);
+	for (size_t i = 0; i < hex.size(); i += 2) {
+		int h = hexDigit(hex[i]);
+		int l = hexDigit(hex[i + 1]);
+		if ((h < 0) || (l < 0)) return {};
+		result.push_back(uint8_t((h << 4) | l));
+	}
+	return result;
+}
+
+} // namespace openmsx
@@ -0,0 +1,53 @@
+#ifndef GDBPACKETPARSER_HH
+#define GDBPACKETPARSER_HH
+
+#include "span.hh"
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace openmsx {
+
+/** Framing of the GDB remote serial protocol.
+  *
+  * Packets have the form '$<payload>#<2 hex digit checksum>', the checksum
+  * is the sum of the payload bytes modulo 256. In the payload the bytes '$',
+  * '#', '}' and '*' are escaped as '}' followed by the byte xor 0x20. Outside
+  * of a packet the client sends '+' and '-' (acknowledgements, these are
+  * ignored) and 0x03 (interrupt).
+  */
+class GdbPacketParser
+{
+public:
+	enum Kind {
+		PACKET,       // a packet with a valid checksum, payload is unescaped
+		BAD_CHECKSUM, // the client should resend this packet
+		INTERRUPT,    // the client wants to stop the target
+	};
+	using Callback = std::function<void(Kind kind, std::string_view payload)>;
+
+	explicit GdbPacketParser(Callback callback);
+	void parse(const char* buf, size_t n);
+
+	/** Append the complete packet (with escapes and checksum) to 'result'. */
+	static void appendPacket(std::string& result, std::string_view payload);
+
+	/** Lower case hex encoding, two digits per byte. */
+	static void appendHex(std::string& result, span<const uint8_t> data);
+	/** Returns nullopt when 'hex' has an odd length or a non-hex digit. */
+	[[nodiscard]] static std::optional<std::vector<uint8_t>> parseHex(std::string_view hex);
+
+private:
+	Callback callback;
+	std::string payload;
+	enum State { IDLE, DATA, ESCAPE, CHECKSUM1, CHECKSUM2 } state = IDLE;
+	uint8_t sum = 0;
+	uint8_t expected = 0;
+};
+
+} // namespace openmsx
+
+#endif
@@ -0,0 +1,566 @@
+#include "GdbServer.hh"
+#include "GdbPacketParser.hh"
+#include "Debugger.hh"
+#include "Debuggable.hh"
+#include "BreakPoint.hh"
+#include "WatchPoint.hh"
+#include "MSXCPUInterface.hh"
+#include "MSXMotherBoard.hh"
+#include "Reactor.hh"
+#include "EventDistributor.hh"
+#include "Event.hh"
+#include "CommandException.hh"
+#include "MSXException.hh"
+#include "TclObject.hh"
+#include "StringOp.hh"
+#include "one_of.hh"
+#include "strCat.hh"
+#include "ranges.hh"
+#include "stl.hh"
+#include "xrange.hh"
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cerrno>
+#include <cstring>
+#include <memory>
+#ifdef _WIN32
+#include <ws2tcpip.h> // for socklen_t
+#endif
+
+namespace openmsx {
+
+// Maximum packet size we announce (hex), 'm' replies are limited by this.
+static constexpr unsigned PACKET_SIZE = 0x4000;
+// The 'CPU regs' debuggable has this size, see MSXCPU.
+static constexpr unsigned CPU_REGS_SIZE = 28;
+// For each gdb register: the offset of its high byte in 'CPU regs', the
+// low byte follows. In order af bc de hl sp pc ix iy af' bc' de' hl' ir.
+static constexpr std::array<uint8_t, 13> REG_OFFSETS = {
+	0, 2, 4, 6, 22, 20, 16, 18, 8, 10, 12, 14, 24
+};
+static constexpr unsigned PC_REG = 5;
+
+[[nodiscard]] static std::optional<unsigned> parseHexNum(std::string_view s)
+{
+	return StringOp::stringToBase<16, unsigned>(s);
+}
+
+GdbServer::GdbServer(Debugger& debugger_, EventDistributor& distributor_, unsigned port_)
+	: debugger(&debugger_)
+	, distributor(distributor_)
+	, port(port_)
+{
+	sock_startup();
+	listenSock = socket(AF_INET, SOCK_STREAM, 0);
+	if (listenSock == OPENMSX_INVALID_SOCKET) {
+		auto err = sock_error();
+		sock_cleanup();
+		throw MSXException("Couldn't create socket: ", err);
+	}
+#ifndef _WIN32
+	// Allow to restart the server right after the previous one stopped.
+	int one = 1;
+	setsockopt(listenSock, SOL_SOCKET, SO_REUSEADDR,
+	           reinterpret_cast<const char*>(&one), sizeof(one));
+#endif
+	sockaddr_in addr;
+	memset(&addr, 0, sizeof(addr));
+	addr.sin_family = AF_INET;
+	addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK); // only local clients
+	addr.sin_port = htons(uint16_t(port));
+	socklen_t addrLen = sizeof(addr);
+	if ((bind(listenSock, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == SOCKET_ERROR) ||
+	    (listen(listenSock, 1) == SOCKET_ERROR) ||
+	    (getsockname(listenSock, reinterpret_cast<sockaddr*>(&addr), &addrLen) == SOCKET_ERROR)) {
+		auto err = sock_error();
+		sock_close(listenSock);
+		sock_cleanup();
+		throw MSXException("Couldn't listen on port ", port, ": ", err);
+	}
+	port = ntohs(addr.sin_port);
+
+	distributor.registerEventListener(EventType::GDB_PACKET, *this);
+	distributor.registerEventListener(EventType::BREAK, *this);
+	thread = std::thread([this]() { mainLoop(); });
+}
+
+GdbServer::~GdbServer()
+{
+	// Note: On Windows closing the sockets is what wakes up the helper
+	//       thread, on other platforms it's the Poller.
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		if (sock != OPENMSX_INVALID_SOCKET) {
+#ifdef _WIN32
+			shutdown(sock, SD_BOTH);
+#else
+			shutdown(sock, SHUT_RDWR);
+#endif
+		}
+	}
+	sock_close(listenSock);
+	poller.abort();
+	thread.join();
+
+	distributor.unregisterEventListener(EventType::BREAK, *this);
+	distributor.unregisterEventListener(EventType::GDB_PACKET, *this);
+	sock_cleanup();
+}
+
+bool GdbServer::isConnected()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return sock != OPENMSX_INVALID_SOCKET;
+}
+
+
+// helper thread
+
+void GdbServer::mainLoop()
+{
+#ifndef _WIN32
+	// see CliServer::mainLoop()
+	fcntl(listenSock, F_SETFL, O_NONBLOCK);
+#endif
+	while (true) {
+#ifndef _WIN32
+		if (poller.poll(listenSock)) break;
+#endif
+		SOCKET sd = accept(listenSock, nullptr, nullptr);
+		if (poller.aborted()) {
+			if (sd != OPENMSX_INVALID_SOCKET) sock_close(sd);
+			break;
+		}
+		if (sd == OPENMSX_INVALID_SOCKET) {
+			if (errno == one_of(EAGAIN, EWOULDBLOCK)) continue;
+			break;
+		}
+#ifndef _WIN32
+		fcntl(sd, F_SETFL, 0);
+#endif
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			sock = sd;
+		}
+		noAck = false;
+		receive(sd);
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			sock = OPENMSX_INVALID_SOCKET;
+		}
+		sock_close(sd);
+		post(DISCONNECT);
+		if (poller.aborted()) break;
+	}
+}
+
+void GdbServer::receive(SOCKET sd)
+{
+	GdbPacketParser parser([&](GdbPacketParser::Kind kind, std::string_view payload) {
+		switch (kind) {
+		case GdbPacketParser::PACKET:
+			if (!noAck) sendRaw("+");
+			post(PACKET, payload);
+			break;
+		case GdbPacketParser::BAD_CHECKSUM:
+			if (!noAck) sendRaw("-");
+			break;
+		case GdbPacketParser::INTERRUPT:
+			post(INTERRUPT);
+			break;
+		}
+	});
+	while (true) {
+#ifndef _WIN32
+		if (poller.poll(sd)) break;
+#endif
+		char buf[4096];
+		int n = sock_recv(sd, buf, sizeof(buf));
+		if (n < 0) break;
+		parser.parse(buf, n);
+	}
+}
+
+void GdbServer::post(Input input, std::string_view payload)
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		inputs.emplace_back(input, payload);
+	}
+	if (!eventPending.exchange(true)) {
+		distributor.distributeEvent(Event::create<GdbPacketEvent>());
+	}
+}
+
+void GdbServer::sendRaw(std::string_view data)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	while (!data.empty() && (sock != OPENMSX_INVALID_SOCKET)) {
+		int n = sock_send(sock, data.data(), data.size());
+		if (n < 0) break; // the helper thread notices the closed socket
+		data.remove_prefix(n);
+	}
+}
+
+
+// main thread
+
+int GdbServer::signalEvent(const Event& event) noexcept
+{
+	if (getType(event) == EventType::BREAK) {
+		if (waitingForStop) {
+			waitingForStop = false;
+			sendPacket("S05"); // SIGTRAP
+		}
+		return 0;
+	}
+
+	assert(getType(event) == EventType::GDB_PACKET);
+	if (!eventPending.exchange(false)) return 0;
+	std::vector<std::pair<Input, std::string>> todo;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		swap(todo, inputs);
+	}
+	for (auto& [input, packet] : todo) {
+		switch (input) {
+		case PACKET:
+			handlePacket(packet);
+			break;
+		case INTERRUPT:
+			if (!getCPUInterface().isBreaked()) {
+				waitingForStop = true;
+				getCPUInterface().doBreak();
+			}
+			break;
+		case DISCONNECT:
+			removePoints();
+			waitingForStop = false;
+			break;
+		}
+	}
+	return 0;
+}
+
+MSXCPUInterface& GdbServer::getCPUInterface()
+{
+	return debugger->getMotherBoard().getCPUInterface();
+}
+
+void GdbServer::sendPacket(std::string_view payload)
+{
+	std::string packet;
+	GdbPacketParser::appendPacket(packet, payload);
+	sendRaw(packet);
+}
+
+void GdbServer::closeConnection()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	if (sock != OPENMSX_INVALID_SOCKET) {
+		// the helper thread closes the socket
+#ifdef _WIN32
+		shutdown(sock, SD_BOTH);
+#else
+		shutdown(sock, SHUT_RDWR);
+#endif
+	}
+}
+
+void GdbServer::handlePacket(std::string_view packet)
+{
+	if (packet.empty()) {
+		sendPacket("");
+		return;
+	}
+	auto args = packet.substr(1);
+	auto& interface = getCPUInterface();
+	try {
+		switch (packet[0]) {
+		case '?':
+			if (interface.isBreaked()) {
+				sendPacket("S05");
+			} else {
+				waitingForStop = true;
+				interface.doBreak();
+			}
+			break;
+		case 'g': readRegisters(); break;
+		case 'G': writeRegisters(args); break;
+		case 'p': readRegister(args); break;
+		case 'P': writeRegister(args); break;
+		case 'm': readMemory(args); break;
+		case 'M': writeMemory(args); break;
+		case 'Z': insertPoint(args); break;
+		case 'z': removePoint(args); break;
+		case 'c': resume(false, args); break;
+		case 's': resume(true, args); break;
+		case 'H': // select thread, there's only one
+		case 'T': // is thread alive
+			sendPacket("OK");
+			break;
+		case 'D': // detach
+			removePoints();
+			waitingForStop = false;
+			interface.doContinue();
+			sendPacket("OK");
+			closeConnection();
+			break;
+		case 'k': // kill: only end the connection, not openMSX
+			removePoints();
+			waitingForStop = false;
+			closeConnection();
+			break;
+		case 'q':
+		case 'Q':
+			query(packet);
+			break;
+		default:
+			sendPacket(""); // not supported
+			break;
+		}
+	} catch (MSXException&) {
+		sendPacket("E02");
+	}
+}
+
+void GdbServer::readRegisters()
+{
+	auto* regs = debugger->findDebuggable("CPU regs");
+	if (!regs) {
+		sendPacket("E01");
+		return;
+	}
+	std::array<uint8_t, CPU_REGS_SIZE> image;
+	regs->readBlock(0, image);
+	std::array<uint8_t, 2 * REG_OFFSETS.size()> gdbRegs;
+	for (auto i : xrange(REG_OFFSETS.size())) {
+		gdbRegs[2 * i + 0] = image[REG_OFFSETS[i] + 1]; // low byte first
+		gdbRegs[2 * i + 1] = image[REG_OFFSETS[i] + 0];
+	}
+	std::string reply;
+	GdbPacketParser::appendHex(reply, gdbRegs);
+	sendPacket(reply);
+}
+
+void GdbServer::setRegisters(unsigned first, span<const uint8_t> data)
+{
+	// Changes the registers starting at gdb register 'first' to the
+	// (little endian) values in 'data'.
+	assert(first + data.size() / 2 <= REG_OFFSETS.size());
+	auto* regs = debugger->findDebuggable("CPU regs");
+	if (!regs) throw CommandException("No CPU");
+	std::array<uint8_t, CPU_REGS_SIZE> image;
+	regs->readBlock(0, image);
+	for (auto i : xrange(data.size() / 2)) {
+		auto offset = REG_OFFSETS[first + i];
+		image[offset + 0] = data[2 * i + 1];
+		image[offset + 1] = data[2 * i + 0];
+	}
+	auto& interp = debugger->getMotherBoard().getReactor().getInterpreter();
+	makeTclList("debug", "write_block", "CPU regs", 0, span<const uint8_t>(image))
+		.executeCommand(interp);
+}
+
+void GdbServer::writeRegisters(std::string_view hex)
+{
+	auto data = GdbPacketParser::parseHex(hex);
+	if (!data || (data->size() < 2 * REG_OFFSETS.size())) {
+		sendPacket("E01");
+		return;
+	}
+	setRegisters(0, span<const uint8_t>(*data).first(2 * REG_OFFSETS.size()));
+	sendPacket("OK");
+}
+
+void GdbServer::readRegister(std::string_view args)
+{
+	auto n = parseHexNum(args);
+	auto* regs = debugger->findDebuggable("CPU regs");
+	if (!n || (*n >= REG_OFFSETS.size()) || !regs) {
+		sendPacket("E01");
+		return;
+	}
+	std::array<uint8_t, CPU_REGS_SIZE> image;
+	regs->readBlock(0, image);
+	std::array<uint8_t, 2> value = {
+		image[REG_OFFSETS[*n] + 1], image[REG_OFFSETS[*n] + 0]
+	};
+	std::string reply;
+	GdbPacketParser::appendHex(reply, value);
+	sendPacket(reply);
+}
+
+void GdbServer::writeRegister(std::string_view args)
+{
+	auto [num, hex] = StringOp::splitOnFirst(args, '=');
+	auto n = parseHexNum(num);
+	auto data = GdbPacketParser::parseHex(hex);
+	if (!n || (*n >= REG_OFFSETS.size()) || !data || (data->size() != 2)) {
+		sendPacket("E01");
+		return;
+	}
+	setRegisters(*n, *data);
+	sendPacket("OK");
+}
+
+void GdbServer::readMemory(std::string_view args)
+{
+	auto [addrStr, lenStr] = StringOp::splitOnFirst(args, ',');
+	auto addr = parseHexNum(addrStr);
+	auto len = parseHexNum(lenStr);
+	auto* memory = debugger->findDebuggable("memory");
+	if (!addr || !len || !memory || (*addr >= memory->getSize())) {
+		sendPacket("E01");
+		return;
+	}
+	// A shorter reply is allowed, gdb asks for the rest.
+	auto num = std::min({*len, memory->getSize() - *addr, PACKET_SIZE / 2});
+	std::vector<uint8_t> data(num);
+	memory->readBlock(*addr, data);
+	std::string reply;
+	GdbPacketParser::appendHex(reply, data);
+	sendPacket(reply);
+}
+
+void GdbServer::writeMemory(std::string_view args)
+{
+	auto [range, hex] = StringOp::splitOnFirst(args, ':');
+	auto [addrStr, lenStr] = StringOp::splitOnFirst(range, ',');
+	auto addr = parseHexNum(addrStr);
+	auto len = parseHexNum(lenStr);
+	auto data = GdbPacketParser::parseHex(hex);
+	auto* memory = debugger->findDebuggable("memory");
+	if (!addr || !len || !data || (data->size() != *len) || !memory ||
+	    (*addr > memory->getSize()) || (*len > (memory->getSize() - *addr))) {
+		sendPacket("E01");
+		return;
+	}
+	auto& interp = debugger->getMotherBoard().getReactor().getInterpreter();
+	makeTclList("debug", "write_block", "memory", *addr, span<const uint8_t>(*data))
+		.executeCommand(interp);
+	sendPacket("OK");
+}
+
+void GdbServer::insertPoint(std::string_view args)
+{
+	// Z<type>,<addr>,<kind>  type: 0/1 = sw/hw breakpoint, 2 = write,
+	//                        3 = read, 4 = access watchpoint
+	auto [type, rest] = StringOp::splitOnFirst(args, ',');
+	auto [addrStr, kindStr] = StringOp::splitOnFirst(rest, ',');
+	auto addr = parseHexNum(addrStr);
+	auto kind = parseHexNum(kindStr);
+	if (!addr || !kind || (*addr >= 0x10000) ||
+	    (type != one_of("0", "1", "2", "3", "4"))) {
+		sendPacket(""); // not supported
+		return;
+	}
+	if (contains(points, args, &Point::key)) {
+		sendPacket("OK"); // already present (gdb may resend)
+		return;
+	}
+
+	auto& interface = getCPUInterface();
+	Point point{std::string(args), {}, type != one_of("0", "1")};
+	if (!point.isWatch) {
+		BreakPoint bp(word(*addr), TclObject("debug break"), TclObject(), false);
+		point.ids.push_back(bp.getId());
+		interface.insertBreakPoint(std::move(bp));
+	} else {
+		auto last = std::min(*addr + std::max(*kind, 1u) - 1, 0xFFFFu);
+		auto add = [&](WatchPoint::Type wpType) {
+			auto wp = std::make_shared<WatchPoint>(
+				TclObject("debug break"), TclObject(), wpType,
+				*addr, last, false);
+			point.ids.push_back(wp->getId());
+			interface.setWatchPoint(wp);
+		};
+		if (type == one_of("2", "4")) add(WatchPoint::WRITE_MEM);
+		if (type == one_of("3", "4")) add(WatchPoint::READ_MEM);
+	}
+	points.push_back(std::move(point));
+	sendPacket("OK");
+}
+
+static void removeIds(MSXCPUInterface& interface, bool isWatch, const std::vector<unsigned>& ids)
+{
+	for (auto id : ids) {
+		if (isWatch) {
+			auto& wps = interface.getWatchPoints();
+			if (auto it = ranges::find(wps, id, &WatchPoint::getId); it != end(wps)) {
+				interface.removeWatchPoint(*it);
+			}
+		} else {
+			auto& bps = interface.getBreakPoints();
+			if (auto it = ranges::find(bps, id, &BreakPoint::getId); it != end(bps)) {
+				interface.removeBreakPoint(*it);
+			}
+		}
+	}
+}
+
+void GdbServer::removePoint(std::string_view args)
+{
+	if (auto it = ranges::find(points, args, &Point::key); it != end(points)) {
+		removeIds(getCPUInterface(), it->isWatch, it->ids);
+		move_pop_back(points, it);
+	}
+	sendPacket("OK");
+}
+
+void GdbServer::removePoints()
+{
+	auto& interface = getCPUInterface();
+	for (auto& p : points) removeIds(interface, p.isWatch, p.ids);
+	points.clear();
+}
+
+void GdbServer::resume(bool step, std::string_view args)
+{
+	auto& interface = getCPUInterface();
+	if (!args.empty()) {
+		// continue/step at the given address
+		auto addr = parseHexNum(args);
+		if (!addr || (*addr >= 0x10000)) {
+			sendPacket("E01");
+			return;
+		}
+		std::array<uint8_t, 2> pc = {uint8_t(*addr), uint8_t(*addr >> 8)};
+		setRegisters(PC_REG, pc);
+	}
+	waitingForStop = true; // the reply is sent on the next break
+	if (step) {
+		interface.doStep();
+	} else {
+		interface.doContinue();
+	}
+}
+
+void GdbServer::query(std::string_view packet)
+{
+	auto [name, args] = StringOp::splitOnFirst(packet, ':');
+	if (name == "qSupported") {
+		sendPacket(tmpStrCat("PacketSize=", hex_string<4>(PACKET_SIZE),
+		                     ";QStartNoAckMode+"));
+	} else if (name == "QStartNoAckMode") {
+		// Still acknowledge this packet itself (done when it was
+		// received), but not the ones after the reply.
+		noAck = true;
+		sendPacket("OK");
+	} else if (name == "qAttached") {
+		sendPacket("1"); // detach instead of kill when gdb quits
+	} else if (name == "qC") {
+		sendPacket("QC1");
+	} else if (name == "qfThreadInfo") {
+		sendPacket("m1");
+	} else if (name == "qsThreadInfo") {
+		sendPacket("l");
+	} else if (name == "qOffsets") {
+		sendPacket("Text=0;Data=0;Bss=0");
+	} else {
+		sendPacket(""); // not supported
+	}
+}
+
+} // namespace openmsx
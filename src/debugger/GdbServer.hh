@@ -0,0 +1,107 @@
+#ifndef GDBSERVER_HH
+#define GDBSERVER_HH
+
+#include "EventListener.hh"
+#include "Poller.hh"
+#include "Socket.hh"
+#include "span.hh"
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace openmsx {
+
+class Debugger;
+class EventDistributor;
+class MSXCPUInterface;
+
+/** Server for the GDB remote serial protocol, so that gdb (or a frontend
+  * that speaks this protocol) can debug the MSX CPU ('target remote :port').
+  *
+  * A helper thread accepts a TCP connection (on localhost) and reads the
+  * packets. These are handled in the main thread, directly on the
+  * debuggables ('memory', 'CPU regs'), breakpoints and watchpoints, so
+  * without going through Tcl scripts. Writes do go through the 'debug
+  * write_block' command, so that they're recorded for replays.
+  *
+  * The registers are in the order of gdb's z80 target: af bc de hl sp pc
+  * ix iy af' bc' de' hl' ir, each 16 bit little endian.
+  */
+class GdbServer final : private EventListener
+{
+public:
+	/** Start listening on the given port (0 means: pick a free port).
+	  * Throws MSXException on error. */
+	GdbServer(Debugger& debugger, EventDistributor& distributor, unsigned port);
+	~GdbServer();
+
+	/** Continue with the machine of another Debugger (reverse). */
+	void setDebugger(Debugger& debugger_) { debugger = &debugger_; }
+
+	/** Remove the break- and watchpoints that were set by the client. */
+	void removePoints();
+
+	[[nodiscard]] unsigned getPort() const { return port; }
+	[[nodiscard]] bool isConnected();
+
+private:
+	enum Input { PACKET, INTERRUPT, DISCONNECT };
+
+	// helper thread
+	void mainLoop();
+	void receive(SOCKET sd);
+	void post(Input input, std::string_view payload = {});
+
+	// main thread (sendRaw() also from the helper thread)
+	void sendRaw(std::string_view data);
+	void sendPacket(std::string_view payload);
+	void closeConnection();
+	void handlePacket(std::string_view packet);
+	void readRegisters();
+	void setRegisters(unsigned first, span<const uint8_t> data);
+	void writeRegisters(std::string_view hex);
+	void readRegister(std::string_view args);
+	void writeRegister(std::string_view args);
+	void readMemory(std::string_view args);
+	void writeMemory(std::string_view args);
+	void insertPoint(std::string_view args);
+	void removePoint(std::string_view args);
+	void query(std::string_view packet);
+	void resume(bool step, std::string_view args);
+	[[nodiscard]] MSXCPUInterface& getCPUInterface();
+
+	int signalEvent(const Event& event) noexcept override;
+
+private:
+	Debugger* debugger;
+	EventDistributor& distributor;
+	unsigned port = 0;
+
+	std::thread thread;
+	Poller poller;
+	SOCKET listenSock = OPENMSX_INVALID_SOCKET;
+
+	std::mutex mutex; // protects 'sock' and 'inputs'
+	SOCKET sock = OPENMSX_INVALID_SOCKET;
+	std::vector<std::pair<Input, std::string>> inputs;
+	std::atomic<bool> eventPending = false;
+	std::atomic<bool> noAck = false;
+
+	// Only used from the main thread.
+	struct Point {
+		std::string key; // "<type>,<addr>,<kind>" as sent by the client
+		std::vector<unsigned> ids; // breakpoint or watchpoint ids
+		bool isWatch;
+	};
+	std::vector<Point> points;
+	bool waitingForStop = false; // reply 'S05' on the next break
+};
+
+} // namespace openmsx
+
+#endif
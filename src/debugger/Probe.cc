@@ -34,4 +34,9 @@ std::string Probe<void>::getValue() const
 	return {};
 }
 
+std::optional<int64_t> Probe<void>::getNumericValue() const
+{
+	return {};
+}
+
 } // namespace openmsx
@@ -4,7 +4,10 @@
 #include "static_string_view.hh"
 #include "Subject.hh"
 #include "strCat.hh"
+#include <cstdint>
+#include <optional>
 #include <string>
+#include <type_traits>
 
 namespace openmsx {
 
@@ -19,6 +22,9 @@ public:
 	[[nodiscard]] const std::string& getName() const { return name; }
 	[[nodiscard]] std::string_view getDescription() const { return description; }
 	[[nodiscard]] virtual std::string getValue() const = 0;
+	/** The current value as a number, or nothing when this probe doesn't
+	  * have a numeric value (e.g. probes that only signal an event). */
+	[[nodiscard]] virtual std::optional<int64_t> getNumericValue() const = 0;
 
 protected:
 	ProbeBase(Debugger& debugger, std::string name,
@@ -52,6 +58,7 @@ public:
 
 private:
 	[[nodiscard]] std::string getValue() const override;
+	[[nodiscard]] std::optional<int64_t> getNumericValue() const override;
 
 	T value;
 };
@@ -70,6 +77,16 @@ std::string Probe<T>::getValue() const
 	return strCat(value);
 }
 
+template<typename T>
+std::optional<int64_t> Probe<T>::getNumericValue() const
+{
+	if constexpr (std::is_arithmetic_v<T> || std::is_enum_v<T>) {
+		return int64_t(value);
+	} else {
+		return {};
+	}
+}
+
 // specialization for void
 template<> class Probe<void> final : public ProbeBase
 {
@@ -79,6 +96,7 @@ public:
 
 private:
 	[[nodiscard]] std::string getValue() const override;
+	[[nodiscard]] std::optional<int64_t> getNumericValue() const override;
 };
 
 } // namespace openmsx
@@ -32,7 +32,7 @@ void ProbeBreakPoint::update(const ProbeBase& /*subject*/) noexcept
 	auto& reactor = debugger.getMotherBoard().getReactor();
 	auto& cliComm = reactor.getGlobalCliComm();
 	auto& interp  = reactor.getInterpreter();
-	checkAndExecute(cliComm, interp);
+	checkAndExecute(cliComm, interp, debugger.getMotherBoard());
 	if (onlyOnce()) {
 		debugger.removeProbeBreakPoint(*this);
 	}
@@ -0,0 +1,49 @@
+#include "ProbeRecorder.hh"
+#include "Probe.hh"
+#include "Debugger.hh"
+#include "MSXCPU.hh"
+#include "MSXMotherBoard.hh"
+#include <algorithm>
+
+namespace openmsx {
+
+ProbeRecorder::ProbeRecorder(Debugger& debugger_, ProbeBase& probe_, size_t capacity)
+	: debugger(debugger_)
+	, probe(probe_)
+	, samples(capacity)
+{
+	probe.attach(*this);
+}
+
+ProbeRecorder::~ProbeRecorder()
+{
+	probe.detach(*this);
+}
+
+void ProbeRecorder::takeOver(ProbeRecorder& other)
+{
+	samples.swap(other.samples);
+	numDropped = other.numDropped;
+}
+
+void ProbeRecorder::update(const ProbeBase& /*subject*/) noexcept
+{
+	// Probes are changed both from within the CPU emulation loop (then
+	// the scheduler time lags behind) and from sync points (then the CPU
+	// time can be slightly ahead). Take the most accurate of both.
+	auto& motherBoard = debugger.getMotherBoard();
+	EmuTime time = std::max(motherBoard.getCurrentTime(),
+	                        motherBoard.getCPU().getCurrentTime());
+	if (samples.full()) {
+		samples.pop_front();
+		++numDropped;
+	}
+	samples.push_back(Sample{time, probe.getNumericValue().value_or(0)});
+}
+
+void ProbeRecorder::subjectDeleted(const ProbeBase& /*subject*/)
+{
+	debugger.removeProbeRecorder(*this);
+}
+
+} // namespace openmsx
@@ -0,0 +1,67 @@
+#ifndef PROBERECORDER_HH
+#define PROBERECORDER_HH
+
+#include "EmuTime.hh"
+#include "Observer.hh"
+#include "circular_buffer.hh"
+#include <cstdint>
+
+namespace openmsx {
+
+class Debugger;
+class ProbeBase;
+
+/** Records every change of a probe, together with the (emulated) time of
+  * that change, in a ring buffer of fixed size.
+  *
+  * Unlike a probe breakpoint this doesn't execute any Tcl code per event,
+  * so this is cheap enough to follow e.g. all VDP register changes or all
+  * IRQ (de)assertions at full rate. The samples are afterwards retrieved in
+  * bulk. When the buffer is full, the oldest samples are dropped.
+  */
+class ProbeRecorder final : private Observer<ProbeBase>
+{
+public:
+	struct Sample {
+		EmuTime time;
+		int64_t value; // 0 for probes without a numeric value
+	};
+
+	/** The buffer for 'capacity' samples is allocated right away. */
+	ProbeRecorder(Debugger& debugger, ProbeBase& probe, size_t capacity);
+	~ProbeRecorder();
+
+	[[nodiscard]] const ProbeBase& getProbe() const { return probe; }
+	[[nodiscard]] size_t getCapacity() const { return samples.capacity(); }
+	[[nodiscard]] size_t getNumSamples() const { return samples.size(); }
+	[[nodiscard]] uint64_t getNumDropped() const { return numDropped; }
+
+	/** Remove the oldest (at most) 'max' samples, 'op' is called for each
+	  * of them (oldest first). */
+	template<typename Op> void take(size_t max, Op op) {
+		for (size_t i = 0; (i < max) && !samples.empty(); ++i) {
+			op(samples.front());
+			samples.pop_front();
+		}
+	}
+
+	/** Continue with the samples (and the capacity) of 'other', e.g. the
+	  * recorder for the same probe in the previous machine, after a
+	  * reverse or savestate load. */
+	void takeOver(ProbeRecorder& other);
+
+private:
+	// Observer<ProbeBase>
+	void update(const ProbeBase& subject) noexcept override;
+	void subjectDeleted(const ProbeBase& subject) override;
+
+private:
+	Debugger& debugger;
+	ProbeBase& probe;
+	circular_buffer<Sample> samples;
+	uint64_t numDropped = 0;
+};
+
+} // namespace openmsx
+
+#endif
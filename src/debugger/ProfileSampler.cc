@@ -0,0 +1,107 @@
+#include "ProfileSampler.hh"
+#include "MSXMotherBoard.hh"
+#include "MSXCPU.hh"
+#include "CPURegs.hh"
+#include "MSXCPUInterface.hh"
+#include "MSXMemoryMapperBase.hh"
+#include "CliComm.hh"
+#include "TclObject.hh"
+#include "ranges.hh"
+#include "xrange.hh"
+#include <utility>
+#include <vector>
+
+namespace openmsx {
+
+ProfileSampler::ProfileSampler(MSXMotherBoard& motherBoard_)
+	: Schedulable(motherBoard_.getScheduler())
+	, motherBoard(motherBoard_)
+{
+	clear();
+}
+
+ProfileSampler::~ProfileSampler()
+{
+	stop();
+}
+
+void ProfileSampler::start(EmuDuration interval_)
+{
+	interval = interval_;
+	removeSyncPoint();
+	setSyncPoint(getCurrentTime() + interval);
+	if (!running) {
+		running = true;
+		motherBoard.getMSXCliComm().update(CliComm::STATUS, "profiler", "on");
+	}
+}
+
+void ProfileSampler::stop()
+{
+	if (!running) return;
+	removeSyncPoint();
+	running = false;
+	motherBoard.getMSXCliComm().update(CliComm::STATUS, "profiler", "off");
+}
+
+void ProfileSampler::clear()
+{
+	pcs.clear();
+	ranges::fill(opcodes, 0);
+	numSamples = 0;
+}
+
+void ProfileSampler::executeUntil(EmuTime::param time)
+{
+	sample(time);
+	setSyncPoint(time + interval);
+}
+
+void ProfileSampler::sample(EmuTime::param time)
+{
+	if (!motherBoard.getMachineConfig()) return;
+	auto& cpuInterface = motherBoard.getCPUInterface();
+	unsigned pc = motherBoard.getCPU().getRegisters().getPC();
+	unsigned page = pc >> 14;
+
+	unsigned ps = cpuInterface.getPrimarySlot(page);
+	uint32_t key = pc | (ps << 24);
+	if (cpuInterface.isExpanded(ps)) {
+		key |= (cpuInterface.getSecondarySlot(page) << 26) | (1 << 28);
+	}
+	if (auto* mapper = dynamic_cast<MSXMemoryMapperBase*>(
+			cpuInterface.getVisibleMSXDevice(page))) {
+		key |= (mapper->getSelectedSegment(page) << 16) | (1 << 29);
+	}
+	++pcs[key];
+	++opcodes[cpuInterface.peekMem(pc, time)];
+	++numSamples;
+}
+
+void ProfileSampler::getPCs(TclObject& result, unsigned maxEntries) const
+{
+	std::vector<std::pair<uint32_t, uint64_t>> sorted(pcs.begin(), pcs.end());
+	ranges::sort(sorted, [](auto& x, auto& y) { return x.second > y.second; });
+	if (sorted.size() > maxEntries) sorted.resize(maxEntries);
+	for (const auto& [key, count] : sorted) {
+		int ps  = (key >> 24) & 3;
+		int ss  = (key & (1 << 28)) ? int((key >> 26) & 3) : -1;
+		int seg = (key & (1 << 29)) ? int((key >> 16) & 0xff) : -1;
+		result.addListElement(makeTclList(ps, ss, seg, int(key & 0xffff),
+		                                  int64_t(count)));
+	}
+}
+
+void ProfileSampler::getOpcodes(TclObject& result) const
+{
+	std::vector<std::pair<int, uint64_t>> sorted;
+	for (auto op : xrange(256)) {
+		if (opcodes[op]) sorted.emplace_back(op, opcodes[op]);
+	}
+	ranges::sort(sorted, [](auto& x, auto& y) { return x.second > y.second; });
+	for (const auto& [op, count] : sorted) {
+		result.addListElement(makeTclList(op, int64_t(count)));
+	}
+}
+
+} // namespace openmsx
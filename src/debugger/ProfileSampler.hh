@@ -0,0 +1,60 @@
+#ifndef PROFILESAMPLER_HH
+#define PROFILESAMPLER_HH
+
+#include "Schedulable.hh"
+#include "EmuDuration.hh"
+#include "hash_map.hh"
+#include <array>
+#include <cstdint>
+
+namespace openmsx {
+
+class MSXMotherBoard;
+class TclObject;
+
+/** Statistical profiler for the MSX CPU.
+  *
+  * Instead of instrumenting every instruction (like 'cpu trace' does), this
+  * periodically (in emulated time) samples the current program counter,
+  * together with the slot, subslot and mapper segment that are visible in
+  * the page of the PC. It also counts the opcodes at the sampled positions.
+  * When not running, this has no cost at all. When running, the cost only
+  * depends on the sample interval, not on the number of executed
+  * instructions.
+  */
+class ProfileSampler final : public Schedulable
+{
+public:
+	explicit ProfileSampler(MSXMotherBoard& motherBoard);
+	~ProfileSampler();
+
+	void start(EmuDuration interval);
+	void stop();
+	void clear();
+	[[nodiscard]] bool isRunning() const { return running; }
+	[[nodiscard]] uint64_t getNumSamples() const { return numSamples; }
+
+	/** Returns list of {slot subslot segment pc count} entries, most often
+	  * sampled first. Subslot and segment are -1 when not applicable. */
+	void getPCs(TclObject& result, unsigned maxEntries) const;
+	/** Returns list of {opcode count} entries, most often sampled first. */
+	void getOpcodes(TclObject& result) const;
+
+private:
+	void executeUntil(EmuTime::param time) override;
+	void sample(EmuTime::param time);
+
+private:
+	MSXMotherBoard& motherBoard;
+	// key: 16-bit pc, 8-bit mapper segment, 2-bit subslot, 2-bit slot and
+	//      2 flag bits (is expanded, has segment)
+	hash_map<uint32_t, uint64_t> pcs;
+	std::array<uint64_t, 256> opcodes;
+	uint64_t numSamples = 0;
+	EmuDuration interval;
+	bool running = false;
+};
+
+} // namespace openmsx
+
+#endif
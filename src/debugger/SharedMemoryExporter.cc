@@ -0,0 +1,301 @@
+#include "SharedMemoryExporter.hh"
+#include "Debugger.hh"
+#include "Debuggable.hh"
+#include "EventDistributor.hh"
+#include "Event.hh"
+#include "CommandException.hh"
+#include "TclObject.hh"
+#include "ranges.hh"
+#include "stl.hh"
+#include "strCat.hh"
+#include "view.hh"
+#include "xrange.hh"
+#include "systemfuncs.hh"
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#if defined _WIN32
+#include "utf8_checked.hh"
+#include <windows.h>
+#elif HAVE_MMAP && !defined __ANDROID__
+#define HAVE_SHM 1
+#include "unistdp.hh"
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+namespace openmsx {
+
+struct ShmHeader {
+	char magic[8];
+	uint32_t version;
+	uint32_t numRegions;
+	std::atomic<uint64_t> sequence;
+};
+static_assert(sizeof(ShmHeader) == 24);
+static_assert(std::atomic<uint64_t>::is_always_lock_free);
+
+struct ShmRegion {
+	char name[48];
+	uint32_t offset;
+	uint32_t size;
+};
+static_assert(sizeof(ShmRegion) == 56);
+
+static constexpr uint32_t SHM_VERSION = 1;
+static constexpr size_t ALIGNMENT = 4096; // page size
+
+static constexpr size_t alignUp(size_t n)
+{
+	return (n + ALIGNMENT - 1) & ~(ALIGNMENT - 1);
+}
+
+// A named, writable shared memory object. It's removed again in the
+// destructor.
+class SharedMemory
+{
+public:
+	SharedMemory(const SharedMemory&) = delete;
+	SharedMemory& operator=(const SharedMemory&) = delete;
+
+	SharedMemory(std::string_view name, size_t size_);
+	~SharedMemory();
+
+	[[nodiscard]] uint8_t* data() { return mem; }
+
+private:
+	uint8_t* mem = nullptr;
+	size_t size;
+#if defined _WIN32
+	HANDLE hMap = nullptr;
+#elif HAVE_SHM
+	std::string path;
+#endif
+};
+
+#if defined _WIN32
+
+SharedMemory::SharedMemory(std::string_view name, size_t size_)
+	: size(size_)
+{
+	hMap = CreateFileMappingW(
+		INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE,
+		DWORD(uint64_t(size) >> 32), DWORD(size),
+		utf8::utf8to16(std::string(name)).c_str());
+	if (!hMap) {
+		throw CommandException("Couldn't create shared memory object ",
+		                       name, ": CreateFileMapping failed: ",
+		                       GetLastError());
+	}
+	mem = static_cast<uint8_t*>(MapViewOfFile(hMap, FILE_MAP_ALL_ACCESS, 0, 0, size));
+	if (!mem) {
+		DWORD gle = GetLastError();
+		CloseHandle(hMap);
+		throw CommandException("Couldn't create shared memory object ",
+		                       name, ": MapViewOfFile failed: ", gle);
+	}
+}
+
+SharedMemory::~SharedMemory()
+{
+	UnmapViewOfFile(mem);
+	CloseHandle(hMap);
+}
+
+#elif HAVE_SHM
+
+SharedMemory::SharedMemory(std::string_view name, size_t size_)
+	: size(size_), path(strCat('/', name))
+{
+	auto error = [&](const char* what) {
+		return CommandException("Couldn't create shared memory object ",
+		                        name, ": ", what, ": ", strerror(errno));
+	};
+	// O_TRUNC: replace a left-over object, e.g. from a crashed session.
+	int fd = shm_open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0600);
+	if (fd == -1) throw error("shm_open");
+	if (ftruncate(fd, off_t(size)) == -1) {
+		auto e = error("ftruncate");
+		close(fd);
+		shm_unlink(path.c_str());
+		throw e;
+	}
+	void* p = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	// MAP_FAILED is #define'd using an old-style cast, we have to
+	// redefine it ourselves to avoid a warning
+	auto* MY_MAP_FAILED = reinterpret_cast<void*>(-1);
+	if (p == MY_MAP_FAILED) {
+		auto e = error("mmap");
+		close(fd);
+		shm_unlink(path.c_str());
+		throw e;
+	}
+	close(fd); // the mapping stays valid
+	mem = static_cast<uint8_t*>(p);
+}
+
+SharedMemory::~SharedMemory()
+{
+	munmap(mem, size);
+	shm_unlink(path.c_str());
+}
+
+#else
+
+SharedMemory::SharedMemory(std::string_view /*name*/, size_t size_)
+	: size(size_)
+{
+	throw CommandException("Shared memory is not supported on this platform");
+}
+
+SharedMemory::~SharedMemory() = default;
+
+#endif
+
+
+struct SharedMemoryExporter::Export
+{
+	Export(std::string_view name_, std::vector<std::string> debuggables_, size_t size)
+		: name(name_), debuggables(std::move(debuggables_)), mem(name, size) {}
+
+	[[nodiscard]] ShmHeader& header() {
+		return *reinterpret_cast<ShmHeader*>(mem.data());
+	}
+	[[nodiscard]] ShmRegion* regions() {
+		return reinterpret_cast<ShmRegion*>(mem.data() + sizeof(ShmHeader));
+	}
+
+	std::string name;
+	std::vector<std::string> debuggables;
+	SharedMemory mem;
+};
+
+
+SharedMemoryExporter::SharedMemoryExporter(
+		Debugger& debugger_, EventDistributor& distributor_)
+	: debugger(debugger_), distributor(distributor_)
+{
+	distributor.registerEventListener(EventType::FINISH_FRAME, *this);
+}
+
+SharedMemoryExporter::~SharedMemoryExporter()
+{
+	distributor.unregisterEventListener(EventType::FINISH_FRAME, *this);
+}
+
+void SharedMemoryExporter::start(std::string_view name, std::vector<std::string> debuggables)
+{
+	if (name.empty() || (name.find_first_of("/\\") != std::string_view::npos)) {
+		throw CommandException("Invalid shared memory name: ", name);
+	}
+	if (debuggables.empty()) {
+		throw CommandException("Need at least one debuggable");
+	}
+	std::vector<unsigned> sizes;
+	for (const auto& d : debuggables) {
+		if (d.size() >= sizeof(ShmRegion::name)) {
+			throw CommandException("Debuggable name too long: ", d);
+		}
+		auto* device = debugger.findDebuggable(d);
+		if (!device) {
+			throw CommandException("No such debuggable: ", d);
+		}
+		sizes.push_back(device->getSize());
+	}
+
+	// Data starts on a page boundary, and each region as well.
+	size_t total = alignUp(
+		sizeof(ShmHeader) + debuggables.size() * sizeof(ShmRegion));
+	std::vector<uint32_t> offsets;
+	for (auto size : sizes) {
+		offsets.push_back(uint32_t(total));
+		total = alignUp(total + size);
+	}
+	if (total > 0xFFFFFFFF) {
+		throw CommandException("Shared memory object too large");
+	}
+
+	// Replaces an existing export with the same name.
+	stop(name);
+	auto e = std::make_unique<Export>(name, std::move(debuggables), total);
+	auto& header = e->header();
+	memcpy(header.magic, "openMSX", 8);
+	header.version = SHM_VERSION;
+	header.numRegions = uint32_t(e->debuggables.size());
+	header.sequence.store(0, std::memory_order_relaxed);
+	auto* regions = e->regions();
+	for (auto i : xrange(e->debuggables.size())) {
+		auto& r = regions[i];
+		memset(r.name, 0, sizeof(r.name));
+		memcpy(r.name, e->debuggables[i].data(), e->debuggables[i].size());
+		r.offset = offsets[i];
+		r.size = sizes[i];
+	}
+	update(*e);
+	exports.push_back(std::move(e));
+}
+
+void SharedMemoryExporter::stop(std::string_view name)
+{
+	auto it = ranges::find(exports, name, [](auto& e) -> std::string_view { return e->name; });
+	if (it != end(exports)) move_pop_back(exports, it);
+}
+
+void SharedMemoryExporter::list(TclObject& result) const
+{
+	for (const auto& e : exports) {
+		auto seq = e->header().sequence.load(std::memory_order_relaxed);
+		TclObject names;
+		names.addListElements(e->debuggables);
+		result.addListElement(makeTclList(e->name, names, int64_t(seq / 2)));
+	}
+}
+
+std::vector<std::string> SharedMemoryExporter::getNames() const
+{
+	return to_vector(view::transform(exports, [](auto& e) { return e->name; }));
+}
+
+void SharedMemoryExporter::takeOver(SharedMemoryExporter& other)
+{
+	assert(exports.empty());
+	exports = std::move(other.exports);
+	other.exports.clear();
+	for (auto& e : exports) update(*e);
+}
+
+void SharedMemoryExporter::update(Export& e)
+{
+	auto& header = e.header();
+	auto seq = header.sequence.load(std::memory_order_relaxed);
+	// Mark as 'being updated' before touching the data.
+	header.sequence.store(seq + 1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+
+	auto* regions = e.regions();
+	for (auto i : xrange(e.debuggables.size())) {
+		// Look up again each time: the device (e.g. a cartridge with
+		// RAM) may have been removed in the mean time. In that case
+		// the region keeps its last content.
+		auto* device = debugger.findDebuggable(e.debuggables[i]);
+		if (!device) continue;
+		auto& r = regions[i];
+		auto size = std::min(r.size, device->getSize());
+		device->readBlock(0, span<byte>(e.mem.data() + r.offset, size));
+	}
+
+	header.sequence.store(seq + 2, std::memory_order_release);
+}
+
+int SharedMemoryExporter::signalEvent(const Event& event) noexcept
+{
+	assert(getType(event) == EventType::FINISH_FRAME); (void)event;
+	for (auto& e : exports) update(*e);
+	return 0;
+}
+
+} // namespace openmsx
@@ -0,0 +1,72 @@
+#ifndef SHAREDMEMORYEXPORTER_HH
+#define SHAREDMEMORYEXPORTER_HH
+
+#include "EventListener.hh"
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace openmsx {
+
+class Debugger;
+class EventDistributor;
+class TclObject;
+
+/** Mirrors the content of some debuggables (e.g. 'memory', 'VRAM') in a
+  * named shared memory object, so that external tools (visualizers,
+  * trainers, AI agents, ...) can read them without going through Tcl
+  * ('debug read_block') on every frame.
+  *
+  * The content is copied at the end of every frame (FINISH_FRAME event).
+  * Layout of the shared memory object (all values in native byte order):
+  *   Header:  char magic[8]       "openMSX"
+  *            uint32_t version    currently 1
+  *            uint32_t numRegions
+  *            uint64_t sequence   odd while an update is in progress
+  *   followed by 'numRegions' times:
+  *            char name[48]       debuggable name (zero terminated)
+  *            uint32_t offset     start of the data (page aligned)
+  *            uint32_t size
+  * A reader can use 'sequence' like a seqlock: read it (it must be even),
+  * copy the data, read it again, and retry when it changed. 'sequence / 2'
+  * is the number of completed updates (frames).
+  *
+  * On POSIX systems the object is created with shm_open("/<name>") (on
+  * Linux it's visible as /dev/shm/<name>), on Windows it's a named file
+  * mapping "<name>". It's removed again on stop (or on exit).
+  */
+class SharedMemoryExporter final : private EventListener
+{
+public:
+	SharedMemoryExporter(Debugger& debugger, EventDistributor& distributor);
+	~SharedMemoryExporter();
+
+	/** Create (or recreate) the shared memory object 'name', containing
+	  * the given debuggables. Throws CommandException on error. */
+	void start(std::string_view name, std::vector<std::string> debuggables);
+	/** Remove the shared memory object 'name'. */
+	void stop(std::string_view name);
+	/** Returns a list of {name {debuggables} updates} elements. */
+	void list(TclObject& result) const;
+	[[nodiscard]] std::vector<std::string> getNames() const;
+
+	/** Continue the exports of 'other' (from a different machine, e.g.
+	  * after a reverse jump) with the debuggables of this machine. */
+	void takeOver(SharedMemoryExporter& other);
+
+private:
+	struct Export;
+	void update(Export& e);
+
+	int signalEvent(const Event& event) noexcept override;
+
+private:
+	Debugger& debugger;
+	EventDistributor& distributor;
+	std::vector<std::unique_ptr<Export>> exports;
+};
+
+} // namespace openmsx
+
+#endif
@@ -5,14 +5,18 @@
 #include "Schedulable.hh"
 #include "EventDistributor.hh"
 #include "InputEventFactory.hh"
+#include "Interpreter.hh"
 #include "Reactor.hh"
 #include "MSXMotherBoard.hh"
 #include "ObjectPool.hh"
+#include "PerfTimers.hh"
 #include "RTSchedulable.hh"
+#include "ScriptProfiler.hh"
 #include "EmuTime.hh"
 #include "CommandException.hh"
 #include "StringOp.hh"
 #include "TclObject.hh"
+#include "Timer.hh"
 #include "ranges.hh"
 #include "stl.hh"
 #include "unreachable.hh"
@@ -322,8 +326,28 @@ void AfterCommand::afterIdle(span<const TclObject> tokens, TclObject& result)
 	afterCmds.push_back(idx);
 }
 
-void AfterCommand::afterInfo(span<const TclObject> /*tokens*/, TclObject& result)
+void AfterCommand::afterInfo(span<const TclObject> tokens, TclObject& result)
 {
+	checkNumArgs(tokens, Between{2, 3}, "?-stats?");
+	if (tokens.size() == 3) {
+		if (tokens[2] != "-stats") throw SyntaxError();
+		std::vector<std::pair<std::string_view, CallbackStats>> sorted(
+			begin(stats), end(stats));
+		ranges::sort(sorted, [](const auto& x, const auto& y) {
+			return x.second.time > y.second.time;
+		});
+		std::ostringstream str;
+		str.precision(3);
+		str << std::fixed << std::showpoint;
+		for (const auto& [name, s] : sorted) {
+			str << name << ": " << s.calls << " calls, "
+			    << (s.time / 1000.0) << "ms total\n";
+		}
+		result = str.str();
+		return;
+	}
+
+
 	auto printTime = [](std::ostream& os, const AfterTimedCmd& cmd) {
 		os.precision(3);
 		os << std::fixed << std::showpoint << cmd.getTime() << ' ';
@@ -398,9 +422,26 @@ std::string AfterCommand::help(span<const TclObject> /*tokens*/) const
 	       "after boot <command>                execute a command after a (re)boot\n"
 	       "after machine_switch <command>      execute a command after a switch to a new machine\n"
 	       "after info                          list all postponed commands\n"
+	       "after info -stats                   show number of calls and total execution time per command name\n"
 	       "after cancel <id>                   cancel the postponed command with given id\n";
 }
 
+void AfterCommand::addStats(std::string_view command, uint64_t duration)
+{
+	// Take the command name from the string representation. Converting
+	// the command to a list would throw away its compiled form.
+	auto first = command.find_first_not_of(" \t\n");
+	if (first == std::string_view::npos) return;
+	command.remove_prefix(first);
+	auto name = command.substr(0, command.find_first_of(" \t\n;"));
+	auto it = stats.find(name);
+	if (it == end(stats)) {
+		it = stats.emplace(std::string(name), CallbackStats{}).first;
+	}
+	++it->second.calls;
+	it->second.time += duration;
+}
+
 void AfterCommand::tabCompletion(std::vector<std::string>& tokens) const
 {
 	if (tokens.size() == 2) {
@@ -505,12 +546,20 @@ AfterCmd::AfterCmd(AfterCommand& afterCommand_, TclObject command_)
 
 void AfterCmd::execute()
 {
+	// Compile the command: callbacks like 'after frame' are typically
+	// re-registered with the same (literal) Tcl_Obj, so the bytecode is
+	// reused on the next execution.
+	auto& interp = afterCommand.getInterpreter();
+	PerfTimers::Scope perf(PerfTimers::TCL);
+	auto start = Timer::getTime();
 	try {
-		command.executeCommand(afterCommand.getInterpreter());
+		ScriptProfiler::Scope scope(interp.getProfiler(), "after", command.getString());
+		command.executeCommand(interp, true);
 	} catch (CommandException& e) {
 		afterCommand.getCommandController().getCliComm().printWarning(
 			"Error executing delayed command: ", e.getMessage());
 	}
+	afterCommand.addStats(command.getString(), Timer::getTime() - start);
 }
 
 AfterCommand::Index AfterCmd::removeSelf()
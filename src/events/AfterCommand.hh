@@ -4,6 +4,10 @@
 #include "Command.hh"
 #include "EventListener.hh"
 #include "Event.hh"
+#include <cstdint>
+#include <map>
+#include <string>
+#include <string_view>
 #include <vector>
 
 namespace openmsx {
@@ -40,12 +44,20 @@ private:
 	void afterIdle    (span<const TclObject> tokens, TclObject& result);
 	void afterInfo    (span<const TclObject> tokens, TclObject& result);
 	void afterCancel  (span<const TclObject> tokens, TclObject& result);
+	void addStats(std::string_view command, uint64_t duration);
 
 	// EventListener
 	int signalEvent(const Event& event) noexcept override;
 
 private:
+	struct CallbackStats {
+		uint64_t calls = 0;
+		uint64_t time = 0; // total execution time in us
+	};
+
 	std::vector<Index> afterCmds;
+	// per command name (the first word of the command)
+	std::map<std::string, CallbackStats, std::less<>> stats;
 	Reactor& reactor;
 	EventDistributor& eventDistributor;
 
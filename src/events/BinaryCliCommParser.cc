@@ -0,0 +1,47 @@
+#include "BinaryCliCommParser.hh"
+#include <algorithm>
+
+namespace openmsx {
+
+BinaryCliCommParser::BinaryCliCommParser(std::function<void(const std::string&)> callback_)
+	: callback(std::move(callback_))
+{
+}
+
+void BinaryCliCommParser::parse(const char* buf, size_t n)
+{
+	while (n) {
+		if (headerPos < 5) {
+			auto c = uint8_t(*buf++); --n;
+			if (headerPos == 0) {
+				type = char(c);
+				remaining = 0;
+			} else {
+				remaining |= uint32_t(c) << (8 * (headerPos - 1));
+			}
+			if (++headerPos < 5) continue;
+			payload.clear();
+			if (type == COMMAND) payload.reserve(remaining);
+		} else {
+			auto num = std::min<size_t>(n, remaining);
+			if (type == COMMAND) payload.append(buf, num);
+			buf += num; n -= num; remaining -= uint32_t(num);
+		}
+		if (remaining == 0) {
+			if (type == COMMAND) callback(payload);
+			headerPos = 0;
+		}
+	}
+}
+
+void BinaryCliCommParser::appendFrame(std::string& result, char type, std::string_view payload)
+{
+	auto size = uint32_t(payload.size());
+	result += type;
+	for (int i = 0; i < 4; ++i) {
+		result += char(size >> (8 * i));
+	}
+	result.append(payload.data(), payload.size());
+}
+
+} // namespace openmsx
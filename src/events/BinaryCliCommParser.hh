@@ -0,0 +1,46 @@
+#ifndef BINARYCLICOMMPARSER_HH
+#define BINARYCLICOMMPARSER_HH
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+
+namespace openmsx {
+
+/** Length-prefixed alternative for the XML control protocol.
+  *
+  * After the 'openmsx_protocol binary' command, both directions use frames
+  * of the form:
+  *   1 byte   type
+  *   4 bytes  payload length (little endian)
+  *   N bytes  payload (raw, not escaped)
+  * The only frame type a client sends is 'C' (command). Frames of unknown
+  * types are skipped.
+  */
+class BinaryCliCommParser
+{
+public:
+	static constexpr char COMMAND = 'C';
+	static constexpr char REPLY_OK = 'R';
+	static constexpr char REPLY_NOK = 'E';
+	static constexpr char LOG = 'L';
+	static constexpr char UPDATE = 'U';
+
+	explicit BinaryCliCommParser(std::function<void(const std::string&)> callback);
+	void parse(const char* buf, size_t n);
+
+	/** Append a frame with the given type and payload to 'result'. */
+	static void appendFrame(std::string& result, char type, std::string_view payload);
+
+private:
+	std::function<void(const std::string&)> callback;
+	std::string payload;
+	uint32_t remaining = 0; // number of payload bytes still needed
+	unsigned headerPos = 0; // number of header bytes received, 0..5
+	char type = 0;
+};
+
+} // namespace openmsx
+
+#endif
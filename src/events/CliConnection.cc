@@ -31,6 +31,7 @@ namespace openmsx {
 CliConnection::CliConnection(CommandController& commandController_,
                              EventDistributor& eventDistributor_)
 	: parser([this](const std::string& cmd) { execute(cmd); })
+	, binaryParser([this](const std::string& cmd) { execute(cmd); })
 	, commandController(commandController_)
 	, eventDistributor(eventDistributor_)
 {
@@ -47,8 +48,15 @@ CliConnection::~CliConnection()
 void CliConnection::log(CliComm::LogLevel level, std::string_view message) noexcept
 {
 	auto levelStr = CliComm::getLevelStrings();
-	output(tmpStrCat("<log level=\"", levelStr[level], "\">",
-	                 XMLEscape(message), "</log>\n"));
+	if (binary) {
+		std::string tmp;
+		BinaryCliCommParser::appendFrame(tmp, BinaryCliCommParser::LOG,
+		                                 tmpStrCat(levelStr[level], '\0', message));
+		send(tmp);
+		return;
+	}
+	send(tmpStrCat("<log level=\"", levelStr[level], "\">",
+	               XMLEscape(message), "</log>\n"));
 }
 
 void CliConnection::update(CliComm::UpdateType type, std::string_view machine,
@@ -57,21 +65,93 @@ void CliConnection::update(CliComm::UpdateType type, std::string_view machine,
 	if (!getUpdateEnable(type)) return;
 
 	auto updateStr = CliComm::getUpdateStrings();
-	auto tmp = strCat("<update type=\"", updateStr[type], '\"');
-	if (!machine.empty()) {
-		strAppend(tmp, " machine=\"", machine, '\"');
+	std::string tmp;
+	if (binary) {
+		BinaryCliCommParser::appendFrame(tmp, BinaryCliCommParser::UPDATE,
+			tmpStrCat(updateStr[type], '\0', machine, '\0', name, '\0', value));
+	} else {
+		strAppend(tmp, "<update type=\"", updateStr[type], '\"');
+		if (!machine.empty()) {
+			strAppend(tmp, " machine=\"", machine, '\"');
+		}
+		if (!name.empty()) {
+			strAppend(tmp, " name=\"", XMLEscape(name), '\"');
+		}
+		strAppend(tmp, '>', XMLEscape(value), "</update>\n");
 	}
-	if (!name.empty()) {
-		strAppend(tmp, " name=\"", XMLEscape(name), '\"');
+
+	std::unique_lock<std::mutex> lock(outMutex);
+	if (!writing) return;
+	if (coalesceWindow.count() == 0) {
+		lock.unlock();
+		send(tmp);
+		return;
+	}
+	// Replace a pending value for the same key, the writer thread sends
+	// the pending updates when the window has passed.
+	auto key = strCat(int(type), ':', machine, ':', name);
+	if (auto it = ranges::find(pendingUpdates, key, [](auto& p) -> auto& { return p.first; });
+	    it != pendingUpdates.end()) {
+		it->second = std::move(tmp);
+	} else {
+		pendingUpdates.emplace_back(std::move(key), std::move(tmp));
+		outCondition.notify_one();
 	}
-	strAppend(tmp, '>', XMLEscape(value), "</update>\n");
+}
 
-	output(tmp);
+void CliConnection::setUpdateCoalescing(unsigned ms)
+{
+	std::lock_guard<std::mutex> lock(outMutex);
+	coalesceWindow = std::chrono::milliseconds(ms);
+	outCondition.notify_one(); // a shorter window may flush right away
 }
 
 void CliConnection::startOutput()
 {
 	output("<openmsx-output>\n");
+	std::lock_guard<std::mutex> lock(outMutex);
+	writing = true;
+	writerThread = std::thread([this]() { writerLoop(); });
+}
+
+void CliConnection::send(std::string_view message)
+{
+	std::lock_guard<std::mutex> lock(outMutex);
+	if (!writing) return;
+	bool wasEmpty = outBuffer.empty();
+	outBuffer.append(message);
+	if (wasEmpty) outCondition.notify_one();
+}
+
+void CliConnection::writerLoop()
+{
+	// runs in writer thread
+	std::unique_lock<std::mutex> lock(outMutex);
+	while (true) {
+		auto deadline = lastUpdateFlush + coalesceWindow;
+		if (!pendingUpdates.empty() &&
+		    (stopWriting || (std::chrono::steady_clock::now() >= deadline))) {
+			for (auto& [key, message] : pendingUpdates) {
+				outBuffer += message;
+			}
+			pendingUpdates.clear();
+			lastUpdateFlush = std::chrono::steady_clock::now();
+		}
+		if (!outBuffer.empty()) {
+			std::string data;
+			swap(data, outBuffer);
+			lock.unlock();
+			output(data);
+			lock.lock();
+			continue;
+		}
+		if (stopWriting) break;
+		if (pendingUpdates.empty()) {
+			outCondition.wait(lock);
+		} else {
+			outCondition.wait_until(lock, deadline);
+		}
+	}
 }
 
 void CliConnection::start()
@@ -81,7 +161,16 @@ void CliConnection::start()
 
 void CliConnection::end()
 {
-	output("</openmsx-output>\n");
+	{
+		std::lock_guard<std::mutex> lock(outMutex);
+		stopWriting = true;
+		outCondition.notify_one();
+	}
+	if (writerThread.joinable()) {
+		// first write all queued output
+		writerThread.join();
+	}
+	if (!binary) output("</openmsx-output>\n");
 	close();
 
 	poller.abort();
@@ -91,16 +180,39 @@ void CliConnection::end()
 	}
 }
 
+void CliConnection::parse(const char* buf, size_t n)
+{
+	if (binary) {
+		binaryParser.parse(buf, n);
+	} else {
+		parser.parse(buf, n);
+	}
+}
+
 void CliConnection::execute(const std::string& command)
 {
 	eventDistributor.distributeEvent(
 		Event::create<CliCommandEvent>(command, this));
 }
 
-static TemporaryString reply(std::string_view message, bool status)
+void CliConnection::sendReply(std::string_view message, bool status)
 {
-	return tmpStrCat("<reply result=\"", (status ? "ok" : "nok"), "\">",
-	                 XMLEscape(message), "</reply>\n");
+	std::string tmp;
+	if (binary) {
+		BinaryCliCommParser::appendFrame(
+			tmp, status ? BinaryCliCommParser::REPLY_OK : BinaryCliCommParser::REPLY_NOK,
+			message);
+	} else {
+		strAppend(tmp, "<reply result=\"", (status ? "ok" : "nok"), "\">",
+		          XMLEscape(message), "</reply>\n");
+	}
+	if (binaryRequested) {
+		// Switch before sending: the client may send binary frames as
+		// soon as it receives this (last XML) reply.
+		binaryRequested = false;
+		binary = true;
+	}
+	send(tmp);
 }
 
 int CliConnection::signalEvent(const Event& event) noexcept
@@ -108,18 +220,25 @@ int CliConnection::signalEvent(const Event& event) noexcept
 	assert(getType(event) == EventType::CLICOMMAND);
 	const auto& commandEvent = get<CliCommandEvent>(event);
 	if (commandEvent.getId() == this) {
-		try {
-			auto result = commandController.executeCommand(
-				commandEvent.getCommand(), this).getString();
-			output(reply(result, true));
-		} catch (CommandException& e) {
-			std::string result = std::move(e).getMessage() + '\n';
-			output(reply(result, false));
-		}
+		pendingCommands.emplace_back(commandEvent.getCommand());
 	}
 	return 0;
 }
 
+void CliConnection::executePendingCommand()
+{
+	assert(!pendingCommands.empty());
+	auto command = std::move(pendingCommands.front());
+	pendingCommands.pop_front();
+	try {
+		auto result = commandController.executeCommand(command, this).getString();
+		sendReply(result, true);
+	} catch (CommandException& e) {
+		std::string result = std::move(e).getMessage() + '\n';
+		sendReply(result, false);
+	}
+}
+
 
 // class StdioConnection
 
@@ -148,7 +267,7 @@ void StdioConnection::run()
 		char buf[BUF_SIZE];
 		int n = read(STDIN_FILENO, buf, sizeof(buf));
 		if (n > 0) {
-			parser.parse(buf, n);
+			parse(buf, n);
 		} else if (n < 0) {
 			break;
 		}
@@ -238,7 +357,7 @@ void PipeConnection::run()
 			if (!GetOverlappedResult(pipeHandle, &overlapped, &bytesRead, TRUE)) {
 				break; // Pipe broke
 			}
-			parser.parse(buf, bytesRead);
+			parse(buf, bytesRead);
 		} else if (wait == WAIT_OBJECT_0) {
 			break; // Shutdown
 		} else {
@@ -317,7 +436,7 @@ void SocketConnection::run()
 		char buf[BUF_SIZE];
 		int n = sock_recv(sd, buf, BUF_SIZE);
 		if (n > 0) {
-			parser.parse(buf, n);
+			parse(buf, n);
 		} else if (n < 0) {
 			break;
 		}
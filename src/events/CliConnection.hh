@@ -6,10 +6,17 @@
 #include "Socket.hh"
 #include "CliComm.hh"
 #include "AdhocCliCommParser.hh"
+#include "BinaryCliCommParser.hh"
 #include "Poller.hh"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
 #include <mutex>
 #include <string>
 #include <thread>
+#include <utility>
+#include <vector>
 
 namespace openmsx {
 
@@ -26,6 +33,18 @@ public:
 		return updateEnabled[type];
 	}
 
+	/** Only send the last value of each update (type, machine, name)
+	  * at most once per 'ms' milliseconds. Zero (the default) sends all
+	  * updates immediately.
+	  */
+	void setUpdateCoalescing(unsigned ms);
+
+	/** Switch both directions to the length-prefixed binary protocol (see
+	  * BinaryCliCommParser) once the reply to the current command is sent.
+	  * That reply itself is still in XML.
+	  */
+	void requestBinaryProtocol() { binaryRequested = true; }
+
 	/** Starts the helper thread.
 	  * Called when this CliConnection is added to GlobalCliComm (and
 	  * after it's allowed to respond to external commands).
@@ -33,11 +52,20 @@ public:
 	  */
 	void start();
 
+	/** Commands are not executed when they arrive, but queued (see
+	  * GlobalCliComm::executeCommands()). Main thread only. */
+	[[nodiscard]] size_t numPendingCommands() const { return pendingCommands.size(); }
+	/** Execute the oldest pending command and send its reply. */
+	void executePendingCommand();
+
 protected:
 	CliConnection(CommandController& commandController,
 	              EventDistributor& eventDistributor);
 	~CliConnection() override;
 
+	/** Write to the client. Called from the writer thread, except for
+	  * the opening and closing tags (see startOutput() and end()).
+	  */
 	virtual void output(std::string_view message) = 0;
 
 	/** End this connection by sending the closing tag
@@ -55,16 +83,24 @@ protected:
 	  * shortly after opening a connection. Cannot be implemented in the
 	  * base class because some subclasses (want to send data before this
 	  * tag).
+	  * This also starts the writer thread: all later output is queued and
+	  * written asynchronously, so a slow client cannot stall the emulation.
+	  * Messages before this call are dropped.
 	  */
 	void startOutput();
 
-	AdhocCliCommParser parser;
+	/** Handle input from the client, called from the helper thread. */
+	void parse(const char* buf, size_t n);
+
 	Poller poller;
 
 private:
 	virtual void run() = 0;
 
 	void execute(const std::string& command);
+	void send(std::string_view message);
+	void sendReply(std::string_view message, bool status);
+	void writerLoop();
 
 	// CliListener
 	void log(CliComm::LogLevel level, std::string_view message) noexcept override;
@@ -74,11 +110,34 @@ private:
 	// EventListener
 	int signalEvent(const Event& event) noexcept override;
 
+	AdhocCliCommParser parser;
+	BinaryCliCommParser binaryParser;
+
 	CommandController& commandController;
 	EventDistributor& eventDistributor;
 
 	std::thread thread;
 
+	// Received, but not yet executed commands (main thread only).
+	std::deque<std::string> pendingCommands;
+
+	// Asynchronous output, all protected by 'outMutex'.
+	std::thread writerThread;
+	std::mutex outMutex;
+	std::condition_variable outCondition;
+	std::string outBuffer;
+	// {type, machine, name} -> message, in order of first occurrence
+	std::vector<std::pair<std::string, std::string>> pendingUpdates;
+	std::chrono::milliseconds coalesceWindow{0};
+	std::chrono::steady_clock::time_point lastUpdateFlush;
+	bool writing = false;
+	bool stopWriting = false;
+
+	// Only changed from the main thread between two commands, the client
+	// must wait for the reply before it uses the binary protocol.
+	std::atomic<bool> binary = false;
+	bool binaryRequested = false;
+
 	bool updateEnabled[CliComm::NUM_UPDATES];
 };
 
@@ -451,11 +451,13 @@ class MachineDeactivatedEvent    final : public SimpleEvent {};
   * should be repainted. */
 class ExposeEvent                final : public SimpleEvent {};
 
-class MidiInReaderEvent          final : public SimpleEvent {};
-class MidiInWindowsEvent         final : public SimpleEvent {};
-class MidiInCoreMidiEvent        final : public SimpleEvent {};
-class MidiInCoreMidiVirtualEvent final : public SimpleEvent {};
+/** Sent by the MIDI-in devices when new data arrived from the host (at most
+  * one pending event per device, see MidiInHostDevice). */
+class MidiInEvent                final : public SimpleEvent {};
 class Rs232TesterEvent           final : public SimpleEvent {};
+class Rs232NetEvent              final : public SimpleEvent {};
+/** Sent by the GdbServer thread when it received packets from the client. */
+class GdbPacketEvent             final : public SimpleEvent {};
 
 
 // --- Put all (non-abstract) Event classes into a std::variant ---
@@ -490,11 +492,10 @@ using EventVariant = std::variant<
 	MachineActivatedEvent,
 	MachineDeactivatedEvent,
 	ExposeEvent,
-	MidiInReaderEvent,
-	MidiInWindowsEvent,
-	MidiInCoreMidiEvent,
-	MidiInCoreMidiVirtualEvent,
-	Rs232TesterEvent
+	MidiInEvent,
+	Rs232TesterEvent,
+	Rs232NetEvent,
+	GdbPacketEvent
 >;
 
 template<typename T>
@@ -534,11 +535,10 @@ enum class EventType : uint8_t
 	MACHINE_ACTIVATED        = event_index<MachineActivatedEvent>,
 	MACHINE_DEACTIVATED      = event_index<MachineDeactivatedEvent>,
 	EXPOSE                   = event_index<ExposeEvent>,
-	MIDI_IN_READER           = event_index<MidiInReaderEvent>,
-	MIDI_IN_WINDOWS          = event_index<MidiInWindowsEvent>,
-	MIDI_IN_COREMIDI         = event_index<MidiInCoreMidiEvent>,
-	MIDI_IN_COREMIDI_VIRTUAL = event_index<MidiInCoreMidiVirtualEvent>,
+	MIDI_IN                  = event_index<MidiInEvent>,
 	RS232_TESTER             = event_index<Rs232TesterEvent>,
+	RS232_NET                = event_index<Rs232NetEvent>,
+	GDB_PACKET               = event_index<GdbPacketEvent>,
 
 	NUM_EVENT_TYPES // must be last
 };
@@ -7,6 +7,7 @@
 #include "Thread.hh"
 #include "ranges.hh"
 #include "stl.hh"
+#include <algorithm>
 #include <cassert>
 #include <chrono>
 
@@ -48,15 +49,29 @@ void EventDistributor::distributeEvent(Event&& event)
 	assert(event);
 	std::unique_lock<std::mutex> lock(mutex);
 	if (!listeners[size_t(getType(event))].empty()) {
+		// deliverEvents() always delivers all queued events. So only
+		// the first event after the queue was emptied has to wake up
+		// the main thread, the following ones (e.g. a burst of MIDI
+		// input or CliComm commands) are simply appended.
+		bool wakeUp = scheduledEvents.empty();
 		scheduledEvents.push_back(std::move(event));
 		// must release lock, otherwise there's a deadlock:
 		//   thread 1: Reactor::deleteMotherBoard()
 		//             EventDistributor::unregisterEventListener()
 		//   thread 2: EventDistributor::distributeEvent()
 		//             Reactor::enterMainLoop()
-		condition.notify_all();
 		lock.unlock();
-		reactor.enterMainLoop();
+		if (wakeUp) {
+			bool wakeUpIdle = false;
+			{
+				std::lock_guard<std::mutex> cvLock(cvMutex);
+				wakeUpPending = true;
+				wakeUpIdle = idleWaiting;
+			}
+			condition.notify_all();
+			if (wakeUpIdle) InputEventGenerator::wakeUp();
+			reactor.enterMainLoop();
+		}
 	}
 }
 
@@ -114,7 +129,32 @@ bool EventDistributor::sleep(unsigned us)
 {
 	std::chrono::microseconds duration(us);
 	std::unique_lock<std::mutex> lock(cvMutex);
-	return condition.wait_for(lock, duration) == std::cv_status::timeout;
+	// Check the flag (instead of only waiting for a notification), a
+	// wake-up that was sent before we started waiting is not lost.
+	bool woken = condition.wait_for(lock, duration, [&] { return wakeUpPending; });
+	wakeUpPending = false;
+	return !woken;
+}
+
+void EventDistributor::idleSleep(unsigned us)
+{
+	if (!InputEventGenerator::canWaitEvent()) {
+		// Still have to poll for host events.
+		sleep(std::min(us, POLL_INTERVAL));
+		return;
+	}
+	{
+		std::lock_guard<std::mutex> lock(cvMutex);
+		if (wakeUpPending) {
+			wakeUpPending = false;
+			return;
+		}
+		idleWaiting = true;
+	}
+	InputEventGenerator::waitEvent(int((us + 999) / 1000));
+	std::lock_guard<std::mutex> lock(cvMutex);
+	idleWaiting = false;
+	wakeUpPending = false;
 }
 
 } // namespace openmsx
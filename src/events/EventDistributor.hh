@@ -56,6 +56,9 @@ public:
 	  */
 	void deliverEvents();
 
+	/** When we have to poll for host events, do this every so many us. */
+	static constexpr unsigned POLL_INTERVAL = 20 * 1000;
+
 	/** Sleep for the specified amount of time, but return early when
 	  * (another thread) called the distributeEvent() method.
 	  * @param us Amount of time to sleep, in micro seconds.
@@ -64,6 +67,12 @@ public:
 	  */
 	bool sleep(unsigned us);
 
+	/** Like sleep(), but also return early when a host (SDL) event
+	  * arrives. So when openMSX is idle (e.g. paused) we can sleep for a
+	  * long time, instead of waking up periodically to poll for host
+	  * events. */
+	void idleSleep(unsigned us);
+
 private:
 	[[nodiscard]] bool isRegistered(EventType type, EventListener* listener) const;
 
@@ -79,8 +88,10 @@ private:
 	using EventQueue = std::vector<Event>;
 	EventQueue scheduledEvents;
 	std::mutex mutex; // lock datastructures
-	std::mutex cvMutex; // lock condition_variable
+	std::mutex cvMutex; // lock condition_variable, wakeUpPending and idleWaiting
 	std::condition_variable condition;
+	bool wakeUpPending = false;
+	bool idleWaiting = false; // main thread is in idleSleep()
 };
 
 } // namespace openmsx
@@ -2,7 +2,9 @@
 #include "CliListener.hh"
 #include "CliConnection.hh"
 #include "Thread.hh"
+#include "Timer.hh"
 #include "ScopedAssign.hh"
+#include "ranges.hh"
 #include "stl.hh"
 #include <cassert>
 #include <iostream>
@@ -51,6 +53,40 @@ void GlobalCliComm::setAllowExternalCommands()
 	}
 }
 
+bool GlobalCliComm::executeCommands(uint64_t budget)
+{
+	assert(Thread::isMainThread());
+	// Don't hold the lock while executing, the commands may log messages.
+	// Connections are only removed on shutdown.
+	std::vector<CliConnection*> connections;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		for (auto& listener : listeners) {
+			if (auto* conn = dynamic_cast<CliConnection*>(listener.get());
+			    conn && conn->numPendingCommands()) {
+				connections.push_back(conn);
+			}
+		}
+	}
+	if (connections.empty()) return false;
+
+	auto start = Timer::getTime();
+	for (auto* conn : connections) {
+		conn->executePendingCommand();
+	}
+	bool pending = true;
+	while (pending && ((Timer::getTime() - start) < budget)) {
+		pending = false;
+		for (auto* conn : connections) {
+			if (conn->numPendingCommands()) {
+				conn->executePendingCommand();
+				pending = true;
+			}
+		}
+	}
+	return ranges::any_of(connections, [](auto* c) { return c->numPendingCommands() != 0; });
+}
+
 void GlobalCliComm::log(LogLevel level, std::string_view message)
 {
 	assert(Thread::isMainThread());
@@ -4,6 +4,7 @@
 #include "CliComm.hh"
 #include "hash_map.hh"
 #include "xxhash.hh"
+#include <cstdint>
 #include <memory>
 #include <mutex>
 #include <vector>
@@ -28,6 +29,16 @@ public:
 	// connections are not yet processed (but they keep pending).
 	void setAllowExternalCommands();
 
+	/** Execute the commands that were received over the external
+	  * connections. First each connection executes its oldest command:
+	  * an interactive client (that waits for the reply before it sends
+	  * the next command) is never delayed by another client. Then the
+	  * remaining (bulk) commands are executed round-robin, but only for at
+	  * most 'budget' microseconds, the rest is kept for the next call.
+	  * Returns true when there are still commands pending.
+	  * Main thread only. */
+	bool executeCommands(uint64_t budget);
+
 	// CliComm
 	void log(LogLevel level, std::string_view message) override;
 	void update(UpdateType type, std::string_view name,
@@ -5,6 +5,7 @@
 #include "EventDistributor.hh"
 #include "CliComm.hh"
 #include "Event.hh"
+#include "ScriptProfiler.hh"
 #include "TclArgParser.hh"
 #include "TclObject.hh"
 #include "SettingsConfig.hh"
@@ -387,6 +388,8 @@ void HotKey::executeBinding(const Event& event, const HotKeyInfo& info)
 		// event. The Tcl script bound to that event closes the main
 		// menu and reopens a new quit_menu. This will re-bind the
 		// action for the 'OSDControl A PRESS' event.
+		// (Copying the TclObject only shares the underlying Tcl_Obj, so
+		// the compiled form of the command is still reused.)
 		TclObject command(info.command);
 		if (info.passEvent) {
 			// Add event as the last argument to the command.
@@ -397,7 +400,9 @@ void HotKey::executeBinding(const Event& event, const HotKeyInfo& info)
 		}
 
 		// ignore return value
-		command.executeCommand(commandController.getInterpreter());
+		auto& interp = commandController.getInterpreter();
+		ScriptProfiler::Scope scope(interp.getProfiler(), "bind", command.getString());
+		command.executeCommand(interp, true);
 	} catch (CommandException& e) {
 		commandController.getCliComm().printWarning(
 			"Error executing hot key command: ", e.getMessage());
@@ -447,7 +452,7 @@ HotKey::BindCmd::BindCmd(CommandController& commandController_, HotKey& hotKey_,
 static string formatBinding(const HotKey::HotKeyInfo& info)
 {
 	return strCat(toString(info.event), (info.repeat ? " [repeat]" : ""),
-	              (info.passEvent ? " [event]" : ""), ":  ", info.command, '\n');
+	              (info.passEvent ? " [event]" : ""), ":  ", info.command.getString(), '\n');
 }
 
 void HotKey::BindCmd::execute(span<const TclObject> tokens, TclObject& result)
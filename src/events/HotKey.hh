@@ -23,11 +23,11 @@ public:
 	struct HotKeyInfo {
 		HotKeyInfo(const Event& event_, std::string command_,
 		           bool repeat_ = false, bool passEvent_ = false)
-			: event(event_), command(std::move(command_))
+			: event(event_), command(command_)
 			, repeat(repeat_)
 			, passEvent(passEvent_) {}
 		Event event;
-		std::string command;
+		TclObject command; // keeps the compiled bytecode between executions
 		bool repeat;
 		bool passEvent; // whether to pass event with args back to command
 	};
@@ -58,7 +58,7 @@ public:
 			if (info.passEvent) {
 				xml.attribute("event", "true");
 			}
-			xml.data(info.command);
+			xml.data(info.command.getString());
 			xml.end("bind");
 		}
 		// add explicit unbinds
@@ -53,6 +53,36 @@ void InputEventGenerator::wait()
 	}
 }
 
+bool InputEventGenerator::canWaitEvent()
+{
+	// Before SDL 2.0.16 SDL_WaitEventTimeout() was implemented as a
+	// poll/sleep(1ms) loop, that's worse than our own poll loop. Newer
+	// versions really block, though they still fall back to polling
+	// without video subsystem or when joysticks need to be polled.
+#if SDL_VERSION_ATLEAST(2, 0, 16)
+	static const bool versionOk = [] {
+		SDL_version v;
+		SDL_GetVersion(&v);
+		return SDL_VERSIONNUM(v.major, v.minor, v.patch) >= SDL_VERSIONNUM(2, 0, 16);
+	}();
+	return versionOk && SDL_WasInit(SDL_INIT_VIDEO) && (SDL_NumJoysticks() == 0);
+#else
+	return false;
+#endif
+}
+
+void InputEventGenerator::waitEvent(int ms)
+{
+	SDL_WaitEventTimeout(nullptr, ms);
+}
+
+void InputEventGenerator::wakeUp()
+{
+	SDL_Event evt = {};
+	evt.type = SDL_USEREVENT; // ignored in handle()
+	SDL_PushEvent(&evt);
+}
+
 void InputEventGenerator::poll()
 {
 	// Heuristic to emulate the old SDL1 behavior:
@@ -381,6 +411,16 @@ void InputEventGenerator::handle(const SDL_Event& evt)
 		case SDL_WINDOWEVENT_EXPOSED:
 			event = Event::create<ExposeEvent>();
 			break;
+		case SDL_WINDOWEVENT_HIDDEN:
+		case SDL_WINDOWEVENT_MINIMIZED:
+			windowHidden = true;
+			break;
+		case SDL_WINDOWEVENT_SHOWN:
+		case SDL_WINDOWEVENT_RESTORED:
+		case SDL_WINDOWEVENT_MAXIMIZED:
+			windowHidden = false;
+			event = Event::create<ExposeEvent>();
+			break;
 		default:
 			break;
 		}
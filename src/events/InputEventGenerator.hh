@@ -43,6 +43,18 @@ public:
 
 	void poll();
 
+	/** Is the window hidden or minimized? Then there's no need to paint. */
+	[[nodiscard]] bool isWindowHidden() const { return windowHidden; }
+
+	/** Can waitEvent() block till an event arrives without polling? */
+	[[nodiscard]] static bool canWaitEvent();
+	/** Wait (at most 'ms' milliseconds) till a host event is available,
+	  * the event is not removed from the SDL queue. */
+	static void waitEvent(int ms);
+	/** Make a concurrent waitEvent() return, can be called from any
+	  * thread. */
+	static void wakeUp();
+
 private:
 	void handle(const SDL_Event& evt);
 	void handleKeyDown(const SDL_KeyboardEvent& key, uint32_t unicode);
@@ -84,6 +96,7 @@ private:
 
 
 	unsigned osdControlButtonsState; // 0 is pressed, 1 is released
+	bool windowHidden = false;
 
 	// only for Android
 	static inline bool androidButtonA = false;
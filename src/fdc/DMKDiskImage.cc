@@ -86,6 +86,10 @@ void DMKDiskImage::readTrack(byte track, byte side, RawTrack& output)
 	// Read raw track data.
 	file->read(output.getRawBuffer(), dmkTrackLen);
 
+	// Read ahead the next two tracks in the file (the other side and/or
+	// the next cylinder), that's where the head most likely goes next.
+	file->prefetch(file->getPos(), 2 * (dmkTrackLen + 128));
+
 	// Convert idam data into an easier to work with internal format.
 	int lastIdam = -1;
 	for (auto i : xrange(64)) {
@@ -24,6 +24,12 @@ void DSKDiskImage::readSectorsImpl(
 {
 	file->seek(startSector * sizeof(SectorBuffer));
 	file->read(buffers, num * sizeof(SectorBuffer));
+
+	// The next read is most likely for the following sector(s) on the same
+	// or the next track. (Small images are already completely pre-cached,
+	// see File::PRE_CACHE, then this does nothing).
+	file->prefetch((startSector + num) * sizeof(SectorBuffer),
+	               READAHEAD_SECTORS * sizeof(SectorBuffer));
 }
 
 void DSKDiskImage::writeSectorImpl(size_t sector, const SectorBuffer& buf)
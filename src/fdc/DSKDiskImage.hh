@@ -23,6 +23,7 @@ private:
 
 private:
 	const std::shared_ptr<File> file;
+	static constexpr size_t READAHEAD_SECTORS = 18; // 1 cylinder of a 720kB disk
 };
 
 } // namespace openmsx
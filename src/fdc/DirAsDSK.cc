@@ -207,23 +207,6 @@ bool DirAsDSK::checkMSXFileExists(
 
 // Returns msx directory entry for the given host file. Or -1 if the host file
 // is not mapped in the virtual disk.
-DirAsDSK::DirIndex DirAsDSK::findHostFileInDSK(std::string_view hostName)
-{
-	for (const auto& [dirIdx, mapDir] : mapDirs) {
-		if (mapDir.hostName == hostName) {
-			return dirIdx;
-		}
-	}
-	return {unsigned(-1), unsigned(-1)};
-}
-
-// Check if a host file is already mapped in the virtual disk.
-bool DirAsDSK::checkFileUsedInDSK(std::string_view hostName)
-{
-	DirIndex dirIndex = findHostFileInDSK(hostName);
-	return dirIndex.sector != unsigned(-1);
-}
-
 static string hostToMsxName(string hostName)
 {
 	// Create an MSX filename 8.3 format. TODO use vfat-like abbreviation
@@ -383,22 +366,34 @@ void DirAsDSK::readSectorImpl(size_t sector, SectorBuffer& buf)
 
 void DirAsDSK::syncWithHost()
 {
+	// Each mapped host file is only stat-ed once per sync:
+	// checkDeletedHostFiles() collects the results for the files that
+	// still exist, checkModifiedHostFiles() reuses them and
+	// addNewHostFiles() skips files that are already mapped.
+	HostStats hostStats;
+	hostStats.reserve(mapDirs.size());
+
 	// Check for removed host files. This frees up space in the virtual
 	// disk. Do this first because otherwise later actions may fail (run
 	// out of virtual disk space) for no good reason.
-	checkDeletedHostFiles();
+	checkDeletedHostFiles(hostStats);
 
 	// Next update existing files. This may enlarge or shrink virtual
 	// files. In case not all host files fit on the virtual disk it's
 	// better to update the existing files than to (partly) add a too big
 	// new file and have no space left to enlarge the existing files.
-	checkModifiedHostFiles();
+	checkModifiedHostFiles(hostStats);
 
 	// Last add new host files (this can only consume virtual disk space).
-	addNewHostFiles({}, firstDirSector);
+	HostNameIndex mapped;
+	mapped.reserve(mapDirs.size());
+	for (const auto& [dirIdx, mapDir] : mapDirs) {
+		mapped.emplace(mapDir.hostName, dirIdx);
+	}
+	addNewHostFiles({}, firstDirSector, mapped);
 }
 
-void DirAsDSK::checkDeletedHostFiles()
+void DirAsDSK::checkDeletedHostFiles(HostStats& hostStats)
 {
 	// This handles both host files and directories.
 	auto copy = mapDirs;
@@ -427,6 +422,8 @@ void DirAsDSK::checkDeletedHostFiles()
 			// name has been created). In both cases delete the msx
 			// entry (if needed it will be recreated soon).
 			deleteMSXFile(dirIdx);
+		} else {
+			hostStats.emplace_back(dirIdx, fst);
 		}
 	}
 }
@@ -494,20 +491,20 @@ void DirAsDSK::freeFATChain(unsigned cluster)
 	}
 }
 
-void DirAsDSK::checkModifiedHostFiles()
+void DirAsDSK::checkModifiedHostFiles(HostStats& hostStats)
 {
-	auto copy = mapDirs;
-	for (const auto& [dirIdx, mapDir] : copy) {
-		if (!mapDirs.contains(dirIdx)) {
+	// 'hostStats' contains the files that passed the checks in
+	// checkDeletedHostFiles() (they exist and have the same type on the
+	// host and msx side).
+	for (auto& [dirIdx, fst] : hostStats) {
+		const auto* mapDir = lookup(mapDirs, dirIdx);
+		if (!mapDir) {
 			// See comment in checkDeletedHostFiles().
 			continue;
 		}
-		auto fullHostName = tmpStrCat(hostDir, mapDir.hostName);
 		bool isMSXDirectory = (msxDir(dirIdx).attrib &
 		                       MSXDirEntry::ATT_DIRECTORY) != 0;
-		FileOperations::Stat fst;
-		if (FileOperations::getStat(fullHostName, fst) &&
-		    (FileOperations::isDirectory(fst) == isMSXDirectory)) {
+		{
 			// Detect changes in host file.
 			// Heuristic: we use filesize and modification time to detect
 			// changes in file content.
@@ -518,14 +515,10 @@ void DirAsDSK::checkModifiedHostFiles()
 			// in that directory is changed/added/removed. But such
 			// changes are handled elsewhere.
 			if (!isMSXDirectory &&
-			    ((mapDir.mtime    != fst.st_mtime) ||
-			     (mapDir.filesize != size_t(fst.st_size)))) {
+			    ((mapDir->mtime    != fst.st_mtime) ||
+			     (mapDir->filesize != size_t(fst.st_size)))) {
 				importHostFile(dirIdx, fst);
 			}
-		} else {
-			// Only very rarely happens (because checkDeletedHostFiles()
-			// checked this just recently).
-			deleteMSXFile(dirIdx);
 		}
 	}
 }
@@ -685,7 +678,8 @@ static size_t weight(const string& hostName)
 	return result;
 }
 
-void DirAsDSK::addNewHostFiles(const string& hostSubDir, unsigned msxDirSector)
+void DirAsDSK::addNewHostFiles(const string& hostSubDir, unsigned msxDirSector,
+                               const HostNameIndex& mapped)
 {
 	assert(!StringOp::startsWith(hostSubDir, '/'));
 	assert(hostSubDir.empty() || StringOp::endsWith(hostSubDir, '/'));
@@ -706,13 +700,22 @@ void DirAsDSK::addNewHostFiles(const string& hostSubDir, unsigned msxDirSector)
 				// also skip hidden files on unix
 				continue;
 			}
+			if (const auto* dirIndex = lookup(mapped, tmpStrCat(hostSubDir, hostName))) {
+				// Already present in the virtual disk. Changes in
+				// existing files are handled by checkModifiedHostFiles(),
+				// only directories must be processed (recursively).
+				if (msxDir(*dirIndex).attrib & MSXDirEntry::ATT_DIRECTORY) {
+					addExistingDirectory(hostSubDir, hostName, *dirIndex, mapped);
+				}
+				continue;
+			}
 			auto fullHostName = tmpStrCat(hostDir, hostSubDir, hostName);
 			FileOperations::Stat fst;
 			if (!FileOperations::getStat(fullHostName, fst)) {
 				throw MSXException("Error accessing ", fullHostName);
 			}
 			if (FileOperations::isDirectory(fst)) {
-				addNewDirectory(hostSubDir, hostName, msxDirSector, fst);
+				addNewDirectory(hostSubDir, hostName, msxDirSector, fst, mapped);
 			} else if (FileOperations::isRegularFile(fst)) {
 				addNewHostFile(hostSubDir, hostName, msxDirSector, fst);
 			} else {
@@ -725,74 +728,67 @@ void DirAsDSK::addNewHostFiles(const string& hostSubDir, unsigned msxDirSector)
 }
 
 void DirAsDSK::addNewDirectory(const string& hostSubDir, const string& hostName,
-                               unsigned msxDirSector, FileOperations::Stat& fst)
+                               unsigned msxDirSector, FileOperations::Stat& fst,
+                               const HostNameIndex& mapped)
 {
-	DirIndex dirIndex = findHostFileInDSK(tmpStrCat(hostSubDir, hostName));
-	unsigned newMsxDirSector;
-	if (dirIndex.sector == unsigned(-1)) {
-		// MSX directory doesn't exist yet, create it.
-		// Allocate a cluster to hold the subdirectory entries.
-		unsigned cluster = getFreeCluster();
-		writeFAT12(cluster, EOF_FAT);
-
-		// Allocate and fill in directory entry.
-		try {
-			dirIndex = fillMSXDirEntry(hostSubDir, hostName, msxDirSector);
-		} catch (...) {
-			// Rollback allocation of directory cluster.
-			writeFAT12(cluster, FREE_FAT);
-			throw;
-		}
-		setMSXTimeStamp(dirIndex, fst);
-		msxDir(dirIndex).attrib = MSXDirEntry::ATT_DIRECTORY;
-		msxDir(dirIndex).startCluster = cluster;
-
-		// Initialize the new directory.
-		newMsxDirSector = clusterToSector(cluster);
-		for (auto i : xrange(SECTORS_PER_CLUSTER)) {
-			memset(&sectors[newMsxDirSector + i], 0, SECTOR_SIZE);
-		}
-		DirIndex idx0(newMsxDirSector, 0); // entry for "."
-		DirIndex idx1(newMsxDirSector, 1); //           ".."
-		memset(msxDir(idx0).filename, ' ', 11);
-		memset(msxDir(idx1).filename, ' ', 11);
-		memset(msxDir(idx0).filename, '.', 1);
-		memset(msxDir(idx1).filename, '.', 2);
-		msxDir(idx0).attrib = MSXDirEntry::ATT_DIRECTORY;
-		msxDir(idx1).attrib = MSXDirEntry::ATT_DIRECTORY;
-		setMSXTimeStamp(idx0, fst);
-		setMSXTimeStamp(idx1, fst);
-		msxDir(idx0).startCluster = cluster;
-		msxDir(idx1).startCluster = msxDirSector == firstDirSector
-		                          ? 0 : sectorToCluster(msxDirSector);
-	} else {
-		if (!(msxDir(dirIndex).attrib & MSXDirEntry::ATT_DIRECTORY)) {
-			// Should rarely happen because checkDeletedHostFiles()
-			// recently checked this. (It could happen when a host
-			// directory is *just*recently* created with the same
-			// name as an existing msx file). Ignore, it will be
-			// corrected in the next sync.
-			return;
-		}
-		unsigned cluster = msxDir(dirIndex).startCluster;
-		if ((cluster < FIRST_CLUSTER) || (cluster >= maxCluster)) {
-			// Sanity check on cluster range.
-			return;
-		}
-		newMsxDirSector = clusterToSector(cluster);
+	// MSX directory doesn't exist yet, create it.
+	// Allocate a cluster to hold the subdirectory entries.
+	unsigned cluster = getFreeCluster();
+	writeFAT12(cluster, EOF_FAT);
+
+	// Allocate and fill in directory entry.
+	DirIndex dirIndex;
+	try {
+		dirIndex = fillMSXDirEntry(hostSubDir, hostName, msxDirSector);
+	} catch (...) {
+		// Rollback allocation of directory cluster.
+		writeFAT12(cluster, FREE_FAT);
+		throw;
 	}
+	setMSXTimeStamp(dirIndex, fst);
+	msxDir(dirIndex).attrib = MSXDirEntry::ATT_DIRECTORY;
+	msxDir(dirIndex).startCluster = cluster;
+
+	// Initialize the new directory.
+	unsigned newMsxDirSector = clusterToSector(cluster);
+	for (auto i : xrange(SECTORS_PER_CLUSTER)) {
+		memset(&sectors[newMsxDirSector + i], 0, SECTOR_SIZE);
+	}
+	DirIndex idx0(newMsxDirSector, 0); // entry for "."
+	DirIndex idx1(newMsxDirSector, 1); //           ".."
+	memset(msxDir(idx0).filename, ' ', 11);
+	memset(msxDir(idx1).filename, ' ', 11);
+	memset(msxDir(idx0).filename, '.', 1);
+	memset(msxDir(idx1).filename, '.', 2);
+	msxDir(idx0).attrib = MSXDirEntry::ATT_DIRECTORY;
+	msxDir(idx1).attrib = MSXDirEntry::ATT_DIRECTORY;
+	setMSXTimeStamp(idx0, fst);
+	setMSXTimeStamp(idx1, fst);
+	msxDir(idx0).startCluster = cluster;
+	msxDir(idx1).startCluster = msxDirSector == firstDirSector
+	                          ? 0 : sectorToCluster(msxDirSector);
 
 	// Recursively process this directory.
-	addNewHostFiles(strCat(hostSubDir, hostName, '/'), newMsxDirSector);
+	addNewHostFiles(strCat(hostSubDir, hostName, '/'), newMsxDirSector, mapped);
 }
 
-void DirAsDSK::addNewHostFile(const string& hostSubDir, const string& hostName,
-                              unsigned msxDirSector, FileOperations::Stat& fst)
+void DirAsDSK::addExistingDirectory(const string& hostSubDir, const string& hostName,
+                                    DirIndex dirIndex, const HostNameIndex& mapped)
 {
-	if (checkFileUsedInDSK(tmpStrCat(hostSubDir, hostName))) {
-		// File is already present in the virtual disk, do nothing.
+	unsigned cluster = msxDir(dirIndex).startCluster;
+	if ((cluster < FIRST_CLUSTER) || (cluster >= maxCluster)) {
+		// Sanity check on cluster range.
 		return;
 	}
+
+	// Recursively process this directory.
+	addNewHostFiles(strCat(hostSubDir, hostName, '/'), clusterToSector(cluster), mapped);
+}
+
+void DirAsDSK::addNewHostFile(const string& hostSubDir, const string& hostName,
+                              unsigned msxDirSector, FileOperations::Stat& fst)
+{
+	// Caller already checked the file isn't present in the virtual disk.
 	// TODO check for available free space on disk instead of max free space
 	int diskSpace = (nofSectors - firstDataSector) * SECTOR_SIZE;
 	if (fst.st_size > diskSpace) {
@@ -6,7 +6,9 @@
 #include "FileOperations.hh"
 #include "EmuTime.hh"
 #include "hash_map.hh"
+#include "xxhash.hh"
 #include <utility>
+#include <vector>
 
 namespace openmsx {
 
@@ -60,6 +62,11 @@ private:
 		                 // truncated.
 	};
 
+	// Host file info, obtained during a host->virtual-disk sync.
+	using HostStats = std::vector<std::pair<DirIndex, FileOperations::Stat>>;
+	// Map host name (relative to 'hostDir') to directory entry.
+	using HostNameIndex = hash_map<std::string, DirIndex, XXHasher>;
+
 	[[nodiscard]] SectorBuffer* fat();
 	[[nodiscard]] SectorBuffer* fat2();
 	[[nodiscard]] MSXDirEntry& msxDir(DirIndex dirIndex);
@@ -70,25 +77,27 @@ private:
 	void writeDIREntry(DirIndex dirIndex, DirIndex dirDirIndex,
 	                   const MSXDirEntry& newEntry);
 	void syncWithHost();
-	void checkDeletedHostFiles();
+	void checkDeletedHostFiles(HostStats& hostStats);
 	void deleteMSXFile(DirIndex dirIndex);
 	void deleteMSXFilesInDir(unsigned msxDirSector);
 	void freeFATChain(unsigned cluster);
-	void addNewHostFiles(const std::string& hostSubDir, unsigned msxDirSector);
+	void addNewHostFiles(const std::string& hostSubDir, unsigned msxDirSector,
+	                     const HostNameIndex& mapped);
 	void addNewDirectory(const std::string& hostSubDir, const std::string& hostName,
-	                     unsigned msxDirSector, FileOperations::Stat& fst);
+	                     unsigned msxDirSector, FileOperations::Stat& fst,
+	                     const HostNameIndex& mapped);
+	void addExistingDirectory(const std::string& hostSubDir, const std::string& hostName,
+	                          DirIndex dirIndex, const HostNameIndex& mapped);
 	void addNewHostFile(const std::string& hostSubDir, const std::string& hostName,
 	                    unsigned msxDirSector, FileOperations::Stat& fst);
 	[[nodiscard]] DirIndex fillMSXDirEntry(
 		const std::string& hostSubDir, const std::string& hostName,
 		unsigned msxDirSector);
 	[[nodiscard]] DirIndex getFreeDirEntry(unsigned msxDirSector);
-	[[nodiscard]] DirIndex findHostFileInDSK(std::string_view hostName);
-	[[nodiscard]] bool checkFileUsedInDSK(std::string_view hostName);
 	[[nodiscard]] unsigned nextMsxDirSector(unsigned sector);
 	[[nodiscard]] bool checkMSXFileExists(const std::string& msxfilename,
 	                                      unsigned msxDirSector);
-	void checkModifiedHostFiles();
+	void checkModifiedHostFiles(HostStats& hostStats);
 	void setMSXTimeStamp(DirIndex dirIndex, FileOperations::Stat& fst);
 	void importHostFile(DirIndex dirIndex, FileOperations::Stat& fst);
 	void exportToHost(DirIndex dirIndex, DirIndex dirDirIndex);
@@ -3,6 +3,7 @@
 #include "DummyDisk.hh"
 #include "RamDSKDiskImage.hh"
 #include "DirAsDSK.hh"
+#include "SectorBasedDisk.hh"
 #include "CommandController.hh"
 #include "StateChangeDistributor.hh"
 #include "Scheduler.hh"
@@ -161,8 +162,18 @@ void DiskChanger::insertDisk(span<const TclObject> args)
 	auto& diskFactory = reactor.getDiskFactory();
 	std::unique_ptr<Disk> newDisk(diskFactory.createDisk(diskImage, *this));
 	for (const auto& arg : view::drop(args, 2)) {
-		newDisk->applyPatch(Filename(
-			arg.getString(), userFileContext()));
+		if (arg == "-overlay") {
+			// DMK images are also accessed per track, bypassing the
+			// (sector based) overlay.
+			if (!dynamic_cast<SectorBasedDisk*>(newDisk.get())) {
+				throw MSXException(
+					"Overlay is not supported for this type of disk image.");
+			}
+			newDisk->enableOverlay();
+		} else {
+			newDisk->applyPatch(Filename(
+				arg.getString(), userFileContext()));
+		}
 	}
 
 	// no errors, only now replace original disk
@@ -210,6 +221,9 @@ void DiskCommand::execute(span<const TclObject> tokens, TclObject& result)
 		if (diskChanger.disk->isWriteProtected()) {
 			options.addListElement("readonly");
 		}
+		if (diskChanger.disk->hasOverlay()) {
+			options.addListElement("overlay");
+		}
 		if (options.getListLength(getInterpreter()) != 0) {
 			result.addListElement(options);
 		}
@@ -241,9 +255,12 @@ void DiskCommand::execute(span<const TclObject> tokens, TclObject& result)
 		}
 		try {
 			std::vector<TclObject> args = { TclObject(diskChanger.getDriveName()) };
+			bool overlay = false;
 			for (size_t i = firstFileToken; i < tokens.size(); ++i) { // 'i' changes in loop
 				std::string_view option = tokens[i].getString();
-				if (option == "-ips") {
+				if (option == "-overlay") {
+					overlay = true;
+				} else if (option == "-ips") {
 					if (++i == tokens.size()) {
 						throw MSXException(
 							"Missing argument for option \"", option, '\"');
@@ -254,6 +271,10 @@ void DiskCommand::execute(span<const TclObject> tokens, TclObject& result)
 					args.emplace_back(option);
 				}
 			}
+			if (overlay) {
+				// must come after the image name
+				args.emplace_back("-overlay");
+			}
 			diskChanger.sendChangeDiskEvent(args);
 		} catch (FileException& e) {
 			throw CommandException(std::move(e).getMessage());
@@ -271,7 +292,8 @@ string DiskCommand::help(span<const TclObject> /*tokens*/) const
 		driveName, " <filename>        : change the disk file\n",
 		driveName, "                   : show which disk image is in drive\n"
 		"The following options are supported when inserting a disk image:\n"
-		"-ips <filename> : apply the given IPS patch to the disk image");
+		"-ips <filename> : apply the given IPS patch to the disk image\n"
+		"-overlay        : write to memory instead of to the disk image");
 }
 
 void DiskCommand::tabCompletion(std::vector<string>& tokens) const
@@ -297,6 +319,7 @@ static string calcSha1(SectorAccessibleDisk* disk, FilePool& filePool)
 
 // version 1:  initial version
 // version 2:  replaced Filename with DiskName
+// version 3:  added copy-on-write overlay
 template<typename Archive>
 void DiskChanger::serialize(Archive& ar, unsigned version)
 {
@@ -320,6 +343,22 @@ void DiskChanger::serialize(Archive& ar, unsigned version)
 	}
 	ar.serialize("patches", patches);
 
+	bool overlay = false;
+	SectorOverlay overlayData;
+	if constexpr (!Archive::IS_LOADER) {
+		overlay = disk->hasOverlay();
+	}
+	if (ar.versionAtLeast(version, 3)) {
+		ar.serialize("overlay", overlay);
+		if (overlay) {
+			if constexpr (Archive::IS_LOADER) {
+				ar.serialize("overlayData", overlayData);
+			} else {
+				ar.serialize("overlayData", *disk->getOverlay());
+			}
+		}
+	}
+
 	auto& filePool = reactor.getFilePool();
 	string oldChecksum;
 	if constexpr (!Archive::IS_LOADER) {
@@ -351,6 +390,7 @@ void DiskChanger::serialize(Archive& ar, unsigned version)
 				p.updateAfterLoadState();
 				args.emplace_back(p.getResolved()); // TODO
 			}
+			if (overlay) args.emplace_back("-overlay");
 
 			try {
 				insertDisk(args);
@@ -361,6 +401,9 @@ void DiskChanger::serialize(Archive& ar, unsigned version)
 				// Alternative: Print warning and continue
 				//   without diskimage. Is this better?
 			}
+			if (auto* o = disk->getOverlay()) {
+				*o = std::move(overlayData);
+			}
 		}
 
 		string newChecksum = calcSha1(getSectorAccessibleDisk(), filePool);
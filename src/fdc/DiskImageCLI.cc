@@ -48,9 +48,17 @@ void DiskImageCLI::parse(zstring_view drive, std::string_view image,
 		throw MSXException("No disk drive ", char(::toupper(drive.back())), " present to put image '", image, "' in.");
 	}
 	TclObject command = makeTclList(drive, image);
-	while (peekArgument(cmdLine) == "-ips") {
-		cmdLine = cmdLine.subspan(1);
-		command.addListElement(getArgument("-ips", cmdLine));
+	while (true) {
+		auto arg = peekArgument(cmdLine);
+		if (arg == "-ips") {
+			cmdLine = cmdLine.subspan(1);
+			command.addListElement(getArgument("-ips", cmdLine));
+		} else if (arg == "-overlay") {
+			cmdLine = cmdLine.subspan(1);
+			command.addListElement("-overlay");
+		} else {
+			break;
+		}
 	}
 	command.executeCommand(parser.getInterpreter());
 }
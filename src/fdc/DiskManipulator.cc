@@ -11,6 +11,7 @@
 #include "FileContext.hh"
 #include "FileException.hh"
 #include "FileOperations.hh"
+#include "GzipWriter.hh"
 #include "SectorBasedDisk.hh"
 #include "StringOp.hh"
 #include "TclObject.hh"
@@ -220,7 +221,8 @@ string DiskManipulator::help(span<const TclObject> tokens) const
 	    "diskmanipulator savedsk <disk name> <dskfilename>\n"
 	    "Save the complete drive content to <dskfilename>, it is not possible to save just one\n"
 	    "partition. The main purpose of this command is to make it possible to save a 'ramdsk' into\n"
-	    "a file and to take 'live backups' of dsk-files in use.\n";
+	    "a file and to take 'live backups' of dsk-files in use.\n"
+	    "When <dskfilename> ends in '.gz' the image is written gzip compressed.\n";
 	  } else if (tokens[1] == "chdir") {
 	  helptext =
 	    "diskmanipulator chdir <disk name> <MSX directory>\n"
@@ -328,10 +330,22 @@ void DiskManipulator::savedsk(const DriveSettings& driveData,
 {
 	auto partition = getPartition(driveData);
 	SectorBuffer buf;
+	bool compress = StringOp::endsWith(filename, ".gz");
 	File file(std::move(filename), File::CREATE);
-	for (auto i : xrange(partition.getNbSectors())) {
-		partition.readSector(i, buf);
-		file.write(&buf, sizeof(buf));
+	if (compress) {
+		GzipWriter gzip([&](span<const uint8_t> data) {
+			file.write(data.data(), data.size());
+		}, 9);
+		for (auto i : xrange(partition.getNbSectors())) {
+			partition.readSector(i, buf);
+			gzip.write(&buf, sizeof(buf));
+		}
+		gzip.finish();
+	} else {
+		for (auto i : xrange(partition.getNbSectors())) {
+			partition.readSector(i, buf);
+			file.write(&buf, sizeof(buf));
+		}
 	}
 }
 
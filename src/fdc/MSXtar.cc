@@ -147,6 +147,7 @@ MSXtar::MSXtar(SectorAccessibleDisk& sectordisk)
 	}
 
 	// cache complete FAT
+	freeClusterHint = 2;
 	fatCacheDirty = false;
 	fatBuffer.resize(sectorsPerFat);
 	disk.readSectors(&fatBuffer[0], 1, sectorsPerFat);
@@ -162,6 +163,7 @@ MSXtar::MSXtar(MSXtar&& other)
 	, rootDirStart(other.rootDirStart)
 	, rootDirLast(other.rootDirLast)
 	, chrootSector(other.chrootSector)
+	, freeClusterHint(other.freeClusterHint)
 	, fatCacheDirty(other.fatCacheDirty)
 {
 	other.fatCacheDirty = false;
@@ -171,12 +173,10 @@ MSXtar::~MSXtar()
 {
 	if (!fatCacheDirty) return;
 
-	for (auto i : xrange(sectorsPerFat)) {
-		try {
-			disk.writeSector(i + 1, fatBuffer[i]);
-		} catch (MSXException&) {
-			// nothing
-		}
+	try {
+		disk.writeSectors(&fatBuffer[0], 1, sectorsPerFat);
+	} catch (MSXException&) {
+		// nothing
 	}
 }
 
@@ -213,18 +213,25 @@ void MSXtar::writeFAT(unsigned clNr, unsigned val)
 		p[0] = val;
 		p[1] = (p[1] & 0xF0) + ((val >> 8) & 0x0F);
 	}
+	if (val == 0) {
+		freeClusterHint = std::min(freeClusterHint, clNr);
+	}
 	fatCacheDirty = true;
 }
 
 // Find the next clusternumber marked as free in the FAT
+// The search starts at 'freeClusterHint' instead of at cluster 2, so adding
+// many files doesn't rescan the (ever growing) used part of the FAT.
 // @throws When no more free clusters
 unsigned MSXtar::findFirstFreeCluster()
 {
-	for (auto cluster : xrange(2u, maxCluster)) {
+	for (auto cluster : xrange(std::max(2u, freeClusterHint), maxCluster)) {
 		if (readFAT(cluster) == 0) {
+			freeClusterHint = cluster;
 			return cluster;
 		}
 	}
+	freeClusterHint = maxCluster;
 	throw MSXException("Disk full.");
 }
 
@@ -489,6 +496,7 @@ void MSXtar::alterFileInDSK(MSXDirEntry& msxDirEntry, const string& hostName)
 
 	// open host file for reading
 	File file(hostName, "rb");
+	MemBuffer<SectorBuffer> clusterBuf(sectorsPerCluster);
 
 	// copy host file to image
 	unsigned prevCl = 0;
@@ -511,16 +519,15 @@ void MSXtar::alterFileInDSK(MSXDirEntry& msxDirEntry, const string& hostName)
 			break;
 		}
 
-		// fill cluster
+		// fill cluster, write all its sectors at once
 		unsigned logicalSector = clusterToSector(curCl);
-		for (unsigned j = 0; (j < sectorsPerCluster) && remaining; ++j) {
-			SectorBuffer buf;
-			memset(&buf, 0, sizeof(buf));
-			unsigned chunkSize = std::min(SECTOR_SIZE, remaining);
-			file.read(&buf, chunkSize);
-			writeLogicalSector(logicalSector + j, buf);
-			remaining -= chunkSize;
-		}
+		assert(logicalSector > sectorsPerFat); // not in the (cached) FAT
+		unsigned chunkSize = std::min(SECTOR_SIZE * sectorsPerCluster, remaining);
+		unsigned numSectors = (chunkSize + SECTOR_SIZE - 1) / SECTOR_SIZE;
+		memset(&clusterBuf[0], 0, numSectors * sizeof(SectorBuffer));
+		file.read(&clusterBuf[0], chunkSize);
+		disk.writeSectors(&clusterBuf[0], logicalSector, numSectors);
+		remaining -= chunkSize;
 
 		// advance to next cluster
 		prevCl = curCl;
@@ -768,16 +775,18 @@ void MSXtar::chroot(string_view newRootDir, bool createDir)
 void MSXtar::fileExtract(const string& resultFile, const MSXDirEntry& dirEntry)
 {
 	unsigned size = dirEntry.size;
-	unsigned sector = clusterToSector(getStartCluster(dirEntry));
+	unsigned cluster = getStartCluster(dirEntry);
 
+	// read (and write) a complete cluster at a time
 	File file(resultFile, "wb");
-	while (size && sector) {
-		SectorBuffer buf;
-		readLogicalSector(sector, buf);
-		unsigned savesize = std::min(size, SECTOR_SIZE);
-		file.write(&buf, savesize);
+	MemBuffer<SectorBuffer> clusterBuf(sectorsPerCluster);
+	while (size && (cluster >= 2) && (cluster != EOF_FAT)) {
+		unsigned savesize = std::min(size, SECTOR_SIZE * sectorsPerCluster);
+		unsigned numSectors = (savesize + SECTOR_SIZE - 1) / SECTOR_SIZE;
+		disk.readSectors(&clusterBuf[0], clusterToSector(cluster), numSectors);
+		file.write(&clusterBuf[0], savesize);
 		size -= savesize;
-		sector = getNextSector(sector);
+		cluster = readFAT(cluster);
 	}
 	// now change the access time
 	changeTime(resultFile, dirEntry);
@@ -75,6 +75,7 @@ private:
 	unsigned rootDirStart; // first sector from the root directory
 	unsigned rootDirLast;  // last  sector from the root directory
 	unsigned chrootSector;
+	unsigned freeClusterHint; // all clusters below this one are in use
 
 	bool fatCacheDirty;
 };
@@ -7,7 +7,9 @@
 #include "one_of.hh"
 #include "serialize.hh"
 #include "serialize_stl.hh"
+#include "span.hh"
 #include "unreachable.hh"
+#include "view.hh"
 #include "xrange.hh"
 #include <algorithm>
 #include <cassert>
@@ -241,6 +243,13 @@ void NowindHost::send16(word value)
 	hostToMsxFifo.push_back(value >> 8);
 }
 
+template<typename Range>
+void NowindHost::sendBlock(const Range& data)
+{
+	// same as send() for each byte, but grows the fifo only once
+	hostToMsxFifo.append(data);
+}
+
 void NowindHost::purge()
 {
 	hostToMsxFifo.clear();
@@ -449,10 +458,7 @@ void NowindHost::transferSectors(unsigned transferAddress, unsigned amount)
 	send16(transferAddress);
 	send16(amount);
 
-	auto* bufferPointer = buffer[0].raw + transferred;
-	for (auto i : xrange(amount)) {
-		send(bufferPointer[i]);
-	}
+	sendBlock(span<const byte>(buffer[0].raw + transferred, amount));
 	send(0xAF);
 	send(0x07); // used for validation
 }
@@ -465,10 +471,7 @@ void NowindHost::transferSectorsBackwards(unsigned transferAddress, unsigned amo
 	send16(transferAddress + amount);
 	send(amount / 64);
 
-	auto* bufferPointer = buffer[0].raw + transferred;
-	for (int i = amount - 1; i >= 0; --i) {
-		send(bufferPointer[i]);
-	}
+	sendBlock(view::reverse(span<const byte>(buffer[0].raw + transferred, amount)));
 	send(0xAF);
 	send(0x07); // used for validation
 }
@@ -65,6 +65,7 @@ private:
 
 	void send(byte value);
 	void send16(word value);
+	template<typename Range> void sendBlock(const Range& data);
 	void sendHeader();
 	void purge();
 
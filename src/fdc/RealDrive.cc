@@ -7,12 +7,38 @@
 #include "CliComm.hh"
 #include "GlobalSettings.hh"
 #include "MSXException.hh"
+#include "StateChange.hh"
+#include "StateChangeDistributor.hh"
 #include "serialize.hh"
 #include "unreachable.hh"
 #include <memory>
 
 namespace openmsx {
 
+// Changes of the 'diskX_instant' setting influence the emulation, so they are
+// recorded like other input events.
+class DriveInstantStateChange final : public StateChange
+{
+public:
+	DriveInstantStateChange() = default; // for serialize
+	DriveInstantStateChange(EmuTime::param time_, std::string name_, bool instant_)
+		: StateChange(time_)
+		, name(std::move(name_)), instant(instant_) {}
+	[[nodiscard]] const std::string& getName() const { return name; }
+	[[nodiscard]] bool getInstant() const { return instant; }
+	template<typename Archive> void serialize(Archive& ar, unsigned /*version*/)
+	{
+		ar.template serializeBase<StateChange>(*this);
+		ar.serialize("name",    name,
+		             "instant", instant);
+	}
+
+private:
+	std::string name;
+	bool instant;
+};
+REGISTER_POLYMORPHIC_CLASS(StateChange, DriveInstantStateChange, "DriveInstantStateChange");
+
 RealDrive::RealDrive(MSXMotherBoard& motherBoard_, EmuDuration::param motorTimeout_,
                      bool signalsNeedMotorOn_, bool doubleSided,
                      DiskDrive::TrackMode trackMode_)
@@ -47,10 +73,22 @@ RealDrive::RealDrive(MSXMotherBoard& motherBoard_, EmuDuration::param motorTimeo
 	motherBoard.getMSXCliComm().update(CliComm::HARDWARE, driveName, "add");
 	changer.emplace(motherBoard, driveName, true, doubleSizedDrive,
 	                [this]() { invalidateTrack(); });
+	instantSetting.emplace(
+		motherBoard.getMSXCommandController(), tmpStrCat(driveName, "_instant"),
+		"Not accurate! Don't wait for the disk to rotate to the requested "
+		"sector. This speeds up disk loading, but may break copy "
+		"protections or programs that depend on disk timing.",
+		false, Setting::DONT_SAVE);
+
+	motherBoard.getStateChangeDistributor().registerListener(*this);
+	instantSetting->attach(*this);
 }
 
 RealDrive::~RealDrive()
 {
+	instantSetting->detach(*this);
+	motherBoard.getStateChangeDistributor().unregisterListener(*this);
+
 	try {
 		flushTrack();
 	} catch (MSXException&) {
@@ -333,6 +371,34 @@ EmuTime RealDrive::getTimeTillIndexPulse(EmuTime::param time, int count)
 	return time + dur1 + dur2;
 }
 
+void RealDrive::setInstant(EmuTime::param time)
+{
+	motherBoard.getStateChangeDistributor().distributeNew<DriveInstantStateChange>(
+		time, changer->getDriveName(), instantSetting->getBoolean());
+}
+
+void RealDrive::update(const Setting& setting) noexcept
+{
+	(void)setting;
+	assert(&setting == &*instantSetting);
+	setInstant(getCurrentTime());
+}
+
+void RealDrive::signalStateChange(const StateChange& event)
+{
+	const auto* is = dynamic_cast<const DriveInstantStateChange*>(&event);
+	if (!is) return;
+	if (is->getName() != changer->getDriveName()) return;
+
+	instant = is->getInstant();
+}
+
+void RealDrive::stopReplay(EmuTime::param time) noexcept
+{
+	// re-sync with current value of the setting
+	if (instant != instantSetting->getBoolean()) setInstant(time);
+}
+
 void RealDrive::invalidateTrack()
 {
 	try {
@@ -413,6 +479,13 @@ EmuTime RealDrive::getNextSector(EmuTime::param time, RawTrack::Sector& sector)
 	if (delta < 4) delta += TICKS_PER_ROTATION;
 	assert(4 <= delta); assert(unsigned(delta) < (TICKS_PER_ROTATION + 4));
 
+	if (instant) {
+		// Instantly rotate the disk so that the sector header is just
+		// in front of the head.
+		startAngle = (startAngle + unsigned(delta - 4)) % TICKS_PER_ROTATION;
+		delta = 4;
+	}
+
 	return time + MotorClock::duration(delta);
 }
 
@@ -458,6 +531,7 @@ void RealDrive::invalidateWd2793ReadTrackQuirk()
 // version 4: removed 'userData' from Schedulable
 // version 5: added 'track', 'trackValid', 'trackDirty'
 // version 6: removed 'headLoadStatus' and 'headLoadTimer'
+// version 7: added 'instant'
 template<typename Archive>
 void RealDrive::serialize(Archive& ar, unsigned version)
 {
@@ -483,6 +557,12 @@ void RealDrive::serialize(Archive& ar, unsigned version)
 		ar.serialize("trackValid", trackValid);
 		ar.serialize("trackDirty", trackDirty);
 	}
+	if (ar.versionAtLeast(version, 7)) {
+		ar.serialize("instant", instant);
+	} else {
+		assert(Archive::IS_LOADER);
+		instant = false;
+	}
 	if constexpr (Archive::IS_LOADER) {
 		// Right after a loadstate, the 'loading indicator' state may
 		// be wrong, but that's OK. It's anyway only a heuristic and
@@ -1,10 +1,13 @@
 #ifndef REALDRIVE_HH
 #define REALDRIVE_HH
 
+#include "BooleanSetting.hh"
 #include "DiskDrive.hh"
 #include "DiskChanger.hh"
 #include "Clock.hh"
+#include "Observer.hh"
 #include "Schedulable.hh"
+#include "StateChangeListener.hh"
 #include "ThrottleManager.hh"
 #include "outer.hh"
 #include "serialize_meta.hh"
@@ -17,7 +20,8 @@ class MSXMotherBoard;
 
 /** This class implements a real drive, single or double sided.
  */
-class RealDrive final : public DiskDrive
+class RealDrive final : public DiskDrive, private Observer<Setting>
+                      , private StateChangeListener
 {
 public:
 	RealDrive(MSXMotherBoard& motherBoard, EmuDuration::param motorTimeout,
@@ -85,6 +89,14 @@ private:
 	[[nodiscard]] std::optional<unsigned> getDiskWriteTrack() const;
 	void getTrack();
 	void invalidateTrack();
+	void setInstant(EmuTime::param time);
+
+	// Observer<Setting>
+	void update(const Setting& setting) noexcept override;
+
+	// StateChangeListener
+	void signalStateChange(const StateChange& event) override;
+	void stopReplay(EmuTime::param time) noexcept override;
 
 private:
 	static constexpr unsigned TICKS_PER_ROTATION = 200000;
@@ -97,10 +109,12 @@ private:
 	using MotorClock = Clock<TICKS_PER_ROTATION * ROTATIONS_PER_SECOND>;
 	MotorClock motorTimer;
 	std::optional<DiskChanger> changer; // delayed initialization
+	std::optional<BooleanSetting> instantSetting; // delayed initialization
 	unsigned headPos;
 	unsigned side;
 	unsigned startAngle;
 	bool motorStatus;
+	bool instant = false; // follows 'instantSetting' via state changes
 	const bool doubleSizedDrive;
 	const bool signalsNeedMotorOn;
 	const DiskDrive::TrackMode trackMode;
@@ -113,7 +127,7 @@ private:
 	bool trackValid;
 	bool trackDirty;
 };
-SERIALIZE_CLASS_VERSION(RealDrive, 6);
+SERIALIZE_CLASS_VERSION(RealDrive, 7);
 
 } // namespace openmsx
 
@@ -5,6 +5,7 @@
 #include "DiskExceptions.hh"
 #include "sha1.hh"
 #include "xrange.hh"
+#include <cstring>
 #include <memory>
 
 namespace openmsx {
@@ -41,6 +42,7 @@ void SectorAccessibleDisk::readSectors(
 	} catch (MSXException& e) {
 		throw DiskIOErrorException("Disk I/O error: ", e.getMessage());
 	}
+	if (overlay) overlay->apply(buffers, startSector, nbSectors);
 }
 
 void SectorAccessibleDisk::readSectorsImpl(
@@ -69,7 +71,7 @@ void SectorAccessibleDisk::writeSector(size_t sector, const SectorBuffer& buf)
 		throw NoSuchSectorException("No such sector");
 	}
 	try {
-		writeSectorImpl(sector, buf);
+		doWriteSector(sector, buf);
 	} catch (MSXException& e) {
 		throw DiskIOErrorException("Disk I/O error: ", e.getMessage());
 	}
@@ -79,13 +81,43 @@ void SectorAccessibleDisk::writeSector(size_t sector, const SectorBuffer& buf)
 void SectorAccessibleDisk::writeSectors(
 	const SectorBuffer* buffers, size_t startSector, size_t nbSectors)
 {
-	// Simply write one-at-a-time. There's no possibility (nor any need) yet
-	// to allow to optimize this
-	for (auto i : xrange(nbSectors)) {
-		writeSector(startSector + i, buffers[i]);
+	// Check once for the whole range and only invalidate the caches at the
+	// end: a bulk import (e.g. via MSXtar) would otherwise clear the sha1
+	// cache (and call isWriteProtected()/getNbSectors()) for every sector.
+	if (nbSectors == 0) return;
+	if (isWriteProtected()) {
+		throw WriteProtectedException();
+	}
+	if (!isDummyDisk() && (getNbSectors() < (startSector + nbSectors))) {
+		throw NoSuchSectorException("No such sector");
 	}
+	try {
+		for (auto i : xrange(nbSectors)) {
+			doWriteSector(startSector + i, buffers[i]);
+		}
+	} catch (MSXException& e) {
+		flushCaches();
+		throw DiskIOErrorException("Disk I/O error: ", e.getMessage());
+	}
+	flushCaches();
 }
 
+void SectorAccessibleDisk::doWriteSector(size_t sector, const SectorBuffer& buf)
+{
+	if (!overlay) {
+		writeSectorImpl(sector, buf);
+		return;
+	}
+	if (!overlay->contains(sector)) {
+		// Don't store sectors that are identical to the image (e.g.
+		// when the whole disk gets rewritten with the same content).
+		SectorBuffer orig;
+		patch->copyBlock(sector * sizeof(SectorBuffer), orig.raw, sizeof(orig));
+		if (memcmp(&orig, &buf, sizeof(buf)) == 0) return;
+	}
+	overlay->write(sector, buf);
+	overlayWritten(sector);
+}
 
 size_t SectorAccessibleDisk::getNbSectors() const
 {
@@ -107,6 +139,11 @@ bool SectorAccessibleDisk::hasPatches() const
 	return !patch->isEmptyPatch();
 }
 
+void SectorAccessibleDisk::enableOverlay()
+{
+	if (!overlay) overlay.emplace();
+}
+
 Sha1Sum SectorAccessibleDisk::getSha1Sum(FilePool& filePool)
 {
 	checkCaches();
@@ -143,7 +180,8 @@ Sha1Sum SectorAccessibleDisk::getSha1SumImpl(FilePool& /*filePool*/)
 
 bool SectorAccessibleDisk::isWriteProtected() const
 {
-	return forcedWriteProtect || isWriteProtectedImpl();
+	// With an overlay the image itself is never written.
+	return forcedWriteProtect || (!overlay && isWriteProtectedImpl());
 }
 
 void SectorAccessibleDisk::forceWriteProtect()
@@ -167,4 +205,9 @@ void SectorAccessibleDisk::flushCaches()
 	sha1cache.clear();
 }
 
+void SectorAccessibleDisk::overlayWritten(size_t /*sector*/)
+{
+	// nothing
+}
+
 } // namespace openmsx
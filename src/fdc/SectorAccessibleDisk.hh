@@ -3,9 +3,11 @@
 
 #include "DiskImageUtils.hh"
 #include "Filename.hh"
+#include "SectorOverlay.hh"
 #include "sha1.hh"
 #include <vector>
 #include <memory>
+#include <optional>
 
 namespace openmsx {
 
@@ -37,6 +39,18 @@ public:
 	[[nodiscard]] std::vector<Filename> getPatches() const;
 	[[nodiscard]] bool hasPatches() const;
 
+	// copy-on-write overlay stuff
+	/** From now on writes go to an in-memory overlay instead of to the
+	  * disk image. This also makes read-only images writable (unless
+	  * forceWriteProtect() was called).
+	  */
+	void enableOverlay();
+	[[nodiscard]] bool hasOverlay() const { return overlay.has_value(); }
+	/** Returns nullptr if there's no overlay. */
+	[[nodiscard]] SectorOverlay* getOverlay() {
+		return overlay ? &*overlay : nullptr;
+	}
+
 	/** Calculate SHA1 of the content of this disk.
 	 * This value is cached (and flushed on writes).
 	 */
@@ -62,14 +76,19 @@ protected:
 	virtual void checkCaches();
 	virtual void flushCaches();
 	virtual Sha1Sum getSha1SumImpl(FilePool& filepool);
+	// Called after a sector was written to the overlay (instead of
+	// writeSectorImpl()).
+	virtual void overlayWritten(size_t sector);
 
 private:
+	void doWriteSector(size_t sector, const SectorBuffer& buf);
 	virtual void writeSectorImpl(size_t sector, const SectorBuffer& buf) = 0;
 	[[nodiscard]] virtual size_t getNbSectorsImpl() const = 0;
 	[[nodiscard]] virtual bool isWriteProtectedImpl() const = 0;
 
 private:
 	std::unique_ptr<const PatchInterface> patch;
+	std::optional<SectorOverlay> overlay;
 	Sha1Sum sha1cache;
 	bool forcedWriteProtect = false;
 	bool peekMode = false;
@@ -1,6 +1,8 @@
 #include "SectorBasedDisk.hh"
 #include "MSXException.hh"
+#include "ranges.hh"
 #include "xrange.hh"
+#include <algorithm>
 #include <cassert>
 
 namespace openmsx {
@@ -8,7 +10,6 @@ namespace openmsx {
 SectorBasedDisk::SectorBasedDisk(DiskName name_)
 	: Disk(std::move(name_))
 	, nbSectors(size_t(-1)) // to detect misuse
-	, cachedTrackNum(-1)
 {
 }
 
@@ -32,21 +33,24 @@ void SectorBasedDisk::writeTrackImpl(byte track, byte side, const RawTrack& inpu
 
 void SectorBasedDisk::readTrack(byte track, byte side, RawTrack& output)
 {
-	// Try to cache the last result of this method (the cache will be
-	// flushed on any write to the disk). This very simple cache mechanism
+	// Try to cache the last few results of this method (the cache will
+	// be flushed on any write to the disk). This simple cache mechanism
 	// will typically already have a very high hit-rate. For example during
 	// emulation of a WD2793 read sector, we also emulate the search for
 	// the correct sector. So the disk rotates from sector to sector, and
 	// each time we re-read the track data (because emutime has passed).
 	// Typically the software will also read several sectors from the same
-	// track before moving to the next.
+	// track before moving to the next. Keeping more than one track helps
+	// when software alternates between both sides or between a few
+	// tracks (e.g. directory and data).
 	checkCaches();
 	int num = track | (side << 8);
-	if (num == cachedTrackNum) {
-		output = cachedTrackData;
+	auto it = ranges::find(trackCache, num, &CachedTrack::num);
+	if (it != trackCache.end()) {
+		std::rotate(trackCache.begin(), it, it + 1); // move to front
+		output = trackCache.front().data;
 		return;
 	}
-	cachedTrackNum = num;
 
 	// This disk image only stores the actual sector data, not all the
 	// extra gap, sync and header information that is in reality stored
@@ -133,15 +137,18 @@ void SectorBasedDisk::readTrack(byte track, byte side, RawTrack& output)
 		// real disk, you simply read an 'empty' track. So we do the
 		// same here.
 		output.clear(RawTrack::STANDARD_SIZE);
-		cachedTrackNum = -1; // needed?
+		return; // don't cache
 	}
-	cachedTrackData = output;
+	// replace the least recently used entry
+	std::rotate(trackCache.begin(), trackCache.end() - 1, trackCache.end());
+	trackCache.front().data = output;
+	trackCache.front().num = num;
 }
 
 void SectorBasedDisk::flushCaches()
 {
 	Disk::flushCaches();
-	cachedTrackNum = -1;
+	for (auto& c : trackCache) c.num = -1;
 }
 
 size_t SectorBasedDisk::getNbSectorsImpl() const
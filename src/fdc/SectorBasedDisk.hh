@@ -3,6 +3,7 @@
 
 #include "Disk.hh"
 #include "RawTrack.hh"
+#include <array>
 
 namespace openmsx {
 
@@ -30,8 +31,14 @@ private:
 
 private:
 	size_t nbSectors;
-	RawTrack cachedTrackData;
-	int cachedTrackNum;
+
+	// Recently synthesized tracks, most recently used first.
+	struct CachedTrack {
+		RawTrack data;
+		int num = -1; // track | (side << 8), or -1 when unused
+	};
+	static constexpr size_t TRACK_CACHE_SIZE = 4;
+	std::array<CachedTrack, TRACK_CACHE_SIZE> trackCache;
 };
 
 } // namespace openmsx
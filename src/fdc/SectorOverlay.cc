@@ -0,0 +1,45 @@
+#include "SectorOverlay.hh"
+#include "serialize.hh"
+#include "serialize_stl.hh"
+#include "xrange.hh"
+
+namespace openmsx {
+
+void SectorOverlay::apply(
+	SectorBuffer* buffers, size_t startSector, size_t nbSectors) const
+{
+	for (auto it = index.lower_bound(startSector);
+	     (it != index.end()) && (it->first < (startSector + nbSectors)); ++it) {
+		buffers[it->first - startSector] = data[it->second];
+	}
+}
+
+void SectorOverlay::write(size_t sector, const SectorBuffer& buf)
+{
+	auto [it, inserted] = index.try_emplace(sector, data.size());
+	if (inserted) {
+		sectors.push_back(sector);
+		data.push_back(buf);
+	} else {
+		data[it->second] = buf;
+	}
+}
+
+template<typename Archive>
+void SectorOverlay::serialize(Archive& ar, unsigned /*version*/)
+{
+	ar.serialize("sectors", sectors);
+	if constexpr (Archive::IS_LOADER) {
+		data.resize(sectors.size());
+		index.clear();
+		for (auto i : xrange(sectors.size())) {
+			index[sectors[i]] = i;
+		}
+	}
+	if (!data.empty()) {
+		ar.serialize_blob("data", data.data(), data.size() * sizeof(SectorBuffer));
+	}
+}
+INSTANTIATE_SERIALIZE_METHODS(SectorOverlay);
+
+} // namespace openmsx
@@ -0,0 +1,51 @@
+#ifndef SECTOROVERLAY_HH
+#define SECTOROVERLAY_HH
+
+#include "DiskImageUtils.hh"
+#include <cstdint>
+#include <map>
+#include <vector>
+
+namespace openmsx {
+
+/** Sparse copy-on-write layer on top of a disk image.
+  *
+  * Only the sectors that were written are stored (in memory), the image
+  * itself is never modified. This allows to write to read-only images, or to
+  * use the same image from many openMSX instances at the same time.
+  *
+  * The sector data is only appended (a sector that's written again is
+  * updated in place). Together with the delta-compression of in-memory
+  * savestates, this keeps reverse snapshots cheap: they only contain the
+  * sectors that changed since the previous snapshot.
+  */
+class SectorOverlay
+{
+public:
+	[[nodiscard]] bool empty() const { return sectors.empty(); }
+	[[nodiscard]] size_t size() const { return sectors.size(); }
+	[[nodiscard]] bool contains(size_t sector) const {
+		return index.find(sector) != index.end();
+	}
+	/** The numbers of all stored sectors (in no particular order). */
+	[[nodiscard]] const std::vector<uint64_t>& getSectors() const { return sectors; }
+
+	/** Replace the sectors in the given range that are present in the
+	  * overlay with their overlay content. */
+	void apply(SectorBuffer* buffers, size_t startSector, size_t nbSectors) const;
+
+	/** Store (or update) a sector. */
+	void write(size_t sector, const SectorBuffer& buf);
+
+	template<typename Archive>
+	void serialize(Archive& ar, unsigned version);
+
+private:
+	std::map<size_t, size_t> index; // sector number -> position in 'data'
+	std::vector<uint64_t> sectors;  // sector number of each entry in 'data'
+	std::vector<SectorBuffer> data;
+};
+
+} // namespace openmsx
+
+#endif
@@ -0,0 +1,31 @@
+#include "SectorReadAhead.hh"
+#include "SectorAccessibleDisk.hh"
+#include "MSXException.hh"
+#include <algorithm>
+
+namespace openmsx {
+
+void SectorReadAhead::read(SectorAccessibleDisk& disk, size_t sector, size_t end,
+                           SectorBuffer& buf)
+{
+	if ((sector - first) >= count) {
+		count = 0;
+		auto n = std::min<size_t>(maxSectors, (end > sector) ? (end - sector) : 1);
+		buffer.resize(maxSectors);
+		try {
+			disk.readSectors(buffer.data(), sector, n);
+			first = sector;
+			count = n;
+		} catch (MSXException&) {
+			// e.g. one bad sector, then report the error for that
+			// specific sector (below)
+		}
+	}
+	if ((sector - first) < count) {
+		buf = buffer[sector - first];
+	} else {
+		disk.readSector(sector, buf);
+	}
+}
+
+} // namespace openmsx
@@ -0,0 +1,42 @@
+#ifndef SECTORREADAHEAD_HH
+#define SECTORREADAHEAD_HH
+
+#include "DiskImageUtils.hh"
+#include <vector>
+
+namespace openmsx {
+
+class SectorAccessibleDisk;
+
+/** For devices that (mostly) read consecutive sectors, e.g. during a
+  * multi-sector read command: read a bunch of sectors with a single
+  * SectorAccessibleDisk::readSectors() call (for a HD image that's one
+  * host file access) and deliver them one by one.
+  *
+  * This is only a cache, so it must not be serialized. Call invalidate()
+  * when the device writes to the disk, or when a new command starts.
+  */
+class SectorReadAhead
+{
+public:
+	explicit SectorReadAhead(unsigned maxSectors_) : maxSectors(maxSectors_) {}
+
+	/** Read 'sector' from 'disk' into 'buf'. When it's not yet buffered,
+	  * read all sectors in [sector, end) (but at most 'maxSectors').
+	  * Throws like SectorAccessibleDisk::readSector().
+	  */
+	void read(SectorAccessibleDisk& disk, size_t sector, size_t end,
+	          SectorBuffer& buf);
+
+	void invalidate() { count = 0; }
+
+private:
+	std::vector<SectorBuffer> buffer;
+	size_t first = 0;
+	size_t count = 0; // 0 means empty
+	const unsigned maxSectors;
+};
+
+} // namespace openmsx
+
+#endif
@@ -1,17 +1,35 @@
 #include "XSADiskImage.hh"
 #include "DiskExceptions.hh"
 #include "File.hh"
+#include "MemBuffer.hh"
+#include "ranges.hh"
 #include "xrange.hh"
+#include <algorithm>
+#include <cassert>
 #include <cstring>
+#include <string>
 #include <utility>
+#include <vector>
 
 namespace openmsx {
 
+// Decompresses the XSA data on demand: only up to the last sector that was
+// requested so far. XSA is one LZ77 stream (with an adaptive huffman table
+// for the offsets), so random access isn't possible, but inserting a disk
+// (which only reads the bootsector) no longer requires decompressing the
+// whole image.
 class XSAExtractor
 {
 public:
-	explicit XSAExtractor(File& file);
-	std::pair<MemBuffer<SectorBuffer>, unsigned> extractData();
+	explicit XSAExtractor(span<const byte> input);
+
+	[[nodiscard]] unsigned getNbSectors() const { return sectors; }
+	[[nodiscard]] span<const byte> getInput() const { return input; }
+
+	/** Get the decompressed data for the given sectors, decompression
+	  * continues till (at least) the end of this range.
+	  * @throws MSXException when the XSA data is corrupt. */
+	[[nodiscard]] const SectorBuffer* getSectors(size_t startSector, size_t num);
 
 private:
 	static constexpr int MAXSTRLEN = 254;
@@ -20,7 +38,7 @@ private:
 
 	[[nodiscard]] inline byte charIn();
 	void chkHeader();
-	void unLz77();
+	void unLz77(size_t limit);
 	[[nodiscard]] unsigned rdStrLen();
 	[[nodiscard]] int rdStrPos();
 	[[nodiscard]] bool bitIn();
@@ -34,10 +52,18 @@ private:
 	};
 
 private:
+	// decompress in chunks of this many sectors
+	static constexpr size_t CHUNK_SECTORS = 16;
+
+	std::vector<byte> input;	// the compressed data
 	MemBuffer<SectorBuffer> outBuf;	// the output buffer
 	const byte* inBufPos;	// pos in input buffer
 	const byte* inBufEnd;
 	unsigned sectors;
+	size_t outIdx = 0;	// number of decompressed bytes
+	size_t remaining;	// space left in outBuf
+	bool finished = false;	// reached the end of the LZ77 stream
+	std::string error;	// non-empty after a decompression error
 
 	int updHufCnt;
 	int cpDist[TBLSIZE + 1];
@@ -56,19 +82,38 @@ private:
 
 // XSADiskImage
 
+// The same image inserted in several drives (possibly of different machines)
+// shares the (decompressed) data.
+static std::shared_ptr<XSAExtractor> getExtractor(span<const byte> input)
+{
+	static std::vector<std::weak_ptr<XSAExtractor>> extractors;
+	extractors.erase(ranges::remove_if(extractors,
+		[](auto& w) { return w.expired(); }), extractors.end());
+	for (auto& w : extractors) {
+		auto e = w.lock();
+		auto other = e->getInput();
+		if ((other.size() == input.size()) &&
+		    std::equal(other.begin(), other.end(), input.begin())) {
+			return e;
+		}
+	}
+	auto result = std::make_shared<XSAExtractor>(input);
+	extractors.push_back(result);
+	return result;
+}
+
 XSADiskImage::XSADiskImage(Filename& filename, File& file)
 	: SectorBasedDisk(filename)
+	, data(getExtractor(file.mmap()))
 {
-	XSAExtractor extractor(file);
-	auto [d, sectors] = extractor.extractData();
-	data = std::move(d);
-	setNbSectors(sectors);
+	setNbSectors(data->getNbSectors());
 }
 
 void XSADiskImage::readSectorsImpl(
 	SectorBuffer* buffers, size_t startSector, size_t num)
 {
-	memcpy(buffers, &data[startSector], num * sizeof(SectorBuffer));
+	memcpy(buffers, data->getSectors(startSector, num),
+	       num * sizeof(SectorBuffer));
 }
 
 void XSADiskImage::writeSectorImpl(size_t /*sector*/, const SectorBuffer& /*buf*/)
@@ -84,26 +129,38 @@ bool XSADiskImage::isWriteProtectedImpl() const
 
 // XSAExtractor
 
-XSAExtractor::XSAExtractor(File& file)
+XSAExtractor::XSAExtractor(span<const byte> data)
 {
-	auto mmap = file.mmap();
-	inBufPos = mmap.begin();
-	inBufEnd = mmap.end();
-
-	if ((charIn() != 'P') || (charIn() != 'C') ||
-	    (charIn() != 'K') || (charIn() != '\010')) {
+	// check the signature before copying the (possibly big) input
+	if ((data.size() < 4) || (data[0] != 'P') || (data[1] != 'C') ||
+	    (data[2] != 'K') || (data[3] != '\010')) {
 		throw MSXException("Not an XSA image");
 	}
+	input.assign(data.begin(), data.end());
+	inBufPos = input.data() + 4;
+	inBufEnd = input.data() + input.size();
 
 	chkHeader();
 	initHufInfo();	// initialize the cpDist tables
-	unLz77();
+	bitCnt = 0; // no bits read yet
 }
 
-std::pair<MemBuffer<SectorBuffer>, unsigned> XSAExtractor::extractData()
+const SectorBuffer* XSAExtractor::getSectors(size_t startSector, size_t num)
 {
-	// destroys internal outBuf, but that's ok
-	return {std::move(outBuf), sectors};
+	assert((startSector + num) <= sectors);
+	size_t end = std::min<size_t>(
+		sectors, (startSector + num + CHUNK_SECTORS - 1) & ~(CHUNK_SECTORS - 1));
+	if (!error.empty()) {
+		// the decompressor state is undefined after an error
+		throw MSXException(error);
+	}
+	try {
+		unLz77(end * sizeof(SectorBuffer));
+	} catch (MSXException& e) {
+		error = e.getMessage();
+		throw;
+	}
+	return &outBuf[startSector];
 }
 
 // Get the next character from the input buffer
@@ -125,6 +182,9 @@ void XSAExtractor::chkHeader()
 	}
 	sectors = (outBufLen + 511) / 512;
 	outBuf.resize(sectors);
+	remaining = sectors * sizeof(SectorBuffer);
+	// the part after the end of the stream (if any) reads as zeros
+	memset(outBuf.data(), 0, remaining);
 
 	// skip compressed length
 	inBufPos += 4;
@@ -134,19 +194,18 @@ void XSAExtractor::chkHeader()
 }
 
 // the actual decompression algorithm itself
-void XSAExtractor::unLz77()
+// continues till (at least) 'limit' bytes are decompressed (or the end of the
+// stream is reached)
+void XSAExtractor::unLz77(size_t limit)
 {
-	bitCnt = 0; // no bits read yet
-
-	size_t remaining = sectors * sizeof(SectorBuffer);
 	byte* out = outBuf.data()->raw;
-	size_t outIdx = 0;
-	while (true) {
+	while (!finished && (outIdx < limit)) {
 		if (bitIn()) {
 			// 1-bit
 			unsigned strLen = rdStrLen();
 			if (strLen == (MAXSTRLEN + 1)) {
-				 return;
+				finished = true;
+				return;
 			}
 			unsigned strPos = rdStrPos();
 			if ((strPos == 0) || (strPos > outIdx)) {
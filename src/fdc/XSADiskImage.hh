@@ -9,11 +9,12 @@
 #define XSADISKIMAGE_HH
 
 #include "SectorBasedDisk.hh"
-#include "MemBuffer.hh"
+#include <memory>
 
 namespace openmsx {
 
 class File;
+class XSAExtractor;
 
 class XSADiskImage final : public SectorBasedDisk
 {
@@ -27,7 +28,7 @@ private:
 	void writeSectorImpl(size_t sector, const SectorBuffer& buf) override;
 	[[nodiscard]] bool isWriteProtectedImpl() const override;
 
-	MemBuffer<SectorBuffer> data;
+	std::shared_ptr<XSAExtractor> data;
 };
 
 } // namespace openmsx
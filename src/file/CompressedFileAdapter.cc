@@ -1,8 +1,12 @@
 #include "CompressedFileAdapter.hh"
+#include "DeflateIndex.hh"
 #include "FileException.hh"
+#include "ZlibInflate.hh"
 #include "hash_set.hh"
 #include "xxhash.hh"
+#include <algorithm>
 #include <cstring>
+#include <mutex>
 
 namespace openmsx {
 
@@ -13,6 +17,12 @@ struct GetURLFromDecompressed {
 };
 static hash_set<std::unique_ptr<CompressedFileAdapter::Decompressed>,
                 GetURLFromDecompressed, XXHasher> decompressCache;
+// FilePoolCore opens (and decompresses) files from several threads.
+static std::mutex decompressMutex;
+
+// Files that are (or decompress to) at least this big are not decompressed
+// completely in memory, see initSeekable().
+constexpr size_t SEEKABLE_THRESHOLD = 32 * 1024 * 1024; // 32MB
 
 
 CompressedFileAdapter::CompressedFileAdapter(std::unique_ptr<FileBase> file_)
@@ -23,6 +33,7 @@ CompressedFileAdapter::CompressedFileAdapter(std::unique_ptr<FileBase> file_)
 CompressedFileAdapter::~CompressedFileAdapter()
 {
 	if (decompressed) {
+		std::lock_guard lock(decompressMutex);
 		auto it = decompressCache.find(getURL());
 		assert(it != end(decompressCache));
 		assert(it->get() == decompressed);
@@ -39,13 +50,23 @@ void CompressedFileAdapter::decompress()
 	if (decompressed) return;
 
 	const std::string& url = getURL();
+	std::unique_lock lock(decompressMutex);
 	auto it = decompressCache.find(url);
 	if (it == end(decompressCache)) {
+		// don't hold the lock during the (slow) decompression
+		lock.unlock();
 		auto d = std::make_unique<Decompressed>();
-		decompress(*file, *d);
+		auto input = file->mmap();
+		ZlibInflate zlib(input);
+		auto sizeHint = readHeader(zlib, input, d->originalName);
+		d->size = zlib.inflate(d->buf, sizeHint ? sizeHint : 65536);
 		d->cachedModificationDate = getModificationDate();
 		d->cachedURL = url;
-		it = decompressCache.insert_noDuplicateCheck(std::move(d));
+		lock.lock();
+		it = decompressCache.find(url); // maybe another thread was faster
+		if (it == end(decompressCache)) {
+			it = decompressCache.insert_noDuplicateCheck(std::move(d));
+		}
 	}
 	++(*it)->useCount;
 	decompressed = it->get();
@@ -54,8 +75,37 @@ void CompressedFileAdapter::decompress()
 	file.reset();
 }
 
+// Big files (e.g. harddisk or laserdisc images) are only decompressed once, to
+// build an index of access points. Afterwards read() only decompresses the
+// parts that are actually needed. This uses less memory and it makes opening
+// such files a lot faster. mmap() still needs the full decompressed content.
+bool CompressedFileAdapter::initSeekable()
+{
+	if (index) return true;
+	if (decompressed || seekableChecked) return false;
+	seekableChecked = true;
+
+	auto input = file->mmap();
+	ZlibInflate zlib(input);
+	std::string name;
+	auto size = readHeader(zlib, input, name);
+	if (std::max(input.size(), size) < SEEKABLE_THRESHOLD) return false;
+
+	index = std::make_unique<DeflateIndex>(input.subspan(zlib.getInputPos()));
+	indexOriginalName = std::move(name);
+	return true;
+}
+
 void CompressedFileAdapter::read(void* buffer, size_t num)
 {
+	if (initSeekable()) {
+		if (index->getSize() < (pos + num)) {
+			throw FileException("Read beyond end of file");
+		}
+		index->read(pos, static_cast<uint8_t*>(buffer), num);
+		pos += num;
+		return;
+	}
 	decompress();
 	if (decompressed->size < (pos + num)) {
 		throw FileException("Read beyond end of file");
@@ -72,6 +122,8 @@ void CompressedFileAdapter::write(const void* /*buffer*/, size_t /*num*/)
 
 span<const uint8_t> CompressedFileAdapter::mmap()
 {
+	index.reset(); // the full content is needed after all
+	seekableChecked = true;
 	decompress();
 	return { decompressed->buf.data(), decompressed->size };
 }
@@ -83,6 +135,7 @@ void CompressedFileAdapter::munmap()
 
 size_t CompressedFileAdapter::getSize()
 {
+	if (initSeekable()) return index->getSize();
 	decompress();
 	return decompressed->size;
 }
@@ -114,6 +167,7 @@ const std::string& CompressedFileAdapter::getURL() const
 
 std::string_view CompressedFileAdapter::getOriginalName()
 {
+	if (initSeekable()) return indexOriginalName;
 	decompress();
 	return decompressed->originalName;
 }
@@ -7,6 +7,9 @@
 
 namespace openmsx {
 
+class DeflateIndex;
+class ZlibInflate;
+
 class CompressedFileAdapter : public FileBase
 {
 public:
@@ -36,15 +39,28 @@ public:
 protected:
 	explicit CompressedFileAdapter(std::unique_ptr<FileBase> file);
 	~CompressedFileAdapter() override;
-	virtual void decompress(FileBase& file, Decompressed& decompressed) = 0;
+
+	/** Parse the header, 'zlib' must end up at the start of the (raw)
+	  * deflate stream.
+	  * @param input The full compressed file.
+	  * @result The decompressed size, or an estimate, or 0 when unknown.
+	  */
+	virtual size_t readHeader(ZlibInflate& zlib, span<const uint8_t> input,
+	                          std::string& originalName) = 0;
 
 private:
 	void decompress();
+	[[nodiscard]] bool initSeekable();
 
 private:
 	std::unique_ptr<FileBase> file;
 	const Decompressed* decompressed = nullptr;
 	size_t pos = 0;
+
+	// Only for big files: decompress on demand.
+	std::unique_ptr<DeflateIndex> index;
+	std::string indexOriginalName;
+	bool seekableChecked = false;
 };
 
 } // namespace openmsx
@@ -0,0 +1,155 @@
+#include "DeflateIndex.hh"
+#include "FileException.hh"
+#include "ranges.hh"
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <zlib.h>
+
+namespace openmsx {
+
+// Owns an initialized (raw) inflate stream.
+struct Inflater
+{
+	Inflater() {
+		s.zalloc = nullptr;
+		s.zfree  = nullptr;
+		s.opaque = nullptr;
+		s.next_in  = nullptr;
+		s.avail_in = 0;
+		int err = inflateInit2(&s, -MAX_WBITS);
+		if (err != Z_OK) {
+			throw FileException(
+				"Error initializing inflate struct: ", zError(err));
+		}
+	}
+	~Inflater() {
+		inflateEnd(&s);
+	}
+	Inflater(const Inflater&) = delete;
+	Inflater& operator=(const Inflater&) = delete;
+
+	z_stream s;
+};
+
+// 'avail_in' is only 32 bit, so (theoretically) we have to feed the input in
+// several steps.
+static void refill(z_stream& s, span<const uint8_t> input)
+{
+	if (s.avail_in != 0) return;
+	auto inPos = size_t(s.next_in - input.data());
+	s.avail_in = uInt(std::min<size_t>(input.size() - inPos, 1 << 30));
+}
+
+static void checkError(int err, z_stream& s, span<const uint8_t> input)
+{
+	if ((err == Z_BUF_ERROR) && (size_t(s.next_in - input.data()) == input.size())) {
+		throw FileException("Error decompressing: unexpected end of file");
+	}
+	if (err != Z_OK) {
+		throw FileException("Error decompressing: ", zError(err));
+	}
+}
+
+DeflateIndex::DeflateIndex(span<const uint8_t> input_, size_t spacing)
+	: input(input_)
+{
+	// The start of the stream is always an access point (with an empty
+	// window).
+	points.push_back({0, 0, 0});
+	windows.assign(WINDOW_SIZE, 0);
+
+	Inflater z;
+	z.s.next_in = const_cast<uint8_t*>(input.data());
+	MemBuffer<uint8_t> window(WINDOW_SIZE); // circular buffer with the last output
+	memset(window.data(), 0, WINDOW_SIZE);
+	z.s.avail_out = 0;
+	size_t out = 0;
+	size_t last = 0; // position of the last access point
+	while (true) {
+		if (z.s.avail_out == 0) {
+			z.s.next_out = window.data();
+			z.s.avail_out = WINDOW_SIZE;
+		}
+		refill(z.s, input);
+		auto before = z.s.avail_out;
+		// Z_BLOCK: stop at each deflate block boundary
+		int err = ::inflate(&z.s, Z_BLOCK);
+		out += before - z.s.avail_out;
+		if (err == Z_STREAM_END) break;
+		checkError(err, z.s, input);
+
+		// At the end of a block (but not the last one)? Only then the
+		// state of the decompressor is small enough to store.
+		if ((z.s.data_type & 128) && !(z.s.data_type & 64) &&
+		    ((out - last) > spacing)) {
+			auto in = size_t(z.s.next_in - input.data());
+			points.push_back({out, in, z.s.data_type & 7});
+			// copy circular buffer, oldest data first
+			size_t left = z.s.avail_out;
+			auto* w = &*windows.insert(windows.end(), WINDOW_SIZE, 0);
+			memcpy(w, window.data() + WINDOW_SIZE - left, left);
+			memcpy(w + left, window.data(), WINDOW_SIZE - left);
+			last = out;
+		}
+	}
+	size = out;
+}
+
+void DeflateIndex::decompressChunk(size_t n)
+{
+	const auto& p = points[n];
+	size_t end = ((n + 1) < points.size()) ? points[n + 1].out : size;
+	size_t len = end - p.out;
+	chunk.resize(len);
+	chunkNum = size_t(-1); // in case of exceptions
+	chunkSize = len;
+
+	Inflater z;
+	z.s.next_in = const_cast<uint8_t*>(input.data() + p.in);
+	if (p.bits) {
+		int err = inflatePrime(&z.s, p.bits, input[p.in - 1] >> (8 - p.bits));
+		checkError(err, z.s, input);
+	}
+	int err = inflateSetDictionary(&z.s, &windows[n * WINDOW_SIZE], WINDOW_SIZE);
+	checkError(err, z.s, input);
+
+	size_t done = 0;
+	while (done < len) {
+		refill(z.s, input);
+		z.s.next_out = chunk.data() + done;
+		z.s.avail_out = uInt(std::min<size_t>(len - done, 1 << 30));
+		auto before = z.s.avail_out;
+		err = ::inflate(&z.s, Z_NO_FLUSH);
+		done += before - z.s.avail_out;
+		if (err == Z_STREAM_END) break;
+		checkError(err, z.s, input);
+	}
+	if (done != len) {
+		throw FileException("Error decompressing: unexpected end of stream");
+	}
+	chunkNum = n;
+}
+
+void DeflateIndex::read(size_t pos, uint8_t* buffer, size_t num)
+{
+	assert((pos + num) <= size);
+	while (num) {
+		auto chunkStart = (chunkNum != size_t(-1)) ? points[chunkNum].out : 0;
+		auto chunkEnd   = (chunkNum != size_t(-1)) ? (chunkStart + chunkSize) : 0;
+		if ((pos < chunkStart) || (pos >= chunkEnd)) {
+			// last access point at or before 'pos'
+			auto it = ranges::upper_bound(points, pos, {}, &AccessPoint::out);
+			decompressChunk(size_t(it - points.begin()) - 1);
+			chunkStart = points[chunkNum].out;
+			chunkEnd = chunkStart + chunkSize;
+		}
+		auto len = std::min(num, chunkEnd - pos);
+		memcpy(buffer, chunk.data() + (pos - chunkStart), len);
+		buffer += len;
+		pos += len;
+		num -= len;
+	}
+}
+
+} // namespace openmsx
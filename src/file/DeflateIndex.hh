@@ -0,0 +1,66 @@
+#ifndef DEFLATEINDEX_HH
+#define DEFLATEINDEX_HH
+
+#include "MemBuffer.hh"
+#include "span.hh"
+#include <cstdint>
+#include <vector>
+
+namespace openmsx {
+
+/** Random access in a (raw) deflate stream.
+  *
+  * The constructor decompresses the full stream once (without storing the
+  * result) and remembers an access point roughly every 'spacing' bytes of
+  * output. An access point contains the position in the input and the last
+  * 32kB of output, that's all the state needed to restart decompression at
+  * that point. Afterwards read() only decompresses the chunks (the data
+  * between two access points) it touches. The most recently decompressed
+  * chunk is kept, so sequential reads decompress each chunk only once.
+  *
+  * This is the same technique as 'zran.c' from the zlib examples.
+  */
+class DeflateIndex
+{
+public:
+	/** @param input The compressed data, must remain valid during the
+	  *              lifetime of this object.
+	  * @throws FileException when the data is invalid.
+	  */
+	explicit DeflateIndex(span<const uint8_t> input, size_t spacing = 1024 * 1024);
+
+	/** Size of the decompressed data. */
+	[[nodiscard]] size_t getSize() const { return size; }
+
+	/** Copy decompressed data.
+	  * @pre pos + num <= getSize()
+	  * @throws FileException
+	  */
+	void read(size_t pos, uint8_t* buffer, size_t num);
+
+	[[nodiscard]] size_t getNumAccessPoints() const { return points.size(); }
+
+private:
+	void decompressChunk(size_t n);
+
+private:
+	static constexpr size_t WINDOW_SIZE = 32768;
+
+	struct AccessPoint {
+		size_t out; // position in the decompressed data
+		size_t in;  // position in the input, first full byte
+		int bits;   // number of bits (1-7) from the byte before 'in', or 0
+	};
+	span<const uint8_t> input;
+	std::vector<AccessPoint> points;
+	std::vector<uint8_t> windows; // WINDOW_SIZE bytes per access point
+	size_t size = 0;
+
+	MemBuffer<uint8_t> chunk; // the last decompressed chunk
+	size_t chunkSize = 0;
+	size_t chunkNum = size_t(-1);
+};
+
+} // namespace openmsx
+
+#endif
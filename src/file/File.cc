@@ -128,6 +128,11 @@ void File::truncate(size_t size)
 	return file->truncate(size);
 }
 
+void File::prefetch(size_t pos, size_t num)
+{
+	file->prefetch(pos, num);
+}
+
 void File::flush()
 {
 	file->flush();
@@ -115,6 +115,14 @@ public:
 	 */
 	void truncate(size_t size);
 
+	/** Hint that the given range of the file will likely be read soon.
+	 *  For files on the local file system the data is read (and
+	 *  discarded) in a background thread, so that it hopefully is in
+	 *  the OS cache once it's really needed. This never blocks and it's
+	 *  fine to pass a range that extends beyond the end of the file.
+	 */
+	void prefetch(size_t pos, size_t num);
+
 	/** Force a write of all buffered data to disk. There is no need to
 	 *  call this function before destroying a File object.
 	 */
@@ -46,6 +46,12 @@ void FileBase::truncate(size_t newSize)
 	}
 }
 
+void FileBase::prefetch(size_t /*pos*/, size_t /*num*/)
+{
+	// default implementation: nothing to do, e.g. decompressed files are
+	// already completely in memory
+}
+
 std::string FileBase::getLocalReference()
 {
 	// default implementation, file is not backed (uncompressed) on
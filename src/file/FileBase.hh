@@ -25,6 +25,7 @@ public:
 	virtual void seek(size_t pos) = 0;
 	[[nodiscard]] virtual size_t getPos() = 0;
 	virtual void truncate(size_t size);
+	virtual void prefetch(size_t pos, size_t num);
 	virtual void flush() = 0;
 
 	[[nodiscard]] virtual const std::string& getURL() const = 0;
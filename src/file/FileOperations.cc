@@ -54,6 +54,7 @@
 #include <algorithm>
 #include <sstream>
 #include <cerrno>
+#include <cstdio>
 #include <cstdlib>
 #include <stdexcept>
 #include <cassert>
@@ -186,6 +187,16 @@ int rmdir(zstring_view path)
 #endif
 }
 
+int rename(zstring_view from, zstring_view to)
+{
+#ifdef _WIN32
+	return MoveFileExW(utf8to16(from).c_str(), utf8to16(to).c_str(),
+	                   MOVEFILE_REPLACE_EXISTING) ? 0 : -1;
+#else
+	return ::rename(from.c_str(), to.c_str());
+#endif
+}
+
 #ifdef _WIN32
 int deleteRecursive(zstring_view path)
 {
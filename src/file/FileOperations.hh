@@ -68,6 +68,13 @@ namespace openmsx::FileOperations {
 	 */
 	int rmdir(zstring_view path);
 
+	/**
+	 * Call rename() in a platform-independent manner. An existing file
+	 * 'to' is replaced (on POSIX systems atomically).
+	 * @result 0 on success
+	 */
+	int rename(zstring_view from, zstring_view to);
+
 	/** Recursively delete a file or directory and (in case of a directory)
 	  * all its sub-components.
 	  */
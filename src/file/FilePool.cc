@@ -8,6 +8,7 @@
 #include "EventDistributor.hh"
 #include "CliComm.hh"
 #include "Reactor.hh"
+#include "PerfTimers.hh"
 #include "outer.hh"
 #include "xrange.hh"
 #include <memory>
@@ -52,11 +53,13 @@ FilePool::~FilePool()
 
 File FilePool::getFile(FileType fileType, const Sha1Sum& sha1sum)
 {
+	PerfTimers::Scope perf(PerfTimers::FILEPOOL);
 	return core.getFile(fileType, sha1sum);
 }
 
 Sha1Sum FilePool::getSha1Sum(File& file)
 {
+	PerfTimers::Scope perf(PerfTimers::FILEPOOL);
 	return core.getSha1Sum(file);
 }
 
@@ -4,11 +4,16 @@
 #include "foreach_file.hh"
 #include "Date.hh"
 #include "Timer.hh"
+#include "WorkerPool.hh"
 #include "one_of.hh"
 #include "ranges.hh"
+#include "strCat.hh"
+#include "xrange.hh"
+#include <cstring>
 #include <fstream>
 #include <optional>
 #include <tuple>
+#include <type_traits>
 
 namespace openmsx {
 
@@ -20,6 +25,42 @@ struct GetSha1 {
 	}
 };
 
+// Layout of the binary version of '.filecache'. It's written next to the text
+// version (which remains the reference), and is only used when it was written
+// at the same time as the text version (it stores the size and modification
+// time of that file). It's stored in native byte order, it's not meant to be
+// portable between machines.
+//   BinaryHeader
+//   BinaryEntry[count]   sorted on sha1sum
+//   char[arenaSize]      all filenames (not zero-terminated)
+static constexpr char BINARY_MAGIC[8] = {'o', 'M', 'S', 'X', 'f', 'p', 'c', '\x1a'};
+static constexpr uint32_t BINARY_VERSION = 1;
+static constexpr uint32_t BYTE_ORDER_MARK = 0x01020304;
+
+struct BinaryHeader {
+	char magic[8];
+	uint32_t version;
+	uint32_t byteOrder;
+	uint64_t textSize;
+	int64_t textTime;
+	uint64_t count;
+	uint64_t arenaSize;
+};
+struct BinaryEntry {
+	int64_t time;
+	uint32_t nameOffset; // in arena
+	uint32_t nameSize;
+	Sha1Sum sum;
+	uint32_t padding = 0;
+};
+static_assert(std::is_trivially_copyable_v<BinaryEntry>);
+static_assert(sizeof(BinaryEntry) == 40);
+
+[[nodiscard]] static std::string binaryFilename(std::string_view filecache)
+{
+	return strCat(filecache, ".bin");
+}
+
 
 FilePoolCore::FilePoolCore(std::string filecache_,
                            std::function<Directories()> getDirectories_,
@@ -167,6 +208,73 @@ void FilePoolCore::readSha1sums()
 	assert(sha1Index.empty());
 	assert(fileMem.empty());
 
+	if (!readBinarySha1sums()) {
+		readTextSha1sums();
+		needWrite = true; // create the binary version for the next time
+	}
+	indexSha1sums();
+}
+
+bool FilePoolCore::readBinarySha1sums()
+{
+	FileOperations::Stat st;
+	if (!FileOperations::getStat(filecache, st)) return false;
+
+	size_t size;
+	try {
+		File file(binaryFilename(filecache));
+		size = file.getSize();
+		if (size < sizeof(BinaryHeader)) return false;
+		fileMem.resize(size);
+		file.read(fileMem.data(), size);
+	} catch (MSXException&) {
+		fileMem.clear();
+		return false;
+	}
+	auto fail = [&] {
+		fileMem.clear();
+		return false;
+	};
+
+	BinaryHeader header;
+	memcpy(&header, fileMem.data(), sizeof(header));
+	if ((memcmp(header.magic, BINARY_MAGIC, sizeof(BINARY_MAGIC)) != 0) ||
+	    (header.version != BINARY_VERSION) ||
+	    (header.byteOrder != BYTE_ORDER_MARK)) {
+		return fail();
+	}
+	if ((header.textSize != uint64_t(st.st_size)) ||
+	    (header.textTime != int64_t(FileOperations::getModificationDate(st)))) {
+		// text version was changed (e.g. by an older openMSX version)
+		return fail();
+	}
+	auto entriesSize = size - sizeof(header);
+	if ((header.count > (entriesSize / sizeof(BinaryEntry))) ||
+	    (header.arenaSize != (entriesSize - header.count * sizeof(BinaryEntry)))) {
+		return fail();
+	}
+	const char* entries = fileMem.data() + sizeof(header);
+	const char* arena = entries + header.count * sizeof(BinaryEntry);
+
+	// first validate everything, so that a corrupt file leaves no trace
+	for (auto i : xrange(header.count)) {
+		BinaryEntry e;
+		memcpy(&e, entries + i * sizeof(BinaryEntry), sizeof(e));
+		if ((uint64_t(e.nameOffset) + e.nameSize) > header.arenaSize) return fail();
+		if (time_t(e.time) == Date::INVALID_TIME_T) return fail();
+	}
+	sha1Index.reserve(header.count);
+	for (auto i : xrange(header.count)) {
+		BinaryEntry e;
+		memcpy(&e, entries + i * sizeof(BinaryEntry), sizeof(e));
+		std::string_view filename(arena + e.nameOffset, e.nameSize);
+		sha1Index.push_back(pool.emplace(e.sum, time_t(e.time), filename).idx);
+	}
+	return true;
+}
+
+void FilePoolCore::readTextSha1sums()
+{
 	File file(filecache);
 	auto size = file.getSize();
 	fileMem.resize(size + 1);
@@ -193,7 +301,10 @@ void FilePoolCore::readSha1sums()
 			return c != one_of('\n', '\r');
 		});
 	}
+}
 
+void FilePoolCore::indexSha1sums()
+{
 	if (!ranges::is_sorted(sha1Index, {}, GetSha1{pool})) {
 		// This should _rarely_ happen. In fact it should only happen
 		// when .filecache was manually edited. Though because it's
@@ -219,21 +330,86 @@ void FilePoolCore::readSha1sums()
 
 void FilePoolCore::writeSha1sums()
 {
-	std::ofstream file;
-	FileOperations::openofstream(file, filecache);
-	if (!file.is_open()) {
+	// Write to a temporary file first and then rename, so that a crash
+	// (or a full disk) doesn't leave a truncated '.filecache' behind.
+	auto tmpName = strCat(filecache, ".tmp");
+	{
+		std::ofstream file;
+		FileOperations::openofstream(file, tmpName);
+		if (!file.is_open()) {
+			return;
+		}
+		for (auto idx : sha1Index) {
+			const auto& entry = pool[idx];
+			file << entry.sum.toString() << "  ";
+			if (entry.timeStr) {
+				file << entry.timeStr;
+			} else {
+				assert(entry.time != Date::INVALID_TIME_T);
+				file << Date::toString(entry.time);
+			}
+			file << "  " << entry.filename << '\n';
+		}
+		file.close();
+		if (file.fail()) {
+			FileOperations::unlink(tmpName);
+			return;
+		}
+	}
+	if (FileOperations::rename(tmpName, filecache) != 0) {
+		FileOperations::unlink(tmpName);
 		return;
 	}
+	writeBinarySha1sums();
+}
+
+void FilePoolCore::writeBinarySha1sums()
+{
+	auto binName = binaryFilename(filecache);
+	FileOperations::Stat st;
+	if (!FileOperations::getStat(filecache, st)) return;
+
+	std::vector<BinaryEntry> entries;
+	entries.reserve(sha1Index.size());
+	std::string arena;
 	for (auto idx : sha1Index) {
-		const auto& entry = pool[idx];
-		file << entry.sum.toString() << "  ";
-		if (entry.timeStr) {
-			file << entry.timeStr;
-		} else {
-			assert(entry.time != Date::INVALID_TIME_T);
-			file << Date::toString(entry.time);
+		auto& entry = pool[idx];
+		auto time = entry.getTime();
+		if (time == Date::INVALID_TIME_T) continue; // removed on next use anyway
+		if ((arena.size() + entry.filename.size()) > 0xFFFF'FFFF) return; // use the text version
+		entries.push_back(BinaryEntry{
+			int64_t(time), uint32_t(arena.size()), uint32_t(entry.filename.size()), entry.sum});
+		arena += entry.filename;
+	}
+
+	BinaryHeader header;
+	memcpy(header.magic, BINARY_MAGIC, sizeof(BINARY_MAGIC));
+	header.version = BINARY_VERSION;
+	header.byteOrder = BYTE_ORDER_MARK;
+	header.textSize = uint64_t(st.st_size);
+	header.textTime = int64_t(FileOperations::getModificationDate(st));
+	header.count = entries.size();
+	header.arenaSize = arena.size();
+
+	auto tmpName = strCat(binName, ".tmp");
+	{
+		std::ofstream file;
+		FileOperations::openofstream(file, tmpName, std::ios::out | std::ios::binary);
+		if (!file.is_open()) {
+			return;
 		}
-		file << "  " << entry.filename << '\n';
+		file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		file.write(reinterpret_cast<const char*>(entries.data()),
+		           std::streamsize(entries.size() * sizeof(BinaryEntry)));
+		file.write(arena.data(), std::streamsize(arena.size()));
+		file.close();
+		if (file.fail()) {
+			FileOperations::unlink(tmpName);
+			return;
+		}
+	}
+	if (FileOperations::rename(tmpName, binName) != 0) {
+		FileOperations::unlink(tmpName);
 	}
 }
 
@@ -369,6 +545,11 @@ File FilePoolCore::scanDirectory(
 		return !result.is_open(); // abort traversal when found
 	};
 	foreach_file_recursive(directory, fileAction);
+	if (!result.is_open() && !stop) {
+		result = hashPending(sha1sum, progress);
+	}
+	progress.pending.clear(); // discard when found or aborted
+	progress.pendingSize = 0;
 	return result;
 }
 
@@ -389,43 +570,112 @@ File FilePoolCore::scanFile(const Sha1Sum& sha1sum, const std::string& filename,
 	}
 
 	auto time = FileOperations::getModificationDate(st);
-	if (auto [idx, entry] = findInDatabase(filename); idx == Index(-1)) {
-		// not in pool
+	if (auto [idx, entry] = findInDatabase(filename); idx != Index(-1)) {
+		// already in pool
+		assert(filename == entry->filename);
+		if (entry->getTime() == time) {
+			// db is still up to date
+			if (entry->sum != sha1sum) return File(); // not found
+			try {
+				return File(filename);
+			} catch (FileException&) {
+				// error reading file, remove from db
+				remove(idx, *entry);
+				return File();
+			}
+		}
+		// db outdated
+	}
+
+	// Not in pool, or outdated: (re)calculate the sha1sum. Most files are
+	// small, those are collected and then hashed in parallel. Big files are
+	// hashed directly, so that we can show progress information.
+	constexpr size_t MAX_PARALLEL_SIZE = 16 * 1024 * 1024; // 16MB
+	constexpr size_t MAX_PENDING_SIZE = 64 * 1024 * 1024; // 64MB
+	auto size = size_t(st.st_size);
+	if (size > MAX_PARALLEL_SIZE) {
+		// first handle the files that were found before this one
+		if (auto result = hashPending(sha1sum, progress); result.is_open()) {
+			return result;
+		}
+		PendingFile p(filename, time);
 		try {
 			File file(filename);
-			auto sum = calcSha1sum(file);
-			insert(sum, time, filename);
-			if (sum == sha1sum) {
-				return file;
-			}
+			p.sum = calcSha1sum(file);
 		} catch (FileException&) {
-			// ignore
+			p.error = true;
 		}
-	} else {
-		// already in pool
-		assert(filename == entry->filename);
+		storeSha1(p);
+		if (p.error || (p.sum != sha1sum)) return File(); // not found
 		try {
-			if (entry->getTime() == time) {
-				// db is still up to date
-				if (entry->sum == sha1sum) {
-					return File(filename);
-				}
-			} else {
-				// db outdated
-				File file(filename);
-				auto sum = calcSha1sum(file);
-				entry->setTime(time);
-				adjustSha1(idx, *entry, sum);
-				if (sum == sha1sum) {
-					return file;
-				}
-			}
+			return File(filename);
 		} catch (FileException&) {
-			// error reading file, remove from db
-			remove(idx, *entry);
+			return File();
 		}
 	}
-	return File(); // not found
+
+	progress.pending.emplace_back(filename, time);
+	progress.pendingSize += size;
+	unsigned maxPending = 4 * (progress.workers ? progress.workers->getNumThreads() : 1);
+	if ((progress.pending.size() >= maxPending) ||
+	    (progress.pendingSize >= MAX_PENDING_SIZE)) {
+		return hashPending(sha1sum, progress);
+	}
+	return File(); // not (yet) found
+}
+
+File FilePoolCore::hashPending(const Sha1Sum& sha1sum, ScanProgress& progress)
+{
+	auto& pending = progress.pending;
+	if (pending.empty()) return File();
+
+	if (!progress.workers) {
+		progress.workers = std::make_unique<WorkerPool>();
+	}
+	for (auto& p : pending) {
+		// Only touch 'p' itself, the database is updated below (on
+		// the main thread).
+		progress.workers->post([&p] {
+			try {
+				File file(p.filename);
+				p.sum = SHA1::calc(file.mmap());
+			} catch (FileException&) {
+				p.error = true;
+			}
+		});
+	}
+	progress.workers->wait();
+
+	// Update the database (also for the files after the match, the work
+	// was done anyway) and return the first match in scan order.
+	File result;
+	for (const auto& p : pending) {
+		storeSha1(p);
+		if (!result.is_open() && !p.error && (p.sum == sha1sum)) {
+			try {
+				result = File(p.filename);
+			} catch (FileException&) {
+				// ignore
+			}
+		}
+	}
+	pending.clear();
+	progress.pendingSize = 0;
+	return result;
+}
+
+void FilePoolCore::storeSha1(const PendingFile& p)
+{
+	auto [idx, entry] = findInDatabase(p.filename);
+	if (p.error) {
+		// error reading file, remove from db (if present)
+		if (idx != Index(-1)) remove(idx, *entry);
+	} else if (idx == Index(-1)) {
+		insert(p.sum, p.time, p.filename);
+	} else {
+		entry->setTime(p.time);
+		adjustSha1(idx, *entry, p.sum);
+	}
 }
 
 std::pair<FilePoolCore::Index, FilePoolCore::Entry*> FilePoolCore::findInDatabase(std::string_view filename)
@@ -11,6 +11,7 @@
 #include <cstdint>
 #include <ctime>
 #include <functional>
+#include <memory>
 #include <string>
 #include <string_view>
 #include <vector>
@@ -18,6 +19,7 @@
 namespace openmsx {
 
 class File;
+class WorkerPool;
 
 enum class FileType {
 	NONE = 0,
@@ -68,9 +70,24 @@ public:
 	void abort() { stop = true; }
 
 private:
+	// A file that (still) needs its sha1sum calculated. These are collected
+	// during a directory scan and then hashed in parallel.
+	struct PendingFile {
+		PendingFile(std::string f, time_t t)
+			: filename(std::move(f)), time(t) {}
+
+		std::string filename;
+		time_t time;
+		Sha1Sum sum; // filled in by the worker thread
+		bool error = false;
+	};
+
 	struct ScanProgress {
 		uint64_t lastTime;
 		unsigned amountScanned;
+		std::vector<PendingFile> pending;
+		size_t pendingSize = 0; // sum of the sizes of the pending files
+		std::unique_ptr<WorkerPool> workers; // created on first use
 	};
 
 	struct Entry {
@@ -135,7 +152,11 @@ private:
 	bool adjustSha1(Index idx,              Entry& entry, const Sha1Sum& newSum);
 
 	void readSha1sums();
+	[[nodiscard]] bool readBinarySha1sums();
+	void readTextSha1sums();
+	void indexSha1sums();
 	void writeSha1sums();
+	void writeBinarySha1sums();
 
 	[[nodiscard]] File getFromPool(const Sha1Sum& sha1sum);
 	[[nodiscard]] File scanDirectory(
@@ -149,6 +170,8 @@ private:
 	        const FileOperations::Stat& st,
 	        std::string_view poolPath,
 	        ScanProgress& progress);
+	[[nodiscard]] File hashPending(const Sha1Sum& sha1sum, ScanProgress& progress);
+	void storeSha1(const PendingFile& p);
 	[[nodiscard]] Sha1Sum calcSha1sum(File& file);
 	[[nodiscard]] std::pair<Index, Entry*> findInDatabase(std::string_view filename);
 
@@ -157,7 +180,7 @@ private:
 	std::function<Directories()> getDirectories;
 	std::function<void(std::string_view)> reportProgress;
 
-	MemBuffer<char> fileMem; // content of initial .filecache
+	MemBuffer<char> fileMem; // content of initial .filecache (text or binary)
 	std::vector<std::string> stringBuffer; // owns strings that are not in 'fileMem'
 
 	Pool pool; // the actual entries
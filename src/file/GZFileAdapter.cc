@@ -53,13 +53,19 @@ GZFileAdapter::GZFileAdapter(std::unique_ptr<FileBase> file_)
 	return true;
 }
 
-void GZFileAdapter::decompress(FileBase& f, Decompressed& d)
+size_t GZFileAdapter::readHeader(ZlibInflate& zlib, span<const uint8_t> input,
+                                 std::string& originalName)
 {
-	ZlibInflate zlib(f.mmap());
-	if (!skipHeader(zlib, d.originalName)) {
+	if (!skipHeader(zlib, originalName)) {
 		throw FileException("Not a gzip header");
 	}
-	d.size = zlib.inflate(d.buf);
+	// The last 4 bytes contain the decompressed size (modulo 2^32). Only
+	// use it as an estimate, and ignore it when it's not possible (deflate
+	// can't compress better than about 1:1032).
+	if (input.size() < 8) return 0;
+	const auto* p = &input[input.size() - 4];
+	size_t size = p[0] | (p[1] << 8) | (p[2] << 16) | (size_t(p[3]) << 24);
+	return (size <= (1032 * input.size())) ? size : 0;
 }
 
 } // namespace openmsx
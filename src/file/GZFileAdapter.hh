@@ -11,7 +11,8 @@ public:
 	explicit GZFileAdapter(std::unique_ptr<FileBase> file);
 
 private:
-	void decompress(FileBase& file, Decompressed& decompressed) override;
+	size_t readHeader(ZlibInflate& zlib, span<const uint8_t> input,
+	                  std::string& originalName) override;
 };
 
 } // namespace openmsx
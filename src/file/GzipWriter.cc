@@ -0,0 +1,162 @@
+#include "GzipWriter.hh"
+#include "FileException.hh"
+#include "WorkerPool.hh"
+#include "xrange.hh"
+#include <algorithm>
+#include <cassert>
+
+namespace openmsx {
+
+GzipWriter::GzipWriter(Sink sink_, int level_)
+	: sink(std::move(sink_))
+	, level(level_)
+	, current(std::make_unique<Block>())
+	, crc(crc32(0, nullptr, 0))
+{
+	current->input.reserve(BLOCK_SIZE);
+}
+
+GzipWriter::~GzipWriter()
+{
+	// the tasks still refer to the blocks (and to 'mutex' and 'doneCond')
+	std::unique_lock lock(mutex);
+	doneCond.wait(lock, [&] {
+		return std::all_of(begin(pending), end(pending),
+		                   [](const auto& b) { return b->done; });
+	});
+}
+
+void GzipWriter::write(const void* data_, size_t len)
+{
+	assert(!finished);
+	const auto* data = static_cast<const uint8_t*>(data_);
+	while (len) {
+		if (current->input.size() == BLOCK_SIZE) submit(false);
+		auto n = std::min(len, BLOCK_SIZE - current->input.size());
+		current->input.insert(current->input.end(), data, data + n);
+		data += n;
+		len -= n;
+	}
+}
+
+void GzipWriter::submit(bool last)
+{
+	auto* block = current.get();
+	block->size = block->input.size();
+	block->last = last;
+	pending.push_back(std::move(current));
+	if (!last) {
+		current = std::make_unique<Block>();
+		current->input.reserve(BLOCK_SIZE);
+		const auto& in = block->input;
+		auto n = std::min(in.size(), DICT_SIZE);
+		current->dict.assign(in.end() - n, in.end());
+	}
+
+	auto& pool = WorkerPool::background();
+	pool.post([this, block, lvl = level] {
+		compress(*block, lvl);
+		// notify while holding the lock: as soon as 'done' is seen
+		// this object may be destroyed
+		std::lock_guard lock(mutex);
+		block->done = true;
+		doneCond.notify_all();
+	});
+
+	// Limit the amount of memory that's in use: don't run too far ahead
+	// of the compression threads.
+	while (pending.size() > 2 * pool.getNumThreads()) {
+		writeFront();
+	}
+}
+
+void GzipWriter::compress(Block& block, int level)
+{
+	block.crc = crc32(0, block.input.data(), uInt(block.input.size()));
+
+	z_stream s = {};
+	if (deflateInit2(&s, level, Z_DEFLATED, -MAX_WBITS, 8,
+	                 Z_DEFAULT_STRATEGY) != Z_OK) {
+		block.error = true;
+		return;
+	}
+	if (!block.dict.empty()) {
+		deflateSetDictionary(&s, block.dict.data(), uInt(block.dict.size()));
+	}
+	// a sync flush adds a few bytes more than the bound for Z_FINISH
+	block.output.resize(deflateBound(&s, uLong(block.input.size())) + 16);
+	s.next_in = block.input.data();
+	s.avail_in = uInt(block.input.size());
+	s.next_out = block.output.data();
+	s.avail_out = uInt(block.output.size());
+	// All but the last block end with a sync flush: that ends on a byte
+	// boundary (without setting the 'last block' bit), so the next block
+	// can simply be appended.
+	int flush = block.last ? Z_FINISH : Z_SYNC_FLUSH;
+	while (true) {
+		int r = deflate(&s, flush);
+		if (block.last ? (r == Z_STREAM_END)
+		               : ((s.avail_in == 0) && (s.avail_out != 0))) {
+			break;
+		}
+		if ((r != Z_OK) && (r != Z_BUF_ERROR)) {
+			block.error = true;
+			break;
+		}
+		// shouldn't happen, but in case the bound was too small
+		auto used = block.output.size() - s.avail_out;
+		block.output.resize(2 * block.output.size());
+		s.next_out = block.output.data() + used;
+		s.avail_out = uInt(block.output.size() - used);
+	}
+	block.output.resize(block.output.size() - s.avail_out);
+	deflateEnd(&s);
+
+	// free memory early, the block may still wait a while to be written
+	block.input = {};
+	block.dict = {};
+}
+
+void GzipWriter::writeFront()
+{
+	assert(!pending.empty());
+	auto* block = pending.front().get();
+	{
+		std::unique_lock lock(mutex);
+		doneCond.wait(lock, [&] { return block->done; });
+	}
+	if (block->error) {
+		throw FileException("Error while compressing");
+	}
+
+	if (!headerWritten) {
+		headerWritten = true;
+		// magic, deflate, no flags, no modification time, extra flags
+		// (best compression or fastest), OS = unix (like zlib does)
+		uint8_t xfl = (level == 9) ? 2 : (level == 1) ? 4 : 0;
+		uint8_t header[10] = { 0x1f, 0x8b, 8, 0, 0, 0, 0, 0, xfl, 3 };
+		sink(header);
+	}
+	sink(block->output);
+
+	crc = crc32_combine(crc, block->crc, z_off_t(block->size));
+	totalSize += uint32_t(block->size);
+	pending.pop_front();
+}
+
+void GzipWriter::finish()
+{
+	assert(!finished);
+	finished = true;
+	submit(true);
+	while (!pending.empty()) writeFront();
+
+	uint8_t trailer[8];
+	for (auto i : xrange(4)) {
+		trailer[i + 0] = uint8_t(crc       >> (8 * i));
+		trailer[i + 4] = uint8_t(totalSize >> (8 * i));
+	}
+	sink(trailer);
+}
+
+} // namespace openmsx
@@ -0,0 +1,87 @@
+#ifndef GZIPWRITER_HH
+#define GZIPWRITER_HH
+
+#include "span.hh"
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <zlib.h>
+
+namespace openmsx {
+
+/** Writes data in gzip format, compressing it on multiple threads.
+  *
+  * The input is split in blocks that are compressed independently (on the
+  * background WorkerPool), each block is primed with the last 32kB of the
+  * previous block, so the compression ratio is almost the same as for a
+  * single stream. The output is a standard gzip file (like 'pigz' does).
+  *
+  * The compressed data is passed (in order) to the given sink, always from
+  * the thread that calls write() or finish(). The sink should throw on
+  * error.
+  */
+class GzipWriter
+{
+public:
+	using Sink = std::function<void(span<const uint8_t>)>;
+
+	explicit GzipWriter(Sink sink, int level = Z_DEFAULT_COMPRESSION);
+
+	/** Waits for the still running compression tasks. Data that wasn't
+	  * finish()'ed yet is discarded. */
+	~GzipWriter();
+
+	GzipWriter(const GzipWriter&) = delete;
+	GzipWriter& operator=(const GzipWriter&) = delete;
+
+	void write(const void* data, size_t len);
+	void write1(uint8_t c)
+	{
+		if (current->input.size() == BLOCK_SIZE) submit(false);
+		current->input.push_back(c);
+	}
+
+	/** Compress the remaining data and write the gzip trailer. */
+	void finish();
+
+private:
+	static constexpr size_t BLOCK_SIZE = 128 * 1024;
+	static constexpr size_t DICT_SIZE = 32 * 1024; // deflate window size
+
+	struct Block {
+		std::vector<uint8_t> input;
+		std::vector<uint8_t> dict; // tail of the previous block's input
+		std::vector<uint8_t> output;
+		size_t size = 0; // of input
+		uLong crc = 0; // of input
+		bool last = false;
+		bool done = false;
+		bool error = false;
+	};
+
+	void submit(bool last);
+	void writeFront();
+	static void compress(Block& block, int level);
+
+private:
+	Sink sink;
+	const int level;
+
+	std::unique_ptr<Block> current;
+	std::deque<std::unique_ptr<Block>> pending; // (being) compressed
+	std::mutex mutex;
+	std::condition_variable doneCond;
+
+	uLong crc;
+	uint32_t totalSize = 0; // modulo 2^32, as stored in the gzip trailer
+	bool headerWritten = false;
+	bool finished = false;
+};
+
+} // namespace openmsx
+
+#endif
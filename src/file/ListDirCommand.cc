@@ -0,0 +1,196 @@
+#include "ListDirCommand.hh"
+#include "CommandException.hh"
+#include "FileContext.hh"
+#include "FileOperations.hh"
+#include "ReadDir.hh"
+#include "StringOp.hh"
+#include "TclObject.hh"
+#include "WorkerPool.hh"
+#include "hash_map.hh"
+#include "one_of.hh"
+#include "ranges.hh"
+#include "xxhash.hh"
+#include <algorithm>
+#include <mutex>
+
+namespace openmsx {
+
+// More entries are unlikely to be useful (most browsing goes up and down
+// a few levels), when exceeded the whole cache is cleared.
+static constexpr size_t MAX_CACHED_DIRS = 256;
+// Limit the background work for one 'list_dir prefetch' command.
+static constexpr size_t MAX_PREFETCH = 64;
+
+struct ListDirCommand::Cache {
+	std::mutex mutex;
+	hash_map<std::string, std::shared_ptr<const Listing>, XXHasher> listings;
+};
+
+ListDirCommand::ListDirCommand(CommandController& commandController_)
+	: Command(commandController_, "list_dir")
+	, cache(std::make_shared<Cache>())
+{
+}
+
+[[nodiscard]] static std::optional<time_t> getModTime(const std::string& directory)
+{
+	FileOperations::Stat st;
+	if (!FileOperations::getStat(directory, st) ||
+	    !FileOperations::isDirectory(st)) {
+		return {};
+	}
+	return FileOperations::getModificationDate(st);
+}
+
+std::optional<ListDirCommand::Listing> ListDirCommand::readDir(const std::string& directory)
+{
+	auto modTime = getModTime(directory);
+	if (!modTime) return {};
+	ReadDir dir(directory);
+	if (!dir.isValid()) return {};
+
+	Listing result;
+	result.modTime = *modTime;
+	std::string path = directory;
+	if (path.empty() || (path.back() != '/')) path += '/';
+	auto origLen = path.size();
+	while (dirent* d = dir.getEntry()) {
+		std::string_view name(d->d_name);
+		if (name == one_of(".", "..")) continue;
+		// like Tcl's 'glob *': skip hidden entries
+		if ((name[0] == '.') && (name != ".openMSX")) continue;
+
+		auto type = d->d_type;
+		if (type == one_of(DT_UNKNOWN, DT_LNK)) {
+			// need to stat (e.g. follow the symlink)
+			path.resize(origLen);
+			path += name;
+			FileOperations::Stat st;
+			if (!FileOperations::getStat(path, st)) continue;
+			type = FileOperations::isDirectory(st)   ? DT_DIR
+			     : FileOperations::isRegularFile(st) ? DT_REG
+			                                         : DT_UNKNOWN;
+		}
+		if (type == DT_DIR) {
+			result.dirs.emplace_back(name);
+		} else if ((type == DT_REG) && (name[0] != '.')) {
+			result.files.emplace_back(name);
+		}
+	}
+	return result;
+}
+
+std::shared_ptr<const ListDirCommand::Listing> ListDirCommand::getListing(
+	const std::string& directory)
+{
+	auto modTime = getModTime(directory);
+	if (!modTime) return {};
+	{
+		std::lock_guard lock(cache->mutex);
+		if (auto* l = lookup(cache->listings, directory);
+		    l && ((*l)->modTime == *modTime)) {
+			return *l;
+		}
+	}
+	auto listing = readDir(directory);
+	if (!listing) return {};
+	auto result = std::make_shared<const Listing>(std::move(*listing));
+	std::lock_guard lock(cache->mutex);
+	if (cache->listings.size() >= MAX_CACHED_DIRS) cache->listings.clear();
+	cache->listings.insert_or_assign(directory, result);
+	return result;
+}
+
+void ListDirCommand::prefetch(std::string directory)
+{
+	WorkerPool::background().post([c = cache, dir = std::move(directory)] {
+		if (auto modTime = getModTime(dir)) {
+			std::lock_guard lock(c->mutex);
+			if (auto* l = lookup(c->listings, dir);
+			    l && ((*l)->modTime == *modTime)) {
+				return; // already up-to-date
+			}
+		}
+		auto listing = readDir(dir);
+		if (!listing) return;
+		auto result = std::make_shared<const Listing>(std::move(*listing));
+		std::lock_guard lock(c->mutex);
+		if (c->listings.size() >= MAX_CACHED_DIRS) c->listings.clear();
+		c->listings.insert_or_assign(dir, std::move(result));
+	});
+}
+
+[[nodiscard]] static bool hasExtension(std::string_view name, span<const std::string_view> extensions)
+{
+	return ranges::any_of(extensions, [&](std::string_view ext) {
+		if (name.size() <= ext.size()) return false;
+		auto pos = name.size() - ext.size();
+		return (name[pos - 1] == '.') &&
+		       StringOp::casecmp()(name.substr(pos), ext);
+	});
+}
+
+void ListDirCommand::execute(span<const TclObject> tokens, TclObject& result)
+{
+	checkNumArgs(tokens, AtLeast{2}, "directory ?extensions?");
+	auto arg = tokens[1].getString();
+	if (arg == "prefetch") {
+		auto dirs = tokens.subspan(2);
+		for (const auto& t : dirs.first(std::min(dirs.size(), MAX_PREFETCH))) {
+			prefetch(FileOperations::expandTilde(std::string(t.getString())));
+		}
+		return;
+	}
+	if (arg == "clear") {
+		checkNumArgs(tokens, 2, "clear");
+		std::lock_guard lock(cache->mutex);
+		cache->listings.clear();
+		return;
+	}
+
+	checkNumArgs(tokens, Between{2, 3}, "directory ?extensions?");
+	auto listing = getListing(FileOperations::expandTilde(std::string(arg)));
+	if (!listing) {
+		throw CommandException("Unable to read directory: ", arg);
+	}
+	TclObject files;
+	if (tokens.size() == 3) {
+		// e.g. "rom|ri|zip", case insensitive
+		std::vector<std::string_view> extensions;
+		for (auto ext : StringOp::split_view(tokens[2].getString(), '|')) {
+			extensions.push_back(ext);
+		}
+		for (const auto& f : listing->files) {
+			if (hasExtension(f, extensions)) files.addListElement(f);
+		}
+	} else {
+		files.addListElements(listing->files);
+	}
+	TclObject dirs;
+	dirs.addListElements(listing->dirs);
+	result.addListElement(std::move(dirs), std::move(files));
+}
+
+std::string ListDirCommand::help(span<const TclObject> /*tokens*/) const
+{
+	return "list_dir <directory> [<extensions>]  Returns a list with 2 lists: the sub-directories and the files\n"
+	       "list_dir prefetch <directory> ...    List these directories in the background (for a later 'list_dir')\n"
+	       "list_dir clear                       Clear the cache\n"
+	       "\n"
+	       "The extensions are separated by '|' (e.g. 'rom|ri|zip'), they're "
+	       "matched case insensitive. Hidden files and directories (except "
+	       "'.openMSX') are skipped. The results are cached, the cache is "
+	       "validated with the modification time of the directory.";
+}
+
+void ListDirCommand::tabCompletion(std::vector<std::string>& tokens) const
+{
+	if (tokens.size() == 2) {
+		static constexpr const char* const subCmds[] = {"prefetch", "clear"};
+		completeFileName(tokens, userFileContext(), subCmds);
+	} else if ((tokens.size() > 2) && (tokens[1] == "prefetch")) {
+		completeFileName(tokens, userFileContext());
+	}
+}
+
+} // namespace openmsx
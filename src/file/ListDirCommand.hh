@@ -0,0 +1,52 @@
+#ifndef LISTDIRCOMMAND_HH
+#define LISTDIRCOMMAND_HH
+
+#include "Command.hh"
+#include <ctime>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace openmsx {
+
+/** The 'list_dir' command: list the files and sub-directories of a
+  * directory, like several 'glob' calls would do in Tcl, but with a single
+  * pass over the directory (mostly without stat() calls per entry).
+  *
+  * The results are cached (validated with the modification time of the
+  * directory), and directories can be listed in advance on the background
+  * WorkerPool. This is meant for the file browsers of the OSD menu, which
+  * can otherwise be very slow on (network) drives with many files.
+  */
+class ListDirCommand final : public Command
+{
+public:
+	explicit ListDirCommand(CommandController& commandController);
+
+	void execute(span<const TclObject> tokens, TclObject& result) override;
+	[[nodiscard]] std::string help(span<const TclObject> tokens) const override;
+	void tabCompletion(std::vector<std::string>& tokens) const override;
+
+	struct Listing {
+		time_t modTime;
+		std::vector<std::string> dirs;  // without trailing '/'
+		std::vector<std::string> files; // regular files
+	};
+	/** Returns nullopt if it's not a (readable) directory. Hidden entries
+	  * are skipped, except for the '.openMSX' directory. Doesn't use the
+	  * cache, can be called from any thread. */
+	[[nodiscard]] static std::optional<Listing> readDir(const std::string& directory);
+
+private:
+	[[nodiscard]] std::shared_ptr<const Listing> getListing(const std::string& directory);
+	void prefetch(std::string directory);
+
+private:
+	struct Cache; // shared with the background tasks
+	std::shared_ptr<Cache> cache;
+};
+
+} // namespace openmsx
+
+#endif
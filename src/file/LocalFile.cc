@@ -99,6 +99,24 @@ void LocalFile::preCacheFile()
 	cache.emplace(FileOperations::getNativePath(filename));
 }
 
+void LocalFile::prefetch(size_t pos, size_t num)
+{
+	// Callers typically pass overlapping ranges on consecutive reads (e.g.
+	// 'the next N bytes'). Only request the part that wasn't requested
+	// before, and only once that part is a reasonable fraction of the
+	// range, so that sequential access results in a few big requests.
+	auto end = pos + num;
+	if ((prefetchBegin <= pos) && (pos <= prefetchEnd)) {
+		if (end <= prefetchEnd) return;
+		if ((end - prefetchEnd) < (num / 2)) return;
+		pos = prefetchEnd;
+	} else {
+		prefetchBegin = pos;
+	}
+	prefetchEnd = end;
+	PreCacheFile::prefetch(FileOperations::getNativePath(filename), pos, end - pos);
+}
+
 void LocalFile::read(void* buffer, size_t num)
 {
 	if (fread(buffer, 1, num, file.get()) != num) {
@@ -32,6 +32,7 @@ public:
 #if HAVE_FTRUNCATE
 	void truncate(size_t size) override;
 #endif
+	void prefetch(size_t pos, size_t num) override;
 	void flush() override;
 	[[nodiscard]] const std::string& getURL() const override;
 	[[nodiscard]] std::string getLocalReference() override;
@@ -51,6 +52,8 @@ private:
 	HANDLE hMmap;
 #endif
 	std::optional<PreCacheFile> cache;
+	size_t prefetchBegin = 0; // last range passed to PreCacheFile::prefetch()
+	size_t prefetchEnd = 0;
 	bool readOnly;
 };
 
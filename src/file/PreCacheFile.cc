@@ -1,6 +1,8 @@
 #include "PreCacheFile.hh"
 #include "FileOperations.hh"
+#include "WorkerPool.hh"
 #include "statp.hh"
+#include <algorithm>
 #include <cstdio>
 #include <sys/types.h>
 
@@ -63,4 +65,42 @@ void PreCacheFile::run()
 	}
 }
 
+static void prefetchRange(const std::string& name, size_t pos, size_t num)
+{
+	auto file = FileOperations::openFile(name, "rb");
+	if (!file) return;
+#if defined _WIN32
+	if (_fseeki64(file.get(), pos, SEEK_SET)) return;
+#else
+	if (fseek(file.get(), pos, SEEK_SET)) return;
+#endif
+	const size_t BLOCK_SIZE = 65536;
+	char buf[BLOCK_SIZE];
+	while (num) {
+		auto chunk = std::min(num, BLOCK_SIZE);
+		if (fread(buf, 1, chunk, file.get()) != chunk) {
+			// error or end-of-file, stop
+			break;
+		}
+		num -= chunk;
+	}
+}
+
+void PreCacheFile::prefetch(std::string name, size_t pos, size_t num)
+{
+	// One thread is enough, more threads wouldn't make the disk faster.
+	// Pending requests are still executed when this object gets destroyed
+	// (on exit), that's why the queue is kept short.
+	static WorkerPool pool(1);
+	static std::atomic<unsigned> pending = 0;
+	constexpr unsigned MAX_PENDING = 8;
+
+	if (pending >= MAX_PENDING) return;
+	++pending;
+	pool.post([name = std::move(name), pos, num] {
+		prefetchRange(name, pos, num);
+		--pending;
+	});
+}
+
 } // namespace openmsx
@@ -11,6 +11,11 @@ namespace openmsx {
  * Read the complete file once and discard result. Hopefully the file
  * sticks in the OS cache. Mainly useful to avoid CD-ROM spinups or to
  * speed up real floppy disk (/dev/fd0) reads.
+ *
+ * The static prefetch() method does the same for only a part of a (possibly
+ * large) file. It's used as a readahead hint by e.g. disk and harddisk
+ * images, so that the emulation thread doesn't have to wait for the actual
+ * I/O (much) of the time.
  */
 class PreCacheFile final
 {
@@ -18,6 +23,15 @@ public:
 	explicit PreCacheFile(std::string name);
 	~PreCacheFile();
 
+	/** Read the range [pos, pos + num) of the given file in a background
+	  * thread and discard the result. Requests are handled in order by a
+	  * single thread. When too many requests are outstanding, new ones
+	  * are dropped (it's only a hint). Errors are ignored.
+	  * @param name Name of the file, in native format (see
+	  *             FileOperations::getNativePath()).
+	  */
+	static void prefetch(std::string name, size_t pos, size_t num);
+
 private:
 	void run();
 
@@ -19,6 +19,7 @@ ZlibInflate::ZlibInflate(span<const uint8_t> input)
 	s.opaque = nullptr;
 	s.next_in  = const_cast<uint8_t*>(input.data());
 	s.avail_in = inputLen;
+	start = input.data();
 	wasInit = false;
 }
 
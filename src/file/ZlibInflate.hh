@@ -22,10 +22,14 @@ public:
 	[[nodiscard]] std::string getString(size_t len);
 	[[nodiscard]] std::string getCString();
 
+	/** Number of input bytes consumed so far (by the methods above). */
+	[[nodiscard]] size_t getInputPos() const { return size_t(s.next_in - start); }
+
 	[[nodiscard]] size_t inflate(MemBuffer<uint8_t>& output, size_t sizeHint = 65536);
 
 private:
 	z_stream s;
+	const uint8_t* start;
 	bool wasInit;
 };
 
@@ -10,9 +10,12 @@
 #include "GlobalSettings.hh"
 #include "MSXException.hh"
 #include "Timer.hh"
+#include "FileOperations.hh"
 #include "serialize.hh"
+#include "sha1.hh"
 #include "tiger.hh"
 #include <cassert>
+#include <cstring>
 #include <memory>
 
 namespace openmsx {
@@ -57,6 +60,10 @@ HD::HD(const DeviceConfig& config)
 		filesize = file.getSize();
 	}
 	tigerTree.emplace(*this, filesize, filename.getResolved());
+	loadTigerTree();
+	if (config.getChildDataAsBool("overlay", false)) {
+		enableOverlay();
+	}
 
 	(*hdInUse)[id] = true;
 	hdCommand.emplace(
@@ -71,6 +78,12 @@ HD::HD(const DeviceConfig& config)
 
 HD::~HD()
 {
+	try {
+		flushWrites();
+	} catch (MSXException& e) {
+		motherBoard.getMSXCliComm().printWarning(e.getMessage());
+	}
+	saveTigerTree();
 	motherBoard.getMSXCliComm().update(CliComm::HARDWARE, name, "remove");
 
 	unsigned id = name[2] - 'a';
@@ -80,10 +93,17 @@ HD::~HD()
 
 void HD::switchImage(const Filename& newFilename)
 {
+	flushWrites();
+	saveTigerTree();
+	if (auto* o = getOverlay()) {
+		// the written sectors belonged to the old image
+		*o = SectorOverlay();
+	}
 	file = File(newFilename);
 	filename = newFilename;
 	filesize = file.getSize();
 	tigerTree.emplace(*this, filesize, filename.getResolved());
+	loadTigerTree();
 	motherBoard.getMSXCliComm().update(CliComm::MEDIA, getName(),
 	                                   filename.getResolved());
 }
@@ -96,18 +116,97 @@ size_t HD::getNbSectorsImpl() const
 void HD::readSectorsImpl(
 	SectorBuffer* buffers, size_t startSector, size_t num)
 {
+	std::lock_guard lock(ioMutex);
 	file.seek(startSector * sizeof(SectorBuffer));
 	file.read(buffers, num * sizeof(SectorBuffer));
+
+	// overwrite with sectors that are not yet written to the file
+	for (auto it = dirty.lower_bound(startSector);
+	     (it != dirty.end()) && (it->first < (startSector + num)); ++it) {
+		buffers[it->first - startSector] = it->second;
+	}
+
+	// sequential access: read ahead in the background
+	if (startSector == nextSector) {
+		file.prefetch((startSector + num) * sizeof(SectorBuffer), READAHEAD);
+	}
+	nextSector = startSector + num;
 }
 
 void HD::writeSectorImpl(size_t sector, const SectorBuffer& buf)
 {
-	file.seek(sector * sizeof(buf));
-	file.write(&buf, sizeof(buf));
-	tigerTree->notifyChange(sector * sizeof(buf), sizeof(buf),
+	std::unique_lock lock(ioMutex);
+	if (!writeError.empty()) {
+		// report errors of earlier (background) writes
+		auto error = std::move(writeError);
+		writeError.clear();
+		throw MSXException(std::move(error));
+	}
+	dirty[sector] = buf;
+	if (!writeBackPosted) {
+		writeBackPosted = true;
+		writer.post([this] { writeBack(); });
+	}
+	bool full = dirty.size() > MAX_DIRTY;
+	lock.unlock();
+
+	written = true;
+	// The actual modification time is only known after the write, it's
+	// updated in flushWrites().
+	tigerTree->notifyChange(sector * sizeof(buf), sizeof(buf), 0);
+	if (full) {
+		// The host disk can't keep up, wait till it did.
+		writer.wait();
+	}
+}
+
+void HD::overlayWritten(size_t sector)
+{
+	// the file itself didn't change
+	tigerTree->notifyChange(sector * sizeof(SectorBuffer), sizeof(SectorBuffer),
 	                        file.getModificationDate());
 }
 
+// Executed on the 'writer' thread.
+void HD::writeBack()
+{
+	std::unique_lock lock(ioMutex);
+	while (!dirty.empty()) {
+		// Write one sector at a time and release the lock in between,
+		// so that reads on the emulation thread never wait long.
+		auto it = dirty.begin();
+		try {
+			file.seek(it->first * sizeof(SectorBuffer));
+			file.write(&it->second, sizeof(SectorBuffer));
+		} catch (MSXException& e) {
+			if (writeError.empty()) writeError = e.getMessage();
+		}
+		dirty.erase(it);
+		lock.unlock();
+		lock.lock();
+	}
+	writeBackPosted = false;
+}
+
+// Wait till all pending writes are in the file. Must be called before 'file'
+// is accessed directly (not via readSectorsImpl()) or replaced.
+void HD::flushWrites()
+{
+	writer.wait(); // after this there's no need to lock 'ioMutex'
+	assert(dirty.empty());
+	if (written) {
+		written = false;
+		file.flush();
+		tigerTree->notifyChange(0, 0, file.getModificationDate());
+	}
+	if (!writeError.empty()) {
+		auto error = std::move(writeError);
+		writeError.clear();
+		throw MSXException("Error writing harddisk image ",
+		                   filename.getResolved(), ": ", error);
+	}
+}
+
 bool HD::isWriteProtectedImpl() const
 {
 	return file.isReadOnly();
@@ -115,9 +214,10 @@ bool HD::isWriteProtectedImpl() const
 
 Sha1Sum HD::getSha1SumImpl(FilePool& filePool)
 {
-	if (hasPatches()) {
+	if (hasPatches() || (getOverlay() && !getOverlay()->empty())) {
 		return SectorAccessibleDisk::getSha1SumImpl(filePool);
 	}
+	flushWrites();
 	return filePool.getSha1Sum(file);
 }
 
@@ -145,7 +245,90 @@ std::string HD::getTigerTreeHash()
 	lastProgressTime = Timer::getTime();
 	everDidProgress = false;
 	auto callback = [this](size_t p, size_t t) { showProgress(p, t); };
-	return tigerTree->calcHash(callback).toString(); // calls HD::getData()
+	auto result = tigerTree->calcHash(callback).toString(); // calls HD::getData()
+	tthUnsaved = true;
+	if (everDidProgress && !written) {
+		// This took a while, don't risk losing the result.
+		saveTigerTree();
+	}
+	return result;
+}
+
+// The (partially) calculated tiger-tree is stored between sessions, so that
+// the (slow) initial calculation for a big harddisk image is only needed once.
+// The cache is only used when the image has the same size and modification
+// time as when the cache was written.
+struct TigerTreeCacheHeader {
+	char magic[8];
+	uint32_t version;
+	uint32_t byteOrder;
+	uint64_t dataSize;
+	int64_t time;
+};
+static constexpr char TTH_CACHE_MAGIC[8] = {'o', 'M', 'S', 'X', 't', 't', 'h', '\x1a'};
+static constexpr uint32_t TTH_CACHE_VERSION = 1;
+static constexpr uint32_t TTH_CACHE_BYTE_ORDER = 0x01020304;
+
+std::string HD::getTigerTreeCacheName() const
+{
+	const auto& path = filename.getResolved();
+	auto sum = SHA1::calc({reinterpret_cast<const uint8_t*>(path.data()), path.size()});
+	return strCat(FileOperations::getUserDataDir(), "/tthcache/", sum.toString());
+}
+
+void HD::loadTigerTree()
+{
+	try {
+		auto time = file.getModificationDate();
+		File cache(getTigerTreeCacheName());
+		auto data = cache.mmap();
+		if (data.size() < sizeof(TigerTreeCacheHeader)) return;
+		TigerTreeCacheHeader header;
+		memcpy(&header, data.data(), sizeof(header));
+		if ((memcmp(header.magic, TTH_CACHE_MAGIC, sizeof(header.magic)) != 0) ||
+		    (header.version != TTH_CACHE_VERSION) ||
+		    (header.byteOrder != TTH_CACHE_BYTE_ORDER) ||
+		    (header.dataSize != filesize) ||
+		    (header.time != int64_t(time))) {
+			return;
+		}
+		(void)tigerTree->loadState(data.subspan(sizeof(header)), time);
+	} catch (MSXException&) {
+		// no (valid) cache, ignore
+	}
+}
+
+// Must be called after flushWrites(), so that the modification time of the
+// file is final.
+void HD::saveTigerTree()
+{
+	if (!tthUnsaved || !file.is_open()) return;
+	// the tree also covers the (not persistent) overlay
+	if (auto* o = getOverlay(); o && !o->empty()) return;
+	tthUnsaved = false;
+	try {
+		TigerTreeCacheHeader header;
+		memcpy(header.magic, TTH_CACHE_MAGIC, sizeof(header.magic));
+		header.version = TTH_CACHE_VERSION;
+		header.byteOrder = TTH_CACHE_BYTE_ORDER;
+		header.dataSize = filesize;
+		header.time = int64_t(file.getModificationDate());
+		auto state = tigerTree->saveState();
+
+		auto cacheName = getTigerTreeCacheName();
+		FileOperations::mkdirp(std::string(FileOperations::getDirName(cacheName)));
+		auto tmpName = strCat(cacheName, ".tmp");
+		{
+			File cache(tmpName, File::TRUNCATE);
+			cache.write(&header, sizeof(header));
+			cache.write(state.data(), state.size());
+		}
+		if (FileOperations::rename(tmpName, cacheName) != 0) {
+			FileOperations::unlink(tmpName);
+		}
+	} catch (MSXException&) {
+		// can't write cache, ignore
+	}
 }
 
 uint8_t* HD::getData(size_t offset, size_t size)
@@ -202,9 +385,14 @@ int HD::insertDisk(const std::string& newFilename)
 
 // version 1: initial version
 // version 2: replaced 'checksum'(=sha1) with 'tthsum`
+// version 3: added copy-on-write overlay
 template<typename Archive>
 void HD::serialize(Archive& ar, unsigned version)
 {
+	// savestates (and the hash check below) should see the file as the
+	// MSX sees it
+	flushWrites();
+
 	Filename tmp = file.is_open() ? filename : Filename();
 	ar.serialize("filename", tmp);
 	if constexpr (Archive::IS_LOADER) {
@@ -233,6 +421,29 @@ void HD::serialize(Archive& ar, unsigned version)
 		}
 	}
 
+	if (ar.versionAtLeast(version, 3)) {
+		bool useOverlay = hasOverlay();
+		ar.serialize("overlay", useOverlay);
+		if (useOverlay) {
+			if constexpr (Archive::IS_LOADER) {
+				enableOverlay();
+				// both the old and the new overlay sectors (may) differ
+				// from what the tiger-tree has seen
+				auto notify = [&] {
+					if (!file.is_open()) return;
+					for (auto sector : getOverlay()->getSectors()) {
+						overlayWritten(sector);
+					}
+				};
+				notify();
+				ar.serialize("overlayData", *getOverlay());
+				notify();
+			} else {
+				ar.serialize("overlayData", *getOverlay());
+			}
+		}
+	}
+
 	// store/check checksum
 	if (file.is_open()) {
 		bool mismatch = false;
@@ -7,8 +7,11 @@
 #include "HDCommand.hh"
 #include "SectorAccessibleDisk.hh"
 #include "TigerTree.hh"
+#include "WorkerPool.hh"
 #include "serialize_meta.hh"
 #include <bitset>
+#include <map>
+#include <mutex>
 #include <string>
 #include <optional>
 
@@ -43,6 +46,7 @@ private:
 	[[nodiscard]] size_t getNbSectorsImpl() const override;
 	[[nodiscard]] bool isWriteProtectedImpl() const override;
 	[[nodiscard]] Sha1Sum getSha1SumImpl(FilePool& filePool) override;
+	void overlayWritten(size_t sector) override;
 
 	// Diskcontainer:
 	[[nodiscard]] SectorAccessibleDisk* getSectorAccessibleDisk() override;
@@ -56,6 +60,13 @@ private:
 
 	void showProgress(size_t position, size_t maxPosition);
 
+	void writeBack();
+	void flushWrites();
+
+	[[nodiscard]] std::string getTigerTreeCacheName() const;
+	void loadTigerTree();
+	void saveTigerTree();
+
 private:
 	MSXMotherBoard& motherBoard;
 	std::string name;
@@ -65,6 +76,8 @@ private:
 	File file;
 	Filename filename;
 	size_t filesize;
+	size_t nextSector = 0; // sector after the last read, to detect sequential access
+	static constexpr size_t READAHEAD = 256 * 1024; // in bytes
 
 	static constexpr unsigned MAX_HD = 26;
 	using HDInUse = std::bitset<MAX_HD>;
@@ -72,10 +85,25 @@ private:
 
 	uint64_t lastProgressTime;
 	bool everDidProgress;
+	bool tthUnsaved = false; // tigerTree calculated since last saveTigerTree()
+
+	// Write-back cache: sectors written by the MSX that are not yet
+	// written to 'file'. That's done by the 'writer' thread, so that
+	// (slow) disk writes don't stall the emulation. Reads take these
+	// sectors into account, so the emulation doesn't see a difference.
+	// While there are pending writes, 'file', 'dirty', 'writeError' and
+	// 'writeBackPosted' are protected by 'ioMutex'.
+	std::map<size_t, SectorBuffer> dirty;
+	std::mutex ioMutex;
+	std::string writeError; // first error (if any) of the writer thread
+	bool writeBackPosted = false;
+	bool written = false; // any writes since the last flushWrites()
+	static constexpr size_t MAX_DIRTY = 4096; // sectors (2MB)
+	WorkerPool writer{1}; // must be last, see ~WorkerPool()
 };
 
 REGISTER_BASE_CLASS(HD, "HD");
-SERIALIZE_CLASS_VERSION(HD, 2);
+SERIALIZE_CLASS_VERSION(HD, 3);
 
 } // namespace openmsx
 
@@ -7,7 +7,6 @@
 #include "endian.hh"
 #include "serialize.hh"
 #include "strCat.hh"
-#include "xrange.hh"
 #include <cassert>
 
 namespace openmsx {
@@ -63,8 +62,8 @@ unsigned IDEHD::readBlockStart(AlignedBuffer& buf, unsigned count)
 	try {
 		assert(count >= 512);
 		(void)count; // avoid warning
-		readSector(transferSectorNumber,
-		           *aligned_cast<SectorBuffer*>(buf));
+		readAhead.read(*this, transferSectorNumber, transferEndSector,
+		               *aligned_cast<SectorBuffer*>(buf));
 		++transferSectorNumber;
 		return 512;
 	} catch (MSXException&) {
@@ -78,10 +77,8 @@ void IDEHD::writeBlockComplete(AlignedBuffer& buf, unsigned count)
 	try {
 		assert((count % 512) == 0);
 		unsigned num = count / 512;
-		for (auto i : xrange(num)) {
-			writeSector(transferSectorNumber++,
-			            *aligned_cast<SectorBuffer*>(buf + 512 * i));
-		}
+		writeSectors(aligned_cast<SectorBuffer*>(buf), transferSectorNumber, num);
+		transferSectorNumber += num;
 	} catch (MSXException&) {
 		abortWriteTransfer(UNC);
 	}
@@ -109,6 +106,8 @@ void IDEHD::executeCommand(byte cmd)
 			break;
 		}
 		transferSectorNumber = sectorNumber;
+		transferEndSector = sectorNumber + numSectors;
+		readAhead.invalidate();
 		if (cmd < 0x30) {
 			startLongReadTransfer(numSectors * 512);
 		} else {
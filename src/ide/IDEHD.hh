@@ -3,6 +3,7 @@
 
 #include "HD.hh"
 #include "AbstractIDEDevice.hh"
+#include "SectorReadAhead.hh"
 
 namespace openmsx {
 
@@ -33,6 +34,11 @@ private:
 private:
 	DiskManipulator& diskManipulator;
 	unsigned transferSectorNumber;
+
+	// The ATA buffer holds one sector, but fetch the sectors of a read
+	// command in bigger chunks from the image.
+	SectorReadAhead readAhead{32};
+	unsigned transferEndSector = 0; // not serialized, only for readAhead
 };
 
 } // namespace openmsx
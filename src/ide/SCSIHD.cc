@@ -28,7 +28,6 @@
 #include "endian.hh"
 #include "one_of.hh"
 #include "serialize.hh"
-#include "xrange.hh"
 #include <algorithm>
 #include <cstring>
 
@@ -278,12 +277,11 @@ unsigned SCSIHD::readSectors(unsigned& blocks)
 	unsigned counter = currentLength * SECTOR_SIZE;
 
 	try {
-		for (auto i : xrange(numSectors)) {
-			auto* sbuf = aligned_cast<SectorBuffer*>(buffer);
-			readSector(currentSector, sbuf[i]);
-			++currentSector;
-			--currentLength;
-		}
+		// one disk access for the whole buffer
+		auto* sbuf = aligned_cast<SectorBuffer*>(buffer);
+		SectorAccessibleDisk::readSectors(sbuf, currentSector, numSectors);
+		currentSector += numSectors;
+		currentLength -= numSectors;
 		blocks = currentLength;
 		return counter;
 	} catch (MSXException&) {
@@ -312,12 +310,10 @@ unsigned SCSIHD::writeSectors(unsigned& blocks)
 	unsigned numSectors = std::min(currentLength, BUFFER_BLOCK_SIZE);
 
 	try {
-		for (auto i : xrange(numSectors)) {
-			const auto* sbuf = aligned_cast<const SectorBuffer*>(buffer);
-			writeSector(currentSector, sbuf[i]);
-			++currentSector;
-			--currentLength;
-		}
+		const auto* sbuf = aligned_cast<const SectorBuffer*>(buffer);
+		SectorAccessibleDisk::writeSectors(sbuf, currentSector, numSectors);
+		currentSector += numSectors;
+		currentLength -= numSectors;
 
 		unsigned tmp = std::min(currentLength, BUFFER_BLOCK_SIZE);
 		blocks = currentLength - tmp;
@@ -4,16 +4,20 @@
 #include "ReverseManager.hh"
 #include "Event.hh"
 #include "Timer.hh"
+#include "TclObject.hh"
 #include "MSXException.hh"
 #include "one_of.hh"
+#include "outer.hh"
 #include "ranges.hh"
 #include "stl.hh"
+#include <algorithm>
 #include <cassert>
 
 namespace openmsx {
 
 EventDelay::EventDelay(Scheduler& scheduler_,
                        CommandController& commandController,
+                       InfoCommand& machineInfoCommand,
                        EventDistributor& eventDistributor_,
                        MSXEventDistributor& msxEventDistributor_,
                        ReverseManager& reverseManager)
@@ -25,7 +29,15 @@ EventDelay::EventDelay(Scheduler& scheduler_,
 	, delaySetting(
 		commandController, "inputdelay",
 		"delay input to avoid key-skips", 0.0, 0.0, 10.0)
+	, lowLatencySetting(
+		commandController, "low_latency_input",
+		"pass input to the MSX as soon as possible, ignores 'inputdelay'",
+		false)
+	, latencyInfo(machineInfoCommand)
 {
+	delaySetting.attach(*this);
+	lowLatencySetting.attach(*this);
+
 	eventDistributor.registerEventListener(
 		EventType::KEY_DOWN, *this, EventDistributor::MSX);
 	eventDistributor.registerEventListener(
@@ -47,11 +59,17 @@ EventDelay::EventDelay(Scheduler& scheduler_,
 	eventDistributor.registerEventListener(
 		EventType::JOY_BUTTON_UP,   *this, EventDistributor::MSX);
 
+	eventDistributor.registerEventListener(
+		EventType::FRAME_DRAWN, *this);
+
 	reverseManager.registerEventDelay(*this);
 }
 
 EventDelay::~EventDelay()
 {
+	eventDistributor.unregisterEventListener(
+		EventType::FRAME_DRAWN, *this);
+
 	eventDistributor.unregisterEventListener(
 		EventType::KEY_DOWN, *this);
 	eventDistributor.unregisterEventListener(
@@ -72,12 +90,24 @@ EventDelay::~EventDelay()
 		EventType::JOY_BUTTON_DOWN, *this);
 	eventDistributor.unregisterEventListener(
 		EventType::JOY_BUTTON_UP,   *this);
+
+	lowLatencySetting.detach(*this);
+	delaySetting.detach(*this);
 }
 
 int EventDelay::signalEvent(const Event& event) noexcept
 {
+	if (getType(event) == EventType::FRAME_DRAWN) {
+		if (latencyPending) {
+			auto latency = Timer::getTime() - latencyStart;
+			inputLatency.add(uint32_t(std::min<uint64_t>(latency, 0xFFFFFFFF)));
+			latencyPending = false;
+		}
+		return 0;
+	}
+
 	toBeScheduledEvents.push_back(event);
-	if (delaySetting.getDouble() == 0.0) {
+	if (isLowLatency() || (delaySetting.getDouble() == 0.0)) {
 		sync(getCurrentTime());
 	}
 	return 0;
@@ -92,7 +122,7 @@ void EventDelay::sync(EmuTime::param curEmu)
 	prevEmu = curEmu;
 
 	double factor = emuDuration.toDouble() / realDuration;
-	EmuDuration extraDelay(delaySetting.getDouble());
+	EmuDuration extraDelay(isLowLatency() ? 0.0 : delaySetting.getDouble());
 
 #if PLATFORM_ANDROID
 	// The virtual keyboard on Android sends a key press and the
@@ -175,6 +205,10 @@ void EventDelay::executeUntil(EmuTime::param time)
 	try {
 		auto event = std::move(scheduledEvents.front());
 		scheduledEvents.pop_front();
+		if (!latencyPending) {
+			latencyStart = get<TimedEvent>(event).getRealTime();
+			latencyPending = true;
+		}
 		msxEventDistributor.distributeEvent(std::move(event), time);
 	} catch (MSXException&) {
 		// ignore
@@ -196,6 +230,48 @@ void EventDelay::flush()
 	toBeScheduledEvents.clear();
 
 	removeSyncPoints();
+	latencyPending = false;
+}
+
+void EventDelay::update(const Setting& /*setting*/) noexcept
+{
+	// start measuring again for the new settings
+	resetLatency();
+}
+
+void EventDelay::resetLatency()
+{
+	inputLatency.clear();
+	latencyPending = false;
+}
+
+
+// class LatencyInfo
+
+EventDelay::LatencyInfo::LatencyInfo(InfoCommand& machineInfoCommand)
+	: InfoTopic(machineInfoCommand, "input_latency")
+{
+}
+
+void EventDelay::LatencyInfo::execute(
+	span<const TclObject> /*tokens*/, TclObject& result) const
+{
+	const auto& histogram = OUTER(EventDelay, latencyInfo).inputLatency;
+	auto count = histogram.getCount();
+	result.addDictKeyValues(
+		"count", int64_t(count),
+		"min", int64_t(histogram.getMin()),
+		"max", int64_t(histogram.getMax()),
+		"average", count ? int64_t(histogram.getSum() / count) : int64_t(0));
+}
+
+std::string EventDelay::LatencyInfo::help(span<const TclObject> /*tokens*/) const
+{
+	return "Returns a dict with the measured input-to-display latency in\n"
+	       "microseconds: the time between a host input event and the first\n"
+	       "frame that's drawn after that event was passed to the MSX. The\n"
+	       "measurement restarts when 'inputdelay' or 'low_latency_input'\n"
+	       "changes.\n";
 }
 
 } // namespace openmsx
@@ -6,6 +6,10 @@
 #include "EmuTime.hh"
 #include "Event.hh"
 #include "FloatSetting.hh"
+#include "BooleanSetting.hh"
+#include "InfoTopic.hh"
+#include "LatencyHistogram.hh"
+#include "Observer.hh"
 #include "build-info.hh"
 #include <vector>
 #include <deque>
@@ -16,17 +20,27 @@ namespace openmsx {
 class Scheduler;
 class CommandController;
 class EventDistributor;
+class InfoCommand;
 class MSXEventDistributor;
 class ReverseManager;
 
 /** This class is responsible for translating host events into MSX events.
   * It also translates host event timing into EmuTime. To better do this
-  * we introduce a small delay (default 0.03s) in this translation.
+  * we can introduce a small delay (setting 'inputdelay') in this
+  * translation.
+  *
+  * Alternatively, in low latency mode, host events are passed to the MSX as
+  * soon as possible (at the next CPU instruction), and RealTime polls for
+  * host events again right after it slept (so for events that arrived
+  * during that sleep we don't have to wait till the next frame has been
+  * emulated).
   */
 class EventDelay final : private EventListener, private Schedulable
+                       , private Observer<Setting>
 {
 public:
 	EventDelay(Scheduler& scheduler, CommandController& commandController,
+	           InfoCommand& machineInfoCommand,
 	           EventDistributor& eventDistributor,
 	           MSXEventDistributor& msxEventDistributor,
 	           ReverseManager& reverseManager);
@@ -35,6 +49,10 @@ public:
 	void sync(EmuTime::param curEmu);
 	void flush();
 
+	[[nodiscard]] bool isLowLatency() const {
+		return lowLatencySetting.getBoolean();
+	}
+
 private:
 	// EventListener
 	int signalEvent(const Event& event) noexcept override;
@@ -42,6 +60,11 @@ private:
 	// Schedulable
 	void executeUntil(EmuTime::param time) override;
 
+	// Observer<Setting>
+	void update(const Setting& setting) noexcept override;
+
+	void resetLatency();
+
 private:
 	EventDistributor& eventDistributor;
 	MSXEventDistributor& msxEventDistributor;
@@ -56,6 +79,21 @@ private:
 	EmuTime prevEmu;
 	uint64_t prevReal;
 	FloatSetting delaySetting;
+	BooleanSetting lowLatencySetting;
+
+	// Input-to-display latency (in us): from the (real) time of a host
+	// event till the next frame is drawn after that event was passed to
+	// the MSX.
+	LatencyHistogram inputLatency;
+	uint64_t latencyStart = 0;
+	bool latencyPending = false;
+
+	struct LatencyInfo final : InfoTopic {
+		explicit LatencyInfo(InfoCommand& machineInfoCommand);
+		void execute(span<const TclObject> tokens,
+		             TclObject& result) const override;
+		[[nodiscard]] std::string help(span<const TclObject> tokens) const override;
+	} latencyInfo;
 };
 
 } // namespace openmsx
@@ -6,6 +6,7 @@
 #include "Event.hh"
 #include "InputEventGenerator.hh"
 #include "StateChange.hh"
+#include "StateChangeCodec.hh"
 #include "TclObject.hh"
 #include "GlobalSettings.hh"
 #include "IntegerSetting.hh"
@@ -15,6 +16,8 @@
 #include "serialize_meta.hh"
 #include "StringOp.hh"
 #include "one_of.hh"
+#include "ranges.hh"
+#include "unreachable.hh"
 #include "xrange.hh"
 #include <memory>
 
@@ -71,6 +74,22 @@ public:
 	[[nodiscard]] byte     getPress()    const { return press; }
 	[[nodiscard]] byte     getRelease()  const { return release; }
 
+	// compact encoding, see StateChangeCodec
+	static constexpr auto COMPACT_TAG = StateChangeCodec::JOYSTICK;
+	static constexpr unsigned NUM_COMPACT_VALUES = 3;
+	[[nodiscard]] uint8_t getCompactTag() const override { return COMPACT_TAG; }
+	void getCompactValues(CompactValues& values) const override {
+		values = {int32_t(joyNum), press, release};
+	}
+	[[nodiscard]] static std::unique_ptr<StateChange> fromCompact(
+		EmuTime::param time, span<const int32_t> v)
+	{
+		StateChangeCodec::checkPressRelease(v[1], v[2]);
+		return std::make_unique<JoyState>(
+			time, unsigned(StateChangeCodec::checkRange(v[0], 0, 255)),
+			byte(v[1]), byte(v[2]));
+	}
+
 	template<typename Archive> void serialize(Archive& ar, unsigned /*version*/)
 	{
 		ar.template serializeBase<StateChange>(*this);
@@ -83,6 +102,7 @@ private:
 	byte press, release;
 };
 REGISTER_POLYMORPHIC_CLASS(StateChange, JoyState, "JoyState");
+static const StateChangeCodec::Registration<JoyState> joyStateCodec;
 
 
 #ifndef SDL_JOYSTICK_DISABLED
@@ -167,12 +187,15 @@ Joystick::Joystick(MSXEventDistributor& eventDistributor_,
 	auto& interp = commandController.getInterpreter();
 	configSetting.setChecker([&interp](TclObject& newValue) {
 		checkJoystickConfig(interp, newValue); });
+	parseConfig();
+	configSetting.attach(*this);
 
 	pin8 = false; // avoid UMR
 }
 
 Joystick::~Joystick()
 {
+	configSetting.detach(*this);
 	if (isPluggedIn()) {
 		Joystick::unplugHelper(EmuTime::dummy());
 	}
@@ -225,80 +248,109 @@ void Joystick::write(byte value, EmuTime::param /*time*/)
 	pin8 = (value & 0x04) != 0;
 }
 
+void Joystick::parseConfig()
+{
+	bindings.clear();
+	auto& interp = configSetting.getInterpreter();
+	const auto& dict = configSetting.getValue();
+	static constexpr std::pair<std::string_view, byte> keys[] = {
+		{"A",     JOY_BUTTONA},
+		{"B",     JOY_BUTTONB},
+		{"UP",    JOY_UP},
+		{"DOWN",  JOY_DOWN},
+		{"LEFT",  JOY_LEFT},
+		{"RIGHT", JOY_RIGHT},
+	};
+	static constexpr std::pair<std::string_view, uint8_t> hats[] = {
+		{"L_hat", SDL_HAT_LEFT},
+		{"R_hat", SDL_HAT_RIGHT},
+		{"U_hat", SDL_HAT_UP},
+		{"D_hat", SDL_HAT_DOWN},
+	};
+	for (const auto& [key, msxBits] : keys) {
+		try {
+			const auto& list = dict.getDictValue(interp, key);
+			for (auto i : xrange(list.getListLength(interp))) {
+				const auto& elem = list.getListIndex(interp, i).getString();
+				auto add = [&](Binding::Kind kind, size_t len, uint8_t hatDir = 0) {
+					if (auto n = StringOp::stringToBase<10, unsigned>(elem.substr(len))) {
+						bindings.push_back({kind, hatDir, msxBits, *n});
+					}
+				};
+				if (StringOp::startsWith(elem, "button")) {
+					add(Binding::BUTTON, 6);
+				} else if (StringOp::startsWith(elem, "+axis")) {
+					add(Binding::POS_AXIS, 5);
+				} else if (StringOp::startsWith(elem, "-axis")) {
+					add(Binding::NEG_AXIS, 5);
+				} else {
+					for (const auto& [prefix, dir] : hats) {
+						if (StringOp::startsWith(elem, prefix)) {
+							add(Binding::HAT, 5, dir);
+						}
+					}
+				}
+			}
+		} catch (...) {
+			// Error, in getListLength() or getListIndex().
+			// In either case we can't do anything about it here, so ignore.
+		}
+	}
+}
+
 byte Joystick::calcState()
 {
 	byte result = JOY_UP | JOY_DOWN | JOY_LEFT | JOY_RIGHT |
 	              JOY_BUTTONA | JOY_BUTTONB;
 	if (joystick) {
 		int threshold = (deadSetting.getInt() * 32768) / 100;
-		auto& interp = configSetting.getInterpreter();
-		const auto& dict   = configSetting.getValue();
-		if (getState(interp, dict, "A"    , threshold)) result &= ~JOY_BUTTONA;
-		if (getState(interp, dict, "B"    , threshold)) result &= ~JOY_BUTTONB;
-		if (getState(interp, dict, "UP"   , threshold)) result &= ~JOY_UP;
-		if (getState(interp, dict, "DOWN" , threshold)) result &= ~JOY_DOWN;
-		if (getState(interp, dict, "LEFT" , threshold)) result &= ~JOY_LEFT;
-		if (getState(interp, dict, "RIGHT", threshold)) result &= ~JOY_RIGHT;
+		for (const auto& b : bindings) {
+			if (!(result & b.msxBits)) continue; // already pressed
+			bool pressed = [&] {
+				switch (b.kind) {
+				case Binding::BUTTON:
+					return InputEventGenerator::joystickGetButton(joystick, b.index);
+				case Binding::POS_AXIS:
+					return SDL_JoystickGetAxis(joystick, b.index) > threshold;
+				case Binding::NEG_AXIS:
+					return SDL_JoystickGetAxis(joystick, b.index) < -threshold;
+				case Binding::HAT:
+					return (SDL_JoystickGetHat(joystick, b.index) & b.hatDir) != 0;
+				default:
+					UNREACHABLE; return false;
+				}
+			}();
+			if (pressed) result &= ~b.msxBits;
+		}
 	}
 	return result;
 }
 
-bool Joystick::getState(Interpreter& interp, const TclObject& dict,
-                        std::string_view key, int threshold)
+// Does the event involve a host button/axis/hat that's mapped to the MSX
+// joystick? E.g. (noisy) analog axes that are not used don't need to
+// recalculate the state.
+bool Joystick::isBound(const Event& event) const
 {
-	try {
-		const auto& list = dict.getDictValue(interp, key);
-		for (auto i : xrange(list.getListLength(interp))) {
-			const auto& elem = list.getListIndex(interp, i).getString();
-			if (StringOp::startsWith(elem, "button")) {
-				if (auto n = StringOp::stringToBase<10, unsigned>(elem.substr(6))) {
-					if (InputEventGenerator::joystickGetButton(joystick, *n)) {
-						return true;
-					}
-				}
-			} else if (StringOp::startsWith(elem, "+axis")) {
-				if (auto n = StringOp::stringToBase<10, unsigned>(elem.substr(5))) {
-					if (SDL_JoystickGetAxis(joystick, *n) > threshold) {
-						return true;
-					}
-				}
-			} else if (StringOp::startsWith(elem, "-axis")) {
-				if (auto n = StringOp::stringToBase<10, unsigned>(elem.substr(5))) {
-					if (SDL_JoystickGetAxis(joystick, *n) < -threshold) {
-						return true;
-					}
-				}
-			} else if (StringOp::startsWith(elem, "L_hat")) {
-				if (auto n = StringOp::stringToBase<10, unsigned>(elem.substr(5))) {
-					if (SDL_JoystickGetHat(joystick, *n) & SDL_HAT_LEFT) {
-						return true;
-					}
-				}
-			} else if (StringOp::startsWith(elem, "R_hat")) {
-				if (auto n = StringOp::stringToBase<10, unsigned>(elem.substr(5))) {
-					if (SDL_JoystickGetHat(joystick, *n) & SDL_HAT_RIGHT) {
-						return true;
-					}
-				}
-			} else if (StringOp::startsWith(elem, "U_hat")) {
-				if (auto n = StringOp::stringToBase<10, unsigned>(elem.substr(5))) {
-					if (SDL_JoystickGetHat(joystick, *n) & SDL_HAT_UP) {
-						return true;
-					}
-				}
-			} else if (StringOp::startsWith(elem, "D_hat")) {
-				if (auto n = StringOp::stringToBase<10, unsigned>(elem.substr(5))) {
-					if (SDL_JoystickGetHat(joystick, *n) & SDL_HAT_DOWN) {
-						return true;
-					}
-				}
-			}
-		}
-	} catch (...) {
-		// Error, in getListLength() or getListIndex().
-		// In either case we can't do anything about it here, so ignore.
-	}
-	return false;
+	auto bound = [&](auto pred) { return ranges::any_of(bindings, pred); };
+	return visit(overloaded{
+		[&](const JoystickButtonEvent& e) {
+			return bound([&](const Binding& b) {
+				return (b.kind == Binding::BUTTON) && (b.index == e.getButton());
+			});
+		},
+		[&](const JoystickAxisMotionEvent& e) {
+			return bound([&](const Binding& b) {
+				return (b.kind == one_of(Binding::POS_AXIS, Binding::NEG_AXIS)) &&
+				       (b.index == e.getAxis());
+			});
+		},
+		[&](const JoystickHatEvent& e) {
+			return bound([&](const Binding& b) {
+				return (b.kind == Binding::HAT) && (b.index == e.getHat());
+			});
+		},
+		[](const EventBase&) { return true; }
+	}, event);
 }
 
 // MSXEventListener
@@ -312,13 +364,10 @@ void Joystick::signalMSXEvent(const Event& event,
 	//       sending the event to all joysticks.
 	if (joyEvent->getJoystick() != joyNum) return;
 
-	// TODO: Currently this recalculates the whole joystick state. It might
-	// be possible to implement this more efficiently by using the specific
-	// event information. Though that's not trivial because e.g. multiple
-	// host buttons can map to the same MSX button. Also calcState()
-	// involves some string processing. It might be possible to only parse
-	// the config once (per setting change). Though this solution is likely
-	// good enough.
+	// Recalculate the whole joystick state (multiple host buttons can
+	// map to the same MSX button), createEvent() filters out events that
+	// don't change it.
+	if (!isBound(event)) return;
 	createEvent(time, calcState());
 }
 
@@ -357,6 +406,12 @@ void Joystick::stopReplay(EmuTime::param time) noexcept
 	createEvent(time, calcState());
 }
 
+// Observer<Setting>
+void Joystick::update(const Setting& /*setting*/) noexcept
+{
+	parseConfig();
+}
+
 // version 1: Initial version, the variable status was not serialized.
 // version 2: Also serialize the above variable, this is required for
 //            record/replay, see comment in Keyboard.cc for more details.
@@ -5,8 +5,11 @@
 #include "MSXEventListener.hh"
 #include "StateChangeListener.hh"
 #include "StringSetting.hh"
+#include "Observer.hh"
 #include "serialize_meta.hh"
 #include <SDL.h>
+#include <cstdint>
+#include <vector>
 
 namespace openmsx {
 
@@ -24,6 +27,7 @@ class Interpreter;
 class Joystick final
 #ifndef SDL_JOYSTICK_DISABLED
 	: public JoystickDevice, private MSXEventListener, private StateChangeListener
+	, private Observer<Setting>
 #endif
 {
 public:
@@ -63,8 +67,8 @@ public:
 private:
 	void plugHelper2();
 	[[nodiscard]] byte calcState();
-	[[nodiscard]] bool getState(Interpreter& interp, const TclObject& dict, std::string_view key,
-	                            int threshold);
+	void parseConfig();
+	[[nodiscard]] bool isBound(const Event& event) const;
 	void createEvent(EmuTime::param time, byte newStatus);
 
 	// MSXEventListener
@@ -73,6 +77,8 @@ private:
 	// StateChangeListener
 	void signalStateChange(const StateChange& event) override;
 	void stopReplay(EmuTime::param time) noexcept override;
+	// Observer<Setting>
+	void update(const Setting& setting) noexcept override;
 
 private:
 	MSXEventDistributor& eventDistributor;
@@ -85,6 +91,16 @@ private:
 	const std::string desc;
 	StringSetting configSetting;
 
+	// 'configSetting' parsed (once per change instead of on every event)
+	struct Binding {
+		enum Kind : uint8_t { BUTTON, POS_AXIS, NEG_AXIS, HAT };
+		Kind kind;
+		uint8_t hatDir; // SDL_HAT_{LEFT,RIGHT,UP,DOWN}, only for HAT
+		byte msxBits;   // JOY_{UP,DOWN,LEFT,RIGHT,BUTTONA,BUTTONB}
+		unsigned index; // host button, axis or hat number
+	};
+	std::vector<Binding> bindings;
+
 	byte status;
 	bool pin8;
 #endif // SDL_JOYSTICK_DISABLED
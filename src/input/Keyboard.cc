@@ -6,11 +6,13 @@
 #include "MSXEventDistributor.hh"
 #include "StateChangeDistributor.hh"
 #include "MSXMotherBoard.hh"
+#include "MSXCPUInterface.hh"
 #include "ReverseManager.hh"
 #include "CommandController.hh"
 #include "CommandException.hh"
 #include "Event.hh"
 #include "StateChange.hh"
+#include "StateChangeCodec.hh"
 #include "TclArgParser.hh"
 #include "enumerate.hh"
 #include "openmsx.hh"
@@ -51,6 +53,7 @@ static constexpr bool SANE_CAPSLOCK_BEHAVIOR = true;
 
 
 static constexpr int TRY_AGAIN = 0x80; // see pressAscii()
+static constexpr unsigned KEYBUF_POLL_FREQ = 100; // see KeyInserter::typeViaKeybuf()
 
 using KeyInfo = UnicodeKeymap::KeyInfo;
 
@@ -73,6 +76,22 @@ public:
 	[[nodiscard]] byte getPress()   const { return press; }
 	[[nodiscard]] byte getRelease() const { return release; }
 
+	// compact encoding, see StateChangeCodec
+	static constexpr auto COMPACT_TAG = StateChangeCodec::KEY_MATRIX;
+	static constexpr unsigned NUM_COMPACT_VALUES = 3;
+	[[nodiscard]] uint8_t getCompactTag() const override { return COMPACT_TAG; }
+	void getCompactValues(CompactValues& values) const override {
+		values = {row, press, release};
+	}
+	[[nodiscard]] static std::unique_ptr<StateChange> fromCompact(
+		EmuTime::param time, span<const int32_t> v)
+	{
+		StateChangeCodec::checkPressRelease(v[1], v[2]);
+		return std::make_unique<KeyMatrixState>(
+			time, byte(StateChangeCodec::checkRange(v[0], 0, 15)),
+			byte(v[1]), byte(v[2]));
+	}
+
 	template<typename Archive> void serialize(Archive& ar, unsigned /*version*/)
 	{
 		ar.template serializeBase<StateChange>(*this);
@@ -84,6 +103,7 @@ private:
 	byte row, press, release;
 };
 REGISTER_POLYMORPHIC_CLASS(StateChange, KeyMatrixState, "KeyMatrixState");
+static const StateChangeCodec::Registration<KeyMatrixState> keyMatrixStateCodec;
 
 
 constexpr const char* const defaultKeymapForMatrix[] = {
@@ -255,7 +275,8 @@ Keyboard::Keyboard(MSXMotherBoard& motherBoard,
 	, modifierPos(modifierPosForMatrix[matrix])
 	, keyMatrixUpCmd  (commandController, stateChangeDistributor, scheduler_)
 	, keyMatrixDownCmd(commandController, stateChangeDistributor, scheduler_)
-	, keyTypeCmd      (commandController, stateChangeDistributor, scheduler_)
+	, keyTypeCmd      (motherBoard, commandController, stateChangeDistributor,
+	                   scheduler_, matrix)
 	, capsLockAligner(eventDistributor, scheduler_)
 	, keyboardSettings(commandController)
 	, msxKeyEventQueue(scheduler_, commandController.getInterpreter())
@@ -1163,28 +1184,33 @@ void Keyboard::MsxKeyEventQueue::executeUntil(EmuTime::param time)
 // class KeyInserter
 
 Keyboard::KeyInserter::KeyInserter(
+		MSXMotherBoard& motherBoard_,
 		CommandController& commandController_,
 		StateChangeDistributor& stateChangeDistributor_,
-		Scheduler& scheduler_)
+		Scheduler& scheduler_, MatrixType matrix_)
 	: RecordedCommand(commandController_, stateChangeDistributor_,
 		scheduler_, "type_via_keyboard")
 	, Schedulable(scheduler_)
 	, lockKeysMask(0)
 	, releaseLast(false)
+	, motherBoard(motherBoard_)
+	, matrix(matrix_)
 {
 	// avoid UMR
 	last = 0;
 	oldLocksOn = 0;
 	releaseBeforePress = false;
+	useKeybuf = false;
 	typingFrequency = 15;
 }
 
 void Keyboard::KeyInserter::execute(
 	span<const TclObject> tokens, TclObject& /*result*/, EmuTime::param /*time*/)
 {
-	checkNumArgs(tokens, AtLeast{2}, "?-release? ?-freq hz? text");
+	checkNumArgs(tokens, AtLeast{2}, "?-release? ?-keybuf? ?-freq hz? text");
 
 	releaseBeforePress = false;
+	useKeybuf = false;
 	typingFrequency = 15;
 
 	// for full backwards compatibility: one option means type it...
@@ -1195,6 +1221,7 @@ void Keyboard::KeyInserter::execute(
 
 	ArgsInfo info[] = {
 		flagArg("-release", releaseBeforePress),
+		flagArg("-keybuf", useKeybuf),
 		valueArg("-freq", typingFrequency),
 	};
 	auto arguments = parseTclArgs(getInterpreter(), tokens.subspan(1), info);
@@ -1211,13 +1238,14 @@ std::string Keyboard::KeyInserter::help(span<const TclObject> /*tokens*/) const
 {
 	return "Type a string in the emulated MSX.\n" \
 	       "Use -release to make sure the keys are always released before typing new ones (necessary for some game input routines, but in general, this means typing is twice as slow).\n" \
-	       "Use -freq to tweak how fast typing goes and how long the keys will be pressed (and released in case -release was used). Keys will be typed at the given frequency and will remain pressed/released for 1/freq seconds";
+	       "Use -freq to tweak how fast typing goes and how long the keys will be pressed (and released in case -release was used). Keys will be typed at the given frequency and will remain pressed/released for 1/freq seconds.\n" \
+	       "Use -keybuf to write the ASCII characters directly in the keyboard buffer of the BIOS, instead of pressing the keys. This is a lot faster, but it only works in software that reads the keys via the BIOS (e.g. MSX-BASIC). Other characters, and all characters while the BIOS keyboard buffer is not initialized, are still typed via the keyboard.";
 }
 
 void Keyboard::KeyInserter::tabCompletion(std::vector<std::string>& tokens) const
 {
 	using namespace std::literals;
-	static constexpr std::array options = {"-release"sv, "-freq"sv};
+	static constexpr std::array options = {"-release"sv, "-keybuf"sv, "-freq"sv};
 	completeString(tokens, options);
 }
 
@@ -1259,6 +1287,20 @@ void Keyboard::KeyInserter::executeUntil(EmuTime::param time)
 	}
 
 	try {
+		if (useKeybuf) {
+			auto result = typeViaKeybuf(time);
+			if (result != KeybufResult::UNAVAILABLE) {
+				// the previous character (if any) was released above
+				releaseLast = false;
+				if (text_utf8.empty()) {
+					reschedule(time);
+				} else {
+					setSyncPoint(time + EmuDuration::hz(KEYBUF_POLL_FREQ));
+				}
+				return;
+			}
+		}
+
 		auto it = begin(text_utf8);
 		unsigned current = utf8::next(it, end(text_utf8));
 		if (releaseLast && (releaseBeforePress || keyboard.commonKeys(last, current))) {
@@ -1293,6 +1335,59 @@ void Keyboard::KeyInserter::reschedule(EmuTime::param time)
 	setSyncPoint(time + EmuDuration::hz(typingFrequency));
 }
 
+Keyboard::KeyInserter::KeybufResult Keyboard::KeyInserter::typeViaKeybuf(EmuTime::param time)
+{
+	// Addresses of the BIOS system variables.
+	struct Keybuf { word putPnt, getPnt, keyBuf, bufEnd; };
+	static constexpr Keybuf msxKeybuf = {0xF3F8, 0xF3FA, 0xFBF0, 0xFC18};
+	static constexpr Keybuf sviKeybuf = {0xFA1A, 0xFA1C, 0xFD8B, 0xFDB3};
+	if (matrix == MATRIX_CVJOY) return KeybufResult::UNAVAILABLE;
+	const auto& kb = (matrix == MATRIX_SVI) ? sviKeybuf : msxKeybuf;
+
+	auto& cpuInterface = motherBoard.getCPUInterface();
+	auto peek16 = [&](word address) {
+		return word(cpuInterface.peekMem(address + 0, time) +
+		           (cpuInterface.peekMem(address + 1, time) << 8));
+	};
+	auto write16 = [&](word address, word value) {
+		cpuInterface.writeMem(address + 0, byte(value & 0xFF), time);
+		cpuInterface.writeMem(address + 1, byte(value >> 8),   time);
+	};
+	auto inBuffer = [&](word pointer) {
+		return (kb.keyBuf <= pointer) && (pointer < kb.bufEnd);
+	};
+
+	// Only when the pointers look sane, otherwise the BIOS is not (yet)
+	// initialized or the memory is used for something else.
+	word putPnt = peek16(kb.putPnt);
+	word getPnt = peek16(kb.getPnt);
+	if (!inBuffer(putPnt) || !inBuffer(getPnt)) return KeybufResult::UNAVAILABLE;
+	// Wait till the BIOS processed the previously written characters.
+	if (putPnt != getPnt) return KeybufResult::BUSY;
+
+	// Fill the buffer (almost, the BIOS can't distinguish full from
+	// empty) with the ASCII characters at the start of the text.
+	word addr = kb.keyBuf;
+	auto it = begin(text_utf8);
+	while ((addr < (kb.bufEnd - 1)) && (it != end(text_utf8))) {
+		auto prev = it;
+		unsigned current = utf8::next(it, end(text_utf8));
+		if (current >= 0x80) {
+			it = prev;
+			break;
+		}
+		cpuInterface.writeMem(addr++, byte(current), time);
+	}
+	if (addr == kb.keyBuf) {
+		// the next character must be typed via the keyboard
+		return KeybufResult::UNAVAILABLE;
+	}
+	text_utf8.erase(begin(text_utf8), it);
+	write16(kb.getPnt, kb.keyBuf);
+	write16(kb.putPnt, addr);
+	return KeybufResult::TYPED;
+}
+
 /*
  * class CapsLockAligner
  *
@@ -1412,14 +1507,21 @@ void Keyboard::KeybDebuggable::write(unsigned /*address*/, byte /*value*/)
 }
 
 
+// version 1: initial version
+// version 2: added releaseBeforePress, useKeybuf and typingFrequency
 template<typename Archive>
-void Keyboard::KeyInserter::serialize(Archive& ar, unsigned /*version*/)
+void Keyboard::KeyInserter::serialize(Archive& ar, unsigned version)
 {
 	ar.template serializeBase<Schedulable>(*this);
 	ar.serialize("text", text_utf8,
 	             "last", last,
 	             "lockKeysMask", lockKeysMask,
 	             "releaseLast", releaseLast);
+	if (ar.versionAtLeast(version, 2)) {
+		ar.serialize("releaseBeforePress", releaseBeforePress,
+		             "useKeybuf",          useKeybuf,
+		             "typingFrequency",    typingFrequency);
+	}
 
 	bool oldCodeKanaLockOn, oldGraphLockOn, oldCapsLockOn;
 	if constexpr (!Archive::IS_LOADER) {
@@ -134,9 +134,10 @@ private:
 
 	class KeyInserter final : public RecordedCommand, public Schedulable {
 	public:
-		KeyInserter(CommandController& commandController,
+		KeyInserter(MSXMotherBoard& motherBoard,
+			    CommandController& commandController,
 			    StateChangeDistributor& stateChangeDistributor,
-			    Scheduler& scheduler);
+			    Scheduler& scheduler, MatrixType matrix);
 		[[nodiscard]] bool isActive() const { return pendingSyncPoint(); }
 		template<typename Archive>
 		void serialize(Archive& ar, unsigned version);
@@ -145,6 +146,12 @@ private:
 		void type(std::string_view str);
 		void reschedule(EmuTime::param time);
 
+		enum class KeybufResult { TYPED, BUSY, UNAVAILABLE };
+		/** Write the ASCII characters at the start of the text directly
+		  * in the BIOS keyboard buffer (only when that buffer is empty).
+		  */
+		KeybufResult typeViaKeybuf(EmuTime::param time);
+
 		// Command
 		void execute(span<const TclObject> tokens, TclObject& result,
 			     EmuTime::param time) override;
@@ -162,7 +169,11 @@ private:
 		byte oldLocksOn;
 
 		bool releaseBeforePress;
+		bool useKeybuf;
 		int typingFrequency;
+
+		MSXMotherBoard& motherBoard;
+		const MatrixType matrix;
 	} keyTypeCmd;
 
 	class CapsLockAligner final : private EventListener, private Schedulable {
@@ -250,6 +261,7 @@ private:
 	byte locksOn;
 };
 SERIALIZE_CLASS_VERSION(Keyboard, 3);
+SERIALIZE_CLASS_VERSION(Keyboard::KeyInserter, 2);
 
 } // namespace openmsx
 
@@ -3,6 +3,7 @@
 #include "StateChangeDistributor.hh"
 #include "Event.hh"
 #include "StateChange.hh"
+#include "StateChangeCodec.hh"
 #include "serialize.hh"
 #include "serialize_meta.hh"
 #include <algorithm>
@@ -17,6 +18,19 @@ public:
 		: StateChange(time_), delta(delta_) {}
 	[[nodiscard]] int getDelta() const { return delta; }
 
+	// compact encoding, see StateChangeCodec
+	static constexpr auto COMPACT_TAG = StateChangeCodec::PADDLE;
+	static constexpr unsigned NUM_COMPACT_VALUES = 1;
+	[[nodiscard]] uint8_t getCompactTag() const override { return COMPACT_TAG; }
+	void getCompactValues(CompactValues& values) const override {
+		values = {delta};
+	}
+	[[nodiscard]] static std::unique_ptr<StateChange> fromCompact(
+		EmuTime::param time, span<const int32_t> v)
+	{
+		return std::make_unique<PaddleState>(time, v[0]);
+	}
+
 	template<typename Archive> void serialize(Archive& ar, unsigned /*version*/)
 	{
 		ar.template serializeBase<StateChange>(*this);
@@ -26,6 +40,7 @@ private:
 	int delta;
 };
 REGISTER_POLYMORPHIC_CLASS(StateChange, PaddleState, "PaddleState");
+static const StateChangeCodec::Registration<PaddleState> paddleStateCodec;
 
 
 Paddle::Paddle(MSXEventDistributor& eventDistributor_,
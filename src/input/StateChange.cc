@@ -0,0 +1,70 @@
+#include "StateChange.hh"
+#include <array>
+#include <new>
+#include <vector>
+
+namespace openmsx {
+
+// All state changes are small (most are less than 32 bytes), and during
+// recording or replaying with e.g. a mouse they're created (and destroyed, e.g.
+// when the reverse history is truncated) at a high rate. So instead of going
+// through the general purpose allocator each time, freed blocks are recycled,
+// per size class. (ObjectPool can't be used for this: it identifies objects
+// by index, here the objects are owned via std::unique_ptr<StateChange>).
+namespace {
+	struct FreeLists {
+		static constexpr size_t GRANULARITY = 8;
+		static constexpr size_t NUM_CLASSES = 16; // up to 128 bytes
+		static constexpr size_t MAX_FREE = 4096; // per size class
+
+		FreeLists() = default;
+		FreeLists(const FreeLists&) = delete;
+		FreeLists& operator=(const FreeLists&) = delete;
+		~FreeLists() {
+			for (auto& list : lists) {
+				for (auto* p : list) ::operator delete(p);
+			}
+		}
+
+		std::array<std::vector<void*>, NUM_CLASSES> lists;
+	};
+	// thread_local: machines can run in parallel (see 'run_machines')
+	thread_local FreeLists freeLists;
+
+	[[nodiscard]] constexpr size_t sizeClass(size_t size) {
+		return (size + FreeLists::GRANULARITY - 1) / FreeLists::GRANULARITY;
+	}
+}
+
+void* StateChange::operator new(size_t size)
+{
+	auto c = sizeClass(size);
+	if ((c == 0) || (c > FreeLists::NUM_CLASSES)) {
+		return ::operator new(size);
+	}
+	auto& list = freeLists.lists[c - 1];
+	if (list.empty()) {
+		return ::operator new(c * FreeLists::GRANULARITY);
+	}
+	void* result = list.back();
+	list.pop_back();
+	return result;
+}
+
+void StateChange::operator delete(void* ptr, size_t size)
+{
+	if (!ptr) return;
+	auto c = sizeClass(size);
+	if ((c == 0) || (c > FreeLists::NUM_CLASSES)) {
+		::operator delete(ptr);
+		return;
+	}
+	auto& list = freeLists.lists[c - 1];
+	if (list.size() >= FreeLists::MAX_FREE) {
+		::operator delete(ptr);
+		return;
+	}
+	list.push_back(ptr);
+}
+
+} // namespace openmsx
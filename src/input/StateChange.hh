@@ -3,6 +3,9 @@
 
 #include "EmuTime.hh"
 #include "serialize_meta.hh"
+#include "static_vector.hh"
+#include <cstddef>
+#include <cstdint>
 
 namespace openmsx {
 
@@ -32,6 +35,19 @@ public:
 		ar.serialize("time", time);
 	}
 
+	/** Memory for state changes comes from a pool, see StateChange.cc. */
+	[[nodiscard]] static void* operator new(size_t size);
+	static void operator delete(void* ptr, size_t size);
+
+	/** Compact encoding, used in replay files, see StateChangeCodec.
+	  * Frequent (input device) state changes that consist of only a few
+	  * small integers return a non-zero tag (StateChangeCodec::Tag) and
+	  * their values. */
+	static constexpr unsigned MAX_COMPACT_VALUES = 4;
+	using CompactValues = static_vector<int32_t, MAX_COMPACT_VALUES>;
+	[[nodiscard]] virtual uint8_t getCompactTag() const { return 0; }
+	virtual void getCompactValues(CompactValues& /*values*/) const {}
+
 protected:
 	StateChange() : time(EmuTime::zero()) {} // for serialize
 	explicit StateChange(EmuTime::param time_)
@@ -0,0 +1,136 @@
+#include "StateChangeCodec.hh"
+#include "MSXException.hh"
+#include "xrange.hh"
+#include <array>
+#include <cassert>
+
+namespace openmsx::StateChangeCodec {
+
+struct TypeInfo {
+	Factory factory = nullptr;
+	unsigned numValues = 0;
+};
+
+[[nodiscard]] static std::array<TypeInfo, NUM_TAGS>& getRegistry()
+{
+	static std::array<TypeInfo, NUM_TAGS> registry;
+	return registry;
+}
+
+void registerType(Tag tag, unsigned numValues, Factory factory)
+{
+	assert((OTHER < tag) && (tag < NUM_TAGS));
+	assert(numValues <= StateChange::MAX_COMPACT_VALUES);
+	auto& info = getRegistry()[tag];
+	assert(!info.factory); // registered twice
+	info.factory = factory;
+	info.numValues = numValues;
+}
+
+int32_t checkRange(int32_t value, int32_t min, int32_t max)
+{
+	if ((value < min) || (value > max)) {
+		throw MSXException("Invalid value in compact event data in replay.");
+	}
+	return value;
+}
+
+void checkPressRelease(int32_t press, int32_t release)
+{
+	if ((press   < 0) || (press   > 255) ||
+	    (release < 0) || (release > 255) ||
+	    ((press == 0) && (release == 0)) || (press & release)) {
+		throw MSXException("Invalid value in compact event data in replay.");
+	}
+}
+
+static void writeVarUint(std::vector<uint8_t>& out, uint64_t value)
+{
+	while (value >= 0x80) {
+		out.push_back(uint8_t(value | 0x80));
+		value >>= 7;
+	}
+	out.push_back(uint8_t(value));
+}
+
+[[nodiscard]] static uint64_t readVarUint(span<const uint8_t>& data)
+{
+	uint64_t result = 0;
+	for (unsigned shift = 0; shift < 64; shift += 7) {
+		if (data.empty()) break;
+		uint8_t b = data[0];
+		data = data.subspan(1);
+		result |= uint64_t(b & 0x7F) << shift;
+		if (!(b & 0x80)) return result;
+	}
+	throw MSXException("Corrupt compact event data in replay.");
+}
+
+// zigzag encoding: small negative values also need only a few bytes
+[[nodiscard]] static constexpr uint64_t toZigZag(int32_t value)
+{
+	return (uint64_t(uint32_t(value)) << 1) ^ uint64_t(int64_t(value) >> 63);
+}
+[[nodiscard]] static constexpr int32_t fromZigZag(uint64_t value)
+{
+	return int32_t(uint32_t(value >> 1) ^ -uint32_t(value & 1));
+}
+
+void encode(const Events& events, std::vector<uint8_t>& out,
+            std::vector<StateChange*>& others)
+{
+	auto prevTime = EmuTime::zero();
+	StateChange::CompactValues values;
+	for (const auto& event : events) {
+		auto time = event->getTime();
+		uint8_t tag = event->getCompactTag();
+		if ((tag == OTHER) || (time < prevTime)) {
+			out.push_back(OTHER);
+			others.push_back(event.get());
+		} else {
+			values.clear();
+			event->getCompactValues(values);
+			assert(values.size() == getRegistry()[tag].numValues);
+			out.push_back(tag);
+			writeVarUint(out, (time - prevTime).length());
+			for (auto v : values) writeVarUint(out, toZigZag(v));
+		}
+		prevTime = time;
+	}
+}
+
+Events decode(span<const uint8_t> data, Events& others)
+{
+	Events result;
+	auto prevTime = EmuTime::zero();
+	auto nextOther = begin(others);
+	std::array<int32_t, StateChange::MAX_COMPACT_VALUES> values;
+	while (!data.empty()) {
+		uint8_t tag = data[0];
+		data = data.subspan(1);
+		if (tag == OTHER) {
+			if (nextOther == end(others)) {
+				throw MSXException("Missing event in replay.");
+			}
+			result.push_back(std::move(*nextOther++));
+		} else {
+			const auto& info = (tag < NUM_TAGS) ? getRegistry()[tag] : TypeInfo();
+			if (!info.factory) {
+				throw MSXException("Unknown compact event type in replay: ", int(tag));
+			}
+			auto time = prevTime + EmuDuration(readVarUint(data));
+			for (auto i : xrange(info.numValues)) {
+				values[i] = fromZigZag(readVarUint(data));
+			}
+			result.push_back(info.factory(time, span<const int32_t>(values.data(), info.numValues)));
+		}
+		prevTime = result.back()->getTime();
+	}
+	if (nextOther != end(others)) {
+		throw MSXException("Corrupt compact event data in replay.");
+	}
+	others.clear();
+	return result;
+}
+
+} // namespace openmsx::StateChangeCodec
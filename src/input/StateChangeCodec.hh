@@ -0,0 +1,79 @@
+#ifndef STATECHANGECODEC_HH
+#define STATECHANGECODEC_HH
+
+#include "StateChange.hh"
+#include "span.hh"
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <vector>
+
+namespace openmsx {
+
+/** Compact binary encoding of a sequence of state changes.
+  *
+  * Replays with mouse, trackball or paddle input contain millions of events.
+  * Serializing each of those polymorphically (in XML) takes a lot of space
+  * and time. Instead the frequent input device events are encoded as: a tag
+  * byte, the time difference with the previous event (in EmuTime ticks) and
+  * the values, all as variable length integers. Events without a compact
+  * encoding are written as a single 'OTHER' tag, their content is
+  * serialized separately (the normal way) and merged back while decoding.
+  */
+namespace StateChangeCodec {
+
+	/** These values are stored in replay files, so never change them. */
+	enum Tag : uint8_t {
+		OTHER = 0,
+		KEY_MATRIX = 1,
+		JOYSTICK = 2,
+		MOUSE = 3,
+		TRACKBALL = 4,
+		PADDLE = 5,
+		NUM_TAGS // must be last
+	};
+
+	using Events = std::deque<std::unique_ptr<StateChange>>;
+	using Factory = std::unique_ptr<StateChange>(*)(
+		EmuTime::param time, span<const int32_t> values);
+
+	/** Each StateChange subclass with a compact encoding registers how
+	  * to recreate it, see Registration below.
+	  * @param tag The value returned by StateChange::getCompactTag().
+	  * @param numValues The number of values of this type.
+	  * @param factory Should validate the values (throw MSXException).
+	  */
+	void registerType(Tag tag, unsigned numValues, Factory factory);
+
+	/** Encode 'events' (appended to 'out'). The events without compact
+	  * encoding are appended to 'others', they must be stored separately.
+	  */
+	void encode(const Events& events, std::vector<uint8_t>& out,
+	            std::vector<StateChange*>& others);
+
+	/** The inverse of encode(). The events in 'others' are moved to the
+	  * result.
+	  * @throws MSXException when the data is corrupt.
+	  */
+	[[nodiscard]] Events decode(span<const uint8_t> data, Events& others);
+
+	/** Helpers for the factories, these throw MSXException when the
+	  * values are invalid (press and release are bitmasks, at least one
+	  * must be non-zero and they may not overlap). */
+	[[nodiscard]] int32_t checkRange(int32_t value, int32_t min, int32_t max);
+	void checkPressRelease(int32_t press, int32_t release);
+
+	/** Registers a class with members 'COMPACT_TAG', 'NUM_COMPACT_VALUES'
+	  * and 'static std::unique_ptr<StateChange> fromCompact(
+	  *     EmuTime::param time, span<const int32_t> values)'.
+	  * Use as a static object in the file that defines the class. */
+	template<typename T> struct Registration {
+		Registration() {
+			registerType(T::COMPACT_TAG, T::NUM_COMPACT_VALUES, &T::fromCompact);
+		}
+	};
+
+} // namespace StateChangeCodec
+} // namespace openmsx
+
+#endif
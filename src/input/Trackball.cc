@@ -3,6 +3,7 @@
 #include "StateChangeDistributor.hh"
 #include "Event.hh"
 #include "StateChange.hh"
+#include "StateChangeCodec.hh"
 #include "serialize.hh"
 #include "serialize_meta.hh"
 #include <algorithm>
@@ -32,6 +33,22 @@ public:
 	[[nodiscard]] byte getPress()   const { return press; }
 	[[nodiscard]] byte getRelease() const { return release; }
 
+	// compact encoding, see StateChangeCodec
+	static constexpr auto COMPACT_TAG = StateChangeCodec::TRACKBALL;
+	static constexpr unsigned NUM_COMPACT_VALUES = 4;
+	[[nodiscard]] uint8_t getCompactTag() const override { return COMPACT_TAG; }
+	void getCompactValues(CompactValues& values) const override {
+		values = {deltaX, deltaY, press, release};
+	}
+	[[nodiscard]] static std::unique_ptr<StateChange> fromCompact(
+		EmuTime::param time, span<const int32_t> v)
+	{
+		return std::make_unique<TrackballState>(
+			time, v[0], v[1],
+			byte(StateChangeCodec::checkRange(v[2], 0, 255)),
+			byte(StateChangeCodec::checkRange(v[3], 0, 255)));
+	}
+
 	template<typename Archive> void serialize(Archive& ar, unsigned /*version*/)
 	{
 		ar.template serializeBase<StateChange>(*this);
@@ -45,6 +62,7 @@ private:
 	byte press, release;
 };
 REGISTER_POLYMORPHIC_CLASS(StateChange, TrackballState, "TrackballState");
+static const StateChangeCodec::Registration<TrackballState> trackballStateCodec;
 
 
 Trackball::Trackball(MSXEventDistributor& eventDistributor_,
@@ -7,6 +7,7 @@
 #include "ranges.hh"
 #include "stl.hh"
 #include "StringOp.hh"
+#include "xrange.hh"
 #include <cstring>
 #include <optional>
 
@@ -95,6 +96,11 @@ UnicodeKeymap::UnicodeKeymap(string_view keyboardType)
 }
 
 UnicodeKeymap::KeyInfo UnicodeKeymap::get(unsigned unicode) const
+{
+	return (unicode < asciiTable.size()) ? asciiTable[unicode] : lookup(unicode);
+}
+
+UnicodeKeymap::KeyInfo UnicodeKeymap::lookup(unsigned unicode) const
 {
 	auto it = ranges::lower_bound(mapdata, unicode, {}, &Entry::unicode);
 	return ((it != end(mapdata)) && (it->unicode == unicode))
@@ -207,6 +213,10 @@ void UnicodeKeymap::parseUnicodeKeymapfile(string_view data)
 	}
 
 	ranges::sort(mapdata, {}, &Entry::unicode);
+
+	for (auto i : xrange(unsigned(asciiTable.size()))) {
+		asciiTable[i] = lookup(i);
+	}
 }
 
 } // namespace openmsx
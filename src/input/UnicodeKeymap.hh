@@ -2,6 +2,7 @@
 #define UNICODEKEYMAP_HH
 
 #include "openmsx.hh"
+#include <array>
 #include <cassert>
 #include <string_view>
 #include <vector>
@@ -136,6 +137,7 @@ private:
 	static constexpr unsigned NUM_DEAD_KEYS = 3;
 
 	void parseUnicodeKeymapfile(std::string_view data);
+	[[nodiscard]] KeyInfo lookup(unsigned unicode) const;
 
 private:
 	struct Entry {
@@ -143,6 +145,9 @@ private:
 		KeyInfo keyInfo;
 	};
 	std::vector<Entry> mapdata; // sorted on unicode
+	/** The result of lookup() for the ASCII range, precomputed because
+	  * (typed) text mostly consists of ASCII characters. */
+	std::array<KeyInfo, 128> asciiTable;
 
 	/** Contains a mask for each key matrix position, which for each modifier
 	  * has the corresponding bit set if that modifier that affects the key.
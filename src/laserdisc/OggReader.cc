@@ -3,12 +3,15 @@
 #include "yuv2rgb.hh"
 #include "likely.hh"
 #include "CliComm.hh"
+#include "Filename.hh"
 #include "MemoryOps.hh"
 #include "one_of.hh"
 #include "ranges.hh"
 #include "stringsp.hh" // for strncasecmp
 #include "view.hh"
 #include "xrange.hh"
+#include <algorithm>
+#include <cassert>
 #include <cstring> // for memcpy, memcmp
 #include <cstdlib> // for atoi
 #include <cctype> // for isspace
@@ -47,6 +50,9 @@ Frame::~Frame()
 OggReader::OggReader(const Filename& filename, CliComm& cli_)
 	: cli(cli_)
 	, file(filename)
+	, indexFileSize(0)
+	, indexReady(false)
+	, stopIndexer(false)
 {
 	audioSerial = -1;
 	videoSerial = -1;
@@ -199,6 +205,11 @@ OggReader::OggReader(const Filename& filename, CliComm& cli_)
 		throw;
 	}
 
+	// Without an index each seek needs a couple of bisection steps, each
+	// step reads (and parses) part of the file. That takes long on slow
+	// media. So scan the whole file once in the background.
+	indexer = std::thread([this, name = Filename(filename)]() { buildIndex(name); });
+
 	th_setup_free(tsi);
 	th_info_clear(&ti);
 	th_comment_clear(&tc);
@@ -228,6 +239,8 @@ void OggReader::cleanup()
 
 OggReader::~OggReader()
 {
+	stopIndexer = true;
+	if (indexer.joinable()) indexer.join();
 	cleanup();
 }
 
@@ -853,10 +866,126 @@ size_t OggReader::bisection(
 	}
 }
 
+void OggReader::buildIndex(const Filename& filename)
+{
+	// Runs in a separate thread: only use local state and the members
+	// which are constant after the constructor has finished. Errors are
+	// ignored, seek() then simply keeps using bisection.
+	constexpr size_t CHUNK = 64 * 1024;
+	std::vector<TheoraPage> theoraPages;
+	std::vector<VorbisPage> vorbisPages;
+	size_t size = 0;
+
+	ogg_sync_state syncState;
+	ogg_sync_init(&syncState);
+	try {
+		File f(filename);
+		size = f.getSize();
+		size_t readOffset = 0;
+		size_t pageOffset = 0;
+		ogg_page page;
+		while (true) {
+			if (stopIndexer) {
+				ogg_sync_clear(&syncState);
+				return;
+			}
+			long ret = ogg_sync_pageseek(&syncState, &page);
+			if (ret < 0) {
+				// skipped bytes, not at a page boundary
+				pageOffset += size_t(-ret);
+				continue;
+			}
+			if (ret == 0) {
+				// need more data
+				if (readOffset >= size) break;
+				size_t chunk = std::min(CHUNK, size - readOffset);
+				char* buffer = ogg_sync_buffer(&syncState, long(chunk));
+				f.read(buffer, chunk);
+				readOffset += chunk;
+				ogg_sync_wrote(&syncState, long(chunk));
+				continue;
+			}
+
+			auto granule = ogg_page_granulepos(&page);
+			if (granule != -1) {
+				int serial = ogg_page_serialno(&page);
+				if (serial == videoSerial) {
+					size_t intra = granule & ((size_t(1) << granuleShift) - 1);
+					size_t key = granule >> granuleShift;
+					theoraPages.push_back({pageOffset, key + intra, key});
+				} else if (serial == audioSerial) {
+					vorbisPages.push_back({pageOffset, size_t(granule)});
+				}
+			}
+			pageOffset += size_t(ret);
+		}
+	} catch (MSXException&) {
+		ogg_sync_clear(&syncState);
+		return;
+	}
+	ogg_sync_clear(&syncState);
+
+	if (theoraPages.empty() || vorbisPages.empty() ||
+	    !ranges::is_sorted(theoraPages, {}, &TheoraPage::frame) ||
+	    !ranges::is_sorted(vorbisPages, {}, &VorbisPage::sample)) {
+		// can't binary search in this, keep using bisection
+		return;
+	}
+	theoraIndex = std::move(theoraPages);
+	vorbisIndex = std::move(vorbisPages);
+	indexFileSize = size;
+	indexReady = true;
+}
+
+size_t OggReader::indexedOffset(size_t frame, size_t sample)
+{
+	fileSize = indexFileSize;
+	totalFrames = theoraIndex.back().frame;
+
+	// same boundary as in findOffset()
+	if (sample < getSampleRate() || frame <= 30) {
+		keyFrame = 1;
+		return 0;
+	}
+
+	size_t maxSamples = vorbisIndex.back().sample;
+	if ((sample > maxSamples) || (frame > totalFrames)) {
+		sample = maxSamples;
+		frame = totalFrames;
+	}
+
+	// The key frame of the first page which completes the requested frame.
+	// When a later key frame is on that page, the previous page tells.
+	auto it = ranges::lower_bound(theoraIndex, frame, {}, &TheoraPage::frame);
+	assert(it != end(theoraIndex));
+	while ((it != begin(theoraIndex)) && (it->keyFrame > frame)) --it;
+	if (it->keyFrame > frame) {
+		keyFrame = 1;
+		return 0;
+	}
+	keyFrame = it->keyFrame;
+
+	// Start reading at the last page which only completes frames before
+	// the key frame, and before the requested sample. Frames before the
+	// key frame are discarded by readTheora().
+	auto t = ranges::lower_bound(theoraIndex, keyFrame, {}, &TheoraPage::frame);
+	auto v = ranges::lower_bound(vorbisIndex, sample, {}, &VorbisPage::sample);
+	if ((t == begin(theoraIndex)) || (v == begin(vorbisIndex))) {
+		return 0;
+	}
+	return std::min(std::prev(t)->offset, std::prev(v)->offset);
+}
+
 size_t OggReader::findOffset(size_t frame, size_t sample)
 {
 	constexpr size_t STEP = 32 * 1024;
 
+	// Use the index when it's ready. It's only valid as long as the file
+	// didn't change (the file might still be growing, see below).
+	if (indexReady && (file.getSize() == indexFileSize)) {
+		return indexedOffset(frame, sample);
+	}
+
 	// first calculate total length in bytes, samples and frames
 
 	// The file might have changed since we last requested its size,
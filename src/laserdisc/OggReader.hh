@@ -6,8 +6,10 @@
 #include <ogg/ogg.h>
 #include <vorbis/codec.h>
 #include <theora/theoradec.h>
+#include <atomic>
 #include <memory>
 #include <list>
+#include <thread>
 #include <vector>
 
 namespace openmsx {
@@ -69,6 +71,8 @@ private:
 	void vorbisFoundPosition();
 	size_t frameNo(ogg_packet* packet) const;
 
+	void buildIndex(const Filename& filename);
+	size_t indexedOffset(size_t frame, size_t sample);
 	size_t findOffset(size_t frame, size_t sample);
 	size_t bisection(size_t frame, size_t sample,
 	                 size_t maxOffset, size_t maxSamples, size_t maxFrames);
@@ -123,6 +127,25 @@ private:
 		size_t frame;
 	};
 	std::vector<ChapterFrame> chapters; // sorted on chapter
+
+	// Page index, built by a background thread (see buildIndex()). Only
+	// pages with a granule position are stored. The vectors are written
+	// before 'indexReady' is set and never change afterwards.
+	struct TheoraPage {
+		size_t offset;
+		size_t frame; // last frame completed on this page
+		size_t keyFrame; // the key frame of that frame
+	};
+	struct VorbisPage {
+		size_t offset;
+		size_t sample; // last sample completed on this page
+	};
+	std::vector<TheoraPage> theoraIndex; // sorted on offset and frame
+	std::vector<VorbisPage> vorbisIndex; // sorted on offset and sample
+	size_t indexFileSize;
+	std::atomic<bool> indexReady;
+	std::atomic<bool> stopIndexer;
+	std::thread indexer;
 };
 
 } // namespace openmsx
@@ -2,12 +2,22 @@
 #include "RawFrame.hh"
 #include "Math.hh"
 #include "PixelFormat.hh"
+#include "WorkerPool.hh"
 #include "xrange.hh"
+#include <algorithm>
 #include <cassert>
 #include <cstdint>
+#include <thread>
 #ifdef __SSE2__
 #include <emmintrin.h>
 #endif
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+#if defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#define YUV2RGB_NEON 1
+#endif
 
 namespace openmsx::yuv2rgb {
 
@@ -217,8 +227,81 @@ static inline void yuv2rgb_sse2(
 	_mm_store_si128(out1 + 7, bgra11_cf);
 }
 
+#ifdef __AVX2__
+
+// The same calculation as yuv2rgb_sse2(), but on 16 instead of 8 chroma
+// samples at once. AVX2 (un)packs within each 128-bit lane, so the
+// results are reordered at the end.
+static inline void yuv2rgb_avx2(
+	const uint8_t* u_ , const uint8_t* v_,
+	const uint8_t* y0_, const uint8_t* y1_,
+	uint32_t* out0_, uint32_t* out1_)
+{
+	// constants
+	const __m256i ALPHA   = _mm256_set1_epi16(short(0xFF00));
+	const __m256i RED_V   = _mm256_set1_epi16(   102);
+	const __m256i GREEN_U = _mm256_set1_epi16(   -25);
+	const __m256i GREEN_V = _mm256_set1_epi16(   -52);
+	const __m256i BLUE_U  = _mm256_set1_epi16(   129);
+	const __m256i COEF_Y  = _mm256_set1_epi16(    74);
+	const __m256i CNST_R  = _mm256_set1_epi16(  -223);
+	const __m256i CNST_G  = _mm256_set1_epi16(   136);
+	const __m256i CNST_B  = _mm256_set1_epi16(  -277);
+	const __m256i Y_MASK  = _mm256_set1_epi16(0x00FF);
+	const __m256i ZERO    = _mm256_setzero_si256();
+	const __m256i MAX     = _mm256_set1_epi16(255);
+
+	__m256i u = _mm256_cvtepu8_epi16(_mm_load_si128(reinterpret_cast<const __m128i*>(u_)));
+	__m256i v = _mm256_cvtepu8_epi16(_mm_load_si128(reinterpret_cast<const __m128i*>(v_)));
+	__m256i mr = _mm256_srai_epi16(_mm256_mullo_epi16(v, RED_V), 6);
+	__m256i sg = _mm256_mullo_epi16(v, GREEN_V);
+	__m256i tg = _mm256_mullo_epi16(u, GREEN_U);
+	__m256i mg = _mm256_srai_epi16(_mm256_adds_epi16(sg, tg), 6);
+	__m256i mb = _mm256_srli_epi16(_mm256_mullo_epi16(u, BLUE_U), 6); // logical shift
+	__m256i dr = _mm256_adds_epi16(mr, CNST_R);
+	__m256i dg = _mm256_adds_epi16(mg, CNST_G);
+	__m256i db = _mm256_adds_epi16(mb, CNST_B);
+
+	auto clip = [&](__m256i x) {
+		return _mm256_min_epi16(_mm256_max_epi16(x, ZERO), MAX);
+	};
+	auto line = [&](const uint8_t* y_, uint32_t* out_) {
+		__m256i y     = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(y_));
+		__m256i yEven = _mm256_srai_epi16(_mm256_mullo_epi16(_mm256_and_si256(y, Y_MASK), COEF_Y), 6);
+		__m256i yOdd  = _mm256_srai_epi16(_mm256_mullo_epi16(_mm256_srli_epi16(y, 8), COEF_Y), 6);
+		// per pixel: 16-bit (g << 8 | b) and (alpha << 8 | r)
+		__m256i gbEven = _mm256_or_si256(
+			_mm256_slli_epi16(clip(_mm256_adds_epi16(dg, yEven)), 8),
+			clip(_mm256_adds_epi16(db, yEven)));
+		__m256i arEven = _mm256_or_si256(ALPHA, clip(_mm256_adds_epi16(dr, yEven)));
+		__m256i gbOdd  = _mm256_or_si256(
+			_mm256_slli_epi16(clip(_mm256_adds_epi16(dg, yOdd)), 8),
+			clip(_mm256_adds_epi16(db, yOdd)));
+		__m256i arOdd  = _mm256_or_si256(ALPHA, clip(_mm256_adds_epi16(dr, yOdd)));
+		// even pixels 0-3|16-19 and 4-7|20-23 (in units of chroma samples)
+		__m256i pEvenLo = _mm256_unpacklo_epi16(gbEven, arEven);
+		__m256i pEvenHi = _mm256_unpackhi_epi16(gbEven, arEven);
+		__m256i pOddLo  = _mm256_unpacklo_epi16(gbOdd,  arOdd);
+		__m256i pOddHi  = _mm256_unpackhi_epi16(gbOdd,  arOdd);
+		// pixels 0-3|16-19, 4-7|20-23, 8-11|24-27, 12-15|28-31
+		__m256i q0 = _mm256_unpacklo_epi32(pEvenLo, pOddLo);
+		__m256i q1 = _mm256_unpackhi_epi32(pEvenLo, pOddLo);
+		__m256i q2 = _mm256_unpacklo_epi32(pEvenHi, pOddHi);
+		__m256i q3 = _mm256_unpackhi_epi32(pEvenHi, pOddHi);
+		auto* out = reinterpret_cast<__m256i*>(out_);
+		_mm256_storeu_si256(out + 0, _mm256_permute2x128_si256(q0, q1, 0x20));
+		_mm256_storeu_si256(out + 1, _mm256_permute2x128_si256(q2, q3, 0x20));
+		_mm256_storeu_si256(out + 2, _mm256_permute2x128_si256(q0, q1, 0x31));
+		_mm256_storeu_si256(out + 3, _mm256_permute2x128_si256(q2, q3, 0x31));
+	};
+	line(y0_, out0_);
+	line(y1_, out1_);
+}
+
+#endif // __AVX2__
+
 static inline void convertHelperSSE2(
-	const th_ycbcr_buffer& buffer, RawFrame& output)
+	const th_ycbcr_buffer& buffer, RawFrame& output, int yBegin, int yEnd)
 {
 	const int width      = buffer[0].width;
 	const int y_stride   = buffer[0].stride;
@@ -227,7 +310,7 @@ static inline void convertHelperSSE2(
 	assert((width % 32) == 0);
 	assert((buffer[0].height % 2) == 0);
 
-	for (int y = 0; y < buffer[0].height; y += 2) {
+	for (int y = yBegin; y < yEnd; y += 2) {
 		const uint8_t* pY1 = buffer[0].data + y * y_stride;
 		const uint8_t* pY2 = buffer[0].data + (y + 1) * y_stride;
 		const uint8_t* pCb = buffer[1].data + y * uv_stride2;
@@ -237,7 +320,11 @@ static inline void convertHelperSSE2(
 
 		for (int x = 0; x < width; x += 32) {
 			// convert a block of (32 x 2) pixels
+#ifdef __AVX2__
+			yuv2rgb_avx2(pCb, pCr, pY1, pY2, out0, out1);
+#else
 			yuv2rgb_sse2(pCb, pCr, pY1, pY2, out0, out1);
+#endif
 			pCb += 16;
 			pCr += 16;
 			pY1 += 32;
@@ -253,6 +340,89 @@ static inline void convertHelperSSE2(
 
 #endif // __SSE2__
 
+#ifdef YUV2RGB_NEON
+
+// The same calculation as yuv2rgb_sse2(), for 16x2 pixels (8 chroma samples).
+static inline void yuv2rgb_neon(
+	const uint8_t* u_ , const uint8_t* v_,
+	const uint8_t* y0_, const uint8_t* y1_,
+	uint32_t* out0_, uint32_t* out1_)
+{
+	const int16x8_t RED_V   = vdupq_n_s16( 102);
+	const int16x8_t GREEN_U = vdupq_n_s16( -25);
+	const int16x8_t GREEN_V = vdupq_n_s16( -52);
+	const int16x8_t BLUE_U  = vdupq_n_s16( 129);
+	const int16x8_t COEF_Y  = vdupq_n_s16(  74);
+	const int16x8_t CNST_R  = vdupq_n_s16(-223);
+	const int16x8_t CNST_G  = vdupq_n_s16( 136);
+	const int16x8_t CNST_B  = vdupq_n_s16(-277);
+
+	int16x8_t u = vreinterpretq_s16_u16(vmovl_u8(vld1_u8(u_)));
+	int16x8_t v = vreinterpretq_s16_u16(vmovl_u8(vld1_u8(v_)));
+	int16x8_t mr = vshrq_n_s16(vmulq_s16(v, RED_V), 6);
+	int16x8_t mg = vshrq_n_s16(vqaddq_s16(vmulq_s16(v, GREEN_V), vmulq_s16(u, GREEN_U)), 6);
+	int16x8_t mb = vreinterpretq_s16_u16(vshrq_n_u16( // logical shift
+		vreinterpretq_u16_s16(vmulq_s16(u, BLUE_U)), 6));
+	int16x8_t dr = vqaddq_s16(mr, CNST_R);
+	int16x8_t dg = vqaddq_s16(mg, CNST_G);
+	int16x8_t db = vqaddq_s16(mb, CNST_B);
+
+	auto line = [&](const uint8_t* y_, uint32_t* out) {
+		uint8x8x2_t y = vld2_u8(y_); // even and odd pixels
+		int16x8_t yEven = vshrq_n_s16(vmulq_s16(vreinterpretq_s16_u16(vmovl_u8(y.val[0])), COEF_Y), 6);
+		int16x8_t yOdd  = vshrq_n_s16(vmulq_s16(vreinterpretq_s16_u16(vmovl_u8(y.val[1])), COEF_Y), 6);
+		auto comp = [&](int16x8_t d) {
+			uint8x8x2_t z = vzip_u8(vqmovun_s16(vqaddq_s16(d, yEven)),
+			                        vqmovun_s16(vqaddq_s16(d, yOdd)));
+			return vcombine_u8(z.val[0], z.val[1]);
+		};
+		uint8x16x4_t bgra;
+		bgra.val[0] = comp(db);
+		bgra.val[1] = comp(dg);
+		bgra.val[2] = comp(dr);
+		bgra.val[3] = vdupq_n_u8(0xFF);
+		vst4q_u8(reinterpret_cast<uint8_t*>(out), bgra);
+	};
+	line(y0_, out0_);
+	line(y1_, out1_);
+}
+
+static inline void convertHelperNEON(
+	const th_ycbcr_buffer& buffer, RawFrame& output, int yBegin, int yEnd)
+{
+	const int width      = buffer[0].width;
+	const int y_stride   = buffer[0].stride;
+	const int uv_stride2 = buffer[1].stride / 2;
+
+	assert((width % 16) == 0);
+	assert((buffer[0].height % 2) == 0);
+
+	for (int y = yBegin; y < yEnd; y += 2) {
+		const uint8_t* pY1 = buffer[0].data + y * y_stride;
+		const uint8_t* pY2 = buffer[0].data + (y + 1) * y_stride;
+		const uint8_t* pCb = buffer[1].data + y * uv_stride2;
+		const uint8_t* pCr = buffer[2].data + y * uv_stride2;
+		auto* out0 = output.getLinePtrDirect<uint32_t>(y + 0);
+		auto* out1 = output.getLinePtrDirect<uint32_t>(y + 1);
+
+		for (int x = 0; x < width; x += 16) {
+			// convert a block of (16 x 2) pixels
+			yuv2rgb_neon(pCb, pCr, pY1, pY2, out0, out1);
+			pCb += 8;
+			pCr += 8;
+			pY1 += 16;
+			pY2 += 16;
+			out0 += 16;
+			out1 += 16;
+		}
+
+		output.setLineWidth(y + 0, width);
+		output.setLineWidth(y + 1, width);
+	}
+}
+
+#endif // YUV2RGB_NEON
+
 constexpr int PREC = 15;
 constexpr int COEF_Y  = int(1.164 * (1 << PREC) + 0.5); // prefer to use lrint() to round
 constexpr int COEF_RV = int(1.596 * (1 << PREC) + 0.5); // but that's not (yet) constexpr
@@ -297,7 +467,7 @@ template<typename Pixel>
 
 template<typename Pixel>
 static void convertHelper(const th_ycbcr_buffer& buffer, RawFrame& output,
-                          const PixelFormat& format)
+                          const PixelFormat& format, int yBegin, int yEnd)
 {
 	assert(buffer[1].width  * 2 == buffer[0].width);
 	assert(buffer[1].height * 2 == buffer[0].height);
@@ -308,7 +478,7 @@ static void convertHelper(const th_ycbcr_buffer& buffer, RawFrame& output,
 	const int y_stride   = buffer[0].stride;
 	const int uv_stride2 = buffer[1].stride / 2;
 
-	for (int y = 0; y < buffer[0].height; y += 2) {
+	for (int y = yBegin; y < yEnd; y += 2) {
 		const uint8_t* pY  = buffer[0].data + y * y_stride;
 		const uint8_t* pCb = buffer[1].data + y * uv_stride2;
 		const uint8_t* pCr = buffer[2].data + y * uv_stride2;
@@ -339,19 +509,63 @@ static void convertHelper(const th_ycbcr_buffer& buffer, RawFrame& output,
 	}
 }
 
-void convert(const th_ycbcr_buffer& input, RawFrame& output)
+static void convertLines(const th_ycbcr_buffer& input, RawFrame& output,
+                         int yBegin, int yEnd)
 {
 	const PixelFormat& format = output.getPixelFormat();
 	if (format.getBytesPerPixel() == 4) {
-#ifdef __SSE2__
-		convertHelperSSE2(input, output);
+#if defined(__SSE2__)
+		convertHelperSSE2(input, output, yBegin, yEnd);
+#elif defined(YUV2RGB_NEON)
+		convertHelperNEON(input, output, yBegin, yEnd);
 #else
-		convertHelper<uint32_t>(input, output, format);
+		convertHelper<uint32_t>(input, output, format, yBegin, yEnd);
 #endif
 	} else {
 		assert(format.getBytesPerPixel() == 2);
-		convertHelper<uint16_t>(input, output, format);
+		convertHelper<uint16_t>(input, output, format, yBegin, yEnd);
+	}
+}
+
+// A laserdisc frame is converted in horizontal bands, in parallel. More than
+// a few bands doesn't help, the conversion is then limited by memory bandwidth.
+static constexpr unsigned MAX_BANDS = 4;
+static constexpr int MIN_BAND_HEIGHT = 32;
+
+[[nodiscard]] static unsigned getNumBands()
+{
+	static const unsigned numBands = std::clamp(
+		std::thread::hardware_concurrency(), 1u, MAX_BANDS);
+	return numBands;
+}
+
+[[nodiscard]] static WorkerPool& getWorkers()
+{
+	static WorkerPool workers(MAX_BANDS - 1);
+	return workers;
+}
+
+void convert(const th_ycbcr_buffer& input, RawFrame& output)
+{
+	const int height = input[0].height;
+	assert((height % 2) == 0);
+	int numBands = std::min(int(getNumBands()), height / MIN_BAND_HEIGHT);
+	if (numBands <= 1) {
+		convertLines(input, output, 0, height);
+		return;
+	}
+
+	// band boundaries must be at even lines (chroma has half the height)
+	int bandHeight = (((height + numBands - 1) / numBands) + 1) & ~1;
+	auto& workers = getWorkers();
+	for (int yBegin = bandHeight; yBegin < height; yBegin += bandHeight) {
+		int yEnd = std::min(yBegin + bandHeight, height);
+		workers.post([&input, &output, yBegin, yEnd] {
+			convertLines(input, output, yBegin, yEnd);
+		});
 	}
+	convertLines(input, output, 0, std::min(bandHeight, height));
+	workers.wait();
 }
 
 } // namespace openmsx::yuv2rgb
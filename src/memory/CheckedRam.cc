@@ -5,7 +5,7 @@
 #include "GlobalSettings.hh"
 #include "StringSetting.hh"
 #include "likely.hh"
-#include "xrange.hh"
+#include <algorithm>
 #include <cassert>
 
 namespace openmsx {
@@ -59,15 +59,10 @@ byte* CheckedRam::getWriteCacheLine(unsigned addr) const
 
 byte* CheckedRam::getRWCacheLines(unsigned addr, unsigned size) const
 {
-	// TODO optimize
-	unsigned num = size >> CacheLine::BITS;
-	unsigned first = addr >> CacheLine::BITS;
-	for (auto i : xrange(num)) {
-		if (!completely_initialized_cacheline[first + i]) {
-			return nullptr;
-		}
-	}
-	return const_cast<byte*>(&ram[addr]);
+	auto first = completely_initialized_cacheline.begin() + (addr >> CacheLine::BITS);
+	auto last  = first + (size >> CacheLine::BITS);
+	return std::all_of(first, last, [](bool b) { return b; })
+	     ? const_cast<byte*>(&ram[addr]) : nullptr;
 }
 
 void CheckedRam::write(unsigned addr, const byte value)
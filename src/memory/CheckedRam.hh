@@ -23,6 +23,11 @@ class Setting;
  * the turboR, only the normal memory mapper runs via CheckedRam. The RAM
  * accessed in DRAM mode or via the ROM mapper are unchecked! Note that there
  * is basically no overhead for using CheckedRam over Ram, thanks to Wouter.
+ *
+ * While a umr_callback is set, only the cache lines that are not yet
+ * completely written are excluded from the CPU cache (and thus are checked
+ * per access). As soon as the last byte of a line gets written, the line
+ * becomes cacheable again.
  */
 class CheckedRam final : private Observer<Setting>
 {
@@ -10,7 +10,7 @@ MSXMemoryMapper::MSXMemoryMapper(const DeviceConfig& config)
 
 void MSXMemoryMapper::writeIO(word port, byte value, EmuTime::param time)
 {
-	MSXMemoryMapperBase::writeIOImpl(port, value, time);
+	if (!MSXMemoryMapperBase::writeIOImpl(port, value, time)) return;
 	byte page = port & 3;
 	if (byte* data = checkedRam.getRWCacheLines(segmentOffset(page), 0x4000)) {
 		fillDeviceRWCache(page * 0x4000, 0x4000, data);
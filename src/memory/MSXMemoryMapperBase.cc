@@ -56,11 +56,15 @@ byte MSXMemoryMapperBase::peekIO(word port, EmuTime::param /*time*/) const
 	return registers[port & 0x03] | ~(Math::ceil2(numSegments) - 1);
 }
 
-void MSXMemoryMapperBase::writeIOImpl(word port, byte value, EmuTime::param /*time*/)
+bool MSXMemoryMapperBase::writeIOImpl(word port, byte value, EmuTime::param /*time*/)
 {
 	unsigned numSegments = checkedRam.getSize() / 0x4000;
-	registers[port & 3] = value & (Math::ceil2(numSegments) - 1);
+	byte newValue = value & (Math::ceil2(numSegments) - 1);
+	byte& reg = registers[port & 3];
+	if (reg == newValue) return false;
+	reg = newValue;
 	// Note: subclasses are responsible for handling CPU cacheline stuff
+	return true;
 }
 
 unsigned MSXMemoryMapperBase::segmentOffset(byte page) const
@@ -76,6 +80,11 @@ unsigned MSXMemoryMapperBase::calcAddress(word address) const
 	return segmentOffset(address / 0x4000) | (address & 0x3fff);
 }
 
+unsigned MSXMemoryMapperBase::getCoverageOffset(word address) const
+{
+	return calcAddress(address);
+}
+
 byte MSXMemoryMapperBase::peekMem(word address, EmuTime::param /*time*/) const
 {
 	return checkedRam.peek(calcAddress(address));
@@ -123,6 +132,12 @@ void MSXMemoryMapperBase::Debuggable::write(unsigned address, byte value)
 	mapper.writeIO(address, value, EmuTime::dummy());
 }
 
+void MSXMemoryMapperBase::Debuggable::readBlock(unsigned start, span<byte> output)
+{
+	auto& mapper = OUTER(MSXMemoryMapperBase, debuggable);
+	ranges::copy(span<const byte>(&mapper.registers[start], output.size()), output.data());
+}
+
 
 template<typename Archive>
 void MSXMemoryMapperBase::serialize(Archive& ar, unsigned version)
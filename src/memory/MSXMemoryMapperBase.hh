@@ -30,11 +30,13 @@ public:
 	[[nodiscard]] const byte* getReadCacheLine(word start) const override;
 	[[nodiscard]] byte* getWriteCacheLine(word start) const override;
 	[[nodiscard]] byte peekMem(word address, EmuTime::param time) const override;
+	[[nodiscard]] unsigned getCoverageOffset(word address) const override;
 	[[nodiscard]] unsigned getBaseSizeAlignment() const override;
 
 	// Subclasses _must_ override this method and
 	//  - call MSXMemoryMapperBase::writeIOImpl()
-	//  - handle CPU cacheline stuff (e.g. invalidate)
+	//  - handle CPU cacheline stuff (e.g. invalidate), but only when
+	//    writeIOImpl() reports that the segment actually changed
 	void writeIO(word port, byte value, EmuTime::param time) override = 0;
 
 	template<typename Archive>
@@ -48,7 +50,12 @@ protected:
 	[[nodiscard]] unsigned calcAddress(word address) const;
 	[[nodiscard]] unsigned segmentOffset(byte page) const;
 
-	void writeIOImpl(word port, byte value, EmuTime::param time);
+	/** Update the segment register for the given port.
+	  * @return false when the register already had this value. Then the
+	  *         CPU cache lines for that page are still correct and don't
+	  *         need to be invalidated or refilled.
+	  */
+	bool writeIOImpl(word port, byte value, EmuTime::param time);
 
 	CheckedRam checkedRam;
 	byte registers[4];
@@ -58,6 +65,7 @@ private:
 		Debuggable(MSXMotherBoard& motherBoard, const std::string& name);
 		[[nodiscard]] byte read(unsigned address) override;
 		void write(unsigned address, byte value) override;
+		void readBlock(unsigned start, span<byte> output) override;
 	} debuggable;
 };
 SERIALIZE_CLASS_VERSION(MSXMemoryMapperBase, 2);
@@ -58,8 +58,9 @@ void MusicalMemoryMapper::writeIO(word port, byte value, EmuTime::param time)
 	if ((port & 0xFC) == 0xFC) {
 		// Mapper port.
 		if (!(controlReg & PORT_ACCESS_DISABLED)) {
-			MSXMemoryMapperBase::writeIOImpl(port, value, time);
-			invalidateDeviceRWCache(0x4000 * (port & 0x03), 0x4000);
+			if (MSXMemoryMapperBase::writeIOImpl(port, value, time)) {
+				invalidateDeviceRWCache(0x4000 * (port & 0x03), 0x4000);
+			}
 		}
 	} else if (port & 1) {
 		// Sound chip.
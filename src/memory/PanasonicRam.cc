@@ -32,7 +32,7 @@ byte* PanasonicRam::getWriteCacheLine(word start) const
 
 void PanasonicRam::writeIO(word port, byte value, EmuTime::param time)
 {
-	MSXMemoryMapperBase::writeIOImpl(port, value, time);
+	if (!MSXMemoryMapperBase::writeIOImpl(port, value, time)) return;
 	byte page = port & 3;
 	unsigned addr = segmentOffset(page);
 	if (byte* data = checkedRam.getRWCacheLines(addr, 0x4000)) {
@@ -97,6 +97,12 @@ byte RamDebuggable::read(unsigned address)
 void RamDebuggable::write(unsigned address, byte value)
 {
 	ram[address] = value;
+	if (ram.debugWriteCallback) ram.debugWriteCallback(address);
+}
+
+void RamDebuggable::readBlock(unsigned start, span<byte> output)
+{
+	memcpy(output.data(), &ram[start], output.size());
 }
 
 
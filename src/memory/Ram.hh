@@ -5,6 +5,7 @@
 #include "MemBuffer.hh"
 #include "openmsx.hh"
 #include "static_string_view.hh"
+#include <functional>
 #include <optional>
 #include <string>
 
@@ -21,6 +22,7 @@ public:
 	              static_string_view description, Ram& ram);
 	byte read(unsigned address) override;
 	void write(unsigned address, byte value) override;
+	void readBlock(unsigned start, span<byte> output) override;
 private:
 	Ram& ram;
 };
@@ -48,6 +50,14 @@ public:
 	[[nodiscard]] const std::string& getName() const;
 	void clear(byte c = 0xff);
 
+	/** Install a callback that's called after each write via the
+	  * debuggable. Objects that track writes to this Ram (e.g. TrackedRam)
+	  * need this because such writes don't pass through them.
+	  */
+	void setDebugWriteCallback(std::function<void(unsigned)> callback) {
+		debugWriteCallback = std::move(callback);
+	}
+
 	template<typename Archive>
 	void serialize(Archive& ar, unsigned version);
 
@@ -56,6 +66,9 @@ private:
 	MemBuffer<byte> ram;
 	unsigned size; // must come before debuggable
 	const std::optional<RamDebuggable> debuggable; // can be nullopt
+	std::function<void(unsigned)> debugWriteCallback;
+
+	friend class RamDebuggable;
 };
 
 } // namespace openmsx
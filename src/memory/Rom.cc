@@ -7,6 +7,7 @@
 #include "FileContext.hh"
 #include "Filename.hh"
 #include "FileException.hh"
+#include "FileOperations.hh"
 #include "PanasonicMemory.hh"
 #include "MSXMotherBoard.hh"
 #include "Reactor.hh"
@@ -15,20 +16,156 @@
 #include "CliComm.hh"
 #include "FilePool.hh"
 #include "ConfigException.hh"
+#include "PerfTimers.hh"
 #include "EmptyPatch.hh"
 #include "IPSPatch.hh"
 #include "StringOp.hh"
+#include "WorkerPool.hh"
 #include "ranges.hh"
 #include "sha1.hh"
 #include "stl.hh"
+#include "xrange.hh"
+#include <algorithm>
+#include <condition_variable>
 #include <cstring>
 #include <limits>
 #include <memory>
+#include <mutex>
+#include <vector>
 
 using std::string;
 
 namespace openmsx {
 
+// Files with ROM content, indexed on sha1sum, shared by all Rom objects (of
+// all machines). E.g. when switching machines or when the reverse system
+// creates a new machine, the new machine is created before the old one is
+// deleted. Then this avoids opening (and for compressed files decompressing)
+// the same files again. Entries disappear when the last user is gone.
+static std::vector<std::pair<Sha1Sum, std::weak_ptr<File>>> sharedFiles;
+
+[[nodiscard]] static std::shared_ptr<File> getSharedFile(const Sha1Sum& sha1)
+{
+	for (const auto& [sum, file] : sharedFiles) {
+		if (sum == sha1) return file.lock(); // can be nullptr
+	}
+	return {};
+}
+
+static void addSharedFile(const Sha1Sum& sha1, const std::shared_ptr<File>& file)
+{
+	sharedFiles.erase(ranges::remove_if(sharedFiles, [](const auto& p) {
+	                          return p.second.expired();
+	                  }),
+	                  sharedFiles.end());
+	if (!getSharedFile(sha1)) {
+		sharedFiles.emplace_back(sha1, file);
+	}
+}
+
+// See RomPrefetch. The vector itself is only accessed from the main thread,
+// the members of the entries (except 'filename') are protected by the mutex.
+struct Prefetched {
+	std::string filename; // resolved
+	std::shared_ptr<File> file; // nullptr if it couldn't be loaded
+	Sha1Sum sha1;
+	bool done = false;
+};
+static std::vector<std::unique_ptr<Prefetched>> prefetched;
+static std::mutex prefetchMutex;
+static std::condition_variable prefetchCond;
+
+[[nodiscard]] static bool isPrefetched(const std::string& filename)
+{
+	return ranges::any_of(prefetched, [&](const auto& p) {
+		return p->filename == filename;
+	});
+}
+
+// Waits till the file is loaded.
+[[nodiscard]] static const Prefetched* getPrefetched(const std::string& filename)
+{
+	auto it = ranges::find_if(prefetched, [&](const auto& p) {
+		return p->filename == filename;
+	});
+	if (it == end(prefetched)) return nullptr;
+	auto& p = **it;
+	std::unique_lock lock(prefetchMutex);
+	prefetchCond.wait(lock, [&] { return p.done; });
+	return &p;
+}
+
+RomPrefetch::RomPrefetch(const XMLElement& elem, const FileContext& context)
+	: first(prefetched.size())
+{
+	auto add = [&](const XMLElement& rom) {
+		// same conditions as in Rom::init()
+		if (rom.findChild("firstblock") ||
+		    rom.findChild("resolvedFilename") ||
+		    rom.findChild("resolvedSha1")) return;
+		for (const auto* f : rom.getChildren("filename")) {
+			std::string filename;
+			try {
+				filename = Filename(f->getData(), context).getResolved();
+			} catch (FileException&) {
+				continue;
+			}
+			if (!FileOperations::exists(filename)) continue;
+			if (!isPrefetched(filename)) {
+				auto p = std::make_unique<Prefetched>();
+				p->filename = std::move(filename);
+				prefetched.push_back(std::move(p));
+			}
+			return; // only the first existing file will be used
+		}
+	};
+	auto collect = [&](const XMLElement& e, auto& self) -> void {
+		for (const auto& c : e.getChildren()) {
+			if (c.getName() == "rom") {
+				add(c);
+			} else {
+				self(c, self);
+			}
+		}
+	};
+	collect(elem, collect);
+
+	auto& pool = WorkerPool::background();
+	for (auto i : xrange(first, prefetched.size())) {
+		pool.post([p = prefetched[i].get()] {
+			std::shared_ptr<File> file;
+			Sha1Sum sha1;
+			try {
+				file = std::make_shared<File>(p->filename);
+				// this reads (for compressed files: decompresses)
+				// the whole file
+				sha1 = SHA1::calc(file->mmap());
+			} catch (MSXException&) {
+				file.reset(); // let Rom::init() report the error
+			}
+			std::lock_guard lock(prefetchMutex);
+			p->file = std::move(file);
+			p->sha1 = sha1;
+			p->done = true;
+			prefetchCond.notify_all();
+		});
+	}
+}
+
+RomPrefetch::~RomPrefetch()
+{
+	// the tasks still refer to the entries
+	{
+		std::unique_lock lock(prefetchMutex);
+		prefetchCond.wait(lock, [&] {
+			return std::all_of(prefetched.begin() + first, prefetched.end(),
+			                   [](const auto& p) { return p->done; });
+		});
+	}
+	prefetched.erase(prefetched.begin() + first, prefetched.end());
+}
+
+
 class RomDebuggable final : public Debuggable
 {
 public:
@@ -85,6 +222,7 @@ Rom::Rom(string name_, static_string_view description_,
 void Rom::init(MSXMotherBoard& motherBoard, const XMLElement& config,
                const FileContext& context)
 {
+	PerfTimers::Scope perf(PerfTimers::ROM_LOAD);
 	// (Only) if the content of this ROM depends on state that is not part
 	// of a savestate, we want to compare the sha1sum of the ROM from the
 	// time the savestate was created with the one from the loaded
@@ -117,30 +255,51 @@ void Rom::init(MSXMotherBoard& motherBoard, const XMLElement& config,
 	} else if (resolvedFilenameElem || resolvedSha1Elem ||
 	           !sums.empty() || !filenames.empty()) {
 		auto& filepool = motherBoard.getReactor().getFilePool();
-		// first try already resolved filename ..
-		if (resolvedFilenameElem) {
+		auto fileType = context.isUserContext()
+			? FileType::ROM : FileType::SYSTEM_ROM;
+		auto getFromPool = [&](const Sha1Sum& sha1) -> std::shared_ptr<File> {
+			if (auto shared = getSharedFile(sha1)) return shared;
+			File f = filepool.getFile(fileType, sha1);
+			if (!f.is_open()) return {};
+			return std::make_shared<File>(std::move(f));
+		};
+		// first check whether this exact content is already loaded
+		// (e.g. by the machine that's being replaced) ..
+		if (resolvedSha1Elem) {
+			Sha1Sum sha1(resolvedSha1Elem->getData());
+			file = getSharedFile(sha1);
+			if (file) originalSha1 = sha1;
+		}
+		// .. then try already resolved filename ..
+		if (!file && resolvedFilenameElem) {
 			try {
-				file = File(std::string(resolvedFilenameElem->getData()));
+				file = std::make_shared<File>(std::string(resolvedFilenameElem->getData()));
 			} catch (FileException&) {
 				// ignore
 			}
 		}
 		// .. then try the actual sha1sum ..
-		auto fileType = context.isUserContext()
-			? FileType::ROM : FileType::SYSTEM_ROM;
-		if (!file.is_open() && resolvedSha1Elem) {
+		if (!file && resolvedSha1Elem) {
 			Sha1Sum sha1(resolvedSha1Elem->getData());
-			file = filepool.getFile(fileType, sha1);
-			if (file.is_open()) {
+			file = getFromPool(sha1);
+			if (file) {
 				// avoid recalculating same sha1 later
 				originalSha1 = sha1;
 			}
 		}
 		// .. and then try filename as originally given by user ..
-		if (!file.is_open()) {
+		if (!file) {
 			for (auto& f : filenames) {
 				try {
-					file = File(Filename(f->getData(), context));
+					Filename filename(f->getData(), context);
+					if (const auto* p = getPrefetched(filename.getResolved());
+					    p && p->file) {
+						file = p->file;
+						// hash was calculated on a worker thread
+						originalSha1 = p->sha1;
+						break;
+					}
+					file = std::make_shared<File>(std::move(filename));
 					break;
 				} catch (FileException&) {
 					// ignore
@@ -149,11 +308,11 @@ void Rom::init(MSXMotherBoard& motherBoard, const XMLElement& config,
 		}
 		// .. then try all alternative sha1sums ..
 		// (this might retry the actual sha1sum)
-		if (!file.is_open()) {
+		if (!file) {
 			for (auto& s : sums) {
 				Sha1Sum sha1(s->getData());
-				file = filepool.getFile(fileType, sha1);
-				if (file.is_open()) {
+				file = getFromPool(sha1);
+				if (file) {
 					// avoid recalculating same sha1 later
 					originalSha1 = sha1;
 					break;
@@ -161,7 +320,7 @@ void Rom::init(MSXMotherBoard& motherBoard, const XMLElement& config,
 			}
 		}
 		// .. still no file, then error
-		if (!file.is_open()) {
+		if (!file) {
 			string error = strCat("Couldn't find ROM file for \"", name, '"');
 			if (!filenames.empty()) {
 				strAppend(error, ' ', filenames.front()->getData());
@@ -184,28 +343,29 @@ void Rom::init(MSXMotherBoard& motherBoard, const XMLElement& config,
 				"supported.");
 		}
 		try {
-			auto mmap = file.mmap();
+			auto mmap = file->mmap();
 			if (mmap.size() > std::numeric_limits<decltype(size)>::max()) {
-				throw MSXException("Rom file too big: ", file.getURL());
+				throw MSXException("Rom file too big: ", file->getURL());
 			}
 			rom = mmap.data();
 			size = unsigned(mmap.size());
 		} catch (FileException&) {
-			throw MSXException("Error reading ROM image: ", file.getURL());
+			throw MSXException("Error reading ROM image: ", file->getURL());
 		}
 
 		// For file-based roms, calc sha1 via File::getSha1Sum(). It can
 		// possibly use the FilePool cache to avoid the calculation.
 		if (originalSha1.empty()) {
-			originalSha1 = filepool.getSha1Sum(file);
+			originalSha1 = filepool.getSha1Sum(*file);
 		}
+		addSharedFile(originalSha1, file);
 
 		// verify SHA1
 		if (!checkSHA1(config)) {
 			motherBoard.getMSXCliComm().printWarning(
 				"SHA1 sum for '", name,
 				"' does not match with sum of '",
-				file.getURL(), "'.");
+				file->getURL(), "'.");
 		}
 
 		// We loaded an external file, so check.
@@ -238,15 +398,15 @@ void Rom::init(MSXMotherBoard& motherBoard, const XMLElement& config,
 					Filename(p->getData(), context),
 					std::move(patch));
 			}
-			auto patchSize = unsigned(patch->getSize());
-			if (patchSize <= size) {
-				patch->copyBlock(0, const_cast<byte*>(rom), size);
-			} else {
-				size = patchSize;
-				extendedRom.resize(size);
-				patch->copyBlock(0, extendedRom.data(), size);
-				rom = extendedRom.data();
-			}
+			// Never patch in place: 'rom' can point to a (memory
+			// mapped) file, and for compressed files that memory is
+			// shared with all other users of the same file (e.g.
+			// another machine with the same system ROM).
+			size = std::max(size, unsigned(patch->getSize()));
+			MemBuffer<byte> patched(size);
+			patch->copyBlock(0, patched.data(), size);
+			extendedRom = std::move(patched);
+			rom = extendedRom.data();
 
 			// calculated because it's different from original
 			actualSha1 = SHA1::calc({rom, size});
@@ -268,7 +428,7 @@ void Rom::init(MSXMotherBoard& motherBoard, const XMLElement& config,
 			name = title;
 		} else {
 			// unknown ROM, use file name
-			name = file.getOriginalName();
+			name = file->getOriginalName();
 		}
 	}
 
@@ -292,7 +452,7 @@ void Rom::init(MSXMotherBoard& motherBoard, const XMLElement& config,
 			const_cast<XMLElement&>(config),
 			"resolvedSha1", doc.allocateString(patchedSha1Str));
 		if (actualSha1Elem->getData() != patchedSha1Str) {
-			std::string_view tmp = file.is_open() ? file.getURL() : name;
+			std::string_view tmp = file ? file->getURL() : name;
 			// can only happen in case of loadstate
 			motherBoard.getMSXCliComm().printWarning(
 				"The content of the rom ", tmp, " has "
@@ -349,7 +509,7 @@ Rom::~Rom() = default;
 
 std::string_view Rom::getFilename() const
 {
-	return file.is_open() ? file.getURL() : std::string_view();
+	return file ? file->getURL() : std::string_view();
 }
 
 const Sha1Sum& Rom::getOriginalSHA1() const
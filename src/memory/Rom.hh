@@ -51,7 +51,7 @@ private:
 	const byte* rom;
 	MemBuffer<byte> extendedRom;
 
-	File file; // can be a closed file
+	std::shared_ptr<File> file; // can be nullptr, can be shared with other Roms
 
 	mutable Sha1Sum originalSha1;
 	mutable Sha1Sum actualSha1;
@@ -65,6 +65,26 @@ private:
 	std::unique_ptr<RomDebuggable> romDebuggable; // can be nullptr
 };
 
+/** While an object of this class is alive, the files of all <rom> tags
+  * (below the given element) are opened, read and hashed in parallel, on
+  * the background WorkerPool. Rom objects that are created in the meantime
+  * (the devices are still constructed one by one) take their file from
+  * this prefetch instead of loading it themselves. Only the <filename>
+  * tags are used; ROMs that are located via the file pool, or via the
+  * resolved filename/sha1 (from a savestate), are loaded as before.
+  */
+class RomPrefetch
+{
+public:
+	RomPrefetch(const XMLElement& elem, const FileContext& context);
+	~RomPrefetch();
+	RomPrefetch(const RomPrefetch&) = delete;
+	RomPrefetch& operator=(const RomPrefetch&) = delete;
+
+private:
+	size_t first; // index of the first entry that belongs to this object
+};
+
 } // namespace openmsx
 
 #endif
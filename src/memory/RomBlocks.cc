@@ -2,6 +2,7 @@
 #include "RomBlocks.hh"
 #include "SRAM.hh"
 #include "Math.hh"
+#include "ranges.hh"
 #include "serialize.hh"
 #include "unreachable.hh"
 #include "xrange.hh"
@@ -42,6 +43,7 @@ RomBlocks<BANK_SIZE>::RomBlocks(
 
 	// Default mask: wraps at end of ROM image.
 	blockMask = nrBlocks - 1;
+	ranges::fill(bankPtr, nullptr); // so that setRom() below fills the cache
 	for (auto i : xrange(NUM_BANKS)) {
 		setRom(i, 0);
 	}
@@ -74,6 +76,18 @@ const byte* RomBlocks<BANK_SIZE>::getReadCacheLine(word address) const
 	return &bankPtr[address / BANK_SIZE][address & BANK_MASK];
 }
 
+template<unsigned BANK_SIZE>
+unsigned RomBlocks<BANK_SIZE>::getCoverageOffset(word address) const
+{
+	const byte* ptr = &bankPtr[address / BANK_SIZE][address & BANK_MASK];
+	if ((rom.getSize() != 0) &&
+	    (&rom[0] <= ptr) && (ptr <= &rom[rom.getSize() - 1])) {
+		return unsigned(ptr - &rom[0]);
+	}
+	// SRAM, unmapped, ...: put it behind the ROM image
+	return rom.getSize() + address;
+}
+
 template<unsigned BANK_SIZE>
 void RomBlocks<BANK_SIZE>::setBank(byte region, const byte* adr, int block)
 {
@@ -83,8 +97,12 @@ void RomBlocks<BANK_SIZE>::setBank(byte region, const byte* adr, int block)
 	        (sram && (&(*sram)[0] <= adr) &&
 	                       (adr <= &(*sram)[sram->getSize() - 1])) ||
 	        ((extraMem <= adr) && (adr <= &extraMem[extraSize - 1]))));
-	bankPtr[region] = adr;
 	blockNr[region] = block; // only for debuggable
+	// Many games (re)select the same bank very often, e.g. on every
+	// interrupt. Then the cache lines are already correct (or invalid,
+	// and then they'll be filled on demand with this same pointer).
+	if (bankPtr[region] == adr) return;
+	bankPtr[region] = adr;
 	fillDeviceRCache(region * BANK_SIZE, BANK_SIZE, adr);
 }
 
@@ -21,6 +21,7 @@ public:
 	[[nodiscard]] byte readMem(word address, EmuTime::param time) override;
 	[[nodiscard]] byte peekMem(word address, EmuTime::param time) const override;
 	[[nodiscard]] const byte* getReadCacheLine(word address) const override;
+	[[nodiscard]] unsigned getCoverageOffset(word address) const override;
 
 	template<typename Archive>
 	void serialize(Archive& ar, unsigned version);
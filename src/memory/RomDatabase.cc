@@ -1,18 +1,24 @@
 #include "RomDatabase.hh"
 #include "FileContext.hh"
 #include "File.hh"
+#include "FileOperations.hh"
 #include "CliComm.hh"
 #include "MSXException.hh"
 #include "StringOp.hh"
 #include "String32.hh"
+#include "Timer.hh"
 #include "hash_map.hh"
 #include "ranges.hh"
 #include "rapidsax.hh"
 #include "unreachable.hh"
 #include "stl.hh"
 #include "view.hh"
+#include "xrange.hh"
 #include "xxhash.hh"
 #include <cassert>
+#include <cstdio>
+#include <cstring>
+#include <type_traits>
 
 using std::string_view;
 
@@ -563,17 +569,187 @@ static void parseDB(CliComm& cliComm, char* buf, char* bufStart,
 	}
 }
 
+// The parsed database is stored in a binary cache file. As long as the
+// softwaredb.xml files don't change, the next start only needs to read this
+// file instead of parsing the (large) xml files again. The cache file uses
+// the native in-memory layout, so it's only valid for the exact same build
+// configuration (this is verified via the header).
+struct SourceFile {
+	std::string filename;
+	uint64_t size;
+	int64_t modificationTime;
+};
+using SourceFiles = std::vector<SourceFile>;
+
+static constexpr char CACHE_MAGIC[8] = "omsxSDB";
+static constexpr uint32_t CACHE_VERSION = 2; // 2: added RomType layout
+
+// Only on 64-bit platforms String32 is an offset in the buffer (instead of
+// a pointer), only then the buffer can be relocated.
+static constexpr bool CACHE_SUPPORTED = std::is_same_v<String32, uint32_t>;
+
+// The cache stores RomType values, so it must be invalidated when that enum
+// changes (types added, removed or reordered). Hash the names of all types in
+// enum order, this changes together with the enum.
+static uint32_t getRomTypeLayout()
+{
+	std::string names;
+	for (auto i : xrange(int(ROM_LAST))) {
+		strAppend(names, RomInfo::romTypeToName(RomType(i)), ',');
+	}
+	return xxhash(names);
+}
+
+static std::string getCacheFilename()
+{
+	return FileOperations::getUserDataDir() + "/.softwaredb.cache";
+}
+
+namespace {
+class CacheReader
+{
+public:
+	explicit CacheReader(span<const uint8_t> data_) : data(data_) {}
+
+	[[nodiscard]] const uint8_t* get(size_t num) {
+		if (num > data.size()) throw MSXException("truncated");
+		const auto* result = data.data();
+		data = data.subspan(num);
+		return result;
+	}
+	template<typename T> [[nodiscard]] T get() {
+		static_assert(std::is_trivially_copyable_v<T>);
+		T result;
+		memcpy(&result, get(sizeof(T)), sizeof(T));
+		return result;
+	}
+	void align(size_t alignment) {
+		(void)get(padding(offset(), alignment));
+	}
+	[[nodiscard]] size_t offset() const { return start.size() - data.size(); }
+	[[nodiscard]] size_t remaining() const { return data.size(); }
+
+	[[nodiscard]] static size_t padding(size_t off, size_t alignment) {
+		return (alignment - (off % alignment)) % alignment;
+	}
+
+private:
+	span<const uint8_t> data;
+	const span<const uint8_t> start = data;
+};
+}
+
+static bool loadCache(const SourceFiles& sources,
+                      RomDatabase::RomDB& db, MemBuffer<char>& buffer)
+{
+	if (!CACHE_SUPPORTED) return false;
+	try {
+		File file(getCacheFilename());
+		CacheReader in(file.mmap());
+		if (memcmp(in.get(sizeof(CACHE_MAGIC)), CACHE_MAGIC, sizeof(CACHE_MAGIC)) != 0) return false;
+		if (in.get<uint32_t>() != CACHE_VERSION) return false;
+		if (in.get<uint32_t>() != getRomTypeLayout()) return false;
+		if (in.get<uint32_t>() != sizeof(RomDatabase::Entry)) return false;
+		if (in.get<uint32_t>() != sources.size()) return false;
+		for (const auto& src : sources) {
+			auto len = in.get<uint32_t>();
+			auto* name = in.get(len);
+			if (string_view(reinterpret_cast<const char*>(name), len) != src.filename) return false;
+			if (in.get<uint64_t>() != src.size) return false;
+			if (in.get<int64_t>() != src.modificationTime) return false;
+		}
+		auto bufferSize = in.get<uint64_t>();
+		auto numEntries = in.get<uint64_t>();
+		const auto* bufData = in.get(bufferSize);
+		in.align(alignof(RomDatabase::Entry));
+		if (numEntries > in.remaining() / sizeof(RomDatabase::Entry)) return false;
+		const auto* entries = reinterpret_cast<const RomDatabase::Entry*>(
+			in.get(numEntries * sizeof(RomDatabase::Entry)));
+
+		buffer.resize(bufferSize);
+		if (bufferSize) memcpy(buffer.data(), bufData, bufferSize);
+		db.assign(entries, entries + numEntries);
+		return true;
+	} catch (MSXException& /*e*/) {
+		// no (valid) cache file
+		return false;
+	}
+}
+
+static void saveCache(const SourceFiles& sources,
+                      const RomDatabase::RomDB& db, const MemBuffer<char>& buffer,
+                      size_t bufferSize)
+{
+	if (!CACHE_SUPPORTED) return;
+	static_assert(std::is_trivially_copyable_v<RomDatabase::Entry>);
+	// Many openMSX processes may start at the same time, so first write to
+	// a temporary file and then (atomically) rename it.
+	auto filename = getCacheFilename();
+	auto tmpName = strCat(filename, '.', Timer::getTime());
+	try {
+		{
+			File file(tmpName, File::TRUNCATE);
+			auto write = [&](const auto& v) { file.write(&v, sizeof(v)); };
+			file.write(CACHE_MAGIC, sizeof(CACHE_MAGIC));
+			write(CACHE_VERSION);
+			write(getRomTypeLayout());
+			write(uint32_t(sizeof(RomDatabase::Entry)));
+			write(uint32_t(sources.size()));
+			size_t offset = sizeof(CACHE_MAGIC) + 4 * sizeof(uint32_t);
+			for (const auto& src : sources) {
+				write(uint32_t(src.filename.size()));
+				file.write(src.filename.data(), src.filename.size());
+				write(src.size);
+				write(src.modificationTime);
+				offset += sizeof(uint32_t) + src.filename.size() + 2 * sizeof(uint64_t);
+			}
+			write(uint64_t(bufferSize));
+			write(uint64_t(db.size()));
+			offset += 2 * sizeof(uint64_t);
+			if (bufferSize) file.write(buffer.data(), bufferSize);
+			offset += bufferSize;
+			static constexpr char zeros[alignof(RomDatabase::Entry)] = {};
+			file.write(zeros, CacheReader::padding(offset, alignof(RomDatabase::Entry)));
+			file.write(db.data(), db.size() * sizeof(RomDatabase::Entry));
+		}
+		if (std::rename(tmpName.c_str(), filename.c_str()) != 0) {
+			// windows can't rename onto an existing file
+			FileOperations::unlink(filename);
+			if (std::rename(tmpName.c_str(), filename.c_str()) != 0) {
+				FileOperations::unlink(tmpName);
+			}
+		}
+	} catch (MSXException& /*e*/) {
+		// Couldn't write cache, not a problem (next time we parse again).
+		FileOperations::unlink(tmpName);
+	}
+}
+
 RomDatabase::RomDatabase(CliComm& cliComm)
 {
-	db.reserve(3500);
-	UnknownTypes unknownTypes;
 	// first user- then system-directory
 	std::vector<std::string> paths = systemFileContext().getPaths();
+	SourceFiles sources;
+	for (auto& p : paths) {
+		auto filename = p + "/softwaredb.xml";
+		FileOperations::Stat st;
+		if (FileOperations::getStat(filename, st) && FileOperations::isRegularFile(st)) {
+			sources.push_back({std::move(filename), uint64_t(st.st_size),
+			                   int64_t(st.st_mtime)});
+		}
+	}
+	if (!sources.empty() && loadCache(sources, db, buffer)) {
+		buildIndex();
+		return;
+	}
+
+	db.reserve(3500);
+	UnknownTypes unknownTypes;
 	std::vector<File> files;
 	size_t bufferSize = 0;
-	for (auto& p : paths) {
+	for (auto& src : sources) {
 		try {
-			auto& f = files.emplace_back(p + "/softwaredb.xml");
+			auto& f = files.emplace_back(src.filename);
 			bufferSize += f.getSize() + rapidsax::EXTRA_BUFFER_SPACE;
 		} catch (MSXException& /*e*/) {
 			// Ignore. It's not unusual the DB in the user
@@ -584,6 +760,7 @@ RomDatabase::RomDatabase(CliComm& cliComm)
 	}
 	buffer.resize(bufferSize);
 	size_t bufferOffset = 0;
+	bool parseError = files.size() != sources.size();
 	for (auto& file : files) {
 		try {
 			auto size = file.getSize();
@@ -594,10 +771,12 @@ RomDatabase::RomDatabase(CliComm& cliComm)
 
 			parseDB(cliComm, buf, buffer.data(), db, unknownTypes);
 		} catch (rapidsax::ParseError& e) {
+			parseError = true;
 			cliComm.printWarning(
 				"Rom database parsing failed: ", e.what());
 		} catch (MSXException& /*e*/) {
 			// Ignore, see above
+			parseError = true;
 		}
 	}
 	if (bufferSize) buffer[0] = 0;
@@ -613,13 +792,34 @@ RomDatabase::RomDatabase(CliComm& cliComm)
 		}
 		cliComm.printWarning(output);
 	}
+	if (!parseError && !db.empty()) {
+		saveCache(sources, db, buffer, bufferSize);
+	}
+	buildIndex();
+}
+
+void RomDatabase::buildIndex()
+{
+	constexpr unsigned NUM = 1 << INDEX_BITS;
+	index.resize(NUM + 1);
+	size_t pos = 0;
+	for (auto i : xrange(NUM)) {
+		while ((pos < db.size()) &&
+		       ((db[pos].sha1.getPrefix32() >> (32 - INDEX_BITS)) < i)) {
+			++pos;
+		}
+		index[i] = uint32_t(pos);
+	}
+	index[NUM] = uint32_t(db.size());
 }
 
 const RomInfo* RomDatabase::fetchRomInfo(const Sha1Sum& sha1sum) const
 {
-	auto it = ranges::lower_bound(db, sha1sum, {}, &Entry::sha1);
-	return ((it != end(db)) && (it->sha1 == sha1sum))
-		? &it->romInfo : nullptr;
+	auto i = sha1sum.getPrefix32() >> (32 - INDEX_BITS);
+	for (auto p : xrange(index[i], index[i + 1])) {
+		if (db[p].sha1 == sha1sum) return &db[p].romInfo;
+	}
+	return nullptr;
 }
 
 } // namespace openmsx
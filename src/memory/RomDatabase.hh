@@ -4,6 +4,7 @@
 #include "MemBuffer.hh"
 #include "RomInfo.hh"
 #include "sha1.hh"
+#include <cstdint>
 #include <vector>
 
 namespace openmsx {
@@ -29,7 +30,17 @@ public:
 	[[nodiscard]] const char* getBufferStart() const { return buffer.data(); }
 
 private:
+	void buildIndex();
+
+private:
+	// The db is sorted on sha1 and sha1 values are uniformly distributed,
+	// so the first INDEX_BITS bits of the sha1 directly select a (very
+	// short) range of entries: index[i] is the position of the first
+	// entry whose prefix is >= i. This replaces the binary search.
+	static constexpr unsigned INDEX_BITS = 12;
+
 	RomDB db;
+	std::vector<uint32_t> index; // 2^INDEX_BITS + 1 entries
 	MemBuffer<char> buffer;
 };
 
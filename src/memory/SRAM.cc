@@ -4,11 +4,15 @@
 #include "FileContext.hh"
 #include "FileException.hh"
 #include "FileNotFoundException.hh"
+#include "FileOperations.hh"
 #include "Reactor.hh"
 #include "CliComm.hh"
 #include "serialize.hh"
 #include "openmsx.hh"
+#include "ranges.hh"
+#include "strCat.hh"
 #include "vla.hh"
+#include <algorithm>
 #include <cstring>
 
 namespace openmsx {
@@ -40,7 +44,9 @@ SRAM::SRAM(const std::string& name, int size,
 	, config(config_)
 	, ram(config, name, "sram", size)
 	, header(header_)
+	, unsavedBlocks(((size - 1) >> SAVE_BLOCK_BITS) + 1, false)
 {
+	ram.setDebugWriteCallback([this](unsigned addr) { markUnsaved(addr, 1); });
 	load(loaded);
 }
 
@@ -50,7 +56,9 @@ SRAM::SRAM(const std::string& name, static_string_view description, int size,
 	, config(config_)
 	, ram(config, name, description, size)
 	, header(header_)
+	, unsavedBlocks(((size - 1) >> SAVE_BLOCK_BITS) + 1, false)
 {
+	ram.setDebugWriteCallback([this](unsigned addr) { markUnsaved(addr, 1); });
 	load(loaded);
 }
 
@@ -67,6 +75,7 @@ void SRAM::write(unsigned addr, byte value)
 		schedulable->scheduleRT(5000000); // sync to disk after 5s
 	}
 	assert(addr < getSize());
+	markUnsaved(addr, 1);
 	ram.write(addr, value);
 }
 
@@ -76,7 +85,23 @@ void SRAM::memset(unsigned addr, byte c, unsigned size)
 		schedulable->scheduleRT(5000000); // sync to disk after 5s
 	}
 	assert((addr + size) <= getSize());
-	::memset(ram.getWriteBackdoor() + addr, c, size);
+	if (size == 0) return;
+	markUnsaved(addr, size);
+	::memset(ram.getWriteBackdoor(addr, size), c, size);
+}
+
+void SRAM::markUnsaved(unsigned addr, unsigned size)
+{
+	if (unsavedBlocks.empty()) return; // not persistent
+	for (auto b : xrange(addr >> SAVE_BLOCK_BITS,
+	                     ((addr + size - 1) >> SAVE_BLOCK_BITS) + 1)) {
+		unsavedBlocks[b] = true;
+	}
+}
+
+void SRAM::setAllUnsaved()
+{
+	ranges::fill(unsavedBlocks, true);
 }
 
 void SRAM::load(bool* loaded)
@@ -99,6 +124,7 @@ void SRAM::load(bool* loaded)
 		if (headerOk) {
 			file.read(ram.getWriteBackdoor(), getSize());
 			loadedFilename = file.getURL();
+			fileInSync = true;
 			if (loaded) *loaded = true;
 		} else {
 			config.getCliComm().printWarning(
@@ -115,18 +141,64 @@ void SRAM::load(bool* loaded)
 	}
 }
 
+// Only write the changed blocks, for big flash roms this is a lot faster than
+// rewriting the whole file (e.g. every few seconds while the MSX is writing).
+// Returns false if the file has to be rewritten completely.
+bool SRAM::saveChanged(const std::string& filename)
+{
+	if (!fileInSync) return false;
+	try {
+		File file(filename, File::NORMAL);
+		size_t headerLen = header ? strlen(header) : 0;
+		if (file.isReadOnly() || // also for compressed files
+		    (file.getSize() != (headerLen + getSize()))) {
+			return false;
+		}
+		unsigned numBlocks = unsigned(unsavedBlocks.size());
+		unsigned b = 0;
+		while (b < numBlocks) {
+			if (!unsavedBlocks[b]) { ++b; continue; }
+			// write a run of consecutive changed blocks at once
+			unsigned e = b + 1;
+			while ((e < numBlocks) && unsavedBlocks[e]) ++e;
+			unsigned begin = b << SAVE_BLOCK_BITS;
+			unsigned end = std::min(e << SAVE_BLOCK_BITS, getSize());
+			file.seek(headerLen + begin);
+			file.write(&ram[begin], end - begin);
+			b = e;
+		}
+		return true;
+	} catch (FileException&) {
+		return false;
+	}
+}
+
 void SRAM::save()
 {
 	assert(config.getXML());
 	const auto& filename = config.getChildData("sramname");
 	try {
-		File file(config.getFileContext().resolveCreate(filename),
-			  File::SAVE_PERSISTENT);
-		if (header) {
-			int length = int(strlen(header));
-			file.write(header, length);
+		auto resolved = config.getFileContext().resolveCreate(filename);
+		if (!saveChanged(resolved)) {
+			// Write the complete file under a temporary name and
+			// then (atomically) replace the old file, so that a
+			// crash halfway doesn't destroy the existing save data.
+			auto tmpName = strCat(resolved, ".tmp");
+			{
+				File file(tmpName, File::SAVE_PERSISTENT);
+				if (header) {
+					int length = int(strlen(header));
+					file.write(header, length);
+				}
+				file.write(&ram[0], getSize());
+			}
+			if (FileOperations::rename(tmpName, resolved) != 0) {
+				FileOperations::unlink(tmpName);
+				throw FileException("Couldn't replace file");
+			}
 		}
-		file.write(&ram[0], getSize());
+		ranges::fill(unsavedBlocks, false);
+		fileInSync = true;
 	} catch (FileException& e) {
 		config.getCliComm().printWarning(
 			"Couldn't save SRAM ", filename,
@@ -143,6 +215,9 @@ template<typename Archive>
 void SRAM::serialize(Archive& ar, unsigned /*version*/)
 {
 	ar.serialize("ram", ram);
+	if constexpr (Archive::IS_LOADER) {
+		setAllUnsaved();
+	}
 }
 INSTANTIATE_SERIALIZE_METHODS(SRAM);
 
@@ -5,6 +5,7 @@
 #include "DeviceConfig.hh"
 #include "RTSchedulable.hh"
 #include <optional>
+#include <vector>
 
 namespace openmsx {
 
@@ -52,11 +53,20 @@ private:
 
 	void load(bool* loaded);
 	void save();
+	[[nodiscard]] bool saveChanged(const std::string& filename);
+	void markUnsaved(unsigned addr, unsigned size);
+	void setAllUnsaved();
 
 	const DeviceConfig config;
 	TrackedRam ram;
 	const char* const header;
 
+	// Only the blocks that changed since the last load/save are written
+	// to the file (if it's known to contain the other blocks).
+	static constexpr unsigned SAVE_BLOCK_BITS = 12;
+	std::vector<bool> unsavedBlocks;
+	bool fileInSync = false; // file content matches 'ram' (except 'unsavedBlocks')
+
 	std::string loadedFilename;
 };
 
@@ -47,12 +47,22 @@ SdCard::SdCard(const DeviceConfig& config)
 SdCard::~SdCard() = default;
 
 // helper methods for 'transfer' to avoid duplication
+void SdCard::readCurrentSector()
+{
+	if (mode == MULTI_READ) {
+		// the sectors are read in sequence
+		readAhead.read(*hd, currentSector, hd->getNbSectors(), sectorBuf);
+	} else {
+		hd->readSector(currentSector, sectorBuf);
+	}
+}
+
 byte SdCard::readCurrentByteFromCurrentSector()
 {
 	byte result = [&] {
 		if (currentByteInSector == -1) {
 			try {
-				hd->readSector(currentSector, sectorBuf);
+				readCurrentSector();
 				return START_BLOCK_TOKEN;
 			} catch (MSXException&) {
 				return DATA_ERROR_TOKEN_ERROR;
@@ -287,6 +297,8 @@ void SdCard::executeCommand()
 	case 25: // WRITE_MULTIPLE_BLOCK
 		// SDHC so the address is the sector
 		currentSector = Endian::readB32(&cmdBuf[1]);
+		readAhead.invalidate(); // (possibly) stale after a write
+
 		if (currentSector >= hd->getNbSectors()) {
 			responseQueue.push_back(R1_PARAMETER_ERROR);
 		} else {
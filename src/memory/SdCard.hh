@@ -4,6 +4,7 @@
 #include "openmsx.hh"
 #include "circular_buffer.hh"
 #include "DiskImageUtils.hh"
+#include "SectorReadAhead.hh"
 #include <memory>
 
 namespace openmsx {
@@ -34,6 +35,7 @@ public:
 private:
 	void executeCommand();
 	[[nodiscard]] byte readCurrentByteFromCurrentSector();
+	void readCurrentSector();
 
 private:
 	const std::unique_ptr<HD> hd; // can be nullptr
@@ -48,6 +50,8 @@ private:
 	Mode mode;
 	unsigned currentSector;
 	int currentByteInSector;
+
+	SectorReadAhead readAhead{32}; // for MULTI_READ
 };
 
 } // namespace openmsx
@@ -9,9 +9,15 @@ void TrackedRam::serialize(Archive& ar, unsigned /*version*/)
 	// Note: This is the exact same serialization format as the Ram class.
 	//  This allows to change from Ram to TrackedRam without having to
 	//  increase the class serialization version (of the user).
-	bool diff = writeSinceLastReverseSnapshot || !ar.isReverseSnapshot();
-	ar.serialize_blob("ram", &ram[0], getSize(), diff);
-	if (ar.isReverseSnapshot()) writeSinceLastReverseSnapshot = false;
+	if constexpr (Archive::IS_LOADER) {
+		ar.serialize_blob("ram", &ram[0], getSize());
+		setAllDirty();
+	} else if (ar.isReverseSnapshot()) {
+		ar.serialize_blob("ram", &ram[0], getSize(), dirtyPages, PAGE_SIZE);
+		ranges::fill(dirtyPages, false);
+	} else {
+		ar.serialize_blob("ram", &ram[0], getSize());
+	}
 }
 INSTANTIATE_SERIALIZE_METHODS(TrackedRam);
 
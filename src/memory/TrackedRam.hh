@@ -2,20 +2,38 @@
 #define TRACKED_RAM_HH
 
 #include "Ram.hh"
+#include "ranges.hh"
+#include "xrange.hh"
+#include <cassert>
+#include <functional>
+#include <vector>
 
 namespace openmsx {
 
 // Ram with dirty tracking
+//
+// Writes are tracked per page (of PAGE_SIZE bytes). When creating a reverse
+// snapshot only the pages written since the previous snapshot have to be
+// compared against the reference block (see LastDeltaBlocks), so the cost
+// scales with the amount of changed memory instead of the total size.
 class TrackedRam
 {
 public:
+	static constexpr unsigned PAGE_BITS = 10;
+	static constexpr unsigned PAGE_SIZE = 1 << PAGE_BITS;
+
 	// Most methods simply delegate to the internal 'ram' object.
 	TrackedRam(const DeviceConfig& config, const std::string& name,
 	           static_string_view description, unsigned size)
-		: ram(config, name, description, size) {}
+		: ram(config, name, description, size)
+		, dirtyPages(numPages(size), true)
+	{
+		setDebugWriteCallback({});
+	}
 
 	TrackedRam(const XMLElement& xml, unsigned size)
-		: ram(xml, size) {}
+		: ram(xml, size)
+		, dirtyPages(numPages(size), true) {}
 
 	[[nodiscard]] unsigned getSize() const {
 		return ram.getSize();
@@ -36,12 +54,12 @@ public:
 
 	// Only allow write/clear via an explicit method.
 	void write(unsigned addr, byte value) {
-		writeSinceLastReverseSnapshot = true;
+		dirtyPages[addr >> PAGE_BITS] = true;
 		ram[addr] = value;
 	}
 
 	void clear(byte c = 0xff) {
-		writeSinceLastReverseSnapshot = true;
+		setAllDirty();
 		ram.clear(c);
 	}
 
@@ -50,16 +68,45 @@ public:
 	// invocation, so the resulting pointer (although the same each time)
 	// should not be reused for multiple (distinct) bulk write operations.
 	[[nodiscard]] byte* getWriteBackdoor() {
-		writeSinceLastReverseSnapshot = true;
+		setAllDirty();
 		return &ram[0];
 	}
 
+	// Same, but only marks the pages of the range [addr, addr + num) as
+	// dirty. So the resulting pointer may only be used to write that range.
+	[[nodiscard]] byte* getWriteBackdoor(unsigned addr, unsigned num) {
+		assert(num && ((addr + num) <= getSize()));
+		for (auto page : xrange(addr >> PAGE_BITS, ((addr + num - 1) >> PAGE_BITS) + 1)) {
+			dirtyPages[page] = true;
+		}
+		return &ram[addr];
+	}
+
+	// Writes via the debuggable bypass write(), but they are also
+	// tracked. Optionally 'callback' is called after such a write.
+	void setDebugWriteCallback(std::function<void(unsigned)> callback) {
+		ram.setDebugWriteCallback(
+			[this, callback = std::move(callback)](unsigned addr) {
+				dirtyPages[addr >> PAGE_BITS] = true;
+				if (callback) callback(addr);
+			});
+	}
+
 	template<typename Archive>
 	void serialize(Archive& ar, unsigned version);
 
+private:
+	[[nodiscard]] static unsigned numPages(unsigned size) {
+		return (size + PAGE_SIZE - 1) >> PAGE_BITS;
+	}
+	void setAllDirty() {
+		ranges::fill(dirtyPages, true);
+	}
+
 private:
 	Ram ram;
-	bool writeSinceLastReverseSnapshot = true;
+	// pages written since the last reverse snapshot
+	std::vector<bool> dirtyPages;
 };
 
 } // namespace openmsx
@@ -4,8 +4,6 @@
 #include "MidiInConnector.hh"
 #include "PluggingController.hh"
 #include "PlugException.hh"
-#include "EventDistributor.hh"
-#include "Scheduler.hh"
 #include "serialize.hh"
 #include "StringOp.hh"
 #include "xrange.hh"
@@ -18,21 +16,21 @@ namespace openmsx {
 // MidiInCoreMIDI ===========================================================
 
 void MidiInCoreMIDI::registerAll(EventDistributor& eventDistributor,
-                                 Scheduler& scheduler,
+                                 Scheduler& scheduler, RealTime& realTime,
                                  PluggingController& controller)
 {
 	for (auto i : xrange(MIDIGetNumberOfSources())) {
 		if (MIDIEndpointRef endpoint = MIDIGetSource(i)) {
 			controller.registerPluggable(std::make_unique<MidiInCoreMIDI>(
-					eventDistributor, scheduler, endpoint));
+					eventDistributor, scheduler, realTime, endpoint));
 		}
 	}
 }
 
 MidiInCoreMIDI::MidiInCoreMIDI(EventDistributor& eventDistributor_,
-                               Scheduler& scheduler_, MIDIEndpointRef endpoint_)
-	: eventDistributor(eventDistributor_)
-	, scheduler(scheduler_)
+                               Scheduler& scheduler_, RealTime& realTime_,
+                               MIDIEndpointRef endpoint_)
+	: MidiInHostDevice(eventDistributor_, scheduler_, realTime_)
 	, endpoint(endpoint_)
 {
 	// Get a user-presentable name for the endpoint.
@@ -49,16 +47,9 @@ MidiInCoreMIDI::MidiInCoreMIDI(EventDistributor& eventDistributor_,
 		name = strCat(StringOp::fromCFString(midiDeviceName), " IN");
 		CFRelease(midiDeviceName);
 	}
-
-	eventDistributor.registerEventListener(
-			EventType::MIDI_IN_COREMIDI, *this);
 }
 
-MidiInCoreMIDI::~MidiInCoreMIDI()
-{
-	eventDistributor.unregisterEventListener(
-			EventType::MIDI_IN_COREMIDI, *this);
-}
+MidiInCoreMIDI::~MidiInCoreMIDI() = default;
 
 void MidiInCoreMIDI::plugHelper(Connector& /*connector*/, EmuTime::param /*time*/)
 {
@@ -107,52 +98,11 @@ void MidiInCoreMIDI::sendPacketList(const MIDIPacketList *packetList,
 
 void MidiInCoreMIDI::sendPacketList(const MIDIPacketList *packetList,
                                     void * /*srcConnRefCon*/) {
-	{
-		std::lock_guard<std::mutex> lock(mutex);
-		const MIDIPacket* packet = &packetList->packet[0];
-		repeat(packetList->numPackets, [&] {
-			for (auto j : xrange(packet->length)) {
-				queue.push_back(packet->data[j]);
-			}
-			packet = MIDIPacketNext(packet);
-		});
-	}
-	eventDistributor.distributeEvent(
-		Event::create<MidiInCoreMidiEvent>());
-}
-
-// MidiInDevice
-void MidiInCoreMIDI::signal(EmuTime::param time)
-{
-	auto connector = static_cast<MidiInConnector*>(getConnector());
-	if (!connector->acceptsData()) {
-		std::lock_guard<std::mutex> lock(mutex);
-		queue.clear();
-		return;
-	}
-	if (!connector->ready()) {
-		return;
-	}
-
-	byte data;
-	{
-		std::lock_guard<std::mutex> lock(mutex);
-		if (queue.empty()) return;
-		data = queue.pop_front();
-	}
-	connector->recvByte(data, time);
-}
-
-// EventListener
-int MidiInCoreMIDI::signalEvent(const Event& /*event*/) noexcept
-{
-	if (isPluggedIn()) {
-		signal(scheduler.getCurrentTime());
-	} else {
-		std::lock_guard<std::mutex> lock(mutex);
-		queue.clear();
-	}
-	return 0;
+	const MIDIPacket* packet = &packetList->packet[0];
+	repeat(packetList->numPackets, [&] {
+		push(span<const uint8_t>(packet->data, packet->length));
+		packet = MIDIPacketNext(packet);
+	});
 }
 
 template<typename Archive>
@@ -166,21 +116,15 @@ REGISTER_POLYMORPHIC_INITIALIZER(Pluggable, MidiInCoreMIDI, "MidiInCoreMIDI");
 // MidiInCoreMIDIVirtual ====================================================
 
 MidiInCoreMIDIVirtual::MidiInCoreMIDIVirtual(EventDistributor& eventDistributor_,
-                                             Scheduler& scheduler_)
-	: eventDistributor(eventDistributor_)
-	, scheduler(scheduler_)
+                                             Scheduler& scheduler_,
+                                             RealTime& realTime_)
+	: MidiInHostDevice(eventDistributor_, scheduler_, realTime_)
 	, client(0)
 	, endpoint(0)
 {
-	eventDistributor.registerEventListener(
-			EventType::MIDI_IN_COREMIDI_VIRTUAL, *this);
 }
 
-MidiInCoreMIDIVirtual::~MidiInCoreMIDIVirtual()
-{
-	eventDistributor.unregisterEventListener(
-			EventType::MIDI_IN_COREMIDI_VIRTUAL, *this);
-}
+MidiInCoreMIDIVirtual::~MidiInCoreMIDIVirtual() = default;
 
 void MidiInCoreMIDIVirtual::plugHelper(Connector& /*connector*/,
                                        EmuTime::param /*time*/)
@@ -232,53 +176,11 @@ void MidiInCoreMIDIVirtual::sendPacketList(const MIDIPacketList *packetList,
 void MidiInCoreMIDIVirtual::sendPacketList(const MIDIPacketList *packetList,
                                            void * /*srcConnRefCon*/)
 {
-	{
-		std::lock_guard<std::mutex> lock(mutex);
-		const MIDIPacket* packet = &packetList->packet[0];
-		repeat(packetList->numPackets, [&] {
-			for (auto j : xrange(packet->length)) {
-				queue.push_back(packet->data[j]);
-			}
-			packet = MIDIPacketNext(packet);
-		});
-	}
-	eventDistributor.distributeEvent(
-		Event::create<MidiInCoreMidiVirtualEvent>());
-}
-
-// MidiInDevice
-void MidiInCoreMIDIVirtual::signal(EmuTime::param time)
-{
-	auto connector = static_cast<MidiInConnector*>(getConnector());
-	if (!connector->acceptsData()) {
-		std::lock_guard<std::mutex> lock(mutex);
-		queue.clear();
-		return;
-	}
-	if (!connector->ready()) {
-		return;
-	}
-
-	byte data;
-	{
-		std::lock_guard<std::mutex> lock(mutex);
-		if (queue.empty()) return;
-		data = queue.pop_front();
-	}
-	connector->recvByte(data, time);
-}
-
-// EventListener
-int MidiInCoreMIDIVirtual::signalEvent(
-		const Event& /*event*/) noexcept
-{
-	if (isPluggedIn()) {
-		signal(scheduler.getCurrentTime());
-	} else {
-		std::lock_guard<std::mutex> lock(mutex);
-		queue.clear();
-	}
-	return 0;
+	const MIDIPacket* packet = &packetList->packet[0];
+	repeat(packetList->numPackets, [&] {
+		push(span<const uint8_t>(packet->data, packet->length));
+		packet = MIDIPacketNext(packet);
+	});
 }
 
 template<typename Archive>
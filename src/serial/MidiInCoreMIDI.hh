@@ -3,33 +3,29 @@
 
 #if defined(__APPLE__)
 
-#include "MidiInDevice.hh"
-#include "EventListener.hh"
-#include "openmsx.hh"
+#include "MidiInHostDevice.hh"
 #include "serialize_meta.hh"
-#include "circular_buffer.hh"
 #include <CoreMIDI/MIDIServices.h>
-#include <mutex>
 
 namespace openmsx {
 
-class EventDistributor;
-class Scheduler;
 class PluggingController;
 
 /** Sends MIDI events to an existing CoreMIDI destination.
   */
-class MidiInCoreMIDI final : public MidiInDevice, private EventListener
+class MidiInCoreMIDI final : public MidiInHostDevice
 {
 public:
 	static void registerAll(EventDistributor& eventDistributor,
-                            Scheduler& scheduler, PluggingController& controller);
+	                        Scheduler& scheduler, RealTime& realTime,
+	                        PluggingController& controller);
 
 	/** Public for the sake of make_unique<>() - not intended for actual
 	  * public use.
 	  */
-	explicit MidiInCoreMIDI(EventDistributor& eventDistributor_,
-                            Scheduler& scheduler_, MIDIEndpointRef endpoint);
+	explicit MidiInCoreMIDI(EventDistributor& eventDistributor,
+	                        Scheduler& scheduler, RealTime& realTime,
+	                        MIDIEndpointRef endpoint);
 	~MidiInCoreMIDI();
 
 	// Pluggable
@@ -38,27 +34,16 @@ public:
 	[[nodiscard]] std::string_view getName() const override;
 	[[nodiscard]] std::string_view getDescription() const override;
 
-	// MidiInDevice
-	void signal(EmuTime::param time) override;
-
 	template<typename Archive>
 	void serialize(Archive& ar, unsigned version);
 
 
 private:
-	// EventListener
-	int signalEvent(const Event& event) noexcept override;
-
 	static void sendPacketList(const MIDIPacketList *pktlist,
 	                           void *readProcRefCon, void *srcConnRefCon);
 	void sendPacketList(const MIDIPacketList *pktlist, void *srcConnRefCon);
 
 private:
-	EventDistributor& eventDistributor;
-	Scheduler& scheduler;
-	cb_queue<byte> queue;
-	std::mutex mutex; // to protect queue
-
 	MIDIClientRef client;
 	MIDIPortRef port;
 	MIDIEndpointRef endpoint;
@@ -71,11 +56,11 @@ private:
   * to a MIDI output. It is similar to using an IAC bus, but doesn't require
   * prior configuration to work.
   */
-class MidiInCoreMIDIVirtual final : public MidiInDevice, private EventListener
+class MidiInCoreMIDIVirtual final : public MidiInHostDevice
 {
 public:
-	explicit MidiInCoreMIDIVirtual(EventDistributor& eventDistributor_,
-                                   Scheduler& scheduler_);
+	explicit MidiInCoreMIDIVirtual(EventDistributor& eventDistributor,
+	                               Scheduler& scheduler, RealTime& realTime);
 	~MidiInCoreMIDIVirtual();
 
 	// Pluggable
@@ -84,25 +69,14 @@ public:
 	std::string_view getName() const override;
 	std::string_view getDescription() const override;
 
-	// MidiInDevice
-	void signal(EmuTime::param time) override;
-
 	template<typename Archive>
 	void serialize(Archive& ar, unsigned version);
 
 private:
-	// EventListener
-	int signalEvent(const Event& event) noexcept override;
-
 	static void sendPacketList(const MIDIPacketList *pktlist,
 	                           void *readProcRefCon, void *srcConnRefCon);
 	void sendPacketList(const MIDIPacketList *pktlist, void *srcConnRefCon);
 
-	EventDistributor& eventDistributor;
-	Scheduler& scheduler;
-	cb_queue<byte> queue;
-	std::mutex mutex; // to protect queue
-
 	MIDIClientRef client;
 	MIDIEndpointRef endpoint;
 };
@@ -0,0 +1,103 @@
+#include "MidiInHostDevice.hh"
+#include "MidiInConnector.hh"
+#include "EventDistributor.hh"
+#include "RealTime.hh"
+#include "Timer.hh"
+
+namespace openmsx {
+
+// About 1.3 seconds of MIDI data at the maximum rate (3125 bytes/s).
+constexpr size_t QUEUE_SIZE = 4096;
+
+// When the time stamps would delay a byte by more than this, the emulation
+// runs slower than real time (or it was paused). Then don't let the delay grow
+// further, start again from the current time.
+constexpr auto MAX_DELAY = EmuDuration::msec(100);
+
+MidiInHostDevice::MidiInHostDevice(
+		EventDistributor& eventDistributor_, Scheduler& scheduler_,
+		RealTime& realTime_)
+	: Schedulable(scheduler_)
+	, eventDistributor(eventDistributor_)
+	, realTime(realTime_)
+	, queue(QUEUE_SIZE)
+{
+	eventDistributor.registerEventListener(EventType::MIDI_IN, *this);
+}
+
+MidiInHostDevice::~MidiInHostDevice()
+{
+	eventDistributor.unregisterEventListener(EventType::MIDI_IN, *this);
+}
+
+void MidiInHostDevice::push(span<const uint8_t> data)
+{
+	auto now = Timer::getTime();
+	for (auto value : data) {
+		if (!queue.push({now, value})) break; // full
+	}
+	// Only wake up the main thread when it isn't already going to look at
+	// the queue.
+	if (!eventPending.exchange(true)) {
+		eventDistributor.distributeEvent(Event::create<MidiInEvent>());
+	}
+}
+
+EmuTime MidiInHostDevice::getEmuTime(uint64_t hostTime, EmuTime::param now)
+{
+	if (hostTime >= baseHostTime) {
+		auto result = baseEmuTime +
+			realTime.getEmuDuration(double(hostTime - baseHostTime) / 1000000.0);
+		if ((now <= result) && (result <= (now + MAX_DELAY))) {
+			return result;
+		}
+	}
+	// The first byte after a pause in the data, or the emulation can't
+	// keep up with the time stamps: map this byte to the current time.
+	baseHostTime = hostTime;
+	baseEmuTime = now;
+	return now;
+}
+
+void MidiInHostDevice::signal(EmuTime::param time)
+{
+	auto* conn = static_cast<MidiInConnector*>(getConnector());
+	if (!conn->acceptsData()) {
+		queue.clear();
+		return;
+	}
+	if (!conn->ready()) return;
+
+	auto* entry = queue.front();
+	if (!entry) return;
+	auto t = getEmuTime(entry->hostTime, time);
+	if (t > time) {
+		// too early, try again later
+		removeSyncPoints();
+		setSyncPoint(t);
+		return;
+	}
+	auto value = entry->value;
+	queue.pop();
+	conn->recvByte(value, time);
+}
+
+void MidiInHostDevice::executeUntil(EmuTime::param time)
+{
+	if (isPluggedIn()) signal(time);
+}
+
+int MidiInHostDevice::signalEvent(const Event& /*event*/) noexcept
+{
+	// The event is shared by all MIDI-in devices. Reset the flag before
+	// looking at the queue, so that new data always triggers a new event.
+	if (!eventPending.exchange(false)) return 0;
+	if (isPluggedIn()) {
+		signal(getCurrentTime());
+	} else {
+		queue.clear();
+	}
+	return 0;
+}
+
+} // namespace openmsx
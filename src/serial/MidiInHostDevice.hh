@@ -0,0 +1,70 @@
+#ifndef MIDIINHOSTDEVICE_HH
+#define MIDIINHOSTDEVICE_HH
+
+#include "MidiInDevice.hh"
+#include "EventListener.hh"
+#include "Schedulable.hh"
+#include "span.hh"
+#include "spsc_queue.hh"
+#include <atomic>
+#include <cstdint>
+
+namespace openmsx {
+
+class EventDistributor;
+class RealTime;
+
+/** Common part of the MIDI-in devices that receive their data from the host,
+  * on another thread (a reader thread or a callback from the OS).
+  *
+  * That thread calls push(). The data goes through a lock-free queue to the
+  * emulation thread, which is only woken up when the queue was empty (not
+  * for every byte). Each byte gets a host time stamp, so that the spacing
+  * between the bytes in emulated time follows the spacing in real time
+  * (though never faster than the emulated UART accepts them).
+  */
+class MidiInHostDevice : public MidiInDevice, private EventListener
+                       , private Schedulable
+{
+public:
+	// MidiInDevice
+	void signal(EmuTime::param time) final;
+
+protected:
+	MidiInHostDevice(EventDistributor& eventDistributor, Scheduler& scheduler,
+	                 RealTime& realTime);
+	~MidiInHostDevice();
+
+	/** Add data to the queue. Called from the host thread. When the queue
+	  * is full the data is dropped. */
+	void push(span<const uint8_t> data);
+	void push(uint8_t data) { push(span<const uint8_t>(&data, 1)); }
+
+private:
+	[[nodiscard]] EmuTime getEmuTime(uint64_t hostTime, EmuTime::param now);
+
+	// EventListener
+	int signalEvent(const Event& event) noexcept override;
+
+	// Schedulable
+	void executeUntil(EmuTime::param time) override;
+
+private:
+	EventDistributor& eventDistributor;
+	RealTime& realTime;
+
+	struct Entry {
+		uint64_t hostTime; // in us, see Timer::getTime()
+		uint8_t value;
+	};
+	spsc_queue<Entry> queue;
+	std::atomic<bool> eventPending = false;
+
+	// host time 'baseHostTime' corresponds to emulated time 'baseEmuTime'
+	uint64_t baseHostTime = 0;
+	EmuTime baseEmuTime = EmuTime::zero();
+};
+
+} // namespace openmsx
+
+#endif
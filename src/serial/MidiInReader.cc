@@ -1,8 +1,6 @@
 #include "MidiInReader.hh"
 #include "MidiInConnector.hh"
 #include "PlugException.hh"
-#include "EventDistributor.hh"
-#include "Scheduler.hh"
 #include "FileOperations.hh"
 #include "serialize.hh"
 #include <cstdio>
@@ -12,21 +10,17 @@
 namespace openmsx {
 
 MidiInReader::MidiInReader(EventDistributor& eventDistributor_,
-                           Scheduler& scheduler_,
+                           Scheduler& scheduler_, RealTime& realTime_,
                            CommandController& commandController)
-	: eventDistributor(eventDistributor_), scheduler(scheduler_)
+	: MidiInHostDevice(eventDistributor_, scheduler_, realTime_)
 	, readFilenameSetting(
 		commandController, "midi-in-readfilename",
 		"filename of the file where the MIDI input is read from",
 		"/dev/midi")
 {
-	eventDistributor.registerEventListener(EventType::MIDI_IN_READER, *this);
 }
 
-MidiInReader::~MidiInReader()
-{
-	eventDistributor.unregisterEventListener(EventType::MIDI_IN_READER, *this);
-}
+MidiInReader::~MidiInReader() = default;
 
 // Pluggable
 void MidiInReader::plugHelper(Connector& connector_, EmuTime::param /*time*/)
@@ -84,48 +78,8 @@ void MidiInReader::run()
 			continue;
 		}
 		assert(isPluggedIn());
-
-		{
-			std::lock_guard<std::mutex> lock(mutex);
-			queue.push_back(buf);
-		}
-		eventDistributor.distributeEvent(
-			Event::create<MidiInReaderEvent>());
-	}
-}
-
-// MidiInDevice
-void MidiInReader::signal(EmuTime::param time)
-{
-	auto* conn = static_cast<MidiInConnector*>(getConnector());
-	if (!conn->acceptsData()) {
-		std::lock_guard<std::mutex> lock(mutex);
-		queue.clear();
-		return;
-	}
-	if (!conn->ready()) {
-		return;
-	}
-
-	byte data;
-	{
-		std::lock_guard<std::mutex> lock(mutex);
-		if (queue.empty()) return;
-		data = queue.pop_front();
-	}
-	conn->recvByte(data, time);
-}
-
-// EventListener
-int MidiInReader::signalEvent(const Event& /*event*/) noexcept
-{
-	if (isPluggedIn()) {
-		signal(scheduler.getCurrentTime());
-	} else {
-		std::lock_guard<std::mutex> lock(mutex);
-		queue.clear();
+		push(buf);
 	}
-	return 0;
 }
 
 
@@ -1,27 +1,21 @@
 #ifndef MIDIINREADER_HH
 #define MIDIINREADER_HH
 
-#include "MidiInDevice.hh"
-#include "EventListener.hh"
+#include "MidiInHostDevice.hh"
 #include "FilenameSetting.hh"
 #include "FileOperations.hh"
-#include "openmsx.hh"
-#include "circular_buffer.hh"
 #include "Poller.hh"
-#include <mutex>
 #include <thread>
 
 namespace openmsx {
 
-class EventDistributor;
-class Scheduler;
 class CommandController;
 
-class MidiInReader final : public MidiInDevice, private EventListener
+class MidiInReader final : public MidiInHostDevice
 {
 public:
 	MidiInReader(EventDistributor& eventDistributor, Scheduler& scheduler,
-	             CommandController& commandController);
+	             RealTime& realTime, CommandController& commandController);
 	~MidiInReader() override;
 
 	// Pluggable
@@ -30,25 +24,15 @@ public:
 	[[nodiscard]] std::string_view getName() const override;
 	[[nodiscard]] std::string_view getDescription() const override;
 
-	// MidiInDevice
-	void signal(EmuTime::param time) override;
-
 	template<typename Archive>
 	void serialize(Archive& ar, unsigned version);
 
 private:
 	void run();
 
-	// EventListener
-	int signalEvent(const Event& event) noexcept override;
-
 private:
-	EventDistributor& eventDistributor;
-	Scheduler& scheduler;
 	std::thread thread;
 	FileOperations::FILE_t file;
-	cb_queue<byte> queue;
-	std::mutex mutex; // to protect queue
 	Poller poller;
 
 	FilenameSetting readFilenameSetting;
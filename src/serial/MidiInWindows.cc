@@ -3,8 +3,6 @@
 #include "MidiInConnector.hh"
 #include "PluggingController.hh"
 #include "PlugException.hh"
-#include "EventDistributor.hh"
-#include "Scheduler.hh"
 #include "one_of.hh"
 #include "serialize.hh"
 #include "xrange.hh"
@@ -23,32 +21,29 @@
 namespace openmsx {
 
 void MidiInWindows::registerAll(EventDistributor& eventDistributor,
-                                Scheduler& scheduler,
+                                Scheduler& scheduler, RealTime& realTime,
                                 PluggingController& controller)
 {
 	w32_midiInInit();
 	for (auto i : xrange(w32_midiInGetVFNsNum())) {
 		controller.registerPluggable(std::make_unique<MidiInWindows>(
-			eventDistributor, scheduler, i));
+			eventDistributor, scheduler, realTime, i));
 	}
 }
 
 
 MidiInWindows::MidiInWindows(EventDistributor& eventDistributor_,
-                             Scheduler& scheduler_, unsigned num)
-	: eventDistributor(eventDistributor_), scheduler(scheduler_)
+                             Scheduler& scheduler_, RealTime& realTime_,
+                             unsigned num)
+	: MidiInHostDevice(eventDistributor_, scheduler_, realTime_)
 	, devIdx(unsigned(-1))
 {
 	name = w32_midiInGetVFN(num);
 	desc = w32_midiInGetRDN(num);
-
-	eventDistributor.registerEventListener(EventType::MIDI_IN_WINDOWS, *this);
 }
 
 MidiInWindows::~MidiInWindows()
 {
-	eventDistributor.unregisterEventListener(EventType::MIDI_IN_WINDOWS, *this);
-
 	//w32_midiInClean(); // TODO
 }
 
@@ -99,14 +94,8 @@ std::string_view MidiInWindows::getDescription() const
 void MidiInWindows::procLongMsg(LPMIDIHDR p)
 {
 	if (p->dwBytesRecorded) {
-		{
-			std::lock_guard<std::mutex> lock(queueMutex);
-			for (auto i : xrange(p->dwBytesRecorded)) {
-				queue.push_back(p->lpData[i]);
-			}
-		}
-		eventDistributor.distributeEvent(
-			Event::create<MidiInWindowsEvent>());
+		push(span<const uint8_t>(reinterpret_cast<const uint8_t*>(p->lpData),
+		                         p->dwBytesRecorded));
 	}
 }
 
@@ -121,13 +110,12 @@ void MidiInWindows::procShortMsg(DWORD param)
 		default:
 			num = 1; break;
 	}
-	std::lock_guard<std::mutex> lock(queueMutex);
-	while (num--) {
-		queue.push_back(param & 0xFF);
+	uint8_t buf[3];
+	for (auto i : xrange(num)) {
+		buf[i] = param & 0xFF;
 		param >>= 8;
 	}
-	eventDistributor.distributeEvent(
-		Event::create<MidiInWindowsEvent>());
+	push(span<const uint8_t>(buf, num));
 }
 
 void MidiInWindows::run()
@@ -173,38 +161,6 @@ void MidiInWindows::run()
 	threadId = 0;
 }
 
-// MidiInDevice
-void MidiInWindows::signal(EmuTime::param time)
-{
-	auto* conn = static_cast<MidiInConnector*>(getConnector());
-	if (!conn->acceptsData()) {
-		std::lock_guard<std::mutex> lock(queueMutex);
-		queue.clear();
-		return;
-	}
-	if (!conn->ready()) return;
-
-	byte data;
-	{
-		std::lock_guard<std::mutex> lock(queueMutex);
-		if (queue.empty()) return;
-		data = queue.pop_front();
-	}
-	conn->recvByte(data, time);
-}
-
-// EventListener
-int MidiInWindows::signalEvent(const Event& /*event*/) noexcept
-{
-	if (isPluggedIn()) {
-		signal(scheduler.getCurrentTime());
-	} else {
-		std::lock_guard<std::mutex> lock(queueMutex);
-		queue.clear();
-	}
-	return 0;
-}
-
 template<typename Archive>
 void MidiInWindows::serialize(Archive& /*ar*/, unsigned /*version*/)
 {
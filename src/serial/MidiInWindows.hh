@@ -7,11 +7,8 @@
 #define WIN32_LEAN_AND_MEAN
 #endif
 
-#include "openmsx.hh"
-#include "MidiInDevice.hh"
-#include "EventListener.hh"
+#include "MidiInHostDevice.hh"
 #include "serialize_meta.hh"
-#include "circular_buffer.hh"
 #include <windows.h>
 #include <mmsystem.h>
 #include <mutex>
@@ -20,21 +17,19 @@
 
 namespace openmsx {
 
-class EventDistributor;
-class Scheduler;
 class PluggingController;
 
-class MidiInWindows final : public MidiInDevice, private EventListener
+class MidiInWindows final : public MidiInHostDevice
 {
 public:
 	/** Register all available native Windows midi in devices
 	  */
 	static void registerAll(EventDistributor& eventDistributor,
-	                        Scheduler& scheduler,
+	                        Scheduler& scheduler, RealTime& realTime,
 	                        PluggingController& controller);
 
 	MidiInWindows(EventDistributor& eventDistributor, Scheduler& scheduler,
-	             unsigned num);
+	              RealTime& realTime, unsigned num);
 	~MidiInWindows();
 
 	// Pluggable
@@ -43,24 +38,16 @@ public:
 	[[nodiscard]] std::string_view getName() const override;
 	[[nodiscard]] std::string_view getDescription() const override;
 
-	// MidiInDevice
-	void signal(EmuTime::param time) override;
-
 	template<typename Archive>
 	void serialize(Archive& ar, unsigned version);
 
 private:
 	void run();
 
-	// EventListener
-	int signalEvent(const Event& event) noexcept override;
-
 	void procShortMsg(long unsigned param);
 	void procLongMsg(LPMIDIHDR p);
 
 private:
-	EventDistributor& eventDistributor;
-	Scheduler& scheduler;
 	std::thread thread;
 	std::mutex devIdxMutex;
 	std::condition_variable devIdxCond;
@@ -68,8 +55,6 @@ private:
 	std::mutex threadIdMutex;
 	std::condition_variable threadIdCond;
 	DWORD threadId;
-	cb_queue<byte> queue;
-	std::mutex queueMutex;
 	std::string name;
 	std::string desc;
 };
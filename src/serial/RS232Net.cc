@@ -0,0 +1,222 @@
+#include "RS232Net.hh"
+#include "RS232Connector.hh"
+#include "PlugException.hh"
+#include "EventDistributor.hh"
+#include "StringOp.hh"
+#include "serialize.hh"
+#include "xrange.hh"
+#include <chrono>
+#ifndef _WIN32
+#include <netdb.h>
+#include <netinet/tcp.h>
+#else
+#include <ws2tcpip.h>
+#endif
+
+namespace openmsx {
+
+// Received data that's read ahead, before the MSX reads it.
+constexpr size_t QUEUE_SIZE = 4096;
+// Send the collected data when there's this much of it, or when the first
+// byte has waited this long (in emulated time).
+constexpr size_t FLUSH_SIZE = 256;
+constexpr auto FLUSH_DELAY = EmuDuration::msec(10);
+
+#ifdef MSG_NOSIGNAL
+constexpr int SEND_FLAGS = MSG_NOSIGNAL; // don't raise SIGPIPE
+#else
+constexpr int SEND_FLAGS = 0;
+#endif
+
+RS232Net::RS232Net(EventDistributor& eventDistributor_, Scheduler& scheduler_,
+                   CommandController& commandController)
+	: Schedulable(scheduler_)
+	, eventDistributor(eventDistributor_)
+	, queue(QUEUE_SIZE)
+	, addressSetting(
+	        commandController, "rs232-net-address",
+	        "<host>:<port> of the TCP server that rs232-net connects to",
+	        "127.0.0.1:2323")
+{
+	eventDistributor.registerEventListener(EventType::RS232_NET, *this);
+}
+
+RS232Net::~RS232Net()
+{
+	eventDistributor.unregisterEventListener(EventType::RS232_NET, *this);
+}
+
+// Pluggable
+void RS232Net::plugHelper(Connector& connector_, EmuTime::param /*time*/)
+{
+	std::string address(addressSetting.getString());
+	auto [host, port] = StringOp::splitOnLast(address, ':');
+	if (host.empty() || port.empty()) {
+		throw PlugException("Invalid address, expected <host>:<port>: ",
+		                    address);
+	}
+
+	sock_startup();
+	addrinfo hints = {};
+	hints.ai_family = AF_UNSPEC;
+	hints.ai_socktype = SOCK_STREAM;
+	hints.ai_protocol = IPPROTO_TCP;
+	addrinfo* addresses = nullptr;
+	if (int err = getaddrinfo(std::string(host).c_str(), std::string(port).c_str(),
+	                          &hints, &addresses)) {
+		sock_cleanup();
+		throw PlugException("Can't resolve ", address, ": ", gai_strerror(err));
+	}
+	for (auto* ai = addresses; ai; ai = ai->ai_next) {
+		sock = socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+		if (sock == OPENMSX_INVALID_SOCKET) continue;
+		if (connect(sock, ai->ai_addr, int(ai->ai_addrlen)) == 0) break;
+		sock_close(sock);
+		sock = OPENMSX_INVALID_SOCKET;
+	}
+	freeaddrinfo(addresses);
+	if (sock == OPENMSX_INVALID_SOCKET) {
+		auto err = sock_error();
+		sock_cleanup();
+		throw PlugException("Can't connect to ", address, ": ", err);
+	}
+	// We already collect the data ourselves, send it without delay.
+	int one = 1;
+	setsockopt(sock, IPPROTO_TCP, TCP_NODELAY,
+	           reinterpret_cast<const char*>(&one), sizeof(one));
+#ifdef SO_NOSIGPIPE
+	setsockopt(sock, SOL_SOCKET, SO_NOSIGPIPE,
+	           reinterpret_cast<const char*>(&one), sizeof(one));
+#endif
+
+	auto& rs232Connector = static_cast<RS232Connector&>(connector_);
+	rs232Connector.setDataBits(SerialDataInterface::DATA_8);	// 8 data bits
+	rs232Connector.setStopBits(SerialDataInterface::STOP_1);	// 1 stop bit
+	rs232Connector.setParityBit(false, SerialDataInterface::EVEN); // no parity
+
+	setConnector(&connector_); // base class will do this in a moment,
+	                           // but thread already needs it
+	stop = false;
+	thread = std::thread([this]() { run(); });
+}
+
+void RS232Net::unplugHelper(EmuTime::param /*time*/)
+{
+	// output
+	removeSyncPoints();
+	flush();
+
+	// input
+	stop = true;
+#ifdef _WIN32
+	shutdown(sock, SD_BOTH);
+#else
+	shutdown(sock, SHUT_RDWR);
+#endif
+	thread.join();
+	sock_close(sock);
+	sock = OPENMSX_INVALID_SOCKET;
+	sock_cleanup();
+}
+
+std::string_view RS232Net::getName() const
+{
+	return "rs232-net";
+}
+
+std::string_view RS232Net::getDescription() const
+{
+	return	"RS232 network pluggable. Connects the RS232 port to the TCP "
+		"server specified with the 'rs232-net-address' setting.";
+}
+
+void RS232Net::run()
+{
+	char buf[256];
+	while (!stop) {
+		int num = sock_recv(sock, buf, sizeof(buf));
+		if (num < 0) break; // connection closed (or unplugged)
+		for (auto i : xrange(num)) {
+			// When the queue is full, wait till the MSX reads more. This
+			// also slows down the sender, via TCP flow control.
+			while (!queue.push(byte(buf[i]))) {
+				if (stop) return;
+				std::this_thread::sleep_for(std::chrono::milliseconds(1));
+			}
+		}
+		if (num && !eventPending.exchange(true)) {
+			eventDistributor.distributeEvent(
+				Event::create<Rs232NetEvent>());
+		}
+	}
+}
+
+// input
+void RS232Net::signal(EmuTime::param time)
+{
+	auto* conn = static_cast<RS232Connector*>(getConnector());
+	if (!conn->acceptsData()) {
+		queue.clear();
+		return;
+	}
+	if (!conn->ready()) return;
+
+	auto* data = queue.front();
+	if (!data) return;
+	auto value = *data;
+	queue.pop();
+	conn->recvByte(value, time);
+}
+
+// EventListener
+int RS232Net::signalEvent(const Event& /*event*/) noexcept
+{
+	if (!eventPending.exchange(false)) return 0;
+	if (isPluggedIn()) {
+		signal(getCurrentTime());
+	} else {
+		queue.clear();
+	}
+	return 0;
+}
+
+
+// output
+void RS232Net::recvByte(byte value, EmuTime::param time)
+{
+	outBuf.push_back(value);
+	if (outBuf.size() >= FLUSH_SIZE) {
+		removeSyncPoints();
+		flush();
+	} else if (!pendingSyncPoint()) {
+		setSyncPoint(time + FLUSH_DELAY);
+	}
+}
+
+void RS232Net::executeUntil(EmuTime::param /*time*/)
+{
+	flush();
+}
+
+void RS232Net::flush()
+{
+	const auto* data = reinterpret_cast<const char*>(outBuf.data());
+	size_t pos = 0;
+	while ((sock != OPENMSX_INVALID_SOCKET) && (pos < outBuf.size())) {
+		int num = send(sock, data + pos, int(outBuf.size() - pos), SEND_FLAGS);
+		if (num <= 0) break; // connection closed, drop the data
+		pos += num;
+	}
+	outBuf.clear();
+}
+
+
+template<typename Archive>
+void RS232Net::serialize(Archive& /*ar*/, unsigned /*version*/)
+{
+	// don't try to restore the connection (see RS232Tester)
+}
+INSTANTIATE_SERIALIZE_METHODS(RS232Net);
+REGISTER_POLYMORPHIC_INITIALIZER(Pluggable, RS232Net, "RS232Net");
+
+} // namespace openmsx
@@ -0,0 +1,76 @@
+#ifndef RS232NET_HH
+#define RS232NET_HH
+
+#include "RS232Device.hh"
+#include "EventListener.hh"
+#include "Schedulable.hh"
+#include "Socket.hh"
+#include "StringSetting.hh"
+#include "openmsx.hh"
+#include "spsc_queue.hh"
+#include <atomic>
+#include <thread>
+#include <vector>
+
+namespace openmsx {
+
+class EventDistributor;
+class CommandController;
+
+/** Connects the RS232 port to a TCP server on the host (e.g. a BBS gateway
+  * or a debug console, or a pty via 'socat').
+  *
+  * The emulated timing stays per byte (that's done by the emulated UART),
+  * but the host side is buffered: received data is read ahead in blocks into
+  * a queue, and sent data is collected and written in batches.
+  */
+class RS232Net final : public RS232Device, private EventListener
+                     , private Schedulable
+{
+public:
+	RS232Net(EventDistributor& eventDistributor, Scheduler& scheduler,
+	         CommandController& commandController);
+	~RS232Net() override;
+
+	// Pluggable
+	void plugHelper(Connector& connector, EmuTime::param time) override;
+	void unplugHelper(EmuTime::param time) override;
+	[[nodiscard]] std::string_view getName() const override;
+	[[nodiscard]] std::string_view getDescription() const override;
+
+	// input
+	void signal(EmuTime::param time) override;
+
+	// output
+	void recvByte(byte value, EmuTime::param time) override;
+
+	template<typename Archive>
+	void serialize(Archive& ar, unsigned version);
+
+private:
+	void run();
+	void flush();
+
+	// EventListener
+	int signalEvent(const Event& event) noexcept override;
+
+	// Schedulable
+	void executeUntil(EmuTime::param time) override;
+
+private:
+	EventDistributor& eventDistributor;
+	std::thread thread;
+	SOCKET sock = OPENMSX_INVALID_SOCKET;
+	std::atomic<bool> stop = false;
+
+	spsc_queue<byte> queue; // received data
+	std::atomic<bool> eventPending = false;
+
+	std::vector<byte> outBuf; // data to send
+
+	StringSetting addressSetting;
+};
+
+} // namespace openmsx
+
+#endif
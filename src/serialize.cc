@@ -6,6 +6,8 @@
 #include "XMLException.hh"
 #include "DeltaBlock.hh"
 #include "MemBuffer.hh"
+#include "File.hh"
+#include "FileException.hh"
 #include "FileOperations.hh"
 #include "StringOp.hh"
 #include "Version.hh"
@@ -13,7 +15,7 @@
 #include "one_of.hh"
 #include "stl.hh"
 #include "build-info.hh"
-#include "cstdiop.hh" // for dup()
+#include <algorithm>
 #include <cstring>
 #include <iostream>
 #include <limits>
@@ -31,9 +33,23 @@ void ArchiveBase<Derived>::attribute(const char* name, const char* value)
 }
 template class ArchiveBase<MemOutputArchive>;
 template class ArchiveBase<XmlOutputArchive>;
+template class ArchiveBase<BinaryOutputArchive>;
 
 ////
 
+OutputArchiveBase2::OutputArchiveBase2()
+{
+	idMap.reserve(lastIdMapSize);
+	polyIdMap.reserve(lastPolyIdMapSize);
+}
+
+OutputArchiveBase2::~OutputArchiveBase2()
+{
+	// forgetIds() may have been called, only ever grow the estimate
+	lastIdMapSize     = std::max(lastIdMapSize,     idMap.size());
+	lastPolyIdMapSize = std::max(lastPolyIdMapSize, polyIdMap.size());
+}
+
 unsigned OutputArchiveBase2::generateID1(const void* p)
 {
 	#ifdef linux
@@ -45,15 +61,14 @@ unsigned OutputArchiveBase2::generateID1(const void* p)
 	polyIdMap.emplace_noDuplicateCheck(p, lastId);
 	return lastId;
 }
-unsigned OutputArchiveBase2::generateID2(
-	const void* p, const std::type_info& typeInfo)
+unsigned OutputArchiveBase2::generateID2(const void* p, const void* type)
 {
 	#ifdef linux
 	assert("Can't serialize ID of object located on the stack" &&
 	       !addressOnStack(p));
 	#endif
 	++lastId;
-	auto key = std::pair(p, std::type_index(typeInfo));
+	auto key = std::pair(p, type);
 	assert(!idMap.contains(key));
 	idMap.emplace_noDuplicateCheck(key, lastId);
 	return lastId;
@@ -64,10 +79,9 @@ unsigned OutputArchiveBase2::getID1(const void* p)
 	auto* v = lookup(polyIdMap, p);
 	return v ? *v : 0;
 }
-unsigned OutputArchiveBase2::getID2(
-	const void* p, const std::type_info& typeInfo)
+unsigned OutputArchiveBase2::getID2(const void* p, const void* type)
 {
-	auto* v = lookup(idMap, std::pair(p, std::type_index(typeInfo)));
+	auto* v = lookup(idMap, std::pair(p, type));
 	return v ? *v : 0;
 }
 
@@ -109,6 +123,7 @@ void OutputArchiveBase<Derived>::serialize_blob(
 
 template class OutputArchiveBase<MemOutputArchive>;
 template class OutputArchiveBase<XmlOutputArchive>;
+template class OutputArchiveBase<BinaryOutputArchive>;
 
 ////
 
@@ -168,6 +183,7 @@ void InputArchiveBase<Derived>::serialize_blob(
 
 template class InputArchiveBase<MemInputArchive>;
 template class InputArchiveBase<XmlInputArchive>;
+template class InputArchiveBase<BinaryInputArchive>;
 
 ////
 
@@ -232,6 +248,21 @@ void MemOutputArchive::serialize_blob(const char* /*tag*/, const void* data,
 
 }
 
+void MemOutputArchive::serialize_blob(const char* tag, const void* data,
+                                      size_t len, const std::vector<bool>& dirtyPages,
+                                      size_t pageSize)
+{
+	if (len > SMALL_SIZE) {
+		auto deltaBlockIdx = unsigned(deltaBlocks.size());
+		save(deltaBlockIdx); // see comment below in MemInputArchive
+		deltaBlocks.push_back(lastDeltaBlocks.createNew(
+			data, static_cast<const uint8_t*>(data), len,
+			dirtyPages, pageSize));
+	} else {
+		serialize_blob(tag, data, len);
+	}
+}
+
 void MemInputArchive::serialize_blob(const char* /*tag*/, void* data,
                                      size_t len, bool /*diff*/)
 {
@@ -254,23 +285,228 @@ void MemInputArchive::serialize_blob(const char* /*tag*/, void* data,
 
 ////
 
+// Binary savestate file layout:
+//   BINARY_MAGIC
+//   uint8_t  file format version
+//   uint8_t  big-endian (1) or little-endian (0)
+//   uint8_t  sizeof(long)
+//   uint8_t  sizeof(size_t)
+//   uint64_t size of the uncompressed stream (native endianness)
+//   zlib compressed stream (till the end of the file)
+static constexpr std::string_view BINARY_MAGIC = "openMSX binary savestate";
+static constexpr uint8_t BINARY_FORMAT_VERSION = 1;
+static constexpr size_t BINARY_HEADER_SIZE = BINARY_MAGIC.size() + 4 + sizeof(uint64_t);
+
+BinaryOutputArchive::BinaryOutputArchive(std::string filename_)
+	: filename(std::move(filename_))
+{
+}
+
+void BinaryOutputArchive::close()
+{
+	if (closed) return;
+	closed = true;
+	assert(openSections.empty());
+
+	size_t size;
+	auto buf = buffer.release(size);
+	writeFile(filename, span<const uint8_t>(buf.data(), size));
+}
+
+void BinaryOutputArchive::writeFile(const std::string& filename, span<const uint8_t> data)
+{
+	auto size = data.size();
+	auto dstLen = compressBound(uLong(size));
+	MemBuffer<uint8_t> dst(BINARY_HEADER_SIZE + dstLen);
+	auto* p = dst.data();
+	memcpy(p, BINARY_MAGIC.data(), BINARY_MAGIC.size()); p += BINARY_MAGIC.size();
+	*p++ = BINARY_FORMAT_VERSION;
+	*p++ = OPENMSX_BIGENDIAN ? 1 : 0;
+	*p++ = uint8_t(sizeof(long));
+	*p++ = uint8_t(sizeof(size_t));
+	auto size64 = uint64_t(size);
+	memcpy(p, &size64, sizeof(size64)); p += sizeof(size64);
+	if (compress2(p, &dstLen, data.data(), uLong(size), Z_BEST_SPEED) != Z_OK) {
+		throw MSXException("Error while compressing savestate.");
+	}
+
+	auto f = FileOperations::openFile(filename, "wb");
+	size_t total = BINARY_HEADER_SIZE + dstLen;
+	if (!f || (fwrite(dst.data(), 1, total, f.get()) != total)) {
+		throw MSXException("Could not write \"", filename, '"');
+	}
+}
+
+MemBuffer<uint8_t> BinaryOutputArchive::releaseBuffer(size_t& size)
+{
+	assert(!closed);
+	assert(openSections.empty());
+	closed = true;
+	return buffer.release(size);
+}
+
+BinaryOutputArchive::~BinaryOutputArchive()
+{
+	try {
+		close();
+	} catch (...) {
+		// Eat exception. Explicitly call close() if you want to handle errors.
+	}
+}
+
+void BinaryOutputArchive::save(std::string_view s)
+{
+	auto size = s.size();
+	uint8_t* buf = buffer.allocate(sizeof(size) + size);
+	memcpy(buf, &size, sizeof(size));
+	memcpy(buf + sizeof(size), s.data(), size);
+}
+
+void BinaryOutputArchive::serialize_blob(const char* /*tag*/, const void* data,
+                                         size_t len, bool /*diff*/)
+{
+	// The length is already known while loading, but storing it allows
+	// to detect a mismatch.
+	save(len);
+	put(data, len);
+}
+
+void BinaryOutputArchive::beginSection()
+{
+	size_t skip = 0; // filled in later
+	save(skip);
+	size_t beginPos = buffer.getPosition();
+	openSections.push_back(beginPos);
+}
+
+void BinaryOutputArchive::endSection()
+{
+	assert(!openSections.empty());
+	size_t endPos   = buffer.getPosition();
+	size_t beginPos = openSections.back();
+	openSections.pop_back();
+	size_t skip = endPos - beginPos;
+	buffer.insertAt(beginPos - sizeof(skip),
+	                &skip, sizeof(skip));
+}
+
+////
+
+bool BinaryInputArchive::isBinaryFile(const std::string& filename)
+{
+	try {
+		File file(filename);
+		if (file.getSize() < BINARY_MAGIC.size()) return false;
+		char buf[BINARY_MAGIC.size()];
+		file.read(buf, sizeof(buf));
+		return string_view(buf, sizeof(buf)) == BINARY_MAGIC;
+	} catch (MSXException&) {
+		return false;
+	}
+}
+
+BinaryInputArchive::BinaryInputArchive(const std::string& filename)
+{
+	File file(filename);
+	auto fileSize = file.getSize();
+	MemBuffer<uint8_t> buf(fileSize);
+	file.read(buf.data(), fileSize);
+	if ((fileSize < BINARY_HEADER_SIZE) ||
+	    (string_view(reinterpret_cast<const char*>(buf.data()), BINARY_MAGIC.size()) != BINARY_MAGIC)) {
+		throw MSXException("Not a binary savestate.");
+	}
+	const auto* p = buf.data() + BINARY_MAGIC.size();
+	if (p[0] != BINARY_FORMAT_VERSION) {
+		throw MSXException("Unsupported binary savestate format version ",
+		                   int(p[0]), '.');
+	}
+	if ((p[1] != (OPENMSX_BIGENDIAN ? 1 : 0)) ||
+	    (p[2] != sizeof(long)) || (p[3] != sizeof(size_t))) {
+		throw MSXException("This binary savestate was created on a different "
+		                   "type of platform, it can't be loaded here.");
+	}
+	p += 4;
+	uint64_t size;
+	memcpy(&size, p, sizeof(size)); p += sizeof(size);
+	if (size > std::numeric_limits<uLong>::max()) {
+		throw MSXException("Binary savestate too large.");
+	}
+
+	data.resize(size);
+	auto dstLen = uLongf(size);
+	auto srcLen = uLong(fileSize - BINARY_HEADER_SIZE);
+	if ((uncompress(data.data(), &dstLen, p, srcLen) != Z_OK) ||
+	    (dstLen != size)) {
+		throw MSXException("Error while decompressing savestate.");
+	}
+	pos = data.data();
+	end = pos + size;
+}
+
+const uint8_t* BinaryInputArchive::skip(size_t len)
+{
+	if (size_t(end - pos) < len) {
+		throw MSXException("Unexpected end of binary savestate.");
+	}
+	const auto* result = pos;
+	pos += len;
+	return result;
+}
+
+void BinaryInputArchive::get(void* result, size_t len)
+{
+	if (len) {
+		memcpy(result, skip(len), len);
+	}
+}
+
+void BinaryInputArchive::load(std::string& s)
+{
+	s = loadStr();
+}
+
+string_view BinaryInputArchive::loadStr()
+{
+	size_t length;
+	load(length);
+	const auto* p = skip(length);
+	return string_view(reinterpret_cast<const char*>(p), length);
+}
+
+void BinaryInputArchive::serialize_blob(const char* /*tag*/, void* data_,
+                                        size_t len, bool /*diff*/)
+{
+	size_t storedLen;
+	load(storedLen);
+	if (storedLen != len) {
+		throw MSXException("Length of blob different from expected value (",
+		                   len, ')');
+	}
+	get(data_, len);
+}
+
+void BinaryInputArchive::skipSection(bool skip_)
+{
+	size_t num;
+	load(num);
+	if (skip_) {
+		(void)skip(num);
+	}
+}
+
+////
+
 XmlOutputArchive::XmlOutputArchive(zstring_view filename_)
 	: filename(filename_)
-	, writer(*this)
-{
-	{
-		auto f = FileOperations::openFile(filename, "wb");
-		if (!f) error();
-		int duped_fd = dup(fileno(f.get()));
-		if (duped_fd == -1) error();
-		file = gzdopen(duped_fd, "wb9");
-		if (!file) {
-			::close(duped_fd);
+	, file(FileOperations::openFile(filename, "wb"))
+	, gzip([this](span<const uint8_t> data) {
+		if (fwrite(data.data(), 1, data.size(), file.get()) != data.size()) {
 			error();
 		}
-		// on scope-exit 'f' is closed, and 'file'
-		// uses the dup()'ed file descriptor.
-	}
+	  }, 9)
+	, writer(*this)
+{
+	if (!file) error();
 
 	static constexpr std::string_view header =
 		"<?xml version=\"1.0\" ?>\n"
@@ -287,12 +523,16 @@ void XmlOutputArchive::close()
 {
 	if (!file) return; // already closed
 
-	writer.end("serial");
-
-	if (gzclose(file) != Z_OK) {
+	try {
+		writer.end("serial");
+		gzip.finish();
+	} catch (MSXException&) {
+		file.reset(); // don't try again from the destructor
+		error();
+	}
+	if (fclose(file.release()) != 0) {
 		error();
 	}
-	file = nullptr;
 }
 
 XmlOutputArchive::~XmlOutputArchive()
@@ -306,14 +546,18 @@ XmlOutputArchive::~XmlOutputArchive()
 
 void XmlOutputArchive::write(const char* buf, size_t len)
 {
-	if (gzwrite(file, buf, len) == 0) {
+	try {
+		gzip.write(buf, len);
+	} catch (FileException&) {
 		error();
 	}
 }
 
 void XmlOutputArchive::write1(char c)
 {
-	if (gzputc(file, c) == -1) {
+	try {
+		gzip.write1(uint8_t(c));
+	} catch (FileException&) {
 		error();
 	}
 }
@@ -494,6 +738,31 @@ void XmlInputArchive::load(unsigned long long& ull)
 	string_view str = loadStr();
 	fastAtoi(str, ull);
 }
+void XmlInputArchive::load(short& s)
+{
+	string_view str = loadStr();
+	fastAtoi(str, s);
+}
+void XmlInputArchive::load(unsigned short& us)
+{
+	string_view str = loadStr();
+	fastAtoi(str, us);
+}
+void XmlInputArchive::load(long& l)
+{
+	string_view str = loadStr();
+	fastAtoi(str, l);
+}
+void XmlInputArchive::load(unsigned long& ul)
+{
+	string_view str = loadStr();
+	fastAtoi(str, ul);
+}
+void XmlInputArchive::load(long long& ll)
+{
+	string_view str = loadStr();
+	fastAtoi(str, ll);
+}
 void XmlInputArchive::load(unsigned char& b)
 {
 	unsigned i;
@@ -538,21 +807,28 @@ void XmlInputArchive::endTag(const char* tag)
 	elems.pop_back();
 }
 
-void XmlInputArchive::attribute(const char* name, string& t)
+std::string_view XmlInputArchive::getAttribute(const char* name) const
 {
 	const auto* attr = currentElement()->findAttribute(name);
 	if (!attr) {
 		throw XMLException("Missing attribute \"", name, "\".");
 	}
-	t = attr->getValue();
+	return attr->getValue();
 }
+void XmlInputArchive::attribute(const char* name, string& t)
+{
+	t = getAttribute(name);
+}
+// The id, id_ref and version attributes are parsed for (almost) every
+// object. Like the load() methods above this only handles values we've
+// written ourselves.
 void XmlInputArchive::attribute(const char* name, int& i)
 {
-	attributeImpl(name, i);
+	fastAtoi(getAttribute(name), i);
 }
 void XmlInputArchive::attribute(const char* name, unsigned& u)
 {
-	attributeImpl(name, u);
+	fastAtoi(getAttribute(name), u);
 }
 bool XmlInputArchive::hasAttribute(const char* name)
 {
@@ -5,9 +5,12 @@
 #include "SerializeBuffer.hh"
 #include "XMLElement.hh"
 #include "XMLOutputStream.hh"
+#include "FileOperations.hh"
+#include "GzipWriter.hh"
 #include "MemBuffer.hh"
-#include "hash_map.hh"
+#include "flat_hash_map.hh"
 #include "inline.hh"
+#include "span.hh"
 #include "strCat.hh"
 #include "unreachable.hh"
 #include "zstring_view.hh"
@@ -145,6 +148,9 @@ public:
 	//   cannot know whether a byte-array should be serialized as a blob
 	//   or as a collection of bytes (IOW we cannot decide it based on the
 	//   type).
+	//   For output archives there's an overload that takes a
+	//   'std::vector<bool> dirtyPages' and a 'size_t pageSize' instead of
+	//   'diff', see TrackedRam.
 	//
 	//
 	// template<typename T> void serialize(const char* tag, const T& t)
@@ -393,15 +399,16 @@ public:
 		//   struct B { A a; ... };
 		// The pointer to the outer and inner structure can be the
 		// same while we still want a different ID to refer to these
-		// two. That's why we use a std::pair<void*, type_index> as key
-		// in the map.
+		// two. That's why we use a std::pair<void*, void*> as key in
+		// the map, the second pointer identifies the type (see
+		// typeKey, that's much cheaper to hash than std::type_index).
 		// For polymorphic types you do sometimes use a base pointer
 		// to refer to a subtype. So there we only use the pointer
 		// value as key in the map.
 		if constexpr (std::is_polymorphic_v<T>) {
 			return generateID1(p);
 		} else {
-			return generateID2(p, typeid(T));
+			return generateID2(p, &typeKey<T>);
 		}
 	}
 
@@ -410,23 +417,44 @@ public:
 		if constexpr (std::is_polymorphic_v<T>) {
 			return getID1(p);
 		} else {
-			return getID2(p, typeid(T));
+			return getID2(p, &typeKey<T>);
 		}
 	}
 
+	// Forget all pointer-to-ID associations (IDs keep on increasing).
+	// Use this between independent object graphs that are created and
+	// destroyed one after the other, otherwise a new object at a reused
+	// address would be mistaken for an already saved one.
+	void forgetIds()
+	{
+		polyIdMap.clear();
+		idMap.clear();
+	}
+
 protected:
-	OutputArchiveBase2() = default;
+	OutputArchiveBase2();
+	~OutputArchiveBase2();
 
 private:
 	[[nodiscard]] unsigned generateID1(const void* p);
-	[[nodiscard]] unsigned generateID2(const void* p, const std::type_info& typeInfo);
+	[[nodiscard]] unsigned generateID2(const void* p, const void* type);
 	[[nodiscard]] unsigned getID1(const void* p);
-	[[nodiscard]] unsigned getID2(const void* p, const std::type_info& typeInfo);
+	[[nodiscard]] unsigned getID2(const void* p, const void* type);
+
+	// Only the address matters: it's different for each type. (Not const,
+	// otherwise the linker may fold identical read-only objects.)
+	template<typename T> static inline char typeKey = 0;
 
 private:
-	hash_map<std::pair<const void*, std::type_index>, unsigned, HashPair> idMap;
-	hash_map<const void*, unsigned> polyIdMap;
+	flat_hash_map<std::pair<const void*, const void*>, unsigned, HashPair> idMap;
+	flat_hash_map<const void*, unsigned> polyIdMap;
 	unsigned lastId = 0;
+
+	// The same object graph (e.g. a machine for each reverse snapshot) is
+	// typically serialized over and over. Size the maps to what the
+	// previous archive needed, so they don't rehash while growing.
+	static inline unsigned lastIdMapSize = 0;
+	static inline unsigned lastPolyIdMapSize = 0;
 };
 
 template<typename Derived>
@@ -461,6 +489,15 @@ public:
 	// the resulting string. But memory archives will memcpy the blob.
 	void serialize_blob(const char* tag, const void* data, size_t len,
 	                    bool diff = true);
+	// Same, but additionally pass which pages (of 'pageSize' bytes) of
+	// the blob possibly changed since the previous reverse snapshot. Only
+	// memory archives make use of this.
+	void serialize_blob(const char* tag, const void* data, size_t len,
+	                    const std::vector<bool>& /*dirtyPages*/,
+	                    size_t /*pageSize*/)
+	{
+		this->self().serialize_blob(tag, data, len);
+	}
 
 	template<typename T> void serialize(const char* tag, const T& t)
 	{
@@ -541,8 +578,8 @@ protected:
 	InputArchiveBase2() = default;
 
 private:
-	hash_map<unsigned, void*> idMap;
-	hash_map<void*, std::shared_ptr<void>> sharedPtrMap;
+	flat_hash_map<unsigned, void*> idMap;
+	flat_hash_map<void*, std::shared_ptr<void>> sharedPtrMap;
 };
 
 template<typename Derived>
@@ -667,6 +704,8 @@ public:
 	void save(std::string_view s);
 	void serialize_blob(const char* tag, const void* data, size_t len,
 	                    bool diff = true);
+	void serialize_blob(const char* tag, const void* data, size_t len,
+	                    const std::vector<bool>& dirtyPages, size_t pageSize);
 
 	using OutputArchiveBase<MemOutputArchive>::serialize;
 	template<typename T, typename ...Args>
@@ -838,6 +877,131 @@ private:
 
 ////
 
+// Binary savestate files. The layout is much like the memory archives, but
+// like the XML archives it also stores class versions and stores enums as
+// strings, so that savestates from older openMSX versions can still be
+// loaded. Values are stored in the native format, so a file can only be
+// loaded on a platform with the same endianness and type sizes (this is
+// checked on load). The whole stream is zlib compressed.
+class BinaryOutputArchive final : public OutputArchiveBase<BinaryOutputArchive>
+{
+public:
+	explicit BinaryOutputArchive(std::string filename);
+	void close();
+	/** Instead of close(): don't write the file, but return the
+	  * (uncompressed) serialized data, e.g. to compare two states. */
+	[[nodiscard]] MemBuffer<uint8_t> releaseBuffer(size_t& size);
+	~BinaryOutputArchive();
+
+	/** Compress and write (what close() does) data that was obtained
+	  * earlier via releaseBuffer(). This doesn't touch any emulator state,
+	  * so it can be done on a background thread. Throws on error. */
+	static void writeFile(const std::string& filename, span<const uint8_t> data);
+
+	template<typename T> void save(const T& t)
+	{
+		put(&t, sizeof(t));
+	}
+	inline void saveChar(char c)
+	{
+		save(c);
+	}
+	void save(const std::string& s) { save(std::string_view(s)); }
+	void save(std::string_view s);
+	void serialize_blob(const char* tag, const void* data, size_t len,
+	                    bool diff = true);
+	void serialize_blob(const char* tag, const void* data, size_t len,
+	                    const std::vector<bool>& /*dirtyPages*/,
+	                    size_t /*pageSize*/)
+	{
+		serialize_blob(tag, data, len);
+	}
+
+	using OutputArchiveBase<BinaryOutputArchive>::serialize;
+	template<typename T, typename ...Args>
+	ALWAYS_INLINE void serialize(const char* tag, const T& t, Args&& ...args)
+	{
+		// by default just repeatedly call the single-pair serialize() variant
+		this->self().serialize(tag, t);
+		this->self().serialize(std::forward<Args>(args)...);
+	}
+
+	void beginSection();
+	void endSection();
+
+//internal:
+	static constexpr bool TRANSLATE_ENUM_TO_STRING = true;
+
+private:
+	void put(const void* data, size_t len)
+	{
+		if (len) {
+			buffer.insert(data, len);
+		}
+	}
+
+	std::string filename;
+	OutputBuffer buffer;
+	std::vector<size_t> openSections;
+	bool closed = false;
+};
+
+class BinaryInputArchive final : public InputArchiveBase<BinaryInputArchive>
+{
+public:
+	explicit BinaryInputArchive(const std::string& filename);
+
+	/** Does the given file start with the binary savestate signature?
+	  * Returns false when the file can't be read. */
+	[[nodiscard]] static bool isBinaryFile(const std::string& filename);
+
+	[[nodiscard]] inline bool versionAtLeast(unsigned actual, unsigned required) const
+	{
+		return actual >= required;
+	}
+	[[nodiscard]] inline bool versionBelow(unsigned actual, unsigned required) const
+	{
+		return actual < required;
+	}
+
+	template<typename T> void load(T& t)
+	{
+		get(&t, sizeof(t));
+	}
+	inline void loadChar(char& c)
+	{
+		load(c);
+	}
+	void load(std::string& s);
+	[[nodiscard]] std::string_view loadStr();
+	void serialize_blob(const char* tag, void* data, size_t len,
+	                    bool diff = true);
+
+	using InputArchiveBase<BinaryInputArchive>::serialize;
+	template<typename T, typename ...Args>
+	ALWAYS_INLINE void serialize(const char* tag, T& t, Args&& ...args)
+	{
+		// by default just repeatedly call the single-pair serialize() variant
+		this->self().serialize(tag, t);
+		this->self().serialize(std::forward<Args>(args)...);
+	}
+
+	void skipSection(bool skip);
+
+//internal:
+	static constexpr bool TRANSLATE_ENUM_TO_STRING = true;
+
+private:
+	void get(void* result, size_t len);
+	[[nodiscard]] const uint8_t* skip(size_t len);
+
+	MemBuffer<uint8_t> data;
+	const uint8_t* pos;
+	const uint8_t* end;
+};
+
+////
+
 class XmlOutputArchive final : public OutputArchiveBase<XmlOutputArchive>
 {
 public:
@@ -909,7 +1073,8 @@ public:
 
 private:
 	zstring_view filename;
-	gzFile file = nullptr;
+	FileOperations::FILE_t file;
+	GzipWriter gzip; // compresses on multiple threads
 	XMLOutputStream<XmlOutputArchive> writer;
 };
 
@@ -939,9 +1104,14 @@ public:
 	void load(unsigned char& b);
 	void load(signed char& c);
 	void load(char& c);
-	void load(int& i);                  // these 3 are not strictly needed
+	void load(int& i);                  // these are not strictly needed
 	void load(unsigned& u);             // but having them non-inline
 	void load(unsigned long long& ull); // saves quite a bit of code
+	void load(short& s);                // (and it's much faster than
+	void load(unsigned short& us);      // going via std::istringstream,
+	void load(long& l);                 // e.g. EmuTime is stored as
+	void load(unsigned long& ul);       // uint64_t)
+	void load(long long& ll);
 	void load(std::string& t);
 	[[nodiscard]] std::string_view loadStr();
 
@@ -989,6 +1159,9 @@ public:
 	bool findAttribute(const char* name, unsigned& value);
 	[[nodiscard]] int countChildren() const;
 
+private:
+	[[nodiscard]] std::string_view getAttribute(const char* name) const;
+
 private:
 	XMLDocument xmlDoc{16384}; // tweak: initial allocator buffer size
 	std::vector<std::pair<const XMLElement*, const XMLElement*>> elems;
@@ -998,7 +1171,9 @@ private:
 template void CLASS::serialize(MemInputArchive&,   unsigned); \
 template void CLASS::serialize(MemOutputArchive&,  unsigned); \
 template void CLASS::serialize(XmlInputArchive&,   unsigned); \
-template void CLASS::serialize(XmlOutputArchive&,  unsigned);
+template void CLASS::serialize(XmlOutputArchive&,  unsigned); \
+template void CLASS::serialize(BinaryInputArchive&,  unsigned); \
+template void CLASS::serialize(BinaryOutputArchive&, unsigned);
 
 } // namespace openmsx
 
@@ -33,6 +33,17 @@ unsigned loadVersionHelper(MemInputArchive& /*ar*/, const char* /*className*/,
 	UNREACHABLE; return 0;
 }
 
+unsigned loadVersionHelper(BinaryInputArchive& ar, const char* className,
+                           unsigned latestVersion)
+{
+	unsigned version;
+	ar.attribute("version", version);
+	if (unlikely(version > latestVersion)) {
+		versionError(className, latestVersion, version);
+	}
+	return version;
+}
+
 unsigned loadVersionHelper(XmlInputArchive& ar, const char* className,
                            unsigned latestVersion)
 {
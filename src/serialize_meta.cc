@@ -52,6 +52,7 @@ void PolymorphicSaverRegistry<Archive>::save(
 
 template class PolymorphicSaverRegistry<MemOutputArchive>;
 template class PolymorphicSaverRegistry<XmlOutputArchive>;
+template class PolymorphicSaverRegistry<BinaryOutputArchive>;
 
 ////
 
@@ -84,6 +85,7 @@ void* PolymorphicLoaderRegistry<Archive>::load(
 
 template class PolymorphicLoaderRegistry<MemInputArchive>;
 template class PolymorphicLoaderRegistry<XmlInputArchive>;
+template class PolymorphicLoaderRegistry<BinaryInputArchive>;
 
 ////
 
@@ -130,5 +132,6 @@ void PolymorphicInitializerRegistry<Archive>::init(
 
 template class PolymorphicInitializerRegistry<MemInputArchive>;
 template class PolymorphicInitializerRegistry<XmlInputArchive>;
+template class PolymorphicInitializerRegistry<BinaryInputArchive>;
 
 } // namespace openmsx
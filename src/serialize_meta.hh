@@ -289,6 +289,8 @@ class MemInputArchive;
 class MemOutputArchive;
 class XmlInputArchive;
 class XmlOutputArchive;
+class BinaryInputArchive;
+class BinaryOutputArchive;
 
 /*#define REGISTER_POLYMORPHIC_CLASS_HELPER(B,C,N) \
 static_assert(std::is_base_of_v<B,C>, "must be base and sub class"); \
@@ -304,6 +306,8 @@ static RegisterLoaderHelper<MemInputArchive,  C> registerHelper3##C(N); \
 static RegisterSaverHelper <MemOutputArchive, C> registerHelper4##C(N); \
 static RegisterLoaderHelper<XmlInputArchive,  C> registerHelper5##C(N); \
 static RegisterSaverHelper <XmlOutputArchive, C> registerHelper6##C(N); \
+static RegisterLoaderHelper<BinaryInputArchive,  C> registerHelper7##C(N); \
+static RegisterSaverHelper <BinaryOutputArchive, C> registerHelper8##C(N); \
 template<> struct PolymorphicBaseClass<C> { using type = B; };
 
 #define REGISTER_POLYMORPHIC_INITIALIZER_HELPER(B,C,N) \
@@ -312,6 +316,8 @@ static RegisterInitializerHelper<MemInputArchive,  C> registerHelper3##C(N); \
 static RegisterSaverHelper      <MemOutputArchive, C> registerHelper4##C(N); \
 static RegisterInitializerHelper<XmlInputArchive,  C> registerHelper5##C(N); \
 static RegisterSaverHelper      <XmlOutputArchive, C> registerHelper6##C(N); \
+static RegisterInitializerHelper<BinaryInputArchive,  C> registerHelper7##C(N); \
+static RegisterSaverHelper      <BinaryOutputArchive, C> registerHelper8##C(N); \
 template<> struct PolymorphicBaseClass<C> { using type = B; };
 
 #define REGISTER_BASE_NAME_HELPER(B,N) \
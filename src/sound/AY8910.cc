@@ -16,6 +16,7 @@
 #include "Math.hh"
 #include "StringOp.hh"
 #include "serialize.hh"
+#include "serialize_stl.hh"
 #include "cstd.hh"
 #include "likely.hh"
 #include "one_of.hh"
@@ -524,6 +525,7 @@ AY8910::~AY8910()
 
 void AY8910::reset(EmuTime::param time)
 {
+	syncRegisterWrites(time);
 	// Reset generators and envelope.
 	for (auto& t : tone) t.reset();
 	noise.reset();
@@ -538,6 +540,7 @@ void AY8910::reset(EmuTime::param time)
 byte AY8910::readRegister(unsigned reg, EmuTime::param time)
 {
 	if (reg >= 16) return 255;
+	if (reg < AY_PORTA) syncRegisterWrites(time);
 	switch (reg) {
 	case AY_PORTA:
 		if (!(regs[AY_ENABLE] & PORT_A_DIRECTION)) { // input
@@ -575,19 +578,37 @@ byte AY8910::peekRegister(unsigned reg, EmuTime::param time) const
 		}
 		break;
 	}
-	return regs[reg];
+	return getQueuedValue(reg).value_or(regs[reg]);
 }
 
 
 void AY8910::writeRegister(unsigned reg, byte value, EmuTime::param time)
 {
 	if (reg >= 16) return;
-	if ((reg < AY_PORTA) && (reg == AY_ESHAPE || regs[reg] != value)) {
-		// Update the output buffer before changing the register.
-		updateStream(time);
+	if (reg == AY_ENABLE) {
+		// Can have side effects on the periphery, so this write is not
+		// queued. Other registers are, see below.
+		if (regs[reg] != value) {
+			updateStream(time);
+			applyRegisterWrites(); // the ones after the last sample
+		}
+	} else if (reg < AY_PORTA) {
+		// Compare against the value the register will have once the
+		// queued writes are applied.
+		if (reg == AY_ESHAPE ||
+		    getQueuedValue(reg).value_or(regs[reg]) != value) {
+			queueRegisterWrite(reg, value, time);
+		}
+		return;
 	}
 	wrtReg(reg, value, time);
 }
+
+void AY8910::applyRegisterWrite(unsigned reg, uint8_t value, EmuTime::param time)
+{
+	wrtReg(reg, value, time);
+}
+
 void AY8910::wrtReg(unsigned reg, byte value, EmuTime::param time)
 {
 	// Warn/force port directions
@@ -676,6 +697,11 @@ void AY8910::wrtReg(unsigned reg, byte value, EmuTime::param time)
 	}
 }
 
+// The generators are advanced event by event (getNextEventTime() /
+// doNextEvent() / advanceFast()), and the output between two events is
+// written as one run with addFill(). So there is no per-sample work besides
+// storing the samples. (With the 'blip' resampler, only the level
+// transitions in these runs are fed into the BlipBuffer.)
 void AY8910::generateChannels(float** bufs, unsigned num)
 {
 	// Disable channels with volume 0: since the sample value doesn't matter,
@@ -1002,13 +1028,18 @@ void AY8910::Debuggable::write(unsigned address, byte value, EmuTime::param time
 }
 
 
+// version 1: initial version
+// version 2: added 'registerWrites' (queued writes, see ResampledSoundDevice)
 template<typename Archive>
-void AY8910::serialize(Archive& ar, unsigned /*version*/)
+void AY8910::serialize(Archive& ar, unsigned version)
 {
 	ar.serialize("toneGenerators", tone,
 	             "noiseGenerator", noise,
 	             "envelope",       envelope,
 	             "registers",      regs);
+	if (ar.versionAtLeast(version, 2)) {
+		serializeRegisterWrites(ar);
+	}
 
 	// amplitude
 	if constexpr (Archive::IS_LOADER) {
@@ -166,6 +166,9 @@ private:
 	// Observer<Setting>
 	void update(const Setting& setting) noexcept override;
 
+	// ResampledSoundDevice
+	void applyRegisterWrite(unsigned reg, uint8_t value, EmuTime::param time) override;
+
 	void wrtReg(unsigned reg, byte value, EmuTime::param time);
 
 private:
@@ -193,6 +196,7 @@ private:
 	bool detuneInitialized;
 };
 
+SERIALIZE_CLASS_VERSION(AY8910, 2);
 SERIALIZE_CLASS_VERSION(AY8910::Generator, 2);
 SERIALIZE_CLASS_VERSION(AY8910::ToneGenerator, 2);
 SERIALIZE_CLASS_VERSION(AY8910::NoiseGenerator, 2);
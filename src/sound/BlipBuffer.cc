@@ -9,6 +9,9 @@
 #include <cstring>
 #include <cassert>
 #include <iostream>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 
 namespace openmsx {
 
@@ -119,6 +122,37 @@ void BlipBuffer::addDelta(TimeIndex time, float delta)
 	}
 }
 
+void BlipBuffer::addDeltas(const TimeIndex* times, const float* deltas, unsigned num)
+{
+	if (num == 0) return;
+	// times are increasing, so only the last one can raise 'availSamp'
+	unsigned tmp = times[num - 1].toInt() + BLIP_IMPULSE_WIDTH;
+	assert(tmp < BUFFER_SIZE);
+	availSamp = std::max<int>(availSamp, tmp);
+	// Sum the impulses of all deltas that start at the same sample (that
+	// is common for high input rates, e.g. PSG sample playback) before
+	// adding them to the buffer. Note that this rounds differently than
+	// separate addDelta() calls.
+	unsigned i = 0;
+	while (i < num) {
+		unsigned t = times[i].toInt();
+		float sum[BLIP_IMPULSE_WIDTH] = {};
+		do {
+			const float* __restrict impulse = impulses[times[i].fractAsInt()].data();
+			float d = deltas[i];
+			for (auto k : xrange(BLIP_IMPULSE_WIDTH)) sum[k] += impulse[k] * d;
+			++i;
+		} while ((i < num) && (unsigned(times[i].toInt()) == t));
+		unsigned ofst = t + offset;
+		if (likely((ofst + BLIP_IMPULSE_WIDTH) <= BUFFER_SIZE)) {
+			float* __restrict result = &buffer[ofst];
+			for (auto k : xrange(BLIP_IMPULSE_WIDTH)) result[k] += sum[k];
+		} else {
+			for (auto k : xrange(BLIP_IMPULSE_WIDTH)) buffer[(ofst + k) & BUFFER_MASK] += sum[k];
+		}
+	}
+}
+
 constexpr float BASS_FACTOR = 511.0f / 512.0f;
 
 template<unsigned PITCH>
@@ -127,7 +161,45 @@ void BlipBuffer::readSamplesHelper(float* __restrict out, unsigned samples) __re
 	assert((offset + samples) <= BUFFER_SIZE);
 	auto acc = accum;
 	unsigned ofst = offset;
-	for (auto i : xrange(samples)) {
+	unsigned i = 0;
+#ifdef __SSE2__
+	// Integrate 4 samples at once. For input x0..x3 (and 'acc' = a):
+	//   out = [a, a*R + x0, a*R^2 + x0*R + x1, a*R^3 + x0*R^2 + x1*R + x2]
+	//   new a = a*R^4 + x0*R^3 + x1*R^2 + x2*R + x3
+	// The sum over the x-terms is a prefix-scan, calculated in two
+	// shift-multiply-add steps. This uses the same coefficients as the
+	// scalar loop below, but rounds in a different order, so the result
+	// can differ in the last bits.
+	constexpr float R1 = BASS_FACTOR;
+	constexpr float R2 = R1 * R1;
+	constexpr float R3 = R2 * R1;
+	constexpr float R4 = R2 * R2;
+	const __m128 powR  = _mm_setr_ps(1.0f, R1, R2, R3);
+	const __m128 r1    = _mm_set1_ps(R1);
+	const __m128 r2    = _mm_set1_ps(R2);
+	const __m128 zero  = _mm_setzero_ps();
+	for (; (i + 4) <= samples; i += 4, ofst += 4) {
+		__m128 x = _mm_loadu_ps(&buffer[ofst]);
+		_mm_storeu_ps(&buffer[ofst], zero);
+		// s = [x0, x0*R + x1, x0*R^2 + x1*R + x2, ... + x3]
+		__m128 s = _mm_add_ps(x, _mm_mul_ps(r1, _mm_castsi128_ps(
+			_mm_slli_si128(_mm_castps_si128(x), 4))));
+		s = _mm_add_ps(s, _mm_mul_ps(r2, _mm_castsi128_ps(
+			_mm_slli_si128(_mm_castps_si128(s), 8))));
+		// [0, s0, s1, s2]
+		__m128 prev = _mm_castsi128_ps(_mm_slli_si128(_mm_castps_si128(s), 4));
+		__m128 o = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(acc), powR), prev);
+		if constexpr (PITCH == 1) {
+			_mm_storeu_ps(&out[i], o);
+		} else {
+			alignas(16) float tmp[4];
+			_mm_store_ps(tmp, o);
+			for (auto j : xrange(4)) out[(i + j) * PITCH] = tmp[j];
+		}
+		acc = acc * R4 + _mm_cvtss_f32(_mm_shuffle_ps(s, s, 3));
+	}
+#endif
+	for (; i < samples; ++i) {
 		out[i * PITCH] = acc;
 		acc *= BASS_FACTOR;
 		acc += buffer[ofst];
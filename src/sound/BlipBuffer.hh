@@ -26,6 +26,10 @@ public:
 	// units and since the last time readSamples() was called.
 	void addDelta(TimeIndex time, float delta);
 
+	// Same as calling addDelta() for each (time, delta) pair (except for
+	// rounding), but faster. The times must be in increasing order.
+	void addDeltas(const TimeIndex* times, const float* deltas, unsigned num);
+
 	// Read the given amount of samples into destination buffer.
 	template<unsigned PITCH>
 	bool readSamples(float* out, unsigned samples);
@@ -1,5 +1,6 @@
 #include "MSXMixer.hh"
 #include "Mixer.hh"
+#include "MixerKernels.hh"
 #include "SoundDevice.hh"
 #include "MSXMotherBoard.hh"
 #include "MSXCommandController.hh"
@@ -11,9 +12,13 @@
 #include "BooleanSetting.hh"
 #include "CommandException.hh"
 #include "AviRecorder.hh"
+#include "FrameStreamer.hh"
+#include "Reactor.hh"
 #include "Filename.hh"
 #include "FileOperations.hh"
 #include "CliComm.hh"
+#include "PerfTimers.hh"
+#include "WorkerPool.hh"
 #include "stl.hh"
 #include "aligned.hh"
 #include "one_of.hh"
@@ -157,6 +162,7 @@ double MSXMixer::getEffectiveSpeed() const
 
 void MSXMixer::updateStream(EmuTime::param time)
 {
+	PerfTimers::Scope perf(PerfTimers::SOUND);
 	union {
 		float mixBuffer[8192 * 2]; // make sure buffer is 32-bit aligned
 #ifdef __SSE2__
@@ -177,227 +183,14 @@ void MSXMixer::updateStream(EmuTime::param time)
 	if (recorder) {
 		recorder->addWave(count, mixBuffer);
 	}
+	if (auto& streamer = motherBoard.getReactor().getFrameStreamer();
+	    streamer.isConnected() && motherBoard.isActive()) {
+		streamer.addWave(count, mixBuffer, hostSampleRate);
+	}
 
 	prevTime += count;
 }
 
-
-// Various (inner) loops that multiply one buffer by a constant and add the
-// result to a second buffer. Either buffer can be mono or stereo, so if
-// necessary the mono buffer is expanded to stereo. It's possible the
-// accumulation buffer is still empty (as-if it contains zeros), in that case
-// we skip the accumulation step.
-
-// buf[0:n] *= f
-static inline void mul(float* buf, int n, float f)
-{
-	// C++ version, unrolled 4x,
-	//   this allows gcc/clang to do much better auto-vectorization
-	// Note that this can process upto 3 samples too many, but that's OK.
-	assume_SSE_aligned(buf);
-	int i = 0;
-	do {
-		buf[i + 0] *= f;
-		buf[i + 1] *= f;
-		buf[i + 2] *= f;
-		buf[i + 3] *= f;
-		i += 4;
-	} while (i < n);
-}
-
-// acc[0:n] += mul[0:n] * f
-static inline void mulAcc(
-	float* __restrict acc, const float* __restrict mul, int n, float f)
-{
-	// C++ version, unrolled 4x, see comments above.
-	assume_SSE_aligned(acc);
-	assume_SSE_aligned(mul);
-	int i = 0;
-	do {
-		acc[i + 0] += mul[i + 0] * f;
-		acc[i + 1] += mul[i + 1] * f;
-		acc[i + 2] += mul[i + 2] * f;
-		acc[i + 3] += mul[i + 3] * f;
-		i += 4;
-	} while (i < n);
-}
-
-// buf[0:2n+0:2] = buf[0:n] * l
-// buf[1:2n+1:2] = buf[0:n] * r
-static inline void mulExpand(float* buf, int n, float l, float r)
-{
-	int i = n;
-	do {
-		--i; // back-to-front
-		auto t = buf[i];
-		buf[2 * i + 0] = l * t;
-		buf[2 * i + 1] = r * t;
-	} while (i != 0);
-}
-
-// acc[0:2n+0:2] += mul[0:n] * l
-// acc[1:2n+1:2] += mul[0:n] * r
-static inline void mulExpandAcc(
-	float* __restrict acc, const float* __restrict mul, int n,
-	float l, float r)
-{
-	int i = 0;
-	do {
-		auto t = mul[i];
-		acc[2 * i + 0] += l * t;
-		acc[2 * i + 1] += r * t;
-	} while (++i < n);
-}
-
-// buf[0:2n+0:2] = buf[0:2n+0:2] * l1 + buf[1:2n+1:2] * l2
-// buf[1:2n+1:2] = buf[0:2n+0:2] * r1 + buf[1:2n+1:2] * r2
-static inline void mulMix2(float* buf, int n, float l1, float l2, float r1, float r2)
-{
-	int i = 0;
-	do {
-		auto t1 = buf[2 * i + 0];
-		auto t2 = buf[2 * i + 1];
-		buf[2 * i + 0] = l1 * t1 + l2 * t2;
-		buf[2 * i + 1] = r1 * t1 + r2 * t2;
-	} while (++i < n);
-}
-
-// acc[0:2n+0:2] += mul[0:2n+0:2] * l1 + mul[1:2n+1:2] * l2
-// acc[1:2n+1:2] += mul[0:2n+0:2] * r1 + mul[1:2n+1:2] * r2
-static inline void mulMix2Acc(
-	float* __restrict acc, const float* __restrict mul, int n,
-	float l1, float l2, float r1, float r2)
-{
-	int i = 0;
-	do {
-		auto t1 = mul[2 * i + 0];
-		auto t2 = mul[2 * i + 1];
-		acc[2 * i + 0] += l1 * t1 + l2 * t2;
-		acc[2 * i + 1] += r1 * t1 + r2 * t2;
-	} while (++i < n);
-}
-
-
-// DC removal filter routines:
-//
-//  formula:
-//     y(n) = x(n) - x(n-1) + R * y(n-1)
-//  implemented as:
-//     t1 = R * t0 + x(n)    mathematically equivalent, has
-//     y(n) = t1 - t0        the same number of operations but
-//     t0 = t1               requires only one state variable
-//    see: http://en.wikipedia.org/wiki/Digital_filter#Direct_Form_I
-//  with:
-//     R = 1 - (2*pi * cut-off-frequency / samplerate)
-//  we take R = 511/512
-//   44100Hz --> cutoff freq = 14Hz
-//   22050Hz                     7Hz
-constexpr auto R = 511.0f / 512.0f;
-
-// No new input, previous output was (non-zero) mono.
-static inline float filterMonoNull(float t0, float* __restrict out, int n)
-{
-	assert(n > 0);
-	int i = 0;
-	do {
-		auto t1 = R * t0;
-		auto s = t1 - t0;
-		out[2 * i + 0] = s;
-		out[2 * i + 1] = s;
-		t0 = t1;
-	} while (++i < n);
-	return t0;
-}
-
-// No new input, previous output was (non-zero) stereo.
-static inline std::tuple<float, float> filterStereoNull(
-	float tl0, float tr0, float* __restrict out, int n)
-{
-	assert(n > 0);
-	int i = 0;
-	do {
-		float tl1 = R * tl0;
-		float tr1 = R * tr0;
-		out[2 * i + 0] = tl1 - tl0;
-		out[2 * i + 1] = tr1 - tr0;
-		tl0 = tl1;
-		tr0 = tr1;
-	} while (++i < n);
-	return std::tuple(tl0, tr0);
-}
-
-// New input is mono, previous output was also mono.
-static inline float filterMonoMono(float t0, const float* __restrict in,
-                                   float* __restrict out, int n)
-{
-	assert(n > 0);
-	int i = 0;
-	do {
-		auto t1 = R * t0 + in[i];
-		auto s = t1 - t0;
-		out[2 * i + 0] = s;
-		out[2 * i + 1] = s;
-		t0 = t1;
-	} while (++i < n);
-	return t0;
-}
-
-// New input is mono, previous output was stereo
-static inline std::tuple<float, float>
-filterStereoMono(float tl0, float tr0, const float* __restrict in,
-                 float* __restrict out, int n)
-{
-	assert(n > 0);
-	int i = 0;
-	do {
-		auto x = in[i];
-		auto tl1 = R * tl0 + x;
-		auto tr1 = R * tr0 + x;
-		out[2 * i + 0] = tl1 - tl0;
-		out[2 * i + 1] = tr1 - tr0;
-		tl0 = tl1;
-		tr0 = tr1;
-	} while (++i < n);
-	return std::tuple(tl0, tr0);
-}
-
-// New input is stereo, (previous output either mono/stereo)
-static inline std::tuple<float, float>
-filterStereoStereo(float tl0, float tr0, const float* __restrict in,
-                   float* __restrict out, int n)
-{
-	assert(n > 0);
-	int i = 0;
-	do {
-		auto tl1 = R * tl0 + in[2 * i + 0];
-		auto tr1 = R * tr0 + in[2 * i + 1];
-		out[2 * i + 0] = tl1 - tl0;
-		out[2 * i + 1] = tr1 - tr0;
-		tl0 = tl1;
-		tr0 = tr1;
-	} while (++i < n);
-	return std::tuple(tl0, tr0);
-}
-
-// We have both mono and stereo input (and produce stereo output)
-static inline std::tuple<float, float>
-filterBothStereo(float tl0, float tr0, const float* __restrict inM,
-                 const float* __restrict inS, float* __restrict out, int n)
-{
-	assert(n > 0);
-	int i = 0;
-	do {
-		auto m = inM[i];
-		auto tl1 = R * tl0 + inS[2 * i + 0] + m;
-		auto tr1 = R * tr0 + inS[2 * i + 1] + m;
-		out[2 * i + 0] = tl1 - tl0;
-		out[2 * i + 1] = tr1 - tr0;
-		tl0 = tl1;
-		tr0 = tr1;
-	} while (++i < n);
-	return std::tuple(tl0, tr0);
-}
-
 static bool approxEqual(float x, float y)
 {
 	constexpr float threshold = 1.0f / 32768;
@@ -406,6 +199,8 @@ static bool approxEqual(float x, float y)
 
 void MSXMixer::generate(float* output, EmuTime::param time, unsigned samples)
 {
+	using namespace MixerKernels;
+
 	// The code below is specialized for a lot of cases (before this
 	// routine was _much_ shorter). This is done because this routine
 	// ends up relatively high (top 5) in a profile run.
@@ -434,33 +229,63 @@ void MSXMixer::generate(float* output, EmuTime::param time, unsigned samples)
 	constexpr unsigned HAS_STEREO_FLAG = 2;
 	unsigned usedBuffers = 0;
 
+	// With multiple threads, first generate all devices in their own
+	// buffer. The mixing below is still done in the same order, so the
+	// result is exactly the same as when generating on a single thread.
+	unsigned numThreads = mixer.getNumSoundThreads();
+	bool parallel = (numThreads > 1) && (infos.size() > 1);
+	if (parallel) {
+		generateParallel(time, samples, numThreads);
+	} else {
+		workers.reset();
+	}
+	// Generate device 'i' in 'buf' (parallel: copy it to 'buf'). Returns
+	// false when the device is silent.
+	auto generateInto = [&](size_t i, float* buf) {
+		if (!parallel) {
+			return infos[i].device->updateBuffer(samples, buf, time);
+		}
+		if (!deviceActive[i]) return false;
+		unsigned num = (infos[i].device->isStereo() ? 2 : 1) * samples + 3;
+		memcpy(buf, deviceBufs[i].data(), num * sizeof(float));
+		return true;
+	};
+	// Same, but when generated in parallel it avoids the copy.
+	auto generateDevice = [&](size_t i, float* buf) -> const float* {
+		if (!parallel) {
+			return infos[i].device->updateBuffer(samples, buf, time) ? buf : nullptr;
+		}
+		return deviceActive[i] ? deviceBufs[i].data() : nullptr;
+	};
+
 	// FIXME: The Infos should be ordered such that all the mono
 	// devices are handled first
-	for (auto& info : infos) {
+	for (auto i : xrange(infos.size())) {
+		auto& info = infos[i];
 		SoundDevice& device = *info.device;
 		auto l1 = info.left1;
 		auto r1 = info.right1;
 		if (!device.isStereo()) {
 			if (l1 == r1) {
 				if (!(usedBuffers & HAS_MONO_FLAG)) {
-					if (device.updateBuffer(samples, monoBuf, time)) {
+					if (generateInto(i, monoBuf)) {
 						usedBuffers |= HAS_MONO_FLAG;
 						mul(monoBuf, samples, l1);
 					}
 				} else {
-					if (device.updateBuffer(samples, tmpBuf, time)) {
-						mulAcc(monoBuf, tmpBuf, samples, l1);
+					if (const auto* buf = generateDevice(i, tmpBuf)) {
+						mulAcc(monoBuf, buf, samples, l1);
 					}
 				}
 			} else {
 				if (!(usedBuffers & HAS_STEREO_FLAG)) {
-					if (device.updateBuffer(samples, stereoBuf, time)) {
+					if (generateInto(i, stereoBuf)) {
 						usedBuffers |= HAS_STEREO_FLAG;
 						mulExpand(stereoBuf, samples, l1, r1);
 					}
 				} else {
-					if (device.updateBuffer(samples, tmpBuf, time)) {
-						mulExpandAcc(stereoBuf, tmpBuf, samples, l1, r1);
+					if (const auto* buf = generateDevice(i, tmpBuf)) {
+						mulExpandAcc(stereoBuf, buf, samples, l1, r1);
 					}
 				}
 			}
@@ -471,24 +296,24 @@ void MSXMixer::generate(float* output, EmuTime::param time, unsigned samples)
 				assert(l2 == 0.0f);
 				assert(r1 == 0.0f);
 				if (!(usedBuffers & HAS_STEREO_FLAG)) {
-					if (device.updateBuffer(samples, stereoBuf, time)) {
+					if (generateInto(i, stereoBuf)) {
 						usedBuffers |= HAS_STEREO_FLAG;
 						mul(stereoBuf, 2 * samples, l1);
 					}
 				} else {
-					if (device.updateBuffer(samples, tmpBuf, time)) {
-						mulAcc(stereoBuf, tmpBuf, 2 * samples, l1);
+					if (const auto* buf = generateDevice(i, tmpBuf)) {
+						mulAcc(stereoBuf, buf, 2 * samples, l1);
 					}
 				}
 			} else {
 				if (!(usedBuffers & HAS_STEREO_FLAG)) {
-					if (device.updateBuffer(samples, stereoBuf, time)) {
+					if (generateInto(i, stereoBuf)) {
 						usedBuffers |= HAS_STEREO_FLAG;
 						mulMix2(stereoBuf, samples, l1, l2, r1, r2);
 					}
 				} else {
-					if (device.updateBuffer(samples, tmpBuf, time)) {
-						mulMix2Acc(stereoBuf, tmpBuf, samples, l1, l2, r1, r2);
+					if (const auto* buf = generateDevice(i, tmpBuf)) {
+						mulMix2Acc(stereoBuf, buf, samples, l1, l2, r1, r2);
 					}
 				}
 			}
@@ -534,6 +359,43 @@ void MSXMixer::generate(float* output, EmuTime::param time, unsigned samples)
 	}
 }
 
+void MSXMixer::generateParallel(EmuTime::param time, unsigned samples, unsigned numThreads)
+{
+	if (workers && (workers->getNumThreads() != (numThreads - 1))) {
+		workers.reset();
+	}
+	if (!workers) {
+		workers = std::make_unique<WorkerPool>(numThreads - 1);
+	}
+	unsigned size = 2 * samples + 3;
+	if ((deviceBufs.size() != infos.size()) || (deviceBufSize < size)) {
+		deviceBufSize = std::max(deviceBufSize, size);
+		deviceBufs.resize(infos.size());
+		for (auto& buf : deviceBufs) buf.resize(deviceBufSize);
+	}
+	deviceActive.resize(infos.size());
+
+	// The devices are independent: register writes up to 'time' are
+	// either already done, or they're queued in the device (see
+	// ResampledSoundDevice::queueRegisterWrite()). Queued writes are
+	// applied from updateBuffer(), so on the worker threads, but they only
+	// change the state of that one device, and this thread waits till all
+	// devices are done. Device 0 is generated on this thread.
+	// The tasks only capture 'this' and the index, that's small enough
+	// for std::function to store them without a heap allocation.
+	parallelTime = time;
+	parallelSamples = samples;
+	auto gen = [this](size_t i) {
+		deviceActive[i] = infos[i].device->updateBuffer(
+			parallelSamples, deviceBufs[i].data(), parallelTime);
+	};
+	for (auto i : xrange(size_t(1), infos.size())) {
+		workers->post([gen, i] { gen(i); });
+	}
+	gen(0);
+	workers->wait();
+}
+
 bool MSXMixer::needStereoRecording() const
 {
 	return ranges::any_of(infos, [](auto& info) {
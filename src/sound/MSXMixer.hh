@@ -6,6 +6,9 @@
 #include "InfoTopic.hh"
 #include "EmuTime.hh"
 #include "DynamicClock.hh"
+#include "MemBuffer.hh"
+#include "aligned.hh"
+#include <cstdint>
 #include <vector>
 #include <memory>
 
@@ -22,6 +25,7 @@ class IntegerSetting;
 class StringSetting;
 class BooleanSetting;
 class Setting;
+class WorkerPool;
 class AviRecorder;
 
 class MSXMixer final : private Schedulable, private Observer<Setting>
@@ -138,6 +142,7 @@ private:
 	void reschedule();
 	void reschedule2();
 	void generate(float* output, EmuTime::param time, unsigned samples);
+	void generateParallel(EmuTime::param time, unsigned samples, unsigned numThreads);
 
 	// Schedulable
 	void executeUntil(EmuTime::param time) override;
@@ -180,6 +185,14 @@ private:
 	AviRecorder* recorder;
 	unsigned synchronousCounter;
 
+	// For generating the devices in parallel (see 'sound_threads').
+	std::unique_ptr<WorkerPool> workers; // can be nullptr
+	std::vector<MemBuffer<float, SSE_ALIGNMENT>> deviceBufs; // one per device
+	std::vector<uint8_t> deviceActive; // result of updateBuffer(), per device
+	unsigned deviceBufSize = 0;
+	EmuTime parallelTime = EmuTime::zero(); // arguments of the current
+	unsigned parallelSamples = 0;           //   generateParallel() call
+
 	unsigned muteCount;
 	float tl0, tr0; // internal DC-filter state
 };
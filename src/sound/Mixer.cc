@@ -5,12 +5,17 @@
 #include "CommandController.hh"
 #include "CliComm.hh"
 #include "MSXException.hh"
+#include "Reactor.hh"
+#include "TclObject.hh"
+#include "outer.hh"
 #include "one_of.hh"
 #include "stl.hh"
 #include "unreachable.hh"
 #include "build-info.hh"
+#include <algorithm>
 #include <cassert>
 #include <memory>
+#include <thread>
 
 namespace openmsx {
 
@@ -47,6 +52,12 @@ Mixer::Mixer(Reactor& reactor_, CommandController& commandController_)
 	, samplesSetting(
 		commandController, "samples",
 		"mixer samples", defaultsamples, 64, 8192)
+	, soundThreadsSetting(
+		commandController, "sound_threads",
+		"number of threads used to generate the sound of the emulated "
+		"sound chips (1 = only the main thread, 0 = one per CPU core)",
+		1, 0, MAX_SOUND_THREADS)
+	, latencyInfo(reactor.getOpenMSXInfoCommand())
 	, muteCount(0)
 {
 	muteSetting       .attach(*this);
@@ -153,6 +164,17 @@ void Mixer::uploadBuffer(MSXMixer& /*msxMixer*/, float* buffer, unsigned len)
 	driver->uploadBuffer(buffer, len);
 }
 
+unsigned Mixer::getNumSoundThreads() const
+{
+	unsigned num = soundThreadsSetting.getInt();
+	if (num == 0) {
+		// automatic: one per core
+		static const unsigned cores = std::thread::hardware_concurrency();
+		num = std::clamp(cores, 1u, unsigned(MAX_SOUND_THREADS));
+	}
+	return num;
+}
+
 void Mixer::update(const Setting& setting) noexcept
 {
 	if (&setting == &muteSetting) {
@@ -168,4 +190,29 @@ void Mixer::update(const Setting& setting) noexcept
 	}
 }
 
+
+// class LatencyInfo
+
+Mixer::LatencyInfo::LatencyInfo(InfoCommand& openMSXInfoCommand)
+	: InfoTopic(openMSXInfoCommand, "sound_latency")
+{
+}
+
+void Mixer::LatencyInfo::execute(span<const TclObject> /*tokens*/,
+                                 TclObject& result) const
+{
+	auto& mixer = OUTER(Mixer, latencyInfo);
+	auto latency = mixer.driver->getLatency();
+	result.addDictKeyValues("latency",   latency.current * 1000.0,
+	                        "target",    latency.target  * 1000.0,
+	                        "underruns", int(latency.underruns));
+}
+
+std::string Mixer::LatencyInfo::help(span<const TclObject> /*tokens*/) const
+{
+	return "Returns the delay (in ms) between generating and playing the "
+	       "sound, the targeted delay and the number of buffer underruns "
+	       "of the current sound driver.";
+}
+
 } // namespace openmsx
@@ -4,6 +4,7 @@
 #include "Observer.hh"
 #include "BooleanSetting.hh"
 #include "EnumSetting.hh"
+#include "InfoTopic.hh"
 #include "IntegerSetting.hh"
 #include <vector>
 #include <memory>
@@ -47,6 +48,10 @@ public:
 
 	[[nodiscard]] IntegerSetting& getMasterVolume() { return masterVolume; }
 
+	/** Number of threads to generate the sound devices with (>= 1). */
+	[[nodiscard]] unsigned getNumSoundThreads() const;
+	static constexpr int MAX_SOUND_THREADS = 16;
+
 private:
 	void reloadDriver();
 	void muteHelper();
@@ -66,6 +71,14 @@ private:
 	IntegerSetting masterVolume;
 	IntegerSetting frequencySetting;
 	IntegerSetting samplesSetting;
+	IntegerSetting soundThreadsSetting;
+
+	struct LatencyInfo final : InfoTopic {
+		explicit LatencyInfo(InfoCommand& openMSXInfoCommand);
+		void execute(span<const TclObject> tokens,
+		             TclObject& result) const override;
+		[[nodiscard]] std::string help(span<const TclObject> tokens) const override;
+	} latencyInfo;
 
 	int muteCount;
 };
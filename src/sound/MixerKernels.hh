@@ -0,0 +1,378 @@
+#ifndef MIXERKERNELS_HH
+#define MIXERKERNELS_HH
+
+// Inner loops of MSXMixer::generate(), in a separate header so that they can
+// be unit-tested (and benchmarked) in isolation.
+//
+// The SSE2 versions perform exactly the same floating point operations (in
+// the same order) as the generic C++ versions, so both produce bit-identical
+// results.
+
+#include "aligned.hh"
+#include <cassert>
+#include <tuple>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace openmsx::MixerKernels {
+
+// Various (inner) loops that multiply one buffer by a constant and add the
+// result to a second buffer. Either buffer can be mono or stereo, so if
+// necessary the mono buffer is expanded to stereo. It's possible the
+// accumulation buffer is still empty (as-if it contains zeros), in that case
+// we skip the accumulation step.
+
+// buf[0:n] *= f
+inline void mul(float* buf, int n, float f)
+{
+	// C++ version, unrolled 4x,
+	//   this allows gcc/clang to do much better auto-vectorization
+	// Note that this can process upto 3 samples too many, but that's OK.
+	assume_SSE_aligned(buf);
+	int i = 0;
+	do {
+		buf[i + 0] *= f;
+		buf[i + 1] *= f;
+		buf[i + 2] *= f;
+		buf[i + 3] *= f;
+		i += 4;
+	} while (i < n);
+}
+
+// acc[0:n] += mul[0:n] * f
+inline void mulAcc(
+	float* __restrict acc, const float* __restrict mul, int n, float f)
+{
+	// C++ version, unrolled 4x, see comments above.
+	assume_SSE_aligned(acc);
+	assume_SSE_aligned(mul);
+	int i = 0;
+	do {
+		acc[i + 0] += mul[i + 0] * f;
+		acc[i + 1] += mul[i + 1] * f;
+		acc[i + 2] += mul[i + 2] * f;
+		acc[i + 3] += mul[i + 3] * f;
+		i += 4;
+	} while (i < n);
+}
+
+// The stereo routines below interleave the left and right channel, the
+// compiler doesn't auto-vectorize these well. Unlike mul() and mulAcc(), they
+// don't process any extra samples: the stereo buffers only have room for 3
+// extra floats, that's not enough for a whole extra stereo group.
+
+// buf[0:2n+0:2] = buf[0:n] * l
+// buf[1:2n+1:2] = buf[0:n] * r
+inline void mulExpand(float* buf, int n, float l, float r)
+{
+	int i = n;
+#ifdef __SSE2__
+	// First the (at most 3) samples at the end that don't fill a whole
+	// group, then whole groups, all back-to-front. Reading group 'k'
+	// (buf[4k:4k+4]) completes before writing it to buf[8k:8k+8], and all
+	// of that (except for k=0 itself) was already read before.
+	assume_SSE_aligned(buf);
+	while (i & 3) {
+		--i;
+		auto t = buf[i];
+		buf[2 * i + 0] = l * t;
+		buf[2 * i + 1] = r * t;
+	}
+	__m128 lr = _mm_setr_ps(l, r, l, r);
+	while (i != 0) {
+		i -= 4;
+		__m128 t = _mm_load_ps(buf + i);
+		__m128 lo = _mm_unpacklo_ps(t, t); // t0 t0 t1 t1
+		__m128 hi = _mm_unpackhi_ps(t, t); // t2 t2 t3 t3
+		_mm_store_ps(buf + 2 * i + 0, _mm_mul_ps(lr, lo));
+		_mm_store_ps(buf + 2 * i + 4, _mm_mul_ps(lr, hi));
+	}
+#else
+	do {
+		--i; // back-to-front
+		auto t = buf[i];
+		buf[2 * i + 0] = l * t;
+		buf[2 * i + 1] = r * t;
+	} while (i != 0);
+#endif
+}
+
+// acc[0:2n+0:2] += mul[0:n] * l
+// acc[1:2n+1:2] += mul[0:n] * r
+inline void mulExpandAcc(
+	float* __restrict acc, const float* __restrict mul, int n,
+	float l, float r)
+{
+	int i = 0;
+#ifdef __SSE2__
+	assume_SSE_aligned(acc);
+	assume_SSE_aligned(mul);
+	__m128 lr = _mm_setr_ps(l, r, l, r);
+	for (/**/; i < (n & ~3); i += 4) {
+		__m128 t = _mm_load_ps(mul + i);
+		__m128 lo = _mm_unpacklo_ps(t, t);
+		__m128 hi = _mm_unpackhi_ps(t, t);
+		__m128 a0 = _mm_load_ps(acc + 2 * i + 0);
+		__m128 a1 = _mm_load_ps(acc + 2 * i + 4);
+		_mm_store_ps(acc + 2 * i + 0, _mm_add_ps(a0, _mm_mul_ps(lr, lo)));
+		_mm_store_ps(acc + 2 * i + 4, _mm_add_ps(a1, _mm_mul_ps(lr, hi)));
+	}
+#endif
+	for (/**/; i < n; ++i) {
+		auto t = mul[i];
+		acc[2 * i + 0] += l * t;
+		acc[2 * i + 1] += r * t;
+	}
+}
+
+#ifdef __SSE2__
+// Helper for mulMix2() and mulMix2Acc(): two stereo samples at once.
+[[nodiscard]] inline __m128 mix2(__m128 t, __m128 lr1, __m128 lr2)
+{
+	__m128 t1 = _mm_shuffle_ps(t, t, _MM_SHUFFLE(2, 2, 0, 0));
+	__m128 t2 = _mm_shuffle_ps(t, t, _MM_SHUFFLE(3, 3, 1, 1));
+	return _mm_add_ps(_mm_mul_ps(lr1, t1), _mm_mul_ps(lr2, t2));
+}
+#endif
+
+// buf[0:2n+0:2] = buf[0:2n+0:2] * l1 + buf[1:2n+1:2] * l2
+// buf[1:2n+1:2] = buf[0:2n+0:2] * r1 + buf[1:2n+1:2] * r2
+inline void mulMix2(float* buf, int n, float l1, float l2, float r1, float r2)
+{
+	int i = 0;
+#ifdef __SSE2__
+	assume_SSE_aligned(buf);
+	__m128 lr1 = _mm_setr_ps(l1, r1, l1, r1);
+	__m128 lr2 = _mm_setr_ps(l2, r2, l2, r2);
+	for (/**/; i < (n & ~1); i += 2) {
+		_mm_store_ps(buf + 2 * i, mix2(_mm_load_ps(buf + 2 * i), lr1, lr2));
+	}
+#endif
+	for (/**/; i < n; ++i) {
+		auto t1 = buf[2 * i + 0];
+		auto t2 = buf[2 * i + 1];
+		buf[2 * i + 0] = l1 * t1 + l2 * t2;
+		buf[2 * i + 1] = r1 * t1 + r2 * t2;
+	}
+}
+
+// acc[0:2n+0:2] += mul[0:2n+0:2] * l1 + mul[1:2n+1:2] * l2
+// acc[1:2n+1:2] += mul[0:2n+0:2] * r1 + mul[1:2n+1:2] * r2
+inline void mulMix2Acc(
+	float* __restrict acc, const float* __restrict mul, int n,
+	float l1, float l2, float r1, float r2)
+{
+	int i = 0;
+#ifdef __SSE2__
+	assume_SSE_aligned(acc);
+	assume_SSE_aligned(mul);
+	__m128 lr1 = _mm_setr_ps(l1, r1, l1, r1);
+	__m128 lr2 = _mm_setr_ps(l2, r2, l2, r2);
+	for (/**/; i < (n & ~1); i += 2) {
+		__m128 a = _mm_load_ps(acc + 2 * i);
+		__m128 m = mix2(_mm_load_ps(mul + 2 * i), lr1, lr2);
+		_mm_store_ps(acc + 2 * i, _mm_add_ps(a, m));
+	}
+#endif
+	for (/**/; i < n; ++i) {
+		auto t1 = mul[2 * i + 0];
+		auto t2 = mul[2 * i + 1];
+		acc[2 * i + 0] += l1 * t1 + l2 * t2;
+		acc[2 * i + 1] += r1 * t1 + r2 * t2;
+	}
+}
+
+
+// DC removal filter routines:
+//
+//  formula:
+//     y(n) = x(n) - x(n-1) + R * y(n-1)
+//  implemented as:
+//     t1 = R * t0 + x(n)    mathematically equivalent, has
+//     y(n) = t1 - t0        the same number of operations but
+//     t0 = t1               requires only one state variable
+//    see: http://en.wikipedia.org/wiki/Digital_filter#Direct_Form_I
+//  with:
+//     R = 1 - (2*pi * cut-off-frequency / samplerate)
+//  we take R = 511/512
+//   44100Hz --> cutoff freq = 14Hz
+//   22050Hz                     7Hz
+//
+// This is a recursive filter, each output sample depends on the previous
+// one. Processing several samples at once would require reordering the
+// floating point operations (and thus change the result). So the stereo
+// SSE2 versions only process the left and right channel together, in the
+// lower two elements of a SSE register.
+constexpr auto R = 511.0f / 512.0f;
+
+#ifdef __SSE2__
+[[nodiscard]] inline __m128 loadStereo(const float* p)
+{
+	return _mm_castpd_ps(_mm_load_sd(reinterpret_cast<const double*>(p)));
+}
+inline void storeStereo(float* p, __m128 v)
+{
+	_mm_store_sd(reinterpret_cast<double*>(p), _mm_castps_pd(v));
+}
+[[nodiscard]] inline std::tuple<float, float> toTuple(__m128 v)
+{
+	return std::tuple(_mm_cvtss_f32(v),
+	                  _mm_cvtss_f32(_mm_shuffle_ps(v, v, _MM_SHUFFLE(1, 1, 1, 1))));
+}
+#endif
+
+// No new input, previous output was (non-zero) mono.
+inline float filterMonoNull(float t0, float* __restrict out, int n)
+{
+	assert(n > 0);
+	int i = 0;
+	do {
+		auto t1 = R * t0;
+		auto s = t1 - t0;
+		out[2 * i + 0] = s;
+		out[2 * i + 1] = s;
+		t0 = t1;
+	} while (++i < n);
+	return t0;
+}
+
+// No new input, previous output was (non-zero) stereo.
+inline std::tuple<float, float> filterStereoNull(
+	float tl0, float tr0, float* __restrict out, int n)
+{
+	assert(n > 0);
+	int i = 0;
+#ifdef __SSE2__
+	__m128 r = _mm_set1_ps(R);
+	__m128 t0 = _mm_setr_ps(tl0, tr0, 0.0f, 0.0f);
+	do {
+		__m128 t1 = _mm_mul_ps(r, t0);
+		storeStereo(out + 2 * i, _mm_sub_ps(t1, t0));
+		t0 = t1;
+	} while (++i < n);
+	return toTuple(t0);
+#else
+	do {
+		float tl1 = R * tl0;
+		float tr1 = R * tr0;
+		out[2 * i + 0] = tl1 - tl0;
+		out[2 * i + 1] = tr1 - tr0;
+		tl0 = tl1;
+		tr0 = tr1;
+	} while (++i < n);
+	return std::tuple(tl0, tr0);
+#endif
+}
+
+// New input is mono, previous output was also mono.
+inline float filterMonoMono(float t0, const float* __restrict in,
+                            float* __restrict out, int n)
+{
+	assert(n > 0);
+	int i = 0;
+	do {
+		auto t1 = R * t0 + in[i];
+		auto s = t1 - t0;
+		out[2 * i + 0] = s;
+		out[2 * i + 1] = s;
+		t0 = t1;
+	} while (++i < n);
+	return t0;
+}
+
+// New input is mono, previous output was stereo
+inline std::tuple<float, float>
+filterStereoMono(float tl0, float tr0, const float* __restrict in,
+                 float* __restrict out, int n)
+{
+	assert(n > 0);
+	int i = 0;
+#ifdef __SSE2__
+	__m128 r = _mm_set1_ps(R);
+	__m128 t0 = _mm_setr_ps(tl0, tr0, 0.0f, 0.0f);
+	do {
+		__m128 x = _mm_set1_ps(in[i]);
+		__m128 t1 = _mm_add_ps(_mm_mul_ps(r, t0), x);
+		storeStereo(out + 2 * i, _mm_sub_ps(t1, t0));
+		t0 = t1;
+	} while (++i < n);
+	return toTuple(t0);
+#else
+	do {
+		auto x = in[i];
+		auto tl1 = R * tl0 + x;
+		auto tr1 = R * tr0 + x;
+		out[2 * i + 0] = tl1 - tl0;
+		out[2 * i + 1] = tr1 - tr0;
+		tl0 = tl1;
+		tr0 = tr1;
+	} while (++i < n);
+	return std::tuple(tl0, tr0);
+#endif
+}
+
+// New input is stereo, (previous output either mono/stereo)
+inline std::tuple<float, float>
+filterStereoStereo(float tl0, float tr0, const float* __restrict in,
+                   float* __restrict out, int n)
+{
+	assert(n > 0);
+	int i = 0;
+#ifdef __SSE2__
+	__m128 r = _mm_set1_ps(R);
+	__m128 t0 = _mm_setr_ps(tl0, tr0, 0.0f, 0.0f);
+	do {
+		__m128 t1 = _mm_add_ps(_mm_mul_ps(r, t0), loadStereo(in + 2 * i));
+		storeStereo(out + 2 * i, _mm_sub_ps(t1, t0));
+		t0 = t1;
+	} while (++i < n);
+	return toTuple(t0);
+#else
+	do {
+		auto tl1 = R * tl0 + in[2 * i + 0];
+		auto tr1 = R * tr0 + in[2 * i + 1];
+		out[2 * i + 0] = tl1 - tl0;
+		out[2 * i + 1] = tr1 - tr0;
+		tl0 = tl1;
+		tr0 = tr1;
+	} while (++i < n);
+	return std::tuple(tl0, tr0);
+#endif
+}
+
+// We have both mono and stereo input (and produce stereo output)
+inline std::tuple<float, float>
+filterBothStereo(float tl0, float tr0, const float* __restrict inM,
+                 const float* __restrict inS, float* __restrict out, int n)
+{
+	assert(n > 0);
+	int i = 0;
+#ifdef __SSE2__
+	__m128 r = _mm_set1_ps(R);
+	__m128 t0 = _mm_setr_ps(tl0, tr0, 0.0f, 0.0f);
+	do {
+		__m128 m = _mm_set1_ps(inM[i]);
+		__m128 t1 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(r, t0), loadStereo(inS + 2 * i)), m);
+		storeStereo(out + 2 * i, _mm_sub_ps(t1, t0));
+		t0 = t1;
+	} while (++i < n);
+	return toTuple(t0);
+#else
+	do {
+		auto m = inM[i];
+		auto tl1 = R * tl0 + inS[2 * i + 0] + m;
+		auto tr1 = R * tr0 + inS[2 * i + 1] + m;
+		out[2 * i + 0] = tl1 - tl0;
+		out[2 * i + 1] = tr1 - tr0;
+		tl0 = tl1;
+		tr0 = tr1;
+	} while (++i < n);
+	return std::tuple(tl0, tr0);
+#endif
+}
+
+} // namespace openmsx::MixerKernels
+
+#endif
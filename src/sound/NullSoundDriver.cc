@@ -24,4 +24,9 @@ void NullSoundDriver::uploadBuffer(float* /*buffer*/, unsigned /*len*/)
 {
 }
 
+SoundDriver::Latency NullSoundDriver::getLatency() const
+{
+	return {0.0, 0.0, 0};
+}
+
 } // namespace openmsx
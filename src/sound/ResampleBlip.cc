@@ -42,6 +42,10 @@ bool ResampleBlip<CHANNELS>::generateOutputImpl(float* dataOut, unsigned hostNum
 		if (input.generateInput(buf, emuNum)) {
 			FP pos1;
 			hostClock.getTicksTill(emu1, pos1);
+			// Collect all changes of one channel, then add them to
+			// the BlipBuffer in one go.
+			VLA(BlipBuffer::TimeIndex, times, emuNum);
+			VLA(float, deltas, emuNum);
 			for (auto ch : xrange(CHANNELS)) {
 				// In case of PSG (and to a lesser degree SCC) it happens
 				// very often that two consecutive samples have the same
@@ -53,6 +57,7 @@ bool ResampleBlip<CHANNELS>::generateOutputImpl(float* dataOut, unsigned hostNum
 					buf[CHANNELS * (emuNum - 1) + ch] + 1.0f;
 				FP pos = pos1;
 				auto last = lastInput[ch]; // local var is slightly faster
+				unsigned num = 0;
 				for (unsigned i = 0; /**/; ++i) {
 					auto delta = buf[CHANNELS * i + ch] - last;
 					if (unlikely(delta != 0)) {
@@ -60,12 +65,13 @@ bool ResampleBlip<CHANNELS>::generateOutputImpl(float* dataOut, unsigned hostNum
 							break;
 						}
 						last = buf[CHANNELS * i + ch];
-						blip[ch].addDelta(
-							BlipBuffer::TimeIndex(pos),
-							delta);
+						times[num] = BlipBuffer::TimeIndex(pos);
+						deltas[num] = delta;
+						++num;
 					}
 					pos += step;
 				}
+				blip[ch].addDeltas(times, deltas, num);
 				lastInput[ch] = last;
 			}
 		} else {
@@ -29,6 +29,21 @@
 #ifdef __SSE2__
 #include <emmintrin.h>
 #endif
+#if defined(__AVX2__) && defined(__FMA__)
+#include <immintrin.h>
+#define RESAMPLE_HQ_AVX 1
+#define AVX_TARGET
+#elif defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+// Also build the AVX2+FMA version and select it at run time.
+#include <immintrin.h>
+#define RESAMPLE_HQ_AVX 1
+#define RESAMPLE_HQ_AVX_DISPATCH 1
+#define AVX_TARGET __attribute__((target("avx2,fma")))
+#endif
+#if defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#define RESAMPLE_HQ_NEON 1
+#endif
 
 namespace openmsx {
 
@@ -524,6 +539,162 @@ static inline void calcSseStereo(const float* buf_, const float* tab_, size_t le
 
 #endif
 
+#ifdef RESAMPLE_HQ_AVX
+// Used when compiling with e.g. -march=native, or (on x86-64 with gcc/clang)
+// when the CPU supports it, see useAvx(). Compared to the SSE2 version this
+// processes twice as many coefficients per instruction, it uses fused
+// multiply-add and it needs fewer shuffles. The result can differ in the last
+// bit from the SSE2 version, that's fine.
+
+[[nodiscard]] static inline bool useAvx()
+{
+#ifdef RESAMPLE_HQ_AVX_DISPATCH
+	static const bool result = __builtin_cpu_supports("avx2") &&
+	                           __builtin_cpu_supports("fma");
+	return result;
+#else
+	return true;
+#endif
+}
+
+// Load 8 coefficients, in reverse order when REVERSE (then 'p' points just
+// past the 8 elements).
+template<bool REVERSE>
+AVX_TARGET static inline __m256 loadTab8(const float* p)
+{
+	if constexpr (REVERSE) {
+		return _mm256_permutevar8x32_ps(_mm256_loadu_ps(p - 8),
+		                                _mm256_setr_epi32(7, 6, 5, 4, 3, 2, 1, 0));
+	} else {
+		return _mm256_loadu_ps(p);
+	}
+}
+// Load 4 coefficients and duplicate each: (c0 c0 c1 c1 c2 c2 c3 c3).
+template<bool REVERSE>
+AVX_TARGET static inline __m256 loadTab4x2(const float* p)
+{
+	if constexpr (REVERSE) {
+		return _mm256_permutevar8x32_ps(_mm256_castps128_ps256(_mm_load_ps(p - 4)),
+		                                _mm256_setr_epi32(3, 3, 2, 2, 1, 1, 0, 0));
+	} else {
+		return _mm256_permutevar8x32_ps(_mm256_castps128_ps256(_mm_load_ps(p)),
+		                                _mm256_setr_epi32(0, 0, 1, 1, 2, 2, 3, 3));
+	}
+}
+
+template<bool REVERSE>
+AVX_TARGET static inline void calcAvxMono(const float* buf, const float* tab, size_t len, float* out)
+{
+	assert((len % 4) == 0);
+	assert((uintptr_t(tab) % 16) == 0);
+	int dir = REVERSE ? -1 : 1;
+
+	__m256 a0 = _mm256_setzero_ps();
+	__m256 a1 = _mm256_setzero_ps();
+	size_t i = 0;
+	for (/**/; (i + 16) <= len; i += 16) {
+		a0 = _mm256_fmadd_ps(_mm256_loadu_ps(buf + i + 0),
+		                     loadTab8<REVERSE>(tab + dir * int(i + 0)), a0);
+		a1 = _mm256_fmadd_ps(_mm256_loadu_ps(buf + i + 8),
+		                     loadTab8<REVERSE>(tab + dir * int(i + 8)), a1);
+	}
+	if ((i + 8) <= len) {
+		a0 = _mm256_fmadd_ps(_mm256_loadu_ps(buf + i),
+		                     loadTab8<REVERSE>(tab + dir * int(i)), a0);
+		i += 8;
+	}
+	__m256 a = _mm256_add_ps(a0, a1);
+	__m128 s = _mm_add_ps(_mm256_castps256_ps128(a), _mm256_extractf128_ps(a, 1));
+	if (i < len) {
+		__m128 t = REVERSE ? _mm_loadr_ps(tab - i - 4) : _mm_load_ps(tab + i);
+		s = _mm_fmadd_ps(_mm_loadu_ps(buf + i), t, s);
+	}
+	s = _mm_add_ps(s, _mm_movehl_ps(s, s));
+	s = _mm_add_ss(s, _mm_shuffle_ps(s, s, 1));
+	_mm_store_ss(out, s);
+}
+
+template<bool REVERSE>
+AVX_TARGET static inline void calcAvxStereo(const float* buf, const float* tab, size_t len, float* out)
+{
+	assert((len % 4) == 0);
+	assert((uintptr_t(tab) % 16) == 0);
+	int dir = REVERSE ? -1 : 1;
+
+	__m256 a0 = _mm256_setzero_ps();
+	__m256 a1 = _mm256_setzero_ps();
+	size_t i = 0;
+	for (/**/; (i + 8) <= len; i += 8) {
+		a0 = _mm256_fmadd_ps(_mm256_loadu_ps(buf + 2 * i + 0),
+		                     loadTab4x2<REVERSE>(tab + dir * int(i + 0)), a0);
+		a1 = _mm256_fmadd_ps(_mm256_loadu_ps(buf + 2 * i + 8),
+		                     loadTab4x2<REVERSE>(tab + dir * int(i + 4)), a1);
+	}
+	if (i < len) {
+		a0 = _mm256_fmadd_ps(_mm256_loadu_ps(buf + 2 * i),
+		                     loadTab4x2<REVERSE>(tab + dir * int(i)), a0);
+	}
+	__m256 a = _mm256_add_ps(a0, a1);
+	__m128 s = _mm_add_ps(_mm256_castps256_ps128(a), _mm256_extractf128_ps(a, 1));
+	s = _mm_add_ps(s, _mm_movehl_ps(s, s));
+	_mm_store_ss(&out[0], s);
+	_mm_store_ss(&out[1], _mm_shuffle_ps(s, s, _MM_SHUFFLE(1, 1, 1, 1)));
+}
+
+#elif defined(RESAMPLE_HQ_NEON)
+// Same as the SSE2 version, but with fused multiply-add (always present on
+// aarch64).
+
+template<bool REVERSE>
+static inline float32x4_t loadTab4(const float* p)
+{
+	if constexpr (REVERSE) {
+		float32x4_t t = vrev64q_f32(vld1q_f32(p - 4)); // c1 c0 c3 c2
+		return vextq_f32(t, t, 2);                      // c3 c2 c1 c0
+	} else {
+		return vld1q_f32(p);
+	}
+}
+
+template<bool REVERSE>
+static inline void calcNeonMono(const float* buf, const float* tab, size_t len, float* out)
+{
+	assert((len % 4) == 0);
+	int dir = REVERSE ? -1 : 1;
+
+	float32x4_t a0 = vdupq_n_f32(0.0f);
+	float32x4_t a1 = vdupq_n_f32(0.0f);
+	size_t i = 0;
+	for (/**/; (i + 8) <= len; i += 8) {
+		a0 = vfmaq_f32(a0, vld1q_f32(buf + i + 0), loadTab4<REVERSE>(tab + dir * int(i + 0)));
+		a1 = vfmaq_f32(a1, vld1q_f32(buf + i + 4), loadTab4<REVERSE>(tab + dir * int(i + 4)));
+	}
+	if (i < len) {
+		a0 = vfmaq_f32(a0, vld1q_f32(buf + i), loadTab4<REVERSE>(tab + dir * int(i)));
+	}
+	*out = vaddvq_f32(vaddq_f32(a0, a1));
+}
+
+template<bool REVERSE>
+static inline void calcNeonStereo(const float* buf, const float* tab, size_t len, float* out)
+{
+	assert((len % 4) == 0);
+	int dir = REVERSE ? -1 : 1;
+
+	float32x4_t a0 = vdupq_n_f32(0.0f);
+	float32x4_t a1 = vdupq_n_f32(0.0f);
+	for (size_t i = 0; i < len; i += 4) {
+		float32x4_t t = loadTab4<REVERSE>(tab + dir * int(i));
+		a0 = vfmaq_f32(a0, vld1q_f32(buf + 2 * i + 0), vzip1q_f32(t, t));
+		a1 = vfmaq_f32(a1, vld1q_f32(buf + 2 * i + 4), vzip2q_f32(t, t));
+	}
+	float32x4_t a = vaddq_f32(a0, a1);
+	float32x2_t s = vadd_f32(vget_low_f32(a), vget_high_f32(a));
+	vst1_f32(out, s);
+}
+
+#endif
+
 template<unsigned CHANNELS>
 void ResampleHQ<CHANNELS>::calcOutput(
 	float pos, float* __restrict output)
@@ -541,13 +712,30 @@ void ResampleHQ<CHANNELS>::calcOutput(
 		t = permute[t];
 		const float* tab = &table[t * filterLen];
 
-#ifdef __SSE2__
+#ifdef RESAMPLE_HQ_AVX
+		if (useAvx()) {
+			if constexpr (CHANNELS == 1) {
+				calcAvxMono  <false>(buf, tab, filterLen, output);
+			} else {
+				calcAvxStereo<false>(buf, tab, filterLen, output);
+			}
+			return;
+		}
+#endif
+#if defined(__SSE2__)
 		if constexpr (CHANNELS == 1) {
 			calcSseMono  <false>(buf, tab, filterLen, output);
 		} else {
 			calcSseStereo<false>(buf, tab, filterLen, output);
 		}
 		return;
+#elif defined(RESAMPLE_HQ_NEON)
+		if constexpr (CHANNELS == 1) {
+			calcNeonMono  <false>(buf, tab, filterLen, output);
+		} else {
+			calcNeonStereo<false>(buf, tab, filterLen, output);
+		}
+		return;
 #endif
 
 		// c++ version, both mono and stereo
@@ -570,13 +758,30 @@ void ResampleHQ<CHANNELS>::calcOutput(
 		t = permute[TAB_LEN - 1 - t];
 		const float* tab = &table[(t + 1) * filterLen];
 
-#ifdef __SSE2__
+#ifdef RESAMPLE_HQ_AVX
+		if (useAvx()) {
+			if constexpr (CHANNELS == 1) {
+				calcAvxMono  <true>(buf, tab, filterLen, output);
+			} else {
+				calcAvxStereo<true>(buf, tab, filterLen, output);
+			}
+			return;
+		}
+#endif
+#if defined(__SSE2__)
 		if constexpr (CHANNELS == 1) {
 			calcSseMono  <true>(buf, tab, filterLen, output);
 		} else {
 			calcSseStereo<true>(buf, tab, filterLen, output);
 		}
 		return;
+#elif defined(RESAMPLE_HQ_NEON)
+		if constexpr (CHANNELS == 1) {
+			calcNeonMono  <true>(buf, tab, filterLen, output);
+		} else {
+			calcNeonStereo<true>(buf, tab, filterLen, output);
+		}
+		return;
 #endif
 
 		// c++ version, both mono and stereo
@@ -598,8 +803,17 @@ void ResampleHQ<CHANNELS>::calcOutput(
 }
 
 template<unsigned CHANNELS>
-void ResampleHQ<CHANNELS>::prepareData(unsigned emuNum)
+bool ResampleHQ<CHANNELS>::prepareData(unsigned emuNum)
 {
+	VLA_SSE_ALIGNED(float, tmpBuf, emuNum * CHANNELS + 3);
+	bool silent = !input.generateInput(tmpBuf, emuNum);
+	if (silent && (nonzeroSamples == 0)) {
+		// The buffer only contains zeros, appending more zeros and
+		// dropping the same amount at the start would give the same
+		// content. So instead leave the buffer as-is.
+		return false;
+	}
+
 	// Still enough free space at end of buffer?
 	unsigned free = unsigned(buffer.size() / CHANNELS) - bufEnd;
 	if (free < emuNum) {
@@ -624,8 +838,7 @@ void ResampleHQ<CHANNELS>::prepareData(unsigned emuNum)
 			buffer.resize(buffer.size() + missing * CHANNELS);
 		}
 	}
-	VLA_SSE_ALIGNED(float, tmpBuf, emuNum * CHANNELS + 3);
-	if (input.generateInput(tmpBuf, emuNum)) {
+	if (!silent) {
 		memcpy(&buffer[bufEnd * CHANNELS], tmpBuf,
 		       emuNum * CHANNELS * sizeof(float));
 		bufEnd += emuNum;
@@ -638,6 +851,7 @@ void ResampleHQ<CHANNELS>::prepareData(unsigned emuNum)
 
 	assert(bufStart <= bufEnd);
 	assert(bufEnd <= (buffer.size() / CHANNELS));
+	return true;
 }
 
 template<unsigned CHANNELS>
@@ -646,9 +860,7 @@ bool ResampleHQ<CHANNELS>::generateOutputImpl(
 {
 	auto& emuClk = getEmuClock();
 	unsigned emuNum = emuClk.getTicksTill(time);
-	if (emuNum > 0) {
-		prepareData(emuNum);
-	}
+	bool appended = (emuNum > 0) && prepareData(emuNum);
 
 	bool notMuted = nonzeroSamples > 0;
 	if (notMuted) {
@@ -663,7 +875,7 @@ bool ResampleHQ<CHANNELS>::generateOutputImpl(
 		}
 	}
 	emuClk += emuNum;
-	bufStart += emuNum;
+	if (appended) bufStart += emuNum;
 	nonzeroSamples = std::max<int>(0, nonzeroSamples - emuNum);
 
 	assert(bufStart <= bufEnd);
@@ -24,7 +24,8 @@ public:
 
 private:
 	void calcOutput(float pos, float* output);
-	void prepareData(unsigned emuNum);
+	/** Returns false when nothing was appended (see implementation). */
+	[[nodiscard]] bool prepareData(unsigned emuNum);
 
 private:
 	const DynamicClock& hostClock;
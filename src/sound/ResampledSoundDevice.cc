@@ -8,7 +8,10 @@
 #include "GlobalSettings.hh"
 #include "EnumSetting.hh"
 #include "unreachable.hh"
+#include "vla.hh"
+#include <algorithm>
 #include <cassert>
+#include <cstring>
 #include <memory>
 
 namespace openmsx {
@@ -21,6 +24,7 @@ ResampledSoundDevice::ResampledSoundDevice(
 	              channels, inputSampleRate_, stereo_)
 	, resampleSetting(motherBoard.getReactor().getGlobalSettings().getResampleSetting())
 	, emuClock(EmuTime::zero())
+	, inputClock(EmuTime::zero())
 {
 	resampleSetting.attach(*this);
 }
@@ -44,9 +48,92 @@ bool ResampledSoundDevice::updateBuffer(unsigned length, float* buffer,
 
 bool ResampledSoundDevice::generateInput(float* buffer, unsigned num)
 {
+	if (!registerWrites.empty()) {
+		return generateWithRegisterWrites(buffer, num);
+	}
+	inputClock += num;
 	return mixChannels(buffer, num);
 }
 
+bool ResampledSoundDevice::generateWithRegisterWrites(float* buffer, unsigned num)
+{
+	// Split the block at the position of each queued write. The pieces are
+	// generated in a temporary (aligned) buffer, silent pieces are filled
+	// with zeros because the result must be valid as a whole.
+	unsigned step = isStereo() ? 2 : 1;
+	VLA_SSE_ALIGNED(float, tmp, num * step + 3);
+	bool result = false;
+	unsigned done = 0;
+	auto generateTill = [&](unsigned pos) {
+		if (pos == done) return;
+		auto* out = buffer + done * step;
+		auto n = (pos - done) * step;
+		if (mixChannels(tmp, pos - done)) {
+			memcpy(out, tmp, n * sizeof(float));
+			result = true;
+		} else {
+			std::fill_n(out, n, 0.0f);
+		}
+		done = pos;
+	};
+	while (!registerWrites.empty()) {
+		const auto& w = registerWrites.front();
+		// The write becomes audible in the first sample after 'w.time'.
+		// Writes before the start of this block (the resampler may
+		// already have generated samples ahead) are applied right away.
+		unsigned pos = (w.time <= inputClock.getTime())
+		             ? 0 : inputClock.getTicksTill(w.time);
+		if (pos >= num) break;
+		generateTill(pos);
+		auto [time, reg, value] = registerWrites.pop_front();
+		applyRegisterWrite(reg, value, time);
+	}
+	generateTill(num);
+	inputClock += num;
+	return result;
+}
+
+void ResampledSoundDevice::queueRegisterWrite(unsigned reg, uint8_t value, EmuTime::param time)
+{
+	assert(registerWrites.empty() || (registerWrites.back().time <= time));
+	if (registerWrites.size() >= MAX_QUEUED_WRITES) {
+		// Normally the queue is emptied (at least) once per generated
+		// block. Don't let it grow unbounded when that's not the case.
+		syncRegisterWrites(time);
+	}
+	registerWrites.push_back(RegisterWrite{time, reg, value});
+}
+
+void ResampledSoundDevice::syncRegisterWrites(EmuTime::param time)
+{
+	if (registerWrites.empty()) return;
+	updateStream(time);
+	// Writes after the last generated sample are still queued.
+	applyRegisterWrites();
+}
+
+void ResampledSoundDevice::applyRegisterWrites()
+{
+	while (!registerWrites.empty()) {
+		auto [time, reg, value] = registerWrites.pop_front();
+		applyRegisterWrite(reg, value, time);
+	}
+}
+
+std::optional<uint8_t> ResampledSoundDevice::getQueuedValue(unsigned reg) const
+{
+	auto it = std::find_if(registerWrites.rbegin(), registerWrites.rend(),
+	                       [&](const auto& w) { return w.reg == reg; });
+	if (it == registerWrites.rend()) return {};
+	return it->value;
+}
+
+void ResampledSoundDevice::applyRegisterWrite(
+	unsigned /*reg*/, uint8_t /*value*/, EmuTime::param /*time*/)
+{
+	UNREACHABLE; // only called for devices that queue writes
+}
+
 
 void ResampledSoundDevice::update(const Setting& setting) noexcept
 {
@@ -62,6 +149,8 @@ void ResampledSoundDevice::createResampler()
 	EmuDuration inputPeriod(getEffectiveSpeed() / double(getInputRate()));
 	emuClock.reset(hostClock.getTime());
 	emuClock.setPeriod(inputPeriod);
+	inputClock.reset(hostClock.getTime());
+	inputClock.setPeriod(inputPeriod);
 
 	if (outputPeriod == inputPeriod) {
 		algo = std::make_unique<ResampleTrivial>(*this);
@@ -4,7 +4,11 @@
 #include "SoundDevice.hh"
 #include "DynamicClock.hh"
 #include "Observer.hh"
+#include "circular_buffer.hh"
+#include <cstdint>
 #include <memory>
+#include <optional>
+#include <vector>
 
 namespace openmsx {
 
@@ -42,11 +46,66 @@ protected:
 
 	void createResampler();
 
+	/** Instead of calling updateStream() before each register write, a
+	  * subclass can queue the write. It's then applied (via
+	  * applyRegisterWrite()) at the correct sample position while the
+	  * next block is generated. The write times must be non-decreasing.
+	  */
+	void queueRegisterWrite(unsigned reg, uint8_t value, EmuTime::param time);
+	/** Bring the chip up to date with all writes till 'time'. To be used
+	  * before the chip state is read back, and before a write that can't
+	  * be queued (e.g. because it has side effects outside the chip). */
+	void syncRegisterWrites(EmuTime::param time);
+	/** Immediately apply all queued writes. */
+	void applyRegisterWrites();
+	/** The value of the most recent queued write to 'reg', or nullopt. */
+	[[nodiscard]] std::optional<uint8_t> getQueuedValue(unsigned reg) const;
+	/** Called (possibly from within generateInput()) for each queued write.
+	  * Must be overridden by subclasses that use queueRegisterWrite(). */
+	virtual void applyRegisterWrite(unsigned reg, uint8_t value, EmuTime::param time);
+	/** Savestates contain the queued writes (applying them would change
+	  * the generated sound). To be called from the subclass' serialize(). */
+	template<typename Archive>
+	void serializeRegisterWrites(Archive& ar)
+	{
+		std::vector<RegisterWrite> writes;
+		if constexpr (!Archive::IS_LOADER) {
+			writes.assign(registerWrites.begin(), registerWrites.end());
+		}
+		ar.serialize("registerWrites", writes);
+		if constexpr (Archive::IS_LOADER) {
+			registerWrites.clear();
+			for (const auto& w : writes) registerWrites.push_back(w);
+		}
+	}
+
+private:
+	bool generateWithRegisterWrites(float* buffer, unsigned num);
+
 private:
 	EnumSetting<ResampleType>& resampleSetting;
 	std::unique_ptr<ResampleAlgo> algo;
 	DynamicClock emuClock; // time of the last produced emu-sample,
 	                       //    ticks once per emu-sample
+	// Like 'emuClock', but advanced in generateInput() (the resample
+	// algorithms ticks 'emuClock' either before or after generating).
+	DynamicClock inputClock;
+
+	struct RegisterWrite {
+		EmuTime time = EmuTime::zero();
+		unsigned reg = 0;
+		uint8_t value = 0;
+
+		template<typename Archive>
+		void serialize(Archive& ar, unsigned /*version*/)
+		{
+			ar.serialize("time",  time,
+			             "reg",   reg,
+			             "value", value);
+		}
+	};
+	static constexpr size_t MAX_QUEUED_WRITES = 1024;
+	cb_queue<RegisterWrite> registerWrites;
 };
 
 } // namespace openmsx
@@ -100,7 +100,6 @@
 #include "DeviceConfig.hh"
 #include "cstd.hh"
 #include "enumerate.hh"
-#include "likely.hh"
 #include "outer.hh"
 #include "ranges.hh"
 #include "serialize.hh"
@@ -469,16 +468,36 @@ void SCC::generateChannels(float** bufs, unsigned num)
 			unsigned pos2 = pos[i];
 			unsigned incr2 = incr[i];
 			unsigned period2 = period[i] + 1;
-			for (auto j : xrange(num)) {
-				bufs[i][j] += out2;
-				count2 += incr2;
-				// Note: only for very small periods
-				//       this will take more than 1 iteration
-				while (unlikely(count2 >= period2)) {
-					count2 -= period2;
-					pos2 = (pos2 + 1) % 32;
-					out2 = volAdjustedWave[i][pos2];
+			auto* buf = bufs[i];
+			// The output only changes when the position in the
+			// waveform changes. So instead of stepping sample per
+			// sample, directly calculate the length of each run of
+			// equal samples, and fill those in bulk (loops that
+			// the compiler can vectorize). Gives the exact same
+			// result as stepping per sample.
+			unsigned remaining = num;
+			while (remaining) {
+				// number of samples till the next waveform step
+				// (count2 < period2, so at least 1), or 0 if the
+				// channel doesn't advance
+				unsigned run = incr2
+				             ? (period2 - count2 + incr2 - 1) / incr2
+				             : 0;
+				if ((run == 0) || (run > remaining)) {
+					// no more steps in this block
+					for (auto j : xrange(remaining)) buf[j] += out2;
+					count2 += remaining * incr2;
+					break;
 				}
+				for (auto j : xrange(run)) buf[j] += out2;
+				buf += run;
+				remaining -= run;
+				count2 += run * incr2;
+				// Note: only for very small periods this
+				//       advances more than 1 step
+				pos2 = (pos2 + count2 / period2) % 32;
+				count2 %= period2;
+				out2 = volAdjustedWave[i][pos2];
 			}
 			out[i] = out2;
 			count[i] = count2;
@@ -37,8 +37,18 @@ SDLSoundDriver::SDLSoundDriver(Reactor& reactor_,
 	frequency = obtained.freq;
 	fragmentSize = obtained.samples;
 
-	mixBufferSize = 3 * (obtained.size / sizeof(float)) + 2;
+	// Room for 4 fragments, by default we aim to keep 3 fragments
+	// buffered and we go as low as 1.5 fragments.
+	unsigned fragmentFloats = obtained.size / sizeof(float);
+	mixBufferSize = 4 * fragmentFloats + 2;
 	mixBuffer.resize(mixBufferSize);
+	minTargetFill = 3 * fragmentFloats / 2;
+	maxTargetFill = mixBufferSize - 2;
+	targetFill = 3 * fragmentFloats;
+	underruns = 0;
+	seenUnderruns = 0;
+	stableUploads = 0;
+	latency = 0.0;
 	reInit();
 }
 
@@ -49,6 +59,8 @@ SDLSoundDriver::~SDLSoundDriver()
 
 void SDLSoundDriver::reInit()
 {
+	// Only called while the audio device is paused, so the callback isn't
+	// running. Still, take the lock to be safe.
 	SDL_LockAudioDevice(deviceID);
 	readIdx  = 0;
 	writeIdx = 0;
@@ -89,21 +101,21 @@ void SDLSoundDriver::audioCallbackHelper(void* userdata, uint8_t* strm, int len)
 		audioCallback(reinterpret_cast<float*>(strm), len / sizeof(float));
 }
 
-unsigned SDLSoundDriver::getBufferFilled() const
+unsigned SDLSoundDriver::getBufferFilled(unsigned rdIdx, unsigned wrIdx) const
 {
-	int result = writeIdx - readIdx;
+	int result = wrIdx - rdIdx;
 	if (result < 0) result += mixBufferSize;
 	assert((0 <= result) && (unsigned(result) < mixBufferSize));
 	return result;
 }
 
-unsigned SDLSoundDriver::getBufferFree() const
+unsigned SDLSoundDriver::getBufferFree(unsigned rdIdx, unsigned wrIdx) const
 {
 	// we can't distinguish completely filled from completely empty
 	// (in both cases readIx would be equal to writeIdx), so instead
 	// we define full as '(writeIdx + 2) == readIdx' (note that index
 	// increases in steps of 2 (stereo)).
-	int result = mixBufferSize - 2 - getBufferFilled();
+	int result = mixBufferSize - 2 - getBufferFilled(rdIdx, wrIdx);
 	assert((0 <= result) && (unsigned(result) < mixBufferSize));
 	return result;
 }
@@ -111,59 +123,97 @@ unsigned SDLSoundDriver::getBufferFree() const
 void SDLSoundDriver::audioCallback(float* stream, unsigned len)
 {
 	assert((len & 1) == 0); // stereo
-	unsigned available = getBufferFilled();
+	unsigned rdIdx = readIdx.load(std::memory_order_relaxed);
+	unsigned wrIdx = writeIdx.load(std::memory_order_acquire);
+	unsigned available = getBufferFilled(rdIdx, wrIdx);
 	unsigned num = std::min(len, available);
-	if ((readIdx + num) < mixBufferSize) {
-		memcpy(stream, &mixBuffer[readIdx], num * sizeof(float));
-		readIdx += num;
+	if ((rdIdx + num) < mixBufferSize) {
+		memcpy(stream, &mixBuffer[rdIdx], num * sizeof(float));
+		rdIdx += num;
 	} else {
-		unsigned len1 = mixBufferSize - readIdx;
-		memcpy(stream, &mixBuffer[readIdx], len1 * sizeof(float));
+		unsigned len1 = mixBufferSize - rdIdx;
+		memcpy(stream, &mixBuffer[rdIdx], len1 * sizeof(float));
 		unsigned len2 = num - len1;
 		memcpy(&stream[len1], &mixBuffer[0], len2 * sizeof(float));
-		readIdx = len2;
+		rdIdx = len2;
 	}
+	readIdx.store(rdIdx, std::memory_order_release);
 	int missing = len - available;
 	if (missing > 0) {
 		// buffer underrun
 		memset(&stream[available], 0, missing * sizeof(float));
+		underruns.fetch_add(1, std::memory_order_relaxed);
+	}
+}
+
+void SDLSoundDriver::adjustTargetFill()
+{
+	unsigned fragmentFloats = 2 * fragmentSize;
+	unsigned newUnderruns = underruns.load(std::memory_order_relaxed);
+	if (newUnderruns != seenUnderruns) {
+		// We were too aggressive, quickly back off.
+		seenUnderruns = newUnderruns;
+		stableUploads = 0;
+		targetFill = std::min(targetFill + fragmentFloats / 2, maxTargetFill);
+	} else if (++stableUploads >= (4 * frequency / fragmentSize)) {
+		// No underruns for about 4 seconds, try a lower latency.
+		stableUploads = 0;
+		targetFill = std::max(targetFill - fragmentFloats / 8, minTargetFill);
 	}
 }
 
 void SDLSoundDriver::uploadBuffer(float* buffer, unsigned len)
 {
-	SDL_LockAudioDevice(deviceID);
 	len *= 2; // stereo
-	unsigned free = getBufferFree();
-	if (len > free) {
+	adjustTargetFill();
+
+	unsigned wrIdx = writeIdx.load(std::memory_order_relaxed);
+	auto getFree = [&] {
+		return getBufferFree(readIdx.load(std::memory_order_acquire), wrIdx);
+	};
+	// When throttled, wait till there's room below the target fill level
+	// (but always allow at least one upload in an otherwise empty buffer).
+	unsigned limit = std::max(targetFill, len);
+	unsigned free = getFree();
+	if (len > free || (mixBufferSize - 2 - free + len) > limit) {
 		auto* board = reactor.getMotherBoard();
 		if (board && !board->getMSXMixer().isSynchronousMode() && // when not recording
 		    reactor.getGlobalSettings().getThrottleManager().isThrottled()) {
 			do {
-				SDL_UnlockAudioDevice(deviceID);
-				Timer::sleep(5000); // 5ms
-				SDL_LockAudioDevice(deviceID);
+				Timer::sleep(1000); // 1ms
 				board->getRealTime().resync();
-				free = getBufferFree();
-			} while (len > free);
+				free = getFree();
+			} while ((mixBufferSize - 2 - free + len) > limit);
 		} else {
 			// drop excess samples
-			len = free;
+			len = std::min(len, free);
 		}
 	}
 	assert(len <= free);
-	if ((writeIdx + len) < mixBufferSize) {
-		memcpy(&mixBuffer[writeIdx], buffer, len * sizeof(float));
-		writeIdx += len;
+	if ((wrIdx + len) < mixBufferSize) {
+		memcpy(&mixBuffer[wrIdx], buffer, len * sizeof(float));
+		wrIdx += len;
 	} else {
-		unsigned len1 = mixBufferSize - writeIdx;
-		memcpy(&mixBuffer[writeIdx], buffer, len1 * sizeof(float));
+		unsigned len1 = mixBufferSize - wrIdx;
+		memcpy(&mixBuffer[wrIdx], buffer, len1 * sizeof(float));
 		unsigned len2 = len - len1;
 		memcpy(&mixBuffer[0], &buffer[len1], len2 * sizeof(float));
-		writeIdx = len2;
+		wrIdx = len2;
 	}
+	writeIdx.store(wrIdx, std::memory_order_release);
 
-	SDL_UnlockAudioDevice(deviceID);
+	// A sample that's uploaded now is played after all buffered samples,
+	// plus the fragment that SDL is currently playing.
+	unsigned filled = mixBufferSize - 2 - getFree();
+	double current = double(filled / 2 + fragmentSize) / frequency;
+	latency = (latency == 0.0) ? current : (0.95 * latency + 0.05 * current);
+}
+
+SoundDriver::Latency SDLSoundDriver::getLatency() const
+{
+	return {muted ? 0.0 : latency,
+	        double(targetFill / 2 + fragmentSize) / frequency,
+	        underruns.load(std::memory_order_relaxed)};
 }
 
 } // namespace openmsx
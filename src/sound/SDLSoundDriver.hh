@@ -5,6 +5,7 @@
 #include "SDLSurfacePtr.hh"
 #include "MemBuffer.hh"
 #include <SDL.h>
+#include <atomic>
 
 namespace openmsx {
 
@@ -26,11 +27,13 @@ public:
 	[[nodiscard]] unsigned getSamples() const override;
 
 	void uploadBuffer(float* buffer, unsigned len) override;
+	[[nodiscard]] Latency getLatency() const override;
 
 private:
 	void reInit();
-	[[nodiscard]] unsigned getBufferFilled() const;
-	[[nodiscard]] unsigned getBufferFree() const;
+	void adjustTargetFill();
+	[[nodiscard]] unsigned getBufferFilled(unsigned rdIdx, unsigned wrIdx) const;
+	[[nodiscard]] unsigned getBufferFree(unsigned rdIdx, unsigned wrIdx) const;
 	static void audioCallbackHelper(void* userdata, uint8_t* strm, int len);
 	void audioCallback(float* stream, unsigned len);
 
@@ -41,7 +44,24 @@ private:
 	unsigned mixBufferSize;
 	unsigned frequency;
 	unsigned fragmentSize;
-	unsigned readIdx, writeIdx;
+
+	// The buffer is a single-producer (uploadBuffer(), main thread),
+	// single-consumer (audioCallback(), SDL audio thread) ring buffer.
+	// 'readIdx' is only written by the consumer, 'writeIdx' only by the
+	// producer, so no lock is needed.
+	std::atomic<unsigned> readIdx, writeIdx;
+	std::atomic<unsigned> underruns; // incremented by audioCallback()
+
+	// Only used by the producer:
+	// When throttled, uploadBuffer() waits till the fill level drops below
+	// this target (in floats). It's lowered as long as there are no
+	// buffer underruns and raised again on an underrun.
+	unsigned targetFill;
+	unsigned minTargetFill, maxTargetFill;
+	unsigned seenUnderruns;
+	unsigned stableUploads;
+	double latency; // smoothed, in seconds
+
 	bool muted;
 	SDLSubSystemInitializer<SDL_INIT_AUDIO> audioInitializer;
 };
@@ -5,6 +5,7 @@
 #include "MSXException.hh"
 #include "serialize.hh"
 #include "xrange.hh"
+#include <algorithm>
 #include <cassert>
 
 namespace openmsx {
@@ -106,21 +107,30 @@ void SamplePlayer::generateChannels(float** bufs, unsigned num)
 		return;
 	}
 
-	auto& wav = samples[currentSampleNum];
-	for (auto i : xrange(num)) {
+	auto* buf = bufs[0];
+	while (num) {
 		if (index >= bufferSize) {
 			if (nextSampleNum != unsigned(-1)) {
 				doRepeat();
 			} else {
 				currentSampleNum = unsigned(-1);
+			}
+			if (!isPlaying()) {
 				// fill remaining buffer with zeros
-				do {
-					bufs[0][i++] = 0.0f;
-				} while (i < num);
-				break;
+				std::fill_n(buf, num, 0.0f);
+				return;
 			}
 		}
-		bufs[0][i] = 3 * wav.getSample(index++);
+		// Copy (the rest of) the current sample in one go. Note: after
+		// doRepeat() this can be a different sample.
+		const auto& wav = samples[currentSampleNum];
+		unsigned n = std::min(num, bufferSize - index);
+		for (auto i : xrange(n)) {
+			buf[i] = 3 * wav.getSample(index + i);
+		}
+		index += n;
+		buf += n;
+		num -= n;
 	}
 }
 
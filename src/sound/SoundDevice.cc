@@ -18,8 +18,9 @@
 
 namespace openmsx {
 
-static MemBuffer<float, SSE_ALIGNMENT> mixBuffer;
-static unsigned mixBufferSize = 0;
+// thread_local: MSXMixer can generate several devices in parallel
+static thread_local MemBuffer<float, SSE_ALIGNMENT> mixBuffer;
+static thread_local unsigned mixBufferSize = 0;
 
 static void allocateMixBuffer(unsigned size)
 {
@@ -193,6 +194,12 @@ bool SoundDevice::mixChannels(float* dataOut, unsigned samples)
 	assert((uintptr_t(dataOut) & 15) == 0); // must be 16-byte aligned
 #endif
 	if (samples == 0) return true;
+	if (isIdle()) {
+		for (auto& w : writer) {
+			if (w) w->writeSilence(stereo, samples);
+		}
+		return false;
+	}
 	unsigned outputStereo = isStereo() ? 2 : 1;
 
 	static_assert(sizeof(float) == sizeof(uint32_t));
@@ -173,6 +173,17 @@ protected:
 	  */
 	virtual void generateChannels(float** buffers, unsigned num) = 0;
 
+	/** Is this device known to be silent right now?
+	  * When this returns true, mixChannels() doesn't prepare any buffers
+	  * and doesn't call generateChannels() at all. So only return true
+	  * when generateChannels() would set all buffer pointers to nullptr
+	  * without changing the internal state (e.g. on FM chips when all
+	  * envelopes have finished). Checking this should be cheap, it's
+	  * called for each generated block of samples.
+	  * The default implementation returns false.
+	  */
+	[[nodiscard]] virtual bool isIdle() const { return false; }
+
 	/** Calls generateChannels() and combines the output to a single
 	  * channel.
 	  * @param dataOut Output buffer, must be big enough to hold
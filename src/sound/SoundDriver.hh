@@ -28,6 +28,16 @@ public:
 
 	virtual void uploadBuffer(float* buffer, unsigned len) = 0;
 
+	struct Latency {
+		double current;     // smoothed, in seconds
+		double target;      // in seconds
+		unsigned underruns; // since the driver was (re)created
+	};
+	/** Returns the (estimated) delay between uploading a sample and
+	  * the moment it's played by the host, plus some related info.
+	  */
+	[[nodiscard]] virtual Latency getLatency() const = 0;
+
 protected:
 	SoundDriver() = default;
 };
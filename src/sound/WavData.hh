@@ -37,6 +37,20 @@ public:
 		return (pos < length) ? buffer[pos] : 0;
 	}
 
+	/** The format of a .wav file, as needed to read the samples from the
+	  * 'data' chunk without loading them all (see WavImage). */
+	struct Format {
+		unsigned freq;
+		unsigned channels;
+		unsigned bits; // 8 or 16
+		size_t dataOffset; // offset of the sample data in the file
+		unsigned length; // number of samples (per channel)
+	};
+	/** Parse the header of a .wav file, only needs the part of the file
+	  * up to the start of the sample data.
+	  * @throws MSXException when the format is invalid or unsupported. */
+	[[nodiscard]] static Format parseHeader(span<const uint8_t> raw);
+
 private:
 	template<typename T>
 	[[nodiscard]] static const T* read(span<const uint8_t> raw, size_t offset, size_t count = 1);
@@ -58,11 +72,8 @@ inline const T* WavData::read(span<const uint8_t> raw, size_t offset, size_t cou
 	return reinterpret_cast<const T*>(raw.data() + offset);
 }
 
-template<typename Filter>
-inline WavData::WavData(File file, Filter filter)
+inline WavData::Format WavData::parseHeader(span<const uint8_t> raw)
 {
-	// Read and check header
-	auto raw = file.mmap();
 	struct WavHeader {
 		char riffID[4];
 		Endian::L32 riffSize;
@@ -82,12 +93,13 @@ inline WavData::WavData(File file, Filter filter)
 	    memcmp(header->fmtID, "fmt ", 4)) {
 		throw MSXException("Invalid WAV file.");
 	}
-	unsigned bits = header->wBitsPerSample;
-	if ((header->wFormatTag != 1) || (bits != one_of(8u, 16u))) {
+	Format result;
+	result.bits = header->wBitsPerSample;
+	if ((header->wFormatTag != 1) || (result.bits != one_of(8u, 16u))) {
 		throw MSXException("WAV format unsupported, must be 8 or 16 bit PCM.");
 	}
-	freq = header->dwSamplesPerSec;
-	unsigned channels = header->wChannels;
+	result.freq = header->dwSamplesPerSec;
+	result.channels = header->wChannels;
 
 	// Skip any extra format bytes
 	size_t pos = 20 + header->fmtSize;
@@ -106,9 +118,23 @@ inline WavData::WavData(File file, Filter filter)
 		// Skip non-data chunk
 		pos += dataHeader->chunkSize;
 	}
+	result.dataOffset = pos;
+	result.length = dataHeader->chunkSize / ((result.bits / 8) * result.channels);
+	return result;
+}
+
+template<typename Filter>
+inline WavData::WavData(File file, Filter filter)
+{
+	// Read and check header
+	auto raw = file.mmap();
+	auto format = parseHeader(raw);
+	freq = format.freq;
+	unsigned channels = format.channels;
+	size_t pos = format.dataOffset;
 
 	// Read and convert sample data
-	length = dataHeader->chunkSize / ((bits / 8) * channels);
+	length = format.length;
 	buffer.resize(length);
 	filter.setFreq(freq);
 	auto convertLoop = [&](const auto* in, auto convertFunc) {
@@ -117,7 +143,7 @@ inline WavData::WavData(File file, Filter filter)
 			in += channels; // discard all but the first channel
 		}
 	};
-	if (bits == 8) {
+	if (format.bits == 8) {
 		convertLoop(read<uint8_t>(raw, pos, length * channels),
 		            [](uint8_t u8) { return (int16_t(u8) - 0x80) << 8; });
 	} else {
@@ -777,7 +777,7 @@ void Y8950::setEnabled(bool enabled_, EmuTime::param time)
 	enabled = enabled_;
 }
 
-bool Y8950::checkMuteHelper()
+bool Y8950::checkMuteHelper() const
 {
 	if (!enabled) {
 		return true;
@@ -811,6 +811,19 @@ void Y8950::generateChannels(float** bufs, unsigned num)
 		return;
 	}
 
+	// Channels that are inactive now, stay inactive for the whole block
+	// (only a key-on can change that). Nothing is added to their buffers,
+	// so instead of mixing those zeros, mark them as muted (see below).
+	bool active[9 + 5];
+	for (auto i : xrange(9)) {
+		active[i] = !(rythm_mode && (i >= 6)) && ch[i].slot[CAR].isActive();
+	}
+	active[ 9] = rythm_mode && ch[6].slot[CAR].isActive();
+	active[10] = rythm_mode && ch[7].slot[CAR].isActive();
+	active[11] = rythm_mode && ch[8].slot[CAR].isActive();
+	active[12] = rythm_mode && ch[7].slot[MOD].isActive();
+	active[13] = rythm_mode && ch[8].slot[MOD].isActive();
+
 	for (auto sample : xrange(num)) {
 		// Amplitude modulation: 27 output levels (triangle waveform);
 		// 1 level takes one of: 192, 256 or 448 samples
@@ -887,6 +900,10 @@ void Y8950::generateChannels(float** bufs, unsigned num)
 
 		bufs[14][sample] += adpcm.calcSample();
 	}
+
+	for (auto i : xrange(9 + 5)) {
+		if (!active[i]) bufs[i] = nullptr;
+	}
 }
 
 //
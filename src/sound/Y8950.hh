@@ -76,6 +76,7 @@ private:
 	// SoundDevice
 	[[nodiscard]] float getAmplificationFactorImpl() const override;
 	void generateChannels(float** bufs, unsigned num) override;
+	[[nodiscard]] bool isIdle() const override { return checkMuteHelper(); }
 
 	inline void keyOn_BD();
 	inline void keyOn_SD();
@@ -90,7 +91,7 @@ private:
 	inline void setRythmMode(int data);
 	void update_key_status();
 
-	[[nodiscard]] bool checkMuteHelper();
+	[[nodiscard]] bool checkMuteHelper() const;
 
 	void changeStatusMask(byte newMask);
 
@@ -107,8 +107,22 @@ void Y8950Adpcm::sync(EmuTime::param time)
 {
 	if (isPlaying()) { // optimization, also correct without this test
 		unsigned ticks = clock.getTicksTill(time);
-		for (unsigned i = 0; isPlaying() && (i < ticks); ++i) {
-			(void)calcSample(true); // ignore result
+		while (isPlaying() && ticks) {
+			// In between two nibbles calcSample() only interpolates
+			// the output, do all those steps at once. The ADPCM
+			// decoding (and its side effects) only happens when
+			// reaching the next nibble.
+			unsigned skip = (emu.nowStep > unsigned(STEP_MASK)) ? 0
+			              : (delta == 0) ? ticks
+			              : std::min<unsigned>(ticks,
+			                  (STEP_MASK - emu.nowStep) / delta);
+			emu.nowStep += skip * delta;
+			emu.output += int(skip) * emu.sampleStep;
+			ticks -= skip;
+			if (ticks) {
+				(void)calcSample(true); // ignore result
+				--ticks;
+			}
 		}
 	}
 	clock.advance(time);
@@ -912,7 +912,19 @@ YM2151::~YM2151()
 	unregisterSound();
 }
 
-bool YM2151::checkMuteHelper()
+// All operators of the channel are off (so attenuated to below ENV_QUIET)
+// and there's no feedback or delayed (MEM) sample left. Then chanCalc() (or
+// chan7Calc()) would output 0 and not change any state, so it can be skipped.
+bool YM2151::isChannelIdle(unsigned chan) const
+{
+	const YM2151Operator* op = &oper[chan * 4]; // M1
+	return (op[0].state == EG_OFF) && (op[1].state == EG_OFF) &&
+	       (op[2].state == EG_OFF) && (op[3].state == EG_OFF) &&
+	       (op->fb_out_prev == 0) && (op->fb_out_curr == 0) &&
+	       (op->mem_value == 0);
+}
+
+bool YM2151::checkMuteHelper() const
 {
 	return ranges::all_of(oper, [](auto& op) { return op.state == EG_OFF; });
 }
@@ -1513,10 +1525,10 @@ void YM2151::generateChannels(float** bufs, unsigned num)
 
 		for (auto j : xrange(8 - 1)) {
 			chanout[j] = 0;
-			chanCalc(j);
+			if (!isChannelIdle(j)) chanCalc(j);
 		}
 		chanout[7] = 0;
-		chan7Calc(); // special case for channel 7
+		if (!isChannelIdle(7)) chan7Calc(); // special case for channel 7
 
 		for (auto j : xrange(8)) {
 			bufs[j][2 * i + 0] += int(chanout[j] & pan[2 * j + 0]);
@@ -119,6 +119,7 @@ private:
 
 	// SoundDevice
 	void generateChannels(float** bufs, unsigned num) override;
+	[[nodiscard]] bool isIdle() const override { return checkMuteHelper(); }
 
 	void callback(byte flag) override;
 	void setStatus(byte flags);
@@ -136,11 +137,12 @@ private:
 	// general chip mehods
 	void chanCalc(unsigned chan);
 	void chan7Calc();
+	[[nodiscard]] bool isChannelIdle(unsigned chan) const;
 
 	void advanceEG();
 	void advance();
 
-	[[nodiscard]] bool checkMuteHelper();
+	[[nodiscard]] bool checkMuteHelper() const;
 
 	IRQHelper irq;
 
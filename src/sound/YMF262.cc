@@ -481,12 +481,6 @@ static constexpr SinTab getSinTab()
 constexpr SinTab sin = getSinTab();
 
 
-// TODO clean this up
-static int phase_modulation;  // phase modulation input (SLOT 2)
-static int phase_modulation2; // phase modulation input (SLOT 3
-                              // in 4 operator channels)
-
-
 YMF262::Slot::Slot()
 	: Cnt(0), Incr(0)
 {
@@ -673,9 +667,22 @@ inline int YMF262::Slot::op_calc(unsigned phase, unsigned lfo_am) const
 	return (p < TL_TAB_LEN) ? tlTab[p] : 0;
 }
 
+// Is op_calc() guaranteed to return zero, and does it stay like that until
+// the next key-on? (The envelope generator doesn't leave the EG_OFF state by
+// itself, and 'TLL' only changes via register writes.)
+inline bool YMF262::Slot::isSilent() const
+{
+	return (state == EG_OFF) && ((TLL + volume) >= ENV_QUIET);
+}
+inline bool YMF262::Channel::isSilent() const
+{
+	return slot[MOD].isSilent() && slot[CAR].isSilent();
+}
+
 // calculate output of a standard 2 operator channel
 // (or 1st part of a 4-op channel)
-void YMF262::Channel::chan_calc(unsigned lfo_am)
+void YMF262::Channel::chan_calc(
+	unsigned lfo_am, int& phase_modulation, int& phase_modulation2)
 {
 	// !! something is wrong with this, it caused bug
 	// !!    [2823673] moonsound 4 operator FM fail
@@ -713,8 +720,21 @@ void YMF262::Channel::chan_calc(unsigned lfo_am)
 	*car.connect += car.op_calc(car.Cnt.toInt() + phase_modulation, lfo_am);
 }
 
+// Same effect as chan_calc() for a channel for which isSilent() is true.
+inline void YMF262::Channel::chan_skip(int& phase_modulation, int& phase_modulation2)
+{
+	phase_modulation = 0;
+	phase_modulation2 = 0;
+
+	auto& mod = slot[MOD];
+	mod.op1_out[0] = mod.op1_out[1];
+	mod.op1_out[1] = 0;
+	// both slots output zero, no need to add anything to 'connect'
+}
+
 // calculate output of a 2nd part of 4-op channel
-void YMF262::Channel::chan_calc_ext(unsigned lfo_am)
+void YMF262::Channel::chan_calc_ext(
+	unsigned lfo_am, int& phase_modulation, int& phase_modulation2)
 {
 	// !! see remark in chan_cal(), something is wrong with this
 	// !! optimization disabled for now
@@ -1471,6 +1491,7 @@ YMF262::YMF262(const std::string& name_,
 
 	// avoid (harmless) UMR in serialize()
 	memset(chanout, 0, sizeof(chanout));
+	phase_modulation = phase_modulation2 = 0;
 	memset(reg, 0, sizeof(reg));
 
 	// For debugging: print out tables to be able to compare before/after
@@ -1503,7 +1524,7 @@ byte YMF262::peekStatus() const
 	return status | status2;
 }
 
-bool YMF262::checkMuteHelper()
+bool YMF262::checkMuteHelper() const
 {
 	// TODO this doesn't always mute when possible
 	for (auto& ch : channel) {
@@ -1552,6 +1573,30 @@ void YMF262::generateChannels(float** bufs, unsigned num)
 
 	bool rhythmEnabled = (rhythm & 0x20) != 0;
 
+	// Channels that are silent now stay silent for the whole block (only a
+	// register write can change that). Often only a few of the 18 channels
+	// are in use, so skip calculating the others and don't mix them. The
+	// rhythm channels are always calculated.
+	unsigned silent = 0;
+	for (auto i : xrange(18)) {
+		if (channel[i].isSilent()) silent |= 1 << i;
+	}
+	if (rhythmEnabled) silent &= ~(7u << 6);
+	auto calc = [&](unsigned i, unsigned lfo_am) {
+		if (silent & (1 << i)) {
+			channel[i].chan_skip(phase_modulation, phase_modulation2);
+		} else {
+			channel[i].chan_calc(lfo_am, phase_modulation, phase_modulation2);
+		}
+	};
+	auto calcExt = [&](unsigned i, unsigned lfo_am) {
+		// when silent its output is zero, and 'phase_modulation' is
+		// reset by the next chan_calc() or chan_skip()
+		if (!(silent & (1 << i))) {
+			channel[i].chan_calc_ext(lfo_am, phase_modulation, phase_modulation2);
+		}
+	};
+
 	for (auto j : xrange(num)) {
 		// Amplitude modulation: 27 output levels (triangle waveform);
 		// 1 level takes one of: 192, 256 or 448 samples
@@ -1569,38 +1614,37 @@ void YMF262::generateChannels(float** bufs, unsigned num)
 
 		// channels 0,3 1,4 2,5  9,12 10,13 11,14
 		// in either 2op or 4op mode
-		for (int k = 0; k <= 9; k += 9) {
+		for (unsigned k = 0; k <= 9; k += 9) {
 			for (auto i : xrange(3)) {
-				auto& ch0 = channel[k + i + 0];
-				auto& ch3 = channel[k + i + 3];
 				// extended 4op ch#0 part 1 or 2op ch#0
-				ch0.chan_calc(lfo_am);
-				if (ch0.extended) {
+				calc(k + i + 0, lfo_am);
+				if (channel[k + i + 0].extended) {
 					// extended 4op ch#0 part 2
-					ch3.chan_calc_ext(lfo_am);
+					calcExt(k + i + 3, lfo_am);
 				} else {
 					// standard 2op ch#3
-					ch3.chan_calc(lfo_am);
+					calc(k + i + 3, lfo_am);
 				}
 			}
 		}
 
 		// channels 6,7,8 rhythm or 2op mode
 		if (!rhythmEnabled) {
-			channel[6].chan_calc(lfo_am);
-			channel[7].chan_calc(lfo_am);
-			channel[8].chan_calc(lfo_am);
+			calc(6, lfo_am);
+			calc(7, lfo_am);
+			calc(8, lfo_am);
 		} else {
 			// Rhythm part
 			chan_calc_rhythm(lfo_am);
 		}
 
 		// channels 15,16,17 are fixed 2-operator channels only
-		channel[15].chan_calc(lfo_am);
-		channel[16].chan_calc(lfo_am);
-		channel[17].chan_calc(lfo_am);
+		calc(15, lfo_am);
+		calc(16, lfo_am);
+		calc(17, lfo_am);
 
 		for (auto i : xrange(18)) {
+			if (silent & (1 << i)) continue;
 			bufs[i][2 * j + 0] += int(chanout[i] & pan[4 * i + 0]);
 			bufs[i][2 * j + 1] += int(chanout[i] & pan[4 * i + 1]);
 			// unused c        += int(chanout[i] & pan[4 * i + 2]);
@@ -1609,6 +1653,10 @@ void YMF262::generateChannels(float** bufs, unsigned num)
 
 		advance();
 	}
+
+	for (auto i : xrange(18)) {
+		if (silent & (1 << i)) bufs[i] = nullptr;
+	}
 }
 
 
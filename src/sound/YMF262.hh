@@ -58,6 +58,7 @@ private:
 		void update_ar_dr();
 		void update_rr();
 		void calc_fc(const Channel& ch);
+		[[nodiscard]] inline bool isSilent() const;
 
 		/** Sets the amount of feedback [0..7]
 		 */
@@ -115,8 +116,12 @@ private:
 	class Channel {
 	public:
 		Channel();
-		void chan_calc(unsigned lfo_am);
-		void chan_calc_ext(unsigned lfo_am);
+		void chan_calc(unsigned lfo_am, int& phase_modulation,
+		               int& phase_modulation2);
+		void chan_calc_ext(unsigned lfo_am, int& phase_modulation,
+		                   int& phase_modulation2);
+		inline void chan_skip(int& phase_modulation, int& phase_modulation2);
+		[[nodiscard]] inline bool isSilent() const;
 
 		template<typename Archive>
 		void serialize(Archive& ar, unsigned version);
@@ -144,6 +149,7 @@ private:
 	// SoundDevice
 	[[nodiscard]] float getAmplificationFactorImpl() const override;
 	void generateChannels(float** bufs, unsigned num) override;
+	[[nodiscard]] bool isIdle() const override { return checkMuteHelper(); }
 
 	void callback(byte flag) override;
 
@@ -163,7 +169,7 @@ private:
 	void set_ksl_tl(unsigned sl, byte v);
 	void set_ar_dr(unsigned sl, byte v);
 	void set_sl_rr(unsigned sl, byte v);
-	bool checkMuteHelper();
+	[[nodiscard]] bool checkMuteHelper() const;
 
 	[[nodiscard]] inline bool isExtended(unsigned ch) const;
 	[[nodiscard]] inline Channel& getFirstOfPair(unsigned ch);
@@ -192,6 +198,9 @@ private:
 	IRQHelper irq;
 
 	int chanout[18]; // 18 channels
+	int phase_modulation;  // phase modulation input (SLOT 2)
+	int phase_modulation2; // phase modulation input (SLOT 3
+	                       // in 4 operator channels)
 
 	byte reg[512];
 	Channel channel[18];	// OPL3 chips have 18 channels
@@ -322,99 +322,97 @@ uint16_t YMF278::Slot::compute_am() const
 }
 
 
-void YMF278::advance()
+// Advance this slot by one sample, 'eg_cnt' is the (already incremented)
+// value of the global envelope generator counter for that sample.
+void YMF278::Slot::advance(unsigned eg_cnt)
 {
-	eg_cnt++;
-
 	// modulo counters for volume interpolation
 	int tl_int_cnt  =  eg_cnt % 9;      // 0 .. 8
 	int tl_int_step = (eg_cnt / 9) % 3; // 0 .. 2
 
-	for (auto& op : slots) {
-		// volume interpolation
-		if (tl_int_cnt == 0) {
-			if (tl_int_step == 0) {
-				// decrease volume by one step every 27 samples
-				if (op.TL < op.TLdest) ++op.TL;
-			} else {
-				// increase volume by one step every 13.5 samples
-				if (op.TL > op.TLdest) --op.TL;
-			}
+	// volume interpolation
+	if (tl_int_cnt == 0) {
+		if (tl_int_step == 0) {
+			// decrease volume by one step every 27 samples
+			if (TL < TLdest) ++TL;
+		} else {
+			// increase volume by one step every 13.5 samples
+			if (TL > TLdest) --TL;
 		}
+	}
 
-		if (op.lfo_active) {
-			op.lfo_cnt = (op.lfo_cnt + lfo_period[op.lfo]) & (LFO_PERIOD - 1);
-		}
+	if (lfo_active) {
+		lfo_cnt = (lfo_cnt + lfo_period[lfo]) & (LFO_PERIOD - 1);
+	}
 
-		// Envelope Generator
-		switch (op.state) {
-		case EG_ATT: { // attack phase
-			uint8_t rate = op.compute_rate(op.AR);
-			// Verified by HW recording (and matches Nemesis' tests of the YM2612):
-			// AR = 0xF during KeyOn results in instant switch to EG_DEC. (see keyOnHelper)
-			// Setting AR = 0xF while the attack phase is in progress freezes the envelope.
-			if (rate >= 63) {
-				break;
-			}
-			uint8_t shift = eg_rate_shift[rate];
-			if (!(eg_cnt & ((1 << shift) - 1))) {
-				uint8_t select = eg_rate_select[rate];
-				// >>4 makes the attack phase's shape match the actual chip -Valley Bell
-				op.env_vol += (~op.env_vol * eg_inc[select + ((eg_cnt >> shift) & 7)]) >> 4;
-				if (op.env_vol <= MIN_ATT_INDEX) {
-					op.env_vol = MIN_ATT_INDEX;
-					// TODO does the real HW skip EG_DEC completely,
-					//      or is it active for 1 sample?
-					op.state = op.DL ? EG_DEC : EG_SUS;
-				}
-			}
+	// Envelope Generator
+	switch (state) {
+	case EG_ATT: { // attack phase
+		uint8_t rate = compute_rate(AR);
+		// Verified by HW recording (and matches Nemesis' tests of the YM2612):
+		// AR = 0xF during KeyOn results in instant switch to EG_DEC. (see keyOnHelper)
+		// Setting AR = 0xF while the attack phase is in progress freezes the envelope.
+		if (rate >= 63) {
 			break;
 		}
-		case EG_DEC: { // decay phase
-			uint8_t rate = op.compute_decay_rate(op.D1R);
-			uint8_t shift = eg_rate_shift[rate];
-			if (!(eg_cnt & ((1 << shift) - 1))) {
-				uint8_t select = eg_rate_select[rate];
-				op.env_vol += eg_inc[select + ((eg_cnt >> shift) & 7)];
-				if (op.env_vol >= op.DL) {
-					op.state = (op.env_vol < MAX_ATT_INDEX) ? EG_SUS : EG_OFF;
-				}
+		uint8_t shift = eg_rate_shift[rate];
+		if (!(eg_cnt & ((1 << shift) - 1))) {
+			uint8_t select = eg_rate_select[rate];
+			// >>4 makes the attack phase's shape match the actual chip -Valley Bell
+			env_vol += (~env_vol * eg_inc[select + ((eg_cnt >> shift) & 7)]) >> 4;
+			if (env_vol <= MIN_ATT_INDEX) {
+				env_vol = MIN_ATT_INDEX;
+				// TODO does the real HW skip EG_DEC completely,
+				//      or is it active for 1 sample?
+				state = DL ? EG_DEC : EG_SUS;
 			}
-			break;
 		}
-		case EG_SUS: { // sustain phase
-			uint8_t rate = op.compute_decay_rate(op.D2R);
-			uint8_t shift = eg_rate_shift[rate];
-			if (!(eg_cnt & ((1 << shift) - 1))) {
-				uint8_t select = eg_rate_select[rate];
-				op.env_vol += eg_inc[select + ((eg_cnt >> shift) & 7)];
-				if (op.env_vol >= MAX_ATT_INDEX) {
-					op.env_vol = MAX_ATT_INDEX;
-					op.state = EG_OFF;
-				}
+		break;
+	}
+	case EG_DEC: { // decay phase
+		uint8_t rate = compute_decay_rate(D1R);
+		uint8_t shift = eg_rate_shift[rate];
+		if (!(eg_cnt & ((1 << shift) - 1))) {
+			uint8_t select = eg_rate_select[rate];
+			env_vol += eg_inc[select + ((eg_cnt >> shift) & 7)];
+			if (env_vol >= DL) {
+				state = (env_vol < MAX_ATT_INDEX) ? EG_SUS : EG_OFF;
 			}
-			break;
 		}
-		case EG_REL: { // release phase
-			uint8_t rate = op.compute_decay_rate(op.RR);
-			uint8_t shift = eg_rate_shift[rate];
-			if (!(eg_cnt & ((1 << shift) - 1))) {
-				uint8_t select = eg_rate_select[rate];
-				op.env_vol += eg_inc[select + ((eg_cnt >> shift) & 7)];
-				if (op.env_vol >= MAX_ATT_INDEX) {
-					op.env_vol = MAX_ATT_INDEX;
-					op.state = EG_OFF;
-				}
+		break;
+	}
+	case EG_SUS: { // sustain phase
+		uint8_t rate = compute_decay_rate(D2R);
+		uint8_t shift = eg_rate_shift[rate];
+		if (!(eg_cnt & ((1 << shift) - 1))) {
+			uint8_t select = eg_rate_select[rate];
+			env_vol += eg_inc[select + ((eg_cnt >> shift) & 7)];
+			if (env_vol >= MAX_ATT_INDEX) {
+				env_vol = MAX_ATT_INDEX;
+				state = EG_OFF;
 			}
-			break;
 		}
-		case EG_OFF:
-			// nothing
-			break;
-
-		default:
-			UNREACHABLE;
+		break;
+	}
+	case EG_REL: { // release phase
+		uint8_t rate = compute_decay_rate(RR);
+		uint8_t shift = eg_rate_shift[rate];
+		if (!(eg_cnt & ((1 << shift) - 1))) {
+			uint8_t select = eg_rate_select[rate];
+			env_vol += eg_inc[select + ((eg_cnt >> shift) & 7)];
+			if (env_vol >= MAX_ATT_INDEX) {
+				env_vol = MAX_ATT_INDEX;
+				state = EG_OFF;
+			}
 		}
+		break;
+	}
+	case EG_OFF:
+		// nothing
+		break;
+
+	default:
+		UNREACHABLE;
 	}
 }
 
@@ -492,12 +490,43 @@ void YMF278::generateChannels(float** bufs, unsigned num)
 		return;
 	}
 
-	for (auto j : xrange(num)) {
-		for (auto i : xrange(24)) {
-			auto& sl = slots[i];
+	// The slots only share the (global) envelope generator counter, so
+	// instead of advancing all slots one sample at a time, we can generate
+	// one slot at a time for the whole block. This keeps the state of a
+	// single slot in registers and results in exactly the same output.
+	unsigned eg_cnt0 = eg_cnt;
+	eg_cnt += num;
+
+	for (auto i : xrange(24)) {
+		auto& sl = slots[i];
+		if (sl.state == EG_OFF) {
+			// Remains off during the whole block (only a key-on can
+			// change that). Only the TL interpolation and the LFO
+			// still need to be updated.
+			if (sl.TL != sl.TLdest) {
+				for (auto j : xrange(num)) sl.advance(eg_cnt0 + j + 1);
+			} else if (sl.lfo_active) {
+				sl.lfo_cnt = (sl.lfo_cnt + num * lfo_period[sl.lfo]) & (LFO_PERIOD - 1);
+			}
+			bufs[i] = nullptr;
+			continue;
+		}
+
+		// Panning is also done separately. (low-volume TL + low-volume panning goes below -60dB)
+		// I'll be taking wild guess and assume that -3dB is approximated with 75%. (same as with TL and envelope levels)
+		// The same applies to the PCM mix level.
+		int32_t volLeft  = pan_left [sl.pan]; // note: register 0xF9 is handled externally
+		int32_t volRight = pan_right[sl.pan];
+		// 0 -> 0x20, 8 -> 0x18, 16 -> 0x10, 24 -> 0x0C, etc. (not using vol_factor here saves array boundary checks)
+		volLeft  = (0x20 - (volLeft  & 0x0f)) >> (volLeft  >> 4);
+		volRight = (0x20 - (volRight & 0x0f)) >> (volRight >> 4);
+
+		float* buf = bufs[i];
+		for (auto j : xrange(num)) {
 			if (sl.state == EG_OFF) {
-				//bufs[i][2 * j + 0] += 0;
-				//bufs[i][2 * j + 1] += 0;
+				//buf[2 * j + 0] += 0;
+				//buf[2 * j + 1] += 0;
+				sl.advance(eg_cnt0 + j + 1);
 				continue;
 			}
 
@@ -513,17 +542,8 @@ void YMF278::generateChannels(float** bufs, unsigned num)
 			                           MAX_ATT_INDEX);
 			int smplOut = vol_factor(vol_factor(sample, envVol), sl.TL << TL_SHIFT);
 
-			// Panning is also done separately. (low-volume TL + low-volume panning goes below -60dB)
-			// I'll be taking wild guess and assume that -3dB is approximated with 75%. (same as with TL and envelope levels)
-			// The same applies to the PCM mix level.
-			int32_t volLeft  = pan_left [sl.pan]; // note: register 0xF9 is handled externally
-			int32_t volRight = pan_right[sl.pan];
-			// 0 -> 0x20, 8 -> 0x18, 16 -> 0x10, 24 -> 0x0C, etc. (not using vol_factor here saves array boundary checks)
-			volLeft  = (0x20 - (volLeft  & 0x0f)) >> (volLeft  >> 4);
-			volRight = (0x20 - (volRight & 0x0f)) >> (volRight >> 4);
-
-			bufs[i][2 * j + 0] += (smplOut * volLeft ) >> 5;
-			bufs[i][2 * j + 1] += (smplOut * volRight) >> 5;
+			buf[2 * j + 0] += (smplOut * volLeft ) >> 5;
+			buf[2 * j + 1] += (smplOut * volRight) >> 5;
 
 			unsigned step = (sl.lfo_active && sl.vib)
 			              ? calcStep(sl.OCT, sl.FN, sl.compute_vib())
@@ -542,8 +562,8 @@ void YMF278::generateChannels(float** bufs, unsigned num)
 					sl.pos += sl.endaddr + sl.loopaddr; // This is how the actual chip does it.
 				}
 			}
+			sl.advance(eg_cnt0 + j + 1);
 		}
-		advance();
 	}
 }
 
@@ -557,7 +577,7 @@ void YMF278::keyOnHelper(YMF278::Slot& slot)
 		// Nuke.YKT verified that the FM part does it exactly this way,
 		// and the OPL4 manual says it's instant as well.
 		slot.env_vol = MIN_ATT_INDEX;
-		// see comment in 'case EG_ATT' in YMF278::advance()
+		// see comment in 'case EG_ATT' in YMF278::Slot::advance()
 		slot.state = slot.DL ? EG_DEC : EG_SUS;
 	}
 	slot.stepptr = 0;
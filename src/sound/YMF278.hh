@@ -45,6 +45,7 @@ private:
 		void envelope_next(int sample_rate);
 		[[nodiscard]] int16_t compute_vib() const;
 		[[nodiscard]] uint16_t compute_am() const;
+		void advance(unsigned eg_cnt);
 
 		template<typename Archive>
 		void serialize(Archive& ar, unsigned version);
@@ -93,7 +94,6 @@ private:
 	void writeRegDirect(byte reg, byte data, EmuTime::param time);
 	[[nodiscard]] unsigned getRamAddress(unsigned addr) const;
 	[[nodiscard]] int16_t getSample(Slot& op) const;
-	void advance();
 	[[nodiscard]] bool anyActive();
 	void keyOnHelper(Slot& slot);
 
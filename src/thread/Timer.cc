@@ -1,6 +1,12 @@
 #include "Timer.hh"
 #include <chrono>
 #include <thread>
+#if defined(__linux__)
+#include <ctime>
+#include <cerrno>
+#elif defined(_WIN32)
+#include <windows.h>
+#endif
 
 namespace openmsx::Timer {
 
@@ -29,4 +35,59 @@ void sleep(uint64_t us)
 	std::this_thread::sleep_for(std::chrono::microseconds(us));
 }
 
+// Sleep till (approximately) the given time, as precise as the OS allows.
+static void osSleepUntil(uint64_t target)
+{
+#if defined(__linux__)
+	// steady_clock is CLOCK_MONOTONIC (see above), so we can use an
+	// absolute timeout: no drift because of the time spent between
+	// calculating the timeout and actually going to sleep.
+	timespec ts;
+	ts.tv_sec  = time_t(target / 1000000);
+	ts.tv_nsec = long((target % 1000000) * 1000);
+	while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, nullptr) == EINTR) {
+		// interrupted by a signal, sleep again
+	}
+#elif defined(_WIN32)
+	// A high resolution waitable timer (Windows 10 1803 and later) is a
+	// lot more precise than Sleep() (which by default has a granularity
+	// of 15.6ms).
+#ifndef CREATE_WAITABLE_TIMER_HIGH_RESOLUTION
+#define CREATE_WAITABLE_TIMER_HIGH_RESOLUTION 0x00000002
+#endif
+	static thread_local HANDLE timer = CreateWaitableTimerExW(
+		nullptr, nullptr, CREATE_WAITABLE_TIMER_HIGH_RESOLUTION,
+		TIMER_ALL_ACCESS);
+	auto now = getTime();
+	if (target <= now) return;
+	if (timer) {
+		LARGE_INTEGER due;
+		due.QuadPart = -LONGLONG((target - now) * 10); // relative, 100ns units
+		if (SetWaitableTimerEx(timer, &due, 0, nullptr, nullptr, nullptr, 0)) {
+			WaitForSingleObject(timer, INFINITE);
+			return;
+		}
+	}
+	sleep(target - now);
+#else
+	using namespace std::chrono;
+	std::this_thread::sleep_until(
+		steady_clock::time_point(duration_cast<steady_clock::duration>(
+			microseconds(target))));
+#endif
+}
+
+uint64_t sleepUntil(uint64_t target, uint64_t spin)
+{
+	if (target > spin) {
+		auto wakeup = target - spin;
+		if (getTime() < wakeup) osSleepUntil(wakeup);
+	}
+	auto result = getTime();
+	while (getTime() < target) {
+		std::this_thread::yield();
+	}
+	return result;
+}
+
 } // namespace openmsx::Timer
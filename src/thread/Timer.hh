@@ -14,6 +14,15 @@ namespace openmsx::Timer {
 	  */
 	void sleep(uint64_t us);
 
+	/** Sleep till (at least) the given time (as returned by getTime()).
+	  * The OS is asked to wake us up 'spin' us before that time (using an
+	  * absolute, high resolution timer where available), the remaining
+	  * time is spent in a busy loop. So 'spin' should be (slightly) more
+	  * than the usual lateness of the OS wake-ups.
+	  * @return The time right after the OS sleep (before busy waiting).
+	  */
+	uint64_t sleepUntil(uint64_t target, uint64_t spin);
+
 } // namespace openmsx::Timer
 
 #endif
@@ -0,0 +1,74 @@
+#include "WorkerPool.hh"
+#include <cassert>
+
+namespace openmsx {
+
+WorkerPool::WorkerPool(unsigned numThreads)
+{
+	if (numThreads == 0) {
+		unsigned cores = std::thread::hardware_concurrency();
+		numThreads = (cores > 1) ? (cores - 1) : 1;
+	}
+	threads.reserve(numThreads);
+	for (unsigned i = 0; i < numThreads; ++i) {
+		threads.emplace_back([this]() { run(); });
+	}
+}
+
+WorkerPool::~WorkerPool()
+{
+	{
+		std::lock_guard lock(mutex);
+		exiting = true;
+	}
+	taskCond.notify_all();
+	for (auto& t : threads) {
+		t.join();
+	}
+	assert(tasks.empty());
+}
+
+void WorkerPool::post(std::function<void()> task)
+{
+	{
+		std::lock_guard lock(mutex);
+		tasks.push_back(std::move(task));
+	}
+	taskCond.notify_one();
+}
+
+void WorkerPool::wait()
+{
+	std::unique_lock lock(mutex);
+	idleCond.wait(lock, [&] { return tasks.empty() && (busy == 0); });
+}
+
+void WorkerPool::run()
+{
+	std::unique_lock lock(mutex);
+	while (true) {
+		taskCond.wait(lock, [&] { return !tasks.empty() || exiting; });
+		if (tasks.empty()) {
+			assert(exiting);
+			return;
+		}
+		auto task = tasks.pop_front();
+		++busy;
+		lock.unlock();
+		task();
+		task = nullptr; // destroy captured state outside the lock
+		lock.lock();
+		--busy;
+		if (tasks.empty() && (busy == 0)) {
+			idleCond.notify_all();
+		}
+	}
+}
+
+WorkerPool& WorkerPool::background()
+{
+	static WorkerPool pool;
+	return pool;
+}
+
+} // namespace openmsx
@@ -0,0 +1,61 @@
+#ifndef WORKERPOOL_HH
+#define WORKERPOOL_HH
+
+#include "circular_buffer.hh"
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace openmsx {
+
+/** A fixed set of worker threads that execute posted tasks in FIFO order.
+  *
+  * Used to move work that doesn't need to happen in lock-step with the
+  * emulation (e.g. compression) off the main thread. Tasks must not touch
+  * emulator state that the main thread may modify concurrently.
+  */
+class WorkerPool final
+{
+public:
+	/** Create a pool with the given number of threads. A value of 0
+	  * means one thread less than the number of cores (but at least 1).
+	  */
+	explicit WorkerPool(unsigned numThreads = 0);
+
+	/** Executes all still pending tasks, then stops the threads. */
+	~WorkerPool();
+
+	WorkerPool(const WorkerPool&) = delete;
+	WorkerPool& operator=(const WorkerPool&) = delete;
+
+	/** Queue a task for execution on one of the worker threads. */
+	void post(std::function<void()> task);
+
+	/** Block until all tasks posted so far have finished. */
+	void wait();
+
+	[[nodiscard]] unsigned getNumThreads() const { return unsigned(threads.size()); }
+
+	/** Pool shared by all code that needs some background processing. */
+	[[nodiscard]] static WorkerPool& background();
+
+private:
+	void run();
+
+private:
+	std::vector<std::thread> threads;
+	cb_queue<std::function<void()>> tasks; // keeps its capacity, so a
+	                                       // steady stream of (small) tasks
+	                                       // doesn't allocate
+	std::mutex mutex;
+	std::condition_variable taskCond; // signaled on new task or on exit
+	std::condition_variable idleCond; // signaled when a task finished
+	unsigned busy = 0; // number of tasks currently being executed
+	bool exiting = false;
+};
+
+} // namespace openmsx
+
+#endif
@@ -0,0 +1,74 @@
+#include "catch.hpp"
+#include "LineScalers.hh"
+#include "PixelOperations.hh"
+#include <cstdint>
+#include <random>
+#include <vector>
+
+using namespace openmsx;
+
+// The (SIMD) line routine must give exactly the same result as the per-pixel
+// PixelOperations::alphaBlend(), also in-place and for the leftover pixels at
+// the end of the line.
+template<typename Pixel, typename Gen>
+static void test(const PixelFormat& format, Gen gen)
+{
+	PixelOperations<Pixel> pixelOps(format);
+	AlphaBlendLines<Pixel> blend(pixelOps);
+	std::mt19937 rng(1234);
+	for (size_t width : {0, 1, 3, 4, 7, 8, 9, 15, 16, 17, 320, 641}) {
+		std::vector<Pixel> in1(width), in2(width), out(width);
+		for (auto i : xrange(width)) {
+			in1[i] = gen(rng);
+			in2[i] = Pixel(rng());
+		}
+		std::vector<Pixel> expected(width);
+		for (auto i : xrange(width)) {
+			expected[i] = pixelOps.alphaBlend(in1[i], in2[i]);
+		}
+
+		blend(in1.data(), in2.data(), out.data(), width);
+		CHECK(out == expected);
+
+		blend(in1.data(), in2.data(), in1.data(), width);
+		CHECK(in1 == expected);
+	}
+}
+
+TEST_CASE("AlphaBlendLines: 32bpp")
+{
+	auto gen = [](std::mt19937& rng) {
+		// often fully opaque or fully transparent
+		uint32_t p = rng();
+		switch (rng() % 4) {
+			case 0: return p | 0xFF000000;
+			case 1: return p & 0x00FFFFFF;
+			default: return p;
+		}
+	};
+	SECTION("alpha in high byte") {
+		test<uint32_t>(PixelFormat(32,
+			0x000000FF,  0, 0, 0x0000FF00,  8, 0,
+			0x00FF0000, 16, 0, 0xFF000000, 24, 0), gen);
+	}
+	SECTION("alpha in low byte") {
+		auto gen2 = [&](std::mt19937& rng) {
+			uint32_t p = gen(rng);
+			return (p << 8) | (p >> 24);
+		};
+		test<uint32_t>(PixelFormat(32,
+			0x0000FF00,  8, 0, 0x00FF0000, 16, 0,
+			0xFF000000, 24, 0, 0x000000FF,  0, 0), gen2);
+	}
+}
+
+TEST_CASE("AlphaBlendLines: 16bpp")
+{
+	auto gen = [](std::mt19937& rng) {
+		// 0x0001 is the key color (transparent)
+		return (rng() & 1) ? uint16_t(0x0001) : uint16_t(rng());
+	};
+	test<uint16_t>(PixelFormat(16,
+		0xF800, 11, 3, 0x07E0, 5, 2,
+		0x001F,  0, 3, 0x0000, 0, 8), gen);
+}
@@ -0,0 +1,52 @@
+#include "catch.hpp"
+#include "BinaryCliCommParser.hh"
+#include <string>
+#include <vector>
+
+using namespace openmsx;
+using namespace std;
+
+static string frame(char type, string_view payload)
+{
+	string result;
+	BinaryCliCommParser::appendFrame(result, type, payload);
+	return result;
+}
+
+TEST_CASE("BinaryCliCommParser")
+{
+	vector<string> result;
+	BinaryCliCommParser parser([&](const string& cmd) { result.push_back(cmd); });
+	auto parse = [&](const string& stream) { parser.parse(stream.data(), stream.size()); };
+
+	SECTION("frame layout") {
+		CHECK(frame('C', "ab") == string("C\x02\0\0\0ab", 7));
+		CHECK(frame('R', "") == string("R\0\0\0\0", 5));
+		CHECK(frame('C', string(0x10203, 'x')).substr(0, 5) == string("C\x03\x02\x01\0", 5));
+	}
+	SECTION("multiple commands") {
+		parse(frame('C', "foo") + frame('C', "") + frame('C', "bar"));
+		CHECK(result == vector<string>{"foo", "", "bar"});
+	}
+	SECTION("payload is not interpreted") {
+		string cmd("<command>&amp;\0\n", 16);
+		parse(frame('C', cmd));
+		CHECK(result == vector<string>{cmd});
+	}
+	SECTION("split at every byte") {
+		auto stream = frame('C', "set renderer SDL") + frame('C', "reset");
+		for (char c : stream) parser.parse(&c, 1);
+		CHECK(result == vector<string>{"set renderer SDL", "reset"});
+	}
+	SECTION("unknown frame types are skipped") {
+		parse(frame('C', "foo") + frame('X', "ignored") + frame('C', "bar"));
+		CHECK(result == vector<string>{"foo", "bar"});
+	}
+	SECTION("incomplete frame") {
+		auto stream = frame('C', "foo");
+		parse(stream.substr(0, 6));
+		CHECK(result.empty());
+		parse(stream.substr(6));
+		CHECK(result == vector<string>{"foo"});
+	}
+}
@@ -0,0 +1,191 @@
+#include "catch.hpp"
+#include "BitmapConverter.hh"
+#include "build-info.hh"
+#include "components.hh"
+#include <algorithm>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+using namespace openmsx;
+
+// Straightforward reference implementations, one pixel at a time.
+
+template<typename Pixel>
+static void refGraphic4(Pixel* out, const byte* vram, const Pixel* pal16)
+{
+	for (int i = 0; i < 128; ++i) {
+		out[2 * i + 0] = pal16[vram[i] >> 4];
+		out[2 * i + 1] = pal16[vram[i] & 15];
+	}
+}
+
+template<typename Pixel>
+static void refGraphic5(Pixel* out, const byte* vram, const Pixel* pal16)
+{
+	for (int i = 0; i < 128; ++i) {
+		out[4 * i + 0] = pal16[ 0 + ((vram[i] >> 6) & 3)];
+		out[4 * i + 1] = pal16[16 + ((vram[i] >> 4) & 3)];
+		out[4 * i + 2] = pal16[ 0 + ((vram[i] >> 2) & 3)];
+		out[4 * i + 3] = pal16[16 + ((vram[i] >> 0) & 3)];
+	}
+}
+
+template<typename Pixel>
+static void refGraphic6(Pixel* out, const byte* vram0, const byte* vram1, const Pixel* pal16)
+{
+	for (int i = 0; i < 128; ++i) {
+		out[4 * i + 0] = pal16[vram0[i] >> 4];
+		out[4 * i + 1] = pal16[vram0[i] & 15];
+		out[4 * i + 2] = pal16[vram1[i] >> 4];
+		out[4 * i + 3] = pal16[vram1[i] & 15];
+	}
+}
+
+template<typename Pixel>
+static void refGraphic7(Pixel* out, const byte* vram0, const byte* vram1, const Pixel* pal256)
+{
+	for (int i = 0; i < 128; ++i) {
+		out[2 * i + 0] = pal256[vram0[i]];
+		out[2 * i + 1] = pal256[vram1[i]];
+	}
+}
+
+template<typename Pixel>
+static void refYJK(Pixel* out, const byte* vram0, const byte* vram1,
+                   const Pixel* pal16, const Pixel* pal32768, bool yae)
+{
+	for (int i = 0; i < 64; ++i) {
+		int p[4] = { vram0[2 * i + 0], vram1[2 * i + 0],
+		             vram0[2 * i + 1], vram1[2 * i + 1] };
+		// 6-bit signed values
+		int j = (((p[3] & 7) << 3) | (p[2] & 7)); if (j >= 32) j -= 64;
+		int k = (((p[1] & 7) << 3) | (p[0] & 7)); if (k >= 32) k -= 64;
+		for (int n = 0; n < 4; ++n) {
+			if (yae && (p[n] & 0x08)) {
+				out[4 * i + n] = pal16[p[n] >> 4];
+			} else {
+				int y = p[n] >> 3;
+				int r = std::clamp(y + j, 0, 31);
+				int g = std::clamp(y + k, 0, 31);
+				int b = std::clamp((5 * y - 2 * j - k) / 4, 0, 31);
+				out[4 * i + n] = pal32768[(r << 10) | (g << 5) | b];
+			}
+		}
+	}
+}
+
+// Construct a display mode via its register values.
+static DisplayMode mode(byte base, byte reg25 = 0)
+{
+	return DisplayMode(byte((base & 0x1C) >> 1), 0, reg25);
+}
+static constexpr byte G4 = 0x0C, G5 = 0x10, G6 = 0x14, G7 = 0x1C;
+static constexpr byte YJK = 0x08, YAE = 0x10; // R#25 bits
+
+template<typename Pixel> struct Fixture
+{
+	Fixture()
+		: pal16(32), pal256(256), pal32768(32768)
+		, vram0(128), vram1(128)
+		, converter(pal16.data(), pal256.data(), pal32768.data())
+	{
+		randomize(pal16);
+		randomize(pal256);
+		randomize(pal32768);
+		randomize(vram0);
+		randomize(vram1);
+	}
+
+	template<typename T> void randomize(std::vector<T>& v)
+	{
+		std::uniform_int_distribution<uint32_t> dist;
+		for (auto& e : v) e = T(dist(gen));
+	}
+
+	void check(byte base, byte reg25 = 0)
+	{
+		std::vector<Pixel> expected(512);
+		Pixel* e = expected.data();
+		switch (base) {
+		case G4: refGraphic4(e, vram0.data(), pal16.data()); break;
+		case G5: refGraphic5(e, vram0.data(), pal16.data()); break;
+		case G6:
+			if (reg25 & YJK) {
+				refYJK(e, vram0.data(), vram1.data(), pal16.data(), pal32768.data(), reg25 & YAE);
+			} else {
+				refGraphic6(e, vram0.data(), vram1.data(), pal16.data());
+			}
+			break;
+		case G7:
+			if (reg25 & YJK) {
+				refYJK(e, vram0.data(), vram1.data(), pal16.data(), pal32768.data(), reg25 & YAE);
+			} else {
+				refGraphic7(e, vram0.data(), vram1.data(), pal256.data());
+			}
+			break;
+		}
+		size_t width = (((base == G5) || (base == G6)) && !(reg25 & YJK)) ? 512 : 256;
+		expected.resize(width);
+
+		converter.setDisplayMode(mode(base, reg25));
+		// Also test an unaligned destination, and check for writes
+		// outside the line.
+		const auto SENTINEL = Pixel(0x5A5A5A5A);
+		for (size_t offset : {8, 9}) {
+			std::vector<Pixel> actual(512 + 16, SENTINEL);
+			Pixel* a = actual.data() + offset;
+			if ((base == G4) || (base == G5)) {
+				converter.convertLine(a, vram0.data());
+			} else {
+				converter.convertLinePlanar(a, vram0.data(), vram1.data());
+			}
+			CHECK(std::vector<Pixel>(a, a + width) == expected);
+			CHECK(std::all_of(actual.begin(), actual.begin() + offset,
+			                  [&](Pixel p) { return p == SENTINEL; }));
+			CHECK(std::all_of(actual.begin() + offset + width, actual.end(),
+			                  [&](Pixel p) { return p == SENTINEL; }));
+		}
+	}
+
+	void checkAll()
+	{
+		for (int round = 0; round < 10; ++round) {
+			randomize(vram0);
+			randomize(vram1);
+			if (round & 1) {
+				randomize(pal16);
+				converter.palette16Changed();
+			}
+			check(G4);
+			check(G5);
+			check(G6);
+			check(G7);
+			check(G6, YJK);
+			check(G7, YJK);
+			check(G6, YJK | YAE);
+			check(G7, YJK | YAE);
+		}
+	}
+
+	std::mt19937 gen{1234};
+	std::vector<Pixel> pal16, pal256, pal32768;
+	std::vector<byte> vram0, vram1;
+	BitmapConverter<Pixel> converter;
+};
+
+#if HAVE_32BPP || COMPONENT_GL
+TEST_CASE("BitmapConverter: 32bpp")
+{
+	Fixture<uint32_t> f;
+	f.checkAll();
+}
+#endif
+
+#if HAVE_16BPP
+TEST_CASE("BitmapConverter: 16bpp")
+{
+	Fixture<uint16_t> f;
+	f.checkAll();
+}
+#endif
@@ -0,0 +1,108 @@
+#include "catch.hpp"
+#include "BlipBuffer.hh"
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <random>
+#include <vector>
+
+using namespace openmsx;
+
+using TimeIndex = BlipBuffer::TimeIndex;
+
+struct Delta {
+	TimeIndex time;
+	float delta;
+};
+
+// Increasing times in [0, samples), on average 'perSample' changes per sample.
+static std::vector<Delta> randomDeltas(std::mt19937& gen, unsigned samples, float perSample)
+{
+	std::uniform_real_distribution<float> value(-1.0f, 1.0f);
+	std::exponential_distribution<double> gap(perSample);
+	std::vector<Delta> result;
+	double t = gap(gen);
+	while (t < samples) {
+		result.push_back({TimeIndex(t), value(gen)});
+		t += gap(gen);
+	}
+	return result;
+}
+
+// Read 'samples' in chunks of at most 'chunk' samples.
+template<unsigned PITCH>
+static std::vector<float> read(BlipBuffer& blip, unsigned samples, unsigned chunk)
+{
+	std::vector<float> result(samples * PITCH, 0.0f);
+	for (unsigned pos = 0; pos < samples; pos += chunk) {
+		unsigned num = std::min(chunk, samples - pos);
+		if (!blip.readSamples<PITCH>(&result[pos * PITCH], num)) {
+			for (unsigned i = 0; i < num; ++i) result[(pos + i) * PITCH] = 0.0f;
+		}
+	}
+	return result;
+}
+
+static float maxDiff(const std::vector<float>& a, const std::vector<float>& b)
+{
+	REQUIRE(a.size() == b.size());
+	float result = 0.0f;
+	for (size_t i = 0; i < a.size(); ++i) {
+		result = std::max(result, std::abs(a[i] - b[i]));
+	}
+	return result;
+}
+
+// addDeltas() sums the impulses in a different order, so the result is only
+// approximately the same.
+TEST_CASE("BlipBuffer: addDeltas() is the same as addDelta()")
+{
+	std::mt19937 gen(1234);
+	for (float perSample : {0.01f, 0.5f, 3.0f}) {
+		auto deltas = randomDeltas(gen, 1000, perSample);
+		auto blip1 = std::make_unique<BlipBuffer>();
+		auto blip2 = std::make_unique<BlipBuffer>();
+		std::vector<TimeIndex> times;
+		std::vector<float> values;
+		for (const auto& d : deltas) {
+			blip1->addDelta(d.time, d.delta);
+			times.push_back(d.time);
+			values.push_back(d.delta);
+		}
+		blip2->addDeltas(times.data(), values.data(), unsigned(times.size()));
+		CHECK(maxDiff(read<1>(*blip1, 1100, 1100), read<1>(*blip2, 1100, 1100)) < 1e-4f);
+	}
+}
+
+// Reading in big chunks uses the SIMD integration loop (when available),
+// reading in chunks of less than 4 samples uses the scalar loop. These round
+// differently, so only compare approximately.
+template<unsigned PITCH>
+static void checkIntegration()
+{
+	std::mt19937 gen(4321);
+	for (unsigned chunk : {1, 2, 3}) {
+		auto blip1 = std::make_unique<BlipBuffer>();
+		auto blip2 = std::make_unique<BlipBuffer>();
+		std::vector<float> out1, out2;
+		// several blocks, this also wraps around the internal buffer
+		for (int block = 0; block < 40; ++block) {
+			unsigned samples = 400 + 37 * block;
+			for (const auto& d : randomDeltas(gen, samples, 0.2f)) {
+				blip1->addDelta(d.time, d.delta);
+				blip2->addDelta(d.time, d.delta);
+			}
+			auto o1 = read<PITCH>(*blip1, samples, samples);
+			auto o2 = read<PITCH>(*blip2, samples, chunk);
+			out1.insert(out1.end(), o1.begin(), o1.end());
+			out2.insert(out2.end(), o2.begin(), o2.end());
+		}
+		CHECK(maxDiff(out1, out2) < 1e-4f);
+	}
+}
+
+TEST_CASE("BlipBuffer: integration")
+{
+	SECTION("mono") { checkIntegration<1>(); }
+	SECTION("stereo") { checkIntegration<2>(); }
+}
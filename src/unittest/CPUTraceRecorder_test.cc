@@ -0,0 +1,128 @@
+#include "catch.hpp"
+#include "CPUTraceRecorder.hh"
+#include "MSXException.hh"
+#include "xrange.hh"
+#include <vector>
+
+using namespace openmsx;
+
+static std::vector<uint8_t> getTrace(const CPUTraceRecorder& recorder)
+{
+	std::vector<uint8_t> result;
+	recorder.write([&](span<const uint8_t> data) {
+		result.insert(result.end(), data.begin(), data.end());
+	});
+	return result;
+}
+
+static std::vector<CPUTraceRecorder::Entry> decode(span<const uint8_t> trace)
+{
+	std::vector<CPUTraceRecorder::Entry> result;
+	CPUTraceRecorder::decode(trace, [&](const CPUTraceRecorder::Entry& e) {
+		result.push_back(e);
+	});
+	return result;
+}
+
+TEST_CASE("CPUTraceRecorder: round trip")
+{
+	CPUTraceRecorder recorder;
+	recorder.start(1024 * 1024);
+	CHECK(recorder.isRecording());
+
+	CPUTraceRecorder::Regs regs = {};
+	byte nop[4]  = {0x00, 0x11, 0x22, 0x33};       // nop
+	byte ldhl[4] = {0x21, 0x34, 0x12, 0x99};       // ld hl,#1234
+	byte jp[4]   = {0xC3, 0x00, 0x40, 0x99};       // jp #4000
+	byte ixcb[4] = {0xDD, 0xCB, 0x05, 0x46};       // bit 0,(ix+#05)
+
+	recorder.record(1000, 0x0100, nop, regs);
+	regs[3] = 0x1234;
+	recorder.record(1010, 0x0101, ldhl, regs);
+	recorder.record(1020, 0x0104, jp, regs);
+	regs[0] = 0x5544;
+	recorder.record(1050, 0x4000, ixcb, regs);
+	// time going backwards (e.g. reverse) starts a new chunk
+	recorder.record(500, 0x4004, nop, regs);
+	CHECK(recorder.getNumRecords() == 5);
+
+	auto entries = decode(getTrace(recorder));
+	REQUIRE(entries.size() == 5);
+	CHECK(entries[0].time == 1000);
+	CHECK(entries[0].pc == 0x0100);
+	CHECK(entries[0].length == 1);
+	CHECK(entries[1].time == 1010);
+	CHECK(entries[1].pc == 0x0101);
+	CHECK(entries[1].length == 3);
+	CHECK(entries[1].opcode[2] == 0x12);
+	CHECK(entries[1].opcode[3] == 0x00); // not part of the instruction
+	CHECK(entries[1].regs[3] == 0x1234);
+	CHECK(entries[2].pc == 0x0104);
+	CHECK(entries[3].time == 1050);
+	CHECK(entries[3].pc == 0x4000);
+	CHECK(entries[3].length == 4);
+	CHECK(entries[3].opcode[3] == 0x46);
+	CHECK(entries[3].regs[0] == 0x5544);
+	CHECK(entries[3].regs[3] == 0x1234);
+	CHECK(entries[4].time == 500);
+	CHECK(entries[4].pc == 0x4004);
+	CHECK(entries[4].regs[0] == 0x5544);
+
+	// stop() keeps the data
+	recorder.stop();
+	CHECK(!recorder.isRecording());
+	CHECK(decode(getTrace(recorder)).size() == 5);
+
+	recorder.clear();
+	CHECK(recorder.getNumRecords() == 0);
+	CHECK(decode(getTrace(recorder)).empty());
+}
+
+TEST_CASE("CPUTraceRecorder: ring buffer")
+{
+	CPUTraceRecorder recorder;
+	recorder.start(1); // only keep the most recent chunk
+	CPUTraceRecorder::Regs regs = {};
+	byte opcode[4] = {0x3C, 0, 0, 0}; // inc a
+	unsigned n = 100000;
+	for (auto i : xrange(n)) {
+		regs[0] = word(i * 0x997); // make it hard to compress
+		recorder.record(i * 4, word(i), opcode, regs);
+	}
+	recorder.stop();
+	CHECK(recorder.getNumChunks() == 1);
+	CHECK(recorder.getNumDropped() > 0);
+	CHECK((recorder.getNumRecords() + recorder.getNumDropped()) == n);
+
+	auto entries = decode(getTrace(recorder));
+	REQUIRE(entries.size() == recorder.getNumRecords());
+	CHECK(entries.back().pc == word(n - 1));
+	CHECK(entries.back().time == (n - 1) * 4);
+	CHECK(entries.back().regs[0] == word((n - 1) * 0x997));
+}
+
+TEST_CASE("CPUTraceRecorder: invalid data")
+{
+	CPUTraceRecorder recorder;
+	recorder.start(1024 * 1024);
+	CPUTraceRecorder::Regs regs = {};
+	byte opcode[4] = {0, 0, 0, 0};
+	for (auto i : xrange(100)) {
+		recorder.record(i, word(10 * i), opcode, regs);
+	}
+	auto trace = getTrace(recorder);
+	CHECK(decode(trace).size() == 100);
+
+	SECTION("bad header") {
+		trace[0] = 'X';
+		CHECK_THROWS_AS(decode(trace), MSXException);
+	}
+	SECTION("corrupt data") {
+		trace.back() ^= 0x55;
+		CHECK_THROWS_AS(decode(trace), MSXException);
+	}
+	SECTION("truncated") {
+		trace.pop_back();
+		CHECK_THROWS_AS(decode(trace), MSXException);
+	}
+}
@@ -0,0 +1,73 @@
+#include "catch.hpp"
+#include "CheatFinder.hh"
+#include <array>
+#include <vector>
+
+using namespace openmsx;
+
+static std::vector<unsigned> getCandidates(const CheatFinder& finder)
+{
+	std::vector<unsigned> result;
+	finder.forEachCandidate([&](unsigned addr, byte /*prev*/, byte /*value*/) {
+		result.push_back(addr);
+	});
+	return result;
+}
+
+TEST_CASE("CheatFinder")
+{
+	using R = CheatFinder::Relation;
+	std::vector<byte> mem(100, 0); // not a multiple of 32
+	for (unsigned i = 0; i < mem.size(); ++i) mem[i] = byte(i);
+
+	CheatFinder finder;
+	CHECK(!finder.isStarted());
+	finder.start(mem);
+	CHECK(finder.isStarted());
+	CHECK(finder.getSize() == 100);
+	CHECK(finder.getNumCandidates() == 100);
+	CHECK(getCandidates(finder).back() == 99);
+
+	SECTION("relations with previous values") {
+		mem[10] = 5; mem[20] = 30; mem[99] = 0;
+		CHECK(finder.narrow(mem, R::NOT_EQUAL) == 3);
+		CHECK(getCandidates(finder) == std::vector<unsigned>{10, 20, 99});
+		mem[20] = 31; mem[99] = 1;
+		CHECK(finder.narrow(mem, R::GREATER) == 2);
+		CHECK(getCandidates(finder) == std::vector<unsigned>{20, 99});
+		std::vector<std::array<unsigned, 3>> entries;
+		finder.forEachCandidate([&](unsigned addr, byte prev, byte value) {
+			entries.push_back({addr, prev, value});
+		});
+		CHECK(entries == std::vector<std::array<unsigned, 3>>{{20, 30, 31}, {99, 0, 1}});
+		CHECK(finder.narrow(mem, R::EQUAL) == 2); // unchanged
+		mem[20] = 0;
+		CHECK(finder.narrow(mem, R::LESS_EQUAL) == 2);
+		CHECK(finder.narrow(mem, R::LESS) == 0);
+		CHECK(getCandidates(finder).empty());
+	}
+	SECTION("fixed value") {
+		mem[50] = 42; mem[60] = 42;
+		CHECK(finder.narrow(mem, R::EQUAL, byte(42)) == 3); // 42, 50, 60
+		CHECK(getCandidates(finder) == std::vector<unsigned>{42, 50, 60});
+		CHECK(finder.narrow(mem, R::GREATER_EQUAL, byte(43)) == 0);
+	}
+	SECTION("any") {
+		mem[5] = 200;
+		CHECK(finder.narrow(mem, R::ANY) == 100);
+		// the values of this step are now the reference
+		CHECK(finder.narrow(mem, R::EQUAL) == 100);
+	}
+	SECTION("keep") {
+		std::vector<unsigned> addrs = {3, 64, 99, 1000};
+		CHECK(finder.keep(mem, addrs) == 3);
+		CHECK(getCandidates(finder) == std::vector<unsigned>{3, 64, 99});
+		std::vector<unsigned> none;
+		CHECK(finder.keep(mem, none) == 0);
+	}
+	SECTION("restart") {
+		CHECK(finder.narrow(mem, R::NOT_EQUAL) == 0);
+		finder.start(mem);
+		CHECK(finder.getNumCandidates() == 100);
+	}
+}
@@ -0,0 +1,101 @@
+#include "catch.hpp"
+#include "CodeCoverage.hh"
+#include "MSXException.hh"
+#include <vector>
+
+using namespace openmsx;
+
+static std::vector<uint8_t> getFile(const CodeCoverage& coverage)
+{
+	std::vector<uint8_t> result;
+	coverage.write([&](span<const uint8_t> data) {
+		result.insert(result.end(), data.begin(), data.end());
+	});
+	return result;
+}
+
+TEST_CASE("CodeCoverage: mark and count")
+{
+	CodeCoverage coverage;
+	CHECK(coverage.getBitmap(CodeCoverage::EXEC, 1, 2).empty());
+	CHECK(coverage.count(CodeCoverage::EXEC) == 0);
+
+	coverage.mark(CodeCoverage::EXEC, 1, 2, 0x4000);
+	coverage.mark(CodeCoverage::EXEC, 1, 2, 0x4000); // twice the same
+	coverage.mark(CodeCoverage::EXEC, 1, 2, 0x4003);
+	coverage.mark(CodeCoverage::READ, 1, 2, 0x4001);
+	coverage.mark(CodeCoverage::EXEC, 3, 0, 0xFFFF);
+
+	auto bits = coverage.getBitmap(CodeCoverage::EXEC, 1, 2);
+	REQUIRE(bits.size() == CodeCoverage::INITIAL_SIZE);
+	CHECK(bits[0x4000 / 8] == 0x09);
+	CHECK(coverage.count(CodeCoverage::EXEC, 1, 2) == 2);
+	CHECK(coverage.count(CodeCoverage::READ, 1, 2) == 1);
+	CHECK(coverage.count(CodeCoverage::WRITE, 1, 2) == 0);
+	CHECK(coverage.count(CodeCoverage::EXEC) == 3);
+	CHECK(coverage.getBitmap(CodeCoverage::EXEC, 2, 1).empty());
+
+	SECTION("grow") {
+		// e.g. segment 100 of a memory mapper
+		coverage.mark(CodeCoverage::WRITE, 1, 2, 100 * 0x4000 + 5);
+		auto wbits = coverage.getBitmap(CodeCoverage::WRITE, 1, 2);
+		CHECK(wbits.size() >= (100 * 0x4000 / 8));
+		CHECK(wbits[100 * 0x4000 / 8] == 0x20);
+		CHECK(coverage.count(CodeCoverage::WRITE) == 1);
+	}
+	SECTION("clear") {
+		coverage.clear();
+		CHECK(coverage.count(CodeCoverage::EXEC) == 0);
+		CHECK(coverage.count(CodeCoverage::READ) == 0);
+		// size is kept
+		CHECK(coverage.getBitmap(CodeCoverage::EXEC, 1, 2).size() == CodeCoverage::INITIAL_SIZE);
+	}
+}
+
+TEST_CASE("CodeCoverage: file")
+{
+	CodeCoverage coverage;
+	SECTION("empty") {
+		CHECK(CodeCoverage::parse(getFile(coverage)).empty());
+		// allocated, but all zero, isn't stored either
+		coverage.mark(CodeCoverage::READ, 0, 0, 0);
+		coverage.clear();
+		CHECK(CodeCoverage::parse(getFile(coverage)).empty());
+	}
+	SECTION("round trip") {
+		coverage.mark(CodeCoverage::WRITE, 3, 1, 0xC000);
+		coverage.mark(CodeCoverage::EXEC, 0, 0, 0x0038);
+		auto bitmaps = CodeCoverage::parse(getFile(coverage));
+		REQUIRE(bitmaps.size() == 2);
+		CHECK(bitmaps[0].ps == 0);
+		CHECK(bitmaps[0].ss == 0);
+		CHECK(bitmaps[0].kind == CodeCoverage::EXEC);
+		REQUIRE(bitmaps[0].bits.size() == CodeCoverage::INITIAL_SIZE);
+		CHECK(bitmaps[0].bits[0x0038 / 8] == 0x01);
+		CHECK(bitmaps[1].ps == 3);
+		CHECK(bitmaps[1].ss == 1);
+		CHECK(bitmaps[1].kind == CodeCoverage::WRITE);
+		CHECK(bitmaps[1].bits[0xC000 / 8] == 0x01);
+	}
+	SECTION("invalid") {
+		coverage.mark(CodeCoverage::READ, 2, 0, 0x1234);
+		auto file = getFile(coverage);
+		CHECK(CodeCoverage::parse(file).size() == 1);
+		SECTION("bad header") {
+			file[3] = 'x';
+			CHECK_THROWS_AS(CodeCoverage::parse(file), MSXException);
+		}
+		SECTION("truncated") {
+			file.pop_back();
+			CHECK_THROWS_AS(CodeCoverage::parse(file), MSXException);
+		}
+		SECTION("trailing data") {
+			file.push_back(0);
+			CHECK_THROWS_AS(CodeCoverage::parse(file), MSXException);
+		}
+		SECTION("bad slot") {
+			file[16 + 8] = 4;
+			CHECK_THROWS_AS(CodeCoverage::parse(file), MSXException);
+		}
+	}
+}
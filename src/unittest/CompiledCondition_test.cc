@@ -0,0 +1,102 @@
+#include "catch.hpp"
+#include "CompiledCondition.hh"
+#include <array>
+
+using namespace openmsx;
+
+struct TestEnv {
+	std::array<uint8_t, 28> regs = {};
+	std::array<uint8_t, 0x10000> mem = {};
+	int ps = 0;
+	int ss = 0;
+
+	uint8_t readReg(unsigned index) { return regs[index]; }
+	uint8_t peek(uint16_t address) { return mem[address]; }
+	bool inSlot(int ps_, int ss_) {
+		return (ps_ == ps) && ((ss_ == -1) || (ss_ == ss));
+	}
+};
+
+static std::optional<bool> eval(std::string_view expr, TestEnv& env)
+{
+	CompiledCondition c(expr);
+	REQUIRE(c.isValid());
+	return c.evaluate(env);
+}
+
+TEST_CASE("CompiledCondition: literals and operators")
+{
+	TestEnv env;
+	CHECK(eval("1", env) == true);
+	CHECK(eval("0", env) == false);
+	CHECK(eval("0x10 == 16", env) == true);
+	CHECK(eval("0b101 == 5", env) == true);
+	CHECK(eval("1 + 2 * 3 == 7", env) == true);
+	CHECK(eval("(1 + 2) * 3 == 9", env) == true);
+	CHECK(eval("1 << 4 == 16", env) == true);
+	CHECK(eval("-8 >> 1 == -4", env) == true);
+	CHECK(eval("6 & 3 == 2", env) == false); // '==' binds stronger than '&'
+	CHECK(eval("(6 & 3) == 2", env) == true);
+	CHECK(eval("(6 | 3) == 7 && (6 ^ 3) == 5", env) == true);
+	CHECK(eval("0 || 2 < 1", env) == false);
+	CHECK(eval("1 <= 1 && 2 >= 3", env) == false);
+	CHECK(eval("!0 && ~0 == -1 && -(3) == -3 && +3 == 3", env) == true);
+	CHECK(eval("1 != 2", env) == true);
+}
+
+TEST_CASE("CompiledCondition: machine access")
+{
+	TestEnv env;
+	env.regs[0] = 0x12;                     // A
+	env.regs[6] = 0x40; env.regs[7] = 0x00; // HL
+	env.regs[20] = 0x80; env.regs[21] = 0x01; // PC
+	env.mem[0x4000] = 0x34;
+	env.mem[0x4001] = 0x56;
+	env.ps = 3; env.ss = 1;
+
+	CHECK(eval("[reg A] == 0x12", env) == true);
+	CHECK(eval("[reg a] == 0x12", env) == true);
+	CHECK(eval("[reg HL] == 0x4000", env) == true);
+	CHECK(eval("[reg PC] == 0x8001", env) == true);
+	CHECK(eval("[ reg PCl ] == 1", env) == true);
+	CHECK(eval("[peek 0x4000] == 0x34", env) == true);
+	CHECK(eval("[peek [reg HL]] == 0x34", env) == true);
+	CHECK(eval("[peek16 [reg HL]] == 0x5634", env) == true);
+	CHECK(eval("[pc_in_slot 3]", env) == true);
+	CHECK(eval("[pc_in_slot 3 1]", env) == true);
+	CHECK(eval("[pc_in_slot 3 X]", env) == true);
+	CHECK(eval("[pc_in_slot 3 2]", env) == false);
+	CHECK(eval("[pc_in_slot 2]", env) == false);
+	CHECK(eval("![pc_in_slot 2]", env) == true);
+	CHECK(eval("[pc_in_slot 3] && [reg A] == 0x12", env) == true);
+	CHECK(eval("([pc_in_slot 2] || [pc_in_slot 3 1])", env) == true);
+
+	// falls back to Tcl for cases where Tcl would behave differently
+	CHECK(eval("[peek 0x10000] == 0", env) == std::nullopt);
+	CHECK(eval("[peek16 0xffff] == 0", env) == std::nullopt);
+	CHECK(eval("1 << 40", env) == std::nullopt);
+}
+
+TEST_CASE("CompiledCondition: unsupported")
+{
+	CHECK(!CompiledCondition("").isValid());
+	CHECK(!CompiledCondition("$x == 1").isValid());
+	CHECK(!CompiledCondition("[reg XY] == 1").isValid());
+	CHECK(!CompiledCondition("[peek 0x10 memory] == 1").isValid());
+	CHECK(!CompiledCondition("[pc_in_slot 0 0 3]").isValid());
+	// the Tcl proc returns "true", only use it as a boolean
+	CHECK(!CompiledCondition("[pc_in_slot 0] == 1").isValid());
+	CHECK(!CompiledCondition("[pc_in_slot 0] + 0").isValid());
+	CHECK(!CompiledCondition("-[pc_in_slot 0]").isValid());
+	CHECK(!CompiledCondition("+[pc_in_slot 0]").isValid());
+	CHECK(!CompiledCondition("[peek [pc_in_slot 0]]").isValid());
+	CHECK(!CompiledCondition("[foo] == 1").isValid());
+	CHECK(!CompiledCondition("010 == 8").isValid()); // octal in Tcl
+	CHECK(!CompiledCondition("1 / 2").isValid());
+	CHECK(!CompiledCondition("1 == 1 extra").isValid());
+	CHECK(!CompiledCondition("(1 == 1").isValid());
+	CHECK(!CompiledCondition("true").isValid());
+	CHECK(!CompiledCondition("\"a\" eq \"a\"").isValid());
+	// too many instructions
+	CHECK(!CompiledCondition("1+1+1+1+1+1+1+1+1+1+1+1+1+1+1+1+1+1+1+1").isValid());
+}
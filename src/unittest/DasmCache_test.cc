@@ -0,0 +1,51 @@
+#include "catch.hpp"
+#include "DasmCache.hh"
+#include <array>
+
+using namespace openmsx;
+
+TEST_CASE("DasmCache")
+{
+	std::array<byte, 0x10000> mem = {};
+	mem[0x4000] = 0x21; mem[0x4001] = 0x34; mem[0x4002] = 0x12; // ld hl,#1234
+	mem[0x4003] = 0x18; mem[0x4004] = 0xFE;                     // jr #4003
+	unsigned peeks = 0;
+	auto peek = [&](word addr) { ++peeks; return mem[addr]; };
+
+	DasmCache cache;
+	const auto& e1 = cache.get(0x4000, peek);
+	CHECK(e1.length == 3);
+	CHECK(e1.bytes[2] == 0x12);
+	CHECK(e1.text.find("1234") != std::string::npos);
+	CHECK(cache.getMisses() == 1);
+
+	// hit: only the bytes of the instruction are compared
+	peeks = 0;
+	CHECK(cache.get(0x4000, peek).length == 3);
+	CHECK(cache.getHits() == 1);
+	CHECK(peeks == 3);
+
+	// the text depends on the address (relative jump)
+	auto jr = cache.get(0x4003, peek).text;
+	CHECK(jr.find("4003") != std::string::npos);
+	mem[0x8003] = 0x18; mem[0x8004] = 0xFE;
+	CHECK(cache.get(0x8003, peek).text.find("8003") != std::string::npos);
+
+	SECTION("memory changed") {
+		mem[0x4002] = 0x56;
+		const auto& e2 = cache.get(0x4000, peek);
+		CHECK(e2.text.find("5634") != std::string::npos);
+		CHECK(cache.getMisses() == 4);
+	}
+	SECTION("same slot in cache, different address") {
+		word other = word(0x4000 + DasmCache::SIZE);
+		CHECK(cache.get(other, peek).length == 1); // nop
+		CHECK(cache.get(0x4000, peek).length == 3);
+		CHECK(cache.getMisses() == 5);
+	}
+	SECTION("clear") {
+		cache.clear();
+		CHECK(cache.get(0x4000, peek).length == 3);
+		CHECK(cache.getMisses() == 4);
+	}
+}
@@ -0,0 +1,81 @@
+#include "catch.hpp"
+#include "DeflateIndex.hh"
+#include "FileException.hh"
+#include "xrange.hh"
+#include <algorithm>
+#include <random>
+#include <vector>
+#include <zlib.h>
+
+using namespace openmsx;
+
+// Somewhat compressible data: random runs of random bytes and repeated
+// fragments of earlier data.
+static std::vector<uint8_t> createData(size_t size)
+{
+	std::mt19937 gen(1234);
+	std::vector<uint8_t> result;
+	while (result.size() < size) {
+		auto r = gen();
+		if (result.empty() || (r & 1)) {
+			repeat(r % 100, [&] { result.push_back(uint8_t(gen())); });
+		} else {
+			auto len = std::min<size_t>((r >> 8) % 300, result.size());
+			auto start = (r >> 16) % (result.size() - len + 1);
+			for (size_t i = 0; i < len; ++i) result.push_back(result[start + i]);
+		}
+	}
+	result.resize(size);
+	return result;
+}
+
+// raw deflate stream, small deflate blocks to get many access points
+static std::vector<uint8_t> compress(const std::vector<uint8_t>& data)
+{
+	z_stream s = {};
+	REQUIRE(deflateInit2(&s, 6, Z_DEFLATED, -MAX_WBITS, 1, Z_DEFAULT_STRATEGY) == Z_OK);
+	std::vector<uint8_t> result(deflateBound(&s, uLong(data.size())));
+	s.next_in = const_cast<uint8_t*>(data.data());
+	s.avail_in = uInt(data.size());
+	s.next_out = result.data();
+	s.avail_out = uInt(result.size());
+	REQUIRE(deflate(&s, Z_FINISH) == Z_STREAM_END);
+	result.resize(s.total_out);
+	deflateEnd(&s);
+	return result;
+}
+
+TEST_CASE("DeflateIndex")
+{
+	auto data = createData(1'000'000);
+	auto compressed = compress(data);
+	DeflateIndex index(compressed, 50'000);
+	CHECK(index.getSize() == data.size());
+	CHECK(index.getNumAccessPoints() > 5);
+
+	auto check = [&](size_t pos, size_t num) {
+		std::vector<uint8_t> buf(num);
+		index.read(pos, buf.data(), num);
+		CHECK(std::equal(buf.begin(), buf.end(), data.begin() + pos));
+	};
+	SECTION("sequential") {
+		for (size_t pos = 0; pos < data.size(); pos += 4096) {
+			check(pos, std::min<size_t>(4096, data.size() - pos));
+		}
+	}
+	SECTION("random") {
+		std::mt19937 gen(4321);
+		for (int i = 0; i < 100; ++i) {
+			size_t pos = gen() % data.size();
+			size_t num = std::min<size_t>(gen() % 200'000, data.size() - pos);
+			check(pos, num);
+		}
+	}
+	SECTION("everything at once") {
+		check(0, data.size());
+	}
+	SECTION("truncated input") {
+		compressed.resize(compressed.size() / 2);
+		CHECK_THROWS_AS(DeflateIndex(compressed), FileException);
+	}
+}
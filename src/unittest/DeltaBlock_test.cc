@@ -0,0 +1,141 @@
+#include "catch.hpp"
+#include "DeltaBlock.hh"
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <vector>
+
+using namespace openmsx;
+
+static std::vector<uint8_t> restore(const DeltaBlock& block, size_t size)
+{
+	std::vector<uint8_t> result(size);
+	block.apply(result.data(), size);
+	return result;
+}
+
+TEST_CASE("DeltaBlock: dirty pages")
+{
+	constexpr size_t PAGE = 256;
+	constexpr size_t SIZE = 100 * PAGE + 17; // last page is partial
+	constexpr size_t NUM_PAGES = (SIZE + PAGE - 1) / PAGE;
+
+	std::mt19937 gen(4321);
+	std::uniform_int_distribution<size_t> addr(0, SIZE - 1);
+	std::uniform_int_distribution<int> val(0, 255);
+	std::uniform_int_distribution<int> count(0, 40);
+
+	std::vector<uint8_t> data(SIZE);
+	for (auto& d : data) d = uint8_t(val(gen));
+	std::vector<bool> dirty(NUM_PAGES, true);
+
+	LastDeltaBlocks lastSparse;
+	LastDeltaBlocks lastDense;
+	std::vector<std::shared_ptr<DeltaBlock>> blocks;
+	std::vector<std::vector<uint8_t>> expected;
+	for (int i = 0; i < 200; ++i) {
+		auto sparse = lastSparse.createNew(data.data(), data.data(), SIZE, dirty, PAGE);
+		auto dense  = lastDense .createNew(data.data(), data.data(), SIZE);
+		REQUIRE(restore(*sparse, SIZE) == data);
+		// same delta, whether or not clean pages are compared
+		auto s = std::dynamic_pointer_cast<DeltaBlockDiff>(sparse);
+		auto d = std::dynamic_pointer_cast<DeltaBlockDiff>(dense);
+		if (s && d) CHECK(s->getDeltaSize() == d->getDeltaSize());
+		blocks.push_back(sparse);
+		expected.push_back(data);
+
+		dirty.assign(NUM_PAGES, false);
+		int n = (i % 10 == 9) ? 0 : count(gen); // sometimes no writes at all
+		for (int j = 0; j < n; ++j) {
+			auto a = addr(gen);
+			data[a] = uint8_t(val(gen));
+			dirty[a / PAGE] = true;
+		}
+		if (n && (i % 7 == 0)) {
+			// also write (the same value) to a neighbouring page
+			auto a = addr(gen);
+			dirty[a / PAGE] = true;
+			if (a + PAGE < SIZE) dirty[a / PAGE + 1] = true;
+		}
+	}
+	// earlier blocks are unaffected by later ones
+	for (size_t i = 0; i < blocks.size(); ++i) {
+		CHECK(restore(*blocks[i], SIZE) == expected[i]);
+	}
+}
+
+TEST_CASE("DeltaBlock: mix with and without dirty info")
+{
+	constexpr size_t PAGE = 64;
+	constexpr size_t SIZE = 64 * PAGE;
+	std::vector<uint8_t> data(SIZE, 0);
+	std::vector<bool> clean(SIZE / PAGE, false);
+	std::vector<bool> dirty(SIZE / PAGE, true);
+
+	LastDeltaBlocks last;
+	auto b1 = last.createNew(data.data(), data.data(), SIZE, dirty, PAGE);
+	data[5] = 1;
+	auto b2 = last.createNew(data.data(), data.data(), SIZE); // no dirty info
+	CHECK(restore(*b2, SIZE) == data);
+	// dirty info says nothing changed since b2
+	auto b3 = last.createNew(data.data(), data.data(), SIZE, clean, PAGE);
+	CHECK(b3 == b2);
+	data[3000] = 2;
+	std::vector<bool> one(SIZE / PAGE, false);
+	one[3000 / PAGE] = true;
+	// change in page 0 (b2) is unknown to the dirty tracking, must still
+	// be included
+	auto b4 = last.createNew(data.data(), data.data(), SIZE, one, PAGE);
+	CHECK(restore(*b4, SIZE) == data);
+	CHECK(restore(*b1, SIZE) == std::vector<uint8_t>(SIZE, 0));
+}
+
+TEST_CASE("DeltaBlock: run lengths and alignment")
+{
+	// Exercise the word-at-a-time scan functions: differing and equal runs
+	// of all lengths around the SIMD word sizes, at different offsets.
+	constexpr size_t SIZE = 4096;
+	std::mt19937 gen(999);
+	std::uniform_int_distribution<int> val(0, 255);
+	for (size_t offset = 0; offset < 4; ++offset) {
+		for (size_t len = 1; len <= 70; ++len) {
+			std::vector<uint8_t> buf(SIZE + offset);
+			for (auto& b : buf) b = uint8_t(val(gen));
+			uint8_t* data = buf.data() + offset;
+
+			LastDeltaBlocks last;
+			auto b1 = last.createNew(data, data, SIZE);
+			auto orig = std::vector<uint8_t>(data, data + SIZE);
+			// 'len' differing bytes, then 'len' equal bytes, ...
+			for (size_t pos = len / 2; pos < SIZE; pos += 2 * len) {
+				for (size_t i = pos; i < std::min(pos + len, SIZE); ++i) {
+					data[i] ^= 1 + (i % 255);
+				}
+			}
+			auto b2 = last.createNew(data, data, SIZE);
+			CHECK(restore(*b2, SIZE) == std::vector<uint8_t>(data, data + SIZE));
+			CHECK(restore(*b1, SIZE) == orig);
+		}
+	}
+}
+
+TEST_CASE("DeltaBlock: memory usage")
+{
+	constexpr size_t SIZE = 4096;
+	std::vector<uint8_t> data(SIZE);
+	for (size_t i = 0; i < SIZE; ++i) data[i] = uint8_t(i * 7 + (i >> 5));
+
+	LastDeltaBlocks last;
+	auto b1 = last.createNew(data.data(), data.data(), SIZE);
+	REQUIRE(std::dynamic_pointer_cast<DeltaBlockCopy>(b1));
+	CHECK(b1->getMemoryUsage() == SIZE);
+
+	data[100] = 0xff;
+	auto b2 = last.createNew(data.data(), data.data(), SIZE);
+	auto d2 = std::dynamic_pointer_cast<DeltaBlockDiff>(b2);
+	REQUIRE(d2);
+	CHECK(d2->getPrev() == b1.get());
+	// only the (small) delta, not the referenced block
+	CHECK(b2->getMemoryUsage() == d2->getDeltaSize());
+	CHECK(b2->getMemoryUsage() < 100);
+}
@@ -4,7 +4,9 @@
 #include "File.hh"
 #include "FileOperations.hh"
 #include "one_of.hh"
+#include "sha1.hh"
 #include "StringOp.hh"
+#include "strCat.hh"
 #include "Timer.hh"
 #include <iostream>
 #include <fstream>
@@ -133,3 +135,91 @@ TEST_CASE("FilePoolCore")
 
 	FileOperations::deleteRecursive(tmp);
 }
+
+// Enough files to need several batches of parallel sha1 calculations.
+TEST_CASE("FilePoolCore: many files")
+{
+	auto tmp = FileOperations::getTempDir() + "/filepool_unittest2";
+	FileOperations::deleteRecursive(tmp);
+	FileOperations::mkdirp(tmp + "/sub");
+	constexpr int NUM = 100;
+	std::vector<Sha1Sum> sums;
+	for (int i = 0; i < NUM; ++i) {
+		auto content = strCat("file number ", i);
+		createFile(strCat(tmp, (i & 1) ? "/sub/" : "/", i), content);
+		sums.push_back(SHA1::calc({reinterpret_cast<const uint8_t*>(content.data()), content.size()}));
+	}
+
+	auto getDirectories = [&] {
+		FilePoolCore::Directories result;
+		result.push_back(FilePoolCore::Dir{tmp, FileType::ROM});
+		return result;
+	};
+	{
+		FilePoolCore pool(tmp + "/cache",
+				  getDirectories,
+				  [](std::string_view) { /* report progress: nothing */});
+		for (int i : {37, 0, 99, 38}) {
+			auto file = pool.getFile(FileType::ROM, sums[i]);
+			CHECK(file.is_open());
+			CHECK(file.getURL() == strCat(tmp, (i & 1) ? "/sub/" : "/", i));
+		}
+		// not present, this indexes all files
+		auto file = pool.getFile(FileType::ROM, Sha1Sum("f36b4825e5db2cf7dd2d2593b3f5c24c0311d8b2"));
+		CHECK(!file.is_open());
+	}
+	CHECK(readLines(tmp + "/cache").size() == NUM);
+
+	FileOperations::deleteRecursive(tmp);
+}
+
+TEST_CASE("FilePoolCore: binary .filecache")
+{
+	auto tmp = FileOperations::getTempDir() + "/filepool_unittest3";
+	FileOperations::deleteRecursive(tmp);
+	auto poolDir = tmp + "/pool"; // don't scan the cache files themselves
+	FileOperations::mkdirp(poolDir);
+	createFile(tmp + "/pool/a", "aaa"); // 7e240de74fb1ed08fa08d38063f6a6a91462a815
+	createFile(tmp + "/pool/b", "bbb"); // 5cb138284d431abd6a053a56625ec088bfb88912
+	Sha1Sum sumA("7e240de74fb1ed08fa08d38063f6a6a91462a815");
+	Sha1Sum sumB("5cb138284d431abd6a053a56625ec088bfb88912");
+
+	auto getDirectories = [&] {
+		FilePoolCore::Directories result;
+		result.push_back(FilePoolCore::Dir{poolDir, FileType::ROM});
+		return result;
+	};
+	auto lookup = [&](const Sha1Sum& sum) {
+		FilePoolCore pool(tmp + "/cache",
+				  getDirectories,
+				  [](std::string_view) { /* report progress: nothing */});
+		return pool.getFile(FileType::ROM, sum).getURL();
+	};
+
+	// creates both the text and the binary version
+	CHECK(lookup(sumB) == tmp + "/pool/b");
+	CHECK(FileOperations::isRegularFile(tmp + "/cache"));
+	CHECK(FileOperations::isRegularFile(tmp + "/cache.bin"));
+	CHECK(!FileOperations::exists(tmp + "/cache.tmp"));
+	CHECK(!FileOperations::exists(tmp + "/cache.bin.tmp"));
+	auto textLines = readLines(tmp + "/cache");
+	CHECK(textLines.size() == 2);
+
+	// read back (from the binary version)
+	CHECK(lookup(sumA) == tmp + "/pool/a");
+	CHECK(readLines(tmp + "/cache") == textLines);
+
+	// corrupt binary version, falls back to the text version
+	createFile(tmp + "/cache.bin", "garbage");
+	CHECK(lookup(sumA) == tmp + "/pool/a");
+	CHECK(lookup(sumB) == tmp + "/pool/b");
+	CHECK(readLines(tmp + "/cache") == textLines);
+
+	// text version changed (e.g. by an older openMSX version): binary
+	// version is ignored
+	createFile(tmp + "/cache", textLines[0] + '\n');
+	CHECK(lookup(sumA) == tmp + "/pool/a");
+	CHECK(readLines(tmp + "/cache").size() == 2);
+
+	FileOperations::deleteRecursive(tmp);
+}
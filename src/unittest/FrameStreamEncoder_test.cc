@@ -0,0 +1,97 @@
+#include "catch.hpp"
+#include "FrameStreamEncoder.hh"
+#include "lz4.hh"
+#include <cstdint>
+#include <vector>
+
+using namespace openmsx;
+
+using Line = std::vector<uint8_t>;
+using Frame = std::vector<Line>;
+
+static unsigned get16(const uint8_t* p) { return p[0] | (p[1] << 8); }
+static unsigned get32(const uint8_t* p) { return get16(p) | (get16(p + 2) << 16); }
+
+// A minimal client: apply a 'V' message to 'frame', returns the number of
+// changed lines.
+static unsigned decode(const std::vector<uint8_t>& msg, Frame& frame)
+{
+	REQUIRE(msg.size() >= 5);
+	CHECK(msg[0] == 'V');
+	CHECK(get32(&msg[1]) == msg.size() - 5);
+	const uint8_t* p = &msg[5];
+	unsigned height = get16(p);
+	unsigned n = get16(p + 2);
+	p += 4;
+	frame.resize(height);
+	const uint8_t* info = p;
+	p += 4 * n;
+	unsigned rawSize = get32(p);
+	p += 4;
+	std::vector<uint8_t> raw(rawSize);
+	if (rawSize) {
+		LZ4::decompress(p, raw.data(), int(msg.data() + msg.size() - p), int(rawSize));
+	}
+	size_t offset = 0;
+	for (unsigned i = 0; i < n; ++i) {
+		unsigned y = get16(info + 4 * i + 0);
+		unsigned w = get16(info + 4 * i + 2);
+		REQUIRE(y < height);
+		REQUIRE(offset + 3 * w <= raw.size());
+		frame[y].assign(raw.begin() + offset, raw.begin() + offset + 3 * w);
+		offset += 3 * w;
+	}
+	CHECK(offset == raw.size());
+	return n;
+}
+
+static std::vector<uint8_t> encode(FrameStreamEncoder& encoder, const Frame& frame)
+{
+	encoder.startFrame(unsigned(frame.size()));
+	for (const auto& line : frame) encoder.addLine(line);
+	return encoder.finishFrame();
+}
+
+TEST_CASE("FrameStreamEncoder: video")
+{
+	Frame frame(8);
+	for (unsigned y = 0; y < 8; ++y) {
+		unsigned w = (y & 1) ? 1 : 256; // border lines are 1 pixel wide
+		frame[y].resize(3 * w);
+		for (unsigned i = 0; i < 3 * w; ++i) frame[y][i] = uint8_t(i * y);
+	}
+
+	FrameStreamEncoder encoder;
+	Frame client;
+	CHECK(decode(encode(encoder, frame), client) == 8); // everything
+	CHECK(client == frame);
+
+	CHECK(decode(encode(encoder, frame), client) == 0); // nothing changed
+	CHECK(client == frame);
+
+	frame[2][10] ^= 1;
+	frame[5].assign(3 * 512, 7); // other width
+	CHECK(decode(encode(encoder, frame), client) == 2);
+	CHECK(client == frame);
+
+	encoder.reset();
+	CHECK(decode(encode(encoder, frame), client) == 8);
+
+	frame.resize(4); // other height: send everything again
+	CHECK(decode(encode(encoder, frame), client) == 4);
+	CHECK(client == frame);
+}
+
+TEST_CASE("FrameStreamEncoder: audio")
+{
+	int16_t samples[] = {0, 1, -1, 0x1234, -0x8000, 0x7fff};
+	auto msg = FrameStreamEncoder::encodeAudio(samples, 2, 44100);
+	REQUIRE(msg.size() == 5 + 6 + 12);
+	CHECK(msg[0] == 'A');
+	CHECK(get32(&msg[1]) == 18);
+	CHECK(get32(&msg[5]) == 44100);
+	CHECK(get16(&msg[9]) == 2);
+	for (unsigned i = 0; i < 6; ++i) {
+		CHECK(int16_t(get16(&msg[11 + 2 * i])) == samples[i]);
+	}
+}
@@ -0,0 +1,67 @@
+#include "catch.hpp"
+#include "GdbPacketParser.hh"
+#include <string>
+#include <vector>
+
+using namespace openmsx;
+using namespace std;
+
+static string packet(string_view payload)
+{
+	string result;
+	GdbPacketParser::appendPacket(result, payload);
+	return result;
+}
+
+TEST_CASE("GdbPacketParser")
+{
+	vector<string> result; // interrupt as "^C", bad checksum as "bad:<payload>"
+	GdbPacketParser parser([&](GdbPacketParser::Kind kind, string_view payload) {
+		switch (kind) {
+		case GdbPacketParser::PACKET:       result.emplace_back(payload); break;
+		case GdbPacketParser::BAD_CHECKSUM: result.push_back("bad:" + string(payload)); break;
+		case GdbPacketParser::INTERRUPT:    result.emplace_back("^C"); break;
+		}
+	});
+	auto parse = [&](const string& stream) { parser.parse(stream.data(), stream.size()); };
+
+	SECTION("packet layout") {
+		CHECK(packet("") == "$#00");
+		CHECK(packet("OK") == "$OK#9a");
+		CHECK(packet("g") == "$g#67");
+		CHECK(packet("a#b") == "$a}\x03" "b#43");
+	}
+	SECTION("acks and interrupts") {
+		parse("+$qSupported:swbreak+#8b+\x03-$?#3f");
+		CHECK(result == vector<string>{"qSupported:swbreak+", "^C", "?"});
+	}
+	SECTION("checksum") {
+		parse("$m0,10#2a$m0,10#2b$m0,10#zz");
+		CHECK(result == vector<string>{"m0,10", "bad:m0,10", "bad:m0,10"});
+	}
+	SECTION("escapes round trip") {
+		string payload = "X0,4:$#}*";
+		parse(packet(payload));
+		CHECK(result == vector<string>{payload});
+	}
+	SECTION("split at every byte") {
+		auto stream = packet("Z0,4000,1") + "+" + packet("c");
+		for (char c : stream) parser.parse(&c, 1);
+		CHECK(result == vector<string>{"Z0,4000,1", "c"});
+	}
+}
+
+TEST_CASE("GdbPacketParser: hex")
+{
+	string s;
+	uint8_t data[] = {0x00, 0x7f, 0xa5, 0xff};
+	GdbPacketParser::appendHex(s, data);
+	CHECK(s == "007fa5ff");
+
+	auto parsed = GdbPacketParser::parseHex("007FA5ff");
+	REQUIRE(parsed);
+	CHECK(*parsed == vector<uint8_t>{0x00, 0x7f, 0xa5, 0xff});
+	CHECK(GdbPacketParser::parseHex("")->empty());
+	CHECK(!GdbPacketParser::parseHex("123"));
+	CHECK(!GdbPacketParser::parseHex("0g"));
+}
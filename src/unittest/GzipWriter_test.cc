@@ -0,0 +1,78 @@
+#include "catch.hpp"
+#include "GzipWriter.hh"
+#include "xrange.hh"
+#include <algorithm>
+#include <random>
+#include <vector>
+#include <zlib.h>
+
+using namespace openmsx;
+
+// Somewhat compressible data: random runs of random bytes and repeated
+// fragments of earlier data.
+static std::vector<uint8_t> createData(size_t size)
+{
+	std::mt19937 gen(1234);
+	std::vector<uint8_t> result;
+	while (result.size() < size) {
+		auto r = gen();
+		if (result.empty() || (r & 1)) {
+			repeat(r % 100, [&] { result.push_back(uint8_t(gen() % 16)); });
+		} else {
+			auto len = std::min<size_t>((r >> 8) % 300, result.size());
+			auto start = (r >> 16) % (result.size() - len + 1);
+			for (size_t i = 0; i < len; ++i) result.push_back(result[start + i]);
+		}
+	}
+	result.resize(size);
+	return result;
+}
+
+static std::vector<uint8_t> gunzip(const std::vector<uint8_t>& input, size_t expectedSize)
+{
+	z_stream s = {};
+	REQUIRE(inflateInit2(&s, 16 + MAX_WBITS) == Z_OK); // gzip header
+	std::vector<uint8_t> result(expectedSize + 100);
+	s.next_in = const_cast<uint8_t*>(input.data());
+	s.avail_in = uInt(input.size());
+	s.next_out = result.data();
+	s.avail_out = uInt(result.size());
+	CHECK(inflate(&s, Z_FINISH) == Z_STREAM_END); // also checks crc and size
+	CHECK(s.avail_in == 0);
+	result.resize(s.total_out);
+	inflateEnd(&s);
+	return result;
+}
+
+TEST_CASE("GzipWriter")
+{
+	// empty, smaller than one block, exactly one block, several blocks
+	for (size_t size : {0, 1, 1000, 128 * 1024, 128 * 1024 + 1, 2'000'000}) {
+		auto data = createData(size);
+		std::vector<uint8_t> compressed;
+		GzipWriter gzip([&](span<const uint8_t> d) {
+			compressed.insert(compressed.end(), d.begin(), d.end());
+		}, 9);
+		// mix of different write sizes
+		std::mt19937 gen(size);
+		size_t pos = 0;
+		while (pos < size) {
+			if (gen() & 3) {
+				auto n = std::min<size_t>(gen() % 70000, size - pos);
+				gzip.write(&data[pos], n);
+				pos += n;
+			} else {
+				gzip.write1(data[pos++]);
+			}
+		}
+		gzip.finish();
+
+		CHECK(gunzip(compressed, size) == data);
+
+		// almost as good as compressing as a single stream
+		auto bound = compressBound(uLong(size));
+		std::vector<uint8_t> single(bound);
+		REQUIRE(compress2(single.data(), &bound, data.data(), uLong(size), 9) == Z_OK);
+		CHECK(compressed.size() <= bound + bound / 100 + 20);
+	}
+}
@@ -0,0 +1,94 @@
+#include "catch.hpp"
+#include "HQCommon.hh"
+#include "build-info.hh"
+#include <cstdint>
+#include <random>
+#include <vector>
+
+using namespace openmsx;
+
+// Straightforward reference implementation, one edge at a time.
+template<typename Pixel, typename EdgeOp>
+static std::vector<uint16_t> refNewEdges(
+	const std::vector<Pixel>& curr, const std::vector<Pixel>& next, EdgeOp edgeOp)
+{
+	unsigned width = unsigned(curr.size());
+	std::vector<uint16_t> result(width);
+	for (unsigned x = 0; x < width; ++x) {
+		unsigned x1 = (x == (width - 1)) ? x : x + 1;
+		uint32_t c5 = readPixel(curr[x]);
+		uint32_t c6 = readPixel(curr[x1]);
+		uint32_t c8 = readPixel(next[x]);
+		uint32_t c9 = readPixel(next[x1]);
+		result[x] = (edgeOp(c5, c8) << 5) | (edgeOp(c5, c9) << 6) |
+		            (edgeOp(c6, c8) << 7) | (edgeOp(c5, c6) << 8);
+	}
+	return result;
+}
+
+// Random pixels, but mostly close to each other so that both sides of the
+// EdgeHQ thresholds are tested.
+template<typename Pixel>
+static std::vector<Pixel> randomLine(std::mt19937& gen, unsigned width)
+{
+	std::uniform_int_distribution<uint32_t> full;
+	std::uniform_int_distribution<int> kind(0, 3);
+	std::uniform_int_distribution<int> delta(-0x30, 0x30);
+	std::vector<Pixel> result(width);
+	uint32_t base = full(gen);
+	for (auto& p : result) {
+		switch (kind(gen)) {
+		case 0: p = Pixel(full(gen)); break;
+		case 1: p = Pixel(base); break;
+		default: {
+			uint32_t c = base;
+			for (int shift : {0, 8, 16}) {
+				int ch = int((c >> shift) & 0xFF) + delta(gen);
+				ch = std::clamp(ch, 0, 255);
+				c = (c & ~(0xFF << shift)) | (uint32_t(ch) << shift);
+			}
+			p = Pixel(c);
+		}
+		}
+	}
+	return result;
+}
+
+template<typename Pixel, typename EdgeOp>
+static void check(EdgeOp edgeOp)
+{
+	std::mt19937 gen(4321);
+	for (unsigned width : {1, 2, 7, 8, 9, 15, 16, 17, 256, 320, 512, 640}) {
+		for (int round = 0; round < 20; ++round) {
+			auto curr = randomLine<Pixel>(gen, width);
+			auto next = randomLine<Pixel>(gen, width);
+			std::vector<uint16_t> actual(width + 1, 0xFFFF);
+			calcNewEdges(curr.data(), next.data(), width, actual.data(), edgeOp);
+			CHECK(actual.back() == 0xFFFF); // no write beyond the end
+			actual.pop_back();
+			CHECK(actual == refNewEdges(curr, next, edgeOp));
+		}
+	}
+}
+
+TEST_CASE("HQCommon: calcNewEdges")
+{
+#if HAVE_32BPP
+	SECTION("32bpp hq") {
+		check<uint32_t>(EdgeHQ(16, 8, 0));
+		check<uint32_t>(EdgeHQ(0, 8, 16));
+		check<uint32_t>(EdgeHQ(24, 16, 8));
+	}
+	SECTION("32bpp hqlite") {
+		check<uint32_t>(EdgeHQLite());
+	}
+#endif
+#if HAVE_16BPP
+	SECTION("16bpp hq") {
+		check<uint16_t>(EdgeHQ(0, 8, 16));
+	}
+	SECTION("16bpp hqlite") {
+		check<uint16_t>(EdgeHQLite());
+	}
+#endif
+}
@@ -0,0 +1,68 @@
+#include "catch.hpp"
+#include "InstructionIndex.hh"
+
+using namespace openmsx;
+
+static EmuTime t(uint64_t n)
+{
+	return EmuTime::zero() + EmuDuration(n);
+}
+
+TEST_CASE("InstructionIndex")
+{
+	InstructionIndex index;
+	CHECK(!index.getPrevious());
+
+	index.record(t(100), 0x4000);
+	index.record(t(110), 0x4001);
+	index.record(t(120), 0x4003);
+	REQUIRE(index.getPrevious());
+	CHECK(*index.getPrevious() == t(120));
+
+	SECTION("step back") {
+		index.truncate(t(120));
+		REQUIRE(index.getPrevious());
+		CHECK(*index.getPrevious() == t(110));
+		index.truncate(t(110));
+		CHECK(*index.getPrevious() == t(100));
+		// the first entry was recorded after a gap
+		index.truncate(t(100));
+		CHECK(!index.getPrevious());
+		CHECK(index.size() == 0);
+	}
+	SECTION("not at the start of an instruction") {
+		index.truncate(t(115));
+		CHECK(!index.getPrevious());
+		CHECK(index.size() == 2);
+	}
+	SECTION("gap") {
+		index.markGap();
+		CHECK(!index.getPrevious());
+		index.record(t(500), 0x0038);
+		CHECK(*index.getPrevious() == t(500));
+		index.record(t(510), 0x0039);
+		index.truncate(t(510));
+		CHECK(*index.getPrevious() == t(500));
+		// don't step over the gap
+		index.truncate(t(500));
+		CHECK(!index.getPrevious());
+		// but the older entries are still valid positions
+		auto e = index.findLast(t(500), [](auto& entry) { return entry.pc == 0x4001; });
+		REQUIRE(e);
+		CHECK(e->time == t(110));
+	}
+	SECTION("findLast") {
+		auto any = [](auto&) { return true; };
+		CHECK(index.findLast(t(120), any)->pc == 0x4001);
+		CHECK(index.findLast(t(121), any)->pc == 0x4003);
+		CHECK(!index.findLast(t(100), any));
+		CHECK(!index.findLast(t(200), [](auto& e) { return e.pc == 0x1234; }));
+	}
+	SECTION("capacity") {
+		for (unsigned i = 0; i < InstructionIndex::CAPACITY; ++i) {
+			index.record(t(1000 + i), 0);
+		}
+		CHECK(index.size() == InstructionIndex::CAPACITY);
+		CHECK(!index.findLast(t(200), [](auto&) { return true; }));
+	}
+}
@@ -0,0 +1,42 @@
+#include "catch.hpp"
+#include "LatencyHistogram.hh"
+
+TEST_CASE("LatencyHistogram: buckets")
+{
+	CHECK(LatencyHistogram::getBucket(0) == 0);
+	CHECK(LatencyHistogram::getBucket(1) == 1);
+	CHECK(LatencyHistogram::getBucket(2) == 2);
+	CHECK(LatencyHistogram::getBucket(3) == 2);
+	CHECK(LatencyHistogram::getBucket(4) == 3);
+	CHECK(LatencyHistogram::getBucket(255) == 8);
+	CHECK(LatencyHistogram::getBucket(256) == 9);
+	CHECK(LatencyHistogram::getBucket(0xFFFFFFFF) == 32);
+}
+
+TEST_CASE("LatencyHistogram: add")
+{
+	LatencyHistogram h;
+	CHECK(h.getCount() == 0);
+	CHECK(h.getMin() == 0);
+	CHECK(h.getMax() == 0);
+
+	h.add(5);
+	h.add(7);
+	h.add(0);
+	h.add(100);
+	CHECK(h.getCount() == 4);
+	CHECK(h.getSum() == 112);
+	CHECK(h.getMin() == 0);
+	CHECK(h.getMax() == 100);
+	const auto& b = h.getBuckets();
+	CHECK(b[0] == 1);
+	CHECK(b[3] == 2); // [4, 8)
+	CHECK(b[7] == 1); // [64, 128)
+
+	h.clear();
+	CHECK(h.getCount() == 0);
+	CHECK(h.getSum() == 0);
+	CHECK(h.getBuckets()[3] == 0);
+	h.add(9);
+	CHECK(h.getMin() == 9);
+}
@@ -0,0 +1,177 @@
+#include "catch.hpp"
+#include "MixerKernels.hh"
+#include "MemBuffer.hh"
+#include <algorithm>
+#include <random>
+#include <tuple>
+#include <vector>
+
+using namespace openmsx;
+using namespace openmsx::MixerKernels;
+
+// Straightforward reference implementations, one sample at a time. These
+// perform the same operations in the same order, so the results must be
+// bit-identical (not only approximately equal).
+
+static void refMulExpand(std::vector<float>& buf, int n, float l, float r)
+{
+	for (int i = n - 1; i >= 0; --i) {
+		auto t = buf[i];
+		buf[2 * i + 0] = l * t;
+		buf[2 * i + 1] = r * t;
+	}
+}
+
+static void refMulExpandAcc(std::vector<float>& acc, const std::vector<float>& mul,
+                            int n, float l, float r)
+{
+	for (int i = 0; i < n; ++i) {
+		acc[2 * i + 0] += l * mul[i];
+		acc[2 * i + 1] += r * mul[i];
+	}
+}
+
+static void refMulMix2Acc(std::vector<float>& acc, const std::vector<float>& mul,
+                          int n, float l1, float l2, float r1, float r2)
+{
+	for (int i = 0; i < n; ++i) {
+		auto t1 = mul[2 * i + 0];
+		auto t2 = mul[2 * i + 1];
+		acc[2 * i + 0] += l1 * t1 + l2 * t2;
+		acc[2 * i + 1] += r1 * t1 + r2 * t2;
+	}
+}
+
+static std::tuple<float, float> refFilter(
+	float tl0, float tr0, const float* inM, const float* inS,
+	std::vector<float>& out, int n)
+{
+	for (int i = 0; i < n; ++i) {
+		auto tl1 = R * tl0;
+		auto tr1 = R * tr0;
+		if (inS) { tl1 += inS[2 * i + 0]; tr1 += inS[2 * i + 1]; }
+		if (inM) { tl1 += inM[i];         tr1 += inM[i]; }
+		out[2 * i + 0] = tl1 - tl0;
+		out[2 * i + 1] = tr1 - tr0;
+		tl0 = tl1;
+		tr0 = tr1;
+	}
+	return {tl0, tr0};
+}
+
+// Aligned buffer with room for 2n+3 floats, like the buffers in
+// MSXMixer::generate(). The (not yet used) tail is filled with a sentinel.
+struct Buffer {
+	static constexpr float SENTINEL = 12345.0f;
+
+	Buffer(const std::vector<float>& init, int n)
+		: buf(2 * n + 3)
+	{
+		std::fill_n(buf.data(), 2 * n + 3, SENTINEL);
+		std::copy(init.begin(), init.end(), buf.data());
+	}
+	[[nodiscard]] std::vector<float> get(int num) const {
+		return std::vector<float>(buf.data(), buf.data() + num);
+	}
+	[[nodiscard]] bool tailUntouched(int num, int n) const {
+		return std::all_of(buf.data() + num, buf.data() + 2 * n + 3,
+		                   [](float f) { return f == SENTINEL; });
+	}
+	MemBuffer<float, SSE_ALIGNMENT> buf;
+};
+
+static std::vector<float> randomSamples(std::mt19937& gen, int num)
+{
+	std::uniform_real_distribution<float> dist(-1.0f, 1.0f);
+	std::vector<float> result(num);
+	for (auto& f : result) f = dist(gen);
+	return result;
+}
+
+TEST_CASE("MixerKernels: mixing")
+{
+	std::mt19937 gen(1234);
+	std::uniform_real_distribution<float> gain(0.0f, 2.0f);
+	for (int n : {1, 2, 3, 4, 5, 7, 8, 9, 31, 32, 33, 441, 735}) {
+		float l1 = gain(gen), l2 = gain(gen), r1 = gain(gen), r2 = gain(gen);
+		auto mono   = randomSamples(gen,     n);
+		auto stereo = randomSamples(gen, 2 * n);
+		auto acc    = randomSamples(gen, 2 * n);
+
+		SECTION("mulExpand") {
+			Buffer b(mono, n);
+			mulExpand(b.buf.data(), n, l1, r1);
+			auto expected = mono;
+			expected.resize(2 * n);
+			refMulExpand(expected, n, l1, r1);
+			CHECK(b.get(2 * n) == expected);
+			CHECK(b.tailUntouched(2 * n, n));
+		}
+		SECTION("mulExpandAcc") {
+			Buffer b(acc, n);
+			Buffer m(mono, n);
+			mulExpandAcc(b.buf.data(), m.buf.data(), n, l1, r1);
+			auto expected = acc;
+			refMulExpandAcc(expected, mono, n, l1, r1);
+			CHECK(b.get(2 * n) == expected);
+			CHECK(b.tailUntouched(2 * n, n));
+		}
+		SECTION("mulMix2") {
+			Buffer b(stereo, n);
+			mulMix2(b.buf.data(), n, l1, l2, r1, r2);
+			std::vector<float> expected(2 * n, 0.0f);
+			refMulMix2Acc(expected, stereo, n, l1, l2, r1, r2);
+			CHECK(b.get(2 * n) == expected);
+			CHECK(b.tailUntouched(2 * n, n));
+		}
+		SECTION("mulMix2Acc") {
+			Buffer b(acc, n);
+			Buffer m(stereo, n);
+			mulMix2Acc(b.buf.data(), m.buf.data(), n, l1, l2, r1, r2);
+			auto expected = acc;
+			refMulMix2Acc(expected, stereo, n, l1, l2, r1, r2);
+			CHECK(b.get(2 * n) == expected);
+			CHECK(b.tailUntouched(2 * n, n));
+		}
+	}
+}
+
+TEST_CASE("MixerKernels: DC filter")
+{
+	std::mt19937 gen(4321);
+	for (int n : {1, 2, 3, 4, 5, 64, 441, 735}) {
+		auto mono   = randomSamples(gen,     n);
+		auto stereo = randomSamples(gen, 2 * n);
+		float tl0 = 0.25f, tr0 = -0.5f;
+		std::vector<float> expected(2 * n);
+		Buffer out({}, n);
+		auto check = [&](std::tuple<float, float> actualT, std::tuple<float, float> expectedT) {
+			CHECK(actualT == expectedT);
+			CHECK(out.get(2 * n) == expected);
+			CHECK(out.tailUntouched(2 * n, n));
+		};
+
+		SECTION("null") {
+			auto e = refFilter(tl0, tr0, nullptr, nullptr, expected, n);
+			check(filterStereoNull(tl0, tr0, out.buf.data(), n), e);
+
+			auto eMono = refFilter(tl0, tl0, nullptr, nullptr, expected, n);
+			check({filterMonoNull(tl0, out.buf.data(), n), std::get<1>(eMono)}, eMono);
+		}
+		SECTION("mono") {
+			auto e = refFilter(tl0, tr0, mono.data(), nullptr, expected, n);
+			check(filterStereoMono(tl0, tr0, mono.data(), out.buf.data(), n), e);
+
+			auto eMono = refFilter(tl0, tl0, mono.data(), nullptr, expected, n);
+			check({filterMonoMono(tl0, mono.data(), out.buf.data(), n), std::get<1>(eMono)}, eMono);
+		}
+		SECTION("stereo") {
+			auto e = refFilter(tl0, tr0, nullptr, stereo.data(), expected, n);
+			check(filterStereoStereo(tl0, tr0, stereo.data(), out.buf.data(), n), e);
+		}
+		SECTION("both") {
+			auto e = refFilter(tl0, tr0, mono.data(), stereo.data(), expected, n);
+			check(filterBothStereo(tl0, tr0, mono.data(), stereo.data(), out.buf.data(), n), e);
+		}
+	}
+}
@@ -0,0 +1,66 @@
+#include "catch.hpp"
+#include "RTScheduler.hh"
+#include "RTSchedulable.hh"
+#include <memory>
+#include <vector>
+
+using namespace openmsx;
+
+namespace {
+	struct TestSchedulable final : RTSchedulable {
+		TestSchedulable(RTScheduler& scheduler_, std::vector<int>& log_, int id_)
+			: RTSchedulable(scheduler_), log(log_), id(id_) {}
+		void executeRT() override { log.push_back(id); }
+		std::vector<int>& log;
+		int id;
+	};
+}
+
+static constexpr uint64_t FAR_AWAY = uint64_t(1000) * 1000 * 1000 * 1000; // us
+
+TEST_CASE("RTScheduler")
+{
+	RTScheduler scheduler;
+	std::vector<int> log;
+	std::vector<std::unique_ptr<TestSchedulable>> s;
+	for (int i = 0; i < 8; ++i) {
+		s.push_back(std::make_unique<TestSchedulable>(scheduler, log, i));
+	}
+	CHECK(!scheduler.getNextDeadline());
+
+	SECTION("expired in order of scheduling") {
+		for (int i : {3, 1, 4, 0, 5, 2}) s[i]->scheduleRT(0);
+		s[6]->scheduleRT(FAR_AWAY);
+		CHECK(scheduler.getNextDeadline());
+		scheduler.execute();
+		CHECK(log == std::vector<int>{3, 1, 4, 0, 5, 2});
+		CHECK(!s[3]->isPendingRT());
+		CHECK(s[6]->isPendingRT());
+	}
+	SECTION("cancel") {
+		for (auto& e : s) e->scheduleRT(0);
+		CHECK(s[0]->cancelRT());
+		CHECK(s[5]->cancelRT());
+		CHECK(s[7]->cancelRT());
+		CHECK(!s[5]->cancelRT()); // not pending anymore
+		CHECK(!s[5]->isPendingRT());
+		CHECK(s[4]->isPendingRT());
+		scheduler.execute();
+		CHECK(log == std::vector<int>{1, 2, 3, 4, 6});
+		CHECK(!scheduler.getNextDeadline());
+	}
+	SECTION("reschedule") {
+		s[0]->scheduleRT(FAR_AWAY);
+		s[1]->scheduleRT(0);
+		s[0]->scheduleRT(0); // replaces the earlier one
+		scheduler.execute();
+		CHECK(log == std::vector<int>{1, 0});
+	}
+	SECTION("destroy while pending") {
+		s[2]->scheduleRT(0);
+		s[3]->scheduleRT(0);
+		s[2].reset();
+		scheduler.execute();
+		CHECK(log == std::vector<int>{3});
+	}
+}
@@ -0,0 +1,127 @@
+#include "catch.hpp"
+#include "SchedulerHeap.hh"
+#include "SchedulerQueue.hh"
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <random>
+#include <vector>
+
+using namespace openmsx;
+
+namespace {
+struct Item {
+	uint64_t time;
+	int id;
+};
+struct LessItem {
+	bool operator()(const Item& x, const Item& y) const { return x.time < y.time; }
+};
+}
+
+static const auto setSentinel = [](Item& i) { i.time = std::numeric_limits<uint64_t>::max(); };
+
+TEST_CASE("SchedulerHeap: same order as SchedulerQueue")
+{
+	std::mt19937 gen(12345);
+	std::uniform_int_distribution<int> op(0, 9);
+	std::uniform_int_distribution<int> delta(0, 20); // many equal times
+	std::uniform_int_distribution<int> dev(0, 15);
+
+	SchedulerQueue<Item> queue;
+	SchedulerHeap<Item, LessItem> heap;
+	uint64_t now = 0;
+	int nextId = 0;
+	for (int i = 0; i < 20000; ++i) {
+		int o = op(gen);
+		if ((o < 5) || queue.empty()) {
+			Item item{now + delta(gen), nextId++};
+			queue.insert(item, setSentinel, LessItem());
+			heap .insert(item, setSentinel, LessItem());
+		} else if (o < 8) {
+			REQUIRE(queue.front().id == heap.front().id);
+			now = queue.front().time;
+			queue.remove_front();
+			heap .remove_front();
+		} else if (o < 9) {
+			// both remove the earliest matching element
+			int d = dev(gen);
+			auto pred = [&](const Item& it) { return (it.id % 16) == d; };
+			CHECK(queue.remove(pred) == heap.remove(pred));
+		} else {
+			int d = dev(gen);
+			auto pred = [&](const Item& it) { return (it.id % 16) == d; };
+			queue.remove_all(pred);
+			heap .remove_all(pred);
+		}
+		REQUIRE(queue.size() == heap.size());
+	}
+	while (!queue.empty()) {
+		REQUIRE(queue.front().id == heap.front().id);
+		queue.remove_front();
+		heap .remove_front();
+	}
+	CHECK(heap.empty());
+}
+
+TEST_CASE("SchedulerHeap: remove the earliest sync point of a device")
+{
+	// device = id % 4, several sync points per device, some with equal times
+	SchedulerHeap<Item, LessItem> heap;
+	static constexpr uint64_t times[] = {50, 10, 40, 30, 10, 20, 50, 60, 20, 40, 30, 10};
+	int id = 0;
+	for (auto t : times) heap.insert(Item{t, id++}, setSentinel, LessItem());
+
+	auto dev = [](int d) { return [d](const Item& it) { return (it.id % 4) == d; }; };
+	auto contains = [&](int i) {
+		for (const auto& it : heap) if (it.id == i) return true;
+		return false;
+	};
+
+	// device 1: ids 1 (t=10), 5 (t=20), 9 (t=40)
+	CHECK(heap.remove(dev(1)));
+	CHECK(!contains(1)); CHECK(contains(5)); CHECK(contains(9));
+	CHECK(heap.remove(dev(1)));
+	CHECK(!contains(5)); CHECK(contains(9));
+
+	// device 2: ids 2 (t=40), 6 (t=50), 10 (t=30)
+	CHECK(heap.remove(dev(2)));
+	CHECK(!contains(10)); CHECK(contains(2)); CHECK(contains(6));
+
+	// device 0: ids 0 (t=50), 4 (t=10), 8 (t=20)
+	CHECK(heap.remove(dev(0)));
+	CHECK(!contains(4)); CHECK(contains(0)); CHECK(contains(8));
+
+	// device 3: ids 3 (t=30), 7 (t=60), 11 (t=10)
+	CHECK(heap.remove(dev(3)));
+	CHECK(!contains(11)); CHECK(contains(3));
+	CHECK(heap.remove(dev(3)));
+	CHECK(!contains(3)); CHECK(contains(7));
+	CHECK(heap.remove(dev(3)));
+	CHECK(!heap.remove(dev(3)));
+
+	// the remaining elements still come out in order
+	std::vector<int> order;
+	while (!heap.empty()) {
+		order.push_back(heap.front().id);
+		heap.remove_front();
+	}
+	CHECK(order == std::vector<int>{8, 2, 9, 0, 6});
+}
+
+TEST_CASE("SchedulerHeap: remove, equal times in insertion order")
+{
+	SchedulerHeap<Item, LessItem> heap;
+	for (int i = 0; i < 8; ++i) heap.insert(Item{100, i}, setSentinel, LessItem());
+	auto even = [](const Item& it) { return (it.id % 2) == 0; };
+	std::vector<int> left = {0, 1, 2, 3, 4, 5, 6, 7};
+	for (int expected : {0, 2, 4, 6}) {
+		REQUIRE(heap.remove(even));
+		left.erase(std::find(left.begin(), left.end(), expected));
+		std::vector<int> ids;
+		for (const auto& it : heap) ids.push_back(it.id);
+		std::sort(ids.begin(), ids.end());
+		CHECK(ids == left);
+	}
+	CHECK(!heap.remove(even));
+}
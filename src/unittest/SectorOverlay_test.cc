@@ -0,0 +1,51 @@
+#include "catch.hpp"
+#include "SectorOverlay.hh"
+#include "xrange.hh"
+#include <cstring>
+
+using namespace openmsx;
+
+static SectorBuffer makeSector(uint8_t value)
+{
+	SectorBuffer buf;
+	memset(buf.raw, value, sizeof(buf.raw));
+	return buf;
+}
+
+TEST_CASE("SectorOverlay")
+{
+	SectorOverlay overlay;
+	CHECK(overlay.empty());
+
+	SectorBuffer bufs[8];
+	auto reset = [&] {
+		for (auto i : xrange(8)) bufs[i] = makeSector(uint8_t(i));
+	};
+
+	// empty overlay changes nothing
+	reset();
+	overlay.apply(bufs, 10, 8);
+	for (auto i : xrange(8)) CHECK(bufs[i].raw[0] == i);
+
+	overlay.write(12, makeSector(100));
+	overlay.write(20, makeSector(101)); // outside the range below
+	overlay.write(10, makeSector(102));
+	CHECK(overlay.size() == 3);
+	CHECK(overlay.contains(12));
+	CHECK(!overlay.contains(11));
+
+	reset();
+	overlay.apply(bufs, 10, 8);
+	CHECK(bufs[0].raw[0] == 102);
+	CHECK(bufs[1].raw[0] == 1);
+	CHECK(bufs[2].raw[0] == 100);
+	CHECK(bufs[2].raw[511] == 100);
+	for (auto i : xrange(3, 8)) CHECK(bufs[i].raw[0] == i);
+
+	// overwriting doesn't add a new entry
+	overlay.write(12, makeSector(103));
+	CHECK(overlay.size() == 3);
+	reset();
+	overlay.apply(bufs + 2, 12, 1);
+	CHECK(bufs[2].raw[0] == 103);
+}
@@ -0,0 +1,77 @@
+#include "catch.hpp"
+#include "StateChangeCodec.hh"
+#include "MSXException.hh"
+
+using namespace openmsx;
+
+namespace {
+	// A state change without compact encoding.
+	struct TestChange final : StateChange {
+		TestChange(EmuTime::param time_, int value_)
+			: StateChange(time_), value(value_) {}
+		int value;
+	};
+}
+
+TEST_CASE("StateChangeCodec: other events")
+{
+	StateChangeCodec::Events events;
+	auto t = EmuTime::zero();
+	events.push_back(std::make_unique<TestChange>(t + EmuDuration(uint64_t(10)), 1));
+	events.push_back(std::make_unique<TestChange>(t + EmuDuration(uint64_t(20)), 2));
+	events.push_back(std::make_unique<TestChange>(t + EmuDuration(uint64_t(20)), 3));
+
+	std::vector<uint8_t> data;
+	std::vector<StateChange*> others;
+	StateChangeCodec::encode(events, data, others);
+	REQUIRE(data.size() == 3); // only the OTHER tags
+	CHECK(data[0] == StateChangeCodec::OTHER);
+	REQUIRE(others.size() == 3);
+	CHECK(others[1] == events[1].get());
+
+	// decode() takes ownership of the 'other' events
+	StateChangeCodec::Events stored = std::move(events);
+	auto decoded = StateChangeCodec::decode(data, stored);
+	CHECK(stored.empty());
+	REQUIRE(decoded.size() == 3);
+	for (int i = 0; i < 3; ++i) {
+		auto* c = dynamic_cast<TestChange*>(decoded[i].get());
+		REQUIRE(c);
+		CHECK(c->value == i + 1);
+	}
+}
+
+TEST_CASE("StateChangeCodec: corrupt data")
+{
+	auto t = EmuTime::zero();
+	StateChangeCodec::Events others;
+	std::vector<uint8_t> data;
+
+	SECTION("missing other event") {
+		data = {StateChangeCodec::OTHER};
+		CHECK_THROWS_AS(StateChangeCodec::decode(data, others), MSXException);
+	}
+	SECTION("unused other event") {
+		others.push_back(std::make_unique<TestChange>(t, 0));
+		data = {};
+		CHECK_THROWS_AS(StateChangeCodec::decode(data, others), MSXException);
+	}
+	SECTION("unknown tag") {
+		data = {200, 0};
+		CHECK_THROWS_AS(StateChangeCodec::decode(data, others), MSXException);
+	}
+}
+
+TEST_CASE("StateChangeCodec: checks")
+{
+	CHECK(StateChangeCodec::checkRange(5, 0, 10) == 5);
+	CHECK_THROWS_AS(StateChangeCodec::checkRange(-1, 0, 10), MSXException);
+	CHECK_THROWS_AS(StateChangeCodec::checkRange(11, 0, 10), MSXException);
+
+	CHECK_NOTHROW(StateChangeCodec::checkPressRelease(0x01, 0x00));
+	CHECK_NOTHROW(StateChangeCodec::checkPressRelease(0x00, 0x80));
+	CHECK_NOTHROW(StateChangeCodec::checkPressRelease(0x0F, 0xF0));
+	CHECK_THROWS_AS(StateChangeCodec::checkPressRelease(0x00, 0x00), MSXException);
+	CHECK_THROWS_AS(StateChangeCodec::checkPressRelease(0x03, 0x01), MSXException);
+	CHECK_THROWS_AS(StateChangeCodec::checkPressRelease(0x100, 0x00), MSXException);
+}
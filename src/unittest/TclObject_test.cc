@@ -5,7 +5,9 @@
 #include <cstdint>
 #include <cstring>
 #include <iterator>
+#include <list>
 #include <string>
+#include <vector>
 
 using namespace openmsx;
 
@@ -156,6 +158,18 @@ TEST_CASE("TclObject, operator=")
 		buf[0] = 99;
 		CHECK(result[0] == 1);
 	}
+	SECTION("allocateBinary") {
+		TclObject t2 = t; // shared
+		auto buf = t.allocateBinary(3);
+		CHECK(buf.size() == 3);
+		buf[0] = 'x'; buf[1] = 0; buf[2] = 'z';
+		auto result = t.getBinary();
+		CHECK(result.size() == 3);
+		CHECK(result.data() == buf.data()); // not copied
+		CHECK(result[1] == 0);
+		CHECK(result[2] == 'z');
+		CHECK(t2.getString() == "123"); // other reference unchanged
+	}
 	SECTION("copy") {
 		TclObject t2(true);
 		REQUIRE(t2.getString() == "1");
@@ -252,6 +266,17 @@ TEST_CASE("TclObject, addListElements")
 		CHECK(t.getListIndex(interp, 8).getString() == "one");
 		CHECK(t.getListIndex(interp, 9).getString() == "2");
 		CHECK(t.getListIndex(interp, 10).getString() == "3.14");
+		// large range, not on the stack
+		std::vector<int> v(5000);
+		for (size_t i = 0; i < v.size(); ++i) v[i] = int(i);
+		t.addListElements(v);
+		CHECK(t.getListLength(interp) == 5011);
+		CHECK(t.getListIndex(interp, 5010).getString() == "4999");
+		// non-random-access range
+		std::list<std::string> l = {"a", "b"};
+		t.addListElements(l);
+		CHECK(t.getListLength(interp) == 5013);
+		CHECK(t.getListIndex(interp, 5012).getString() == "b");
 	}
 	SECTION("error") {
 		TclObject t("{foo"); // invalid list representation
@@ -0,0 +1,126 @@
+#include "catch.hpp"
+#include "YM2413NukeYKT.hh"
+#include <algorithm>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+using namespace openmsx;
+
+// A register log: each register write is followed by a number of samples
+// (at the native 49.7kHz rate) before the next write.
+struct RegWrite {
+	uint8_t reg;
+	uint8_t val;
+	unsigned wait;
+};
+using RegLog = std::vector<RegWrite>;
+
+constexpr unsigned CHANNELS = 9 + 5;
+
+// Somewhat resembles a real tune: all melody instruments (including a custom
+// one), frequency and volume changes, key-on/off and a rhythm section.
+static RegLog createLog()
+{
+	RegLog log;
+	std::mt19937 gen(2413);
+	std::uniform_int_distribution<int> fnum(0x100, 0x1FF);
+	std::uniform_int_distribution<int> block(2, 5);
+	std::uniform_int_distribution<int> instr(0, 15);
+	std::uniform_int_distribution<int> vol(0, 6);
+	auto write = [&](uint8_t reg, uint8_t val, unsigned wait = 2) {
+		log.push_back({reg, val, wait});
+	};
+
+	// custom instrument
+	for (auto [r, v] : {std::pair{0x00, 0x61}, {0x01, 0x61}, {0x02, 0x1E}, {0x03, 0x17},
+	                    {0x04, 0xF0}, {0x05, 0x7F}, {0x06, 0x00}, {0x07, 0x17}}) {
+		write(uint8_t(r), uint8_t(v));
+	}
+	for (int bar = 0; bar < 16; ++bar) {
+		bool rhythm = bar >= 8;
+		int melodyChannels = rhythm ? 6 : 9;
+		for (int ch = 0; ch < melodyChannels; ++ch) {
+			int f = fnum(gen);
+			write(uint8_t(0x20 + ch), 0x00); // key-off
+			write(uint8_t(0x30 + ch), uint8_t((instr(gen) << 4) | vol(gen)));
+			write(uint8_t(0x10 + ch), uint8_t(f));
+			write(uint8_t(0x20 + ch), uint8_t(0x10 | (block(gen) << 1) | (f >> 8)));
+		}
+		if (rhythm) {
+			// drum frequencies and volumes
+			for (auto [r, v] : {std::pair{0x16, 0x20}, {0x26, 0x05}, {0x17, 0x50}, {0x27, 0x05},
+			                    {0x18, 0xC0}, {0x28, 0x01}, {0x36, 0x01},
+			                    {0x37, 0x12}, {0x38, 0x21}}) {
+				write(uint8_t(r), uint8_t(v));
+			}
+		}
+		for (int beat = 0; beat < 4; ++beat) {
+			if (rhythm) {
+				write(0x0E, 0x20); // all drums off
+				write(0x0E, uint8_t(0x20 | (beat & 1 ? 0x0A : 0x11)));
+			}
+			log.back().wait += 6000; // ~1/8 s
+		}
+	}
+	// let everything decay
+	for (int ch = 0; ch < 9; ++ch) write(uint8_t(0x20 + ch), 0x00);
+	write(0x0E, 0x00, 20000);
+	return log;
+}
+
+// Feed the log through the given core, 'blockSize' limits the number of
+// samples generated per generateChannels() call. Returns the amplified sum
+// of all channels.
+static std::vector<float> run(YM2413Core& core, const RegLog& log, unsigned blockSize)
+{
+	unsigned total = 0;
+	for (const auto& w : log) total += w.wait;
+	std::vector<float> result(total);
+	std::vector<float> tmp(CHANNELS * blockSize);
+
+	unsigned pos = 0;
+	for (const auto& w : log) {
+		core.writePort(false, w.reg, 0);
+		core.writePort(true,  w.val, 3);
+		unsigned remaining = w.wait;
+		while (remaining) {
+			unsigned num = std::min(remaining, blockSize);
+			std::fill_n(tmp.data(), CHANNELS * num, 0.0f);
+			float* bufs[CHANNELS];
+			for (unsigned i = 0; i < CHANNELS; ++i) bufs[i] = &tmp[i * num];
+			core.generateChannels(bufs, num);
+			for (unsigned i = 0; i < CHANNELS; ++i) {
+				if (!bufs[i]) continue; // silent channel
+				for (unsigned j = 0; j < num; ++j) {
+					result[pos + j] += bufs[i][j];
+				}
+			}
+			pos += num;
+			remaining -= num;
+		}
+	}
+	float factor = core.getAmplificationFactor();
+	for (auto& s : result) s *= factor;
+	return result;
+}
+
+// Index of the first difference, or -1 when both are equal (comparing the
+// vectors directly would print the full content on failure).
+static ptrdiff_t firstDiff(const std::vector<float>& a, const std::vector<float>& b)
+{
+	REQUIRE(a.size() == b.size());
+	auto [it, _] = std::mismatch(a.begin(), a.end(), b.begin());
+	return (it == a.end()) ? -1 : (it - a.begin());
+}
+
+// Guards optimizations in the (cycle accurate) NukeYKT core: splitting the
+// generation into smaller blocks must not change the output.
+TEST_CASE("YM2413Core: NukeYKT output doesn't depend on the block size")
+{
+	auto log = createLog();
+	YM2413NukeYKT::YM2413 big, small;
+	auto out = run(big, log, 8192);
+	CHECK(firstDiff(out, run(small, log, 7)) == -1);
+	CHECK(std::any_of(out.begin(), out.end(), [](float s) { return s != 0.0f; }));
+}
@@ -117,6 +117,15 @@ TEST_CASE("cb_queue") {
 	q.clear();                 check_queue(q, 8, {});
 }
 
+TEST_CASE("cb_queue, append") {
+	cb_queue<int> q;
+	q.append(vector<int>{});       check_queue(q, 0, {});
+	q.append(vector<int>{1,2,3});  check_queue(q, 4, {1,2,3});
+	CHECK(q.pop_front() == 1);     check_queue(q, 4, {2,3});
+	q.append(vector<int>{4,5});    check_queue(q, 4, {2,3,4,5});
+	q.append(vector<int>(13, 6));  check_queue(q, 32, {2,3,4,5,6,6,6,6,6,6,6,6,6,6,6,6,6});
+}
+
 static void check_queue(
 	const cb_queue<unique_ptr<int>>& q, int expectedCapacity,
 	const vector<int>& expectedElements)
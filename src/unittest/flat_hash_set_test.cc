@@ -0,0 +1,102 @@
+#include "catch.hpp"
+#include "flat_hash_map.hh"
+#include "flat_hash_set.hh"
+#include <algorithm>
+#include <memory>
+#include <random>
+#include <set>
+#include <string>
+#include <vector>
+
+// Also check 'contains()' and iteration, against the expected contents.
+template<typename SET>
+static void check(const SET& s, const std::set<int>& expected)
+{
+	CHECK(s.size() == expected.size());
+	CHECK(s.empty() == expected.empty());
+	for (auto e : expected) CHECK(s.contains(e));
+	std::vector<int> elems(s.begin(), s.end());
+	std::sort(elems.begin(), elems.end());
+	CHECK(elems == std::vector<int>(expected.begin(), expected.end()));
+}
+
+TEST_CASE("flat_hash_set: basics")
+{
+	flat_hash_set<int> s;
+	check(s, {});
+	CHECK(s.capacity() == 0);
+	CHECK(s.find(42) == s.end());
+	CHECK(!s.erase(42));
+
+	CHECK(s.insert(42).second);
+	CHECK(!s.insert(42).second);
+	CHECK(*s.find(42) == 42);
+	CHECK(s.capacity() == 14); // one group
+	check(s, {42});
+
+	for (int i : xrange(100)) s.insert(i);
+	CHECK(s.capacity() >= 100);
+	std::set<int> expected;
+	for (int i : xrange(100)) expected.insert(i);
+	check(s, expected);
+
+	CHECK(s.erase(42));
+	CHECK(!s.erase(42));
+	expected.erase(42);
+	s.erase(s.find(7));
+	expected.erase(7);
+	check(s, expected);
+
+	auto s2 = s; // copy
+	check(s2, expected);
+	auto s3 = std::move(s2);
+	check(s3, expected);
+	s = flat_hash_set<int>{1, 2, 3};
+	check(s, {1, 2, 3});
+
+	auto cap = s3.capacity();
+	s3.clear();
+	check(s3, {});
+	CHECK(s3.capacity() == cap); // keeps its memory
+}
+
+TEST_CASE("flat_hash_set: many inserts and erases")
+{
+	// Erasing leaves tombstones, these must not break lookups or make the
+	// table grow without bounds.
+	std::mt19937 gen(1);
+	std::uniform_int_distribution<int> dist(0, 499);
+	flat_hash_set<int> s;
+	std::set<int> expected;
+	for (int i : xrange(20000)) {
+		auto v = dist(gen);
+		if (i & 1) {
+			CHECK(s.insert(v).second == expected.insert(v).second);
+		} else {
+			CHECK(s.erase(v) == (expected.erase(v) != 0));
+		}
+	}
+	check(s, expected);
+	CHECK(s.capacity() <= 2 * 500);
+}
+
+TEST_CASE("flat_hash_map")
+{
+	flat_hash_map<std::string, std::unique_ptr<int>> m;
+	m.emplace_noDuplicateCheck("one", std::make_unique<int>(1));
+	m["two"] = std::make_unique<int>(2);
+	CHECK(m.insert_or_assign("three", std::make_unique<int>(3)).second);
+	CHECK(!m.insert_or_assign("three", std::make_unique<int>(33)).second);
+	CHECK(m.size() == 3);
+	CHECK(m.contains("one"));
+	CHECK(!m.contains("four"));
+	CHECK(**lookup(m, "one") == 1);
+	CHECK(**lookup(m, "two") == 2);
+	CHECK(**lookup(m, "three") == 33);
+	CHECK(lookup(m, "four") == nullptr);
+
+	// move-only values must survive a rehash
+	for (int i : xrange(100)) m[std::to_string(i)] = std::make_unique<int>(i);
+	for (int i : xrange(100)) CHECK(**lookup(m, std::to_string(i)) == i);
+	CHECK(**lookup(m, "one") == 1);
+}
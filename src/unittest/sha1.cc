@@ -1,6 +1,7 @@
 #include "catch.hpp"
 #include "sha1.hh"
 #include "xrange.hh"
+#include <algorithm>
 #include <cstring>
 #include <sstream>
 
@@ -18,6 +19,7 @@ TEST_CASE("Sha1Sum: constructors")
 		Sha1Sum sum("1234567890123456789012345678901234567890");
 		CHECK(!sum.empty());
 		CHECK(sum.toString() == "1234567890123456789012345678901234567890");
+		CHECK(sum.getPrefix32() == 0x12345678);
 	}
 	SECTION("from string, too short") {
 		CHECK_THROWS(Sha1Sum("123456789012345678901234567890123456789"));
@@ -176,3 +178,19 @@ TEST_CASE("sha1: finalize")
 		CHECK(sum.toString() == "0098ba824b5c16427bd7a1122a5a442a25ec644d");
 	}
 }
+
+TEST_CASE("sha1: update in pieces")
+{
+	// Several blocks per update() call and updates that are not aligned
+	// to blocks (exercises the multi-block code path).
+	uint8_t data[1000];
+	for (auto i : xrange(sizeof(data))) data[i] = uint8_t(i * 7);
+	for (size_t piece : {1, 3, 63, 64, 65, 200, 1000}) {
+		SHA1 sha1;
+		for (size_t pos = 0; pos < sizeof(data); pos += piece) {
+			auto num = std::min(piece, sizeof(data) - pos);
+			sha1.update({&data[pos], num});
+		}
+		CHECK(sha1.digest().toString() == "38f3aa587f4aa04965a359f9151092759b3a4c2a");
+	}
+}
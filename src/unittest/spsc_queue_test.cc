@@ -0,0 +1,59 @@
+#include "catch.hpp"
+#include "spsc_queue.hh"
+#include "xrange.hh"
+#include <thread>
+
+TEST_CASE("spsc_queue: single thread")
+{
+	spsc_queue<int> q(4);
+	CHECK(q.empty());
+	CHECK(q.capacity() == 4);
+	CHECK(q.front() == nullptr);
+
+	CHECK(q.push(1));
+	CHECK(q.push(2));
+	CHECK(q.push(3));
+	CHECK(q.push(4));
+	CHECK(!q.push(5)); // full
+	CHECK(q.size() == 4);
+
+	REQUIRE(q.front() != nullptr);
+	CHECK(*q.front() == 1);
+	q.pop();
+	CHECK(*q.front() == 2);
+	CHECK(q.push(6)); // wraps around
+	q.pop();
+	q.pop();
+	CHECK(*q.front() == 4);
+	q.pop();
+	CHECK(*q.front() == 6);
+	q.pop();
+	CHECK(q.empty());
+
+	CHECK(q.push(7));
+	CHECK(q.push(8));
+	q.clear();
+	CHECK(q.empty());
+	CHECK(q.front() == nullptr);
+}
+
+TEST_CASE("spsc_queue: two threads")
+{
+	constexpr int N = 100000;
+	spsc_queue<int> q(64);
+	std::thread producer([&] {
+		for (auto i : xrange(N)) {
+			while (!q.push(i)) std::this_thread::yield();
+		}
+	});
+	bool inOrder = true;
+	for (auto i : xrange(N)) {
+		int* p;
+		while (!(p = q.front())) std::this_thread::yield();
+		inOrder &= (*p == i);
+		q.pop();
+	}
+	producer.join();
+	CHECK(inOrder);
+	CHECK(q.empty());
+}
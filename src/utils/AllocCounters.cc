@@ -0,0 +1,146 @@
+#include "AllocCounters.hh"
+#include "PerfTimers.hh"
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#ifdef OPENMSX_ALLOC_TRACKING
+#include <cstdlib>
+#include <new>
+#include <thread>
+#endif
+
+namespace openmsx::AllocCounters {
+
+struct Counter {
+	std::atomic<uint64_t> count = 0;
+	std::atomic<uint64_t> bytes = 0;
+};
+static Counter counters[NUM_KINDS];
+
+void add(Kind kind, size_t bytes)
+{
+	assert(kind < NUM_KINDS);
+	// Only statistics, no ordering with other memory operations needed.
+	counters[kind].count.fetch_add(1, std::memory_order_relaxed);
+	counters[kind].bytes.fetch_add(bytes, std::memory_order_relaxed);
+}
+
+Totals get(Kind kind)
+{
+	assert(kind < NUM_KINDS);
+	return {counters[kind].count.load(std::memory_order_relaxed),
+	        counters[kind].bytes.load(std::memory_order_relaxed)};
+}
+
+std::string_view getName(Kind kind)
+{
+	static constexpr std::string_view names[NUM_KINDS] = {
+		"snapshot", "xml"
+	};
+	assert(kind < NUM_KINDS);
+	return names[kind];
+}
+
+
+void* CountingResource::do_allocate(size_t bytes, size_t alignment)
+{
+	add(kind, bytes);
+	return upstream->allocate(bytes, alignment);
+}
+
+void CountingResource::do_deallocate(void* p, size_t bytes, size_t alignment)
+{
+	upstream->deallocate(p, bytes, alignment);
+}
+
+bool CountingResource::do_is_equal(const std::pmr::memory_resource& other) const noexcept
+{
+	return this == &other;
+}
+
+std::pmr::memory_resource* getResource(Kind kind)
+{
+	static CountingResource resources[NUM_KINDS] = {
+		CountingResource(SNAPSHOT),
+		CountingResource(XML),
+	};
+	assert(kind < NUM_KINDS);
+	return &resources[kind];
+}
+
+
+// Counted from within operator new, so these can't allocate themselves and
+// must be usable before any static initialization (zero-initialized). The
+// slots past the end are counted in the last one, that's normally plenty.
+static constexpr unsigned MAX_HEAP_SLOTS = 256;
+static uint64_t heapCounts[MAX_HEAP_SLOTS];
+static std::atomic<uint64_t> otherThreadsHeapCount = 0;
+
+uint64_t getHeapCount(unsigned slot)
+{
+	return heapCounts[std::min(slot, MAX_HEAP_SLOTS - 1)];
+}
+
+uint64_t getOtherThreadsHeapCount()
+{
+	return otherThreadsHeapCount.load(std::memory_order_relaxed);
+}
+
+#ifdef OPENMSX_ALLOC_TRACKING
+static void countHeapAllocation()
+{
+	// The first allocation happens during static initialization, so on
+	// the main thread (Thread::isMainThread() can't be used yet).
+	static std::thread::id mainThread = std::this_thread::get_id();
+	if (std::this_thread::get_id() == mainThread) {
+		++heapCounts[std::min(PerfTimers::getCurrentSlot(), MAX_HEAP_SLOTS - 1)];
+	} else {
+		otherThreadsHeapCount.fetch_add(1, std::memory_order_relaxed);
+	}
+}
+#endif
+
+} // namespace openmsx::AllocCounters
+
+#ifdef OPENMSX_ALLOC_TRACKING
+// Replacements for the global (non-aligned) allocation functions. The aligned
+// variants keep their default implementation, they're hardly used.
+
+void* operator new(std::size_t size)
+{
+	openmsx::AllocCounters::countHeapAllocation();
+	if (size == 0) size = 1;
+	while (true) {
+		if (void* p = std::malloc(size)) return p;
+		auto* handler = std::get_new_handler();
+		if (!handler) throw std::bad_alloc();
+		handler();
+	}
+}
+
+void* operator new[](std::size_t size)
+{
+	return operator new(size);
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept
+{
+	try {
+		return operator new(size);
+	} catch (...) {
+		return nullptr;
+	}
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept
+{
+	return operator new(size, std::nothrow);
+}
+
+void operator delete  (void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete  (void* p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t) noexcept { std::free(p); }
+void operator delete  (void* p, const std::nothrow_t&) noexcept { std::free(p); }
+void operator delete[](void* p, const std::nothrow_t&) noexcept { std::free(p); }
+#endif
@@ -0,0 +1,80 @@
+#ifndef ALLOCCOUNTERS_HH
+#define ALLOCCOUNTERS_HH
+
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <string_view>
+
+/** Counters for the heap allocations of some operations that allocate a lot
+  * (e.g. creating snapshots), to see how much memory they churn through in a
+  * long session.
+  *
+  * Can be used from any thread.
+  */
+namespace openmsx::AllocCounters {
+
+enum Kind : unsigned {
+	SNAPSHOT, // in-memory savestates (reverse snapshots)
+	XML,      // XMLDocument arenas (configs, XML savestates)
+	NUM_KINDS
+};
+
+struct Totals {
+	uint64_t count = 0;
+	uint64_t bytes = 0;
+};
+
+void add(Kind kind, size_t bytes);
+[[nodiscard]] Totals get(Kind kind);
+[[nodiscard]] std::string_view getName(Kind kind);
+
+/** Forwards to the upstream resource, and counts the allocations. */
+class CountingResource final : public std::pmr::memory_resource
+{
+public:
+	explicit CountingResource(
+		Kind kind_,
+		std::pmr::memory_resource* upstream_ = std::pmr::new_delete_resource())
+		: kind(kind_), upstream(upstream_) {}
+
+private:
+	void* do_allocate(size_t bytes, size_t alignment) override;
+	void do_deallocate(void* p, size_t bytes, size_t alignment) override;
+	[[nodiscard]] bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override;
+
+private:
+	const Kind kind;
+	std::pmr::memory_resource* const upstream;
+};
+
+/** One (global) CountingResource per kind, with new/delete as upstream. */
+[[nodiscard]] std::pmr::memory_resource* getResource(Kind kind);
+
+
+/** Heap allocation tracking, only available in builds with
+  * OPENMSX_ALLOC_TRACKING defined (meson option 'alloctracking', or
+  * 'make OPENMSX_ALLOC_TRACKING=true').
+  *
+  * Such builds replace the global operator new. Each allocation on the main
+  * thread is counted in the PerfTimers stage that is active at that moment
+  * (so e.g. 'cpu', 'sound' or 'scheduler:VDP'); the allocations on other
+  * threads are counted together. This is meant to find the allocations that
+  * remain once the emulation runs in a steady state (see
+  * build/alloc_test.tcl), it makes allocating somewhat slower.
+  */
+#ifdef OPENMSX_ALLOC_TRACKING
+inline constexpr bool HEAP_TRACKING = true;
+#else
+inline constexpr bool HEAP_TRACKING = false;
+#endif
+
+/** Number of heap allocations in the given PerfTimers slot since startup.
+  * Always 0 when HEAP_TRACKING is false. */
+[[nodiscard]] uint64_t getHeapCount(unsigned slot);
+/** Same, for all threads except the main thread. */
+[[nodiscard]] uint64_t getOtherThreadsHeapCount();
+
+} // namespace openmsx::AllocCounters
+
+#endif
@@ -1,7 +1,13 @@
 #include "DeltaBlock.hh"
+#include "AllocCounters.hh"
+#include "Math.hh"
+#include "WorkerPool.hh"
+#include "inline.hh"
 #include "likely.hh"
 #include "ranges.hh"
 #include "lz4.hh"
+#include "xrange.hh"
+#include <algorithm>
 #include <cassert>
 #include <cstring>
 #include <tuple>
@@ -12,6 +18,22 @@
 #ifdef __SSE2__
 #include <emmintrin.h>
 #endif
+#ifdef __AVX2__
+#include <immintrin.h>
+#define DELTA_BLOCK_AVX2 1
+#define AVX2_TARGET
+#elif defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+// Not enabled at compile time, but most x86-64 CPUs do have AVX2. So also
+// build AVX2 versions of the scan functions and select them at run time.
+#include <immintrin.h>
+#define DELTA_BLOCK_AVX2 1
+#define DELTA_BLOCK_AVX2_DISPATCH 1
+#define AVX2_TARGET __attribute__((target("avx2")))
+#endif
+#if defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#define DELTA_BLOCK_NEON 1
+#endif
 
 namespace openmsx {
 
@@ -42,7 +64,7 @@ static void storeUleb(std::vector<uint8_t>& result, size_t value)
 }
 
 
-// --- Helper functions to compare {4,8,16} bytes at aligned memory locations ---
+// --- Helper functions to compare {4,8,16,32} bytes at aligned memory locations ---
 
 template<int N> bool comp(const uint8_t* p, const uint8_t* q);
 
@@ -69,11 +91,59 @@ template<> bool comp<16>(const uint8_t* p, const uint8_t* q)
 	__m128i d = _mm_cmpeq_epi8(a, b);
 	return _mm_movemask_epi8(d) == 0xffff;
 }
+#elif defined(DELTA_BLOCK_NEON)
+template<> bool comp<16>(const uint8_t* p, const uint8_t* q)
+{
+	uint8x16_t d = vceqq_u8(vld1q_u8(p), vld1q_u8(q));
+	return vminvq_u8(d) == 0xff;
+}
+#endif
+
+#ifdef DELTA_BLOCK_AVX2
+template<> AVX2_TARGET inline bool comp<32>(const uint8_t* p, const uint8_t* q)
+{
+	// Buffers are only guaranteed to be 16-byte aligned (see below), so
+	// use unaligned loads. On AVX2 capable CPUs these are as fast as
+	// aligned loads when the data happens to be aligned.
+	__m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+	__m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(q));
+	__m256i d = _mm256_cmpeq_epi8(a, b);
+	return _mm256_movemask_epi8(d) == -1;
+}
+
+// One bit per byte, set when the bytes at 'p' and 'q' are equal.
+AVX2_TARGET static inline unsigned equalMask32(const uint8_t* p, const uint8_t* q)
+{
+	__m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+	__m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(q));
+	return unsigned(_mm256_movemask_epi8(_mm256_cmpeq_epi8(a, b)));
+}
 #endif
 
 
 // --- Optimized mismatch function ---
 
+// When AVX2 is available, work with 32-byte words, with SSE2 or NEON with
+// 16-byte words, otherwise 4 or 8 bytes. On x86-64 the AVX2 versions are
+// selected at run time when not already enabled at compile time (see
+// DELTA_BLOCK_AVX2_DISPATCH): not all x86_64 CPUs have AVX2 (all have SSE2).
+constexpr int DEFAULT_WORD_SIZE =
+#if defined(__AVX2__)
+	32;
+#elif defined(__SSE2__) || defined(DELTA_BLOCK_NEON)
+	16;
+#else
+	sizeof(void*);
+#endif
+
+#ifdef DELTA_BLOCK_AVX2_DISPATCH
+[[nodiscard]] static bool hasAvx2()
+{
+	static const bool result = __builtin_cpu_supports("avx2");
+	return result;
+}
+#endif
+
 // This is much like the function std::mismatch(). You pass in two buffers,
 // the corresponding elements of both buffers are compared and the first
 // position where the elements no longer match is returned.
@@ -82,36 +152,34 @@ template<> bool comp<16>(const uint8_t* p, const uint8_t* q)
 // - We make use of sentinels. This requires to temporarily change the content
 //   of the buffer. So it won't work with read-only-memory.
 // - We compare words-at-a-time instead of byte-at-a-time.
-static std::pair<const uint8_t*, const uint8_t*> scan_mismatch(
+//
+// Always inlined, so that in scan_mismatch_avx2() the AVX2 helpers above can
+// be inlined as well.
+template<int WORD_SIZE>
+static ALWAYS_INLINE std::pair<const uint8_t*, const uint8_t*> scan_mismatch_impl(
 	const uint8_t* p, const uint8_t* p_end, const uint8_t* q, const uint8_t* q_end)
 {
 	assert((p_end - p) == (q_end - q));
 
-	// When SSE is available, work with 16-byte words, otherwise 4 or 8
-	// bytes. This routine also benefits from AVX2 instructions. Though not
-	// all x86_64 CPUs have AVX2 (all have SSE2), so using them requires
-	// extra run-time checks and that's not worth it at this point.
-	constexpr int WORD_SIZE =
-#ifdef __SSE2__
-		sizeof(__m128i);
-#else
-		sizeof(void*);
-#endif
+	// Both buffers must have the same alignment relative to this. For
+	// AVX2 this is less than WORD_SIZE: malloc() only guarantees 16-byte
+	// alignment, so requiring 32 would often force the slow path.
+	constexpr int ALIGNMENT = std::min(WORD_SIZE, 16);
 
 	// Region too small or
 	// both buffers are differently aligned.
 	if (unlikely((p_end - p) < (2 * WORD_SIZE)) ||
-	    unlikely((reinterpret_cast<uintptr_t>(p) & (WORD_SIZE - 1)) !=
-	             (reinterpret_cast<uintptr_t>(q) & (WORD_SIZE - 1)))) {
+	    unlikely((reinterpret_cast<uintptr_t>(p) & (ALIGNMENT - 1)) !=
+	             (reinterpret_cast<uintptr_t>(q) & (ALIGNMENT - 1)))) {
 		goto end;
 	}
 
-	// Align to WORD_SIZE boundary. No need for end-of-buffer checks.
-	if (unlikely(reinterpret_cast<uintptr_t>(p) & (WORD_SIZE - 1))) {
+	// Align to ALIGNMENT boundary. No need for end-of-buffer checks.
+	if (unlikely(reinterpret_cast<uintptr_t>(p) & (ALIGNMENT - 1))) {
 		do {
 			if (*p != *q) return {p, q};
 			p += 1; q += 1;
-		} while (reinterpret_cast<uintptr_t>(p) & (WORD_SIZE - 1));
+		} while (reinterpret_cast<uintptr_t>(p) & (ALIGNMENT - 1));
 	}
 
 	// Fast path. Compare words-at-a-time.
@@ -137,6 +205,23 @@ static std::pair<const uint8_t*, const uint8_t*> scan_mismatch(
 end:	return std::mismatch(p, p_end, q);
 }
 
+#ifdef DELTA_BLOCK_AVX2_DISPATCH
+AVX2_TARGET static std::pair<const uint8_t*, const uint8_t*> scan_mismatch_avx2(
+	const uint8_t* p, const uint8_t* p_end, const uint8_t* q, const uint8_t* q_end)
+{
+	return scan_mismatch_impl<32>(p, p_end, q, q_end);
+}
+#endif
+
+static std::pair<const uint8_t*, const uint8_t*> scan_mismatch(
+	const uint8_t* p, const uint8_t* p_end, const uint8_t* q, const uint8_t* q_end)
+{
+#ifdef DELTA_BLOCK_AVX2_DISPATCH
+	if (hasAvx2()) return scan_mismatch_avx2(p, p_end, q, q_end);
+#endif
+	return scan_mismatch_impl<DEFAULT_WORD_SIZE>(p, p_end, q, q_end);
+}
+
 
 // --- Optimized scan_match function ---
 
@@ -146,10 +231,14 @@ end:	return std::mismatch(p, p_end, q);
 // Like scan_mismatch(), this places a temporary sentinel in the buffer, so the
 // buffer cannot be read-only memory.
 //
-// Unlike scan_mismatch() it's less obvious how to perform this function
-// word-at-a-time (it's possible with some bit hacks). Though luckily this
-// function is also less performance critical.
-[[nodiscard]] static constexpr std::pair<const uint8_t*, const uint8_t*> scan_match(
+// With SIMD instructions this can be done word-at-a-time: compare all bytes
+// of a word and search the first set bit in the 'equal' mask. Without SIMD
+// it's less obvious (it's possible with some bit hacks), though luckily this
+// function is also less performance critical: most differing runs are short.
+// (But e.g. the first snapshot after (re)initializing a big RAM does have
+// long runs).
+template<int WORD_SIZE>
+[[nodiscard]] static ALWAYS_INLINE std::pair<const uint8_t*, const uint8_t*> scan_match_impl(
 	const uint8_t* p, const uint8_t* p_end, const uint8_t* q, const uint8_t* q_end)
 {
 	assert((p_end - p) == (q_end - q));
@@ -158,6 +247,48 @@ end:	return std::mismatch(p, p_end, q);
 	//   while ((p != p_end) && (*p != *q)) { ++p; ++q; }
 	//   return {p, q};
 
+#ifdef DELTA_BLOCK_AVX2
+	if constexpr (WORD_SIZE == 32) {
+		while ((p_end - p) >= 32) {
+			if (auto mask = equalMask32(p, q)) {
+				auto n = Math::findFirstSet(mask) - 1;
+				return {p + n, q + n};
+			}
+			p += 32; q += 32;
+		}
+	}
+#endif
+#if defined(__SSE2__)
+	if constexpr (WORD_SIZE == 16) {
+		while ((p_end - p) >= 16) {
+			__m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+			__m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(q));
+			auto mask = unsigned(_mm_movemask_epi8(_mm_cmpeq_epi8(a, b)));
+			if (mask) {
+				auto n = Math::findFirstSet(mask) - 1;
+				return {p + n, q + n};
+			}
+			p += 16; q += 16;
+		}
+	}
+#elif defined(DELTA_BLOCK_NEON)
+	if constexpr (WORD_SIZE == 16) {
+		while ((p_end - p) >= 16) {
+			uint8x16_t d = vceqq_u8(vld1q_u8(p), vld1q_u8(q));
+			if (vmaxvq_u8(d)) {
+				// NEON has no movemask, narrow each byte to a nibble
+				uint64_t mask = vget_lane_u64(vreinterpret_u64_u8(
+					vshrn_n_u16(vreinterpretq_u16_u8(d), 4)), 0);
+				auto lo = Math::findFirstSet(unsigned(mask));
+				auto n = lo ? ((lo - 1) / 4)
+				            : (8 + (Math::findFirstSet(unsigned(mask >> 32)) - 1) / 4);
+				return {p + n, q + n};
+			}
+			p += 16; q += 16;
+		}
+	}
+#endif
+
 	if (p == p_end) return {p, q};
 
 	auto* p_last = const_cast<uint8_t*>(p_end - 1);
@@ -171,6 +302,23 @@ end:	return std::mismatch(p, p_end, q);
 	return {p, q};
 }
 
+#ifdef DELTA_BLOCK_AVX2_DISPATCH
+AVX2_TARGET static std::pair<const uint8_t*, const uint8_t*> scan_match_avx2(
+	const uint8_t* p, const uint8_t* p_end, const uint8_t* q, const uint8_t* q_end)
+{
+	return scan_match_impl<32>(p, p_end, q, q_end);
+}
+#endif
+
+[[nodiscard]] static std::pair<const uint8_t*, const uint8_t*> scan_match(
+	const uint8_t* p, const uint8_t* p_end, const uint8_t* q, const uint8_t* q_end)
+{
+#ifdef DELTA_BLOCK_AVX2_DISPATCH
+	if (hasAvx2()) return scan_match_avx2(p, p_end, q, q_end);
+#endif
+	return scan_match_impl<DEFAULT_WORD_SIZE>(p, p_end, q, q_end);
+}
+
 
 // --- delta (de)compression routines ---
 
@@ -180,43 +328,72 @@ end:	return std::mismatch(p, p_end, q);
 //   n2 number of bytes are different, and here are the bytes
 //   n3 number of bytes are equal
 //   ...
+// Only the bytes within the 'dirty' ranges are compared, all other bytes are
+// known to be equal. Passing the single range [0, size) compares everything.
+// The result doesn't depend on the ranges (as long as all differences are
+// within them).
 [[nodiscard]] static std::vector<uint8_t> calcDelta(
-	const uint8_t* oldBuf, const uint8_t* newBuf, size_t size)
+	const uint8_t* oldBuf, const uint8_t* newBuf, size_t size,
+	const DeltaBlockDiff::Ranges& dirty)
 {
-	std::vector<uint8_t> result;
-
-	const auto* p = oldBuf;
-	const auto* q = newBuf;
-	const auto* p_end = p + size;
-	const auto* q_end = q + size;
+	// Build the delta in a scratch buffer that's reused for all blocks
+	// (of all snapshots), then copy it into an exactly sized result. That's
+	// a single allocation per block, instead of one for each time the
+	// vector grows (plus one for shrink_to_fit()).
+	static thread_local std::vector<uint8_t> scratch;
+	auto& result = scratch;
+	result.clear();
+
+	// Both helpers below only move forward, so they can share 'r'.
+	auto r = dirty.begin();
+	auto skipRanges = [&](size_t pos) {
+		while ((r != dirty.end()) && (r->second <= pos)) ++r;
+	};
+	// offset of the first differing byte at or after 'pos' (or 'size')
+	auto mismatch = [&](size_t pos) {
+		for (skipRanges(pos); r != dirty.end(); ++r) {
+			auto begin = std::max(pos, r->first);
+			auto q = scan_mismatch(oldBuf + begin, oldBuf + r->second,
+			                       newBuf + begin, newBuf + r->second).second;
+			if (q != (newBuf + r->second)) return size_t(q - newBuf);
+		}
+		return size;
+	};
+	// offset of the first equal byte at or after 'pos' (or 'size')
+	auto match = [&](size_t pos) {
+		skipRanges(pos);
+		if ((r == dirty.end()) || (pos < r->first)) return pos; // clean
+		auto q = scan_match(oldBuf + pos, oldBuf + r->second,
+		                    newBuf + pos, newBuf + r->second).second;
+		// ranges are not adjacent: 'r->second' is clean (or 'size')
+		return size_t(q - newBuf);
+	};
 
 	// scan equal bytes (possibly zero)
-	const auto* q1 = q;
-	std::tie(p, q) = scan_mismatch(p, p_end, q, q_end);
-	auto n1 = q - q1;
-	storeUleb(result, n1);
+	size_t pos = mismatch(0);
+	storeUleb(result, pos);
 
-	while (q != q_end) {
-		assert(*p != *q);
+	while (pos != size) {
+		assert(oldBuf[pos] != newBuf[pos]);
 
-		const auto* q2 = q;
+		auto q2 = pos;
 	different:
-		std::tie(p, q) = scan_match(p + 1, p_end, q + 1, q_end);
-		auto n2 = q - q2;
+		pos = match(pos + 1);
+		auto n2 = pos - q2;
 
-		const auto* q3 = q;
-		std::tie(p, q) = scan_mismatch(p, p_end, q, q_end);
-		auto n3 = q - q3;
-		if ((q != q_end) && (n3 <= 2)) goto different;
+		auto q3 = pos;
+		pos = mismatch(pos);
+		auto n3 = pos - q3;
+		if ((pos != size) && (n3 <= 2)) goto different;
 
 		storeUleb(result, n2);
-		result.insert(result.end(), q2, q3);
+		result.insert(result.end(), newBuf + q2, newBuf + q3);
 
 		if (n3 != 0) storeUleb(result, n3);
 	}
 
-	result.shrink_to_fit();
-	return result;
+	AllocCounters::add(AllocCounters::SNAPSHOT, result.size());
+	return std::vector<uint8_t>(result.begin(), result.end());
 }
 
 // Apply a previously calculated 'delta' to 'oldBuf' to get 'newbuf'.
@@ -253,8 +430,10 @@ DeltaBlock::~DeltaBlock()
 
 DeltaBlockCopy::DeltaBlockCopy(const uint8_t* data, size_t size)
 	: block(size)
+	, uncompressedSize(size)
 	, compressedSize(0)
 {
+	AllocCounters::add(AllocCounters::SNAPSHOT, size);
 #ifdef DEBUG
 	sha1 = SHA1::calc({data, size});
 #endif
@@ -270,6 +449,7 @@ DeltaBlockCopy::DeltaBlockCopy(const uint8_t* data, size_t size)
 
 void DeltaBlockCopy::apply(uint8_t* dst, size_t size) const
 {
+	std::lock_guard lock(mutex);
 	if (compressed()) {
 		LZ4::decompress(block.data(), dst, int(compressedSize), int(size));
 	} else {
@@ -280,8 +460,16 @@ void DeltaBlockCopy::apply(uint8_t* dst, size_t size) const
 #endif
 }
 
+size_t DeltaBlockCopy::getMemoryUsage() const
+{
+	std::lock_guard lock(mutex);
+	return compressed() ? compressedSize : uncompressedSize;
+}
+
 void DeltaBlockCopy::compress(size_t size)
 {
+	// Reading 'block' without holding the lock is fine: it's only
+	// modified below, and there's at most one compress() call per block.
 	if (compressed()) return;
 
 	size_t dstLen = LZ4::compressBound(int(size));
@@ -292,9 +480,12 @@ void DeltaBlockCopy::compress(size_t size)
 		// compression isn't beneficial
 		return;
 	}
-	compressedSize = dstLen;
-	block.swap(buf2);
-	block.resize(compressedSize); // shrink to fit
+	{
+		std::lock_guard lock(mutex);
+		compressedSize = dstLen;
+		block.swap(buf2);
+		block.resize(compressedSize); // shrink to fit
+	}
 	assert(compressed());
 #ifdef DEBUG
 	MemBuffer<uint8_t> buf3(size);
@@ -310,6 +501,17 @@ void DeltaBlockCopy::compress(size_t size)
 #endif
 }
 
+void DeltaBlockCopy::compressInBackground(
+	std::shared_ptr<DeltaBlockCopy> block, size_t size)
+{
+	if (block->compressRequested) return;
+	block->compressRequested = true;
+	// the task keeps the block alive until it's compressed
+	WorkerPool::background().post([block = std::move(block), size] {
+		block->compress(size);
+	});
+}
+
 const uint8_t* DeltaBlockCopy::getData()
 {
 	assert(!compressed());
@@ -322,8 +524,15 @@ const uint8_t* DeltaBlockCopy::getData()
 DeltaBlockDiff::DeltaBlockDiff(
 		std::shared_ptr<DeltaBlockCopy> prev_,
 		const uint8_t* data, size_t size)
+	: DeltaBlockDiff(std::move(prev_), data, size, Ranges{{0, size}})
+{
+}
+
+DeltaBlockDiff::DeltaBlockDiff(
+		std::shared_ptr<DeltaBlockCopy> prev_,
+		const uint8_t* data, size_t size, const Ranges& dirty)
 	: prev(std::move(prev_))
-	, delta(calcDelta(prev->getData(), data, size))
+	, delta(calcDelta(prev->getData(), data, size, dirty))
 {
 #ifdef DEBUG
 	sha1 = SHA1::calc({data, size});
@@ -349,6 +558,11 @@ void DeltaBlockDiff::apply(uint8_t* dst, size_t size) const
 #endif
 }
 
+size_t DeltaBlockDiff::getMemoryUsage() const
+{
+	return delta.size();
+}
+
 size_t DeltaBlockDiff::getDeltaSize() const
 {
 	return delta.size();
@@ -357,8 +571,7 @@ size_t DeltaBlockDiff::getDeltaSize() const
 
 // class LastDeltaBlocks
 
-std::shared_ptr<DeltaBlock> LastDeltaBlocks::createNew(
-		const void* id, const uint8_t* data, size_t size)
+LastDeltaBlocks::Info& LastDeltaBlocks::getInfo(const void* id, size_t size)
 {
 	auto it = ranges::lower_bound(infos, std::tuple(id, size), {},
 		[](const Info& info) { return std::tuple(info.id, info.size); });
@@ -368,29 +581,99 @@ std::shared_ptr<DeltaBlock> LastDeltaBlocks::createNew(
 	}
 	assert(it->id   == id);
 	assert(it->size == size);
+	return *it;
+}
 
-	auto ref = it->ref.lock();
-	if (it->accSize >= size || !ref) {
-		if (ref) {
-			// We will switch to a new DeltaBlockCopy object. So
-			// now is a good time to compress the old one.
-			ref->compress(size);
-		}
+std::shared_ptr<DeltaBlock> LastDeltaBlocks::createCopy(
+	Info& info, const uint8_t* data, std::shared_ptr<DeltaBlockCopy> oldRef)
+{
+	if (oldRef) {
+		// We will switch to a new DeltaBlockCopy object. So now is a
+		// good time to compress the old one. Do this on a worker
+		// thread, for large blocks (e.g. a 4MB memory mapper) lz4
+		// takes too long for the main thread.
+		DeltaBlockCopy::compressInBackground(std::move(oldRef), info.size);
+	}
+	auto b = std::make_shared<DeltaBlockCopy>(data, info.size);
+	info.ref = b;
+	info.last = b;
+	info.accSize = 0;
+	info.dirtySinceRef.assign(info.dirtySinceRef.size(), false);
+	info.dirtyValid = info.pageSize != 0;
+	return b;
+}
+
+std::shared_ptr<DeltaBlock> LastDeltaBlocks::createNew(
+		const void* id, const uint8_t* data, size_t size)
+{
+	auto& info = getInfo(id, size);
+
+	auto ref = info.ref.lock();
+	if (info.accSize >= size || !ref) {
 		// Heuristic: create a new block when too many small
 		// differences have accumulated.
-		auto b = std::make_shared<DeltaBlockCopy>(data, size);
-		it->ref = b;
-		it->last = b;
-		it->accSize = 0;
-		return b;
+		info.pageSize = 0; // no (more) dirty info
+		return createCopy(info, data, std::move(ref));
 	} else {
 		// Create diff based on earlier reference block.
 		// Reference remains unchanged.
 		auto b = std::make_shared<DeltaBlockDiff>(ref, data, size);
-		it->last = b;
-		it->accSize += b->getDeltaSize();
+		info.last = b;
+		info.accSize += b->getDeltaSize();
+		info.dirtyValid = false;
+		return b;
+	}
+}
+
+std::shared_ptr<DeltaBlock> LastDeltaBlocks::createNew(
+		const void* id, const uint8_t* data, size_t size,
+		const std::vector<bool>& dirtyPages, size_t pageSize)
+{
+	assert(pageSize != 0);
+	assert(dirtyPages.size() == (size + pageSize - 1) / pageSize);
+	auto& info = getInfo(id, size);
+
+	auto ref = info.ref.lock();
+	if (info.accSize >= size || !ref) {
+		info.pageSize = pageSize;
+		info.dirtySinceRef.resize(dirtyPages.size());
+		return createCopy(info, data, std::move(ref));
+	}
+	if (ranges::none_of(dirtyPages, [](bool b) { return b; })) {
+		if (auto last = info.last.lock()) {
+			// Nothing changed since the previous call.
+#ifdef DEBUG
+			assert(SHA1::calc({data, size}) == last->sha1);
+#endif
+			return last;
+		}
+	}
+	if (!info.dirtyValid || (info.pageSize != pageSize)) {
+		// Can't use the dirty info, till the next reference block.
+		auto b = std::make_shared<DeltaBlockDiff>(ref, data, size);
+		info.last = b;
+		info.accSize += b->getDeltaSize();
+		info.dirtyValid = false;
 		return b;
 	}
+
+	for (auto i : xrange(dirtyPages.size())) {
+		if (dirtyPages[i]) info.dirtySinceRef[i] = true;
+	}
+
+	// Compare only the pages that changed since the reference block was
+	// created (the others are still equal to the reference).
+	DeltaBlockDiff::Ranges dirty;
+	for (size_t i = 0, n = info.dirtySinceRef.size(); i < n; ++i) {
+		if (!info.dirtySinceRef[i]) continue;
+		size_t begin = i * pageSize;
+		while ((i + 1 < n) && info.dirtySinceRef[i + 1]) ++i;
+		dirty.emplace_back(begin, std::min((i + 1) * pageSize, size));
+	}
+	auto b = std::make_shared<DeltaBlockDiff>(ref, data, size, dirty);
+	info.last = b;
+	info.accSize += b->getDeltaSize();
+	return b;
 }
 
 std::shared_ptr<DeltaBlock> LastDeltaBlocks::createNullDiff(
@@ -405,11 +688,7 @@ std::shared_ptr<DeltaBlock> LastDeltaBlocks::createNullDiff(
 
 	auto last = it->last.lock();
 	if (!last) {
-		auto b = std::make_shared<DeltaBlockCopy>(data, size);
-		it->ref = b;
-		it->last = b;
-		it->accSize = 0;
-		return b;
+		return createCopy(*it, data, it->ref.lock());
 	} else {
 #ifdef DEBUG
 		assert(SHA1::calc({data, size}) == last->sha1);
@@ -422,7 +701,7 @@ void LastDeltaBlocks::clear()
 {
 	for (const Info& info : infos) {
 		if (auto ref = info.ref.lock()) {
-			ref->compress(info.size);
+			DeltaBlockCopy::compressInBackground(std::move(ref), info.size);
 		}
 	}
 	infos.clear();
@@ -6,6 +6,8 @@
 #include "MemBuffer.hh"
 #include <cstdint>
 #include <memory>
+#include <mutex>
+#include <utility>
 #include <vector>
 #ifdef DEBUG
 #include "sha1.hh"
@@ -22,6 +24,9 @@ public:
 	virtual ~DeltaBlock() = default;
 #endif
 	virtual void apply(uint8_t* dst, size_t size) const = 0;
+	/** Number of bytes allocated for the data of this block (not
+	  * including the block this one possibly refers to). */
+	[[nodiscard]] virtual size_t getMemoryUsage() const = 0;
 
 protected:
 	DeltaBlock() = default;
@@ -44,24 +49,45 @@ class DeltaBlockCopy final : public DeltaBlock
 public:
 	DeltaBlockCopy(const uint8_t* data, size_t size);
 	void apply(uint8_t* dst, size_t size) const override;
+	[[nodiscard]] size_t getMemoryUsage() const override;
 	void compress(size_t size);
 	[[nodiscard]] const uint8_t* getData();
 
+	/** Compress the block on a background thread (see WorkerPool).
+	  * Until that's finished the block is used uncompressed. Must not
+	  * be used anymore as reference for new DeltaBlockDiff objects. */
+	static void compressInBackground(std::shared_ptr<DeltaBlockCopy> block,
+	                                 size_t size);
+
 private:
 	[[nodiscard]] bool compressed() const { return compressedSize != 0; }
 
 	MemBuffer<uint8_t> block;
+	const size_t uncompressedSize;
 	size_t compressedSize;
+	// Protects 'block' and 'compressedSize' when compress() (possibly on
+	// a worker thread) replaces them while apply() reads them.
+	mutable std::mutex mutex;
+	bool compressRequested = false; // not accessed by the worker thread
 };
 
 
 class DeltaBlockDiff final : public DeltaBlock
 {
 public:
+	// Sorted, non-overlapping, non-adjacent [begin, end) byte ranges.
+	using Ranges = std::vector<std::pair<size_t, size_t>>;
+
 	DeltaBlockDiff(std::shared_ptr<DeltaBlockCopy> prev_,
 	               const uint8_t* data, size_t size);
+	/** Only the bytes within the given ranges can differ from 'prev',
+	  * the rest isn't compared. */
+	DeltaBlockDiff(std::shared_ptr<DeltaBlockCopy> prev_,
+	               const uint8_t* data, size_t size, const Ranges& dirty);
 	void apply(uint8_t* dst, size_t size) const override;
+	[[nodiscard]] size_t getMemoryUsage() const override;
 	[[nodiscard]] size_t getDeltaSize() const;
+	[[nodiscard]] const DeltaBlockCopy* getPrev() const { return prev.get(); }
 
 private:
 	const std::shared_ptr<DeltaBlockCopy> prev;
@@ -74,6 +100,13 @@ class LastDeltaBlocks
 public:
 	[[nodiscard]] std::shared_ptr<DeltaBlock> createNew(
 		const void* id, const uint8_t* data, size_t size);
+	/** Like createNew(), but the caller additionally tells which parts
+	  * of the block possibly changed since the previous call (with the
+	  * same id): one element per 'pageSize' bytes. This avoids comparing
+	  * the clean pages (matters for big blocks with few changes). */
+	[[nodiscard]] std::shared_ptr<DeltaBlock> createNew(
+		const void* id, const uint8_t* data, size_t size,
+		const std::vector<bool>& dirtyPages, size_t pageSize);
 	[[nodiscard]] std::shared_ptr<DeltaBlock> createNullDiff(
 		const void* id, const uint8_t* data, size_t size);
 	void clear();
@@ -88,8 +121,18 @@ private:
 		std::weak_ptr<DeltaBlockCopy> ref;
 		std::weak_ptr<DeltaBlock> last;
 		size_t accSize;
+		// Union of the dirty pages passed since 'ref' was created.
+		// Only meaningful when 'dirtyValid' is set: that's no longer
+		// the case once the block was changed without dirty info.
+		std::vector<bool> dirtySinceRef;
+		size_t pageSize = 0;
+		bool dirtyValid = false;
 	};
 
+	[[nodiscard]] Info& getInfo(const void* id, size_t size);
+	[[nodiscard]] std::shared_ptr<DeltaBlock> createCopy(
+		Info& info, const uint8_t* data, std::shared_ptr<DeltaBlockCopy> oldRef);
+
 	std::vector<Info> infos;
 };
 
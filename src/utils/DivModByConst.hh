@@ -62,6 +62,9 @@ struct Reduce2Result {
 
 [[nodiscard]] static constexpr uint64_t mla64(uint64_t a, uint64_t b, uint64_t c)
 {
+#if defined(__SIZEOF_INT128__) && !defined(_MSC_VER)
+	return (__uint128_t(a) * b + c) >> 64;
+#else
 	// equivalent to this:
 	//    return (__uint128_t(a) * b + c) >> 64;
 	uint64_t t1 = uint64_t(uint32_t(a)) * uint32_t(b);
@@ -74,6 +77,7 @@ struct Reduce2Result {
 	uint64_t s3 = uint64_t(uint32_t(s2)) + uint32_t(t3);
 	uint64_t s4 = (s3 >> 32) + (s2 >> 32) + (t3 >> 32) + t4;
 	return s4;
+#endif
 }
 
 template<uint32_t DIVISOR>
@@ -130,7 +134,7 @@ template<uint32_t DIVISOR> struct DivModByConst
 {
 	[[nodiscard]] constexpr uint32_t div(uint64_t dividend) const
 	{
-	#ifdef __x86_64
+	#if defined(__x86_64) || defined(__aarch64__)
 		// on 64-bit CPUs gcc already does this
 		// optimization (and better)
 		uint64_t result = dividend / DIVISOR;
@@ -147,7 +151,7 @@ template<uint32_t DIVISOR> struct DivModByConst
 
 	[[nodiscard]] constexpr uint32_t mod(uint64_t dividend) const
 	{
-	#ifdef __x86_64
+	#if defined(__x86_64) || defined(__aarch64__)
 		uint64_t result = dividend % DIVISOR;
 	#else
 		uint64_t result = dividend - DIVISOR * div(dividend);
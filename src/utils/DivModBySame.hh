@@ -29,7 +29,9 @@ public:
 
 	[[nodiscard]] uint32_t div(uint64_t dividend) const
 	{
-	#if defined __x86_64 && !defined _MSC_VER
+	#if defined(__SIZEOF_INT128__) && !defined(_MSC_VER)
+		// 64-bit CPUs (x86-64, aarch64, ...) have a 64x64->128 bit
+		// multiply, much faster than divinC()
 		uint64_t t = (__uint128_t(dividend) * m + a) >> 64;
 		return t >> s;
 	#else
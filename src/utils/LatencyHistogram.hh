@@ -0,0 +1,53 @@
+#ifndef LATENCYHISTOGRAM_HH
+#define LATENCYHISTOGRAM_HH
+
+#include "Math.hh"
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <limits>
+
+/** Collects statistics (count, sum, min, max and a logarithmic histogram)
+  * of a series of non-negative integer values, e.g. latencies expressed in
+  * clock cycles.
+  *
+  * Bucket 0 counts the value 0, bucket 'n' (n>0) counts the values in the
+  * range [2^(n-1), 2^n). Adding a value is cheap enough to do for every
+  * emulated event.
+  */
+class LatencyHistogram
+{
+public:
+	static constexpr unsigned NUM_BUCKETS = 33;
+
+	void add(uint32_t value) {
+		++count;
+		sum += value;
+		min = std::min(min, value);
+		max = std::max(max, value);
+		++buckets[getBucket(value)];
+	}
+
+	void clear() { *this = LatencyHistogram(); }
+
+	[[nodiscard]] uint64_t getCount() const { return count; }
+	[[nodiscard]] uint64_t getSum() const { return sum; }
+	[[nodiscard]] uint32_t getMin() const { return count ? min : 0; }
+	[[nodiscard]] uint32_t getMax() const { return max; }
+	[[nodiscard]] const std::array<uint64_t, NUM_BUCKETS>& getBuckets() const {
+		return buckets;
+	}
+
+	[[nodiscard]] static constexpr unsigned getBucket(uint32_t value) {
+		return value ? (32 - Math::countLeadingZeros(value)) : 0;
+	}
+
+private:
+	std::array<uint64_t, NUM_BUCKETS> buckets = {};
+	uint64_t count = 0;
+	uint64_t sum = 0;
+	uint32_t min = std::numeric_limits<uint32_t>::max();
+	uint32_t max = 0;
+};
+
+#endif
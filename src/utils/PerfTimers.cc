@@ -0,0 +1,84 @@
+#include "PerfTimers.hh"
+#include "Timer.hh"
+#include "StringOp.hh"
+#include "ranges.hh"
+#include <cassert>
+#ifdef __GNUC__
+#include <cstdlib>
+#include <cxxabi.h>
+#endif
+
+namespace openmsx::PerfTimers {
+
+// To convert ticks to seconds: compare with the elapsed real time.
+static const uint64_t startTicks = detail::now();
+static const uint64_t startTime = Timer::getTime();
+
+static std::vector<std::string> names = {
+	"other", "cpu", "vdp_render", "sound", "postprocess", "osd", "tcl",
+	"config", "rom_load", "filepool", "video_init", "audio_init"
+};
+static std::vector<std::pair<const std::type_info*, unsigned>> types;
+
+[[nodiscard]] static std::string getTypeName(const std::type_info& type)
+{
+	std::string result;
+#ifdef __GNUC__
+	int status = 0;
+	if (char* demangled = abi::__cxa_demangle(type.name(), nullptr, nullptr, &status)) {
+		result = demangled;
+		free(demangled);
+	}
+#endif
+	if (result.empty()) result = type.name();
+	// remove 'class ' and 'openmsx::' (MSVC style names)
+	std::string_view name = result;
+	if (StringOp::startsWith(name, "class ")) name.remove_prefix(6);
+	if (StringOp::startsWith(name, "openmsx::")) name.remove_prefix(9);
+	return std::string(name);
+}
+
+unsigned getSchedulableSlot(const std::type_info& type)
+{
+	if (auto it = ranges::find_if(types, [&](auto& p) { return *p.first == type; });
+	    it != end(types)) {
+		return it->second;
+	}
+	auto slot = unsigned(names.size());
+	names.push_back("scheduler:" + getTypeName(type));
+	detail::state.ticks.push_back(0);
+	types.emplace_back(&type, slot);
+	return slot;
+}
+
+std::vector<std::pair<std::string, double>> getTimes()
+{
+	detail::switchTo(detail::state.current); // account the running stage
+	auto& ticks = detail::state.ticks;
+	assert(ticks.size() == names.size());
+
+	auto elapsedTicks = detail::state.last - startTicks;
+	auto elapsedTime = Timer::getTime() - startTime;
+	double secondsPerTick = elapsedTicks
+		? (double(elapsedTime) / 1e6) / double(elapsedTicks)
+		: 0.0;
+
+	std::vector<std::pair<std::string, double>> result;
+	for (size_t i = 0; i < ticks.size(); ++i) {
+		result.emplace_back(names[i], double(ticks[i]) * secondsPerTick);
+	}
+	return result;
+}
+
+unsigned getNumSlots()
+{
+	return unsigned(names.size());
+}
+
+const std::string& getName(unsigned slot)
+{
+	assert(slot < names.size());
+	return names[slot];
+}
+
+} // namespace openmsx::PerfTimers
@@ -0,0 +1,98 @@
+#ifndef PERFTIMERS_HH
+#define PERFTIMERS_HH
+
+#include <cstdint>
+#include <string>
+#include <typeinfo>
+#include <utility>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define PERFTIMERS_TSC 1
+#elif defined(_M_X64) || defined(_M_IX86)
+#include <intrin.h>
+#define PERFTIMERS_TSC 1
+#else
+#include <chrono>
+#endif
+
+/** Always enabled timers for the main (per-frame) stages of the emulation:
+  * CPU emulation, device callbacks from the Scheduler (one slot per
+  * Schedulable type), VDP rendering, sound generation, post-processing,
+  * OSD and Tcl scripts.
+  *
+  * The measured times are exclusive: entering a nested stage pauses the
+  * enclosing one. So e.g. the device callbacks are not also counted as CPU
+  * time. Switching stages only reads the time stamp counter (on x86) and
+  * does an addition, so this is cheap enough to be always active.
+  *
+  * Can only be used from the main thread.
+  */
+namespace openmsx::PerfTimers {
+
+// fixed slots, the Schedulable types are added after these
+enum Stage : unsigned {
+	OTHER, // not in any of the stages below (e.g. waiting, event handling)
+	CPU, VDP_RENDER, SOUND, POSTPROCESS, OSD, TCL,
+	// mostly during startup (and when switching machines), see
+	// the '-startup-profile' command line option
+	CONFIG, ROM_LOAD, FILEPOOL, VIDEO_INIT, AUDIO_INIT,
+	NUM_STAGES
+};
+
+namespace detail {
+	[[nodiscard]] inline uint64_t now()
+	{
+#ifdef PERFTIMERS_TSC
+		return __rdtsc();
+#else
+		return std::chrono::steady_clock::now().time_since_epoch().count();
+#endif
+	}
+
+	struct State {
+		std::vector<uint64_t> ticks = std::vector<uint64_t>(NUM_STAGES);
+		uint64_t last = now();
+		unsigned current = OTHER;
+	};
+	inline State state;
+
+	// returns the previous stage
+	inline unsigned switchTo(unsigned slot)
+	{
+		auto t = now();
+		auto& s = state;
+		s.ticks[s.current] += t - s.last;
+		s.last = t;
+		return std::exchange(s.current, slot);
+	}
+}
+
+/** Get the slot for the given dynamic type of a Schedulable. */
+[[nodiscard]] unsigned getSchedulableSlot(const std::type_info& type);
+
+/** Total (exclusive) time per slot, in seconds, since startup. */
+[[nodiscard]] std::vector<std::pair<std::string, double>> getTimes();
+
+/** Number of slots so far and the name of a slot (as in getTimes()). */
+[[nodiscard]] unsigned getNumSlots();
+[[nodiscard]] const std::string& getName(unsigned slot);
+
+/** The slot of the stage that's currently running. */
+[[nodiscard]] inline unsigned getCurrentSlot() { return detail::state.current; }
+
+/** Measures the lifetime of this object. */
+class Scope {
+public:
+	explicit Scope(unsigned slot) : prev(detail::switchTo(slot)) {}
+	~Scope() { detail::switchTo(prev); }
+	Scope(const Scope&) = delete;
+	Scope& operator=(const Scope&) = delete;
+private:
+	unsigned prev;
+};
+
+} // namespace openmsx::PerfTimers
+
+#endif
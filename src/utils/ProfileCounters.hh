@@ -29,7 +29,8 @@ template<typename E> std::ostream& operator<<(std::ostream& os, EnumValueName<E>
 
 // A collection of (simple) profile counters:
 // - Counters start at zero.
-// - An individual counter can be incremented by 1 via 'tick(<counter-id>)'.
+// - An individual counter can be incremented by 1 via 'tick(<counter-id>)'
+//   (or by 'n' via 'tick(<counter-id>, n)').
 // - When this 'ProfileCounters' object is destoyed it prints the value of each
 //   counter.
 //
@@ -98,6 +99,9 @@ public:
 	void tick(ENUM e) const {
 		++counters[size_t(e)];
 	}
+	void tick(ENUM e, unsigned n) const {
+		counters[size_t(e)] += n;
+	}
 
 private:
 	static constexpr auto NUM = size_t(ENUM::NUM); // value 'ENUM::NUM' must exist
@@ -112,6 +116,7 @@ class ProfileCounters<false, ENUM>
 {
 public:
 	void tick(ENUM) const { /*nothing*/ }
+	void tick(ENUM, unsigned) const { /*nothing*/ }
 };
 
 #endif
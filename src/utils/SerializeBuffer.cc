@@ -1,4 +1,5 @@
 #include "SerializeBuffer.hh"
+#include "AllocCounters.hh"
 #include "likely.hh"
 #include <cstdlib>
 #include <utility>
@@ -26,6 +27,8 @@ OutputBuffer::OutputBuffer()
 	// high value. For performance an overestimation is less bad than an
 	// underestimation.
 	lastSize -= lastSize >> 7;
+
+	AllocCounters::add(AllocCounters::SNAPSHOT, finish - buf.data());
 }
 
 #ifdef __GNUC__
@@ -73,6 +76,7 @@ void OutputBuffer::grow(size_t len)
 	size_t oldSize = end - buf.data();
 	size_t newSize = std::max(oldSize + len, oldSize + oldSize / 2);
 	buf.resize(newSize);
+	AllocCounters::add(AllocCounters::SNAPSHOT, newSize);
 	end    = buf.data() + oldSize;
 	finish = buf.data() + newSize;
 }
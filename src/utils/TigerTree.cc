@@ -95,7 +95,10 @@ const TigerHash& TigerTree::calcHash(Node node, const std::function<void(size_t,
 			size_t l = dataSize - b;
 
 			if (l >= BLOCK_SIZE) {
-				auto* d = data.getData(b, BLOCK_SIZE);
+				// tiger_leaf() only uses the first 1024 bytes of
+				// the block, no need to fetch the rest (for a big
+				// harddisk image this is a lot less I/O).
+				auto* d = data.getData(b, 1024);
 				tiger_leaf(d, entry.hash[n]);
 			} else {
 				// partial last block
@@ -115,6 +118,43 @@ const TigerHash& TigerTree::calcHash(Node node, const std::function<void(size_t,
 	return entry.hash[n];
 }
 
+// Format: numNodes (as uint64_t), 'numNodes' valid flags (one byte each),
+// 'numNodes' hashes. Native byte order, that's fine for a local cache.
+std::vector<uint8_t> TigerTree::saveState() const
+{
+	auto n = entry.numNodes;
+	std::vector<uint8_t> result(sizeof(uint64_t) + n + n * sizeof(TigerHash));
+	auto n64 = uint64_t(n);
+	memcpy(result.data(), &n64, sizeof(n64));
+	auto* p = result.data() + sizeof(n64);
+	for (size_t i = 0; i < n; ++i) p[i] = entry.valid[i];
+	memcpy(p + n, entry.hash.data(), n * sizeof(TigerHash));
+	return result;
+}
+
+bool TigerTree::loadState(span<const uint8_t> state, time_t time)
+{
+	auto n = entry.numNodes;
+	if (state.size() != (sizeof(uint64_t) + n + n * sizeof(TigerHash))) return false;
+	uint64_t n64;
+	memcpy(&n64, state.data(), sizeof(n64));
+	if (n64 != n) return false;
+
+	const auto* p = state.data() + sizeof(n64);
+	size_t numValid = 0;
+	for (size_t i = 0; i < n; ++i) {
+		if (p[i] > 1) return false;
+		numValid += p[i];
+	}
+	if (numValid <= entry.numNodesValid) return false;
+
+	for (size_t i = 0; i < n; ++i) entry.valid[i] = p[i] != 0;
+	memcpy(entry.hash.data(), p + n, n * sizeof(TigerHash));
+	entry.numNodesValid = numValid;
+	entry.time = time;
+	return true;
+}
+
 
 // The TigerTree::nodes member variable stores a linearized binary tree. The
 // linearization is done like in this example:
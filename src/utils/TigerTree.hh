@@ -28,10 +28,12 @@
 #ifndef TIGERTREE_HH
 #define TIGERTREE_HH
 
+#include "span.hh"
 #include <string>
 #include <cstdint>
 #include <ctime>
 #include <functional>
+#include <vector>
 
 namespace openmsx {
 
@@ -90,6 +92,20 @@ public:
 	 */
 	void notifyChange(size_t offset, size_t len, time_t time);
 
+	/** Get the (partially) calculated tree as a block of bytes, so that
+	 * it can be stored and restored in a later session with loadState().
+	 * The result can only be used for data of the same size.
+	 */
+	[[nodiscard]] std::vector<uint8_t> saveState() const;
+
+	/** Restore a state obtained with saveState(). The caller must make
+	 * sure it belongs to the exact same data (e.g. via the file's
+	 * modification time). Nothing changes when the state is invalid or
+	 * when it contains less calculated nodes than the current tree.
+	 * @return Was the state restored?
+	 */
+	bool loadState(span<const uint8_t> state, time_t time);
+
 private:
 	// functions to navigate in binary tree
 	struct Node {
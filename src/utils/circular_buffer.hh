@@ -362,6 +362,14 @@ public:
 		for (auto& e : list) push_back(e);
 	}
 
+	/** Append all elements of the given range. The buffer grows (at most)
+	  * once, instead of checking the capacity for every element. */
+	template<typename Range>
+	void append(const Range& range) {
+		checkGrow(size_t(std::distance(std::begin(range), std::end(range))));
+		for (const auto& e : range) buf.push_back(e);
+	}
+
 	T pop_front() {
 		T t = std::move(buf.front());
 		buf.pop_front();
@@ -389,9 +397,11 @@ public:
 	[[nodiscard]] auto& getBuffer() const { return buf; }
 
 private:
-	void checkGrow() {
-		if (buf.full()) {
-			buf.set_capacity(std::max(size_t(4), buf.capacity() * 2));
+	void checkGrow(size_t extra = 1) {
+		if (buf.reserve() < extra) {
+			auto newCapacity = std::max(size_t(4), buf.capacity() * 2);
+			while ((newCapacity - buf.size()) < extra) newCapacity *= 2;
+			buf.set_capacity(newCapacity);
 		}
 	}
 
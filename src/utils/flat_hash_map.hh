@@ -0,0 +1,98 @@
+// flat_hash_map
+//
+// The open addressing variant of hash_map, see flat_hash_set.
+
+#ifndef FLAT_HASH_MAP_HH
+#define FLAT_HASH_MAP_HH
+
+#include "flat_hash_set.hh"
+
+namespace flat_hash_set_impl {
+
+// Takes any (const or non-const) pair reference and returns a reference to
+// the first element of the pair.
+struct ExtractFirst {
+	template<typename Pair> [[nodiscard]] auto& operator()(Pair&& p) const { return p.first; }
+};
+
+} // namespace flat_hash_set_impl
+
+
+// flat_hash_map
+//
+// A hash-map with the same interface as hash_map. Though (as for
+// flat_hash_set) inserting may move the existing elements around in memory.
+template<typename Key,
+         typename Value,
+         typename Hasher = std::hash<Key>,
+         typename Equal = std::equal_to<>>
+class flat_hash_map : public flat_hash_set<std::pair<Key, Value>, flat_hash_set_impl::ExtractFirst, Hasher, Equal>
+{
+	using BaseType = flat_hash_set<std::pair<Key, Value>, flat_hash_set_impl::ExtractFirst, Hasher, Equal>;
+public:
+	using key_type    = Key;
+	using mapped_type = Value;
+	using value_type  = std::pair<Key, Value>;
+	using       iterator = typename BaseType::      iterator;
+	using const_iterator = typename BaseType::const_iterator;
+
+	explicit flat_hash_map(unsigned initialSize = 0,
+	         Hasher hasher_ = Hasher(),
+	         Equal equal_ = Equal())
+		: BaseType(initialSize, flat_hash_set_impl::ExtractFirst(), hasher_, equal_)
+	{
+	}
+
+	flat_hash_map(std::initializer_list<std::pair<Key, Value>> list)
+		: BaseType(list)
+	{
+	}
+
+	template<typename K>
+	[[nodiscard]] Value& operator[](K&& key)
+	{
+		auto it = this->find(key);
+		if (it == this->end()) {
+			auto p = this->insert(value_type(std::forward<K>(key), Value()));
+			it = p.first;
+		}
+		return it->second;
+	}
+
+	template<typename K, typename V>
+	std::pair<iterator, bool> insert_or_assign(K&& key, V&& value)
+	{
+		auto it = this->find(key);
+		if (it == this->end()) {
+			// insert, return pair<iterator, true>
+			return this->insert(value_type(std::forward<K>(key), std::forward<V>(value)));
+		} else {
+			// assign, return pair<iterator, false>
+			it->second = std::forward<V>(value);
+			return std::pair(it, false);
+		}
+	}
+
+	template<typename K>
+	[[nodiscard]] bool contains(const K& k) const
+	{
+		return this->find(k) != this->end();
+	}
+};
+
+
+template<typename Key, typename Value, typename Hasher, typename Equal, typename Key2>
+[[nodiscard]] const Value* lookup(const flat_hash_map<Key, Value, Hasher, Equal>& map, const Key2& key)
+{
+	auto it = map.find(key);
+	return (it != map.end()) ? &it->second : nullptr;
+}
+
+template<typename Key, typename Value, typename Hasher, typename Equal, typename Key2>
+[[nodiscard]] Value* lookup(flat_hash_map<Key, Value, Hasher, Equal>& map, const Key2& key)
+{
+	auto it = map.find(key);
+	return (it != map.end()) ? &it->second : nullptr;
+}
+
+#endif
@@ -0,0 +1,650 @@
+// flat_hash_set
+//
+// An open addressing variant of hash_set, the design is based on the "Swiss
+// tables" from Google's abseil library.
+
+#ifndef FLAT_HASH_SET_HH
+#define FLAT_HASH_SET_HH
+
+#include "Math.hh"
+#include "xrange.hh"
+#include <cassert>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <initializer_list>
+#include <iterator>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace flat_hash_set_impl {
+
+// Identity operation: accepts any type (by const or non-const reference) and
+// returns the exact same (reference) value.
+struct Identity {
+	template<typename T>
+	[[nodiscard]] inline T& operator()(T&& t) const { return t; }
+};
+
+// Each slot in the table has one control byte:
+// - 0b0xxxxxxx: the slot holds an element, xxxxxxx are 7 bits of its hash
+// - EMPTY:      the slot was never used (since the last rehash)
+// - DELETED:    the slot held an element that was erased (a tombstone)
+using ctrl_t = int8_t;
+constexpr ctrl_t EMPTY   = -128; // 0b10000000
+constexpr ctrl_t DELETED = -2;   // 0b11111110
+
+// The table is divided in groups of this many slots. The control bytes of one
+// group are checked in parallel (with one SSE2 instruction).
+constexpr unsigned GROUP_SIZE = 16;
+
+// The control bytes of one group. The match functions return a bitmask with
+// one bit per slot in the group (bit 'i' for slot 'i').
+class Group {
+public:
+	explicit Group(const ctrl_t* p)
+	{
+#ifdef __SSE2__
+		ctrl = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+#else
+		memcpy(ctrl, p, GROUP_SIZE);
+#endif
+	}
+
+	[[nodiscard]] unsigned match(ctrl_t c) const
+	{
+#ifdef __SSE2__
+		return _mm_movemask_epi8(_mm_cmpeq_epi8(ctrl, _mm_set1_epi8(c)));
+#else
+		unsigned result = 0;
+		for (auto i : xrange(GROUP_SIZE)) {
+			result |= unsigned(ctrl[i] == c) << i;
+		}
+		return result;
+#endif
+	}
+
+	[[nodiscard]] unsigned matchEmpty() const
+	{
+		return match(EMPTY);
+	}
+
+	[[nodiscard]] unsigned matchEmptyOrDeleted() const
+	{
+#ifdef __SSE2__
+		// both have the sign bit set, full slots don't
+		return _mm_movemask_epi8(ctrl);
+#else
+		unsigned result = 0;
+		for (auto i : xrange(GROUP_SIZE)) {
+			result |= unsigned(ctrl[i] < 0) << i;
+		}
+		return result;
+#endif
+	}
+
+private:
+#ifdef __SSE2__
+	__m128i ctrl;
+#else
+	ctrl_t ctrl[GROUP_SIZE];
+#endif
+};
+
+// Type-alias for the resulting type of applying Extractor on Value.
+template<typename Value, typename Extractor>
+using ExtractedType =
+	typename std::remove_cv<
+		typename std::remove_reference<
+			decltype(std::declval<Extractor>()(std::declval<Value>()))>
+		::type>
+	::type;
+
+} // namespace flat_hash_set_impl
+
+
+// flat_hash_set
+//
+// A hash-set with (mostly) the same interface as hash_set, see there for the
+// meaning of the template parameters.
+//
+// The elements are stored directly in the hash table (open addressing), so a
+// lookup typically touches only two cache lines: one with the control bytes
+// (see above) and the one with the element. For each element the control
+// bytes also hold 7 bits of its hash, for 16 slots at once these are compared
+// to the hash of the key that's looked up. Only for matching slots the (more
+// expensive) Equal functor is called.
+//
+// Compared to hash_set:
+// - Inserting or erasing elements may move the other elements around in
+//   memory (like std::vector). So iterators, pointers and references to
+//   elements are invalidated by insert/emplace, and by reserve().
+// - The given Hasher may be weak (e.g. std::hash of a pointer is the identity
+//   function on most platforms), the result gets mixed before it's used.
+// - An empty flat_hash_set doesn't allocate memory, the first insert
+//   allocates room for 14 elements (one group with 7/8 maximum load).
+template<typename Value,
+         typename Extractor = flat_hash_set_impl::Identity,
+         typename Hasher = std::hash<flat_hash_set_impl::ExtractedType<Value, Extractor>>,
+         typename Equal = std::equal_to<>>
+class flat_hash_set
+{
+	using ctrl_t = flat_hash_set_impl::ctrl_t;
+	using Group = flat_hash_set_impl::Group;
+	static constexpr auto EMPTY      = flat_hash_set_impl::EMPTY;
+	static constexpr auto DELETED    = flat_hash_set_impl::DELETED;
+	static constexpr auto GROUP_SIZE = flat_hash_set_impl::GROUP_SIZE;
+
+public:
+	using value_type = Value;
+
+	template<typename HashSet, typename IValue>
+	class Iter {
+	public:
+		using value_type = IValue;
+		using difference_type = int;
+		using pointer = IValue*;
+		using reference = IValue&;
+		using iterator_category = std::forward_iterator_tag;
+
+		Iter() = default;
+
+		template<typename HashSet2, typename IValue2>
+		explicit Iter(const Iter<HashSet2, IValue2>& other)
+			: hashSet(other.hashSet), idx(other.idx) {}
+
+		template<typename HashSet2, typename IValue2>
+		Iter& operator=(const Iter<HashSet2, IValue2>& rhs) {
+			hashSet = rhs.hashSet;
+			idx = rhs.idx;
+			return *this;
+		}
+
+		[[nodiscard]] bool operator==(const Iter& rhs) const {
+			assert((hashSet == rhs.hashSet) || !hashSet || !rhs.hashSet);
+			return idx == rhs.idx;
+		}
+		[[nodiscard]] bool operator!=(const Iter& rhs) const {
+			return !(*this == rhs);
+		}
+
+		Iter& operator++() {
+			idx = hashSet->nextFull(idx + 1);
+			if (idx == hashSet->slotCount) idx = END;
+			return *this;
+		}
+		Iter operator++(int) {
+			Iter tmp = *this;
+			++(*this);
+			return tmp;
+		}
+
+		[[nodiscard]] IValue& operator*() const {
+			return hashSet->slots[idx];
+		}
+		[[nodiscard]] IValue* operator->() const {
+			return &hashSet->slots[idx];
+		}
+
+	private:
+		friend class flat_hash_set;
+		template<typename HashSet2, typename IValue2> friend class Iter;
+
+		Iter(HashSet* m, unsigned i)
+			: hashSet(m), idx((i == m->slotCount) ? END : i) {}
+
+		[[nodiscard]] unsigned getIdx() const {
+			return idx;
+		}
+
+	private:
+		static constexpr unsigned END = unsigned(-1);
+		HashSet* hashSet = nullptr;
+		unsigned idx = END;
+	};
+
+	using       iterator = Iter<      flat_hash_set,       Value>;
+	using const_iterator = Iter<const flat_hash_set, const Value>;
+
+public:
+	explicit flat_hash_set(unsigned initialSize = 0,
+	         Extractor extract_ = Extractor(),
+	         Hasher hasher_ = Hasher(),
+	         Equal equal_ = Equal())
+		: extract(extract_), hasher(hasher_), equal(equal_)
+	{
+		reserve(initialSize); // optimized away if initialSize==0
+	}
+
+	flat_hash_set(const flat_hash_set& source)
+		: extract(source.extract), hasher(source.hasher)
+		, equal(source.equal)
+	{
+		copyElements(source);
+	}
+
+	flat_hash_set(flat_hash_set&& source) noexcept
+		: ctrl(source.ctrl)
+		, slots(source.slots)
+		, slotCount(source.slotCount)
+		, elemCount(source.elemCount)
+		, growthLeft(source.growthLeft)
+		, extract(std::move(source.extract))
+		, hasher (std::move(source.hasher))
+		, equal  (std::move(source.equal))
+	{
+		source.release();
+	}
+
+	explicit flat_hash_set(std::initializer_list<Value> args)
+	{
+		reserve(unsigned(args.size()));
+		for (const auto& a : args) insert_noCapacityCheck(a);
+	}
+
+	~flat_hash_set()
+	{
+		destroyElements();
+		free(ctrl);
+		free(slots);
+	}
+
+	flat_hash_set& operator=(const flat_hash_set& source)
+	{
+		if (&source == this) return *this;
+		clear();
+		extract = source.extract;
+		hasher  = source.hasher;
+		equal   = source.equal;
+		copyElements(source);
+		return *this;
+	}
+
+	flat_hash_set& operator=(flat_hash_set&& source) noexcept
+	{
+		if (&source == this) return *this;
+		destroyElements();
+		free(ctrl);
+		free(slots);
+		ctrl       = source.ctrl;
+		slots      = source.slots;
+		slotCount  = source.slotCount;
+		elemCount  = source.elemCount;
+		growthLeft = source.growthLeft;
+		extract    = std::move(source.extract);
+		hasher     = std::move(source.hasher);
+		equal      = std::move(source.equal);
+		source.release();
+		return *this;
+	}
+
+	template<typename K>
+	[[nodiscard]] bool contains(const K& key) const
+	{
+		return locate(key) != slotCount;
+	}
+
+	template<typename V>
+	std::pair<iterator, bool> insert(V&& value)
+	{
+		return insert_impl<true, true>(std::forward<V>(value));
+	}
+	template<typename V>
+	std::pair<iterator, bool> insert_noCapacityCheck(V&& value)
+	{
+		return insert_impl<false, true>(std::forward<V>(value));
+	}
+	template<typename V>
+	iterator insert_noDuplicateCheck(V&& value)
+	{
+		return insert_impl<true, false>(std::forward<V>(value)).first;
+	}
+	template<typename V>
+	iterator insert_noCapacityCheck_noDuplicateCheck(V&& value)
+	{
+		return insert_impl<false, false>(std::forward<V>(value)).first;
+	}
+
+	// Unlike hash_set, these first construct a temporary Value (so they
+	// don't save anything compared to insert()).
+	template<typename... Args>
+	std::pair<iterator, bool> emplace(Args&&... args)
+	{
+		return insert_impl<true, true>(Value(std::forward<Args>(args)...));
+	}
+	template<typename... Args>
+	std::pair<iterator, bool> emplace_noCapacityCheck(Args&&... args)
+	{
+		return insert_impl<false, true>(Value(std::forward<Args>(args)...));
+	}
+	template<typename... Args>
+	iterator emplace_noDuplicateCheck(Args&&... args)
+	{
+		return insert_impl<true, false>(Value(std::forward<Args>(args)...)).first;
+	}
+	template<typename... Args>
+	iterator emplace_noCapacityCheck_noDuplicateCheck(Args&&... args)
+	{
+		return insert_impl<false, false>(Value(std::forward<Args>(args)...)).first;
+	}
+
+	template<typename K>
+	bool erase(const K& key)
+	{
+		auto idx = locate(key);
+		if (idx == slotCount) return false;
+		eraseSlot(idx);
+		return true;
+	}
+
+	void erase(iterator it)
+	{
+		auto idx = it.getIdx();
+		assert(idx < slotCount); // not allowed to call erase(end())
+		eraseSlot(idx);
+	}
+
+	[[nodiscard]] bool empty() const
+	{
+		return elemCount == 0;
+	}
+
+	[[nodiscard]] unsigned size() const
+	{
+		return elemCount;
+	}
+
+	// Removes all elements, but keeps the allocated memory.
+	void clear()
+	{
+		if (slotCount == 0) return;
+		destroyElements();
+		std::fill(ctrl, ctrl + slotCount, EMPTY);
+		elemCount = 0;
+		growthLeft = maxLoad(slotCount);
+	}
+
+	template<typename K>
+	[[nodiscard]] iterator find(const K& key)
+	{
+		return iterator(this, locate(key));
+	}
+
+	template<typename K>
+	[[nodiscard]] const_iterator find(const K& key) const
+	{
+		return const_iterator(this, locate(key));
+	}
+
+	[[nodiscard]] iterator begin()
+	{
+		return iterator(this, nextFull(0));
+	}
+
+	[[nodiscard]] const_iterator begin() const
+	{
+		return const_iterator(this, nextFull(0));
+	}
+
+	[[nodiscard]] iterator end()
+	{
+		return iterator();
+	}
+
+	[[nodiscard]] const_iterator end() const
+	{
+		return const_iterator();
+	}
+
+	// The number of elements that can be present without a rehash.
+	[[nodiscard]] unsigned capacity() const
+	{
+		return elemCount + growthLeft;
+	}
+
+	// After this call, the flat_hash_set can at least contain 'count' number
+	// of elements without requiring any additional memory allocation or
+	// rehash.
+	void reserve(unsigned count)
+	{
+		if (count <= capacity()) return;
+		rehash(slotCountFor(count));
+	}
+
+	friend void swap(flat_hash_set& x, flat_hash_set& y) noexcept
+	{
+		using std::swap;
+		swap(x.ctrl,       y.ctrl);
+		swap(x.slots,      y.slots);
+		swap(x.slotCount,  y.slotCount);
+		swap(x.elemCount,  y.elemCount);
+		swap(x.growthLeft, y.growthLeft);
+		swap(x.extract,    y.extract);
+		swap(x.hasher,     y.hasher);
+		swap(x.equal,      y.equal);
+	}
+
+	[[nodiscard]] friend auto begin(      flat_hash_set& s) { return s.begin(); }
+	[[nodiscard]] friend auto begin(const flat_hash_set& s) { return s.begin(); }
+	[[nodiscard]] friend auto end  (      flat_hash_set& s) { return s.end();   }
+	[[nodiscard]] friend auto end  (const flat_hash_set& s) { return s.end();   }
+
+private:
+	// At most 7/8 of the slots are in use (elements plus tombstones), so
+	// that unsuccessful lookups quickly find an empty slot.
+	[[nodiscard]] static constexpr unsigned maxLoad(unsigned numSlots)
+	{
+		return numSlots - numSlots / 8;
+	}
+	[[nodiscard]] static unsigned slotCountFor(unsigned count)
+	{
+		unsigned numSlots = GROUP_SIZE;
+		while (maxLoad(numSlots) < count) numSlots *= 2;
+		return numSlots;
+	}
+
+	// Multiply by (2^64 / golden ratio) and fold the upper half into the
+	// lower half: all bits of the result depend on all bits of the hash.
+	template<typename K>
+	[[nodiscard]] uint64_t hash(const K& key) const
+	{
+		auto h = uint64_t(hasher(key)) * 0x9E3779B97F4A7C15ull;
+		return h ^ (h >> 32);
+	}
+	// The lower bits select the group, the upper 7 bits go in the control
+	// byte.
+	[[nodiscard]] static ctrl_t h2(uint64_t h)
+	{
+		return ctrl_t(h >> 57);
+	}
+
+	// Visit the groups in the order: g, g+1, g+3, g+6, ... (modulo the
+	// number of groups). Because that number is a power of 2, eventually
+	// all groups are visited.
+	class ProbeSeq {
+	public:
+		ProbeSeq(uint64_t h, unsigned numSlots)
+			: mask(numSlots / GROUP_SIZE - 1)
+			, group(unsigned(h) & mask) {}
+		[[nodiscard]] unsigned offset() const { return group * GROUP_SIZE; }
+		void next() { group = (group + ++step) & mask; }
+	private:
+		unsigned mask;
+		unsigned group;
+		unsigned step = 0;
+	};
+
+	[[nodiscard]] unsigned nextFull(unsigned idx) const
+	{
+		while ((idx < slotCount) && (ctrl[idx] < 0)) ++idx;
+		return idx;
+	}
+
+	// Returns the index of the element with the given key, or 'slotCount'
+	// when there's no such element.
+	template<typename K>
+	[[nodiscard]] unsigned locate(const K& key) const
+	{
+		if (elemCount == 0) return slotCount;
+		return locate(key, hash(key));
+	}
+	template<typename K>
+	[[nodiscard]] unsigned locate(const K& key, uint64_t h) const
+	{
+		auto tag = h2(h);
+		for (ProbeSeq seq(h, slotCount); /**/; seq.next()) {
+			Group group(ctrl + seq.offset());
+			for (auto m = group.match(tag); m; m &= m - 1) {
+				auto idx = seq.offset() + Math::findFirstSet(m) - 1;
+				if (equal(extract(slots[idx]), key)) return idx;
+			}
+			// The probe sequence of an element never passes an
+			// empty slot, so the element isn't present.
+			if (group.matchEmpty()) return slotCount;
+		}
+	}
+
+	// Returns the index of the first empty or deleted slot in the probe
+	// sequence. (There always is one, see maxLoad()).
+	[[nodiscard]] unsigned findFree(uint64_t h) const
+	{
+		for (ProbeSeq seq(h, slotCount); /**/; seq.next()) {
+			Group group(ctrl + seq.offset());
+			if (auto m = group.matchEmptyOrDeleted()) {
+				return seq.offset() + Math::findFirstSet(m) - 1;
+			}
+		}
+	}
+
+	template<bool CHECK_CAPACITY, bool CHECK_DUPLICATE, typename V>
+	[[nodiscard]] std::pair<iterator, bool> insert_impl(V&& value)
+	{
+		auto h = hash(extract(value));
+		if constexpr (CHECK_DUPLICATE) {
+			if (elemCount != 0) {
+				auto idx = locate(extract(value), h);
+				if (idx != slotCount) {
+					// already exists
+					return std::pair(iterator(this, idx), false);
+				}
+			}
+		}
+
+		if (CHECK_CAPACITY && (growthLeft == 0)) {
+			grow();
+		}
+		assert(growthLeft != 0);
+
+		auto idx = findFree(h);
+		if (ctrl[idx] == EMPTY) --growthLeft; // reusing a tombstone is free
+		ctrl[idx] = h2(h);
+		new (&slots[idx]) Value(std::forward<V>(value));
+		++elemCount;
+		return std::pair(iterator(this, idx), true);
+	}
+
+	void eraseSlot(unsigned idx)
+	{
+		assert(ctrl[idx] >= 0);
+		slots[idx].~Value();
+		--elemCount;
+		// When this group still has an empty slot, no probe sequence
+		// continued past this group (it was never full). So then this
+		// slot can become empty again instead of a tombstone.
+		Group group(ctrl + (idx & ~(GROUP_SIZE - 1)));
+		if (group.matchEmpty()) {
+			ctrl[idx] = EMPTY;
+			++growthLeft;
+		} else {
+			ctrl[idx] = DELETED;
+		}
+	}
+
+	void grow()
+	{
+		// When more than half of the used slots are tombstones, rehash
+		// to the same size (this removes the tombstones). Otherwise
+		// double the size.
+		if ((slotCount != 0) && (elemCount <= maxLoad(slotCount) / 2)) {
+			rehash(slotCount);
+		} else {
+			rehash(std::max(GROUP_SIZE, 2 * slotCount));
+		}
+	}
+
+	void rehash(unsigned newSlotCount)
+	{
+		assert(Math::ispow2(newSlotCount) && (newSlotCount >= GROUP_SIZE));
+		assert(maxLoad(newSlotCount) >= elemCount);
+		auto* newCtrl = static_cast<ctrl_t*>(malloc(newSlotCount));
+		if (!newCtrl) throw std::bad_alloc();
+		auto* newSlots = static_cast<Value*>(malloc(newSlotCount * sizeof(Value)));
+		if (!newSlots) { free(newCtrl); throw std::bad_alloc(); }
+		std::fill(newCtrl, newCtrl + newSlotCount, EMPTY);
+
+		auto* oldCtrl = ctrl;
+		auto* oldSlots = slots;
+		auto oldSlotCount = slotCount;
+		ctrl = newCtrl;
+		slots = newSlots;
+		slotCount = newSlotCount;
+		growthLeft = maxLoad(newSlotCount) - elemCount;
+
+		for (auto i : xrange(oldSlotCount)) {
+			if (oldCtrl[i] < 0) continue;
+			auto h = hash(extract(oldSlots[i]));
+			auto idx = findFree(h);
+			ctrl[idx] = h2(h);
+			new (&slots[idx]) Value(std::move(oldSlots[i]));
+			oldSlots[i].~Value();
+		}
+		free(oldCtrl);
+		free(oldSlots);
+	}
+
+	void copyElements(const flat_hash_set& source)
+	{
+		if (source.elemCount == 0) return;
+		reserve(source.elemCount);
+		for (const auto& v : source) {
+			insert_noCapacityCheck_noDuplicateCheck(v);
+		}
+	}
+
+	void destroyElements()
+	{
+		if constexpr (!std::is_trivially_destructible_v<Value>) {
+			if (elemCount == 0) return;
+			for (auto i : xrange(slotCount)) {
+				if (ctrl[i] >= 0) slots[i].~Value();
+			}
+		}
+	}
+
+	void release()
+	{
+		ctrl = nullptr;
+		slots = nullptr;
+		slotCount = 0;
+		elemCount = 0;
+		growthLeft = 0;
+	}
+
+private:
+	ctrl_t* ctrl = nullptr;
+	Value* slots = nullptr; // only the slots with a 'full' ctrl byte are constructed
+	unsigned slotCount = 0; // 0 or a power of 2 (at least GROUP_SIZE)
+	unsigned elemCount = 0;
+	unsigned growthLeft = 0; // number of EMPTY slots that can still be used
+	Extractor extract;
+	Hasher hasher;
+	Equal equal;
+};
+
+#endif
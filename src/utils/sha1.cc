@@ -29,6 +29,26 @@ A million repetitions of "a"
 #include <emmintrin.h> // SSE2
 #endif
 
+// Hardware accelerated SHA-1:
+// - x86-64: Intel SHA extensions (SHA-NI). Most builds don't target CPUs that
+//   are guaranteed to have these, so check at runtime.
+// - aarch64: ARMv8 crypto extensions, only when enabled at compile time.
+#if (defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))) || defined(_M_X64)
+#define SHA1_X86_NI 1
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#define SHA_NI_TARGET
+#else
+#include <cpuid.h>
+#define SHA_NI_TARGET __attribute__((target("sha,ssse3,sse4.1")))
+#endif
+#endif
+#if defined(__aarch64__) && (defined(__ARM_FEATURE_SHA2) || defined(__ARM_FEATURE_CRYPTO))
+#define SHA1_ARM_CRYPTO 1
+#include <arm_neon.h>
+#endif
+
 namespace openmsx {
 
 // Rotate x bits to the left
@@ -90,6 +110,132 @@ WorkspaceBlock::WorkspaceBlock(const uint8_t buffer[64])
 	memcpy(data, buffer, sizeof(data));
 }
 
+#ifdef SHA1_X86_NI
+[[nodiscard]] static bool detectShaNi()
+{
+	// SHA: CPUID.(EAX=7,ECX=0):EBX[bit 29]
+	// SSSE3 and SSE4.1: CPUID.(EAX=1):ECX[bit 9, bit 19]
+#ifdef _MSC_VER
+	int r1[4], r7[4];
+	__cpuid(r1, 0);
+	if (r1[0] < 7) return false;
+	__cpuid(r1, 1);
+	__cpuidex(r7, 7, 0);
+	unsigned ecx1 = unsigned(r1[2]), ebx7 = unsigned(r7[1]);
+#else
+	unsigned eax, ebx, ecx, edx, ecx1, ebx7;
+	if (!__get_cpuid(1, &eax, &ebx, &ecx1, &edx)) return false;
+	if (!__get_cpuid_count(7, 0, &eax, &ebx7, &ecx, &edx)) return false;
+#endif
+	return (ecx1 & (1 << 9)) && (ecx1 & (1 << 19)) && (ebx7 & (1 << 29));
+}
+
+[[nodiscard]] static bool hasShaNi()
+{
+	static const bool result = detectShaNi();
+	return result;
+}
+
+// 5 groups of 4 rounds, all using the same round function 'F'.
+// The message schedule is kept in 'w' as 4 groups of 4 words (the first word
+// in the highest lane). Group 'j' replaces group 'j - 4'.
+template<int F>
+SHA_NI_TARGET static inline void shaNiRounds(
+	__m128i& abcd, __m128i& e, __m128i w[4], int j0)
+{
+	for (int j = j0; j < (j0 + 5); ++j) {
+		auto& wj = w[j & 3];
+		if (j >= 4) {
+			wj = _mm_sha1msg2_epu32(
+				_mm_xor_si128(_mm_sha1msg1_epu32(wj, w[(j + 1) & 3]),
+				              w[(j + 2) & 3]),
+				w[(j + 3) & 3]);
+		}
+		auto x = (j == 0) ? _mm_add_epi32(e, wj) : _mm_sha1nexte_epu32(e, wj);
+		e = abcd;
+		abcd = _mm_sha1rnds4_epu32(abcd, x, F);
+	}
+}
+
+SHA_NI_TARGET static void transformShaNi(uint32_t state[5], const uint8_t* data, size_t numBlocks)
+{
+	const __m128i MASK = _mm_set_epi64x(0x0001020304050607ULL, 0x08090a0b0c0d0e0fULL);
+	auto abcd = _mm_shuffle_epi32(
+		_mm_loadu_si128(reinterpret_cast<const __m128i*>(state)), 0x1B);
+	auto e = _mm_set_epi32(int(state[4]), 0, 0, 0);
+
+	for (/**/; numBlocks != 0; --numBlocks, data += 64) {
+		auto abcdSave = abcd;
+		auto eSave = e;
+		__m128i w[4];
+		for (int i = 0; i < 4; ++i) {
+			w[i] = _mm_shuffle_epi8(
+				_mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 16 * i)), MASK);
+		}
+		shaNiRounds<0>(abcd, e, w,  0);
+		shaNiRounds<1>(abcd, e, w,  5);
+		shaNiRounds<2>(abcd, e, w, 10);
+		shaNiRounds<3>(abcd, e, w, 15);
+		e = _mm_sha1nexte_epu32(e, eSave);
+		abcd = _mm_add_epi32(abcd, abcdSave);
+	}
+
+	_mm_storeu_si128(reinterpret_cast<__m128i*>(state), _mm_shuffle_epi32(abcd, 0x1B));
+	state[4] = uint32_t(_mm_extract_epi32(e, 3));
+}
+#endif
+
+#ifdef SHA1_ARM_CRYPTO
+// Same structure as the SHA-NI version above, but here the first word is in
+// the lowest lane.
+template<int F>
+static inline void armRounds(uint32x4_t& abcd, uint32_t& e, uint32x4_t w[4], int j0)
+{
+	static constexpr uint32_t K[4] = { 0x5A827999, 0x6ED9EBA1, 0x8F1BBCDC, 0xCA62C1D6 };
+	for (int j = j0; j < (j0 + 5); ++j) {
+		auto& wj = w[j & 3];
+		if (j >= 4) {
+			wj = vsha1su1q_u32(vsha1su0q_u32(wj, w[(j + 1) & 3], w[(j + 2) & 3]),
+			                   w[(j + 3) & 3]);
+		}
+		auto wk = vaddq_u32(wj, vdupq_n_u32(K[F]));
+		auto eNext = vsha1h_u32(vgetq_lane_u32(abcd, 0));
+		if constexpr (F == 0) {
+			abcd = vsha1cq_u32(abcd, e, wk);
+		} else if constexpr (F == 2) {
+			abcd = vsha1mq_u32(abcd, e, wk);
+		} else {
+			abcd = vsha1pq_u32(abcd, e, wk);
+		}
+		e = eNext;
+	}
+}
+
+static void transformArm(uint32_t state[5], const uint8_t* data, size_t numBlocks)
+{
+	auto abcd = vld1q_u32(state);
+	uint32_t e = state[4];
+
+	for (/**/; numBlocks != 0; --numBlocks, data += 64) {
+		auto abcdSave = abcd;
+		auto eSave = e;
+		uint32x4_t w[4];
+		for (int i = 0; i < 4; ++i) {
+			w[i] = vreinterpretq_u32_u8(vrev32q_u8(vld1q_u8(data + 16 * i)));
+		}
+		armRounds<0>(abcd, e, w,  0);
+		armRounds<1>(abcd, e, w,  5);
+		armRounds<2>(abcd, e, w, 10);
+		armRounds<3>(abcd, e, w, 15);
+		e += eSave;
+		abcd = vaddq_u32(abcd, abcdSave);
+	}
+
+	vst1q_u32(state, abcd);
+	state[4] = e;
+}
+#endif
+
 
 // class Sha1Sum
 
@@ -264,7 +410,23 @@ SHA1::SHA1()
 	m_finalized = false;
 }
 
-void SHA1::transform(const uint8_t buffer[64])
+void SHA1::transform(const uint8_t* buffer, size_t numBlocks)
+{
+#if defined(SHA1_ARM_CRYPTO)
+	transformArm(m_state.a, buffer, numBlocks);
+	return;
+#elif defined(SHA1_X86_NI)
+	if (hasShaNi()) {
+		transformShaNi(m_state.a, buffer, numBlocks);
+		return;
+	}
+#endif
+	for (/**/; numBlocks != 0; --numBlocks, buffer += 64) {
+		transformGeneric(buffer);
+	}
+}
+
+void SHA1::transformGeneric(const uint8_t buffer[64])
 {
 	WorkspaceBlock block(buffer);
 
@@ -326,10 +488,10 @@ void SHA1::update(span<const uint8_t> data_)
 	size_t i;
 	if ((j + len) > 63) {
 		memcpy(&m_buffer[j], data, (i = 64 - j));
-		transform(m_buffer);
-		for (/**/; i + 63 < len; i += 64) {
-			transform(&data[i]);
-		}
+		transform(m_buffer, 1);
+		size_t numBlocks = (len - i) / 64;
+		transform(&data[i], numBlocks);
+		i += 64 * numBlocks;
 		j = 0;
 	} else {
 		i = 0;
@@ -345,13 +507,13 @@ void SHA1::finalize()
 	m_buffer[j++] = 0x80;
 	if (j > 56) {
 		memset(&m_buffer[j], 0, 64 - j);
-		transform(m_buffer);
+		transform(m_buffer, 1);
 		j = 0;
 	}
 	memset(&m_buffer[j], 0, 56 - j);
 	Endian::B64 finalCount = 8 * m_count; // convert number of bytes to bits
 	memcpy(&m_buffer[56], &finalCount, 8);
-	transform(m_buffer);
+	transform(m_buffer, 1);
 
 	m_finalized = true;
 }
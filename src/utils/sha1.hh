@@ -54,6 +54,11 @@ public:
 		return a[5 - 1] < other.a[5 - 1];
 	}
 
+	/** The first 32 bits of the sum. These bits determine the sort order
+	  * (most significant first) and, because sha1 values are uniformly
+	  * distributed, they also make a good hash value. */
+	[[nodiscard]] uint32_t getPrefix32() const { return a[0]; }
+
 	[[nodiscard]] bool operator<=(const Sha1Sum& other) const { return !(other <  *this); }
 	[[nodiscard]] bool operator> (const Sha1Sum& other) const { return  (other <  *this); }
 	[[nodiscard]] bool operator>=(const Sha1Sum& other) const { return !(*this <  other); }
@@ -93,7 +98,8 @@ public:
 	[[nodiscard]] static Sha1Sum calc(span<const uint8_t> data);
 
 private:
-	void transform(const uint8_t buffer[64]);
+	void transform(const uint8_t* buffer, size_t numBlocks);
+	void transformGeneric(const uint8_t buffer[64]);
 	void finalize();
 
 private:
@@ -0,0 +1,75 @@
+#ifndef SPSC_QUEUE_HH
+#define SPSC_QUEUE_HH
+
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <vector>
+
+/** A fixed capacity queue for exactly one producer and one consumer thread,
+  * without locks.
+  *
+  * push() may only be called from the producer thread. front(), pop() and
+  * clear() may only be called from the consumer thread. empty() and size()
+  * can be called from both threads, though the result may already be out of
+  * date when it's used by the other thread.
+  */
+template<typename T> class spsc_queue
+{
+public:
+	/** @param capacity Must be a power of 2. */
+	explicit spsc_queue(size_t capacity)
+		: buf(capacity), mask(capacity - 1)
+	{
+		assert(capacity && ((capacity & mask) == 0));
+	}
+
+	/** Add an element at the back.
+	  * @return false (and drop the element) when the queue is full. */
+	bool push(const T& t) {
+		auto w = writeIdx.load(std::memory_order_relaxed);
+		if ((w - readIdx.load(std::memory_order_acquire)) == buf.size()) {
+			return false;
+		}
+		buf[w & mask] = t;
+		writeIdx.store(w + 1, std::memory_order_release);
+		return true;
+	}
+
+	/** The oldest element, or nullptr when the queue is empty. Stays valid
+	  * until the next pop() or clear(). */
+	[[nodiscard]] T* front() {
+		auto r = readIdx.load(std::memory_order_relaxed);
+		if (r == writeIdx.load(std::memory_order_acquire)) return nullptr;
+		return &buf[r & mask];
+	}
+
+	/** Remove the oldest element. The queue may not be empty. */
+	void pop() {
+		auto r = readIdx.load(std::memory_order_relaxed);
+		assert(r != writeIdx.load(std::memory_order_acquire));
+		readIdx.store(r + 1, std::memory_order_release);
+	}
+
+	/** Remove all elements that are in the queue at this point. */
+	void clear() {
+		readIdx.store(writeIdx.load(std::memory_order_acquire),
+		              std::memory_order_release);
+	}
+
+	[[nodiscard]] size_t size() const {
+		return writeIdx.load(std::memory_order_acquire) -
+		       readIdx.load(std::memory_order_acquire);
+	}
+	[[nodiscard]] bool empty() const { return size() == 0; }
+	[[nodiscard]] size_t capacity() const { return buf.size(); }
+
+private:
+	std::vector<T> buf;
+	const size_t mask;
+	// Both only increase (and wrap around), the difference is the size.
+	std::atomic<size_t> readIdx = 0;
+	std::atomic<size_t> writeIdx = 0;
+};
+
+#endif
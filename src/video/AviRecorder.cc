@@ -7,6 +7,7 @@
 #include "CommandException.hh"
 #include "Display.hh"
 #include "PostProcessor.hh"
+#include "PipeWriter.hh"
 #include "Math.hh"
 #include "MSXMixer.hh"
 #include "Filename.hh"
@@ -36,10 +37,12 @@ AviRecorder::~AviRecorder()
 {
 	assert(!aviWriter);
 	assert(!wavWriter);
+	assert(!pipeWriter);
 }
 
 void AviRecorder::start(bool recordAudio, bool recordVideo, bool recordMono,
-                        bool recordStereo, const Filename& filename)
+                        bool recordStereo, const Filename& filename,
+                        const std::string& pipeCommand)
 {
 	stop();
 	MSXMotherBoard* motherBoard = reactor.getMotherBoard();
@@ -81,10 +84,21 @@ void AviRecorder::start(bool recordAudio, bool recordVideo, bool recordMono,
 		prevTime = EmuTime::infinity();
 
 		try {
-			aviWriter = std::make_unique<AviWriter>(
-				filename, frameWidth, frameHeight, bpp,
-				(recordAudio && stereo) ? 2 : 1, sampleRate);
+			if (!pipeCommand.empty()) {
+				// raw video to the pipe, audio to a separate file
+				pipeWriter = std::make_unique<PipeWriter>(
+					pipeCommand, frameWidth, frameHeight);
+				if (recordAudio) {
+					wavWriter = std::make_unique<Wav16Writer>(
+						filename, stereo ? 2 : 1, sampleRate);
+				}
+			} else {
+				aviWriter = std::make_unique<AviWriter>(
+					filename, frameWidth, frameHeight, bpp,
+					(recordAudio && stereo) ? 2 : 1, sampleRate);
+			}
 		} catch (MSXException& e) {
+			pipeWriter.reset();
 			throw CommandException("Can't start recording: ",
 			                       e.getMessage());
 		}
@@ -113,6 +127,12 @@ void AviRecorder::stop()
 	sampleRate = 0;
 	aviWriter.reset();
 	wavWriter.reset();
+	pipeWriter.reset();
+}
+
+bool AviRecorder::isRecording() const
+{
+	return aviWriter || wavWriter || pipeWriter;
 }
 
 static int16_t float2int16(float f)
@@ -168,9 +188,11 @@ void AviRecorder::addWave(unsigned num, float* fData)
 	}
 }
 
-void AviRecorder::addImage(FrameSource* frame, EmuTime::param time)
+void AviRecorder::addImage(
+	FrameSource* frame, std::shared_ptr<const FrameSource> sharedFrame,
+	EmuTime::param time)
 {
-	assert(!wavWriter);
+	assert(aviWriter || pipeWriter);
 	if (duration != EmuDuration::infinity()) {
 		if (!warnedFps && ((time - prevTime) != duration)) {
 			warnedFps = true;
@@ -181,15 +203,20 @@ void AviRecorder::addImage(FrameSource* frame, EmuTime::param time)
 		}
 	} else if (prevTime != EmuTime::infinity()) {
 		duration = time - prevTime;
-		aviWriter->setFps(1.0 / duration.toDouble());
+		if (aviWriter) aviWriter->setFps(1.0 / duration.toDouble());
 	}
 	prevTime = time;
 
 	if (mixer) {
 		mixer->updateStream(time);
 	}
-	aviWriter->addFrame(frame, unsigned(audioBuf.size()), audioBuf.data());
-	audioBuf.clear();
+	if (pipeWriter) {
+		pipeWriter->addFrame(frame);
+	} else {
+		aviWriter->addFrame(frame, std::move(sharedFrame),
+		                    unsigned(audioBuf.size()), audioBuf.data());
+		audioBuf.clear();
+	}
 }
 
 // TODO: Can this be dropped?
@@ -201,6 +228,7 @@ unsigned AviRecorder::getFrameHeight() const {
 void AviRecorder::processStart(Interpreter& interp, span<const TclObject> tokens, TclObject& result)
 {
 	std::string_view prefix = "openmsx";
+	std::string pipeCommand;
 	bool audioOnly    = false;
 	bool videoOnly    = false;
 	bool recordMono   = false;
@@ -209,6 +237,7 @@ void AviRecorder::processStart(Interpreter& interp, span<const TclObject> tokens
 	bool tripleSize   = false;
 	ArgsInfo info[] = {
 		valueArg("-prefix", prefix),
+		valueArg("-pipe", pipeCommand),
 		flagArg("-audioonly", audioOnly),
 		flagArg("-videoonly", videoOnly),
 		flagArg("-mono",      recordMono),
@@ -227,6 +256,9 @@ void AviRecorder::processStart(Interpreter& interp, span<const TclObject> tokens
 	if (doubleSize && tripleSize) {
 		throw CommandException("Can't have both -doublesize and -triplesize.");
 	}
+	if (audioOnly && !pipeCommand.empty()) {
+		throw CommandException("Can't have both -audioonly and -pipe.");
+	}
 	if (videoOnly && (recordStereo || recordMono)) {
 		throw CommandException("Can't have both -videoonly and -stereo or -mono.");
 	}
@@ -253,17 +285,25 @@ void AviRecorder::processStart(Interpreter& interp, span<const TclObject> tokens
 	}
 	bool recordAudio = !videoOnly;
 	bool recordVideo = !audioOnly;
-	std::string_view directory = recordVideo ? "videos" : "soundlogs";
-	std::string_view extension = recordVideo ? ".avi"   : ".wav";
+	bool toAvi = recordVideo && pipeCommand.empty();
+	std::string_view directory = toAvi ? "videos" : "soundlogs";
+	std::string_view extension = toAvi ? ".avi"   : ".wav";
 	auto filename = FileOperations::parseCommandFileArgument(
 		filenameArg, directory, prefix, extension);
 
-	if (aviWriter || wavWriter) {
+	if (isRecording()) {
 		result = "Already recording.";
 	} else {
 		start(recordAudio, recordVideo, recordMono, recordStereo,
-				Filename(filename));
-		result = tmpStrCat("Recording to ", filename);
+				Filename(filename), pipeCommand);
+		if (pipeCommand.empty()) {
+			result = tmpStrCat("Recording to ", filename);
+		} else {
+			auto msg = strCat("Recording ", frameWidth, 'x', frameHeight,
+			                  " bgr0 video to '", pipeCommand, '\'');
+			if (recordAudio) strAppend(msg, " and audio to ", filename);
+			result = msg;
+		}
 	}
 }
 
@@ -274,7 +314,7 @@ void AviRecorder::processStop(span<const TclObject> /*tokens*/)
 
 void AviRecorder::processToggle(Interpreter& interp, span<const TclObject> tokens, TclObject& result)
 {
-	if (aviWriter || wavWriter) {
+	if (isRecording()) {
 		// drop extra tokens
 		processStop(tokens.first<2>());
 	} else {
@@ -284,7 +324,13 @@ void AviRecorder::processToggle(Interpreter& interp, span<const TclObject> token
 
 void AviRecorder::status(span<const TclObject> /*tokens*/, TclObject& result) const
 {
-	result.addDictKeyValue("status", (aviWriter || wavWriter) ? "recording" : "idle");
+	result.addDictKeyValue("status", isRecording() ? "recording" : "idle");
+	if (aviWriter) {
+		auto stats = aviWriter->getStats();
+		result.addDictKeyValues("encoder_queue", stats.queued,
+		                        "encoder_waits", stats.waits,
+		                        "encoder_wait_time", stats.waitTime);
+	}
 }
 
 // class AviRecorder::Cmd
@@ -317,6 +363,8 @@ std::string AviRecorder::Cmd::help(span<const TclObject> /*tokens*/) const
 	       "record start              Record to file 'openmsxNNNN.avi'\n"
 	       "record start <filename>   Record to given file\n"
 	       "record start -prefix foo  Record to file 'fooNNNN.avi'\n"
+	       "record start -pipe <cmd>  Write raw video frames to the standard input of\n"
+	       "                          <cmd>, and audio to file 'openmsxNNNN.wav'\n"
 	       "record stop               Stop recording\n"
 	       "record toggle             Toggle recording (useful as keybinding)\n"
 	       "record status             Query recording state\n"
@@ -324,7 +372,10 @@ std::string AviRecorder::Cmd::help(span<const TclObject> /*tokens*/) const
 	       "The start subcommand also accepts an optional -audioonly, -videoonly, "
 	       " -mono, -stereo, -doublesize, -triplesize flag.\n"
 	       "Videos are recorded in a 320x240 size by default, at 640x480 when the "
-	       "-doublesize flag is used and at 960x720 when the -triplesize flag is used.";
+	       "-doublesize flag is used and at 960x720 when the -triplesize flag is used.\n"
+	       "With -pipe each frame is written without header, 4 bytes per pixel: "
+	       "blue, green, red, unused. E.g. for ffmpeg use: "
+	       "-f rawvideo -pix_fmt bgr0 -s 320x240 -r 59.94 -i -";
 }
 
 void AviRecorder::Cmd::tabCompletion(std::vector<std::string>& tokens) const
@@ -337,7 +388,7 @@ void AviRecorder::Cmd::tabCompletion(std::vector<std::string>& tokens) const
 		completeString(tokens, cmds);
 	} else if ((tokens.size() >= 3) && (tokens[1] == "start")) {
 		static constexpr std::array options = {
-			"-prefix"sv, "-videoonly"sv, "-audioonly"sv,
+			"-prefix"sv, "-pipe"sv, "-videoonly"sv, "-audioonly"sv,
 			"-doublesize"sv, "-triplesize"sv,
 			"-mono"sv, "-stereo"sv,
 		};
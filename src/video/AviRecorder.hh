@@ -5,8 +5,9 @@
 #include "EmuTime.hh"
 #include "span.hh"
 #include <cstdint>
-#include <vector>
 #include <memory>
+#include <string>
+#include <vector>
 
 namespace openmsx {
 
@@ -15,6 +16,7 @@ class Filename;
 class FrameSource;
 class Interpreter;
 class MSXMixer;
+class PipeWriter;
 class PostProcessor;
 class Reactor;
 class TclObject;
@@ -27,13 +29,21 @@ public:
 	~AviRecorder();
 
 	void addWave(unsigned num, float* data);
-	void addImage(FrameSource* frame, EmuTime::param time);
+	/** @param sharedFrame Either nullptr or the same frame as 'frame'. In
+	  *        the latter case the frame can still be read after this call
+	  *        (so it doesn't have to be copied right away).
+	  */
+	void addImage(FrameSource* frame,
+	              std::shared_ptr<const FrameSource> sharedFrame,
+	              EmuTime::param time);
 	void stop();
 	[[nodiscard]] unsigned getFrameHeight() const;
 
 private:
 	void start(bool recordAudio, bool recordVideo, bool recordMono,
-		   bool recordStereo, const Filename& filename);
+		   bool recordStereo, const Filename& filename,
+		   const std::string& pipeCommand);
+	[[nodiscard]] bool isRecording() const;
 	void status(span<const TclObject> tokens, TclObject& result) const;
 
 	void processStart (Interpreter& interp, span<const TclObject> tokens, TclObject& result);
@@ -53,6 +63,7 @@ private:
 	std::vector<int16_t> audioBuf;
 	std::unique_ptr<AviWriter>   aviWriter; // can be nullptr
 	std::unique_ptr<Wav16Writer> wavWriter; // can be nullptr
+	std::unique_ptr<PipeWriter>  pipeWriter; // can be nullptr
 	std::vector<PostProcessor*> postProcessors;
 	MSXMixer* mixer;
 	EmuDuration duration;
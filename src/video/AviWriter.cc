@@ -6,14 +6,28 @@
 #include "build-info.hh"
 #include "Version.hh"
 #include "cstdiop.hh" // for snprintf
+#include "FrameSource.hh"
 #include <cassert>
+#include <chrono>
 #include <cstring>
 #include <ctime>
 #include <limits>
 
 namespace openmsx {
 
-constexpr unsigned AVI_HEADER_SIZE = 500;
+constexpr unsigned SUPER_INDEX_ENTRIES = 256; // so max 256GB
+constexpr unsigned SUPER_INDEX_SIZE = 8 + 24 + 16 * SUPER_INDEX_ENTRIES;
+constexpr unsigned ODML_LIST_SIZE = 12 + 8 + 248;
+constexpr unsigned AVI_HEADER_SIZE = 512 + 2 * SUPER_INDEX_SIZE + ODML_LIST_SIZE;
+constexpr uint64_t MAX_RIFF_SIZE = 1 << 30;
+constexpr size_t WRITE_BUFFER_SIZE = 1 << 20;
+static constexpr const char* const STREAM_TAGS[2] = {"00dc", "01wb"};
+static constexpr const char* const INDEX_TAGS[2] = {"ix00", "ix01"};
+
+[[nodiscard]] static uint32_t fourcc(const char* s)
+{
+	return (s[0] << 0) | (s[1] << 8) | (s[2] << 16) | (s[3] << 24);
+}
 
 AviWriter::AviWriter(const Filename& filename, unsigned width_,
                      unsigned height_, unsigned bpp, unsigned channels_,
@@ -26,19 +40,23 @@ AviWriter::AviWriter(const Filename& filename, unsigned width_,
 	, channels(channels_)
 	, audiorate(freq_)
 {
-	uint8_t dummy[AVI_HEADER_SIZE] = {};
-	file.write(dummy, sizeof(dummy));
+	writeBuffer.reserve(WRITE_BUFFER_SIZE);
+	// header is filled in by the destructor
+	std::vector<uint8_t> dummy(AVI_HEADER_SIZE);
+	write(dummy.data(), dummy.size());
+	moviStart = AVI_HEADER_SIZE - 4;
 
 	index.resize(2);
 
 	frames = 0;
-	written = 0;
 	audiowritten = 0;
 }
 
 AviWriter::~AviWriter()
 {
-	if (written == 0) {
+	encoder.wait(); // finish all queued frames
+
+	if (frames == 0) {
 		// no data written yet (a recording less than one video frame)
 		std::string filename = file.getURL();
 		file.close(); // close file (needed for windows?)
@@ -47,9 +65,20 @@ AviWriter::~AviWriter()
 	}
 	assert(fps != 0.0f); // a decent fps should have been set
 
+	try {
+		finishRiff();
+		flushBuffer();
+		writeHeader();
+	} catch (MSXException&) {
+		// can't throw from destructor
+	}
+}
+
+void AviWriter::writeHeader()
+{
 	// Possible cleanup: use structs for the different headers, that
 	// also allows to use the aligned versions of the Endian routines.
-	uint8_t avi_header[AVI_HEADER_SIZE] = {};
+	std::vector<uint8_t> avi_header(AVI_HEADER_SIZE);
 	unsigned header_pos = 0;
 
 	auto AVIOUT4 = [&](const char (&s)[5]) { // expect a string-literal of 4 chars (+ zero terminator)
@@ -65,17 +94,43 @@ AviWriter::~AviWriter()
 		Endian::write_UA_L32(&avi_header[header_pos], d);
 		header_pos += sizeof(d);
 	};
+	auto AVIOUTq = [&](uint64_t q) {
+		Endian::write_UA_L64(&avi_header[header_pos], q);
+		header_pos += sizeof(q);
+	};
 	auto AVIOUTs = [&](const char* s) {
 		auto len1 = strlen(s) + 1; // +1 for zero-terminator
 		memcpy(&avi_header[header_pos], s, len1);
 		header_pos += (len1 + 1) & ~1; // round-up to even
 	};
+	// The OpenDML super index, the unused entries stay zero.
+	auto AVIOUTindx = [&](unsigned stream) {
+		const auto& superIndex = streamIndex[stream].superIndex;
+		assert(superIndex.size() <= SUPER_INDEX_ENTRIES);
+		unsigned end = header_pos + SUPER_INDEX_SIZE;
+		AVIOUT4("indx");
+		AVIOUTd(SUPER_INDEX_SIZE - 8);  // # of bytes to follow
+		AVIOUTw(4);                     // LongsPerEntry
+		avi_header[header_pos++] = 0;   // IndexSubType
+		avi_header[header_pos++] = 0;   // IndexType: AVI_INDEX_OF_INDEXES
+		AVIOUTd(unsigned(superIndex.size())); // EntriesInUse
+		AVIOUTd(fourcc(STREAM_TAGS[stream])); // ChunkId
+		AVIOUTd(0);                     // Reserved
+		AVIOUTd(0);
+		AVIOUTd(0);
+		for (const auto& e : superIndex) {
+			AVIOUTq(e.offset);
+			AVIOUTd(e.size);
+			AVIOUTd(e.duration);
+		}
+		header_pos = end;
+	};
 
 	bool hasAudio = audiorate != 0;
 
 	// write avi header
 	AVIOUT4("RIFF");                    // Riff header
-	AVIOUTd(AVI_HEADER_SIZE + written - 8 + unsigned(index.size() * sizeof(Endian::L32)));
+	AVIOUTd(unsigned(firstRiffEnd - 8));
 	AVIOUT4("AVI ");
 	AVIOUT4("LIST");                    // List header
 	unsigned main_list = header_pos;
@@ -88,7 +143,7 @@ AviWriter::~AviWriter()
 	AVIOUTd(0);
 	AVIOUTd(0);                         // PaddingGranularity (whatever that might be)
 	AVIOUTd(0x110);                     // Flags,0x10 has index, 0x100 interleaved
-	AVIOUTd(frames);                    // TotalFrames
+	AVIOUTd(firstRiffFrames);           // TotalFrames (only in the first RIFF)
 	AVIOUTd(0);                         // InitialFrames
 	AVIOUTd(hasAudio? 2 : 1);           // Stream count
 	AVIOUTd(0);                         // SuggestedBufferSize
@@ -101,7 +156,7 @@ AviWriter::~AviWriter()
 
 	// Video stream list
 	AVIOUT4("LIST");
-	AVIOUTd(4 + 8 + 56 + 8 + 40);       // Size of the list
+	AVIOUTd(4 + 8 + 56 + 8 + 40 + SUPER_INDEX_SIZE); // Size of the list
 	AVIOUT4("strl");
 	// video stream header
 	AVIOUT4("strh");
@@ -133,6 +188,7 @@ AviWriter::~AviWriter()
 	AVIOUTd(0);                         // YPelsPerMeter
 	AVIOUTd(0);                         // ClrUsed: Number of colors used
 	AVIOUTd(0);                         // ClrImportant: Number of colors important
+	AVIOUTindx(0);
 
 	if (hasAudio) {
 		// 1 fragment is 1 (for mono) or 2 (for stereo) samples
@@ -140,11 +196,11 @@ AviWriter::~AviWriter()
 		unsigned bytesPerSample = bitsPerSample / 8;
 		unsigned bytesPerFragment = bytesPerSample * channels;
 		unsigned bytesPerSecond = audiorate * bytesPerFragment;
-		unsigned fragments = audiowritten / channels;
+		auto fragments = unsigned(audiowritten / channels);
 
 		// Audio stream list
 		AVIOUT4("LIST");
-		AVIOUTd(4 + 8 + 56 + 8 + 16);// Length of list in bytes
+		AVIOUTd(4 + 8 + 56 + 8 + 16 + SUPER_INDEX_SIZE); // Length of list in bytes
 		AVIOUT4("strl");
 		// The audio stream header
 		AVIOUT4("strh");
@@ -173,8 +229,19 @@ AviWriter::~AviWriter()
 		AVIOUTd(bytesPerSecond);    // AvgBytesPerSec
 		AVIOUTw(bytesPerFragment);  // BlockAlign: for PCM: nChannels * BitsPerSaple / 8
 		AVIOUTw(bitsPerSample);     // BitsPerSample
+		AVIOUTindx(1);
 	}
 
+	// OpenDML header: the total number of frames (in all RIFF lists)
+	AVIOUT4("LIST");
+	AVIOUTd(ODML_LIST_SIZE - 8);
+	AVIOUT4("odml");
+	AVIOUT4("dmlh");
+	AVIOUTd(248);                       // # of bytes to follow
+	unsigned dmlhEnd = header_pos + 248;
+	AVIOUTd(frames);                    // TotalFrames
+	header_pos = dmlhEnd;               // the rest is reserved (zero)
+
 	std::string versionStr = Version::full();
 
 	// The standard snprintf() function does always zero-terminate the
@@ -223,68 +290,259 @@ AviWriter::~AviWriter()
 	header_pos = AVI_HEADER_SIZE - 12;
 
 	AVIOUT4("LIST");
-	AVIOUTd(written + 4);               // Length of list in bytes
+	AVIOUTd(unsigned(firstMoviEnd - (AVI_HEADER_SIZE - 4))); // Length of list in bytes
 	AVIOUT4("movi");
 
-	try {
-		// First add the index table to the end
+	file.seek(0);
+	file.write(avi_header.data(), AVI_HEADER_SIZE);
+}
+
+// The data goes via a (large) buffer to the file.
+void AviWriter::write(const void* data, size_t size)
+{
+	if (writeBuffer.size() + size > WRITE_BUFFER_SIZE) {
+		flushBuffer();
+		if (size >= WRITE_BUFFER_SIZE) {
+			file.write(data, size);
+			filePos += size;
+			return;
+		}
+	}
+	const auto* p = static_cast<const uint8_t*>(data);
+	writeBuffer.insert(writeBuffer.end(), p, p + size);
+	filePos += size;
+}
+
+void AviWriter::flushBuffer()
+{
+	if (writeBuffer.empty()) return;
+	file.write(writeBuffer.data(), writeBuffer.size());
+	writeBuffer.clear();
+}
+
+// Fill in a (size) field of an already written header.
+void AviWriter::patch(uint64_t pos, uint32_t value)
+{
+	flushBuffer();
+	Endian::L32 v = value;
+	file.seek(pos);
+	file.write(&v, sizeof(v));
+	file.seek(filePos);
+}
+
+void AviWriter::startRiff()
+{
+	if (riffCount == SUPER_INDEX_ENTRIES) {
+		throw MSXException("Maximum size of the AVI file reached");
+	}
+	riffStart = filePos;
+	struct {
+		char riff[4]; Endian::L32 riffSize; char avix[4];
+		char list[4]; Endian::L32 listSize; char movi[4];
+	} header;
+	memcpy(header.riff, "RIFF", 4); header.riffSize = 0; // filled in later
+	memcpy(header.avix, "AVIX", 4);
+	memcpy(header.list, "LIST", 4); header.listSize = 0; // filled in later
+	memcpy(header.movi, "movi", 4);
+	write(&header, sizeof(header));
+	moviStart = filePos - 4;
+}
+
+void AviWriter::finishRiff()
+{
+	if (riffCount == 0) {
+		firstRiffFrames = unsigned(streamIndex[0].entries.size() / 2);
+	}
+	writeStdIndex(0);
+	if (audiorate) writeStdIndex(1);
+
+	if (riffCount == 0) {
+		firstMoviEnd = filePos;
+		// the classic index, after the 'movi' list
 		unsigned idxSize = unsigned(index.size()) * sizeof(Endian::L32);
-		index[0] = ('i' << 0) | ('d' << 8) | ('x' << 16) | ('1' << 24);
+		index[0] = fourcc("idx1");
 		index[1] = idxSize - 8;
-		file.write(&index[0], idxSize);
-		file.seek(0);
-		file.write(avi_header, AVI_HEADER_SIZE);
-	} catch (MSXException&) {
-		// can't throw from destructor
+		write(index.data(), idxSize);
+		index.clear();
+		index.shrink_to_fit();
+		firstRiffEnd = filePos;
+	} else {
+		patch(riffStart + 4, uint32_t(filePos - riffStart - 8));
+		patch(moviStart - 4, uint32_t(filePos - moviStart));
 	}
+	++riffCount;
+}
+
+// The OpenDML index of the chunks of one stream in the current RIFF list.
+void AviWriter::writeStdIndex(unsigned stream)
+{
+	auto& si = streamIndex[stream];
+	uint32_t size = uint32_t(8 + 24 + si.entries.size() * sizeof(Endian::L32));
+	struct {
+		char tag[4];
+		Endian::L32 size;
+		Endian::L16 longsPerEntry;
+		uint8_t indexSubType;
+		uint8_t indexType;
+		Endian::L32 entriesInUse;
+		Endian::L32 chunkId;
+		Endian::L32 baseOffsetLow;
+		Endian::L32 baseOffsetHigh;
+		Endian::L32 reserved;
+	} header;
+	static_assert(sizeof(header) == 8 + 24);
+	memcpy(header.tag, INDEX_TAGS[stream], 4);
+	header.size = size - 8;
+	header.longsPerEntry = 2;
+	header.indexSubType = 0;
+	header.indexType = 1; // AVI_INDEX_OF_CHUNKS
+	header.entriesInUse = uint32_t(si.entries.size() / 2);
+	header.chunkId = fourcc(STREAM_TAGS[stream]);
+	header.baseOffsetLow  = uint32_t(riffStart);
+	header.baseOffsetHigh = uint32_t(riffStart >> 32);
+	header.reserved = 0;
+
+	si.superIndex.push_back({filePos, size, si.duration});
+	write(&header, sizeof(header));
+	write(si.entries.data(), si.entries.size() * sizeof(Endian::L32));
+	si.entries.clear();
+	si.duration = 0;
 }
 
-void AviWriter::addAviChunk(const char* tag, size_t size_, const void* data, unsigned flags)
+void AviWriter::addAviChunk(unsigned stream, size_t size_, const void* data, bool keyFrame)
 {
+	assert(size_ < MAX_RIFF_SIZE);
+	auto size = uint32_t(size_);
+	uint32_t writesize = (size + 1) & ~1;
+
+	// Start a new RIFF list when this chunk (plus the indices) doesn't
+	// fit anymore.
+	uint64_t indexSize = 2 * (8 + 24) + 8 +
+		(streamIndex[0].entries.size() + streamIndex[1].entries.size() + 2) * sizeof(Endian::L32);
+	if (riffCount == 0) indexSize += (index.size() + 4) * sizeof(Endian::L32);
+	if ((filePos - riffStart) + 8 + writesize + indexSize > MAX_RIFF_SIZE) {
+		finishRiff();
+		startRiff();
+	}
+
+	if (riffCount == 0) {
+		size_t idxSize = index.size();
+		index.resize(idxSize + 4);
+		index[idxSize + 0] = fourcc(STREAM_TAGS[stream]);
+		index[idxSize + 1] = keyFrame ? 0x10 : 0x0;
+		index[idxSize + 2] = uint32_t(filePos - moviStart);
+		index[idxSize + 3] = size;
+	}
+	auto& entries = streamIndex[stream].entries;
+	entries.push_back(uint32_t(filePos + 8 - riffStart)); // position of the data
+	entries.push_back(size | (keyFrame ? 0 : 0x80000000));
+
 	struct {
 		char t[4];
 		Endian::L32 s;
 	} chunk;
+	memcpy(chunk.t, STREAM_TAGS[stream], sizeof(chunk.t));
+	chunk.s = size;
+	write(&chunk, sizeof(chunk));
+	write(data, size);
+	if (size & 1) {
+		uint8_t pad = 0;
+		write(&pad, 1);
+	}
+}
 
-	assert(size_ <= std::numeric_limits<uint32_t>::max());
-	auto size = uint32_t(size_);
+void AviWriter::addFrame(FrameSource* frame,
+                         std::shared_ptr<const FrameSource> sharedFrame,
+                         unsigned samples, int16_t* sampleData)
+{
+	assert((samples % channels) == 0);
+	Job* job;
+	{
+		std::unique_lock lock(mutex);
+		if (!error.empty()) {
+			throw MSXException(error);
+		}
+		if (freeJobs.empty() && (jobs.size() < MAX_QUEUED)) {
+			jobs.push_back(std::make_unique<Job>(codec.getFrameSize()));
+			freeJobs.push_back(jobs.back().get());
+		}
+		if (freeJobs.empty()) {
+			// encoder can't keep up, slow down the emulation
+			auto start = std::chrono::steady_clock::now();
+			jobDone.wait(lock, [&] { return !freeJobs.empty(); });
+			++stats.waits;
+			stats.waitTime += std::chrono::duration<double>(
+				std::chrono::steady_clock::now() - start).count();
+		}
+		job = freeJobs.back();
+		freeJobs.pop_back();
+		++stats.queued;
+	}
 
-	memcpy(chunk.t, tag, sizeof(chunk.t));
-	chunk.s = size;
-	file.write(&chunk, sizeof(chunk));
-
-	unsigned writesize = (size + 1) & ~1;
-	file.write(data, writesize);
-	unsigned pos = written + 4;
-	written += writesize + 8;
-
-	size_t idxSize = index.size();
-	index.resize(idxSize + 4);
-	memcpy(&index[idxSize], tag, sizeof(Endian::L32));
-	index[idxSize + 1] = flags;
-	index[idxSize + 2] = pos;
-	index[idxSize + 3] = size;
+	if (sharedFrame) {
+		// The encoder thread copies the frame, the post processor
+		// doesn't overwrite it while we hold a reference.
+		job->source = std::move(sharedFrame);
+	} else {
+		// The frame must be read now, it's recycled after this call.
+		// Note that copyFrame() doesn't touch the codec state.
+		codec.copyFrame(frame, job->frame.data());
+	}
+	job->pixelFormat = frame->getPixelFormat();
+	job->samples.assign(sampleData, sampleData + samples);
+	encoder.post([this, job] { encode(*job); });
 }
 
-void AviWriter::addFrame(FrameSource* frame, unsigned samples, int16_t* sampleData)
+void AviWriter::encode(Job& job)
 {
-	bool keyFrame = (frames++ % 300 == 0);
-	auto buffer = codec.compressFrame(keyFrame, frame);
-	addAviChunk("00dc", buffer.size(), buffer.data(), keyFrame ? 0x10 : 0x0);
-
-	if (samples) {
-		assert((samples % channels) == 0);
-		assert(audiorate != 0);
-		if constexpr (OPENMSX_BIGENDIAN) {
-			// See comment in WavWriter::write()
-			//VLA(Endian::L16, buf, samples); // doesn't work in clang
-			std::vector<Endian::L16> buf(sampleData, sampleData + samples);
-			addAviChunk("01wb", samples * sizeof(int16_t), buf.data(), 0);
-		} else {
-			addAviChunk("01wb", samples * sizeof(int16_t), sampleData, 0);
+	bool failed;
+	{
+		std::lock_guard lock(mutex);
+		failed = !error.empty();
+	}
+	if (job.source) {
+		if (!failed) codec.copyFrame(job.source.get(), job.frame.data());
+		job.source.reset(); // the frame can be reused now
+	}
+	if (!failed) {
+		try {
+			bool keyFrame = (frames++ % 300 == 0);
+			auto buffer = codec.compressFrame(keyFrame, job.frame.data(), job.pixelFormat);
+			addAviChunk(0, buffer.size(), buffer.data(), keyFrame);
+			++streamIndex[0].duration;
+
+			if (auto samples = unsigned(job.samples.size())) {
+				assert(audiorate != 0);
+				auto* sampleData = job.samples.data();
+				if constexpr (OPENMSX_BIGENDIAN) {
+					// See comment in WavWriter::write()
+					//VLA(Endian::L16, buf, samples); // doesn't work in clang
+					std::vector<Endian::L16> buf(sampleData, sampleData + samples);
+					addAviChunk(1, samples * sizeof(int16_t), buf.data(), true);
+				} else {
+					addAviChunk(1, samples * sizeof(int16_t), sampleData, true);
+				}
+				streamIndex[1].duration += samples / channels;
+				audiowritten += samples;
+			}
+		} catch (MSXException& e) {
+			std::lock_guard lock(mutex);
+			error = e.getMessage();
 		}
-		audiowritten += samples;
 	}
+
+	{
+		std::lock_guard lock(mutex);
+		freeJobs.push_back(&job);
+		--stats.queued;
+	}
+	jobDone.notify_one();
+}
+
+AviWriter::Stats AviWriter::getStats() const
+{
+	std::lock_guard lock(mutex);
+	return stats;
 }
 
 } // namespace openmsx
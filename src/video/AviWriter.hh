@@ -5,8 +5,16 @@
 
 #include "ZMBVEncoder.hh"
 #include "File.hh"
+#include "MemBuffer.hh"
+#include "PixelFormat.hh"
+#include "WorkerPool.hh"
+#include "aligned.hh"
 #include "endian.hh"
+#include <condition_variable>
 #include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
 #include <vector>
 
 namespace openmsx {
@@ -14,22 +22,107 @@ namespace openmsx {
 class Filename;
 class FrameSource;
 
+/** Writes an AVI file with ZMBV compressed video.
+  *
+  * The file uses the OpenDML (AVI 2.0) extensions, so it's not limited to
+  * 2GB (or 4GB): the data is split over RIFF lists of at most 1GB (the first
+  * one is 'AVI ', the following ones are 'AVIX'). Each of those ends with a
+  * standard index chunk per stream ('ix00', 'ix01'), and the (preallocated)
+  * super index in the header points to all of those. The first RIFF list
+  * also has a classic 'idx1' index, so players that don't know OpenDML can
+  * still play (the first part of) the file.
+  * All writes go through a large buffer, so the disk sees a few big writes
+  * instead of two small writes per chunk.
+  *
+  * The compression (and writing to the file) happens on a separate encoder
+  * thread: addFrame() only copies the frame and audio data in a (recycled)
+  * buffer and queues it. When the frame can be shared, even the copying
+  * (which also converts the frame to the output size) is done by the encoder
+  * thread. At most MAX_QUEUED frames are queued, when the
+  * encoder falls further behind addFrame() waits until a frame is done.
+  */
 class AviWriter
 {
+public:
+	static constexpr unsigned MAX_QUEUED = 8;
+
+	struct Stats {
+		unsigned queued; // number of frames waiting for the encoder
+		unsigned waits;  // number of times addFrame() had to wait
+		double waitTime; // total time addFrame() waited (in seconds)
+	};
+
 public:
 	AviWriter(const Filename& filename, unsigned width, unsigned height,
 	          unsigned bpp, unsigned channels, unsigned freq);
 	~AviWriter();
-	void addFrame(FrameSource* frame, unsigned samples, int16_t* sampleData);
+
+	/** Queue a frame, plus the audio samples that belong to it.
+	  * Throws MSXException when writing a previous frame failed.
+	  * @param sharedFrame nullptr or the same frame as 'frame', see
+	  *        AviRecorder::addImage().
+	  */
+	void addFrame(FrameSource* frame,
+	              std::shared_ptr<const FrameSource> sharedFrame,
+	              unsigned samples, int16_t* sampleData);
 	void setFps(float fps_) { fps = fps_; }
 
+	[[nodiscard]] Stats getStats() const;
+
 private:
-	void addAviChunk(const char* tag, size_t size, const void* data, unsigned flags);
+	struct Job {
+		explicit Job(unsigned frameSize) : frame(frameSize) {}
+		MemBuffer<uint8_t, SSE_ALIGNMENT> frame;
+		std::shared_ptr<const FrameSource> source; // not yet copied to 'frame'
+		std::vector<int16_t> samples;
+		PixelFormat pixelFormat;
+	};
+
+	// on the encoder thread
+	void encode(Job& job);
+	void addAviChunk(unsigned stream, size_t size, const void* data, bool keyFrame);
+	void startRiff();
+	void finishRiff();
+	void writeStdIndex(unsigned stream);
+	void write(const void* data, size_t size);
+	void flushBuffer();
+	void patch(uint64_t pos, uint32_t value);
+	void writeHeader();
 
 private:
+	// Shared between the main and the encoder thread, protected by 'mutex'.
+	mutable std::mutex mutex;
+	std::condition_variable jobDone;
+	std::vector<std::unique_ptr<Job>> jobs; // all allocated jobs
+	std::vector<Job*> freeJobs;
+	std::string error; // non-empty after a write error
+	Stats stats = {0, 0, 0.0};
+
+	// Only used by the encoder thread (or after it has finished).
 	File file;
 	ZMBVEncoder codec;
-	std::vector<Endian::L32> index;
+	std::vector<uint8_t> writeBuffer;
+	uint64_t filePos = 0; // including the not yet written buffered data
+
+	struct SuperIndexEntry {
+		uint64_t offset; // of the 'ix##' chunk
+		uint32_t size;   // of that chunk (including its header)
+		uint32_t duration; // in frames (video) or sample fragments (audio)
+	};
+	struct StreamIndex {
+		std::vector<Endian::L32> entries; // offset, size pairs (current RIFF)
+		uint32_t duration = 0; // of those entries
+		std::vector<SuperIndexEntry> superIndex;
+	};
+	StreamIndex streamIndex[2]; // video, audio
+	std::vector<Endian::L32> index; // classic 'idx1' (only the first RIFF)
+
+	uint64_t riffStart = 0; // offset of the current 'RIFF' tag
+	uint64_t moviStart = 0; // offset of the current 'movi' tag
+	uint64_t firstMoviEnd = 0;
+	uint64_t firstRiffEnd = 0;
+	unsigned riffCount = 0; // number of finished RIFF lists
+	unsigned firstRiffFrames = 0;
 
 	float fps;
 	const unsigned width;
@@ -38,8 +131,9 @@ private:
 	const unsigned audiorate;
 
 	unsigned frames;
-	unsigned audiowritten;
-	unsigned written;
+	uint64_t audiowritten;
+
+	WorkerPool encoder{1}; // a single thread, so frames stay in order
 };
 
 } // namespace openmsx
@@ -6,10 +6,196 @@
 #include "components.hh"
 #include <algorithm>
 #include <cstdint>
+#include <cstring>
 #include <tuple>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+#if defined(__SSSE3__)
+#include <tmmintrin.h>
+#define BITMAP_CONVERTER_SSSE3 1
+#define SSSE3_TARGET
+#elif defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+// Also build the SSSE3 version and select it at run time.
+#include <tmmintrin.h>
+#define BITMAP_CONVERTER_SSSE3 1
+#define BITMAP_CONVERTER_SSSE3_DISPATCH 1
+#define SSSE3_TARGET __attribute__((target("ssse3")))
+#endif
+#if defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#define BITMAP_CONVERTER_NEON 1
+#endif
 
 namespace openmsx {
 
+// The SIMD palette lookups below work on byte planes (see palettePlanes). A
+// 16-entry table of bytes fits in a single register, so 16 pixels can be
+// looked up with one shuffle instruction per byte of a Pixel.
+// On x86_64 the shuffle needs SSSE3, that's not part of the baseline (SSE2
+// is), so when it's not enabled at compile time it's selected at run time
+// (see BITMAP_CONVERTER_SSSE3_DISPATCH). On aarch64 NEON is always present.
+#ifdef BITMAP_CONVERTER_SSSE3
+
+[[nodiscard]] static inline bool useSsse3()
+{
+#ifdef BITMAP_CONVERTER_SSSE3_DISPATCH
+	static const bool result = __builtin_cpu_supports("ssse3");
+	return result;
+#else
+	return true;
+#endif
+}
+
+SSSE3_TARGET static inline __m128i lookupPlane(const uint8_t (&plane)[16], __m128i idx)
+{
+	return _mm_shuffle_epi8(
+		_mm_load_si128(reinterpret_cast<const __m128i*>(plane)), idx);
+}
+
+// Look up 16 palette indices (one per byte, each in range [0..15]) and store
+// the resulting 16 pixels.
+template<typename Pixel>
+SSSE3_TARGET static inline void lookup16(const uint8_t (&planes)[sizeof(Pixel)][16],
+                                         __m128i idx, Pixel* out)
+{
+	auto* o = reinterpret_cast<__m128i*>(out);
+	if constexpr (sizeof(Pixel) == 4) {
+		__m128i b0 = lookupPlane(planes[0], idx), b1 = lookupPlane(planes[1], idx);
+		__m128i b2 = lookupPlane(planes[2], idx), b3 = lookupPlane(planes[3], idx);
+		__m128i lo01 = _mm_unpacklo_epi8(b0, b1);
+		__m128i hi01 = _mm_unpackhi_epi8(b0, b1);
+		__m128i lo23 = _mm_unpacklo_epi8(b2, b3);
+		__m128i hi23 = _mm_unpackhi_epi8(b2, b3);
+		_mm_storeu_si128(o + 0, _mm_unpacklo_epi16(lo01, lo23));
+		_mm_storeu_si128(o + 1, _mm_unpackhi_epi16(lo01, lo23));
+		_mm_storeu_si128(o + 2, _mm_unpacklo_epi16(hi01, hi23));
+		_mm_storeu_si128(o + 3, _mm_unpackhi_epi16(hi01, hi23));
+	} else {
+		__m128i b0 = lookupPlane(planes[0], idx), b1 = lookupPlane(planes[1], idx);
+		_mm_storeu_si128(o + 0, _mm_unpacklo_epi8(b0, b1));
+		_mm_storeu_si128(o + 1, _mm_unpackhi_epi8(b0, b1));
+	}
+}
+
+// Convert 16 bytes of 4bpp data (high nibble first) to 32 pixels.
+template<typename Pixel>
+SSSE3_TARGET static inline void convert4bpp(const uint8_t (&planes)[sizeof(Pixel)][16],
+                                            __m128i data, Pixel* out)
+{
+	__m128i mask = _mm_set1_epi8(0x0F);
+	__m128i hi = _mm_and_si128(_mm_srli_epi16(data, 4), mask);
+	__m128i lo = _mm_and_si128(data, mask);
+	lookup16(planes, _mm_unpacklo_epi8(hi, lo), out +  0);
+	lookup16(planes, _mm_unpackhi_epi8(hi, lo), out + 16);
+}
+
+template<typename Pixel>
+SSSE3_TARGET static void renderGraphic4SSSE3(
+	const uint8_t (&planes)[sizeof(Pixel)][16],
+	const byte* __restrict vramPtr0, Pixel* __restrict pixelPtr)
+{
+	for (auto i : xrange(128 / 16)) {
+		__m128i data = _mm_loadu_si128(reinterpret_cast<const __m128i*>(vramPtr0) + i);
+		convert4bpp(planes, data, pixelPtr + 32 * i);
+	}
+}
+
+// Each byte contains 4 pixels of 2 bits, alternating between the even
+// (index 0-3) and odd (index 4-7) palette in palettePlanesG5.
+template<typename Pixel>
+SSSE3_TARGET static void renderGraphic5SSSE3(
+	const uint8_t (&planes)[sizeof(Pixel)][16],
+	const byte* __restrict vramPtr0, Pixel* __restrict pixelPtr)
+{
+	for (auto i : xrange(128 / 16)) {
+		__m128i data = _mm_loadu_si128(reinterpret_cast<const __m128i*>(vramPtr0) + i);
+		__m128i three = _mm_set1_epi8(3);
+		__m128i four  = _mm_set1_epi8(4);
+		__m128i a =                  _mm_and_si128(_mm_srli_epi16(data, 6), three);
+		__m128i b = _mm_or_si128(four, _mm_and_si128(_mm_srli_epi16(data, 4), three));
+		__m128i c =                  _mm_and_si128(_mm_srli_epi16(data, 2), three);
+		__m128i d = _mm_or_si128(four, _mm_and_si128(data, three));
+		__m128i abLo = _mm_unpacklo_epi8(a, b), abHi = _mm_unpackhi_epi8(a, b);
+		__m128i cdLo = _mm_unpacklo_epi8(c, d), cdHi = _mm_unpackhi_epi8(c, d);
+		Pixel* out = pixelPtr + 64 * i;
+		lookup16(planes, _mm_unpacklo_epi16(abLo, cdLo), out +  0);
+		lookup16(planes, _mm_unpackhi_epi16(abLo, cdLo), out + 16);
+		lookup16(planes, _mm_unpacklo_epi16(abHi, cdHi), out + 32);
+		lookup16(planes, _mm_unpackhi_epi16(abHi, cdHi), out + 48);
+	}
+}
+
+#elif defined(BITMAP_CONVERTER_NEON)
+
+template<typename Pixel>
+static inline void lookup16(const uint8_t (&planes)[sizeof(Pixel)][16],
+                            uint8x16_t idx, Pixel* out)
+{
+	auto* o = reinterpret_cast<uint8_t*>(out);
+	if constexpr (sizeof(Pixel) == 4) {
+		uint8x16x4_t b = {{
+			vqtbl1q_u8(vld1q_u8(planes[0]), idx),
+			vqtbl1q_u8(vld1q_u8(planes[1]), idx),
+			vqtbl1q_u8(vld1q_u8(planes[2]), idx),
+			vqtbl1q_u8(vld1q_u8(planes[3]), idx)}};
+		vst4q_u8(o, b); // interleaving store
+	} else {
+		uint8x16x2_t b = {{
+			vqtbl1q_u8(vld1q_u8(planes[0]), idx),
+			vqtbl1q_u8(vld1q_u8(planes[1]), idx)}};
+		vst2q_u8(o, b);
+	}
+}
+
+template<typename Pixel>
+static inline void convert4bpp(const uint8_t (&planes)[sizeof(Pixel)][16],
+                               uint8x16_t data, Pixel* out)
+{
+	uint8x16_t hi = vshrq_n_u8(data, 4);
+	uint8x16_t lo = vandq_u8(data, vdupq_n_u8(0x0F));
+	lookup16(planes, vzip1q_u8(hi, lo), out +  0);
+	lookup16(planes, vzip2q_u8(hi, lo), out + 16);
+}
+
+template<typename Pixel>
+static void renderGraphic4NEON(
+	const uint8_t (&planes)[sizeof(Pixel)][16],
+	const byte* __restrict vramPtr0, Pixel* __restrict pixelPtr)
+{
+	for (auto i : xrange(128 / 16)) {
+		convert4bpp(planes, vld1q_u8(vramPtr0 + 16 * i), pixelPtr + 32 * i);
+	}
+}
+
+// See renderGraphic5SSSE3().
+template<typename Pixel>
+static void renderGraphic5NEON(
+	const uint8_t (&planes)[sizeof(Pixel)][16],
+	const byte* __restrict vramPtr0, Pixel* __restrict pixelPtr)
+{
+	for (auto i : xrange(128 / 16)) {
+		uint8x16_t data = vld1q_u8(vramPtr0 + 16 * i);
+		uint8x16_t three = vdupq_n_u8(3);
+		uint8x16_t four  = vdupq_n_u8(4);
+		uint8x16_t a =               vshrq_n_u8(data, 6);
+		uint8x16_t b = vorrq_u8(four, vandq_u8(vshrq_n_u8(data, 4), three));
+		uint8x16_t c =               vandq_u8(vshrq_n_u8(data, 2), three);
+		uint8x16_t d = vorrq_u8(four, vandq_u8(data, three));
+		auto ab = [&](auto zip) { return vreinterpretq_u16_u8(zip(a, b)); };
+		auto cd = [&](auto zip) { return vreinterpretq_u16_u8(zip(c, d)); };
+		auto z1 = [](uint8x16_t x, uint8x16_t y) { return vzip1q_u8(x, y); };
+		auto z2 = [](uint8x16_t x, uint8x16_t y) { return vzip2q_u8(x, y); };
+		Pixel* out = pixelPtr + 64 * i;
+		lookup16(planes, vreinterpretq_u8_u16(vzip1q_u16(ab(z1), cd(z1))), out +  0);
+		lookup16(planes, vreinterpretq_u8_u16(vzip2q_u16(ab(z1), cd(z1))), out + 16);
+		lookup16(planes, vreinterpretq_u8_u16(vzip1q_u16(ab(z2), cd(z2))), out + 32);
+		lookup16(planes, vreinterpretq_u8_u16(vzip2q_u16(ab(z2), cd(z2))), out + 48);
+	}
+}
+
+#endif
+
 template<typename Pixel>
 BitmapConverter<Pixel>::BitmapConverter(
 	const Pixel* palette16_, const Pixel* palette256_,
@@ -36,6 +222,17 @@ void BitmapConverter<Pixel>::calcDPalette()
 			dPalette[16 * i + j] = dp;
 		}
 	}
+
+	auto setPlanes = [](uint8_t (&planes)[sizeof(Pixel)][16], int i, Pixel p) {
+		uint8_t bytes[sizeof(Pixel)];
+		memcpy(bytes, &p, sizeof(Pixel));
+		for (auto b : xrange(sizeof(Pixel))) planes[b][i] = bytes[b];
+	};
+	for (auto i : xrange(16)) {
+		setPlanes(palettePlanes, i, palette16[i]);
+		// Graphic5 only uses indices 0-7 (but initialize all, avoid UMR)
+		setPlanes(palettePlanesG5, i, palette16[((i & 4) << 2) | (i & 3)]);
+	}
 }
 
 template<typename Pixel>
@@ -127,6 +324,16 @@ void BitmapConverter<Pixel>::renderGraphic4(
 		calcDPalette();
 	}
 
+#if defined(BITMAP_CONVERTER_SSSE3)
+	if (useSsse3()) {
+		renderGraphic4SSSE3(palettePlanes, vramPtr0, pixelPtr);
+		return;
+	}
+#elif defined(BITMAP_CONVERTER_NEON)
+	renderGraphic4NEON(palettePlanes, vramPtr0, pixelPtr);
+	return;
+#endif
+
 	if ((sizeof(Pixel) == 2) && ((uintptr_t(pixelPtr) & 1) == 1)) {
 		// Its 16 bit destination but currently not aligned on a word boundary
 		// First write one pixel to get aligned
@@ -166,7 +373,7 @@ void BitmapConverter<Pixel>::renderGraphic4(
 				out[4 * i + 0] = dPalette[(data >>  0) & 0xFF];
 				out[4 * i + 1] = dPalette[(data >>  8) & 0xFF];
 				out[4 * i + 2] = dPalette[(data >> 16) & 0xFF];
-				if (i != (256-8) / 8) {
+				if (i == (256-8) / 8) {
 					// Last pixel in last iteration must be written individually
 					pixelPtr[254] = palette16[(data >> 24) & 0x0F];
 				} else {
@@ -207,6 +414,22 @@ void BitmapConverter<Pixel>::renderGraphic5(
 	Pixel*      __restrict pixelPtr,
 	const byte* __restrict vramPtr0)
 {
+#if defined(BITMAP_CONVERTER_SSSE3)
+	if (useSsse3()) {
+		if (unlikely(!dPaletteValid)) {
+			calcDPalette();
+		}
+		renderGraphic5SSSE3(palettePlanesG5, vramPtr0, pixelPtr);
+		return;
+	}
+#elif defined(BITMAP_CONVERTER_NEON)
+	if (unlikely(!dPaletteValid)) {
+		calcDPalette();
+	}
+	renderGraphic5NEON(palettePlanesG5, vramPtr0, pixelPtr);
+	return;
+#endif
+
 	for (auto i : xrange(128)) {
 		unsigned data = vramPtr0[i];
 		pixelPtr[4 * i + 0] = palette16[ 0 +  (data >> 6)     ];
@@ -233,6 +456,9 @@ void BitmapConverter<Pixel>::renderGraphic6(
 	if (unlikely(!dPaletteValid)) {
 		calcDPalette();
 	}
+
+	// Note: in this mode the SIMD lookup (see renderGraphic4) measured
+	// slower than the dPalette approach below.
 	      auto* out = reinterpret_cast<DPixel*>(pixelPtr);
 	const auto* in0 = reinterpret_cast<const unsigned*>(vramPtr0);
 	const auto* in1 = reinterpret_cast<const unsigned*>(vramPtr1);
@@ -282,12 +508,69 @@ static constexpr std::tuple<int, int, int> yjk2rgb(int y, int j, int k)
 	return {r, g, b};
 }
 
+#ifdef __SSE2__
+// Calculate the palette32768 indices for 16 YJK pixels (4 groups of 4) at
+// once. 'data' contains the pixel bytes in display order, so interleaved
+// from both planes. Same calculation as yjk2rgb(), but:
+// - The division by 4 is an arithmetic shift. This rounds differently for
+//   negative values, but these get clamped to 0 anyway.
+// - j and k are 6-bit signed values: sign extend via shifts.
+static inline void yjkIndices(__m128i data, uint16_t* result)
+{
+	__m128i zero = _mm_setzero_si128();
+	auto calc = [&](__m128i p) { // 8 pixels, one per 16-bit lane
+		// broadcast byte 'n' of each group of 4 to the whole group
+		auto bc = [&](auto shuffle) { return shuffle(p); };
+		__m128i p0 = bc([](__m128i x) { return _mm_shufflehi_epi16(_mm_shufflelo_epi16(x, 0x00), 0x00); });
+		__m128i p1 = bc([](__m128i x) { return _mm_shufflehi_epi16(_mm_shufflelo_epi16(x, 0x55), 0x55); });
+		__m128i p2 = bc([](__m128i x) { return _mm_shufflehi_epi16(_mm_shufflelo_epi16(x, 0xAA), 0xAA); });
+		__m128i p3 = bc([](__m128i x) { return _mm_shufflehi_epi16(_mm_shufflelo_epi16(x, 0xFF), 0xFF); });
+		__m128i seven = _mm_set1_epi16(7);
+		auto signed6 = [&](__m128i lo, __m128i hi) {
+			__m128i v = _mm_or_si128(_mm_slli_epi16(_mm_and_si128(hi, seven), 3),
+			                         _mm_and_si128(lo, seven));
+			return _mm_srai_epi16(_mm_slli_epi16(v, 10), 10);
+		};
+		__m128i j = signed6(p2, p3);
+		__m128i k = signed6(p0, p1);
+		__m128i y = _mm_srli_epi16(p, 3);
+
+		__m128i max = _mm_set1_epi16(31);
+		auto clamp = [&](__m128i v) { return _mm_min_epi16(_mm_max_epi16(v, zero), max); };
+		__m128i r = clamp(_mm_add_epi16(y, j));
+		__m128i g = clamp(_mm_add_epi16(y, k));
+		__m128i y5 = _mm_add_epi16(_mm_slli_epi16(y, 2), y);
+		__m128i b = clamp(_mm_srai_epi16(
+			_mm_sub_epi16(_mm_sub_epi16(y5, _mm_add_epi16(j, j)), k), 2));
+		return _mm_or_si128(_mm_or_si128(_mm_slli_epi16(r, 10),
+		                                 _mm_slli_epi16(g, 5)), b);
+	};
+	auto* out = reinterpret_cast<__m128i*>(result);
+	_mm_storeu_si128(out + 0, calc(_mm_unpacklo_epi8(data, zero)));
+	_mm_storeu_si128(out + 1, calc(_mm_unpackhi_epi8(data, zero)));
+}
+#endif
+
 template<typename Pixel>
 void BitmapConverter<Pixel>::renderYJK(
 	Pixel*      __restrict pixelPtr,
 	const byte* __restrict vramPtr0,
 	const byte* __restrict vramPtr1)
 {
+#ifdef __SSE2__
+	for (auto i : xrange(128 / 16)) {
+		__m128i d0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(vramPtr0) + i);
+		__m128i d1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(vramPtr1) + i);
+		uint16_t col[32];
+		yjkIndices(_mm_unpacklo_epi8(d0, d1), col +  0);
+		yjkIndices(_mm_unpackhi_epi8(d0, d1), col + 16);
+		for (auto n : xrange(32)) {
+			pixelPtr[32 * i + n] = palette32768[col[n]];
+		}
+	}
+	return;
+#endif
+
 	for (auto i : xrange(64)) {
 		unsigned p[4];
 		p[0] = vramPtr0[2 * i + 0];
@@ -313,6 +596,26 @@ void BitmapConverter<Pixel>::renderYAE(
 	const byte* __restrict vramPtr0,
 	const byte* __restrict vramPtr1)
 {
+#ifdef __SSE2__
+	for (auto i : xrange(128 / 16)) {
+		__m128i d0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(vramPtr0) + i);
+		__m128i d1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(vramPtr1) + i);
+		__m128i lo = _mm_unpacklo_epi8(d0, d1);
+		__m128i hi = _mm_unpackhi_epi8(d0, d1);
+		uint16_t col[32];
+		yjkIndices(lo, col +  0);
+		yjkIndices(hi, col + 16);
+		alignas(16) byte p[32];
+		_mm_store_si128(reinterpret_cast<__m128i*>(p) + 0, lo);
+		_mm_store_si128(reinterpret_cast<__m128i*>(p) + 1, hi);
+		for (auto n : xrange(32)) {
+			pixelPtr[32 * i + n] = (p[n] & 0x08) ? palette16[p[n] >> 4] // YAE
+			                                     : palette32768[col[n]]; // YJK
+		}
+	}
+	return;
+#endif
+
 	for (auto i : xrange(64)) {
 		unsigned p[4];
 		p[0] = vramPtr0[2 * i + 0];
@@ -95,6 +95,16 @@ private:
 
 	using DPixel = typename DoublePixel<sizeof(Pixel)>::type;
 	DPixel dPalette[16 * 16];
+
+	/** The 16-color palettes split in byte planes, for SIMD table lookups:
+	  * palettePlanes[b][i] is byte 'b' (in memory order) of palette16[i].
+	  * palettePlanesG5 is the same for Graphic5, entries 0-3 are the
+	  * colors for the even pixels, 4-7 for the odd pixels.
+	  * Like dPalette, these are only valid when dPaletteValid is true.
+	  */
+	alignas(16) uint8_t palettePlanes  [sizeof(Pixel)][16];
+	alignas(16) uint8_t palettePlanesG5[sizeof(Pixel)][16];
+
 	DisplayMode mode;
 	bool dPaletteValid;
 };
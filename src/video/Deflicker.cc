@@ -4,12 +4,26 @@
 #include "one_of.hh"
 #include "unreachable.hh"
 #include "vla.hh"
-#include "xrange.hh"
 #include "build-info.hh"
 #include <memory>
 #ifdef __SSE2__
 #include <emmintrin.h>
 #endif
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define DEFLICKER_AVX2 1
+#define AVX2_TARGET
+#elif defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+// Also build the AVX2 version and select it at run time.
+#include <immintrin.h>
+#define DEFLICKER_AVX2 1
+#define DEFLICKER_AVX2_DISPATCH 1
+#define AVX2_TARGET __attribute__((target("avx2")))
+#endif
+#if defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#define DEFLICKER_NEON 1
+#endif
 
 namespace openmsx {
 
@@ -17,7 +31,7 @@ template<typename Pixel> class DeflickerImpl final : public Deflicker
 {
 public:
 	DeflickerImpl(const PixelFormat& format,
-	              std::unique_ptr<RawFrame>* lastFrames);
+	              std::shared_ptr<RawFrame>* lastFrames);
 
 private:
 	[[nodiscard]] const void* getLineInfo(
@@ -31,7 +45,7 @@ private:
 
 std::unique_ptr<Deflicker> Deflicker::create(
 	const PixelFormat& format,
-	std::unique_ptr<RawFrame>* lastFrames)
+	std::shared_ptr<RawFrame>* lastFrames)
 {
 #if HAVE_16BPP
 	if (format.getBytesPerPixel() == 2) {
@@ -48,7 +62,7 @@ std::unique_ptr<Deflicker> Deflicker::create(
 
 
 Deflicker::Deflicker(const PixelFormat& format,
-                     std::unique_ptr<RawFrame>* lastFrames_)
+                     std::shared_ptr<RawFrame>* lastFrames_)
 	: FrameSource(format)
 	, lastFrames(lastFrames_)
 {
@@ -68,12 +82,16 @@ unsigned Deflicker::getLineWidth(unsigned line) const
 
 template<typename Pixel>
 DeflickerImpl<Pixel>::DeflickerImpl(const PixelFormat& format,
-                                    std::unique_ptr<RawFrame>* lastFrames_)
+                                    std::shared_ptr<RawFrame>* lastFrames_)
 	: Deflicker(format, lastFrames_)
 	, pixelOps(format)
 {
 }
 
+// The SIMD routines below process the largest multiple of the vector width
+// (in pixels) that fits in 'width', and return that amount. The caller
+// handles the remaining pixels.
+
 #ifdef __SSE2__
 template<typename Pixel>
 static __m128i blend(__m128i x, __m128i y, Pixel blendMask)
@@ -118,6 +136,125 @@ static __m128i compare(__m128i x, __m128i y)
 		return _mm_cmpeq_epi16(x, y);
 	}
 }
+
+template<typename Pixel>
+static size_t deflickerSSE2(
+	const Pixel* line0, const Pixel* line1, const Pixel* line2, const Pixel* line3,
+	Pixel* dst, size_t width, Pixel blendMask)
+{
+	size_t pixelsPerSSE = sizeof(__m128i) / sizeof(Pixel);
+	size_t widthSSE = width & ~(pixelsPerSSE - 1); // rounded down to a multiple of pixels in a SSE register
+	line0 += widthSSE;
+	line1 += widthSSE;
+	line2 += widthSSE;
+	line3 += widthSSE;
+	dst   += widthSSE;
+	auto byteOffst = -ptrdiff_t(widthSSE * sizeof(Pixel));
+
+	while (byteOffst < 0) {
+		__m128i a0 = uload(line0, byteOffst);
+		__m128i a1 = uload(line1, byteOffst);
+		__m128i a2 = uload(line2, byteOffst);
+		__m128i a3 = uload(line3, byteOffst);
+
+		__m128i e02 = compare<Pixel>(a0, a2); // a0 == a2
+		__m128i e13 = compare<Pixel>(a1, a3); // a1 == a3
+		__m128i cnd = _mm_and_si128(e02, e13); // (a0==a2) && (a1==a3)
+
+		__m128i a01 = blend(a0, a1, blendMask);
+		__m128i p = _mm_xor_si128(a0, a01);
+		__m128i q = _mm_and_si128(p, cnd);
+		__m128i r = _mm_xor_si128(q, a0); // select(a0, a01, cnd)
+
+		ustore(dst, byteOffst, r);
+		byteOffst += sizeof(__m128i);
+	}
+	return widthSSE;
+}
+#endif
+
+#ifdef DEFLICKER_AVX2
+// Same as the SSE2 version, but twice as many pixels per iteration.
+[[nodiscard]] static inline bool useAvx2()
+{
+#ifdef DEFLICKER_AVX2_DISPATCH
+	static const bool result = __builtin_cpu_supports("avx2");
+	return result;
+#else
+	return true;
+#endif
+}
+
+template<typename Pixel>
+AVX2_TARGET static size_t deflickerAVX2(
+	const Pixel* line0, const Pixel* line1, const Pixel* line2, const Pixel* line3,
+	Pixel* dst, size_t width, Pixel blendMask)
+{
+	static_assert(sizeof(Pixel) == one_of(2u, 4u));
+	constexpr size_t pixelsPerAVX = sizeof(__m256i) / sizeof(Pixel);
+	size_t widthAVX = width & ~(pixelsPerAVX - 1);
+	for (size_t x = 0; x < widthAVX; x += pixelsPerAVX) {
+		__m256i a0 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(line0 + x));
+		__m256i a1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(line1 + x));
+		__m256i a2 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(line2 + x));
+		__m256i a3 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(line3 + x));
+
+		__m256i cnd, a01;
+		if constexpr (sizeof(Pixel) == 4) {
+			cnd = _mm256_and_si256(_mm256_cmpeq_epi32(a0, a2),
+			                       _mm256_cmpeq_epi32(a1, a3));
+			a01 = _mm256_avg_epu8(a0, a1);
+		} else {
+			cnd = _mm256_and_si256(_mm256_cmpeq_epi16(a0, a2),
+			                       _mm256_cmpeq_epi16(a1, a3));
+			// (x & y) + (((x ^ y) & blendMask) >> 1)
+			__m256i m = _mm256_set1_epi16(blendMask);
+			__m256i a = _mm256_and_si256(a0, a1);
+			__m256i b = _mm256_and_si256(_mm256_xor_si256(a0, a1), m);
+			a01 = _mm256_add_epi16(a, _mm256_srli_epi16(b, 1));
+		}
+		__m256i r = _mm256_blendv_epi8(a0, a01, cnd); // select(a0, a01, cnd)
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + x), r);
+	}
+	return widthAVX;
+}
+#endif
+
+#ifdef DEFLICKER_NEON
+template<typename Pixel>
+static size_t deflickerNEON(
+	const Pixel* line0, const Pixel* line1, const Pixel* line2, const Pixel* line3,
+	Pixel* dst, size_t width, Pixel blendMask)
+{
+	static_assert(sizeof(Pixel) == one_of(2u, 4u));
+	constexpr size_t pixelsPerNEON = 16 / sizeof(Pixel);
+	size_t widthNEON = width & ~(pixelsPerNEON - 1);
+	for (size_t x = 0; x < widthNEON; x += pixelsPerNEON) {
+		if constexpr (sizeof(Pixel) == 4) {
+			uint32x4_t a0 = vld1q_u32(line0 + x);
+			uint32x4_t a1 = vld1q_u32(line1 + x);
+			uint32x4_t a2 = vld1q_u32(line2 + x);
+			uint32x4_t a3 = vld1q_u32(line3 + x);
+			uint32x4_t cnd = vandq_u32(vceqq_u32(a0, a2), vceqq_u32(a1, a3));
+			// per component rounding average, like _mm_avg_epu8()
+			uint32x4_t a01 = vreinterpretq_u32_u8(vrhaddq_u8(
+				vreinterpretq_u8_u32(a0), vreinterpretq_u8_u32(a1)));
+			vst1q_u32(dst + x, vbslq_u32(cnd, a01, a0));
+		} else {
+			uint16x8_t a0 = vld1q_u16(line0 + x);
+			uint16x8_t a1 = vld1q_u16(line1 + x);
+			uint16x8_t a2 = vld1q_u16(line2 + x);
+			uint16x8_t a3 = vld1q_u16(line3 + x);
+			uint16x8_t cnd = vandq_u16(vceqq_u16(a0, a2), vceqq_u16(a1, a3));
+			// (x & y) + (((x ^ y) & blendMask) >> 1)
+			uint16x8_t a = vandq_u16(a0, a1);
+			uint16x8_t b = vandq_u16(veorq_u16(a0, a1), vdupq_n_u16(blendMask));
+			uint16x8_t a01 = vaddq_u16(a, vshrq_n_u16(b, 1));
+			vst1q_u16(dst + x, vbslq_u16(cnd, a01, a0));
+		}
+	}
+	return widthNEON;
+}
 #endif
 
 template<typename Pixel>
@@ -149,43 +286,26 @@ const void* DeflickerImpl<Pixel>::getLineInfo(
 	// sequence with length (at least) 4. Or IOW we look for "A B A B".
 	// The implementation below also detects a constant pixel value
 	// "A A A A" as alternating between "A" and "A", but that's fine.
-	Pixel* dst = out;
-	unsigned remaining = width0;
-#ifdef __SSE2__
-	size_t pixelsPerSSE = sizeof(__m128i) / sizeof(Pixel);
-	size_t widthSSE = remaining & ~(pixelsPerSSE - 1); // rounded down to a multiple of pixels in a SSE register
-	line0 += widthSSE;
-	line1 += widthSSE;
-	line2 += widthSSE;
-	line3 += widthSSE;
-	dst   += widthSSE;
-	auto byteOffst = -ptrdiff_t(widthSSE * sizeof(Pixel));
-
+	size_t x = 0;
+#if defined(DEFLICKER_AVX2) || defined(__SSE2__) || defined(DEFLICKER_NEON)
 	Pixel blendMask = pixelOps.getBlendMask();
-	while (byteOffst < 0) {
-		__m128i a0 = uload(line0, byteOffst);
-		__m128i a1 = uload(line1, byteOffst);
-		__m128i a2 = uload(line2, byteOffst);
-		__m128i a3 = uload(line3, byteOffst);
-
-		__m128i e02 = compare<Pixel>(a0, a2); // a0 == a2
-		__m128i e13 = compare<Pixel>(a1, a3); // a1 == a3
-		__m128i cnd = _mm_and_si128(e02, e13); // (a0==a2) && (a1==a3)
-
-		__m128i a01 = blend(a0, a1, blendMask);
-		__m128i p = _mm_xor_si128(a0, a01);
-		__m128i q = _mm_and_si128(p, cnd);
-		__m128i r = _mm_xor_si128(q, a0); // select(a0, a01, cnd)
-
-		ustore(dst, byteOffst, r);
-		byteOffst += sizeof(__m128i);
+#endif
+#ifdef DEFLICKER_AVX2
+	if (useAvx2()) {
+		x = deflickerAVX2(line0, line1, line2, line3, out, width0, blendMask);
 	}
-	remaining &= pixelsPerSSE - 1;
 #endif
-	for (auto x : xrange(remaining)) {
-		dst[x] = ((line0[x] == line2[x]) && (line1[x] == line3[x]))
+#if defined(__SSE2__)
+	x += deflickerSSE2(line0 + x, line1 + x, line2 + x, line3 + x,
+	                   out + x, width0 - x, blendMask);
+#elif defined(DEFLICKER_NEON)
+	x += deflickerNEON(line0 + x, line1 + x, line2 + x, line3 + x,
+	                   out + x, width0 - x, blendMask);
+#endif
+	for (/**/; x < width0; ++x) {
+		out[x] = ((line0[x] == line2[x]) && (line1[x] == line3[x]))
 		       ? pixelOps.template blend<1, 1>(line0[x], line1[x])
-	               : line0[x];
+		       : line0[x];
 	}
 
 	if (width0 <= bufWidth) {
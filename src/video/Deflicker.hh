@@ -14,18 +14,18 @@ public:
 	// Factory method, actually returns a Deflicker subclass.
 	[[nodiscard]] static std::unique_ptr<Deflicker> create(
 		const PixelFormat& format,
-		std::unique_ptr<RawFrame>* lastFrames);
+		std::shared_ptr<RawFrame>* lastFrames);
 	void init();
 	virtual ~Deflicker() = default;
 
 protected:
 	Deflicker(const PixelFormat& format,
-	          std::unique_ptr<RawFrame>* lastFrames);
+	          std::shared_ptr<RawFrame>* lastFrames);
 
 	[[nodiscard]] unsigned getLineWidth(unsigned line) const override;
 
 protected:
-	std::unique_ptr<RawFrame>* lastFrames;
+	std::shared_ptr<RawFrame>* lastFrames;
 };
 
 } // namespace openmsx
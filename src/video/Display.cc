@@ -8,13 +8,16 @@
 #include "FileOperations.hh"
 #include "FileContext.hh"
 #include "CliComm.hh"
+#include "PerfTimers.hh"
 #include "Timer.hh"
 #include "BooleanSetting.hh"
 #include "IntegerSetting.hh"
 #include "EnumSetting.hh"
 #include "Reactor.hh"
+#include "InputEventGenerator.hh"
 #include "MSXMotherBoard.hh"
 #include "HardwareConfig.hh"
+#include "PNG.hh"
 #include "TclArgParser.hh"
 #include "XMLElement.hh"
 #include "VideoSystemChangeListener.hh"
@@ -314,6 +317,7 @@ void Display::doRendererSwitch()
 
 void Display::doRendererSwitch2()
 {
+	PerfTimers::Scope perf(PerfTimers::VIDEO_INIT);
 	for (auto& l : listeners) {
 		l->preVideoSystemChange();
 	}
@@ -341,11 +345,13 @@ void Display::repaintImpl()
 
 	cancelRT(); // cancel delayed repaint
 
-	if (!renderFrozen) {
+	if (!renderFrozen && !reactor.getInputEventGenerator().isWindowHidden()) {
 		assert(videoSystem);
 		if (OutputSurface* surface = videoSystem->getOutputSurface()) {
 			repaintImpl(*surface);
+			auto flushStart = Timer::getTime();
 			videoSystem->flush();
+			presentWait = Timer::getTime() - flushStart;
 		}
 	}
 
@@ -361,6 +367,8 @@ void Display::repaintImpl(OutputSurface& surface)
 {
 	for (auto it = baseLayer(); it != end(layers); ++it) {
 		if ((*it)->getCoverage() != Layer::COVER_NONE) {
+			PerfTimers::Scope perf(((*it)->getZ() <= Layer::Z_MSX_ACTIVE)
+				? PerfTimers::POSTPROCESS : PerfTimers::OSD);
 			(*it)->paint(surface);
 		}
 	}
@@ -418,16 +426,38 @@ void Display::ScreenShotCmd::execute(span<const TclObject> tokens, TclObject& re
 	bool msxOnly = false;
 	bool doubleSize = false;
 	bool withOsd = false;
+	bool hash = false;
+	std::string_view compression = "default";
+	std::string_view machine;
+	PNG::SaveOptions options;
 	ArgsInfo info[] = {
 		valueArg("-prefix", prefix),
 		flagArg("-raw", rawShot),
 		flagArg("-msxonly", msxOnly),
 		flagArg("-doublesize", doubleSize),
-		flagArg("-with-osd", withOsd)
+		flagArg("-with-osd", withOsd),
+		flagArg("-async", options.async),
+		flagArg("-hash", hash),
+		valueArg("-compression", compression),
+		valueArg("-machine", machine),
 	};
 	auto arguments = parseTclArgs(getInterpreter(), tokens.subspan(1), info);
 
 	auto& display = OUTER(Display, screenShotCmd);
+	for (const auto& error : PNG::takeAsyncErrors()) {
+		display.getCliComm().printWarning(
+			"Failed to save screenshot: ", error);
+	}
+	if (compression == "default") {
+		options.compression = PNG::SaveOptions::Compression::DEFAULT;
+	} else if (compression == "fast") {
+		options.compression = PNG::SaveOptions::Compression::FAST;
+	} else if (compression == "none") {
+		options.compression = PNG::SaveOptions::Compression::NONE;
+	} else {
+		throw CommandException("Unknown compression '", compression,
+		                       "', must be one of default, fast or none");
+	}
 	if (msxOnly) {
 		display.getCliComm().printWarning(
 			"The -msxonly option has been deprecated and will "
@@ -435,14 +465,22 @@ void Display::ScreenShotCmd::execute(span<const TclObject> tokens, TclObject& re
 			"-raw option for the same effect.");
 		rawShot = true;
 	}
-	if (doubleSize && !rawShot) {
+	if (doubleSize && !rawShot && !hash) {
 		throw CommandException("-doublesize option can only be used in "
-		                       "combination with -raw");
+		                       "combination with -raw or -hash");
 	}
 	if (rawShot && withOsd) {
 		throw CommandException("-with-osd cannot be used in "
 		                       "combination with -raw");
 	}
+	if (hash && withOsd) {
+		throw CommandException("-with-osd cannot be used in "
+		                       "combination with -hash");
+	}
+	if (!machine.empty() && !rawShot && !hash) {
+		throw CommandException("-machine option can only be used in "
+		                       "combination with -raw or -hash");
+	}
 
 	std::string_view fname;
 	switch (arguments.size()) {
@@ -455,34 +493,62 @@ void Display::ScreenShotCmd::execute(span<const TclObject> tokens, TclObject& re
 	default:
 		throw SyntaxError();
 	}
+	auto getVideoLayer = [&] {
+		if (!machine.empty()) {
+			// Also for a machine that's not the active one, e.g. one
+			// that renders in the background ('run_machines -render').
+			for (auto* l : display.layers) {
+				auto* v = dynamic_cast<VideoLayer*>(l);
+				if (v && v->needRecord() &&
+				    (v->getMotherBoard().getMachineID() == machine)) {
+					return v;
+				}
+			}
+			throw CommandException("No video of machine: ", machine);
+		}
+		auto* videoLayer = dynamic_cast<VideoLayer*>(
+			display.findActiveLayer());
+		if (!videoLayer) {
+			throw CommandException(
+				"Current renderer doesn't support taking screenshots.");
+		}
+		return videoLayer;
+	};
+	unsigned height = doubleSize ? 480 : 240;
+
+	if (hash) {
+		// no file at all, e.g. to compare with a known good frame
+		if (!fname.empty()) {
+			throw CommandException("-hash doesn't write a file");
+		}
+		result = strCat(hex_string<8>(getVideoLayer()->getRawFrameHash(height)));
+		return;
+	}
+
 	string filename = FileOperations::parseCommandFileArgument(
 		fname, "screenshots", prefix, ".png");
 
 	if (!rawShot) {
 		// include all layers (OSD stuff, console)
 		try {
-			display.getVideoSystem().takeScreenShot(filename, withOsd);
+			display.getVideoSystem().takeScreenShot(filename, withOsd, options);
 		} catch (MSXException& e) {
 			throw CommandException(
 				"Failed to take screenshot: ", e.getMessage());
 		}
 	} else {
-		auto* videoLayer = dynamic_cast<VideoLayer*>(
-			display.findActiveLayer());
-		if (!videoLayer) {
-			throw CommandException(
-				"Current renderer doesn't support taking screenshots.");
-		}
-		unsigned height = doubleSize ? 480 : 240;
 		try {
-			videoLayer->takeRawScreenShot(height, filename);
+			getVideoLayer()->takeRawScreenShot(height, filename, options);
 		} catch (MSXException& e) {
 			throw CommandException(
 				"Failed to take screenshot: ", e.getMessage());
 		}
 	}
 
-	display.getCliComm().printInfo("Screen saved to ", filename);
+	if (machine.empty()) {
+		// not for e.g. the periodic thumbnails of background machines
+		display.getCliComm().printInfo("Screen saved to ", filename);
+	}
 	result = filename;
 }
 
@@ -495,7 +561,12 @@ string Display::ScreenShotCmd::help(span<const TclObject> /*tokens*/) const
 	       "screenshot -raw              320x240 raw screenshot (of MSX screen only)\n"
 	       "screenshot -raw -doublesize  640x480 raw screenshot (of MSX screen only)\n"
 	       "screenshot -with-osd         Include OSD elements in the screenshot\n"
-	       "screenshot -no-sprites       Don't include sprites in the screenshot\n";
+	       "screenshot -no-sprites       Don't include sprites in the screenshot\n"
+	       "screenshot -hash [-doublesize] Return a hash of the raw MSX screen (no file)\n"
+	       "screenshot -async            Save the file in the background, errors are\n"
+	       "                             reported by the next screenshot command\n"
+	       "screenshot -compression <c>  Use 'default', 'fast' or 'none' compression\n"
+	       "screenshot -raw -machine <id>  Raw screenshot of the given (e.g. background) machine\n";
 }
 
 void Display::ScreenShotCmd::tabCompletion(std::vector<string>& tokens) const
@@ -503,6 +574,7 @@ void Display::ScreenShotCmd::tabCompletion(std::vector<string>& tokens) const
 	using namespace std::literals;
 	static constexpr std::array extra = {
 		"-prefix"sv, "-raw"sv, "-doublesize"sv, "-with-osd"sv, "-no-sprites"sv,
+		"-hash"sv, "-async"sv, "-compression"sv, "-machine"sv,
 	};
 	completeFileName(tokens, userFileContext(), extra);
 }
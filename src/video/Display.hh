@@ -66,6 +66,11 @@ public:
 
 	[[nodiscard]] std::string getWindowTitle();
 
+	/** How long (in us) the last flush of the output surface took. With
+	  * vsync enabled this is mostly the time spent waiting for the host
+	  * vertical retrace, see RealTime (frame pacing). */
+	[[nodiscard]] uint64_t getPresentWait() const { return presentWait; }
+
 private:
 	void resetVideoSystem();
 
@@ -100,6 +105,7 @@ private:
 	CircularBuffer<uint64_t, NUM_FRAME_DURATIONS> frameDurations;
 	uint64_t frameDurationSum;
 	uint64_t prevTimeStamp;
+	uint64_t presentWait = 0;
 
 	struct ScreenShotCmd final : Command {
 		explicit ScreenShotCmd(CommandController& commandController);
@@ -6,6 +6,7 @@
 #include "Scaler.hh"
 #include "ScalerFactory.hh"
 #include "SDLOutputSurface.hh"
+#include "WorkerPool.hh"
 #include "aligned.hh"
 #include "checked_cast.hh"
 #include "random.hh"
@@ -16,6 +17,7 @@
 #include <cstdint>
 #include <cstddef>
 #include <numeric>
+#include <thread>
 #ifdef __SSE2__
 #include <emmintrin.h>
 #endif
@@ -224,7 +226,7 @@ void FBPostProcessor<Pixel>::update(const Setting& setting) noexcept
 	VideoLayer::update(setting);
 	auto& noiseSetting = renderSettings.getNoiseSetting();
 	if (&setting == &noiseSetting) {
-		preCalcNoise(noiseSetting.getDouble());
+		noiseDirty = true; // regenerate (only once) in the next paint()
 	}
 }
 
@@ -259,6 +261,11 @@ template<typename Pixel>
 void FBPostProcessor<Pixel>::paint(OutputSurface& output_)
 {
 	auto& output = checked_cast<SDLOutputSurface&>(output_);
+	if (noiseDirty) {
+		noiseDirty = false;
+		preCalcNoise(renderSettings.getNoiseSetting().getDouble());
+	}
+
 	if (renderSettings.getInterleaveBlackFrame()) {
 		interleaveCount ^= 1;
 		if (interleaveCount) {
@@ -270,11 +277,16 @@ void FBPostProcessor<Pixel>::paint(OutputSurface& output_)
 	if (!paintFrame) return;
 
 	// New scaler algorithm selected? Or different horizontal stretch?
+	// MLAA looks for edges within the scaled region, splitting the image
+	// in bands would give visible seams.
 	auto algo = renderSettings.getScaleAlgorithm();
 	unsigned factor = renderSettings.getScaleFactor();
 	unsigned inWidth = lrintf(renderSettings.getHorizontalStretch());
+	unsigned numBands = (algo == RenderSettings::SCALER_MLAA)
+	                  ? 1 : getNumScaleThreads();
 	if ((scaleAlgorithm != algo) || (scaleFactor != factor) ||
-	    (inWidth != stretchWidth) || (lastOutput != &output)) {
+	    (inWidth != stretchWidth) || (lastOutput != &output) ||
+	    ((bands.size() + 1) != numBands)) {
 		scaleAlgorithm = algo;
 		scaleFactor = factor;
 		stretchWidth = inWidth;
@@ -284,6 +296,23 @@ void FBPostProcessor<Pixel>::paint(OutputSurface& output_)
 			renderSettings);
 		stretchScaler = StretchScalerOutputFactory<Pixel>::create(
 			output, pixelOps, inWidth);
+
+		if (workers && (workers->getNumThreads() != (numBands - 1))) {
+			workers.reset();
+		}
+		bands.clear();
+		for (unsigned i = 1; i < numBands; ++i) {
+			bands.push_back(Band{
+				ScalerFactory<Pixel>::createScaler(
+					PixelOperations<Pixel>(output.getPixelFormat()),
+					renderSettings),
+				StretchScalerOutputFactory<Pixel>::create(
+					output, pixelOps, inWidth),
+				{}});
+		}
+		if (!bands.empty() && !workers) {
+			workers = std::make_unique<WorkerPool>(unsigned(bands.size()));
+		}
 	}
 
 	// Scale image.
@@ -296,6 +325,7 @@ void FBPostProcessor<Pixel>::paint(OutputSurface& output_)
 
 	// TODO: Store all MSX lines in RawFrame and only scale the ones that fit
 	//       on the PC screen, as a preparation for resizable output window.
+	std::vector<Region> regions;
 	unsigned srcStartY = 0;
 	unsigned dstStartY = 0;
 	while (dstStartY < dstHeight) {
@@ -313,27 +343,101 @@ void FBPostProcessor<Pixel>::paint(OutputSurface& output_)
 			dstEndY += dstStep;
 		}
 
-		// fill region
-		//fprintf(stderr, "post processing lines %d-%d: %d\n",
-		//        srcStartY, srcEndY, lineWidth);
-		currScaler->scaleImage(
-			*paintFrame, superImposeVideoFrame,
-			srcStartY, srcEndY, lineWidth, // source
-			*stretchScaler, dstStartY, dstEndY); // dest
+		regions.push_back({srcStartY, srcEndY, lineWidth, dstStartY, dstEndY});
 
 		// next region
 		srcStartY = srcEndY;
 		dstStartY = dstEndY;
 	}
 
+	if (bands.empty()) {
+		for (const auto& r : regions) {
+			//fprintf(stderr, "post processing lines %d-%d: %d\n",
+			//        r.srcStartY, r.srcEndY, r.lineWidth);
+			currScaler->scaleImage(
+				*paintFrame, superImposeVideoFrame,
+				r.srcStartY, r.srcEndY, r.lineWidth, // source
+				*stretchScaler, r.dstStartY, r.dstEndY); // dest
+		}
+	} else {
+		scaleBands(regions, dstHeight);
+	}
+
 	drawNoise(output);
 
 	output.flushFrameBuffer();
 }
 
 template<typename Pixel>
-std::unique_ptr<RawFrame> FBPostProcessor<Pixel>::rotateFrames(
-	std::unique_ptr<RawFrame> finishedFrame, EmuTime::param time)
+unsigned FBPostProcessor<Pixel>::getNumScaleThreads() const
+{
+	unsigned num = renderSettings.getScaleThreads();
+	if (num == 0) {
+		// automatic: one band per core
+		static const unsigned cores = std::thread::hardware_concurrency();
+		num = std::clamp(cores, 1u, unsigned(RenderSettings::MAX_SCALE_THREADS));
+	}
+	return num;
+}
+
+template<typename Pixel>
+void FBPostProcessor<Pixel>::scaleBands(
+	const std::vector<Region>& regions, unsigned dstHeight)
+{
+	// Divide the output lines in (roughly) equal parts. Regions are only
+	// split at a multiple of their step size, so each band scales whole
+	// groups of source lines.
+	unsigned numBands = unsigned(bands.size()) + 1;
+	std::vector<Region> firstBand;
+	for (auto& band : bands) band.regions.clear();
+	auto bandRegions = [&](unsigned b) -> std::vector<Region>& {
+		return (b == 0) ? firstBand : bands[b - 1].regions;
+	};
+	for (auto r : regions) {
+		unsigned srcStep = (r.srcEndY - r.srcStartY);
+		unsigned dstStep = (r.dstEndY - r.dstStartY);
+		// paint() made the steps coprime, this recovers them
+		unsigned g = std::gcd(srcStep, dstStep);
+		srcStep /= g;
+		dstStep /= g;
+		while (r.dstStartY < r.dstEndY) {
+			unsigned b = std::min(r.dstStartY * numBands / dstHeight, numBands - 1);
+			unsigned bandEnd = (b + 1) * dstHeight / numBands;
+			unsigned steps = (std::min(bandEnd, r.dstEndY) - r.dstStartY + dstStep - 1) / dstStep;
+			Region part = r;
+			part.srcEndY = std::min(r.srcStartY + steps * srcStep, r.srcEndY);
+			part.dstEndY = std::min(r.dstStartY + steps * dstStep, r.dstEndY);
+			bandRegions(b).push_back(part);
+			r.srcStartY = part.srcEndY;
+			r.dstStartY = part.dstEndY;
+		}
+	}
+
+	auto* frame = paintFrame;
+	auto* superImpose = superImposeVideoFrame;
+	for (auto& band : bands) {
+		if (band.regions.empty()) continue;
+		workers->post([&band, frame, superImpose] {
+			for (const auto& r : band.regions) {
+				band.scaler->scaleImage(
+					*frame, superImpose,
+					r.srcStartY, r.srcEndY, r.lineWidth,
+					*band.output, r.dstStartY, r.dstEndY);
+			}
+		});
+	}
+	for (const auto& r : firstBand) {
+		currScaler->scaleImage(
+			*paintFrame, superImposeVideoFrame,
+			r.srcStartY, r.srcEndY, r.lineWidth,
+			*stretchScaler, r.dstStartY, r.dstEndY);
+	}
+	workers->wait();
+}
+
+template<typename Pixel>
+std::shared_ptr<RawFrame> FBPostProcessor<Pixel>::rotateFrames(
+	std::shared_ptr<RawFrame> finishedFrame, EmuTime::param time)
 {
 	auto& generator = global_urng(); // fast (non-cryptographic) random numbers
 	std::uniform_int_distribution<int> distribution(0, NOISE_SHIFT / 16 - 1);
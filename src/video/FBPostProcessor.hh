@@ -5,12 +5,14 @@
 #include "RenderSettings.hh"
 #include "PixelOperations.hh"
 #include "ScalerOutput.hh"
+#include <memory>
 #include <vector>
 
 namespace openmsx {
 
 class MSXMotherBoard;
 class Display;
+class WorkerPool;
 template<typename Pixel> class Scaler;
 
 /** Rasterizer using SDL.
@@ -30,10 +32,25 @@ public:
 	// Layer interface:
 	void paint(OutputSurface& output) override;
 
-	[[nodiscard]] std::unique_ptr<RawFrame> rotateFrames(
-		std::unique_ptr<RawFrame> finishedFrame, EmuTime::param time) override;
+	[[nodiscard]] std::shared_ptr<RawFrame> rotateFrames(
+		std::shared_ptr<RawFrame> finishedFrame, EmuTime::param time) override;
 
 private:
+	/** A part of the output image with equal line width. */
+	struct Region {
+		unsigned srcStartY, srcEndY, lineWidth, dstStartY, dstEndY;
+	};
+	/** Scaler and output for one band of the image. Each thread needs its
+	  * own instances, both contain state that's modified while scaling.
+	  */
+	struct Band {
+		std::unique_ptr<Scaler<Pixel>> scaler;
+		std::unique_ptr<ScalerOutput<Pixel>> output;
+		std::vector<Region> regions;
+	};
+
+	[[nodiscard]] unsigned getNumScaleThreads() const;
+	void scaleBands(const std::vector<Region>& regions, unsigned dstHeight);
 	void preCalcNoise(float factor);
 	void drawNoise(OutputSurface& output);
 	void drawNoiseLine(Pixel* buf, signed char* noise,
@@ -63,6 +80,12 @@ private:
 	  */
 	unsigned stretchWidth;
 
+	/** Scalers for the additional threads (when scaler_threads > 1),
+	  * 'currScaler' (on the main thread) handles the first band.
+	  */
+	std::vector<Band> bands;
+	std::unique_ptr<WorkerPool> workers;
+
 	/** Last used output, need to recreate 'stretchScaler' when this changes.
 	  */
 	OutputSurface* lastOutput = nullptr;
@@ -71,6 +94,9 @@ private:
 	 */
 	std::vector<unsigned> noiseShift;
 
+	/** Noise setting changed, regenerate the noise in the next paint(). */
+	bool noiseDirty = false;
+
 	PixelOperations<Pixel> pixelOps;
 };
 
@@ -87,6 +87,10 @@ public:
 	  * is tied to the lifetime of that work buffer. In any case the return
 	  * value of this function will point to the line data (some internal
 	  * buffer or the work buffer).
+	  * Scaled lines are not cached: consumers request each line only once
+	  * per paint, and most lines already have the requested width (border
+	  * lines have width 1, scaling those is a fill). To process many lines
+	  * in one pass, see getMultiLinePtr().
 	  */
 	template<typename Pixel>
 	[[nodiscard]] inline const Pixel* getLinePtr(int line, unsigned width, Pixel* buf) const
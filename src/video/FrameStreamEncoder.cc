@@ -0,0 +1,83 @@
+#include "FrameStreamEncoder.hh"
+#include "lz4.hh"
+#include <algorithm>
+#include <cassert>
+
+namespace openmsx {
+
+static void append16(std::vector<uint8_t>& buf, unsigned v)
+{
+	buf.push_back(uint8_t(v >> 0));
+	buf.push_back(uint8_t(v >> 8));
+}
+
+static void append32(std::vector<uint8_t>& buf, size_t v)
+{
+	append16(buf, unsigned(v >>  0) & 0xffff);
+	append16(buf, unsigned(v >> 16) & 0xffff);
+}
+
+[[nodiscard]] static std::vector<uint8_t> startMessage(char type, size_t payloadSize)
+{
+	std::vector<uint8_t> result;
+	result.reserve(5 + payloadSize);
+	result.push_back(uint8_t(type));
+	append32(result, payloadSize);
+	return result;
+}
+
+void FrameStreamEncoder::startFrame(unsigned height)
+{
+	if (prevLines.size() != height) {
+		// all lines are sent, so the client can (re)size its frame
+		prevLines.assign(height, {});
+	}
+	lineInfo.clear();
+	pixels.clear();
+	numChanged = 0;
+	currentLine = 0;
+}
+
+void FrameStreamEncoder::addLine(span<const uint8_t> rgb)
+{
+	assert(currentLine < prevLines.size());
+	assert((rgb.size() % 3) == 0);
+	auto& prev = prevLines[currentLine];
+	// an empty 'prev' means: not yet sent (width is at least 1)
+	if (prev.empty() || (prev.size() != rgb.size()) ||
+	    !std::equal(rgb.begin(), rgb.end(), prev.begin())) {
+		prev.assign(rgb.begin(), rgb.end());
+		append16(lineInfo, currentLine);
+		append16(lineInfo, unsigned(rgb.size() / 3));
+		pixels.insert(pixels.end(), rgb.begin(), rgb.end());
+		++numChanged;
+	}
+	++currentLine;
+}
+
+std::vector<uint8_t> FrameStreamEncoder::finishFrame()
+{
+	assert(currentLine == prevLines.size());
+	std::vector<uint8_t> lz4(pixels.empty() ? 0 : LZ4::compressBound(int(pixels.size())));
+	auto lz4Size = pixels.empty() ? 0 : LZ4::compress(pixels.data(), lz4.data(), int(pixels.size()));
+
+	auto result = startMessage('V', 4 + lineInfo.size() + 4 + lz4Size);
+	append16(result, unsigned(prevLines.size()));
+	append16(result, numChanged);
+	result.insert(result.end(), lineInfo.begin(), lineInfo.end());
+	append32(result, pixels.size());
+	result.insert(result.end(), lz4.begin(), lz4.begin() + lz4Size);
+	return result;
+}
+
+std::vector<uint8_t> FrameStreamEncoder::encodeAudio(
+	span<const int16_t> samples, unsigned channels, unsigned sampleRate)
+{
+	auto result = startMessage('A', 6 + 2 * samples.size());
+	append32(result, sampleRate);
+	append16(result, channels);
+	for (auto s : samples) append16(result, uint16_t(s));
+	return result;
+}
+
+} // namespace openmsx
@@ -0,0 +1,61 @@
+#ifndef FRAMESTREAMENCODER_HH
+#define FRAMESTREAMENCODER_HH
+
+#include "span.hh"
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+namespace openmsx {
+
+/** Encodes the messages of the 'stream' protocol (see FrameStreamer).
+  *
+  * After connecting, the server sends the line "openMSX-stream 1\n",
+  * followed by messages. Each message starts with a 1 byte type and a
+  * 4 byte (little endian) payload size. All numbers are little endian.
+  *
+  *  'V' video frame:
+  *    u16 height, u16 number of changed lines N,
+  *    N times: u16 line number, u16 line width (in pixels),
+  *    u32 size of the pixel data (uncompressed), followed by the LZ4 block
+  *    (the rest of the payload) that decompresses to the RGB888 pixels of
+  *    the N lines, concatenated.
+  *    Lines that are not included are unchanged since the previous frame.
+  *    The first frame (and a frame after a height change or after frames
+  *    were dropped) contains all lines.
+  *  'A' audio:
+  *    u32 sample rate, u16 number of channels (1 or 2), followed by the
+  *    (interleaved) signed 16 bit samples.
+  *
+  * The frames are sent at the native MSX resolution (before scaling), so
+  * lines can have different widths (e.g. border lines are 1 pixel wide).
+  */
+class FrameStreamEncoder
+{
+public:
+	static constexpr std::string_view HELLO = "openMSX-stream 1\n";
+
+	/** Forget the previous frame, so that the next frame is sent
+	  * completely. */
+	void reset() { prevLines.clear(); }
+
+	/** Encode a frame: call startFrame(), then addLine() for each line
+	  * (in order), then finishFrame() returns the complete message. */
+	void startFrame(unsigned height);
+	void addLine(span<const uint8_t> rgb);
+	[[nodiscard]] std::vector<uint8_t> finishFrame();
+
+	[[nodiscard]] static std::vector<uint8_t> encodeAudio(
+		span<const int16_t> samples, unsigned channels, unsigned sampleRate);
+
+private:
+	std::vector<std::vector<uint8_t>> prevLines;
+	std::vector<uint8_t> lineInfo; // line number and width of changed lines
+	std::vector<uint8_t> pixels;   // RGB of the changed lines
+	unsigned numChanged = 0;
+	unsigned currentLine = 0;
+};
+
+} // namespace openmsx
+
+#endif
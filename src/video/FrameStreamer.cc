@@ -0,0 +1,344 @@
+#include "FrameStreamer.hh"
+#include "FrameSource.hh"
+#include "PixelFormat.hh"
+#include "PixelOperations.hh"
+#include "Reactor.hh"
+#include "CommandException.hh"
+#include "MSXException.hh"
+#include "TclArgParser.hh"
+#include "TclObject.hh"
+#include "Math.hh"
+#include "aligned.hh"
+#include "one_of.hh"
+#include "outer.hh"
+#include "xrange.hh"
+#include "build-info.hh"
+#include <cassert>
+#include <cerrno>
+#include <cstring>
+#ifdef _WIN32
+#include <ws2tcpip.h> // for socklen_t
+#endif
+
+namespace openmsx {
+
+// When more frames are waiting to be sent, the client is too slow (or the
+// network), then new frames are dropped.
+static constexpr unsigned MAX_QUEUED_FRAMES = 4;
+// Same for audio messages (roughly one per frame).
+static constexpr size_t MAX_QUEUED_MESSAGES = 16;
+
+FrameStreamer::FrameStreamer(Reactor& reactor_)
+	: reactor(reactor_)
+	, streamCommand(reactor.getCommandController())
+{
+}
+
+FrameStreamer::~FrameStreamer()
+{
+	stop();
+}
+
+void FrameStreamer::start(unsigned port_, bool audio_)
+{
+	stop();
+	audio = audio_;
+
+	sock_startup();
+	listenSock = socket(AF_INET, SOCK_STREAM, 0);
+	if (listenSock == OPENMSX_INVALID_SOCKET) {
+		auto err = sock_error();
+		sock_cleanup();
+		throw CommandException("Couldn't create socket: ", err);
+	}
+#ifndef _WIN32
+	// Allow to restart the server right after the previous one stopped.
+	int one = 1;
+	setsockopt(listenSock, SOL_SOCKET, SO_REUSEADDR,
+	           reinterpret_cast<const char*>(&one), sizeof(one));
+#endif
+	sockaddr_in addr;
+	memset(&addr, 0, sizeof(addr));
+	addr.sin_family = AF_INET;
+	addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK); // only local clients
+	addr.sin_port = htons(uint16_t(port_));
+	socklen_t addrLen = sizeof(addr);
+	if ((bind(listenSock, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == SOCKET_ERROR) ||
+	    (listen(listenSock, 1) == SOCKET_ERROR) ||
+	    (getsockname(listenSock, reinterpret_cast<sockaddr*>(&addr), &addrLen) == SOCKET_ERROR)) {
+		auto err = sock_error();
+		sock_close(listenSock);
+		listenSock = OPENMSX_INVALID_SOCKET;
+		sock_cleanup();
+		throw CommandException("Couldn't listen on port ", port_, ": ", err);
+	}
+	port = ntohs(addr.sin_port);
+	framesSent = 0;
+	framesDropped = 0;
+	bytesSent = 0;
+	quit = false;
+	poller = std::make_unique<Poller>();
+	thread = std::thread([this]() { mainLoop(); });
+}
+
+void FrameStreamer::stop()
+{
+	if (!isStreaming()) return;
+	// Note: On Windows closing the sockets is what wakes up the helper
+	//       thread, on other platforms it's the Poller.
+	{
+		std::lock_guard lock(mutex);
+		quit = true;
+		if (sock != OPENMSX_INVALID_SOCKET) {
+#ifdef _WIN32
+			shutdown(sock, SD_BOTH);
+#else
+			shutdown(sock, SHUT_RDWR);
+#endif
+		}
+	}
+	cond.notify_all();
+	sock_close(listenSock);
+	listenSock = OPENMSX_INVALID_SOCKET;
+	poller->abort();
+	thread.join();
+	poller.reset();
+	sock_cleanup();
+
+	messages.clear();
+	queuedFrames = 0;
+	audioBuf.clear();
+	encoder.reset();
+}
+
+static int16_t float2int16(float f)
+{
+	return Math::clipIntToShort(lrintf(32768.0f * f));
+}
+
+void FrameStreamer::addWave(unsigned num, const float* data, unsigned sampleRate_)
+{
+	if (!audio) return;
+	if (sampleRate_ != sampleRate) {
+		flushAudio();
+		sampleRate = sampleRate_;
+	}
+	for (auto i : xrange(2 * num)) {
+		audioBuf.push_back(float2int16(data[i]));
+	}
+	// normally sent together with the next frame, but not e.g. when
+	// the renderer doesn't produce frames
+	if (audioBuf.size() > 2 * sampleRate / 10) flushAudio();
+}
+
+void FrameStreamer::flushAudio()
+{
+	if (audioBuf.empty()) return;
+	queue(FrameStreamEncoder::encodeAudio(audioBuf, 2, sampleRate));
+	audioBuf.clear();
+}
+
+template<typename Pixel>
+static void convertLine(const FrameSource& frame, unsigned y, std::vector<uint8_t>& rgb)
+{
+	PixelOperations<Pixel> pixelOps(frame.getPixelFormat());
+	ALIGNAS_SSE Pixel buf[1280]; // large enough for widest line
+	unsigned width = frame.getLineWidth(y);
+	const Pixel* line = frame.getLinePtr(y, width, buf);
+	rgb.resize(3 * width);
+	for (auto x : xrange(width)) {
+		rgb[3 * x + 0] = uint8_t(pixelOps.red256  (line[x]));
+		rgb[3 * x + 1] = uint8_t(pixelOps.green256(line[x]));
+		rgb[3 * x + 2] = uint8_t(pixelOps.blue256 (line[x]));
+	}
+}
+
+void FrameStreamer::addImage(const FrameSource& frame)
+{
+	flushAudio();
+	{
+		std::lock_guard lock(mutex);
+		if (queuedFrames >= MAX_QUEUED_FRAMES) {
+			// The following frames are deltas against this one,
+			// so after dropping it, the next one is sent completely.
+			++framesDropped;
+			encoder.reset();
+			return;
+		}
+	}
+	if (needKeyFrame.exchange(false)) encoder.reset();
+
+	unsigned height = frame.getHeight();
+	unsigned bpp = frame.getPixelFormat().getBpp();
+	encoder.startFrame(height);
+	for (auto y : xrange(height)) {
+#if HAVE_32BPP
+		if (bpp == 32) {
+			convertLine<uint32_t>(frame, y, rgbLine);
+		} else
+#endif
+		{
+#if HAVE_16BPP
+			convertLine<uint16_t>(frame, y, rgbLine);
+#endif
+		}
+		encoder.addLine(rgbLine);
+	}
+	(void)bpp;
+	queue(encoder.finishFrame());
+	++framesSent;
+}
+
+void FrameStreamer::queue(std::vector<uint8_t>&& message)
+{
+	{
+		std::lock_guard lock(mutex);
+		if (message[0] == 'V') {
+			++queuedFrames;
+		} else if (messages.size() >= MAX_QUEUED_MESSAGES) {
+			return; // drop audio
+		}
+		messages.push_back(std::move(message));
+	}
+	cond.notify_one();
+}
+
+void FrameStreamer::status(TclObject& result) const
+{
+	result.addDictKeyValues("streaming", isStreaming(),
+	                        "port", isStreaming() ? int(port) : 0,
+	                        "connected", bool(connected),
+	                        "frames", double(framesSent),
+	                        "dropped_frames", double(framesDropped),
+	                        "bytes", double(bytesSent));
+}
+
+
+// helper thread
+
+void FrameStreamer::mainLoop()
+{
+#ifndef _WIN32
+	// see CliServer::mainLoop()
+	fcntl(listenSock, F_SETFL, O_NONBLOCK);
+#endif
+	while (true) {
+#ifndef _WIN32
+		if (poller->poll(listenSock)) break;
+#endif
+		SOCKET sd = accept(listenSock, nullptr, nullptr);
+		if (poller->aborted()) {
+			if (sd != OPENMSX_INVALID_SOCKET) sock_close(sd);
+			break;
+		}
+		if (sd == OPENMSX_INVALID_SOCKET) {
+			if (errno == one_of(EAGAIN, EWOULDBLOCK)) continue;
+			break;
+		}
+#ifndef _WIN32
+		fcntl(sd, F_SETFL, 0);
+#endif
+		{
+			std::lock_guard lock(mutex);
+			sock = sd;
+			messages.clear();
+			queuedFrames = 0;
+			messages.emplace_back(FrameStreamEncoder::HELLO.begin(),
+			                      FrameStreamEncoder::HELLO.end());
+		}
+		needKeyFrame = true;
+		connected = true;
+		sendLoop(sd);
+		connected = false;
+		{
+			std::lock_guard lock(mutex);
+			sock = OPENMSX_INVALID_SOCKET;
+		}
+		sock_close(sd);
+		if (poller->aborted()) break;
+	}
+}
+
+void FrameStreamer::sendLoop(SOCKET sd)
+{
+	while (true) {
+		std::vector<uint8_t> message;
+		{
+			std::unique_lock lock(mutex);
+			cond.wait(lock, [&] { return quit || !messages.empty(); });
+			if (quit) return;
+			message = std::move(messages.front());
+			messages.pop_front();
+			if (message[0] == 'V') --queuedFrames;
+		}
+		const auto* data = reinterpret_cast<const char*>(message.data());
+		size_t size = message.size();
+		while (size) {
+			int n = sock_send(sd, data, size);
+			if (n <= 0) return; // client disconnected
+			data += n;
+			size -= n;
+		}
+		bytesSent += message.size();
+	}
+}
+
+
+// class Cmd
+
+FrameStreamer::Cmd::Cmd(CommandController& commandController_)
+	: Command(commandController_, "stream")
+{
+}
+
+void FrameStreamer::Cmd::execute(span<const TclObject> tokens, TclObject& result)
+{
+	checkNumArgs(tokens, AtLeast{2}, "subcommand ?arg ...?");
+	auto& streamer = OUTER(FrameStreamer, streamCommand);
+	executeSubCommand(tokens[1].getString(),
+		"start", [&]{
+			int port = 0;
+			bool noAudio = false;
+			ArgsInfo info[] = {
+				valueArg("-port", port),
+				flagArg("-noaudio", noAudio),
+			};
+			auto args = parseTclArgs(getInterpreter(), tokens.subspan(2), info);
+			if (!args.empty()) throw SyntaxError();
+			if ((port < 0) || (port > 65535)) {
+				throw CommandException("Invalid port number: ", port);
+			}
+			streamer.start(port, !noAudio);
+			result = int(streamer.port);
+		},
+		"stop", [&]{
+			checkNumArgs(tokens, 2, "stop");
+			streamer.stop();
+		},
+		"status", [&]{
+			checkNumArgs(tokens, 2, "status");
+			streamer.status(result);
+		});
+}
+
+std::string FrameStreamer::Cmd::help(span<const TclObject> /*tokens*/) const
+{
+	return "Stream the MSX video (unscaled, only changed lines) and audio "
+	       "to a client over TCP (currently only on localhost).\n"
+	       "stream start [-port <port>] [-noaudio]  start listening, returns the port\n"
+	       "stream stop                             stop streaming\n"
+	       "stream status                           show status info\n";
+}
+
+void FrameStreamer::Cmd::tabCompletion(std::vector<std::string>& tokens) const
+{
+	if (tokens.size() == 2) {
+		static constexpr const char* const cmds[] = {"start", "stop", "status"};
+		completeString(tokens, cmds);
+	} else if ((tokens.size() >= 3) && (tokens[1] == "start")) {
+		static constexpr const char* const options[] = {"-port", "-noaudio"};
+		completeString(tokens, options);
+	}
+}
+
+} // namespace openmsx
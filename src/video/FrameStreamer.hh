@@ -0,0 +1,102 @@
+#ifndef FRAMESTREAMER_HH
+#define FRAMESTREAMER_HH
+
+#include "Command.hh"
+#include "EmuTime.hh"
+#include "FrameStreamEncoder.hh"
+#include "Poller.hh"
+#include "Socket.hh"
+#include "span.hh"
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace openmsx {
+
+class FrameSource;
+class Reactor;
+class TclObject;
+
+/** The 'stream' command: send the (unscaled) MSX frames and the sound over
+  * a TCP socket, for viewing openMSX from a thin client. See
+  * FrameStreamEncoder for the protocol.
+  *
+  * The PostProcessor (frames) and the MSXMixer of the active machine
+  * (sound) pass their output, similar to what they do for the AviRecorder,
+  * but only while a client is connected. So streaming continues when the
+  * machine or the renderer is switched. Encoding happens in the main
+  * thread, a helper thread accepts the connection and sends the messages.
+  * When the client can't keep up, frames are dropped (and the next one is
+  * sent completely).
+  */
+class FrameStreamer
+{
+public:
+	explicit FrameStreamer(Reactor& reactor);
+	~FrameStreamer();
+
+	/** Is a client connected, IOW should addImage() and addWave() be
+	  * called. */
+	[[nodiscard]] bool isConnected() const { return connected; }
+
+	/** 'data' contains 'num' stereo samples. */
+	void addWave(unsigned num, const float* data, unsigned sampleRate);
+	void addImage(const FrameSource& frame);
+
+private:
+	void start(unsigned port, bool audio);
+	void stop();
+	[[nodiscard]] bool isStreaming() const { return listenSock != OPENMSX_INVALID_SOCKET; }
+	void status(TclObject& result) const;
+	void flushAudio();
+	void queue(std::vector<uint8_t>&& message);
+
+	// helper thread
+	void mainLoop();
+	void sendLoop(SOCKET sd);
+
+private:
+	Reactor& reactor;
+
+	struct Cmd final : Command {
+		explicit Cmd(CommandController& commandController);
+		void execute(span<const TclObject> tokens, TclObject& result) override;
+		[[nodiscard]] std::string help(span<const TclObject> tokens) const override;
+		void tabCompletion(std::vector<std::string>& tokens) const override;
+	} streamCommand;
+
+	// Only used from the main thread.
+	FrameStreamEncoder encoder;
+	std::vector<uint8_t> rgbLine;
+	std::vector<int16_t> audioBuf;
+	unsigned sampleRate = 0;
+	unsigned port = 0;
+	bool audio = true;
+	uint64_t framesSent = 0;
+	uint64_t framesDropped = 0;
+
+	std::thread thread;
+	std::unique_ptr<Poller> poller; // a new one per start()
+	SOCKET listenSock = OPENMSX_INVALID_SOCKET;
+
+	// protects 'sock', 'messages', 'queuedFrames' and 'quit'
+	mutable std::mutex mutex;
+	std::condition_variable cond;
+	SOCKET sock = OPENMSX_INVALID_SOCKET;
+	std::deque<std::vector<uint8_t>> messages;
+	unsigned queuedFrames = 0; // number of 'V' messages in 'messages'
+	bool quit = false;
+	std::atomic<bool> connected = false;
+	std::atomic<bool> needKeyFrame = false;
+	std::atomic<uint64_t> bytesSent = 0;
+};
+
+} // namespace openmsx
+
+#endif
@@ -5,13 +5,16 @@
 #include "FloatSetting.hh"
 #include "OutputSurface.hh"
 #include "RawFrame.hh"
+#include "SuperImposedFrame.hh"
 #include "gl_transform.hh"
 #include "random.hh"
 #include "ranges.hh"
 #include "stl.hh"
+#include "vla.hh"
 #include "xrange.hh"
 #include <cassert>
 #include <cstdint>
+#include <cstring>
 #include <numeric>
 
 using namespace gl;
@@ -34,6 +37,9 @@ GLPostProcessor::GLPostProcessor(
 	noiseX = noiseY = 0.0f;
 	preCalcNoise(renderSettings.getNoise());
 	initBuffers();
+	// enough for one full frame (+ some margin for the lines around
+	// each region), larger uploads fall back to a synchronous transfer
+	uploadBuffer.allocate(size_t(maxWidth_) * (height * 2 + 16) * sizeof(uint32_t));
 
 	storedFrame = false;
 	for (auto i : xrange(2)) {
@@ -88,7 +94,7 @@ void GLPostProcessor::createRegions()
 {
 	regions.clear();
 
-	const unsigned srcHeight = paintFrame->getHeight();
+	const unsigned srcHeight = scaleFrame->getHeight();
 	const unsigned dstHeight = screen.getLogicalHeight();
 
 	unsigned g = std::gcd(srcHeight, dstHeight);
@@ -105,11 +111,11 @@ void GLPostProcessor::createRegions()
 		assert(srcStartY < srcHeight);
 
 		// get region with equal lineWidth
-		unsigned lineWidth = getLineWidth(paintFrame, srcStartY, srcStep);
+		unsigned lineWidth = getLineWidth(scaleFrame, srcStartY, srcStep);
 		unsigned srcEndY = srcStartY + srcStep;
 		unsigned dstEndY = dstStartY + dstStep;
 		while ((srcEndY < srcHeight) && (dstEndY < dstHeight) &&
-		       (getLineWidth(paintFrame, srcEndY, srcStep) == lineWidth)) {
+		       (getLineWidth(scaleFrame, srcEndY, srcStep) == lineWidth)) {
 			srcEndY += srcStep;
 			dstEndY += dstStep;
 		}
@@ -126,6 +132,11 @@ void GLPostProcessor::createRegions()
 
 void GLPostProcessor::paint(OutputSurface& /*output*/)
 {
+	if (noiseDirty) {
+		noiseDirty = false;
+		preCalcNoise(renderSettings.getNoiseSetting().getDouble());
+	}
+
 	if (renderSettings.getInterleaveBlackFrame()) {
 		interleaveCount ^= 1;
 		if (interleaveCount) {
@@ -181,13 +192,13 @@ void GLPostProcessor::paint(OutputSurface& /*output*/)
 		//fprintf(stderr, "post processing lines %d-%d: %d\n",
 		//	r.srcStartY, r.srcEndY, r.lineWidth);
 		auto it = find_unguarded(textures, r.lineWidth, &TextureData::width);
-		auto* superImpose = superImposeVideoFrame
+		auto* superImpose = (superImposeVideoFrame || (scaleFrame != paintFrame))
 		                  ? &superImposeTex : nullptr;
 		currScaler->scaleImage(
 			it->tex, superImpose,
 			r.srcStartY, r.srcEndY, r.lineWidth, // src
 			r.dstStartY, r.dstEndY, scrnWidth,   // dst
-			paintFrame->getHeight()); // dst
+			scaleFrame->getHeight()); // dst
 	}
 
 	drawNoise();
@@ -238,10 +249,10 @@ void GLPostProcessor::paint(OutputSurface& /*output*/)
 	//gl::checkGLError("GLPostProcessor::paint");
 }
 
-std::unique_ptr<RawFrame> GLPostProcessor::rotateFrames(
-	std::unique_ptr<RawFrame> finishedFrame, EmuTime::param time)
+std::shared_ptr<RawFrame> GLPostProcessor::rotateFrames(
+	std::shared_ptr<RawFrame> finishedFrame, EmuTime::param time)
 {
-	std::unique_ptr<RawFrame> reuseFrame =
+	std::shared_ptr<RawFrame> reuseFrame =
 		PostProcessor::rotateFrames(std::move(finishedFrame), time);
 	uploadFrame();
 	++frameCounter;
@@ -256,7 +267,7 @@ void GLPostProcessor::update(const Setting& setting) noexcept
 	auto& noiseSetting = renderSettings.getNoiseSetting();
 	auto& horizontalStretch = renderSettings.getHorizontalStretchSetting();
 	if (&setting == &noiseSetting) {
-		preCalcNoise(noiseSetting.getDouble());
+		noiseDirty = true; // regenerate (only once) in the next paint()
 	} else if (&setting == &horizontalStretch) {
 		preCalcMonitor3D(horizontalStretch.getDouble());
 	}
@@ -264,9 +275,18 @@ void GLPostProcessor::update(const Setting& setting) noexcept
 
 void GLPostProcessor::uploadFrame()
 {
+	scaleFrame = paintFrame;
+	if (superImposeVdpFrame && (paintFrame == superImposedFrame.get())) {
+		// Blend on the GPU instead of via SuperImposedFrame::getLineInfo().
+		// That also avoids scaling the lower resolution frame (in
+		// software) to the resolution of the other frame.
+		scaleFrame = superImposedFrame->getTop();
+		uploadSuperImposeVdpFrame();
+	}
 	createRegions();
 
-	const unsigned srcHeight = paintFrame->getHeight();
+	uploadBuffer.beginFrame();
+	const unsigned srcHeight = scaleFrame->getHeight();
 	for (auto& r : regions) {
 		// upload data
 		// TODO get before/after data from scaler
@@ -276,6 +296,7 @@ void GLPostProcessor::uploadFrame()
 		            std::min<int>(srcHeight, r.srcEndY   + after),
 		            r.lineWidth);
 	}
+	uploadBuffer.endFrame();
 
 	if (superImposeVideoFrame) {
 		int w = superImposeVideoFrame->getWidth();
@@ -283,8 +304,8 @@ void GLPostProcessor::uploadFrame()
 		if (superImposeTex.getWidth()  != w ||
 		    superImposeTex.getHeight() != h) {
 			superImposeTex.resize(w, h);
-			superImposeTex.setInterpolation(true);
 		}
+		superImposeTex.setInterpolation(true);
 		superImposeTex.bind();
 		glTexSubImage2D(
 			GL_TEXTURE_2D,     // target
@@ -299,6 +320,40 @@ void GLPostProcessor::uploadFrame()
 	}
 }
 
+void GLPostProcessor::uploadSuperImposeVdpFrame()
+{
+	// Upload all lines at the maximal width, so that a single texture can
+	// be sampled at the (normalized) video coordinates by the shader.
+	// Like in SuperImposedFrame, the V99x8 frame is shown at the
+	// resolution of the V9990 frame, so take the nearest pixel instead of
+	// interpolating.
+	static constexpr unsigned WIDTH = 640;
+	const auto* bottom = superImposedFrame->getBottom();
+	unsigned h = bottom->getHeight();
+	if (superImposeTex.getWidth()  != int(WIDTH) ||
+	    superImposeTex.getHeight() != int(h)) {
+		superImposeTex.resize(WIDTH, h);
+	}
+	superImposeTex.setInterpolation(false);
+	superImposeBuf.resize(WIDTH * h);
+	for (auto y : xrange(h)) {
+		auto* dest = &superImposeBuf[y * WIDTH];
+		const auto* data = bottom->getLinePtr(y, WIDTH, dest);
+		if (data != dest) memcpy(dest, data, WIDTH * sizeof(uint32_t));
+	}
+	superImposeTex.bind();
+	glTexSubImage2D(
+		GL_TEXTURE_2D,     // target
+		0,                 // level
+		0,                 // offset x
+		0,                 // offset y
+		WIDTH,             // width
+		h,                 // height
+		GL_RGBA,           // format
+		GL_UNSIGNED_BYTE,  // type
+		superImposeBuf.data()); // data
+}
+
 void GLPostProcessor::uploadBlock(
 	unsigned srcStartY, unsigned srcEndY, unsigned lineWidth)
 {
@@ -309,6 +364,7 @@ void GLPostProcessor::uploadBlock(
 
 		textureData.tex.resize(lineWidth, height * 2); // *2 for interlace
 		textureData.pbo.setImage(lineWidth, height * 2);
+		textureData.lineValid.assign(height * 2, false);
 		textures.push_back(std::move(textureData));
 		it = end(textures) - 1;
 	}
@@ -318,40 +374,50 @@ void GLPostProcessor::uploadBlock(
 	// bind texture
 	tex.bind();
 
-	// upload data
+	// Copy data. Often most lines are the same as the last time they were
+	// uploaded to this texture (e.g. a static screen), those don't have to
+	// be uploaded again. Runs of changed lines separated by only a few
+	// unchanged lines are combined, that gives fewer (but slightly larger)
+	// uploads.
+	static constexpr unsigned MAX_GAP = 4;
+	uploadRuns.clear();
+	VLA_SSE_ALIGNED(uint32_t, buf, lineWidth);
 	pbo.bind();
 	uint32_t* mapped = pbo.mapWrite();
 	for (auto y : xrange(srcStartY, srcEndY)) {
 		auto* dest = mapped + y * lineWidth;
-		const auto* data = paintFrame->getLinePtr(y, lineWidth, dest);
-		if (data != dest) {
-			memcpy(dest, data, lineWidth * sizeof(uint32_t));
+		const auto* data = scaleFrame->getLinePtr(y, lineWidth, buf);
+		if (it->lineValid[y] &&
+		    (memcmp(dest, data, lineWidth * sizeof(uint32_t)) == 0)) {
+			continue;
+		}
+		memcpy(dest, data, lineWidth * sizeof(uint32_t));
+		it->lineValid[y] = true;
+		if (!uploadRuns.empty() && ((y - uploadRuns.back().second) <= MAX_GAP)) {
+			uploadRuns.back().second = y + 1;
+		} else {
+			uploadRuns.emplace_back(y, y + 1);
 		}
 	}
 	pbo.unmap();
+
+	for (auto [startY, endY] : uploadRuns) {
 #if defined(__APPLE__)
-	// The nVidia GL driver for the GeForce 8000/9000 series seems to hang
-	// on texture data replacements that are 1 pixel wide and start on a
-	// line number that is a non-zero multiple of 16.
-	if (lineWidth == 1 && srcStartY != 0 && srcStartY % 16 == 0) {
-		srcStartY--;
-	}
+		// The nVidia GL driver for the GeForce 8000/9000 series seems to hang
+		// on texture data replacements that are 1 pixel wide and start on a
+		// line number that is a non-zero multiple of 16.
+		if (lineWidth == 1 && startY != 0 && startY % 16 == 0) {
+			startY--;
+		}
 #endif
-	glTexSubImage2D(
-		GL_TEXTURE_2D,       // target
-		0,                   // level
-		0,                   // offset x
-		srcStartY,           // offset y
-		lineWidth,           // width
-		srcEndY - srcStartY, // height
-		GL_RGBA,             // format
-		GL_UNSIGNED_BYTE,    // type
-		pbo.getOffset(0, srcStartY)); // data
+		uploadBuffer.upload(pbo.getOffset(0, startY), lineWidth,
+		                    startY, endY - startY);
+	}
 	pbo.unbind();
 
 	// possibly upload scaler specific data
 	if (currScaler) {
-		currScaler->uploadBlock(srcStartY, srcEndY, lineWidth, *paintFrame);
+		currScaler->uploadBlock(srcStartY, srcEndY, lineWidth, *scaleFrame);
 	}
 }
 
@@ -4,8 +4,10 @@
 #include "PostProcessor.hh"
 #include "RenderSettings.hh"
 #include "GLUtil.hh"
-#include <vector>
+#include <cstdint>
 #include <memory>
+#include <utility>
+#include <vector>
 
 namespace openmsx {
 
@@ -27,8 +29,8 @@ public:
 	// Layer interface:
 	void paint(OutputSurface& output) override;
 
-	[[nodiscard]] std::unique_ptr<RawFrame> rotateFrames(
-		std::unique_ptr<RawFrame> finishedFrame, EmuTime::param time) override;
+	[[nodiscard]] std::shared_ptr<RawFrame> rotateFrames(
+		std::shared_ptr<RawFrame> finishedFrame, EmuTime::param time) override;
 
 protected:
 	// Observer<Setting> interface:
@@ -38,6 +40,7 @@ private:
 	void initBuffers();
 	void createRegions();
 	void uploadFrame();
+	void uploadSuperImposeVdpFrame();
 	void uploadBlock(unsigned srcStartY, unsigned srcEndY,
 	                 unsigned lineWidth);
 
@@ -60,16 +63,32 @@ private:
 	gl::Texture noiseTextureA;
 	gl::Texture noiseTextureB;
 	float noiseX, noiseY;
+	bool noiseDirty = false;
 
+	// One texture per line width that occurs in the frame (e.g. 1 for
+	// blank border lines, 256 or 512 for the active display). Lines are
+	// uploaded at their native width, the scaler shaders do the horizontal
+	// scaling. Only the few lines around each region (needed as context by
+	// the scalers) get converted to that region's width.
 	struct TextureData {
 		gl::ColorTexture tex;
-		gl::PixelBuffer<unsigned> pbo;
+		gl::PixelBuffer<unsigned> pbo; // copy of the texture content
+		std::vector<bool> lineValid; // is this line in 'pbo' and 'tex'
 		[[nodiscard]] unsigned width() const { return tex.getWidth(); }
 	};
 	std::vector<TextureData> textures;
+	std::vector<std::pair<unsigned, unsigned>> uploadRuns; // [start, end)
+	gl::StreamingPixelBuffer uploadBuffer;
 
 	gl::ColorTexture superImposeTex;
 
+	/** The frame that gets uploaded and scaled. Normally this is
+	  * 'paintFrame'. But when superimposing a VDP frame (Video9000) it's
+	  * the top frame of the SuperImposedFrame, the bottom frame is then
+	  * uploaded in 'superImposeTex' and blended by the scaler shader. */
+	const FrameSource* scaleFrame = nullptr;
+	std::vector<uint32_t> superImposeBuf;
+
 	struct Region {
 		Region(unsigned srcStartY_, unsigned srcEndY_,
 		       unsigned dstStartY_, unsigned dstEndY_,
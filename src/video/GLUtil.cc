@@ -2,11 +2,16 @@
 #include "File.hh"
 #include "FileContext.hh"
 #include "FileException.hh"
+#include "FileOperations.hh"
 #include "InitException.hh"
+#include "ranges.hh"
+#include "sha1.hh"
+#include "strCat.hh"
 #include "vla.hh"
 #include "Version.hh"
 #include <iostream>
 #include <cstdio>
+#include <cstring>
 
 using namespace openmsx;
 
@@ -123,12 +128,124 @@ void FrameBufferObject::pop()
 }
 
 
+// class StreamingPixelBuffer
+
+StreamingPixelBuffer::~StreamingPixelBuffer()
+{
+	reset();
+}
+
+void StreamingPixelBuffer::reset()
+{
+	for (auto& fence : fences) {
+		if (fence) glDeleteSync(fence);
+		fence = nullptr;
+	}
+	if (mapped) {
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, bufferId);
+		glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+		mapped = nullptr;
+	}
+	glDeleteBuffers(1, &bufferId); // ok to delete 0-buffer
+	bufferId = 0;
+}
+
+void StreamingPixelBuffer::allocate(size_t frameSize)
+{
+	reset();
+	segmentSize = frameSize;
+	used = 0;
+	segment = 0;
+
+	glGenBuffers(1, &bufferId);
+	if (GLEW_ARB_buffer_storage && GLEW_ARB_sync) {
+		const GLbitfield flags =
+			GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, bufferId);
+		glBufferStorage(GL_PIXEL_UNPACK_BUFFER, NUM_SEGMENTS * segmentSize,
+		                nullptr, flags);
+		mapped = static_cast<uint8_t*>(glMapBufferRange(
+			GL_PIXEL_UNPACK_BUFFER, 0, NUM_SEGMENTS * segmentSize, flags));
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+		if (!mapped) {
+			// The storage of this buffer is immutable, start over
+			// with a new buffer for the non-persistent method.
+			glDeleteBuffers(1, &bufferId);
+			glGenBuffers(1, &bufferId);
+		}
+	}
+}
+
+void StreamingPixelBuffer::beginFrame()
+{
+	if (!mapped) return;
+	segment = (segment + 1) % NUM_SEGMENTS;
+	used = 0;
+	if (auto& fence = fences[segment]) {
+		// Normally the GPU is long done with this segment (it was used
+		// NUM_SEGMENTS frames ago), so this doesn't wait. The timeout
+		// is only a safety net against a hanging driver.
+		glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1'000'000'000); // 1s
+		glDeleteSync(fence);
+		fence = nullptr;
+	}
+}
+
+void StreamingPixelBuffer::endFrame()
+{
+	if (!mapped || (used == 0)) return;
+	fences[segment] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+void StreamingPixelBuffer::upload(
+	const uint32_t* data, GLsizei width, GLint y, GLsizei numLines)
+{
+	size_t size = size_t(width) * numLines * sizeof(uint32_t);
+	const void* pixels = data; // from client memory
+	bool bound = false;
+	if (mapped) {
+		if ((used + size) <= segmentSize) {
+			size_t offset = segment * segmentSize + used;
+			memcpy(mapped + offset, data, size);
+			used += size;
+			glBindBuffer(GL_PIXEL_UNPACK_BUFFER, bufferId);
+			pixels = reinterpret_cast<const void*>(offset);
+			bound = true;
+		}
+	} else if (bufferId != 0) {
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, bufferId);
+		// orphan the old storage, the driver can keep using it for a
+		// previous upload that's still in progress
+		glBufferData(GL_PIXEL_UNPACK_BUFFER, size, nullptr, GL_STREAM_DRAW);
+		if (auto* dest = glMapBuffer(GL_PIXEL_UNPACK_BUFFER, GL_WRITE_ONLY)) {
+			memcpy(dest, data, size);
+			glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+			pixels = nullptr; // offset 0 in the buffer
+			bound = true;
+		} else {
+			glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+		}
+	}
+	glTexSubImage2D(
+		GL_TEXTURE_2D,    // target
+		0,                // level
+		0,                // offset x
+		y,                // offset y
+		width,            // width
+		numLines,         // height
+		GL_RGBA,          // format
+		GL_UNSIGNED_BYTE, // type
+		pixels);          // data
+	if (bound) glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+}
+
+
 // class Shader
 
 void Shader::init(GLenum type, std::string_view header, std::string_view filename)
 {
 	// Load shader source.
-	std::string source;
 	if constexpr (OPENGL_VERSION == OPENGL_ES_2_0) {
 		source += "#version 100\n";
 		if (type == GL_FRAGMENT_SHADER) {
@@ -149,12 +266,20 @@ void Shader::init(GLenum type, std::string_view header, std::string_view filenam
 		              mmap.size());
 	} catch (FileException& e) {
 		std::cerr << "Cannot find shader: " << e.getMessage() << '\n';
-		handle = 0;
-		return;
+		source.clear();
 	}
 
+	shaderFile = filename;
+	shaderType = type;
+}
+
+void Shader::compile() const
+{
+	compiled = true;
+	if (source.empty()) return; // loading failed
+
 	// Allocate shader handle.
-	handle = glCreateShader(type);
+	handle = glCreateShader(shaderType);
 	if (handle == 0) {
 		std::cerr << "Failed to allocate shader\n";
 		return;
@@ -166,7 +291,9 @@ void Shader::init(GLenum type, std::string_view header, std::string_view filenam
 
 	// Compile shader and print any errors and warnings.
 	glCompileShader(handle);
-	const bool ok = isOK();
+	GLint compileStatus = GL_FALSE;
+	glGetShaderiv(handle, GL_COMPILE_STATUS, &compileStatus);
+	const bool ok = compileStatus == GL_TRUE;
 	GLint infoLogLength = 0;
 	glGetShaderiv(handle, GL_INFO_LOG_LENGTH, &infoLogLength);
 	// note: the null terminator is included, so empty string has length 1
@@ -174,7 +301,7 @@ void Shader::init(GLenum type, std::string_view header, std::string_view filenam
 		VLA(GLchar, infoLog, infoLogLength);
 		glGetShaderInfoLog(handle, infoLogLength, nullptr, infoLog);
 		std::cerr << (ok ? "Warning" : "Error") << "(s) compiling shader \""
-		          << filename << "\":\n"
+		          << shaderFile << "\":\n"
 			  << (infoLogLength > 1 ? infoLog : "(no details available)\n");
 	}
 }
@@ -186,6 +313,7 @@ Shader::~Shader()
 
 bool Shader::isOK() const
 {
+	if (!compiled) compile();
 	if (handle == 0) return false;
 	GLint compileStatus = GL_FALSE;
 	glGetShaderiv(handle, GL_COMPILE_STATUS, &compileStatus);
@@ -222,11 +350,34 @@ void ShaderProgram::attach(const Shader& shader)
 	// Sanity check on this program.
 	if (handle == 0) return;
 
-	// Sanity check on the shader.
-	if (!shader.isOK()) return;
+	// Only compiled (and attached) when needed, see link().
+	shaders.push_back(&shader);
+	strAppend(cacheKey, shader.shaderType, ':', shader.source.size(), ':', shader.source);
+}
+
+// The program binaries are specific for the driver (version), so include
+// that in the key.
+[[nodiscard]] static const std::string& getDriverId()
+{
+	static const std::string result = [] {
+		auto get = [](GLenum name) {
+			const auto* s = reinterpret_cast<const char*>(glGetString(name));
+			return std::string_view(s ? s : "");
+		};
+		return strCat(get(GL_VENDOR), '\n', get(GL_RENDERER), '\n',
+		              get(GL_VERSION), '\n');
+	}();
+	return result;
+}
+
+[[nodiscard]] static std::string getBinaryCacheDir()
+{
+	return FileOperations::getUserDataDir() + "/.shadercache";
+}
 
-	// Attach it.
-	glAttachShader(handle, shader.handle);
+[[nodiscard]] static std::string getBinaryCacheFile(const Sha1Sum& key)
+{
+	return strCat(getBinaryCacheDir(), '/', key.toString(), ".bin");
 }
 
 void ShaderProgram::link()
@@ -234,6 +385,32 @@ void ShaderProgram::link()
 	// Sanity check on this program.
 	if (handle == 0) return;
 
+	// Only use the cache when all sources could be loaded, otherwise the
+	// cache-key would be (nearly) empty.
+	bool useCache = GLEW_ARB_get_program_binary &&
+	                !shaders.empty() &&
+	                ranges::none_of(shaders, [](auto* s) { return s->source.empty(); });
+	Sha1Sum key;
+	if (useCache) {
+		SHA1 sha1;
+		const auto& driverId = getDriverId();
+		sha1.update({reinterpret_cast<const uint8_t*>(driverId.data()), driverId.size()});
+		sha1.update({reinterpret_cast<const uint8_t*>(cacheKey.data()), cacheKey.size()});
+		key = sha1.digest();
+		if (loadBinary(key)) {
+			shaders.clear();
+			cacheKey.clear();
+			return;
+		}
+		glProgramParameteri(handle, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+	}
+
+	for (const auto* shader : shaders) {
+		if (shader->isOK()) glAttachShader(handle, shader->handle);
+	}
+	shaders.clear();
+	cacheKey.clear();
+
 	// Link the program and print any errors and warnings.
 	glLinkProgram(handle);
 	const bool ok = isOK();
@@ -247,11 +424,52 @@ void ShaderProgram::link()
 			ok ? "Warning" : "Error",
 			infoLogLength > 1 ? infoLog : "(no details available)\n");
 	}
+	if (ok && useCache) storeBinary(key);
+}
+
+// Cache file format: the binary format (native endian uint32_t), followed by
+// the binary itself.
+bool ShaderProgram::loadBinary(const Sha1Sum& key)
+{
+	try {
+		File file(getBinaryCacheFile(key));
+		auto mmap = file.mmap();
+		if (mmap.size() <= sizeof(uint32_t)) return false;
+		uint32_t format;
+		memcpy(&format, mmap.data(), sizeof(format));
+		glProgramBinary(handle, format, mmap.data() + sizeof(format),
+		                GLsizei(mmap.size() - sizeof(format)));
+	} catch (FileException&) {
+		return false; // not (yet) in the cache
+	}
+	// Fails e.g. after a driver update, then we just compile again (and
+	// overwrite the cached binary).
+	return isOK();
+}
+
+void ShaderProgram::storeBinary(const Sha1Sum& key) const
+{
+	GLint length = 0;
+	glGetProgramiv(handle, GL_PROGRAM_BINARY_LENGTH, &length);
+	if (length <= 0) return;
+	MemBuffer<uint8_t> buf(sizeof(uint32_t) + length);
+	GLenum format = 0;
+	glGetProgramBinary(handle, length, &length, &format, buf.data() + sizeof(uint32_t));
+	auto format32 = uint32_t(format);
+	memcpy(buf.data(), &format32, sizeof(format32));
+	try {
+		FileOperations::mkdirp(getBinaryCacheDir());
+		File file(getBinaryCacheFile(key), File::TRUNCATE);
+		file.write(buf.data(), sizeof(uint32_t) + length);
+	} catch (FileException&) {
+		// ignore, the cache is only an optimization
+	}
 }
 
 void ShaderProgram::bindAttribLocation(unsigned index, const char* name)
 {
 	glBindAttribLocation(handle, index, name);
+	strAppend(cacheKey, "attrib:", index, ':', name, '\n');
 }
 
 GLint ShaderProgram::getUniformLocation(const char* name) const
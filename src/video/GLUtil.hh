@@ -16,8 +16,11 @@
 
 #include "MemBuffer.hh"
 #include "build-info.hh"
+#include <string>
 #include <string_view>
+#include <vector>
 #include <cassert>
+#include <cstdint>
 
 // arbitrary but distinct values, (roughly) ordered according to version number
 #define OPENGL_ES_2_0 1
@@ -25,6 +28,8 @@
 #define OPENGL_3_3    3
 #define OPENGL_VERSION OPENGL_2_1
 
+namespace openmsx { class Sha1Sum; }
+
 namespace gl {
 
 void checkGLError(std::string_view prefix);
@@ -316,14 +321,66 @@ void PixelBuffer<T>::unmap() const
 }
 
 
+/** Uploads pixel data to the currently bound texture via a pixel unpack
+  * buffer object, so that the transfer itself can happen asynchronously.
+  *
+  * When GL_ARB_buffer_storage is available, the buffer is mapped once
+  * (persistently) and split into NUM_SEGMENTS segments that are used in
+  * turn, one per frame. The data is then written directly in GPU visible
+  * memory, a fence per segment makes sure a segment is no longer in use
+  * before it's overwritten. Otherwise the buffer is orphaned and mapped for
+  * each upload. Data that doesn't fit in the current segment is uploaded
+  * directly from client memory.
+  */
+class StreamingPixelBuffer
+{
+public:
+	StreamingPixelBuffer() = default;
+	StreamingPixelBuffer(const StreamingPixelBuffer&) = delete;
+	StreamingPixelBuffer& operator=(const StreamingPixelBuffer&) = delete;
+	~StreamingPixelBuffer();
+
+	/** (Re)allocate the buffer.
+	  * @param frameSize The (typical maximum) number of bytes uploaded
+	  *                  between beginFrame() and endFrame().
+	  */
+	void allocate(size_t frameSize);
+
+	/** Must be called before and after all uploads of one frame.
+	  */
+	void beginFrame();
+	void endFrame();
+
+	/** Upload 'numLines' lines of 'width' pixels, starting at line 'y' of
+	  * the currently bound texture. The lines must be consecutive in memory
+	  * starting at 'data'.
+	  */
+	void upload(const uint32_t* data, GLsizei width, GLint y, GLsizei numLines);
+
+private:
+	void reset();
+
+private:
+	static constexpr unsigned NUM_SEGMENTS = 3;
+	GLsync fences[NUM_SEGMENTS] = {};
+	uint8_t* mapped = nullptr; // non-null iff persistently mapped
+	size_t segmentSize = 0;
+	size_t used = 0; // number of bytes in the current segment
+	unsigned segment = 0;
+	GLuint bufferId = 0;
+};
+
 
 /** Wrapper around an OpenGL shader: a program executed on the GPU.
   * This class is a base class for vertex and fragment shaders.
+  * The source is loaded on construction, but it's only compiled when
+  * needed, see ShaderProgram::link().
   */
 class Shader
 {
 public:
 	/** Returns true iff this shader is loaded and compiled without errors.
+	  * Compiles the shader (if not yet done).
 	  */
 	[[nodiscard]] bool isOK() const;
 
@@ -344,11 +401,16 @@ protected:
 private:
 	void init(GLenum type, std::string_view header,
 	                       std::string_view filename);
+	void compile() const;
 
 	friend class ShaderProgram;
 
 private:
-	GLuint handle;
+	std::string source; // empty if it couldn't be loaded
+	std::string shaderFile; // for error messages
+	GLenum shaderType;
+	mutable GLuint handle = 0;
+	mutable bool compiled = false;
 };
 
 /** Wrapper around an OpenGL vertex shader:
@@ -416,11 +478,15 @@ public:
 	[[nodiscard]] bool isOK() const;
 
 	/** Adds a given shader to this program.
+	  * The shader must stay alive until link() is called.
 	  */
 	void attach(const Shader& shader);
 
 	/** Links all attached shaders together into one program.
 	  * This should be done before activating the program.
+	  * When the driver supports it, the linked binary is stored on disk
+	  * and reused the next time the same program is linked (then the
+	  * shaders don't need to be compiled at all).
 	  */
 	void link();
 
@@ -442,8 +508,14 @@ public:
 
 	void validate() const;
 
+private:
+	[[nodiscard]] bool loadBinary(const openmsx::Sha1Sum& key);
+	void storeBinary(const openmsx::Sha1Sum& key) const;
+
 private:
 	GLuint handle;
+	std::vector<const Shader*> shaders; // attached, not yet linked
+	std::string cacheKey; // sources and attribute locations
 };
 
 class BufferObject
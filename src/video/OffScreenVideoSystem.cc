@@ -0,0 +1,148 @@
+#include "OffScreenVideoSystem.hh"
+#include "SDLOffScreenSurface.hh"
+#include "SDLRasterizer.hh"
+#include "V9990SDLRasterizer.hh"
+#include "FBPostProcessor.hh"
+#include "Display.hh"
+#include "RenderSettings.hh"
+#include "IntegerSetting.hh"
+#include "InitException.hh"
+#include "VDP.hh"
+#include "V9990.hh"
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <string_view>
+
+#include "components.hh"
+#if COMPONENT_LASERDISC
+#include "LaserdiscPlayer.hh"
+#include "LDSDLRasterizer.hh"
+#endif
+
+namespace openmsx {
+
+// Same pixel format as SDLVisibleSurface.
+using Pixel = uint32_t;
+
+OffScreenVideoSystem::OffScreenVideoSystem(Display& display_)
+	: display(display_)
+	, renderSettings(display.getRenderSettings())
+{
+	auto [width, height] = getSurfaceSize();
+	SDLSurfacePtr prototype(SDL_CreateRGBSurface(
+		0, width, height, 32,
+		0x00FF0000, 0x0000FF00, 0x000000FF, 0xFF000000));
+	if (!prototype) {
+		std::string_view err = SDL_GetError();
+		throw InitException("Could not create surface: ", err);
+	}
+	screen = std::make_unique<SDLOffScreenSurface>(*prototype);
+}
+
+OffScreenVideoSystem::~OffScreenVideoSystem() = default;
+
+std::unique_ptr<Rasterizer> OffScreenVideoSystem::createRasterizer(VDP& vdp)
+{
+	std::string videoSource = (vdp.getName() == "VDP")
+	                        ? "MSX" // for backwards compatibility
+	                        : vdp.getName();
+	auto& motherBoard = vdp.getMotherBoard();
+	return std::make_unique<SDLRasterizer<Pixel>>(
+		vdp, display, *screen,
+		std::make_unique<FBPostProcessor<Pixel>>(
+			motherBoard, display, *screen,
+			videoSource, 640, 240, true));
+}
+
+std::unique_ptr<V9990Rasterizer> OffScreenVideoSystem::createV9990Rasterizer(
+	V9990& vdp)
+{
+	std::string videoSource = (vdp.getName() == "Sunrise GFX9000")
+	                        ? "GFX9000" // for backwards compatibility
+	                        : vdp.getName();
+	MSXMotherBoard& motherBoard = vdp.getMotherBoard();
+	return std::make_unique<V9990SDLRasterizer<Pixel>>(
+		vdp, display, *screen,
+		std::make_unique<FBPostProcessor<Pixel>>(
+			motherBoard, display, *screen,
+			videoSource, 1280, 240, true));
+}
+
+#if COMPONENT_LASERDISC
+std::unique_ptr<LDRasterizer> OffScreenVideoSystem::createLDRasterizer(
+	LaserdiscPlayer& ld)
+{
+	std::string videoSource = "Laserdisc"; // TODO handle multiple???
+	MSXMotherBoard& motherBoard = ld.getMotherBoard();
+	return std::make_unique<LDSDLRasterizer<Pixel>>(
+		*screen,
+		std::make_unique<FBPostProcessor<Pixel>>(
+			motherBoard, display, *screen,
+			videoSource, 640, 480, false));
+}
+#endif
+
+gl::ivec2 OffScreenVideoSystem::getSurfaceSize() const
+{
+	// Same limit as for the SDL renderer: there are no 4x software
+	// scalers yet.
+	int factor = std::min(renderSettings.getScaleFactor(), 3);
+	return {320 * factor, 240 * factor};
+}
+
+bool OffScreenVideoSystem::checkSettings()
+{
+	// Re-create the surface when the scale factor changed.
+	return getSurfaceSize() == screen->getLogicalSize();
+}
+
+void OffScreenVideoSystem::flush()
+{
+	// nothing to present
+}
+
+void OffScreenVideoSystem::takeScreenShot(
+	const std::string& filename, bool /*withOsd*/,
+	const PNG::SaveOptions& options)
+{
+	// There are no OSD layers, the surface only contains the MSX screen.
+	screen->saveScreenshot(filename, options);
+}
+
+gl::ivec2 OffScreenVideoSystem::getMouseCoord()
+{
+	return gl::ivec2(0, 0);
+}
+
+OutputSurface* OffScreenVideoSystem::getOutputSurface()
+{
+	return screen.get();
+}
+
+void OffScreenVideoSystem::showCursor(bool /*show*/)
+{
+}
+
+bool OffScreenVideoSystem::getCursorEnabled()
+{
+	return false;
+}
+
+std::string OffScreenVideoSystem::getClipboardText()
+{
+	return clipboard;
+}
+
+void OffScreenVideoSystem::setClipboardText(zstring_view text)
+{
+	clipboard = std::string(text);
+}
+
+void OffScreenVideoSystem::repaint()
+{
+	// Render directly into the memory surface.
+	display.repaintImpl();
+}
+
+} // namespace openmsx
@@ -0,0 +1,59 @@
+#ifndef OFFSCREENVIDEOSYSTEM_HH
+#define OFFSCREENVIDEOSYSTEM_HH
+
+#include "VideoSystem.hh"
+#include "components.hh"
+#include <memory>
+#include <string>
+
+namespace openmsx {
+
+class Display;
+class RenderSettings;
+
+/** Renders the MSX screen (with the SDL software rasterizers) to a surface
+  * in memory, no window is created. Meant for e.g. automated tests of the
+  * rendering output (via screenshots or frame hashes) on machines without
+  * a display. The size of the surface follows the scale_factor setting,
+  * so 'set scale_factor 1' gives the native 320x240 output without any
+  * scaler.
+  */
+class OffScreenVideoSystem final : public VideoSystem
+{
+public:
+	explicit OffScreenVideoSystem(Display& display);
+	~OffScreenVideoSystem() override;
+
+	// VideoSystem interface:
+	[[nodiscard]] std::unique_ptr<Rasterizer> createRasterizer(VDP& vdp) override;
+	[[nodiscard]] std::unique_ptr<V9990Rasterizer> createV9990Rasterizer(
+		V9990& vdp) override;
+#if COMPONENT_LASERDISC
+	[[nodiscard]] std::unique_ptr<LDRasterizer> createLDRasterizer(
+		LaserdiscPlayer& ld) override;
+#endif
+	[[nodiscard]] bool checkSettings() override;
+	void flush() override;
+	void takeScreenShot(const std::string& filename, bool withOsd,
+	                    const PNG::SaveOptions& options) override;
+	[[nodiscard]] gl::ivec2 getMouseCoord() override;
+	[[nodiscard]] OutputSurface* getOutputSurface() override;
+	void showCursor(bool show) override;
+	[[nodiscard]] bool getCursorEnabled() override;
+	[[nodiscard]] std::string getClipboardText() override;
+	void setClipboardText(zstring_view text) override;
+	void repaint() override;
+
+private:
+	[[nodiscard]] gl::ivec2 getSurfaceSize() const;
+
+private:
+	Display& display;
+	RenderSettings& renderSettings;
+	std::unique_ptr<OutputSurface> screen;
+	std::string clipboard; // there's no host clipboard to use
+};
+
+} // namespace openmsx
+
+#endif
@@ -7,6 +7,8 @@
 #include <cassert>
 #include <cstdint>
 
+namespace openmsx::PNG { struct SaveOptions; }
+
 namespace openmsx {
 
 /** A frame buffer where pixels can be written to.
@@ -102,7 +104,8 @@ public:
 	/** Save the content of this OutputSurface to a PNG file.
 	  * @throws MSXException If creating the PNG file fails.
 	  */
-	virtual void saveScreenshot(const std::string& filename) = 0;
+	virtual void saveScreenshot(const std::string& filename,
+	                            const PNG::SaveOptions& options) = 0;
 
 protected:
 	OutputSurface() = default;
@@ -1,6 +1,8 @@
 #include "PNG.hh"
 #include "MSXException.hh"
 #include "File.hh"
+#include "MemBuffer.hh"
+#include "WorkerPool.hh"
 #include "build-info.hh"
 #include "Version.hh"
 #include "one_of.hh"
@@ -11,7 +13,10 @@
 #include <cstdlib>
 #include <ctime>
 #include <iostream>
+#include <memory>
+#include <mutex>
 #include <tuple>
+#include <utility>
 #include <png.h>
 #include <SDL.h>
 
@@ -283,8 +288,32 @@ static void flushData(png_structp ctx)
 	file->flush();
 }
 
-static void IMG_SavePNG_RW(int width, int height, const void** row_pointers,
-                           const std::string& filename, bool color)
+// Header info, determined when the screenshot is taken (not when it's
+// written).
+struct PNGInfo {
+	PNGInfo()
+		: version(Version::full())
+	{
+		// A buffer size of 20 characters is large enough till the year
+		// 9999. But the compiler doesn't understand calendars and
+		// warns that the snprintf output could be truncated (e.g.
+		// because the year is -2147483647). To silence this warning
+		// (and also to work around the windows _snprintf stuff) we add
+		// some extra buffer space.
+		time_t now = time(nullptr);
+		struct tm* tm = localtime(&now);
+		snprintf(timeStr, sizeof(timeStr), "%04d-%02d-%02d %02d:%02d:%02d",
+				1900 + tm->tm_year, tm->tm_mon + 1, tm->tm_mday,
+				tm->tm_hour, tm->tm_min, tm->tm_sec);
+	}
+
+	std::string version;
+	char timeStr[(10 + 1 + 8 + 1) + 44];
+};
+
+static void writePNG(int width, int height, const void** row_pointers,
+                     const std::string& filename, bool color,
+                     const PNGInfo& pngInfo, SaveOptions::Compression compression)
 {
 	try {
 		File file(filename, File::TRUNCATE);
@@ -308,28 +337,13 @@ static void IMG_SavePNG_RW(int width, int height, const void** row_pointers,
 		png_set_write_fn(png.ptr, &file, writeData, flushData);
 
 		// Mark this image as being generated by openMSX and add creation time.
-		std::string version = Version::full();
 		png_text text[2];
 		text[0].compression = PNG_TEXT_COMPRESSION_NONE;
 		text[0].key  = const_cast<char*>("Software");
-		text[0].text = const_cast<char*>(version.c_str());
+		text[0].text = const_cast<char*>(pngInfo.version.c_str());
 		text[1].compression = PNG_TEXT_COMPRESSION_NONE;
 		text[1].key  = const_cast<char*>("Creation Time");
-
-		// A buffer size of 20 characters is large enough till the year
-		// 9999. But the compiler doesn't understand calendars and
-		// warns that the snprintf output could be truncated (e.g.
-		// because the year is -2147483647). To silence this warning
-		// (and also to work around the windows _snprintf stuff) we add
-		// some extra buffer space.
-		static constexpr size_t size = (10 + 1 + 8 + 1) + 44;
-		time_t now = time(nullptr);
-		struct tm* tm = localtime(&now);
-		char timeStr[size];
-		snprintf(timeStr, sizeof(timeStr), "%04d-%02d-%02d %02d:%02d:%02d",
-				1900 + tm->tm_year, tm->tm_mon + 1, tm->tm_mday,
-				tm->tm_hour, tm->tm_min, tm->tm_sec);
-		text[1].text = timeStr;
+		text[1].text = const_cast<char*>(pngInfo.timeStr);
 
 		png_set_text(png.ptr, png.info, text, 2);
 
@@ -338,6 +352,20 @@ static void IMG_SavePNG_RW(int width, int height, const void** row_pointers,
 					PNG_INTERLACE_NONE, PNG_COMPRESSION_TYPE_BASE,
 					PNG_FILTER_TYPE_BASE);
 
+		switch (compression) {
+		case SaveOptions::Compression::DEFAULT:
+			break;
+		case SaveOptions::Compression::FAST:
+			// Trying all filters for each row takes most of the time.
+			png_set_filter(png.ptr, PNG_FILTER_TYPE_BASE, PNG_FILTER_SUB);
+			png_set_compression_level(png.ptr, 1);
+			break;
+		case SaveOptions::Compression::NONE:
+			png_set_filter(png.ptr, PNG_FILTER_TYPE_BASE, PNG_FILTER_NONE);
+			png_set_compression_level(png.ptr, 0);
+			break;
+		}
+
 		// Write the file header information.  REQUIRED
 		png_write_info(png.ptr, png.info);
 
@@ -353,7 +381,51 @@ static void IMG_SavePNG_RW(int width, int height, const void** row_pointers,
 	}
 }
 
-static void save(SDL_Surface* image, const std::string& filename)
+// Asynchronous saving: a single thread, so the files are written in order.
+static std::mutex asyncMutex;
+static std::vector<std::string> asyncErrors; // protected by asyncMutex
+
+static WorkerPool& asyncPool()
+{
+	static WorkerPool pool(1);
+	return pool;
+}
+
+static void IMG_SavePNG_RW(int width, int height, const void** row_pointers,
+                           const std::string& filename, bool color,
+                           const SaveOptions& options)
+{
+	PNGInfo pngInfo;
+	if (!options.async) {
+		writePNG(width, height, row_pointers, filename, color,
+		         pngInfo, options.compression);
+		return;
+	}
+
+	// Copy the image now, the rows are only valid during this call. A
+	// shared_ptr because the task must be copyable.
+	size_t rowSize = size_t(width) * (color ? 3 : 1);
+	auto image = std::make_shared<MemBuffer<uint8_t>>(rowSize * height);
+	for (auto y : xrange(height)) {
+		memcpy(&(*image)[rowSize * y], row_pointers[y], rowSize);
+	}
+	asyncPool().post([=, pngInfo = std::move(pngInfo)] {
+		VLA(const void*, rows, height);
+		for (auto y : xrange(height)) {
+			rows[y] = &(*image)[rowSize * y];
+		}
+		try {
+			writePNG(width, height, rows, filename, color,
+			         pngInfo, options.compression);
+		} catch (MSXException& e) {
+			std::lock_guard lock(asyncMutex);
+			asyncErrors.push_back(e.getMessage());
+		}
+	});
+}
+
+static void save(SDL_Surface* image, const std::string& filename,
+                 const SaveOptions& options)
 {
 	SDLAllocFormatPtr frmt24(SDL_AllocFormat(
 		OPENMSX_BIGENDIAN ? SDL_PIXELFORMAT_BGR24 : SDL_PIXELFORMAT_RGB24));
@@ -365,11 +437,12 @@ static void save(SDL_Surface* image, const std::string& filename)
 		row_pointers[i] = surf24.getLinePtr(i);
 	}
 
-	IMG_SavePNG_RW(image->w, image->h, row_pointers, filename, true);
+	IMG_SavePNG_RW(image->w, image->h, row_pointers, filename, true, options);
 }
 
 void save(unsigned width, unsigned height, const void** rowPointers,
-          const PixelFormat& format, const std::string& filename)
+          const PixelFormat& format, const std::string& filename,
+          const SaveOptions& options)
 {
 	// this implementation creates 1 extra copy, can be optimized if required
 	SDLSurfacePtr surface(
@@ -379,19 +452,31 @@ void save(unsigned width, unsigned height, const void** rowPointers,
 		memcpy(surface.getLinePtr(y),
 		       rowPointers[y], width * format.getBytesPerPixel());
 	}
-	save(surface.get(), filename);
+	save(surface.get(), filename, options);
 }
 
-void save(unsigned width, unsigned height,
-          const void** rowPointers, const std::string& filename)
+void save(unsigned width, unsigned height, const void** rowPointers,
+          const std::string& filename, const SaveOptions& options)
 {
-	IMG_SavePNG_RW(width, height, rowPointers, filename, true);
+	IMG_SavePNG_RW(width, height, rowPointers, filename, true, options);
 }
 
 void saveGrayscale(unsigned width, unsigned height,
-                   const void** rowPointers, const std::string& filename)
+                   const void** rowPointers, const std::string& filename,
+                   const SaveOptions& options)
+{
+	IMG_SavePNG_RW(width, height, rowPointers, filename, false, options);
+}
+
+void waitAsync()
+{
+	asyncPool().wait();
+}
+
+std::vector<std::string> takeAsyncErrors()
 {
-	IMG_SavePNG_RW(width, height, rowPointers, filename, false);
+	std::lock_guard lock(asyncMutex);
+	return std::exchange(asyncErrors, {});
 }
 
 } // namespace openmsx::PNG
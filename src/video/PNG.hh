@@ -4,6 +4,7 @@
 #include "PixelFormat.hh"
 #include "SDLSurfacePtr.hh"
 #include <string>
+#include <vector>
 
 /** Utility functions to hide the complexity of saving to a PNG file.
   */
@@ -16,12 +17,36 @@ namespace openmsx::PNG {
 	 */
 	[[nodiscard]] SDLSurfacePtr load(const std::string& filename, bool want32bpp);
 
+	struct SaveOptions {
+		enum class Compression {
+			DEFAULT, // smallest files
+			FAST,    // fast, but still compressed
+			NONE,    // fastest, for e.g. automated tests
+		};
+		Compression compression = Compression::DEFAULT;
+
+		/** Copy the image and encode it on a background thread. The
+		 * file may then not yet exist when save() returns, and errors
+		 * are reported via takeAsyncErrors().
+		 */
+		bool async = false;
+	};
+
 	void save(unsigned width, unsigned height, const void** rowPointers,
-	          const PixelFormat& format, const std::string& filename);
+	          const PixelFormat& format, const std::string& filename,
+	          const SaveOptions& options = {});
 	void save(unsigned width, unsigned height, const void** rowPointers,
-	          const std::string& filename);
+	          const std::string& filename, const SaveOptions& options = {});
 	void saveGrayscale(unsigned width, unsigned height,
-	                   const void** rowPointers, const std::string& filename);
+	                   const void** rowPointers, const std::string& filename,
+	                   const SaveOptions& options = {});
+
+	/** Block till all asynchronous saves are done. */
+	void waitAsync();
+
+	/** The errors of the asynchronous saves that failed since the
+	 * previous call. */
+	[[nodiscard]] std::vector<std::string> takeAsyncErrors();
 
 } // namespace openmsx::PNG
 
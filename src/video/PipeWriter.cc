@@ -0,0 +1,88 @@
+#include "PipeWriter.hh"
+#include "FrameSource.hh"
+#include "MSXException.hh"
+#include "PixelOperations.hh"
+#include "build-info.hh"
+#include "unreachable.hh"
+#include "vla.hh"
+#include "xrange.hh"
+
+#ifdef _WIN32
+#define popen _popen
+#define pclose _pclose
+#else
+#include <csignal>
+#endif
+
+namespace openmsx {
+
+PipeWriter::PipeWriter(const std::string& command, unsigned width_, unsigned height_)
+	: pipe(popen(command.c_str(), "wb"))
+	, frameBuf(width_ * height_)
+	, width(width_)
+	, height(height_)
+{
+	if (!pipe) {
+		throw MSXException("Couldn't start '", command, '\'');
+	}
+#ifndef _WIN32
+	// When the process exits, writing should give an error (this stops
+	// the recording) instead of killing openMSX.
+	signal(SIGPIPE, SIG_IGN);
+#endif
+}
+
+PipeWriter::~PipeWriter()
+{
+	// closing the pipe signals end-of-stream, this waits for the process
+	pclose(pipe);
+}
+
+template<typename Pixel>
+void PipeWriter::convertLine(const FrameSource& frame, unsigned y, Endian::L32* out)
+{
+	VLA_SSE_ALIGNED(Pixel, buf, width);
+	const Pixel* line = [&]() -> const Pixel* {
+		switch (height) {
+		case 240: return frame.getLinePtr320_240(y, buf);
+		case 480: return frame.getLinePtr640_480(y, buf);
+		case 720: return frame.getLinePtr960_720(y, buf);
+		default: UNREACHABLE; return buf;
+		}
+	}();
+	PixelOperations<Pixel> pixelOps(frame.getPixelFormat());
+	for (auto x : xrange(width)) {
+		unsigned r = pixelOps.red256  (line[x]);
+		unsigned g = pixelOps.green256(line[x]);
+		unsigned b = pixelOps.blue256 (line[x]);
+		out[x] = (r << 16) | (g << 8) | b;
+	}
+}
+
+void PipeWriter::addFrame(FrameSource* frame)
+{
+	auto* out = frameBuf.data();
+	for (auto y : xrange(height)) {
+		switch (frame->getPixelFormat().getBytesPerPixel()) {
+#if HAVE_16BPP
+		case 2:
+			convertLine<uint16_t>(*frame, y, out);
+			break;
+#endif
+#if HAVE_32BPP
+		case 4:
+			convertLine<uint32_t>(*frame, y, out);
+			break;
+#endif
+		default:
+			UNREACHABLE;
+		}
+		out += width;
+	}
+	size_t size = size_t(width) * height;
+	if (fwrite(frameBuf.data(), sizeof(Endian::L32), size, pipe) != size) {
+		throw MSXException("Error writing to pipe");
+	}
+}
+
+} // namespace openmsx
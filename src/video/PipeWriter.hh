@@ -0,0 +1,44 @@
+#ifndef PIPEWRITER_HH
+#define PIPEWRITER_HH
+
+#include "MemBuffer.hh"
+#include "endian.hh"
+#include <cstdint>
+#include <cstdio>
+#include <string>
+
+namespace openmsx {
+
+class FrameSource;
+
+/** Writes raw video frames to the standard input of an external process.
+  *
+  * Each frame is written as width x height pixels of 4 bytes (in memory
+  * order blue, green, red, unused), without any header. For example ffmpeg
+  * can read this with
+  *   ffmpeg -f rawvideo -pix_fmt bgr0 -s 640x480 -r 59.94 -i - ...
+  * A slow process blocks addFrame(), and so slows down the emulation.
+  */
+class PipeWriter
+{
+public:
+	PipeWriter(const std::string& command, unsigned width, unsigned height);
+	~PipeWriter();
+
+	/** Throws MSXException when writing to the pipe failed. */
+	void addFrame(FrameSource* frame);
+
+private:
+	template<typename Pixel> void convertLine(
+		const FrameSource& frame, unsigned y, Endian::L32* out);
+
+private:
+	FILE* pipe;
+	MemBuffer<Endian::L32> frameBuf;
+	const unsigned width;
+	const unsigned height;
+};
+
+} // namespace openmsx
+
+#endif
@@ -22,6 +22,7 @@ TODO:
 #include "GlobalSettings.hh"
 #include "MSXMotherBoard.hh"
 #include "Reactor.hh"
+#include "PerfTimers.hh"
 #include "Timer.hh"
 #include "one_of.hh"
 #include "unreachable.hh"
@@ -210,7 +211,13 @@ void PixelRenderer::frameStart(EmuTime::param time)
 
 	rasterizer->frameStart(time);
 
-	accuracy = renderSettings.getAccuracy();
+	// When not throttled (e.g. fullspeedwhenloading) the painted frames
+	// only show what's going on, so render them as cheap as possible:
+	// the whole frame at once at the end instead of syncing on every VRAM
+	// change. Except when recording video.
+	accuracy = (throttleManager.isThrottled() || rasterizer->isRecording())
+	         ? renderSettings.getAccuracy()
+	         : RenderSettings::ACC_SCREEN;
 
 	nextX = 0;
 	nextY = 0;
@@ -554,6 +561,7 @@ void PixelRenderer::sync(EmuTime::param time, bool force)
 
 void PixelRenderer::renderUntil(EmuTime::param time)
 {
+	PerfTimers::Scope perf(PerfTimers::VDP_RENDER);
 	// Translate from time to pixel position.
 	int limitTicks = vdp.getTicksThisFrame(time);
 	assert(limitTicks <= vdp.getTicksPerFrame());
@@ -6,20 +6,27 @@
 #include "Deflicker.hh"
 #include "SuperImposedFrame.hh"
 #include "PNG.hh"
+#include "PixelOperations.hh"
 #include "RenderSettings.hh"
 #include "RawFrame.hh"
 #include "AviRecorder.hh"
+#include "FrameStreamer.hh"
 #include "CliComm.hh"
 #include "MSXMotherBoard.hh"
 #include "Reactor.hh"
+#include "GlobalSettings.hh"
+#include "BooleanSetting.hh"
 #include "EventDistributor.hh"
 #include "Event.hh"
 #include "CommandException.hh"
 #include "MemBuffer.hh"
 #include "aligned.hh"
 #include "likely.hh"
+#include "ranges.hh"
+#include "stl.hh"
 #include "vla.hh"
 #include "xrange.hh"
+#include "xxhash.hh"
 #include "build-info.hh"
 #include <algorithm>
 #include <cassert>
@@ -47,6 +54,7 @@ PostProcessor::PostProcessor(MSXMotherBoard& motherBoard_,
 	, canDoInterlace(canDoInterlace_)
 	, lastRotate(motherBoard_.getCurrentTime())
 	, eventDistributor(motherBoard_.getReactor().getEventDistributor())
+	, frameStreamer(motherBoard_.getReactor().getFrameStreamer())
 {
 	if (canDoInterlace) {
 		deinterlacedFrame = std::make_unique<DeinterlacedFrame>(
@@ -83,7 +91,7 @@ CliComm& PostProcessor::getCliComm()
 }
 
 unsigned PostProcessor::getLineWidth(
-	FrameSource* frame, unsigned y, unsigned step)
+	const FrameSource* frame, unsigned y, unsigned step)
 {
 	unsigned result = frame->getLineWidth(y);
 	for (auto i : xrange(1u, step)) {
@@ -92,8 +100,8 @@ unsigned PostProcessor::getLineWidth(
 	return result;
 }
 
-std::unique_ptr<RawFrame> PostProcessor::rotateFrames(
-	std::unique_ptr<RawFrame> finishedFrame, EmuTime::param time)
+std::shared_ptr<RawFrame> PostProcessor::rotateFrames(
+	std::shared_ptr<RawFrame> finishedFrame, EmuTime::param time)
 {
 	if (renderSettings.getInterleaveBlackFrame()) {
 		auto delta = time - lastRotate; // time between last two calls
@@ -104,6 +112,9 @@ std::unique_ptr<RawFrame> PostProcessor::rotateFrames(
 	lastRotate = time;
 
 	// Figure out how many past frames we want to use.
+	// Deflicker needs 4 full frames, that's skipped in 'low_memory' mode.
+	bool lowMemory = getMotherBoard().getReactor().getGlobalSettings()
+	                     .getLowMemorySetting().getBoolean();
 	int numRequired = 1;
 	bool doDeinterlace = false;
 	bool doInterlace   = false;
@@ -117,7 +128,7 @@ std::unique_ptr<RawFrame> PostProcessor::rotateFrames(
 			} else {
 				doInterlace = true;
 			}
-		} else if (renderSettings.getDeflicker()) {
+		} else if (renderSettings.getDeflicker() && !lowMemory) {
 			doDeflicker = true;
 			numRequired = 4;
 		}
@@ -140,6 +151,12 @@ std::unique_ptr<RawFrame> PostProcessor::rotateFrames(
 	if (lastFramesCount >= numRequired) {
 		// Only the last 'numRequired' are kept up to date.
 		lastFramesCount = numRequired;
+		if (lowMemory) {
+			// Free the frames that are no longer needed (e.g. after
+			// leaving an interlaced mode), instead of keeping them
+			// for when they're needed again.
+			for (auto i : xrange(numRequired, 4)) lastFrames[i].reset();
+		}
 	} else {
 		// Not enough past frames, fall back to 'regular' rendering.
 		// This situation can only occur when:
@@ -180,10 +197,14 @@ std::unique_ptr<RawFrame> PostProcessor::rotateFrames(
 		paintFrame = superImposedFrame.get();
 	}
 
-	// Possibly record this frame
+	// Possibly record this frame. When it's a plain RawFrame the recorder
+	// can keep it (and read it on the encoder thread), otherwise it copies
+	// the frame right away.
 	if (recorder && needRecord()) {
 		try {
-			recorder->addImage(paintFrame, time);
+			std::shared_ptr<const FrameSource> sharedFrame;
+			if (paintFrame == lastFrames[0].get()) sharedFrame = lastFrames[0];
+			recorder->addImage(paintFrame, std::move(sharedFrame), time);
 		} catch (MSXException& e) {
 			getCliComm().printWarning(
 				"Recording stopped with error: ",
@@ -192,17 +213,48 @@ std::unique_ptr<RawFrame> PostProcessor::rotateFrames(
 			assert(!recorder);
 		}
 	}
+	// Same for a (remote) frame stream client, but only for the active
+	// machine.
+	if (frameStreamer.isConnected() && getMotherBoard().isActive() &&
+	    needRecord()) {
+		frameStreamer.addImage(*paintFrame);
+	}
 
 	// Return recycled frame to the caller
 	if (canDoInterlace) {
-		if (unlikely(!recycleFrame)) {
-			recycleFrame = std::make_unique<RawFrame>(
-				screen.getPixelFormat(), maxWidth, height);
-		}
-		return recycleFrame;
+		return getFreeFrame(std::move(recycleFrame));
 	} else {
-		return std::move(lastFrames[0]);
+		return getFreeFrame(std::move(lastFrames[0]));
+	}
+}
+
+size_t PostProcessor::getFrameMemoryUsage() const
+{
+	size_t result = 0;
+	for (const auto& f : lastFrames) {
+		if (f) result += f->getMemoryUsage();
+	}
+	for (const auto& f : lentFrames) {
+		result += f->getMemoryUsage();
+	}
+	return result;
+}
+
+std::shared_ptr<RawFrame> PostProcessor::getFreeFrame(
+	std::shared_ptr<RawFrame> frame)
+{
+	// Note: when use_count() is 1, only we hold a reference, so it can't
+	// become larger from another thread.
+	if (likely(frame && (frame.use_count() == 1))) return frame;
+	if (frame) lentFrames.push_back(std::move(frame));
+
+	auto it = ranges::find_if(lentFrames, [](auto& f) { return f.use_count() == 1; });
+	if (it != end(lentFrames)) {
+		auto result = std::move(*it);
+		move_pop_back(lentFrames, it);
+		return result;
 	}
+	return std::make_shared<RawFrame>(screen.getPixelFormat(), maxWidth, height);
 }
 
 void PostProcessor::executeUntil(EmuTime::param /*time*/)
@@ -256,7 +308,8 @@ static void getScaledFrame(FrameSource& paintFrame, unsigned bpp,
 	}
 }
 
-void PostProcessor::takeRawScreenShot(unsigned height2, const std::string& filename)
+void PostProcessor::takeRawScreenShot(
+	unsigned height2, const std::string& filename, const PNG::SaveOptions& options)
 {
 	if (!paintFrame) {
 		throw CommandException("TODO");
@@ -266,7 +319,48 @@ void PostProcessor::takeRawScreenShot(unsigned height2, const std::string& filen
 	WorkBuffer workBuffer;
 	getScaledFrame(*paintFrame, getBpp(), height2, lines, workBuffer);
 	unsigned width = (height2 == 240) ? 320 : 640;
-	PNG::save(width, height2, lines, paintFrame->getPixelFormat(), filename);
+	PNG::save(width, height2, lines, paintFrame->getPixelFormat(), filename, options);
+}
+
+template<typename Pixel>
+static uint32_t hashLine(const PixelFormat& format, const Pixel* line, unsigned width)
+{
+	PixelOperations<Pixel> pixelOps(format);
+	VLA(char, rgb, 3 * width);
+	for (auto x : xrange(width)) {
+		rgb[3 * x + 0] = char(pixelOps.red256  (line[x]));
+		rgb[3 * x + 1] = char(pixelOps.green256(line[x]));
+		rgb[3 * x + 2] = char(pixelOps.blue256 (line[x]));
+	}
+	return xxhash(std::string_view(rgb, 3 * width));
+}
+
+uint32_t PostProcessor::getRawFrameHash(unsigned height2)
+{
+	if (!paintFrame) {
+		throw CommandException("No frame available yet");
+	}
+
+	VLA(const void*, lines, height2);
+	WorkBuffer workBuffer;
+	getScaledFrame(*paintFrame, getBpp(), height2, lines, workBuffer);
+	unsigned width = (height2 == 240) ? 320 : 640;
+	const auto& format = paintFrame->getPixelFormat();
+	VLA(uint32_t, lineHashes, height2);
+	for (auto y : xrange(height2)) {
+#if HAVE_32BPP
+		if (getBpp() == 32) {
+			lineHashes[y] = hashLine(format, static_cast<const uint32_t*>(lines[y]), width);
+		} else
+#endif
+		{
+#if HAVE_16BPP
+			lineHashes[y] = hashLine(format, static_cast<const uint16_t*>(lines[y]), width);
+#endif
+		}
+	}
+	return xxhash(std::string_view(reinterpret_cast<const char*>(lineHashes),
+	                               height2 * sizeof(uint32_t)));
 }
 
 unsigned PostProcessor::getBpp() const
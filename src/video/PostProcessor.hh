@@ -5,6 +5,7 @@
 #include "Schedulable.hh"
 #include "EmuTime.hh"
 #include <memory>
+#include <vector>
 
 namespace openmsx {
 
@@ -16,6 +17,7 @@ class Display;
 class DoubledFrame;
 class EventDistributor;
 class FrameSource;
+class FrameStreamer;
 class RawFrame;
 class RenderSettings;
 class SuperImposedFrame;
@@ -40,9 +42,10 @@ public:
 	  *             calculate the framerate for recording (depends on
 	  *             PAL/NTSC, frameskip).
 	  * @return RawFrame object that can be used for building the next frame.
+	  *         No one else holds a reference to it.
 	  */
-	[[nodiscard]] virtual std::unique_ptr<RawFrame> rotateFrames(
-		std::unique_ptr<RawFrame> finishedFrame, EmuTime::param time);
+	[[nodiscard]] virtual std::shared_ptr<RawFrame> rotateFrames(
+		std::shared_ptr<RawFrame> finishedFrame, EmuTime::param time);
 
 	/** Set the Video frame on which to superimpose the 'normal' output of
 	  * this PostProcessor. Superimpose is done (preferably) after the
@@ -86,15 +89,20 @@ public:
 	  */
 	[[nodiscard]] FrameSource* getPaintFrame() const { return paintFrame; }
 
+	/** Memory used by the (unscaled) frames this PostProcessor keeps. */
+	[[nodiscard]] size_t getFrameMemoryUsage() const;
+
 	// VideoLayer
-	void takeRawScreenShot(unsigned height, const std::string& filename) override;
+	void takeRawScreenShot(unsigned height, const std::string& filename,
+	                       const PNG::SaveOptions& options) override;
+	[[nodiscard]] uint32_t getRawFrameHash(unsigned height) override;
 
 	[[nodiscard]] CliComm& getCliComm();
 
 protected:
 	/** Returns the maximum width for lines [y..y+step).
 	  */
-	[[nodiscard]] static unsigned getLineWidth(FrameSource* frame, unsigned y, unsigned step);
+	[[nodiscard]] static unsigned getLineWidth(const FrameSource* frame, unsigned y, unsigned step);
 
 	PostProcessor(
 		MSXMotherBoard& motherBoard, Display& display,
@@ -108,8 +116,10 @@ protected:
 	/** The surface which is visible to the user. */
 	OutputSurface& screen;
 
-	/** The last 4 fully rendered (unscaled) MSX frames. */
-	std::unique_ptr<RawFrame> lastFrames[4];
+	/** The last 4 fully rendered (unscaled) MSX frames.
+	  * Shared, because a consumer (the video recorder) may keep on reading
+	  * a frame after it has left this array, see getFreeFrame(). */
+	std::shared_ptr<RawFrame> lastFrames[4];
 
 	/** Combined the last two frames in a deinterlaced frame. */
 	std::unique_ptr<DeinterlacedFrame> deinterlacedFrame;
@@ -143,6 +153,12 @@ protected:
 	int height;   // these two vars remember how big those should be
 
 private:
+	/** Returns 'frame' when no one else holds a reference to it. Otherwise
+	  * some other frame that's no longer in use (or a new one).
+	  */
+	[[nodiscard]] std::shared_ptr<RawFrame> getFreeFrame(
+		std::shared_ptr<RawFrame> frame);
+
 	// Schedulable
 	void executeUntil(EmuTime::param time) override;
 
@@ -157,6 +173,12 @@ private:
 
 	EmuTime lastRotate;
 	EventDistributor& eventDistributor;
+	FrameStreamer& frameStreamer;
+
+	/** Frames that were still in use by a consumer when they were about to
+	  * be recycled. They are reused once that consumer is done with them.
+	  */
+	std::vector<std::shared_ptr<RawFrame>> lentFrames;
 };
 
 } // namespace openmsx
@@ -40,6 +40,11 @@ public:
 
 	[[nodiscard]] unsigned getRowLength() const override;
 
+	/** Size of the pixel data (in bytes). */
+	[[nodiscard]] size_t getMemoryUsage() const {
+		return size_t(pitch) * getHeight();
+	}
+
 protected:
 	[[nodiscard]] unsigned getLineWidth(unsigned line) const override;
 	[[nodiscard]] const void* getLineInfo(
@@ -2,6 +2,7 @@
 #include "CommandController.hh"
 #include "CommandException.hh"
 #include "Version.hh"
+#include "one_of.hh"
 #include "stl.hh"
 #include "unreachable.hh"
 #include "build-info.hh"
@@ -38,7 +39,8 @@ EnumSetting<RenderSettings::RendererID>::Map RenderSettings::getRendererMap()
 {
 	EnumSetting<RendererID>::Map rendererMap = {
 		{ "none", DUMMY },// TODO: only register when in CliComm mode
-		{ "SDL", SDL } };
+		{ "SDL", SDL },
+		{ "offscreen", OFFSCREEN } };
 #if COMPONENT_GL
 	// compiled with OpenGL-2.0, still need to test whether
 	// it's available at run time, but cannot be done here
@@ -117,6 +119,12 @@ RenderSettings::RenderSettings(CommandController& commandController)
 		"scale_factor", "scale factor",
 		std::min(2, MAX_SCALE_FACTOR), MIN_SCALE_FACTOR, MAX_SCALE_FACTOR)
 
+	, scaleThreadsSetting(commandController,
+		"scaler_threads", "number of threads used to scale the MSX "
+		"image in the SDL renderer (1 = only the main thread, "
+		"0 = one per CPU core)",
+		1, 0, MAX_SCALE_THREADS)
+
 	, scanlineAlphaSetting(commandController,
 		"scanline", "amount of scanline effect: 0 = none, 100 = full",
 		20, 0, 100)
@@ -218,8 +226,9 @@ RenderSettings::RenderSettings(CommandController& commandController)
 	//   save renderer=none
 	rendererSetting.setDontSaveValue(TclObject("none"));
 
-	// A saved value 'none' can be very confusing. If so change it to default.
-	if (rendererSetting.getEnum() == DUMMY) {
+	// A saved value 'none' (or 'offscreen', also without window) can be
+	// very confusing. If so change it to default.
+	if (rendererSetting.getEnum() == one_of(DUMMY, OFFSCREEN)) {
 		rendererSetting.setValue(rendererSetting.getDefaultValue());
 	}
 	// set saved value as default
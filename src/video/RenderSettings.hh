@@ -24,7 +24,7 @@ public:
 	/** Enumeration of Renderers known to openMSX.
 	  * This is the full list, the list of available renderers may be smaller.
 	  */
-	enum RendererID { UNINITIALIZED, DUMMY, SDL, SDLGL_PP };
+	enum RendererID { UNINITIALIZED, DUMMY, SDL, SDLGL_PP, OFFSCREEN };
 	using RendererSetting = EnumSetting<RendererID>;
 
 	/** Render accuracy: granularity of the rendered area.
@@ -119,6 +119,11 @@ public:
 	[[nodiscard]] IntegerSetting& getScaleFactorSetting() { return scaleFactorSetting; }
 	[[nodiscard]] int getScaleFactor() const { return scaleFactorSetting.getInt(); }
 
+	/** The number of threads used to scale the image (SDL renderer),
+	  * 0 means automatic. */
+	static constexpr int MAX_SCALE_THREADS = 16;
+	[[nodiscard]] int getScaleThreads() const { return scaleThreadsSetting.getInt(); }
+
 	/** Limit number of sprites per line?
 	  * If true, limit number of sprites per line as real VDP does.
 	  * If false, display all sprites.
@@ -220,6 +225,7 @@ private:
 	IntegerSetting horizontalBlurSetting;
 	EnumSetting<ScaleAlgorithm> scaleAlgorithmSetting;
 	IntegerSetting scaleFactorSetting;
+	IntegerSetting scaleThreadsSetting;
 	IntegerSetting scanlineAlphaSetting;
 	BooleanSetting limitSpritesSetting;
 	BooleanSetting disableSpritesSetting;
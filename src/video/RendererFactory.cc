@@ -8,6 +8,7 @@
 // Video systems:
 #include "components.hh"
 #include "DummyVideoSystem.hh"
+#include "OffScreenVideoSystem.hh"
 #include "SDLVideoSystem.hh"
 
 // Renderers:
@@ -33,6 +34,8 @@ std::unique_ptr<VideoSystem> createVideoSystem(Reactor& reactor)
 		case RenderSettings::SDLGL_PP:
 			return std::make_unique<SDLVideoSystem>(
 				reactor, display.getCommandConsole());
+		case RenderSettings::OFFSCREEN:
+			return std::make_unique<OffScreenVideoSystem>(display);
 		default:
 			UNREACHABLE; return nullptr;
 	}
@@ -45,6 +48,7 @@ std::unique_ptr<Renderer> createRenderer(VDP& vdp, Display& display)
 			return std::make_unique<DummyRenderer>();
 		case RenderSettings::SDL:
 		case RenderSettings::SDLGL_PP:
+		case RenderSettings::OFFSCREEN:
 			return std::make_unique<PixelRenderer>(vdp, display);
 		default:
 			UNREACHABLE; return nullptr;
@@ -58,6 +62,7 @@ std::unique_ptr<V9990Renderer> createV9990Renderer(V9990& vdp, Display& display)
 			return std::make_unique<V9990DummyRenderer>();
 		case RenderSettings::SDL:
 		case RenderSettings::SDLGL_PP:
+		case RenderSettings::OFFSCREEN:
 			return std::make_unique<V9990PixelRenderer>(vdp);
 		default:
 			UNREACHABLE; return nullptr;
@@ -72,6 +77,7 @@ std::unique_ptr<LDRenderer> createLDRenderer(LaserdiscPlayer& ld, Display& displ
 			return std::make_unique<LDDummyRenderer>();
 		case RenderSettings::SDL:
 		case RenderSettings::SDLGL_PP:
+		case RenderSettings::OFFSCREEN:
 			return std::make_unique<LDPixelRenderer>(ld, display);
 		default:
 			UNREACHABLE; return nullptr;
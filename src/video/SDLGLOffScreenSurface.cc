@@ -25,9 +25,10 @@ SDLGLOffScreenSurface::SDLGLOffScreenSurface(const OutputSurface& output)
 	setOpenGlPixelFormat();
 }
 
-void SDLGLOffScreenSurface::saveScreenshot(const std::string& filename)
+void SDLGLOffScreenSurface::saveScreenshot(
+	const std::string& filename, const PNG::SaveOptions& options)
 {
-	SDLGLVisibleSurface::saveScreenshotGL(*this, filename);
+	SDLGLVisibleSurface::saveScreenshotGL(*this, filename, options);
 }
 
 } // namespace openmsx
@@ -16,7 +16,8 @@ public:
 
 private:
 	// OutputSurface
-	void saveScreenshot(const std::string& filename) override;
+	void saveScreenshot(const std::string& filename,
+	                    const PNG::SaveOptions& options) override;
 
 private:
 	gl::Texture fboTex;
@@ -104,17 +104,20 @@ SDLGLVisibleSurface::~SDLGLVisibleSurface()
 {
 	getDisplay().getRenderSettings().getVSyncSetting().detach(vSyncObserver);
 
+	if (frameFence) glDeleteSync(frameFence);
 	gl::context.reset();
 	SDL_GL_DeleteContext(glContext);
 }
 
-void SDLGLVisibleSurface::saveScreenshot(const std::string& filename)
+void SDLGLVisibleSurface::saveScreenshot(
+	const std::string& filename, const PNG::SaveOptions& options)
 {
-	saveScreenshotGL(*this, filename);
+	saveScreenshotGL(*this, filename, options);
 }
 
 void SDLGLVisibleSurface::saveScreenshotGL(
-	const OutputSurface& output, const std::string& filename)
+	const OutputSurface& output, const std::string& filename,
+	const PNG::SaveOptions& options)
 {
 	auto [x, y] = output.getViewOffset();
 	auto [w, h] = output.getViewSize();
@@ -137,12 +140,25 @@ void SDLGLVisibleSurface::saveScreenshotGL(
 		}
 	}
 
-	PNG::save(w, h, rowPointers, filename);
+	PNG::save(w, h, rowPointers, filename, options);
 }
 
 void SDLGLVisibleSurface::finish()
 {
 	SDL_GL_SwapWindow(window.get());
+
+	// Drivers may queue up several frames ahead of the display, each
+	// queued frame adds a host frame of input-to-screen latency. Allow at
+	// most one frame in flight: before continuing, wait until the GPU
+	// finished the previous frame.
+	if (GLEW_ARB_sync) {
+		if (frameFence) {
+			constexpr GLuint64 TIMEOUT = 100'000'000; // 100ms, in ns
+			glClientWaitSync(frameFence, GL_SYNC_FLUSH_COMMANDS_BIT, TIMEOUT);
+			glDeleteSync(frameFence);
+		}
+		frameFence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	}
 }
 
 std::unique_ptr<Layer> SDLGLVisibleSurface::createSnowLayer()
@@ -2,6 +2,7 @@
 #define SDLGLVISIBLESURFACE_HH
 
 #include "SDLVisibleSurfaceBase.hh"
+#include "GLUtil.hh"
 
 namespace openmsx {
 
@@ -20,10 +21,12 @@ public:
 	~SDLGLVisibleSurface() override;
 
 	static void saveScreenshotGL(const OutputSurface& output,
-	                             const std::string& filename);
+	                             const std::string& filename,
+	                             const PNG::SaveOptions& options);
 
 	// OutputSurface
-	void saveScreenshot(const std::string& filename) override;
+	void saveScreenshot(const std::string& filename,
+	                    const PNG::SaveOptions& options) override;
 
 	// VisibleSurface
 	void finish() override;
@@ -43,6 +46,11 @@ private:
 	} vSyncObserver;
 
 	SDL_GLContext glContext;
+
+	/** Signaled when the GPU is done with the last presented frame.
+	  * See finish(); only used when the driver supports ARB_sync.
+	  */
+	GLsync frameFence = nullptr;
 };
 
 } // namespace openmsx
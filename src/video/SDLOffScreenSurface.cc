@@ -35,9 +35,10 @@ SDLOffScreenSurface::SDLOffScreenSurface(const SDL_Surface& proto)
 	setSDLRenderer(renderer.get());
 }
 
-void SDLOffScreenSurface::saveScreenshot(const std::string& filename)
+void SDLOffScreenSurface::saveScreenshot(
+	const std::string& filename, const PNG::SaveOptions& options)
 {
-	SDLVisibleSurface::saveScreenshotSDL(*this, filename);
+	SDLVisibleSurface::saveScreenshotSDL(*this, filename, options);
 }
 
 void SDLOffScreenSurface::clearScreen()
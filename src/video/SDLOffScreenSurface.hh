@@ -15,7 +15,8 @@ public:
 
 private:
 	// OutputSurface
-	void saveScreenshot(const std::string& filename) override;
+	void saveScreenshot(const std::string& filename,
+	                    const PNG::SaveOptions& options) override;
 	void clearScreen() override;
 
 private:
@@ -10,6 +10,7 @@
 #include "OutputSurface.hh"
 #include "enumerate.hh"
 #include "one_of.hh"
+#include "ranges.hh"
 #include "xrange.hh"
 #include "build-info.hh"
 #include "components.hh"
@@ -68,6 +69,57 @@ inline void SDLRasterizer<Pixel>::renderBitmapLine(Pixel* buf, unsigned vramLine
 	}
 }
 
+template<typename Pixel>
+const Pixel* SDLRasterizer<Pixel>::getBitmapLine(unsigned vramLine)
+{
+	assert(vramLine < std::size(bitmapLineValid));
+	Pixel* line = &bitmapLineCache[vramLine * CACHE_LINE_WIDTH];
+	byte mode = vdp.getDisplayMode().getByte();
+	if (bitmapLineValid[vramLine] != mode) {
+		renderBitmapLine(line, vramLine);
+		bitmapLineValid[vramLine] = mode;
+	}
+	return line;
+}
+
+template<typename Pixel>
+const Pixel* SDLRasterizer<Pixel>::getCharacterLine(unsigned displayY)
+{
+	// This is everything CharacterConverter reads from the VDP.
+	std::array<int, 8> state = {
+		vdp.getDisplayMode().getByte(),
+		vdp.getForegroundColor(), vdp.getBackgroundColor(),
+		vdp.getBlinkForegroundColor(), vdp.getBlinkBackgroundColor(),
+		vdp.getBlinkState(),
+		vdp.getVerticalScroll(), vdp.getHorizontalScrollHigh(),
+	};
+	if (state != charLineState) {
+		charLineState = state;
+		invalidateCharacterLines();
+	}
+
+	assert(displayY < std::size(charLineValid));
+	Pixel* line = &charLineCache[displayY * CACHE_LINE_WIDTH];
+	if (!charLineValid[displayY]) {
+		characterConverter.convertLine(line, displayY);
+		charLineValid[displayY] = true;
+	}
+	return line;
+}
+
+template<typename Pixel>
+void SDLRasterizer<Pixel>::invalidateLineCache()
+{
+	ranges::fill(bitmapLineValid, INVALID_MODE);
+	invalidateCharacterLines();
+}
+
+template<typename Pixel>
+void SDLRasterizer<Pixel>::invalidateCharacterLines()
+{
+	ranges::fill(charLineValid, false);
+}
+
 template<typename Pixel>
 SDLRasterizer<Pixel>::SDLRasterizer(
 		VDP& vdp_, Display& display, OutputSurface& screen_,
@@ -75,12 +127,20 @@ SDLRasterizer<Pixel>::SDLRasterizer(
 	: vdp(vdp_), vram(vdp.getVRAM())
 	, screen(screen_)
 	, postProcessor(std::move(postProcessor_))
-	, workFrame(std::make_unique<RawFrame>(screen.getPixelFormat(), 640, 240))
+	, workFrame(std::make_shared<RawFrame>(screen.getPixelFormat(), 640, 240))
 	, renderSettings(display.getRenderSettings())
 	, characterConverter(vdp, palFg, palBg)
 	, bitmapConverter(palFg, PALETTE256, V9958_COLORS)
 	, spriteConverter(vdp.getSpriteChecker())
+	, charLineCache(256 * CACHE_LINE_WIDTH)
 {
+	// MSX1 VDPs don't have bitmap modes
+	if (!vdp.isMSX1VDP()) {
+		bitmapLineCache.resize(std::size(bitmapLineValid) * CACHE_LINE_WIDTH);
+	}
+	invalidateLineCache();
+	charLineState.fill(-1);
+
 	// Init the palette.
 	precalcPalette();
 
@@ -96,11 +156,21 @@ SDLRasterizer<Pixel>::SDLRasterizer(
 	renderSettings.getBrightnessSetting() .attach(*this);
 	renderSettings.getContrastSetting()   .attach(*this);
 	renderSettings.getColorMatrixSetting().attach(*this);
+
+	vram.bitmapCacheWindow.setObserver(this);
+	vram.nameTable        .setObserver(&charTableObserver);
+	vram.patternTable     .setObserver(&charTableObserver);
+	vram.colorTable       .setObserver(&charTableObserver);
 }
 
 template<typename Pixel>
 SDLRasterizer<Pixel>::~SDLRasterizer()
 {
+	vram.colorTable       .resetObserver();
+	vram.patternTable     .resetObserver();
+	vram.nameTable        .resetObserver();
+	vram.bitmapCacheWindow.resetObserver();
+
 	renderSettings.getColorMatrixSetting().detach(*this);
 	renderSettings.getGammaSetting()      .detach(*this);
 	renderSettings.getBrightnessSetting() .detach(*this);
@@ -117,8 +187,7 @@ template<typename Pixel>
 bool SDLRasterizer<Pixel>::isActive()
 {
 	return postProcessor->needRender() &&
-	       vdp.getMotherBoard().isActive() &&
-	       !vdp.getMotherBoard().isFastForwarding();
+	       vdp.getMotherBoard().needRender();
 }
 
 template<typename Pixel>
@@ -129,6 +198,7 @@ void SDLRasterizer<Pixel>::reset()
 	spriteConverter.setTransparency(vdp.getTransparency());
 
 	resetPalette();
+	invalidateLineCache();
 }
 
 template<typename Pixel>
@@ -165,6 +235,13 @@ void SDLRasterizer<Pixel>::frameStart(EmuTime::param time)
 	// NTSC: display at [32..244),
 	// PAL:  display at [59..271).
 	lineRenderTop = vdp.isPalTiming() ? 59 - 14 : 32 - 14;
+
+	if (paletteDirty) {
+		paletteDirty = false;
+		precalcPalette();
+		resetPalette();
+		invalidateLineCache();
+	}
 }
 
 template<typename Pixel>
@@ -193,6 +270,7 @@ void SDLRasterizer<Pixel>::setPalette(int index, int grb)
 {
 	// Update SDL colors in palette.
 	Pixel newColor = V9938_COLORS[(grb >> 4) & 7][grb >> 8][grb & 7];
+	if (palBg[index] != newColor) invalidateLineCache();
 	palFg[index     ] = newColor;
 	palFg[index + 16] = newColor;
 	palBg[index     ] = newColor;
@@ -354,6 +432,7 @@ void SDLRasterizer<Pixel>::precalcColorIndex0(DisplayMode mode,
 		if (palFg[0] != c) {
 			palFg[0] = c;
 			bitmapConverter.palette16Changed();
+			invalidateLineCache();
 		}
 	} else {
 		// TODO: superimposing
@@ -362,6 +441,7 @@ void SDLRasterizer<Pixel>::precalcColorIndex0(DisplayMode mode,
 			palFg[ 0] = palBg[tpIndex >> 2];
 			palFg[16] = palBg[tpIndex &  3];
 			bitmapConverter.palette16Changed();
+			invalidateLineCache();
 		}
 	}
 }
@@ -509,33 +589,21 @@ void SDLRasterizer<Pixel>::drawDisplay(
 				(vram.nameTable.getMask() >> 7) & (pageMaskOdd  | displayY)
 			};
 
-			Pixel buf[512];
-			int lineInBuf = -1; // buffer data not valid
 			Pixel* dst = workFrame->getLinePtrDirect<Pixel>(y)
 			           + leftBackground + displayX;
 			int firstPageWidth = pageBorder - displayX;
 			if (firstPageWidth > 0) {
-				if (((displayX + hScroll) == 0) &&
-				    (firstPageWidth == lineWidth)) {
-					// fast-path, directly render to destination
-					renderBitmapLine(dst, vramLine[scrollPage1]);
-				} else {
-					lineInBuf = vramLine[scrollPage1];
-					renderBitmapLine(buf, vramLine[scrollPage1]);
-					const Pixel* src = buf + displayX + hScroll;
-					memcpy(dst, src, firstPageWidth * sizeof(Pixel));
-				}
+				const Pixel* src = getBitmapLine(vramLine[scrollPage1])
+				                 + displayX + hScroll;
+				memcpy(dst, src, firstPageWidth * sizeof(Pixel));
 			} else {
 				firstPageWidth = 0;
 			}
 			if (firstPageWidth < displayWidth) {
-				if (lineInBuf != vramLine[scrollPage2]) {
-					renderBitmapLine(buf, vramLine[scrollPage2]);
-				}
 				unsigned x = displayX < pageBorder
 					   ? 0 : displayX + hScroll - lineWidth;
 				memcpy(dst + firstPageWidth,
-				       buf + x,
+				       getBitmapLine(vramLine[scrollPage2]) + x,
 				       (displayWidth - firstPageWidth) * sizeof(Pixel));
 			}
 
@@ -548,14 +616,8 @@ void SDLRasterizer<Pixel>::drawDisplay(
 
 			Pixel* dst = workFrame->getLinePtrDirect<Pixel>(y)
 			           + leftBackground + displayX;
-			if ((displayX == 0) && (displayWidth == lineWidth)){
-				characterConverter.convertLine(dst, displayY);
-			} else {
-				Pixel buf[512];
-				characterConverter.convertLine(buf, displayY);
-				const Pixel* src = buf + displayX;
-				memcpy(dst, src, displayWidth * sizeof(Pixel));
-			}
+			const Pixel* src = getCharacterLine(displayY) + displayX;
+			memcpy(dst, src, displayWidth * sizeof(Pixel));
 
 			displayY = (displayY + 1) & 255;
 		}
@@ -633,11 +695,34 @@ void SDLRasterizer<Pixel>::update(const Setting& setting) noexcept
 	                       &renderSettings.getBrightnessSetting(),
 	                       &renderSettings.getContrastSetting(),
 	                       &renderSettings.getColorMatrixSetting())) {
-		precalcPalette();
-		resetPalette();
+		// Recalculating the palettes is expensive, and e.g. dragging
+		// a slider in the OSD changes these settings many times per
+		// frame. So only do it once, at the start of the next frame.
+		paletteDirty = true;
 	}
 }
 
+template<typename Pixel>
+void SDLRasterizer<Pixel>::updateVRAM(unsigned offset, EmuTime::param /*time*/)
+{
+	// bitmapCacheWindow covers the whole VRAM, so 'offset' is the address.
+	// This is called after the VRAM is written. Also for currently not
+	// displayed lines: those may become visible again later.
+	// Non-planar modes: 128 bytes per line. Planar modes: 256 bytes per
+	// line, split over both 64kB halves (the above-0x200 lines are
+	// mirrors of the lower ones).
+	bitmapLineValid[offset >> 7] = INVALID_MODE;
+	unsigned planarLine = (offset & 0xFFFF) >> 7;
+	bitmapLineValid[planarLine        ] = INVALID_MODE;
+	bitmapLineValid[planarLine | 0x200] = INVALID_MODE;
+}
+
+template<typename Pixel>
+void SDLRasterizer<Pixel>::updateWindow(bool /*enabled*/, EmuTime::param /*time*/)
+{
+	ranges::fill(bitmapLineValid, INVALID_MODE);
+}
+
 
 // Force template instantiation.
 #if HAVE_16BPP
@@ -5,8 +5,12 @@
 #include "BitmapConverter.hh"
 #include "CharacterConverter.hh"
 #include "SpriteConverter.hh"
+#include "VRAMObserver.hh"
+#include "MemBuffer.hh"
 #include "Observer.hh"
+#include "aligned.hh"
 #include "openmsx.hh"
+#include <array>
 #include <memory>
 
 namespace openmsx {
@@ -25,6 +29,7 @@ class PostProcessor;
   */
 template<typename Pixel>
 class SDLRasterizer final : public Rasterizer
+                          , private VRAMObserver
                           , private Observer<Setting>
 {
 public:
@@ -64,6 +69,20 @@ public:
 private:
 	inline void renderBitmapLine(Pixel* buf, unsigned vramLine);
 
+	/** Get the converted pixels (without sprites) of the given VRAM line
+	  * in a bitmap display mode, only converts when not yet cached.
+	  */
+	[[nodiscard]] const Pixel* getBitmapLine(unsigned vramLine);
+
+	/** Idem for the given display line in a character display mode.
+	  */
+	[[nodiscard]] const Pixel* getCharacterLine(unsigned displayY);
+
+	/** Mark all cached lines as invalid.
+	  */
+	void invalidateLineCache();
+	void invalidateCharacterLines();
+
 	/** Reload entire palette from VDP.
 	  */
 	void resetPalette();
@@ -84,6 +103,10 @@ private:
 	// Get the border color(s). These are 16bpp or 32bpp host pixels.
 	std::pair<Pixel, Pixel> getBorderColors();
 
+	// VRAMObserver
+	void updateVRAM(unsigned offset, EmuTime::param time) override;
+	void updateWindow(bool enabled, EmuTime::param time) override;
+
 	// Observer<Setting>
 	void update(const Setting& setting) noexcept override;
 
@@ -107,7 +130,7 @@ private:
 
 	/** The next frame as it is delivered by the VDP, work in progress.
 	  */
-	std::unique_ptr<RawFrame> workFrame;
+	std::shared_ptr<RawFrame> workFrame;
 
 	/** The current renderer settings (gamma, brightness, contrast)
 	  */
@@ -130,6 +153,11 @@ private:
 	  */
 	int lineRenderTop;
 
+	/** Gamma, brightness, contrast or color matrix changed, recalculate
+	  * the palettes at the start of the next frame.
+	  */
+	bool paletteDirty = false;
+
 	/** Host colors corresponding to each VDP palette entry.
 	  * palFg has entry 0 set to the current background color.
 	  *       The 16 first entries are for even pixels, the next 16 are for
@@ -156,6 +184,51 @@ private:
 	/** Host colors corresponding to each possible V9958 color.
 	  */
 	Pixel V9958_COLORS[32768];
+
+	/** Many programs leave (most of) the screen unchanged from frame to
+	  * frame. To avoid converting the same VRAM content again and again,
+	  * converted display lines (before sprites are drawn on top) are
+	  * cached. A line stays valid until VRAM it depends on is written
+	  * (see updateVRAM()), or until some other state it depends on
+	  * changes (palette, display mode, registers).
+	  */
+	static constexpr unsigned CACHE_LINE_WIDTH = 512;
+	static constexpr byte INVALID_MODE = 0xFF; // not a valid DisplayMode
+
+	/** Bitmap modes: indexed by VRAM line (128kB / 128 bytes per line),
+	  * this doesn't depend on scrolling or the displayed page.
+	  */
+	MemBuffer<Pixel, SSE_ALIGNMENT> bitmapLineCache;
+	/** The display mode (byte) in which the cached bitmap line was
+	  * converted, or INVALID_MODE.
+	  */
+	byte bitmapLineValid[1024];
+
+	/** Character modes: indexed by display line. Because every line
+	  * depends on the whole pattern (and color) table, any write inside
+	  * one of the character mode tables invalidates all lines.
+	  */
+	MemBuffer<Pixel, SSE_ALIGNMENT> charLineCache;
+	bool charLineValid[256];
+	/** VDP state (other than VRAM and palette) the cached character lines
+	  * depend on. */
+	std::array<int, 8> charLineState;
+
+	/** Observes the name, pattern and color table. (The rasterizer itself
+	  * observes bitmapCacheWindow, there's only one updateVRAM() method.)
+	  */
+	class CharTableObserver final : public VRAMObserver {
+	public:
+		explicit CharTableObserver(SDLRasterizer& r) : rasterizer(r) {}
+		void updateVRAM(unsigned /*offset*/, EmuTime::param /*time*/) override {
+			rasterizer.invalidateCharacterLines();
+		}
+		void updateWindow(bool /*enabled*/, EmuTime::param /*time*/) override {
+			rasterizer.invalidateCharacterLines();
+		}
+	private:
+		SDLRasterizer& rasterizer;
+	} charTableObserver{*this};
 };
 
 } // namespace openmsx
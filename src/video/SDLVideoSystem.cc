@@ -218,11 +218,12 @@ void SDLVideoSystem::flush()
 	screen->finish();
 }
 
-void SDLVideoSystem::takeScreenShot(const std::string& filename, bool withOsd)
+void SDLVideoSystem::takeScreenShot(
+	const std::string& filename, bool withOsd, const PNG::SaveOptions& options)
 {
 	if (withOsd) {
 		// we can directly save current content as screenshot
-		screen->saveScreenshot(filename);
+		screen->saveScreenshot(filename, options);
 	} else {
 		// we first need to re-render to an off-screen surface
 		// with OSD layers disabled
@@ -230,7 +231,7 @@ void SDLVideoSystem::takeScreenShot(const std::string& filename, bool withOsd)
 		ScopedLayerHider hideOsd(*osdGuiLayer);
 		std::unique_ptr<OutputSurface> surf = screen->createOffScreenSurface();
 		display.repaintImpl(*surf);
-		surf->saveScreenshot(filename);
+		surf->saveScreenshot(filename, options);
 	}
 }
 
@@ -41,7 +41,8 @@ public:
 #endif
 	[[nodiscard]] bool checkSettings() override;
 	void flush() override;
-	void takeScreenShot(const std::string& filename, bool withOsd) override;
+	void takeScreenShot(const std::string& filename, bool withOsd,
+	                    const PNG::SaveOptions& options) override;
 	void updateWindowTitle() override;
 	[[nodiscard]] gl::ivec2 getMouseCoord() override;
 	[[nodiscard]] OutputSurface* getOutputSurface() override;
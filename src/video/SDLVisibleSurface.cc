@@ -107,13 +107,15 @@ std::unique_ptr<OutputSurface> SDLVisibleSurface::createOffScreenSurface()
 	return std::make_unique<SDLOffScreenSurface>(*surface);
 }
 
-void SDLVisibleSurface::saveScreenshot(const std::string& filename)
+void SDLVisibleSurface::saveScreenshot(
+	const std::string& filename, const PNG::SaveOptions& options)
 {
-	saveScreenshotSDL(*this, filename);
+	saveScreenshotSDL(*this, filename, options);
 }
 
 void SDLVisibleSurface::saveScreenshotSDL(
-	const SDLOutputSurface& output, const std::string& filename)
+	const SDLOutputSurface& output, const std::string& filename,
+	const PNG::SaveOptions& options)
 {
 	auto [width, height] = output.getLogicalSize();
 	VLA(const void*, rowPointers, height);
@@ -126,7 +128,7 @@ void SDLVisibleSurface::saveScreenshotSDL(
 			SDL_PIXELFORMAT_RGB24, buffer.data(), width * 3)) {
 		throw MSXException("Couldn't acquire screenshot pixels: ", SDL_GetError());
 	}
-	PNG::save(width, height, rowPointers, filename);
+	PNG::save(width, height, rowPointers, filename, options);
 }
 
 void SDLVisibleSurface::clearScreen()
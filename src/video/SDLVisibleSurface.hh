@@ -17,10 +17,12 @@ public:
 	                  VideoSystem& videoSystem);
 
 	static void saveScreenshotSDL(const SDLOutputSurface& output,
-	                              const std::string& filename);
+	                              const std::string& filename,
+	                              const PNG::SaveOptions& options);
 
 	// OutputSurface
-	void saveScreenshot(const std::string& filename) override;
+	void saveScreenshot(const std::string& filename,
+	                    const PNG::SaveOptions& options) override;
 	void flushFrameBuffer() override;
 	void clearScreen() override;
 
@@ -24,7 +24,7 @@ SpriteChecker::SpriteChecker(VDP& vdp_, RenderSettings& renderSettings,
 	, frameStartTime(time)
 {
 	vram.spriteAttribTable.setObserver(this);
-	vram.spritePatternTable.setObserver(this);
+	vram.spritePatternTable.setObserver(&patternObserver);
 }
 
 void SpriteChecker::reset(EmuTime::param time)
@@ -36,6 +36,8 @@ void SpriteChecker::reset(EmuTime::param time)
 	frameStart(time);
 
 	updateSpritesMethod = &SpriteChecker::updateSprites1;
+	planar = false;
+	lineMasksValid = false;
 }
 
 static constexpr SpriteChecker::SpritePattern doublePattern(SpriteChecker::SpritePattern a)
@@ -76,6 +78,68 @@ inline SpriteChecker::SpritePattern SpriteChecker::calculatePatternPlanar(
 	return !vdp.isSpriteMag() ? pattern : doublePattern(pattern);
 }
 
+inline int SpriteChecker::updateLineMasks(
+	const byte* yPtr, int stride, int endMarker, int magSize)
+{
+	if (!lineMasksValid || (lineMasksMagSize != magSize)) {
+		ranges::fill(lineMasks, 0);
+		int sprite = 0;
+		for (/**/; sprite < 32; ++sprite) {
+			int y = yPtr[stride * sprite];
+			if (y == endMarker) break;
+			// Same condition as '((displayLine - y) & 0xFF) < magSize'.
+			uint32_t bit = uint32_t(1) << sprite;
+			for (auto i : xrange(magSize)) {
+				lineMasks[(y + i) & 0xFF] |= bit;
+			}
+		}
+		lineMasksNumSprites = sprite;
+		lineMasksMagSize = magSize;
+		lineMasksValid = true;
+	}
+	return lineMasksNumSprites;
+}
+
+inline int SpriteChecker::checkCollision(
+	const SpriteInfo* sprites, int count, bool can0collide,
+	byte noCollideMask)
+{
+	// Instead of checking every pair of sprites, accumulate the sprite
+	// pixels of the whole line in a bitmap, 32 pixels per word. Then a
+	// sprite collides when it overlaps with the pixels of the sprites
+	// before it. The leftmost such pixel (over all sprites) is the same
+	// as the leftmost collision pixel of all pairs.
+	// Bitmap word 0 holds the pixels at x=-32..-1, word 9 the pixels at
+	// x=256..287, a collision is only possible in words 1-8.
+	uint32_t pixels[10] = {};
+	int minXCollision = 999; // no collision
+	for (auto i : xrange(count)) {
+		auto colorAttrib = sprites[i].colorAttrib;
+		if (!can0collide && ((colorAttrib & 0xf) == 0)) continue;
+		if (colorAttrib & noCollideMask) continue;
+
+		int pos = sprites[i].x + 32; // [0..287]
+		assert((0 <= pos) && (pos < 288));
+		int w = pos / 32; // [0..8]
+		int shift = pos % 32;
+		SpritePattern pattern = sprites[i].pattern;
+		SpritePattern left  = pattern >> shift;
+		SpritePattern right = shift ? (pattern << (32 - shift)) : 0;
+		SpritePattern colLeft  = (w != 0) ? (pixels[w + 0] & left ) : 0;
+		SpritePattern colRight = (w != 8) ? (pixels[w + 1] & right) : 0;
+		if (colLeft) {
+			int x = 32 * w + Math::countLeadingZeros(colLeft) - 32;
+			minXCollision = std::min(minXCollision, x);
+		} else if (colRight) {
+			int x = 32 * (w + 1) + Math::countLeadingZeros(colRight) - 32;
+			minXCollision = std::min(minXCollision, x);
+		}
+		pixels[w + 0] |= left;
+		pixels[w + 1] |= right;
+	}
+	return minXCollision;
+}
+
 void SpriteChecker::updateSprites1(int limit)
 {
 	if (vdp.spritesEnabledFast()) {
@@ -95,21 +159,15 @@ void SpriteChecker::updateSprites1(int limit)
 
 inline void SpriteChecker::checkSprites1(int minLine, int maxLine)
 {
-	// This implementation contains a double for-loop. The outer loop goes
-	// over the sprites, the inner loop over the to-be-checked lines. This
-	// is not the order in which the real VDP performs this operation: the
-	// real VDP renders line-per-line and for each line checks all 32
-	// sprites.
-	//
-	// Though this 'reverse' order allows to skip over very large regions
-	// of the inner loop: we only have to process the lines were a
-	// particular sprite is actually visible. I measured this makes this
-	// routine 4x-5x faster!
+	// The real VDP renders line-per-line and for each line checks all 32
+	// sprites. We do the same, but instead of looping over all sprites
+	// we use 'lineMasks', which is only recalculated when the
+	// Y-coordinates in the sprite attribute table change. So the work
+	// per line is proportional to the number of sprites on that line.
 	//
 	// This routine also needs to detect the sprite number of the 'first'
 	// 5th-sprite-condition. With 'first' meaning the first line where this
-	// condition occurs. Because our loops are swapped compared to the real
-	// VDP, we need some extra fixup logic to correctly detect this.
+	// condition occurs.
 
 	// Calculate display line.
 	// This is the line sprites are checked at; the line they are displayed
@@ -124,39 +182,28 @@ inline void SpriteChecker::checkSprites1(int minLine, int maxLine)
 	const byte* attributePtr = vram.spriteAttribTable.getReadArea(0, 32 * 4);
 	byte patternIndexMask = size == 16 ? 0xFC : 0xFF;
 	int fifthSpriteNum  = -1;  // no 5th sprite detected yet
-	int fifthSpriteLine = 999; // larger than any possible valid line
-
-	int sprite = 0;
-	for (/**/; sprite < 32; ++sprite) {
-		int y = attributePtr[4 * sprite + 0];
-		if (y == 208) break;
-
-		for (int line = minLine; line < maxLine; ++line) { // 'line' changes in loop
-			// Calculate line number within the sprite.
-			int displayLine = line + displayDelta;
-			int spriteLine = (displayLine - y) & 0xFF;
-			if (spriteLine >= magSize) {
-				// Skip ahead till sprite becomes visible.
-				line += 256 - spriteLine - 1; // -1 because of for-loop
-				continue;
-			}
 
+	int sprite = updateLineMasks(attributePtr, 4, 208, magSize);
+	for (auto line : xrange(minLine, maxLine)) {
+		int displayLine = line + displayDelta;
+		for (uint32_t mask = lineMasks[displayLine & 0xFF]; mask; mask &= mask - 1) {
+			int s = Math::findFirstSet(mask) - 1;
 			int visibleIndex = spriteCount[line];
 			if (visibleIndex == 4) {
-				// Find earliest line where this condition occurs.
-				if (line < fifthSpriteLine) {
-					fifthSpriteLine = line;
-					fifthSpriteNum = sprite;
-				}
-				if (limitSprites) continue;
+				// Lines are checked in order, so the first
+				// detection is on the earliest line.
+				if (fifthSpriteNum == -1) fifthSpriteNum = s;
+				if (limitSprites) break;
 			}
 
+			// Calculate line number within the sprite.
+			int spriteLine = (displayLine - attributePtr[4 * s + 0]) & 0xFF;
 			SpriteInfo& sip = spriteBuffer[line][visibleIndex];
-			int patternIndex = attributePtr[4 * sprite + 2] & patternIndexMask;
+			int patternIndex = attributePtr[4 * s + 2] & patternIndexMask;
 			if (mag) spriteLine /= 2;
 			sip.pattern = calculatePatternNP(patternIndex, spriteLine);
-			sip.x = attributePtr[4 * sprite + 1];
-			byte colorAttrib = attributePtr[4 * sprite + 3];
+			sip.x = attributePtr[4 * s + 1];
+			byte colorAttrib = attributePtr[4 * s + 3];
 			if (colorAttrib & 0x80) sip.x -= 32;
 			sip.colorAttrib = colorAttrib;
 
@@ -199,45 +246,13 @@ inline void SpriteChecker::checkSprites1(int minLine, int maxLine)
 	  they can collide in the V9958 extra border mask. This behaviour is
 	  the same in sprite mode 1 and 2.
 
-	Implemented by checking every pair for collisions.
-	For large numbers of sprites that would be slow,
-	but there are max 4 sprites and therefore max 6 pairs.
-	If any collision is found, method returns at once.
+	See checkCollision() for the implementation.
 	*/
 	bool can0collide = vdp.canSpriteColor0Collide();
 	for (auto line : xrange(minLine, maxLine)) {
-		int minXCollision = 999;
-		for (int i = std::min<int>(4, spriteCount[line]); --i >= 1; /**/) {
-			auto color1 = spriteBuffer[line][i].colorAttrib & 0xf;
-			if (!can0collide && (color1 == 0)) continue;
-			int x_i = spriteBuffer[line][i].x;
-			SpritePattern pattern_i = spriteBuffer[line][i].pattern;
-			for (int j = i; --j >= 0; /**/) {
-				auto color2 = spriteBuffer[line][j].colorAttrib & 0xf;
-				if (!can0collide && (color2 == 0)) continue;
-				// Do sprite i and sprite j collide?
-				int x_j = spriteBuffer[line][j].x;
-				int dist = x_j - x_i;
-				if ((-magSize < dist) && (dist < magSize)) {
-					SpritePattern pattern_j = spriteBuffer[line][j].pattern;
-					if (dist < 0) {
-						pattern_j <<= -dist;
-					} else {
-						pattern_j >>= dist;
-					}
-					SpritePattern colPat = pattern_i & pattern_j;
-					if (x_i < 0) {
-						assert(x_i >= -32);
-						colPat &= (1 << (32 + x_i)) - 1;
-					}
-					if (colPat) {
-						int xCollision = x_i + Math::countLeadingZeros(colPat);
-						assert(xCollision >= 0);
-						minXCollision = std::min(minXCollision, xCollision);
-					}
-				}
-			}
-		}
+		int minXCollision = checkCollision(
+			spriteBuffer[line], std::min<int>(4, spriteCount[line]),
+			can0collide, 0);
 		if (minXCollision < 256) {
 			vdp.setSpriteStatus(vdp.getStatusReg0() | 0x20);
 			// verified: collision coords are also filled
@@ -271,7 +286,7 @@ void SpriteChecker::updateSprites2(int limit)
 
 inline void SpriteChecker::checkSprites2(int minLine, int maxLine)
 {
-	// See comment in checkSprites1() about order of inner and outer loops.
+	// See comment in checkSprites1() about 'lineMasks'.
 
 	// Calculate display line.
 	// This is the line sprites are checked at; the line they are displayed
@@ -285,7 +300,6 @@ inline void SpriteChecker::checkSprites2(int minLine, int maxLine)
 	int magSize = (mag + 1) * size;
 	int patternIndexMask = (size == 16) ? 0xFC : 0xFF;
 	int ninthSpriteNum  = -1;  // no 9th sprite detected yet
-	int ninthSpriteLine = 999; // larger than any possible valid line
 
 	// Because it gave a measurable performance boost, we duplicated the
 	// code for planar and non-planar modes.
@@ -293,40 +307,31 @@ inline void SpriteChecker::checkSprites2(int minLine, int maxLine)
 	if (planar) {
 		auto [attributePtr0, attributePtr1] =
 			vram.spriteAttribTable.getReadAreaPlanar(512, 32 * 4);
+		sprite = updateLineMasks(attributePtr0, 2, 216, magSize);
 		// TODO: Verify CC implementation.
-		for (/**/; sprite < 32; ++sprite) {
-			int y = attributePtr0[2 * sprite + 0];
-			if (y == 216) break;
-
-			for (int line = minLine; line < maxLine; ++line) { // 'line' changes in loop
-				// Calculate line number within the sprite.
-				int displayLine = line + displayDelta;
-				int spriteLine = (displayLine - y) & 0xFF;
-				if (spriteLine >= magSize) {
-					// Skip ahead till sprite is visible.
-					line += 256 - spriteLine - 1;
-					continue;
-				}
-
+		for (auto line : xrange(minLine, maxLine)) {
+			int displayLine = line + displayDelta;
+			for (uint32_t mask = lineMasks[displayLine & 0xFF]; mask; mask &= mask - 1) {
+				int s = Math::findFirstSet(mask) - 1;
 				int visibleIndex = spriteCount[line];
 				if (visibleIndex == 8) {
-					// Find earliest line where this condition occurs.
-					if (line < ninthSpriteLine) {
-						ninthSpriteLine = line;
-						ninthSpriteNum = sprite;
-					}
-					if (limitSprites) continue;
+					// Lines are checked in order, so the
+					// first detection is on the earliest line.
+					if (ninthSpriteNum == -1) ninthSpriteNum = s;
+					if (limitSprites) break;
 				}
 
+				// Calculate line number within the sprite.
+				int spriteLine = (displayLine - attributePtr0[2 * s + 0]) & 0xFF;
 				if (mag) spriteLine /= 2;
-				int colorIndex = (~0u << 10) | (sprite * 16 + spriteLine);
+				int colorIndex = (~0u << 10) | (s * 16 + spriteLine);
 				byte colorAttrib =
 					vram.spriteAttribTable.readPlanar(colorIndex);
 
 				SpriteInfo& sip = spriteBuffer[line][visibleIndex];
-				int patternIndex = attributePtr0[2 * sprite + 1] & patternIndexMask;
+				int patternIndex = attributePtr0[2 * s + 1] & patternIndexMask;
 				sip.pattern = calculatePatternPlanar(patternIndex, spriteLine);
-				sip.x = attributePtr1[2 * sprite + 0];
+				sip.x = attributePtr1[2 * s + 0];
 				if (colorAttrib & 0x80) sip.x -= 32;
 				sip.colorAttrib = colorAttrib;
 
@@ -338,33 +343,24 @@ inline void SpriteChecker::checkSprites2(int minLine, int maxLine)
 	} else {
 		const byte* attributePtr0 =
 			vram.spriteAttribTable.getReadArea(512, 32 * 4);
+		sprite = updateLineMasks(attributePtr0, 4, 216, magSize);
 		// TODO: Verify CC implementation.
-		for (/**/; sprite < 32; ++sprite) {
-			int y = attributePtr0[4 * sprite + 0];
-			if (y == 216) break;
-
-			for (int line = minLine; line < maxLine; ++line) { // 'line' changes in loop
-				// Calculate line number within the sprite.
-				int displayLine = line + displayDelta;
-				int spriteLine = (displayLine - y) & 0xFF;
-				if (spriteLine >= magSize) {
-					// Skip ahead till sprite is visible.
-					line += 256 - spriteLine - 1;
-					continue;
-				}
-
+		for (auto line : xrange(minLine, maxLine)) {
+			int displayLine = line + displayDelta;
+			for (uint32_t mask = lineMasks[displayLine & 0xFF]; mask; mask &= mask - 1) {
+				int s = Math::findFirstSet(mask) - 1;
 				int visibleIndex = spriteCount[line];
 				if (visibleIndex == 8) {
-					// Find earliest line where this condition occurs.
-					if (line < ninthSpriteLine) {
-						ninthSpriteLine = line;
-						ninthSpriteNum = sprite;
-					}
-					if (limitSprites) continue;
+					// Lines are checked in order, so the
+					// first detection is on the earliest line.
+					if (ninthSpriteNum == -1) ninthSpriteNum = s;
+					if (limitSprites) break;
 				}
 
+				// Calculate line number within the sprite.
+				int spriteLine = (displayLine - attributePtr0[4 * s + 0]) & 0xFF;
 				if (mag) spriteLine /= 2;
-				int colorIndex = (~0u << 10) | (sprite * 16 + spriteLine);
+				int colorIndex = (~0u << 10) | (s * 16 + spriteLine);
 				byte colorAttrib =
 					vram.spriteAttribTable.readNP(colorIndex);
 				// Sprites with CC=1 are only visible if preceded by
@@ -374,9 +370,9 @@ inline void SpriteChecker::checkSprites2(int minLine, int maxLine)
 				//    https://github.com/openMSX/openMSX/issues/497
 
 				SpriteInfo& sip = spriteBuffer[line][visibleIndex];
-				int patternIndex = attributePtr0[4 * sprite + 2] & patternIndexMask;
+				int patternIndex = attributePtr0[4 * s + 2] & patternIndexMask;
 				sip.pattern = calculatePatternNP(patternIndex, spriteLine);
-				sip.x = attributePtr0[4 * sprite + 1];
+				sip.x = attributePtr0[4 * s + 1];
 				if (colorAttrib & 0x80) sip.x -= 32;
 				sip.colorAttrib = colorAttrib;
 
@@ -431,53 +427,14 @@ inline void SpriteChecker::checkSprites2(int minLine, int maxLine)
 	  they can collide in the V9958 extra border mask. This behaviour is
 	  the same in sprite mode 1 and 2.
 
-	Implemented by checking every pair for collisions.
-	For large numbers of sprites that would be slow.
-	There are max 8 sprites and therefore max 42 pairs.
-	  TODO: Maybe this is slow... Think of something faster.
-	        Probably new approach is needed anyway for OR-ing.
+	If CC or IC is set, a sprite cannot collide.
+	See checkCollision() for the implementation.
 	*/
 	bool can0collide = vdp.canSpriteColor0Collide();
 	for (auto line : xrange(minLine, maxLine)) {
-		int minXCollision = 999; // no collision
-		SpriteInfo* visibleSprites = spriteBuffer[line];
-		for (int i = std::min<int>(8, spriteCount[line]); --i >= 1; /**/) {
-			auto colorAttrib1 = visibleSprites[i].colorAttrib;
-			if (!can0collide && ((colorAttrib1 & 0xf) == 0)) continue;
-			// If CC or IC is set, this sprite cannot collide.
-			if (colorAttrib1 & 0x60) continue;
-
-			int x_i = visibleSprites[i].x;
-			SpritePattern pattern_i = visibleSprites[i].pattern;
-			for (int j = i; --j >= 0; /**/) {
-				auto colorAttrib2 = visibleSprites[j].colorAttrib;
-				if (!can0collide && ((colorAttrib2 & 0xf) == 0)) continue;
-				// If CC or IC is set, this sprite cannot collide.
-				if (colorAttrib2 & 0x60) continue;
-
-				// Do sprite i and sprite j collide?
-				int x_j = visibleSprites[j].x;
-				int dist = x_j - x_i;
-				if ((-magSize < dist) && (dist < magSize)) {
-					SpritePattern pattern_j = visibleSprites[j].pattern;
-					if (dist < 0) {
-						pattern_j <<= -dist;
-					} else {
-						pattern_j >>= dist;
-					}
-					SpritePattern colPat = pattern_i & pattern_j;
-					if (x_i < 0) {
-						assert(x_i >= -32);
-						colPat &= (1 << (32 + x_i)) - 1;
-					}
-					if (colPat) {
-						int xCollision = x_i + Math::countLeadingZeros(colPat);
-						assert(xCollision >= 0);
-						minXCollision = std::min(minXCollision, xCollision);
-					}
-				}
-			}
-		}
+		int minXCollision = checkCollision(
+			spriteBuffer[line], std::min<int>(8, spriteCount[line]),
+			can0collide, 0x60);
 		if (minXCollision < 256) {
 			vdp.setSpriteStatus(vdp.getStatusReg0() | 0x20);
 			// x-coord should be increased by 12
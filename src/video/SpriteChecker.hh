@@ -245,14 +245,22 @@ public:
 		return spriteCount[line];
 	}
 
-	// VRAMObserver implementation:
+	// VRAMObserver implementation (sprite attribute table):
 
-	void updateVRAM(unsigned /*offset*/, EmuTime::param time) override {
+	void updateVRAM(unsigned offset, EmuTime::param time) override {
 		checkUntil(time);
+		// Only the Y-coordinates (which includes the end marker) are
+		// used to build 'lineMasks'. In non-planar modes these are
+		// at the offsets that are a multiple of 4 (for sprite mode 2
+		// this also matches some color table bytes, that's fine).
+		if (planar || ((offset & 3) == 0)) {
+			lineMasksValid = false;
+		}
 	}
 
 	void updateWindow(bool /*enabled*/, EmuTime::param time) override {
 		sync(time);
+		lineMasksValid = false;
 	}
 
 	template<typename Archive>
@@ -262,6 +270,8 @@ private:
 	/** Calculate 'updateSpritesMethod' and 'planar'.
 	  */
 	inline void setDisplayMode(DisplayMode mode) {
+		lineMasksValid = false;
+		planar = false;
 		switch (mode.getSpriteMode(vdp.isMSX1VDP())) {
 		case 0:
 			updateSpritesMethod = nullptr;
@@ -299,6 +309,24 @@ private:
 	[[nodiscard]] inline SpritePattern calculatePatternNP(unsigned patternNr, unsigned y);
 	[[nodiscard]] inline SpritePattern calculatePatternPlanar(unsigned patternNr, unsigned y);
 
+	/** (Re)calculate 'lineMasks' (when needed).
+	  * @param yPtr Pointer to the Y-coordinate of the first sprite.
+	  * @param stride Distance between the Y-coordinates of two sprites.
+	  * @param endMarker Y-coordinate that marks the end of the sprite list.
+	  * @param magSize Height in pixels of a (magnified) sprite.
+	  * @return The number of sprites before the end marker.
+	  */
+	inline int updateLineMasks(const byte* yPtr, int stride, int endMarker,
+	                           int magSize);
+
+	/** Check collision between the given sprites on one line.
+	  * @return The smallest x-coordinate where two sprites overlap, or a
+	  *         value >= 256 if there is no collision in the visible area.
+	  */
+	[[nodiscard]] static inline int checkCollision(
+		const SpriteInfo* sprites, int count, bool can0collide,
+		byte noCollideMask);
+
 	/** Check sprite collision and number of sprites per line.
 	  * This routine implements sprite mode 1 (MSX1).
 	  * Separated from display code to make MSX behaviour consistent
@@ -375,10 +403,39 @@ private:
 	  */
 	uint8_t spriteCount[313];
 
+	/** For each (vertically scrolled) display line modulo 256, a bitmask
+	  * of the sprites that are visible on that line (bit 0 is sprite 0).
+	  * This avoids looping over all sprites on every checkUntil() call.
+	  * Only depends on the Y-coordinates in the sprite attribute table and
+	  * on the sprite height. It is invalidated on changes of the former,
+	  * 'lineMasksMagSize' is used to detect changes of the latter.
+	  */
+	uint32_t lineMasks[256];
+	int lineMasksMagSize = 0;
+	int lineMasksNumSprites = 0; // number of sprites before the end marker
+	bool lineMasksValid = false;
+
 	/** Is current display mode planar or not?
 	  * TODO: Introduce separate update methods for planar/nonplanar modes.
 	  */
-	bool planar;
+	bool planar = false;
+
+	/** Observes the sprite pattern table. Those changes only require a
+	  * sync, while changes in the attribute table (observed by the
+	  * SpriteChecker itself) also invalidate 'lineMasks'.
+	  */
+	class PatternObserver final : public VRAMObserver {
+	public:
+		explicit PatternObserver(SpriteChecker& c) : checker(c) {}
+		void updateVRAM(unsigned /*offset*/, EmuTime::param time) override {
+			checker.checkUntil(time);
+		}
+		void updateWindow(bool /*enabled*/, EmuTime::param time) override {
+			checker.sync(time);
+		}
+	private:
+		SpriteChecker& checker;
+	} patternObserver{*this};
 };
 SERIALIZE_CLASS_VERSION(SpriteChecker, 2);
 
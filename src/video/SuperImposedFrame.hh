@@ -19,6 +19,11 @@ public:
 	void init(const FrameSource* top, const FrameSource* bottom);
 	virtual ~SuperImposedFrame() = default;
 
+	/** The two input frames, e.g. for a renderer that does the blending
+	  * itself (on the GPU) instead of via getLineInfo(). */
+	[[nodiscard]] const FrameSource* getTop()    const { return top; }
+	[[nodiscard]] const FrameSource* getBottom() const { return bottom; }
+
 protected:
 	explicit SuperImposedFrame(const PixelFormat& format);
 
@@ -87,6 +87,8 @@ VDP::VDP(const DeviceConfig& config)
 	, frameStartTime(getCurrentTime())
 	, irqVertical  (getMotherBoard(), getName() + ".IRQvertical",   config)
 	, irqHorizontal(getMotherBoard(), getName() + ".IRQhorizontal", config)
+	, registerWriteProbe(getMotherBoard().getDebugger(), getName() + ".registerWrite",
+		"Last write to a VDP control register: (register << 8) | value.", 0)
 	, displayStartSyncTime(getCurrentTime())
 	, vScanSyncTime(getCurrentTime())
 	, hScanSyncTime(getCurrentTime())
@@ -169,6 +171,9 @@ VDP::VDP(const DeviceConfig& config)
 		0,    0,    0,    0,    0,    0,    0,    0,    // 24..31
 	};
 	controlRegMask = (isMSX1VDP() ? 0x07 : 0x3F);
+	ioPortMask = (isMSX1VDP() ? 0x01 : 0x03);
+	cpuVramAccessDelta = isMSX1VDP() ? VDPAccessSlots::DELTA_28
+	                                 : VDPAccessSlots::DELTA_16;
 	memcpy(controlValueMasks,
 	       isMSX1VDP() ? VALUE_MASKS_MSX1 : VALUE_MASKS_MSX2,
 	       sizeof(controlValueMasks));
@@ -657,10 +662,11 @@ void VDP::writeIO(word port, byte value, EmuTime::param time_)
 	// cycle and for other x it seems the delay is 2 cycles
 	if (fixedVDPIOdelayCycles > 0) {
 		time = cpu.waitCyclesZ80(time, fixedVDPIOdelayCycles);
+		cpu.getTimingStats().vdpIOStall.add(TimingStats::toCycles(time - time_));
 	}
 
 	assert(isInsideFrame(time));
-	switch (port & (isMSX1VDP() ? 0x01 : 0x03)) {
+	switch (port & ioPortMask) {
 	case 0: // VRAM data write
 		vramWrite(value, time);
 		registerDataStored = false;
@@ -771,6 +777,7 @@ void VDP::scheduleCpuVramAccess(bool isRead, byte write, EmuTime::param time)
 		// Already scheduled. Do nothing.
 		// The old request has been overwritten by the new request!
 		assert(!allowTooFastAccess);
+		++cpu.getTimingStats().vramTooFast;
 		tooFastCallback.execute();
 	} else {
 		if (unlikely(allowTooFastAccess)) {
@@ -816,9 +823,9 @@ void VDP::scheduleCpuVramAccess(bool isRead, byte write, EmuTime::param time)
 			// other variables that influence the exact timing (7
 			// vs 8 cycles).
 			pendingCpuAccess = true;
-			auto delta = isMSX1VDP() ? VDPAccessSlots::DELTA_28
-						 : VDPAccessSlots::DELTA_16;
-			syncCpuVramAccess.setSyncPoint(getAccessSlot(time, delta));
+			EmuTime slot = getAccessSlot(time, cpuVramAccessDelta);
+			cpu.getTimingStats().vramAccess.add(TimingStats::toCycles(slot - time));
+			syncCpuVramAccess.setSyncPoint(slot);
 		}
 	}
 }
@@ -965,7 +972,7 @@ byte VDP::readIO(word port, EmuTime::param time)
 
 	registerDataStored = false; // Abort any port #1 writes in progress.
 
-	switch (port & (isMSX1VDP() ? 0x01 : 0x03)) {
+	switch (port & ioPortMask) {
 	case 0: // VRAM data read
 		return vramRead(time);
 	case 1: // Status register read
@@ -987,6 +994,8 @@ byte VDP::peekIO(word /*port*/, EmuTime::param /*time*/) const
 
 void VDP::changeRegister(byte reg, byte val, EmuTime::param time)
 {
+	registerWriteProbe = (reg << 8) | val;
+
 	if (reg >= 32) {
 		// MXC belongs to CPU interface;
 		// other bits in this register belong to command engine.
@@ -1167,7 +1176,7 @@ void VDP::changeRegister(byte reg, byte val, EmuTime::param time)
 		if ((change & 0x80) && isVDPwithVRAMremapping()) {
 			// confirmed: VRAM remapping only happens on TMS99xx
 			// see VDPVRAM for details on the remapping itself
-			vram->change4k8kMapping((val & 0x80) != 0);
+			vram->change4k8kMapping((val & 0x80) != 0, time);
 		}
 		break;
 	case 2:
@@ -1073,6 +1073,12 @@ private:
 	  */
 	OptionalIRQHelper irqHorizontal;
 
+	/** Signals writes to the control registers, the value is
+	  * (register << 8) | value. Rewriting the last written value to the
+	  * same register is not signalled again.
+	  */
+	Probe<int> registerWriteProbe;
+
 	/** Time of last set DISPLAY_START sync point.
 	  */
 	EmuTime displayStartSyncTime;
@@ -1134,6 +1140,15 @@ private:
 	  */
 	int controlRegMask;
 
+	/** Mask on the I/O port number: TMS99x8 only decodes 2 ports.
+	  * Like the masks above this only depends on the VDP type, so it's
+	  * calculated once instead of testing the type on every I/O access. */
+	byte ioPortMask;
+
+	/** Minimal delay between a CPU-VRAM access request and the access
+	  * itself, see scheduleCpuVramAccess(). */
+	VDPAccessSlots::Delta cpuVramAccessDelta;
+
 	/** Mask on the values of control registers.
 	  * This saves a lot of masking when using the register values,
 	  * because it is guaranteed non-existant bits are always zero.
@@ -70,6 +70,7 @@ public:
 	/** Advance time to the earliest access slot that is at least 'delta'
 	  * ticks later than the current time. */
 	inline void next(Delta delta) {
+		++numSlots;
 		ticks += tab[delta + ticks];
 		if (unlikely(ticks >= TICKS)) {
 			ticks -= TICKS;
@@ -78,9 +79,14 @@ public:
 		}
 	}
 
+	/** The number of calls to next(), so the number of access slots that
+	  * were used (only for statistics). */
+	[[nodiscard]] unsigned getNumSlots() const { return numSlots; }
+
 private:
 	int ticks;
 	int limit;
+	unsigned numSlots = 0;
 	VDP::VDPClock ref;
 	const uint8_t* const tab;
 };
@@ -36,6 +36,8 @@ TODO:
 #include "VDPCmdEngine.hh"
 #include "EmuTime.hh"
 #include "VDPVRAM.hh"
+#include "MSXCPU.hh"
+#include "MSXMotherBoard.hh"
 #include "serialize.hh"
 #include "unreachable.hh"
 #include <algorithm>
@@ -168,10 +170,11 @@ struct Graphic4Mode
 	static constexpr byte PIXELS_PER_BYTE = 2;
 	static constexpr byte PIXELS_PER_BYTE_SHIFT = 1;
 	static constexpr unsigned PIXELS_PER_LINE = 256;
+	static constexpr bool PLANAR = false;
 	static inline unsigned addressOf(unsigned x, unsigned y, bool extVRAM);
 	static inline byte point(VDPVRAM& vram, unsigned x, unsigned y, bool extVRAM);
-	template<typename LogOp>
-	static inline void pset(EmuTime::param time, VDPVRAM& vram,
+	template<typename VRAM, typename LogOp>
+	static inline void pset(EmuTime::param time, VRAM& vram,
 		unsigned x, unsigned addr, byte src, byte color, LogOp op);
 	static inline byte duplicate(byte color);
 };
@@ -191,9 +194,9 @@ inline byte Graphic4Mode::point(
 		>> (((~x) & 1) << 2)) & 15;
 }
 
-template<typename LogOp>
+template<typename VRAM, typename LogOp>
 inline void Graphic4Mode::pset(
-	EmuTime::param time, VDPVRAM& vram, unsigned x, unsigned addr,
+	EmuTime::param time, VRAM& vram, unsigned x, unsigned addr,
 	byte src, byte color, LogOp op)
 {
 	byte sh = ((~x) & 1) << 2;
@@ -218,10 +221,11 @@ struct Graphic5Mode
 	static constexpr byte PIXELS_PER_BYTE = 4;
 	static constexpr byte PIXELS_PER_BYTE_SHIFT = 2;
 	static constexpr unsigned PIXELS_PER_LINE = 512;
+	static constexpr bool PLANAR = false;
 	static inline unsigned addressOf(unsigned x, unsigned y, bool extVRAM);
 	static inline byte point(VDPVRAM& vram, unsigned x, unsigned y, bool extVRAM);
-	template<typename LogOp>
-	static inline void pset(EmuTime::param time, VDPVRAM& vram,
+	template<typename VRAM, typename LogOp>
+	static inline void pset(EmuTime::param time, VRAM& vram,
 		unsigned x, unsigned addr, byte src, byte color, LogOp op);
 	static inline byte duplicate(byte color);
 };
@@ -241,9 +245,9 @@ inline byte Graphic5Mode::point(
 		>> (((~x) & 3) << 1)) & 3;
 }
 
-template<typename LogOp>
+template<typename VRAM, typename LogOp>
 inline void Graphic5Mode::pset(
-	EmuTime::param time, VDPVRAM& vram, unsigned x, unsigned addr,
+	EmuTime::param time, VRAM& vram, unsigned x, unsigned addr,
 	byte src, byte color, LogOp op)
 {
 	byte sh = ((~x) & 3) << 1;
@@ -270,10 +274,11 @@ struct Graphic6Mode
 	static constexpr byte PIXELS_PER_BYTE = 2;
 	static constexpr byte PIXELS_PER_BYTE_SHIFT = 1;
 	static constexpr unsigned PIXELS_PER_LINE = 512;
+	static constexpr bool PLANAR = true;
 	static inline unsigned addressOf(unsigned x, unsigned y, bool extVRAM);
 	static inline byte point(VDPVRAM& vram, unsigned x, unsigned y, bool extVRAM);
-	template<typename LogOp>
-	static inline void pset(EmuTime::param time, VDPVRAM& vram,
+	template<typename VRAM, typename LogOp>
+	static inline void pset(EmuTime::param time, VRAM& vram,
 		unsigned x, unsigned addr, byte src, byte color, LogOp op);
 	static inline byte duplicate(byte color);
 };
@@ -293,9 +298,9 @@ inline byte Graphic6Mode::point(
 		>> (((~x) & 1) << 2)) & 15;
 }
 
-template<typename LogOp>
+template<typename VRAM, typename LogOp>
 inline void Graphic6Mode::pset(
-	EmuTime::param time, VDPVRAM& vram, unsigned x, unsigned addr,
+	EmuTime::param time, VRAM& vram, unsigned x, unsigned addr,
 	byte src, byte color, LogOp op)
 {
 	byte sh = ((~x) & 1) << 2;
@@ -320,10 +325,11 @@ struct Graphic7Mode
 	static constexpr byte PIXELS_PER_BYTE = 1;
 	static constexpr byte PIXELS_PER_BYTE_SHIFT = 0;
 	static constexpr unsigned PIXELS_PER_LINE = 256;
+	static constexpr bool PLANAR = true;
 	static inline unsigned addressOf(unsigned x, unsigned y, bool extVRAM);
 	static inline byte point(VDPVRAM& vram, unsigned x, unsigned y, bool extVRAM);
-	template<typename LogOp>
-	static inline void pset(EmuTime::param time, VDPVRAM& vram,
+	template<typename VRAM, typename LogOp>
+	static inline void pset(EmuTime::param time, VRAM& vram,
 		unsigned x, unsigned addr, byte src, byte color, LogOp op);
 	static inline byte duplicate(byte color);
 };
@@ -342,9 +348,9 @@ inline byte Graphic7Mode::point(
 	return vram.cmdReadWindow.readNP(addressOf(x, y, extVRAM));
 }
 
-template<typename LogOp>
+template<typename VRAM, typename LogOp>
 inline void Graphic7Mode::pset(
-	EmuTime::param time, VDPVRAM& vram, unsigned /*x*/, unsigned addr,
+	EmuTime::param time, VRAM& vram, unsigned /*x*/, unsigned addr,
 	byte src, byte color, LogOp op)
 {
 	op(time, vram, addr, src, color, 0);
@@ -368,10 +374,11 @@ struct NonBitmapMode
 	static constexpr byte PIXELS_PER_BYTE = 1;
 	static constexpr byte PIXELS_PER_BYTE_SHIFT = 0;
 	static constexpr unsigned PIXELS_PER_LINE = 256;
+	static constexpr bool PLANAR = false;
 	static inline unsigned addressOf(unsigned x, unsigned y, bool extVRAM);
 	static inline byte point(VDPVRAM& vram, unsigned x, unsigned y, bool extVRAM);
-	template<typename LogOp>
-	static inline void pset(EmuTime::param time, VDPVRAM& vram,
+	template<typename VRAM, typename LogOp>
+	static inline void pset(EmuTime::param time, VRAM& vram,
 		unsigned x, unsigned addr, byte src, byte color, LogOp op);
 	static inline byte duplicate(byte color);
 };
@@ -390,9 +397,9 @@ inline byte NonBitmapMode::point(
 	return vram.cmdReadWindow.readNP(addressOf(x, y, extVRAM));
 }
 
-template<typename LogOp>
+template<typename VRAM, typename LogOp>
 inline void NonBitmapMode::pset(
-	EmuTime::param time, VDPVRAM& vram, unsigned /*x*/, unsigned addr,
+	EmuTime::param time, VRAM& vram, unsigned /*x*/, unsigned addr,
 	byte src, byte color, LogOp op)
 {
 	op(time, vram, addr, src, color, 0);
@@ -649,7 +656,8 @@ struct IncrShift7
 // Logical operations:
 
 struct DummyOp {
-	void operator()(EmuTime::param /*time*/, VDPVRAM& /*vram*/, unsigned /*addr*/,
+	template<typename VRAM>
+	void operator()(EmuTime::param /*time*/, VRAM& /*vram*/, unsigned /*addr*/,
 	                byte /*src*/, byte /*color*/, byte /*mask*/) const
 	{
 		// Undefined logical operations do nothing.
@@ -657,7 +665,8 @@ struct DummyOp {
 };
 
 struct ImpOp {
-	void operator()(EmuTime::param time, VDPVRAM& vram, unsigned addr,
+	template<typename VRAM>
+	void operator()(EmuTime::param time, VRAM& vram, unsigned addr,
 	                byte src, byte color, byte mask) const
 	{
 		vram.cmdWrite(addr, (src & mask) | color, time);
@@ -665,7 +674,8 @@ struct ImpOp {
 };
 
 struct AndOp {
-	void operator()(EmuTime::param time, VDPVRAM& vram, unsigned addr,
+	template<typename VRAM>
+	void operator()(EmuTime::param time, VRAM& vram, unsigned addr,
 	                byte src, byte color, byte mask) const
 	{
 		vram.cmdWrite(addr, src & (color | mask), time);
@@ -673,7 +683,8 @@ struct AndOp {
 };
 
 struct OrOp {
-	void operator()(EmuTime::param time, VDPVRAM& vram, unsigned addr,
+	template<typename VRAM>
+	void operator()(EmuTime::param time, VRAM& vram, unsigned addr,
 	                byte src, byte color, byte /*mask*/) const
 	{
 		vram.cmdWrite(addr, src | color, time);
@@ -681,7 +692,8 @@ struct OrOp {
 };
 
 struct XorOp {
-	void operator()(EmuTime::param time, VDPVRAM& vram, unsigned addr,
+	template<typename VRAM>
+	void operator()(EmuTime::param time, VRAM& vram, unsigned addr,
 	                byte src, byte color, byte /*mask*/) const
 	{
 		vram.cmdWrite(addr, src ^ color, time);
@@ -689,7 +701,8 @@ struct XorOp {
 };
 
 struct NotOp {
-	void operator()(EmuTime::param time, VDPVRAM& vram, unsigned addr,
+	template<typename VRAM>
+	void operator()(EmuTime::param time, VRAM& vram, unsigned addr,
 	                byte src, byte color, byte mask) const
 	{
 		vram.cmdWrite(addr, (src & mask) | ~(color | mask), time);
@@ -698,7 +711,8 @@ struct NotOp {
 
 template<typename Op>
 struct TransparentOp : Op {
-	void operator()(EmuTime::param time, VDPVRAM& vram, unsigned addr,
+	template<typename VRAM>
+	void operator()(EmuTime::param time, VRAM& vram, unsigned addr,
 	                byte src, byte color, byte mask) const
 	{
 		// TODO does this skip the write or re-write the original value
@@ -714,6 +728,61 @@ using TXorOp = TransparentOp<XorOp>;
 using TNotOp = TransparentOp<NotOp>;
 
 
+// Fast path for the block commands:
+// As long as the written VRAM isn't observed by a subsystem that needs to be
+// synchronized before each write (see VDPVRAM::cmdCanWriteFast()), the exact
+// moment of each write doesn't matter. Then the access slot calculation still
+// happens per byte (that's cheap), but the writes go directly to VRAM.
+// To keep the end-of-line logic in one place, the last byte of each line is
+// always handled by the normal code.
+
+// Can be passed instead of VDPVRAM to the logical operations.
+struct FastVRAM {
+	VDPVRAM& vram;
+	void cmdWrite(unsigned address, byte value, EmuTime::param /*time*/) {
+		vram.cmdWriteFast(address, value);
+	}
+};
+
+// The address range of the bytes on line 'y' between x-coordinates 'x0' and
+// 'x1' (inclusive, in any order). In planar modes the bytes alternate between
+// both 64kB halves, then this range is repeated in both halves.
+template<typename Mode>
+static std::pair<unsigned, unsigned> lineRange(unsigned x0, unsigned x1, unsigned y)
+{
+	unsigned a0 = Mode::addressOf(x0, y, false);
+	unsigned a1 = Mode::addressOf(x1, y, false);
+	if constexpr (Mode::PLANAR) {
+		a0 &= 0xFFFF;
+		a1 &= 0xFFFF;
+	}
+	return {std::min(a0, a1), std::max(a0, a1)};
+}
+
+template<typename Mode>
+static bool canWriteFast(const VDPVRAM& vram, unsigned x0, unsigned x1, unsigned y)
+{
+	auto [first, last] = lineRange<Mode>(x0, x1, y);
+	if constexpr (Mode::PLANAR) {
+		return vram.cmdCanWriteFast(first, last) &&
+		       vram.cmdCanWriteFast(first | 0x10000, last | 0x10000);
+	} else {
+		return vram.cmdCanWriteFast(first, last);
+	}
+}
+
+template<typename Mode>
+static void writeFastDone(VDPVRAM& vram, unsigned x0, unsigned x1, unsigned y,
+                          EmuTime::param time)
+{
+	auto [first, last] = lineRange<Mode>(x0, x1, y);
+	vram.cmdWriteFastDone(first, last, time);
+	if constexpr (Mode::PLANAR) {
+		vram.cmdWriteFastDone(first | 0x10000, last | 0x10000, time);
+	}
+}
+
+
 // Commands
 
 void VDPCmdEngine::setStatusChangeTime(EmuTime::param t)
@@ -847,7 +916,7 @@ void VDPCmdEngine::executeSrch(EmuTime::param limit)
 		}
 		calculator.next(DELTA_88); // TODO
 	}
-	engineTime = calculator.getTime();
+	setEngineTime(calculator);
 }
 
 /** Draw a line.
@@ -934,7 +1003,7 @@ loop:		if (unlikely(calculator.limitReached())) { phase = 0; break; }
 	default:
 		UNREACHABLE;
 	}
-	engineTime = calculator.getTime();
+	setEngineTime(calculator);
 }
 
 
@@ -968,11 +1037,39 @@ void VDPCmdEngine::executeLmmv(EmuTime::param limit)
 	bool dstExt = (ARG & MXD) != 0;
 	bool doPset = !dstExt || hasExtendedVRAM;
 	unsigned addr = Mode::addressOf(ADX, DY, dstExt);
+	bool tryFast = !dstExt;
 	auto calculator = getSlotCalculator(limit);
 
 	switch (phase) {
 	case 0:
 loop:		if (unlikely(calculator.limitReached())) { phase = 0; break; }
+		if (tryFast && (ANX > 1)) {
+			if (canWriteFast<Mode>(vram, ADX, ADX + (ANX - 2) * TX, DY)) {
+				FastVRAM fastVram{vram};
+				unsigned firstX = ADX;
+				bool interrupted = false;
+				do {
+					tmpDst = vram.cmdWriteWindow.readNP(addr);
+					calculator.next(DELTA_24);
+					if (unlikely(calculator.limitReached())) {
+						interrupted = true;
+						break;
+					}
+					Mode::pset(calculator.getTime(), fastVram, ADX, addr,
+					           tmpDst, CL, LogOp());
+					ADX += TX;
+					addr = Mode::addressOf(ADX, DY, false);
+					calculator.next(DELTA_72);
+				} while ((--ANX > 1) && !calculator.limitReached());
+				if (ADX != firstX) {
+					writeFastDone<Mode>(vram, firstX, ADX - TX, DY,
+					                    calculator.getTime());
+				}
+				if (interrupted) { phase = 1; break; }
+				goto loop;
+			}
+			tryFast = false; // try again on the next line
+		}
 		if (likely(doPset)) {
 			tmpDst = vram.cmdWriteWindow.readNP(addr);
 		}
@@ -990,6 +1087,7 @@ loop:		if (unlikely(calculator.limitReached())) { phase = 0; break; }
 			delta = DELTA_136; // 72 + 64;
 			DY += TY; --NY;
 			ADX = DX; ANX = tmpNX;
+			tryFast = !dstExt;
 			if (--tmpNY == 0) {
 				commandDone(calculator.getTime());
 				break;
@@ -1002,7 +1100,7 @@ loop:		if (unlikely(calculator.limitReached())) { phase = 0; break; }
 	default:
 		UNREACHABLE;
 	}
-	engineTime = calculator.getTime();
+	setEngineTime(calculator);
 	this->calcFinishTime(tmpNX, tmpNY, 72 + 24);
 
 	/*
@@ -1135,7 +1233,7 @@ loop:		if (unlikely(calculator.limitReached())) { phase = 0; break; }
 	default:
 		UNREACHABLE;
 	}
-	engineTime = calculator.getTime();
+	setEngineTime(calculator);
 	this->calcFinishTime(tmpNX, tmpNY, 64 + 32 + 24);
 
 	/*if (unlikely(srcExt) || unlikely(dstExt)) {
@@ -1345,9 +1443,24 @@ void VDPCmdEngine::executeHmmv(EmuTime::param limit)
 		ADX, ANX << Mode::PIXELS_PER_BYTE_SHIFT, ARG);
 	bool dstExt = (ARG & MXD) != 0;
 	bool doPset = !dstExt || hasExtendedVRAM;
+	bool tryFast = !dstExt;
 	auto calculator = getSlotCalculator(limit);
 
 	while (!calculator.limitReached()) {
+		if (tryFast && (ANX > 1)) {
+			if (canWriteFast<Mode>(vram, ADX, ADX + (ANX - 2) * TX, DY)) {
+				unsigned firstX = ADX;
+				do {
+					vram.cmdWriteFast(Mode::addressOf(ADX, DY, false), COL);
+					ADX += TX;
+					calculator.next(DELTA_48);
+				} while ((--ANX > 1) && !calculator.limitReached());
+				writeFastDone<Mode>(vram, firstX, ADX - TX, DY,
+				                    calculator.getTime());
+				continue;
+			}
+			tryFast = false; // try again on the next line
+		}
 		if (likely(doPset)) {
 			vram.cmdWrite(Mode::addressOf(ADX, DY, dstExt),
 			              COL, calculator.getTime());
@@ -1358,6 +1471,7 @@ void VDPCmdEngine::executeHmmv(EmuTime::param limit)
 			delta = DELTA_104; // 48 + 56;
 			DY += TY; --NY;
 			ADX = DX; ANX = tmpNX;
+			tryFast = !dstExt;
 			if (--tmpNY == 0) {
 				commandDone(calculator.getTime());
 				break;
@@ -1365,7 +1479,7 @@ void VDPCmdEngine::executeHmmv(EmuTime::param limit)
 		}
 		calculator.next(delta);
 	}
-	engineTime = calculator.getTime();
+	setEngineTime(calculator);
 	calcFinishTime(tmpNX, tmpNY, 48);
 
 	/*if (unlikely(dstExt)) {
@@ -1453,11 +1567,42 @@ void VDPCmdEngine::executeHmmm(EmuTime::param limit)
 	bool dstExt  = (ARG & MXD) != 0;
 	bool doPoint = !srcExt || hasExtendedVRAM;
 	bool doPset  = !dstExt || hasExtendedVRAM;
+	bool tryFast = !dstExt;
 	auto calculator = getSlotCalculator(limit);
 
 	switch (phase) {
 	case 0:
 loop:		if (unlikely(calculator.limitReached())) { phase = 0; break; }
+		if (tryFast && (ANX > 1)) {
+			if (canWriteFast<Mode>(vram, ADX, ADX + (ANX - 2) * TX, DY)) {
+				// Bytes are still copied one by one (not with
+				// memmove()), this gives the same result for
+				// overlapping source and destination.
+				unsigned firstX = ADX;
+				bool interrupted = false;
+				do {
+					tmpSrc = likely(doPoint)
+						? vram.cmdReadWindow.readNP(
+						       Mode::addressOf(ASX, SY, srcExt))
+						: 0xFF;
+					calculator.next(DELTA_24);
+					if (unlikely(calculator.limitReached())) {
+						interrupted = true;
+						break;
+					}
+					vram.cmdWriteFast(Mode::addressOf(ADX, DY, false), tmpSrc);
+					ASX += TX; ADX += TX;
+					calculator.next(DELTA_64);
+				} while ((--ANX > 1) && !calculator.limitReached());
+				if (ADX != firstX) {
+					writeFastDone<Mode>(vram, firstX, ADX - TX, DY,
+					                    calculator.getTime());
+				}
+				if (interrupted) { phase = 1; break; }
+				goto loop;
+			}
+			tryFast = false; // try again on the next line
+		}
 		tmpSrc = likely(doPoint)
 			? vram.cmdReadWindow.readNP(
 			       Mode::addressOf(ASX, SY, srcExt))
@@ -1476,6 +1621,7 @@ loop:		if (unlikely(calculator.limitReached())) { phase = 0; break; }
 			delta = DELTA_128; // 64 + 64
 			SY += TY; DY += TY; --NY;
 			ASX = SX; ADX = DX; ANX = tmpNX;
+			tryFast = !dstExt;
 			if (--tmpNY == 0) {
 				commandDone(calculator.getTime());
 				break;
@@ -1487,7 +1633,7 @@ loop:		if (unlikely(calculator.limitReached())) { phase = 0; break; }
 	default:
 		UNREACHABLE;
 	}
-	engineTime = calculator.getTime();
+	setEngineTime(calculator);
 	calcFinishTime(tmpNX, tmpNY, 24 + 64);
 
 	/*if (unlikely(srcExt || dstExt)) {
@@ -1619,7 +1765,7 @@ loop:		if (unlikely(calculator.limitReached())) { phase = 0; break; }
 	default:
 		UNREACHABLE;
 	}
-	engineTime = calculator.getTime();
+	setEngineTime(calculator);
 	calcFinishTime(tmpNX, tmpNY, 24 + 40);
 
 	/*
@@ -1736,6 +1882,7 @@ void VDPCmdEngine::executeHmmc(EmuTime::param limit)
 
 VDPCmdEngine::VDPCmdEngine(VDP& vdp_, CommandController& commandController)
 	: vdp(vdp_), vram(vdp.getVRAM())
+	, timingStats(vdp.getMotherBoard().getCPU().getTimingStats())
 	, cmdTraceSetting(
 		commandController, vdp_.getName() == "VDP" ? "vdpcmdtrace" :
 		vdp_.getName() + " vdpcmdtrace", "VDP command tracing on/off",
@@ -1752,6 +1899,7 @@ VDPCmdEngine::VDPCmdEngine(VDP& vdp_, CommandController& commandController)
 		"Is the V99x8 VDP is currently executing a command",
 		false)
 	, engineTime(EmuTime::zero())
+	, cmdStartTime(EmuTime::zero())
 	, statusChangeTime(EmuTime::infinity())
 	, hasExtendedVRAM(vram.getSize() == (192 * 1024))
 {
@@ -1922,6 +2070,7 @@ void VDPCmdEngine::executeCommand(EmuTime::param time)
 	// Start command.
 	status |= 0x01;
 	executingProbe = true;
+	cmdStartTime = time;
 
 	switch ((scrMode << 4) | (CMD >> 4)) {
 	case 0x00: case 0x10: case 0x20: case 0x30: case 0x40:
@@ -2572,6 +2721,9 @@ void VDPCmdEngine::reportVdpCommand() const
 
 void VDPCmdEngine::commandDone(EmuTime::param time)
 {
+	if ((status & 0x01) && (time >= cmdStartTime)) {
+		timingStats.cmdDuration.add(TimingStats::toCycles(time - cmdStartTime));
+	}
 	// Note: TR is not reset yet; it is reset when S#2 is read next.
 	status &= 0xFE; // reset CE
 	executingProbe = false;
@@ -6,6 +6,7 @@
 #include "BooleanSetting.hh"
 #include "Probe.hh"
 #include "TclCallback.hh"
+#include "TimingStats.hh"
 #include "serialize_meta.hh"
 #include "openmsx.hh"
 
@@ -160,11 +161,17 @@ private:
 	// the current one.
 	inline void nextAccessSlot(VDPAccessSlots::Delta delta) {
 		engineTime = vdp.getAccessSlot(engineTime, delta);
+		++timingStats.cmdSlots;
 	}
 	inline VDPAccessSlots::Calculator getSlotCalculator(
 			EmuTime::param limit) const {
 		return vdp.getAccessSlotCalculator(engineTime, limit);
 	}
+	// Continue at the time of the given calculator.
+	inline void setEngineTime(const VDPAccessSlots::Calculator& calculator) {
+		engineTime = calculator.getTime();
+		timingStats.cmdSlots += calculator.getNumSlots();
+	}
 
 	/** Finshed executing graphical operation.
 	  */
@@ -179,6 +186,7 @@ private:
 	  */
 	VDP& vdp;
 	VDPVRAM& vram;
+	TimingStats& timingStats;
 
 	/** Only call reportVdpCommand() when this setting is turned on
 	  */
@@ -192,6 +200,9 @@ private:
 	  */
 	EmuTime engineTime;
 
+	/** Start time of the current command, see TimingStats::cmdDuration. */
+	EmuTime cmdStartTime;
+
 	/** Lower bound for the time when the status register will change, IOW
 	  * the status register will not change before this time.
 	  * Can also be EmuTime::zero -> status can change any moment
@@ -4,6 +4,7 @@
 #include "Math.hh"
 #include "outer.hh"
 #include "serialize.hh"
+#include "xrange.hh"
 #include <algorithm>
 #include <cstring>
 
@@ -23,6 +24,28 @@ VRAMWindow::VRAMWindow(Ram& vram)
 	// sizeMask will be initialized shortly by the VDPVRAM class
 }
 
+void VRAMWindow::trackBlocks(uint8_t* blocks_, uint8_t bit)
+{
+	blocks = blocks_;
+	blockBit = bit;
+	updateBlockMasks();
+}
+
+void VRAMWindow::updateBlockMasks()
+{
+	if (!blocks) return;
+	bool active = isEnabled() && hasObserver();
+	for (auto block : xrange(VDPVRAM::NUM_BLOCKS)) {
+		unsigned first = block * VDPVRAM::BLOCK_SIZE;
+		unsigned last  = first + VDPVRAM::BLOCK_SIZE - 1;
+		if (active && mayOverlap(first, last)) {
+			blocks[block] |= blockBit;
+		} else {
+			blocks[block] &= ~blockBit;
+		}
+	}
+}
+
 
 // class LogicalVRAMDebuggable
 
@@ -67,6 +90,15 @@ void VDPVRAM::LogicalVRAMDebuggable::write(
 	vram.cpuWrite(transform(address), value, time);
 }
 
+void VDPVRAM::LogicalVRAMDebuggable::readBlock(unsigned start, span<byte> output)
+{
+	auto& vram = OUTER(VDPVRAM, logicalVRAMDebug);
+	vram.debugSync(getMotherBoard().getCurrentTime());
+	for (auto i : xrange(output.size())) {
+		output[i] = vram.data[transform(start + unsigned(i)) & vram.sizeMask];
+	}
+}
+
 
 // class PhysicalVRAMDebuggable
 
@@ -92,6 +124,15 @@ void VDPVRAM::PhysicalVRAMDebuggable::write(
 	vram.cpuWrite(address, value, time);
 }
 
+void VDPVRAM::PhysicalVRAMDebuggable::readBlock(unsigned start, span<byte> output)
+{
+	auto& vram = OUTER(VDPVRAM, physicalVRAMDebug);
+	vram.debugSync(getMotherBoard().getCurrentTime());
+	for (auto i : xrange(output.size())) {
+		output[i] = vram.data[(start + unsigned(i)) & vram.sizeMask];
+	}
+}
+
 
 // class VDPVRAM
 
@@ -126,6 +167,14 @@ VDPVRAM::VDPVRAM(VDP& vdp_, unsigned size, EmuTime::param time)
 {
 	(void)time;
 
+	bitmapVisibleWindow.trackBlocks(windowBlocks, BITMAP_VISIBLE);
+	spriteAttribTable  .trackBlocks(windowBlocks, SPRITE_ATTRIB);
+	spritePatternTable .trackBlocks(windowBlocks, SPRITE_PATTERN);
+	bitmapCacheWindow  .trackBlocks(windowBlocks, BITMAP_CACHE);
+	nameTable          .trackBlocks(windowBlocks, NAME);
+	colorTable         .trackBlocks(windowBlocks, COLOR);
+	patternTable       .trackBlocks(windowBlocks, PATTERN);
+
 	vrMode = vdp.getVRMode();
 	setSizeMask(time);
 
@@ -236,7 +285,7 @@ void VDPVRAM::setRenderer(Renderer* newRenderer, EmuTime::param time)
 	bitmapVisibleWindow.setObserver(renderer);
 }
 
-void VDPVRAM::change4k8kMapping(bool mapping8k)
+void VDPVRAM::change4k8kMapping(bool mapping8k, EmuTime::param time)
 {
 	/* Sources:
 	 *  - http://www.msx.org/forumtopicl8624.html
@@ -280,6 +329,10 @@ void VDPVRAM::change4k8kMapping(bool mapping8k)
 	 * even in 4K mode, all 16K of VRAM can be accessed. The only
 	 * difference is in what addresses are used to store data.
 	 */
+	// SpriteChecker must be synced before the content moves.
+	spriteAttribTable.notifyAll(time);
+	spritePatternTable.notifyAll(time);
+
 	byte tmp[0x4000];
 	if (mapping8k) {
 		// from 8k/16k to 4k mapping
@@ -303,6 +356,13 @@ void VDPVRAM::change4k8kMapping(bool mapping8k)
 		}
 	}
 	memcpy(&data[0], tmp, sizeof(tmp));
+
+	// content moved without going through writeCommon()
+	spriteAttribTable.notifyAll(time);
+	bitmapCacheWindow.notifyAll(time);
+	nameTable.notifyAll(time);
+	colorTable.notifyAll(time);
+	patternTable.notifyAll(time);
 }
 
 
@@ -315,6 +375,7 @@ void VRAMWindow::serialize(Archive& ar, unsigned /*version*/)
 	if constexpr (Archive::IS_LOADER) {
 		effectiveBaseMask = origBaseMask & sizeMask;
 		combiMask = ~effectiveBaseMask | indexMask;
+		updateBlockMasks();
 		// TODO ?  observer->updateWindow(isEnabled(), time);
 	}
 }
@@ -9,6 +9,7 @@
 #include "Math.hh"
 #include "openmsx.hh"
 #include "likely.hh"
+#include <algorithm>
 #include <cassert>
 
 namespace openmsx {
@@ -174,6 +175,7 @@ public:
 		indexMask         = newIndexMask;
 		baseAddr  =  effectiveBaseMask & indexMask; // this enables window
 		combiMask = ~effectiveBaseMask | indexMask;
+		updateBlockMasks();
 	}
 
 	/** Disable this window: no address will be considered inside.
@@ -182,6 +184,7 @@ public:
 	inline void disable(EmuTime::param time) {
 		observer->updateWindow(false, time);
 		baseAddr = -1;
+		updateBlockMasks();
 	}
 
 	/** Is the given index range continuous in VRAM (iow there's no mirroring)
@@ -279,12 +282,14 @@ public:
 	  */
 	inline void setObserver(VRAMObserver* newObserver) {
 		observer = newObserver;
+		updateBlockMasks();
 	}
 
 	/** Unregister the observer of this VRAM window.
 	  */
 	inline void resetObserver() {
 		observer = &dummyObserver;
+		updateBlockMasks();
 	}
 
 	/** Test whether an address is inside this window.
@@ -298,6 +303,19 @@ public:
 		return (address & combiMask) == unsigned(baseAddr);
 	}
 
+	/** Test whether any address in the range [first, last] might be
+	  * inside this window. This is a conservative test: it can return
+	  * true even though none of the addresses is inside, but never the
+	  * other way around.
+	  */
+	[[nodiscard]] inline bool mayOverlap(unsigned first, unsigned last) const {
+		// Only compare the bits that are the same for all addresses
+		// in the range.
+		unsigned fixedBits = ~Math::floodRight(first ^ last);
+		return (first & combiMask & fixedBits) ==
+		       (unsigned(baseAddr) & fixedBits);
+	}
+
 	/** Notifies the observer of this window of a VRAM change,
 	  * if the changes address is inside this window.
 	  * @param address The address to test.
@@ -309,6 +327,16 @@ public:
 		}
 	}
 
+	/** Notifies the observer that (possibly) the whole content of this
+	  * window changed, while the window itself stays the same.
+	  * @param time The moment in emulated time the change occurs.
+	  */
+	inline void notifyAll(EmuTime::param time) {
+		if (isEnabled()) {
+			observer->updateWindow(true, time);
+		}
+	}
+
 	/** Inform VRAMWindow of changed sizeMask.
 	  * For the moment this only happens when switching the VR bit in VDP
 	  * register 8 (in VR=0 mode only 32kB VRAM is addressable).
@@ -328,6 +356,12 @@ private:
 		return baseAddr != -1;
 	}
 
+	/** Let this window maintain 'blockBit' in the given table, see
+	  * VDPVRAM::windowBlocks.
+	  */
+	void trackBlocks(uint8_t* blocks, uint8_t bit);
+	void updateBlockMasks();
+
 private:
 	/** Only VDPVRAM may construct VRAMWindow objects.
 	  */
@@ -376,6 +410,13 @@ private:
 	  */
 	int sizeMask;
 
+	/** Per 1kB VRAM block: bit 'blockBit' is set when this window has an
+	  * observer and the block (possibly) overlaps with this window.
+	  * nullptr for windows that don't need this.
+	  */
+	uint8_t* blocks = nullptr;
+	uint8_t blockBit = 0;
+
 	static inline DummyVRAMOBserver dummyObserver;
 };
 
@@ -430,6 +471,46 @@ public:
 		writeCommon(address, value, time);
 	}
 
+	/** Can the command engine use cmdWriteFast() for all addresses in
+	  * the range [first, last]? That's the case when none of the
+	  * subsystems that must be synchronized before a write (renderer,
+	  * sprite checker) observes these addresses, and when no mirroring or
+	  * non-present RAM is involved.
+	  */
+	[[nodiscard]] inline bool cmdCanWriteFast(unsigned first, unsigned last) const {
+		assert(first <= last);
+		return (last <= sizeMask) && (last < actualSize) &&
+		       !bitmapVisibleWindow.mayOverlap(first, last) &&
+		       !spriteAttribTable  .mayOverlap(first, last) &&
+		       !spritePatternTable .mayOverlap(first, last);
+	}
+
+	/** Write a byte from the command engine, without any synchronization.
+	  * Only allowed for addresses for which cmdCanWriteFast() returned
+	  * true. After a series of these writes, cmdWriteFastDone() must be
+	  * called.
+	  */
+	inline void cmdWriteFast(unsigned address, byte value) {
+		assert(address < actualSize);
+		data[address] = value;
+	}
+
+	/** Notify the cache windows about the cmdWriteFast() calls in the
+	  * range [first, last]. These don't depend on the exact moment of the
+	  * writes. They also don't need a notification per address: the
+	  * smallest granularity of a VRAM table is 64 bytes (the color table
+	  * in Graphic1 mode), so one address per 64-byte block is enough.
+	  */
+	void cmdWriteFastDone(unsigned first, unsigned last, EmuTime::param time) {
+		for (unsigned block = first & ~63u; block <= last; block += 64) {
+			unsigned address = std::max(block, first);
+			bitmapCacheWindow.notify(address, time);
+			nameTable.notify(address, time);
+			colorTable.notify(address, time);
+			patternTable.notify(address, time);
+		}
+	}
+
 	/** Write a byte to VRAM through the CPU interface.
 	  * @param address The address to write.
 	  * @param value The value to write.
@@ -543,7 +624,7 @@ public:
 	/** TMS99x8 VRAM can be mapped in two ways.
 	  * See implementation for more details.
 	  */
-	void change4k8kMapping(bool mapping8k);
+	void change4k8kMapping(bool mapping8k, EmuTime::param time);
 
 	template<typename Archive>
 	void serialize(Archive& ar, unsigned version);
@@ -563,26 +644,31 @@ private:
 		// even if it is the same as the previous frame.
 		if (data[address] == value) return;
 
+		// Most writes are to blocks that no (observed) window overlaps,
+		// for those a single lookup is enough.
+		assert(address < NUM_BLOCKS * BLOCK_SIZE);
+		unsigned windows = windowBlocks[address / BLOCK_SIZE];
+
 		// Subsystem synchronisation should happen before the commit,
 		// to be able to draw backlog using old state.
-		bitmapVisibleWindow.notify(address, time);
-		spriteAttribTable.notify(address, time);
-		spritePatternTable.notify(address, time);
+		if (windows & SYNC_WINDOWS) {
+			if (windows & BITMAP_VISIBLE) bitmapVisibleWindow.notify(address, time);
+			if (windows & SPRITE_ATTRIB)  spriteAttribTable  .notify(address, time);
+			if (windows & SPRITE_PATTERN) spritePatternTable .notify(address, time);
+		}
 
 		data[address] = value;
 
 		// Cache dirty marking should happen after the commit,
 		// otherwise the cache could be re-validated based on old state.
 
-		// these two seem to be unused
-		// bitmapCacheWindow.notify(address, time);
-		// nameTable.notify(address, time);
-		assert(!bitmapCacheWindow.hasObserver());
-		assert(!nameTable.hasObserver());
-
-		// in the past GLRasterizer observed these two, now there are none
-		assert(!colorTable.hasObserver());
-		assert(!patternTable.hasObserver());
+		// SDLRasterizer keeps a cache of converted display lines
+		if (windows & CACHE_WINDOWS) {
+			if (windows & BITMAP_CACHE) bitmapCacheWindow.notify(address, time);
+			if (windows & NAME)         nameTable        .notify(address, time);
+			if (windows & COLOR)        colorTable       .notify(address, time);
+			if (windows & PATTERN)      patternTable     .notify(address, time);
+		}
 
 		/* TODO:
 		There seems to be a significant difference between subsystem sync
@@ -600,6 +686,13 @@ private:
 	void setSizeMask(EmuTime::param time);
 
 private:
+	/** Bring the VRAM content up-to-date for the debugger (block reads).
+	  * Unlike cpuRead() this doesn't take VDP access slots.
+	  */
+	void debugSync(EmuTime::param time) {
+		if (cmdEngine) cmdEngine->sync(time);
+	}
+
 	/** VDP this VRAM belongs to.
 	  */
 	VDP& vdp;
@@ -618,6 +711,7 @@ private:
 		explicit LogicalVRAMDebuggable(VDP& vdp);
 		[[nodiscard]] byte read(unsigned address, EmuTime::param time) override;
 		void write(unsigned address, byte value, EmuTime::param time) override;
+		void readBlock(unsigned start, span<byte> output) override;
 	private:
 		unsigned transform(unsigned address);
 	} logicalVRAMDebug;
@@ -630,6 +724,7 @@ private:
 		PhysicalVRAMDebuggable(VDP& vdp, unsigned actualSize);
 		[[nodiscard]] byte read(unsigned address, EmuTime::param time) override;
 		void write(unsigned address, byte value, EmuTime::param time) override;
+		void readBlock(unsigned start, span<byte> output) override;
 	} physicalVRAMDebug;
 
 	// TODO: Renderer field can be removed, if updateDisplayMode
@@ -663,6 +758,26 @@ private:
 	  */
 	bool vrMode;
 
+	/** For each 1kB block of VRAM, which of the windows below need to
+	  * be notified on a write (one bit per window, see writeCommon()).
+	  * Maintained by the windows themselves.
+	  */
+	static constexpr unsigned BLOCK_SIZE = 1024;
+	static constexpr unsigned NUM_BLOCKS = 256; // 'sizeMask' is at most 18 bits
+	enum : uint8_t {
+		BITMAP_VISIBLE = 1 << 0,
+		SPRITE_ATTRIB  = 1 << 1,
+		SPRITE_PATTERN = 1 << 2,
+		BITMAP_CACHE   = 1 << 3,
+		NAME           = 1 << 4,
+		COLOR          = 1 << 5,
+		PATTERN        = 1 << 6,
+		SYNC_WINDOWS  = BITMAP_VISIBLE | SPRITE_ATTRIB | SPRITE_PATTERN,
+		CACHE_WINDOWS = BITMAP_CACHE | NAME | COLOR | PATTERN,
+	};
+	uint8_t windowBlocks[NUM_BLOCKS] = {};
+	friend class VRAMWindow;
+
 public:
 	VRAMWindow cmdReadWindow;
 	VRAMWindow cmdWriteWindow;
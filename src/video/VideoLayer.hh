@@ -5,8 +5,11 @@
 #include "Layer.hh"
 #include "Observer.hh"
 #include "MSXEventListener.hh"
+#include <cstdint>
 #include <string>
 
+namespace openmsx::PNG { struct SaveOptions; }
+
 namespace openmsx {
 
 class MSXMotherBoard;
@@ -32,7 +35,13 @@ public:
 	 * parameter should be either '240' or '480'. The current image will be
 	 * scaled to '320x240' or '640x480' and written to a png file. */
 	virtual void takeRawScreenShot(
-		unsigned height, const std::string& filename) = 0;
+		unsigned height, const std::string& filename,
+		const PNG::SaveOptions& options) = 0;
+
+	/** Hash of the raw screen, scaled the same way as for
+	 * takeRawScreenShot(). The pixels are first converted to 8-bit RGB,
+	 * so the hash doesn't depend on the (host) pixel format. */
+	[[nodiscard]] virtual uint32_t getRawFrameHash(unsigned height) = 0;
 
 	// We used to test whether a Layer is active by looking at the
 	// Z-coordinate (Z_MSX_ACTIVE vs Z_MSX_PASSIVE). Though in case of
@@ -46,6 +55,8 @@ public:
 	[[nodiscard]] bool needRender() const;
 	[[nodiscard]] bool needRecord() const;
 
+	[[nodiscard]] MSXMotherBoard& getMotherBoard() const { return motherBoard; }
+
 protected:
 	VideoLayer(MSXMotherBoard& motherBoard,
 	           const std::string& videoSource);
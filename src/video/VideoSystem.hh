@@ -7,6 +7,8 @@
 #include <memory>
 #include "components.hh"
 
+namespace openmsx::PNG { struct SaveOptions; }
+
 namespace openmsx {
 
 class Rasterizer;
@@ -66,9 +68,11 @@ public:
 	  * The default implementation throws an exception.
 	  * @param filename Name of the file to save the screenshot to.
 	  * @param withOsd Should OSD elements be included in the screenshot.
+	  * @param options Compression and asynchronous saving, see PNG::save().
 	  * @throws MSXException If taking the screen shot fails.
 	  */
-	virtual void takeScreenShot(const std::string& filename, bool withOsd);
+	virtual void takeScreenShot(const std::string& filename, bool withOsd,
+	                            const PNG::SaveOptions& options);
 
 	/** Called when the window title string has changed.
 	  */
@@ -7,6 +7,7 @@
 #include "endian.hh"
 #include "ranges.hh"
 #include "unreachable.hh"
+#include <algorithm>
 #include <array>
 #include <cassert>
 #include <cstdint>
@@ -14,6 +15,9 @@
 #include <cstring>
 #include <cmath>
 #include <tuple>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 
 namespace openmsx {
 
@@ -25,11 +29,6 @@ constexpr unsigned BLOCK_WIDTH  = MAX_VECTOR;
 constexpr unsigned BLOCK_HEIGHT = MAX_VECTOR;
 constexpr unsigned FLAG_KEYFRAME = 0x01;
 
-struct CodecVector {
-	int8_t x;
-	int8_t y;
-};
-
 constexpr unsigned VECTOR_TAB_SIZE =
 	1 +                                       // center
 	8 * MAX_VECTOR +                          // horizontal, vertical, diagonal
@@ -184,6 +183,8 @@ void ZMBVEncoder::setupBuffers(unsigned bpp)
 	unsigned xBlocks = width / BLOCK_WIDTH;
 	unsigned yBlocks = height / BLOCK_HEIGHT;
 	blockOffsets.resize(xBlocks * yBlocks);
+	prevVectors.resize(xBlocks * yBlocks);
+	std::fill_n(prevVectors.data(), xBlocks * yBlocks, CodecVector{0, 0});
 	for (auto y : xrange(yBlocks)) {
 		for (auto x : xrange(xBlocks)) {
 			blockOffsets[y * xBlocks + x] =
@@ -219,9 +220,33 @@ unsigned ZMBVEncoder::possibleBlock(int vx, int vy, unsigned offset)
 template<typename P>
 unsigned ZMBVEncoder::compareBlock(int vx, int vy, unsigned offset)
 {
-	int ret = 0;
 	auto* pOld = &(reinterpret_cast<P*>(oldframe.data()))[offset + (vy * pitch) + vx];
 	auto* pNew = &(reinterpret_cast<P*>(newframe.data()))[offset];
+#ifdef __SSE2__
+	// Count the equal pixels, 16 bytes at a time: each compare gives -1
+	// for an equal pixel.
+	__m128i equal = _mm_setzero_si128();
+	repeat(BLOCK_HEIGHT, [&] {
+		for (unsigned x = 0; x < BLOCK_WIDTH; x += 16 / sizeof(P)) {
+			auto o = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pOld + x));
+			auto n = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pNew + x));
+			if constexpr (sizeof(P) == 4) {
+				equal = _mm_sub_epi32(equal, _mm_cmpeq_epi32(o, n));
+			} else {
+				equal = _mm_sub_epi16(equal, _mm_cmpeq_epi16(o, n));
+			}
+		}
+		pOld += pitch;
+		pNew += pitch;
+	});
+	if constexpr (sizeof(P) == 2) {
+		equal = _mm_madd_epi16(equal, _mm_set1_epi16(1)); // to 32-bit
+	}
+	equal = _mm_add_epi32(equal, _mm_shuffle_epi32(equal, 0x4E));
+	equal = _mm_add_epi32(equal, _mm_shuffle_epi32(equal, 0xB1));
+	return BLOCK_WIDTH * BLOCK_HEIGHT - unsigned(_mm_cvtsi128_si32(equal));
+#else
+	int ret = 0;
 	repeat(BLOCK_HEIGHT, [&] {
 		for (auto x : xrange(BLOCK_WIDTH)) {
 			if (pOld[x] != pNew[x]) ++ret;
@@ -230,6 +255,7 @@ unsigned ZMBVEncoder::compareBlock(int vx, int vy, unsigned offset)
 		pNew += pitch;
 	});
 	return ret;
+#endif
 }
 
 template<typename P>
@@ -270,6 +296,19 @@ void ZMBVEncoder::addXorFrame(const PixelFormat& pixelFormat, unsigned& workUsed
 		unsigned offset = blockOffsets[b];
 		// first try best vector of previous block
 		unsigned bestchange = compareBlock<P>(bestVx, bestVy, offset);
+		// then the vector of this block in the previous frame
+		if (bestchange >= 4) {
+			int prevVx = prevVectors[b].x;
+			int prevVy = prevVectors[b].y;
+			if ((prevVx != bestVx) || (prevVy != bestVy)) {
+				unsigned change = compareBlock<P>(prevVx, prevVy, offset);
+				if (change < bestchange) {
+					bestchange = change;
+					bestVx = prevVx;
+					bestVy = prevVy;
+				}
+			}
+		}
 		if (bestchange >= 4) {
 			int possibles = 64;
 			for (const auto& v : vectorTable) {
@@ -286,6 +325,7 @@ void ZMBVEncoder::addXorFrame(const PixelFormat& pixelFormat, unsigned& workUsed
 				}
 			}
 		}
+		prevVectors[b] = {int8_t(bestVx), int8_t(bestVy)};
 		vectors[b * 2 + 0] = (bestVx << 1);
 		vectors[b * 2 + 1] = (bestVy << 1);
 		if (bestchange) {
@@ -300,6 +340,9 @@ void ZMBVEncoder::addFullFrame(const PixelFormat& pixelFormat, unsigned& workUse
 {
 	using LE_P = typename Endian::Little<P>::type;
 
+	unsigned blockcount = (width / BLOCK_WIDTH) * (height / BLOCK_HEIGHT);
+	std::fill_n(prevVectors.data(), blockcount, CodecVector{0, 0});
+
 	PixelOperations<P> pixelOps(pixelFormat);
 	auto* readFrame =
 		&newframe[pixelSize * (MAX_VECTOR + MAX_VECTOR * pitch)];
@@ -314,7 +357,7 @@ void ZMBVEncoder::addFullFrame(const PixelFormat& pixelFormat, unsigned& workUse
 	});
 }
 
-const void* ZMBVEncoder::getScaledLine(FrameSource* frame, unsigned y, void* workBuf_) const
+const void* ZMBVEncoder::getScaledLine(const FrameSource* frame, unsigned y, void* workBuf_) const
 {
 #if HAVE_32BPP
 	if (pixelSize == 4) { // 32bpp
@@ -350,7 +393,18 @@ const void* ZMBVEncoder::getScaledLine(FrameSource* frame, unsigned y, void* wor
 	return nullptr; // avoid warning
 }
 
-span<const uint8_t> ZMBVEncoder::compressFrame(bool keyFrame, FrameSource* frame)
+void ZMBVEncoder::copyFrame(const FrameSource* frame, uint8_t* dest) const
+{
+	unsigned lineWidth = width * pixelSize;
+	for (auto i : xrange(height)) {
+		const auto* scaled = getScaledLine(frame, i, dest);
+		if (scaled != dest) memcpy(dest, scaled, lineWidth);
+		dest += lineWidth;
+	}
+}
+
+span<const uint8_t> ZMBVEncoder::compressFrame(
+	bool keyFrame, const uint8_t* frameData, const PixelFormat& pixelFormat)
 {
 	std::swap(newframe, oldframe); // replace oldframe with newframe
 
@@ -379,11 +433,11 @@ span<const uint8_t> ZMBVEncoder::compressFrame(bool keyFrame, FrameSource* frame
 	unsigned lineWidth = width * pixelSize;
 	uint8_t* dest =
 		&newframe[pixelSize * (MAX_VECTOR + MAX_VECTOR * pitch)];
-	for (auto i : xrange(height)) {
-		const auto* scaled = getScaledLine(frame, i, dest);
-		if (scaled != dest) memcpy(dest, scaled, lineWidth);
+	repeat(height, [&] {
+		memcpy(dest, frameData, lineWidth);
+		frameData += lineWidth;
 		dest += linePitch;
-	}
+	});
 
 	// Add the frame data.
 	if (keyFrame) {
@@ -391,12 +445,12 @@ span<const uint8_t> ZMBVEncoder::compressFrame(bool keyFrame, FrameSource* frame
 		switch (pixelSize) {
 #if HAVE_16BPP
 		case 2:
-			addFullFrame<uint16_t>(frame->getPixelFormat(), workUsed);
+			addFullFrame<uint16_t>(pixelFormat, workUsed);
 			break;
 #endif
 #if HAVE_32BPP
 		case 4:
-			addFullFrame<uint32_t>(frame->getPixelFormat(), workUsed);
+			addFullFrame<uint32_t>(pixelFormat, workUsed);
 			break;
 #endif
 		default:
@@ -407,12 +461,12 @@ span<const uint8_t> ZMBVEncoder::compressFrame(bool keyFrame, FrameSource* frame
 		switch (pixelSize) {
 #if HAVE_16BPP
 		case 2:
-			addXorFrame<uint16_t>(frame->getPixelFormat(), workUsed);
+			addXorFrame<uint16_t>(pixelFormat, workUsed);
 			break;
 #endif
 #if HAVE_32BPP
 		case 4:
-			addXorFrame<uint32_t>(frame->getPixelFormat(), workUsed);
+			addXorFrame<uint32_t>(pixelFormat, workUsed);
 			break;
 #endif
 		default:
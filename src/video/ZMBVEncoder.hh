@@ -15,6 +15,11 @@ namespace openmsx {
 class FrameSource;
 template<typename P> class PixelOperations;
 
+struct CodecVector {
+	int8_t x;
+	int8_t y;
+};
+
 class ZMBVEncoder
 {
 public:
@@ -22,7 +27,18 @@ public:
 
 	ZMBVEncoder(unsigned width, unsigned height, unsigned bpp);
 
-	[[nodiscard]] span<const uint8_t> compressFrame(bool keyFrame, FrameSource* frame);
+	/** Size in bytes of the frame data passed to compressFrame(). */
+	[[nodiscard]] unsigned getFrameSize() const { return width * height * pixelSize; }
+
+	/** Copy (and scale to the recording size) the lines of the given frame
+	  * to 'dest' (getFrameSize() bytes). This doesn't modify the encoder
+	  * state, so it may run in parallel with compressFrame().
+	  */
+	void copyFrame(const FrameSource* frame, uint8_t* dest) const;
+
+	/** Compress one frame, previously copied with copyFrame(). */
+	[[nodiscard]] span<const uint8_t> compressFrame(
+		bool keyFrame, const uint8_t* frameData, const PixelFormat& pixelFormat);
 
 private:
 	enum Format {
@@ -39,7 +55,7 @@ private:
 	template<typename P> void addXorBlock(
 		const PixelOperations<P>& pixelOps, int vx, int vy,
 		unsigned offset, unsigned& workUsed);
-	[[nodiscard]] const void* getScaledLine(FrameSource* frame, unsigned y, void* workBuf) const;
+	[[nodiscard]] const void* getScaledLine(const FrameSource* frame, unsigned y, void* workBuf) const;
 
 private:
 	MemBuffer<uint8_t, SSE_ALIGNMENT> oldframe;
@@ -47,6 +63,7 @@ private:
 	MemBuffer<uint8_t, SSE_ALIGNMENT> work;
 	MemBuffer<uint8_t> output;
 	MemBuffer<unsigned> blockOffsets;
+	MemBuffer<CodecVector> prevVectors; // per block, of the previous frame
 	unsigned outputSize;
 
 	z_stream zstream;
@@ -15,7 +15,7 @@ LDSDLRasterizer<Pixel>::LDSDLRasterizer(
 		OutputSurface& screen,
 		std::unique_ptr<PostProcessor> postProcessor_)
 	: postProcessor(std::move(postProcessor_))
-	, workFrame(std::make_unique<RawFrame>(screen.getPixelFormat(), 640, 480))
+	, workFrame(std::make_shared<RawFrame>(screen.getPixelFormat(), 640, 480))
 {
 }
 
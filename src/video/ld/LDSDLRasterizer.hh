@@ -36,7 +36,7 @@ private:
 
 	/** The next frame as it is delivered by the VDP, work in progress.
 	  */
-	std::unique_ptr<RawFrame> workFrame;
+	std::shared_ptr<RawFrame> workFrame;
 };
 
 } // namespace openmsx
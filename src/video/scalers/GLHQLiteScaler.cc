@@ -96,7 +96,7 @@ void GLHQLiteScaler::scaleImage(
 using Pixel = uint32_t;
 void GLHQLiteScaler::uploadBlock(
 	unsigned srcStartY, unsigned srcEndY, unsigned lineWidth,
-	FrameSource& paintFrame)
+	const FrameSource& paintFrame)
 {
 	if ((lineWidth != 320) || (srcEndY > 240)) return;
 
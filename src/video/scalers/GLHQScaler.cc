@@ -108,7 +108,7 @@ void GLHQScaler::scaleImage(
 using Pixel = uint32_t;
 void GLHQScaler::uploadBlock(
 	unsigned srcStartY, unsigned srcEndY, unsigned lineWidth,
-	FrameSource& paintFrame)
+	const FrameSource& paintFrame)
 {
 	if ((lineWidth != 320) || (srcEndY > 240)) return;
 
@@ -18,7 +18,7 @@ public:
 		unsigned logSrcHeight) override;
 	void uploadBlock(
 		unsigned srcStartY, unsigned srcEndY,
-		unsigned lineWidth, FrameSource& paintFrame) override;
+		unsigned lineWidth, const FrameSource& paintFrame) override;
 
 private:
 	GLScaler& fallback;
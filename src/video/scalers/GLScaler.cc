@@ -32,7 +32,7 @@ GLScaler::GLScaler(const std::string& progName)
 
 void GLScaler::uploadBlock(
 	unsigned /*srcStartY*/, unsigned /*srcEndY*/,
-	unsigned /*lineWidth*/, FrameSource& /*paintFrame*/)
+	unsigned /*lineWidth*/, const FrameSource& /*paintFrame*/)
 {
 }
 
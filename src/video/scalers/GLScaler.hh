@@ -40,7 +40,7 @@ public:
 
 	virtual void uploadBlock(
 		unsigned srcStartY, unsigned srcEndY,
-		unsigned lineWidth, FrameSource& paintFrame);
+		unsigned lineWidth, const FrameSource& paintFrame);
 
 protected:
 	explicit GLScaler(const std::string& progName);
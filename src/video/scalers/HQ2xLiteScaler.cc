@@ -39,8 +39,11 @@ void HQLite_1x1on2x2<Pixel>::operator()(
 	const Pixel* __restrict in2,
 	Pixel* __restrict out0, Pixel* __restrict out1,
 	unsigned srcWidth, unsigned* __restrict edgeBuf,
-	EdgeHQLite /*edgeOp*/) __restrict
+	EdgeHQLite edgeOp) __restrict
 {
+	VLA(uint16_t, newEdges, srcWidth);
+	calcNewEdges(in1, in2, srcWidth, newEdges, edgeOp);
+
 	unsigned c2 = readPixel(in0[0]);
 	unsigned c5 = readPixel(in1[0]); unsigned c6 = c5;
 	unsigned c8 = readPixel(in2[0]); unsigned c9 = c8;
@@ -67,10 +70,7 @@ void HQLite_1x1on2x2<Pixel>::operator()(
 		//if (c5 != c1) pattern |= 1 <<  3; //     l: c2-c6 9,  t: c4-c8 0
 		//if (c4 != c2) pattern |= 1 <<  4; //     l: c5-c3 10, t: c5-c7 1
 		// non-overlapping pixels
-		if (c5 != c8) pattern |= 1 <<  5; // B
-		if (c5 != c9) pattern |= 1 <<  6; // BR
-		if (c6 != c8) pattern |= 1 <<  7; // BR
-		if (c5 != c6) pattern |= 1 <<  8; // R
+		pattern |= newEdges[x]; // B, BR, BR, R: bits 5-8
 		// overlaps with top
 		//if (c2 != c6) pattern |= 1 <<  9; // R - t: c5-c9 6
 		//if (c5 != c3) pattern |= 1 << 10; // R - t: c6-c8 7
@@ -96,8 +96,11 @@ void HQLite_1x1on1x2<Pixel>::operator()(
 	const Pixel* __restrict in2,
 	Pixel* __restrict out0, Pixel* __restrict out1,
 	unsigned srcWidth, unsigned* __restrict edgeBuf,
-	EdgeHQLite /*edgeOp*/) __restrict
+	EdgeHQLite edgeOp) __restrict
 {
+	VLA(uint16_t, newEdges, srcWidth);
+	calcNewEdges(in1, in2, srcWidth, newEdges, edgeOp);
+
 	//  +---+---+---+
 	//  | 1 | 2 | 3 |
 	//  +---+---+---+
@@ -131,10 +134,7 @@ void HQLite_1x1on1x2<Pixel>::operator()(
 		//if (c5 != c1) pattern |= 1 <<  3; //     l: c2-c6 9,  t: c4-c8 0
 		//if (c4 != c2) pattern |= 1 <<  4; //     l: c5-c3 10, t: c5-c7 1
 		// non-overlapping pixels
-		if (c5 != c8) pattern |= 1 <<  5; // B
-		if (c5 != c9) pattern |= 1 <<  6; // BR
-		if (c6 != c8) pattern |= 1 <<  7; // BR
-		if (c5 != c6) pattern |= 1 <<  8; // R
+		pattern |= newEdges[x]; // B, BR, BR, R: bits 5-8
 		// overlaps with top
 		//if (c2 != c6) pattern |= 1 <<  9; // R - t: c5-c9 6
 		//if (c5 != c3) pattern |= 1 << 10; // R - t: c6-c8 7
@@ -35,6 +35,9 @@ void HQ_1x1on3x3<Pixel>::operator()(
 	unsigned srcWidth, unsigned* __restrict edgeBuf,
 	EdgeHQ edgeOp) __restrict
 {
+	VLA(uint16_t, newEdges, srcWidth);
+	calcNewEdges(in1, in2, srcWidth, newEdges, edgeOp);
+
 	unsigned c2 = readPixel(in0[0]); unsigned c3 = c2;
 	unsigned c5 = readPixel(in1[0]); unsigned c6 = c5;
 	unsigned c8 = readPixel(in2[0]); unsigned c9 = c8;
@@ -65,10 +68,7 @@ void HQ_1x1on3x3<Pixel>::operator()(
 		//if (edgeOp(c5, c1)) pattern |= 1 <<  3; //     l: c2-c6 9,  t: c4-c8 0
 		//if (edgeOp(c4, c2)) pattern |= 1 <<  4; //     l: c5-c3 10, t: c5-c7 1
 		// non-overlapping pixels
-		if (edgeOp(c5, c8)) pattern |= 1 <<  5; // B
-		if (edgeOp(c5, c9)) pattern |= 1 <<  6; // BR
-		if (edgeOp(c6, c8)) pattern |= 1 <<  7; // BR
-		if (edgeOp(c5, c6)) pattern |= 1 <<  8; // R
+		pattern |= newEdges[x]; // B, BR, BR, R: bits 5-8
 		// overlaps with top
 		//if (edgeOp(c2, c6)) pattern |= 1 <<  9; // R - t: c5-c9 6
 		//if (edgeOp(c5, c3)) pattern |= 1 << 10; // R - t: c6-c8 7
@@ -12,6 +12,13 @@
 #include <algorithm>
 #include <cassert>
 #include <cstdint>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+#if defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#define HQ_EDGES_NEON 1
+#endif
 
 namespace openmsx {
 
@@ -76,6 +83,11 @@ public:
 
 		return false;
 	}
+
+	[[nodiscard]] unsigned getShiftR() const { return shiftR; }
+	[[nodiscard]] unsigned getShiftG() const { return shiftG; }
+	[[nodiscard]] unsigned getShiftB() const { return shiftB; }
+
 private:
 	const unsigned shiftR;
 	const unsigned shiftG;
@@ -102,6 +114,194 @@ struct EdgeHQLite
 	}
 };
 
+// Vectorized versions of EdgeHQ and EdgeHQLite, these compare 4 pairs of
+// pixels at once and return all ones for an edge, all zeros otherwise.
+#ifdef __SSE2__
+class EdgeHQ_SSE2
+{
+public:
+	explicit EdgeHQ_SSE2(const EdgeHQ& edgeOp)
+		: shiftR(_mm_cvtsi32_si128(edgeOp.getShiftR()))
+		, shiftG(_mm_cvtsi32_si128(edgeOp.getShiftG()))
+		, shiftB(_mm_cvtsi32_si128(edgeOp.getShiftB()))
+	{
+	}
+
+	[[nodiscard]] inline __m128i operator()(__m128i c1, __m128i c2) const
+	{
+		auto channel = [](__m128i c, __m128i shift) {
+			return _mm_and_si128(_mm_srl_epi32(c, shift), _mm_set1_epi32(0xFF));
+		};
+		auto outside = [](__m128i d, int limit) {
+			return _mm_or_si128(_mm_cmpgt_epi32(d, _mm_set1_epi32( limit)),
+			                    _mm_cmplt_epi32(d, _mm_set1_epi32(-limit)));
+		};
+		__m128i dr = _mm_sub_epi32(channel(c1, shiftR), channel(c2, shiftR));
+		__m128i dg = _mm_sub_epi32(channel(c1, shiftG), channel(c2, shiftG));
+		__m128i db = _mm_sub_epi32(channel(c1, shiftB), channel(c2, shiftB));
+		__m128i dy = _mm_add_epi32(_mm_add_epi32(dr, dg), db);
+		__m128i du = _mm_sub_epi32(dr, db);
+		__m128i dv = _mm_sub_epi32(_mm_add_epi32(_mm_add_epi32(dg, dg), dg), dy);
+		return _mm_or_si128(_mm_or_si128(outside(dy, 0xC0), outside(du, 0x1C)),
+		                    outside(dv, 0x30));
+	}
+
+private:
+	const __m128i shiftR;
+	const __m128i shiftG;
+	const __m128i shiftB;
+};
+
+struct EdgeHQLite_SSE2
+{
+	explicit EdgeHQLite_SSE2(EdgeHQLite /*edgeOp*/) {}
+
+	[[nodiscard]] inline __m128i operator()(__m128i c1, __m128i c2) const
+	{
+		return _mm_xor_si128(_mm_cmpeq_epi32(c1, c2), _mm_set1_epi32(-1));
+	}
+};
+
+[[nodiscard]] inline EdgeHQ_SSE2     simdEdgeOp(const EdgeHQ& e)     { return EdgeHQ_SSE2(e); }
+[[nodiscard]] inline EdgeHQLite_SSE2 simdEdgeOp(const EdgeHQLite& e) { return EdgeHQLite_SSE2(e); }
+
+#elif defined(HQ_EDGES_NEON)
+class EdgeHQ_NEON
+{
+public:
+	explicit EdgeHQ_NEON(const EdgeHQ& edgeOp)
+		: shiftR(vdupq_n_s32(-int(edgeOp.getShiftR()))) // negative: shift right
+		, shiftG(vdupq_n_s32(-int(edgeOp.getShiftG())))
+		, shiftB(vdupq_n_s32(-int(edgeOp.getShiftB())))
+	{
+	}
+
+	[[nodiscard]] inline uint32x4_t operator()(uint32x4_t c1, uint32x4_t c2) const
+	{
+		auto channel = [](uint32x4_t c, int32x4_t shift) {
+			return vreinterpretq_s32_u32(
+				vandq_u32(vshlq_u32(c, shift), vdupq_n_u32(0xFF)));
+		};
+		auto outside = [](int32x4_t d, int limit) {
+			return vcgtq_s32(vabsq_s32(d), vdupq_n_s32(limit));
+		};
+		int32x4_t dr = vsubq_s32(channel(c1, shiftR), channel(c2, shiftR));
+		int32x4_t dg = vsubq_s32(channel(c1, shiftG), channel(c2, shiftG));
+		int32x4_t db = vsubq_s32(channel(c1, shiftB), channel(c2, shiftB));
+		int32x4_t dy = vaddq_s32(vaddq_s32(dr, dg), db);
+		int32x4_t du = vsubq_s32(dr, db);
+		int32x4_t dv = vsubq_s32(vmulq_n_s32(dg, 3), dy);
+		return vorrq_u32(vorrq_u32(outside(dy, 0xC0), outside(du, 0x1C)),
+		                 outside(dv, 0x30));
+	}
+
+private:
+	const int32x4_t shiftR;
+	const int32x4_t shiftG;
+	const int32x4_t shiftB;
+};
+
+struct EdgeHQLite_NEON
+{
+	explicit EdgeHQLite_NEON(EdgeHQLite /*edgeOp*/) {}
+
+	[[nodiscard]] inline uint32x4_t operator()(uint32x4_t c1, uint32x4_t c2) const
+	{
+		return vmvnq_u32(vceqq_u32(c1, c2));
+	}
+};
+
+[[nodiscard]] inline EdgeHQ_NEON     simdEdgeOp(const EdgeHQ& e)     { return EdgeHQ_NEON(e); }
+[[nodiscard]] inline EdgeHQLite_NEON simdEdgeOp(const EdgeHQLite& e) { return EdgeHQLite_NEON(e); }
+#endif
+
+// Of the 12 edges around a pixel (see HQ_1x1on2x2 and friends) only the 4
+// edges from the central pixel '5' to the pixels right and below it must be
+// newly calculated, the others are shared with the pixels to the left and
+// above. This calculates these edges for a full line upfront, in the bits
+// where the HQ scalers use them:
+//   bit 5: 5-8, bit 6: 5-9, bit 7: 6-8, bit 8: 5-6
+// For the rightmost pixel '6' and '9' are the same as '5' and '8'.
+// For 32bpp pixels this is done for 4 pixels at once (with SSE2 or NEON).
+// Those are always present on x86_64 and aarch64, so unlike e.g. the AVX2
+// code in ResampleHQ there's nothing to select at run time.
+template<typename Pixel, typename EdgeOp>
+void calcNewEdgesScalar(const Pixel* __restrict curr, const Pixel* __restrict next,
+                        unsigned x, unsigned width, uint16_t* __restrict edges,
+                        EdgeOp edgeOp)
+{
+	for (/**/; x < width; ++x) {
+		unsigned x1 = std::min(x + 1, width - 1);
+		uint32_t c5 = readPixel(curr[x]);
+		uint32_t c6 = readPixel(curr[x1]);
+		uint32_t c8 = readPixel(next[x]);
+		uint32_t c9 = readPixel(next[x1]);
+		unsigned pattern = 0;
+		if (edgeOp(c5, c8)) pattern |= 1 << 5;
+		if (edgeOp(c5, c9)) pattern |= 1 << 6;
+		if (edgeOp(c6, c8)) pattern |= 1 << 7;
+		if (edgeOp(c5, c6)) pattern |= 1 << 8;
+		edges[x] = pattern;
+	}
+}
+
+template<typename Pixel, typename EdgeOp>
+void calcNewEdges(const Pixel* __restrict curr, const Pixel* __restrict next,
+                  unsigned width, uint16_t* __restrict edges, EdgeOp edgeOp)
+{
+	unsigned x = 0;
+#if defined(__SSE2__)
+	if constexpr (sizeof(Pixel) == 4) {
+		auto simdOp = simdEdgeOp(edgeOp);
+		const __m128i mask = _mm_set1_epi32(0xF8F8F8F8); // see readPixel()
+		auto load = [&](const Pixel* p) {
+			return _mm_and_si128(_mm_loadu_si128(
+				reinterpret_cast<const __m128i*>(p)), mask);
+		};
+		auto calc4 = [&](unsigned i) {
+			__m128i c5 = load(curr + i);
+			__m128i c6 = load(curr + i + 1);
+			__m128i c8 = load(next + i);
+			__m128i c9 = load(next + i + 1);
+			__m128i e = _mm_and_si128(simdOp(c5, c8), _mm_set1_epi32(1 << 5));
+			e = _mm_or_si128(e, _mm_and_si128(simdOp(c5, c9), _mm_set1_epi32(1 << 6)));
+			e = _mm_or_si128(e, _mm_and_si128(simdOp(c6, c8), _mm_set1_epi32(1 << 7)));
+			e = _mm_or_si128(e, _mm_and_si128(simdOp(c5, c6), _mm_set1_epi32(1 << 8)));
+			return e;
+		};
+		// the loads of '6' and '9' read one pixel beyond the current group
+		for (/**/; (x + 8) < width; x += 8) {
+			__m128i e = _mm_packs_epi32(calc4(x), calc4(x + 4));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(edges + x), e);
+		}
+	}
+#elif defined(HQ_EDGES_NEON)
+	if constexpr (sizeof(Pixel) == 4) {
+		auto simdOp = simdEdgeOp(edgeOp);
+		const uint32x4_t mask = vdupq_n_u32(0xF8F8F8F8); // see readPixel()
+		auto load = [&](const Pixel* p) {
+			return vandq_u32(vld1q_u32(reinterpret_cast<const uint32_t*>(p)), mask);
+		};
+		auto bit = [](uint32x4_t e, unsigned n) {
+			return vandq_u32(e, vdupq_n_u32(1 << n));
+		};
+		// the loads of '6' and '9' read one pixel beyond the current group
+		for (/**/; (x + 4) < width; x += 4) {
+			uint32x4_t c5 = load(curr + x);
+			uint32x4_t c6 = load(curr + x + 1);
+			uint32x4_t c8 = load(next + x);
+			uint32x4_t c9 = load(next + x + 1);
+			uint32x4_t e = vorrq_u32(vorrq_u32(bit(simdOp(c5, c8), 5),
+			                                   bit(simdOp(c5, c9), 6)),
+			                         vorrq_u32(bit(simdOp(c6, c8), 7),
+			                                   bit(simdOp(c5, c6), 8)));
+			vst1_u16(edges + x, vmovn_u32(e));
+		}
+	}
+#endif
+	calcNewEdgesScalar(curr, next, x, width, edges, edgeOp);
+}
+
 template<typename EdgeOp>
 void calcEdgesGL(const uint32_t* __restrict curr, const uint32_t* __restrict next,
                  Endian::L32* __restrict edges2, EdgeOp edgeOp)
@@ -2,6 +2,7 @@
 #include "FrameSource.hh"
 #include "ScalerOutput.hh"
 #include "MemBuffer.hh"
+#include "WorkerPool.hh"
 #include "aligned.hh"
 #include "vla.hh"
 #include "build-info.hh"
@@ -9,9 +10,43 @@
 #include <vector>
 #include <cassert>
 #include <cstdint>
+#include <thread>
 
 namespace openmsx {
 
+// Each step of the algorithm is split in bands (of lines or of columns) that
+// are processed in parallel. Within a step the bands are independent, but a
+// step can only start when the previous one is completely done.
+static constexpr unsigned MAX_BANDS = 4;
+static constexpr unsigned MIN_BAND_SIZE = 16;
+
+[[nodiscard]] static WorkerPool& getWorkers()
+{
+	static WorkerPool workers(MAX_BANDS - 1);
+	return workers;
+}
+
+// Call 'f(begin, end)' for bands that together cover [0, n).
+template<typename T, typename F>
+static void inBands(T n, F f)
+{
+	static const unsigned maxBands = std::clamp(
+		std::thread::hardware_concurrency(), 1u, MAX_BANDS);
+	auto numBands = T(std::clamp(unsigned(n) / MIN_BAND_SIZE, 1u, maxBands));
+	if (numBands == 1) {
+		f(T(0), n);
+		return;
+	}
+	T bandSize = (n + numBands - 1) / numBands;
+	auto& workers = getWorkers();
+	for (T begin = bandSize; begin < n; begin += bandSize) {
+		T end = std::min(begin + bandSize, n);
+		workers.post([&f, begin, end] { f(begin, end); });
+	}
+	f(T(0), std::min(bandSize, n));
+	workers.wait();
+}
+
 template<typename Pixel>
 MLAAScaler<Pixel>::MLAAScaler(
 		unsigned dstWidth_, const PixelOperations<Pixel>& pixelOps_)
@@ -57,27 +92,27 @@ void MLAAScaler<Pixel>::scaleImage(
 
 	enum { UP = 1 << 0, RIGHT = 1 << 1, DOWN = 1 << 2, LEFT = 1 << 3 };
 	MemBuffer<uint8_t> edges(srcNumLines * srcWidth);
-	uint8_t* edgeGenPtr = edges.data();
-	for (auto y : xrange(srcNumLines)) {
-		auto* srcLinePtr = srcLinePtrs[y];
+	inBands(srcNumLines, [&](int yBegin, int yEnd) {
+	for (auto y : xrange(yBegin, yEnd)) {
+		// Written without branches (and a separate pass for the
+		// horizontal neighbours), so that the compiler can vectorize
+		// these loops.
+		uint8_t* edgeGenPtr = &edges[y * srcWidth];
+		const Pixel* srcLinePtr = srcLinePtrs[y];
+		const Pixel* upLinePtr  = srcLinePtrs[y - 1];
+		const Pixel* downLinePtr = srcLinePtrs[y + 1];
 		for (auto x : xrange(srcWidth)) {
 			Pixel colMid = srcLinePtr[x];
-			uint8_t pixEdges = 0;
-			if (x > 0 && srcLinePtr[x - 1] != colMid) {
-				pixEdges |= LEFT;
-			}
-			if (x < srcWidth - 1 && srcLinePtr[x + 1] != colMid) {
-				pixEdges |= RIGHT;
-			}
-			if (srcLinePtrs[y - 1][x] != colMid) {
-				pixEdges |= UP;
-			}
-			if (srcLinePtrs[y + 1][x] != colMid) {
-				pixEdges |= DOWN;
-			}
-			*edgeGenPtr++ = pixEdges;
+			edgeGenPtr[x] = ((upLinePtr  [x] != colMid) ? UP   : 0)
+			              | ((downLinePtr[x] != colMid) ? DOWN : 0);
+		}
+		for (auto x : xrange(1u, srcWidth)) {
+			bool differ = srcLinePtr[x - 1] != srcLinePtr[x];
+			edgeGenPtr[x    ] |= differ ? LEFT  : 0;
+			edgeGenPtr[x - 1] |= differ ? RIGHT : 0;
 		}
 	}
+	});
 
 	enum {
 		// Is this pixel part of an edge?
@@ -105,9 +140,10 @@ void MLAAScaler<Pixel>::scaleImage(
 
 	// Find horizontal edges.
 	MemBuffer<unsigned> horizontals(srcNumLines * srcWidth);
-	unsigned* horizontalGenPtr = horizontals.data();
-	const uint8_t* edgePtr = edges.data();
-	for (auto y : xrange(srcNumLines)) {
+	inBands(srcNumLines, [&](int yBegin, int yEnd) {
+	unsigned* horizontalGenPtr = &horizontals[yBegin * srcWidth];
+	const uint8_t* edgePtr = &edges[yBegin * srcWidth];
+	for (auto y : xrange(yBegin, yEnd)) {
 		unsigned x = 0;
 		while (x < srcWidth) {
 			// Check which corners are part of a slope.
@@ -184,13 +220,15 @@ void MLAAScaler<Pixel>::scaleImage(
 		assert(x == srcWidth);
 		edgePtr += srcWidth;
 	}
-	assert(unsigned(edgePtr - edges.data()) == srcNumLines * srcWidth);
-	assert(unsigned(horizontalGenPtr - horizontals.data()) == srcNumLines * srcWidth);
+	assert(unsigned(edgePtr - edges.data()) == yEnd * srcWidth);
+	assert(unsigned(horizontalGenPtr - horizontals.data()) == yEnd * srcWidth);
+	});
 
 	// Find vertical edges.
 	MemBuffer<unsigned> verticals(srcNumLines * srcWidth);
-	edgePtr = edges.data();
-	for (auto x : xrange(srcWidth)) {
+	inBands(srcWidth, [&](unsigned xBegin, unsigned xEnd) {
+	const uint8_t* edgePtr = &edges[xBegin];
+	for (auto x : xrange(xBegin, xEnd)) {
 		unsigned* verticalGenPtr = &verticals[x];
 		int y = 0;
 		while (y < srcNumLines) {
@@ -275,16 +313,18 @@ void MLAAScaler<Pixel>::scaleImage(
 		assert(unsigned(verticalGenPtr - verticals.data()) == x + srcNumLines * srcWidth);
 		edgePtr++;
 	}
-	assert(unsigned(edgePtr - edges.data()) == srcWidth);
+	assert(unsigned(edgePtr - edges.data()) == xEnd);
+	});
 
 	VLA(Pixel*, dstLines, dst.getHeight());
 	for (auto i : xrange(dstStartY, dstEndY)) {
 		dstLines[i] = dst.acquireLine(i);
 	}
 
+	inBands(srcNumLines, [&](int yBegin, int yEnd) {
 	// Do a mosaic scale so every destination pixel has a color.
-	unsigned dstY = dstStartY;
-	for (auto y : xrange(srcNumLines)) {
+	unsigned dstY = dstStartY + yBegin * zoomFactorY;
+	for (auto y : xrange(yBegin, yEnd)) {
 		auto* srcLinePtr = srcLinePtrs[y];
 		for (auto x : xrange(srcWidth)) {
 			Pixel col = srcLinePtr[x];
@@ -298,9 +338,9 @@ void MLAAScaler<Pixel>::scaleImage(
 	}
 
 	// Render the horizontal edges.
-	const unsigned* horizontalPtr = horizontals.data();
-	dstY = dstStartY;
-	for (auto y : xrange(srcNumLines)) {
+	const unsigned* horizontalPtr = &horizontals[yBegin * srcWidth];
+	dstY = dstStartY + yBegin * zoomFactorY;
+	for (auto y : xrange(yBegin, yEnd)) {
 		unsigned x = 0;
 		while (x < srcWidth) {
 			// Fetch information about the edge, if any, at the current pixel.
@@ -456,10 +496,12 @@ void MLAAScaler<Pixel>::scaleImage(
 		assert(x == srcWidth);
 		dstY += zoomFactorY;
 	}
-	assert(unsigned(horizontalPtr - horizontals.data()) == srcNumLines * srcWidth);
+	assert(unsigned(horizontalPtr - horizontals.data()) == yEnd * srcWidth);
+	});
 
 	// Render the vertical edges.
-	for (auto x : xrange(srcWidth)) {
+	inBands(srcWidth, [&](unsigned xBegin, unsigned xEnd) {
+	for (auto x : xrange(xBegin, xEnd)) {
 		const unsigned* verticalPtr = &verticals[x];
 		int y = 0;
 		while (y < srcNumLines) {
@@ -613,9 +655,11 @@ void MLAAScaler<Pixel>::scaleImage(
 		}
 		assert(y == srcNumLines);
 	}
+	});
 
 	// TODO: This is compensation for the fact that we do not support
 	//       non-integer zoom factors yet.
+	const unsigned dstY = dstStartY + srcNumLines * zoomFactorY;
 	if (srcWidth * zoomFactorX != dstWidth) {
 		for (auto dy : xrange(dstStartY, dstY)) {
 			unsigned sy = std::min(
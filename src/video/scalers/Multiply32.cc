@@ -1,7 +1,6 @@
 #include "Multiply32.hh"
 #include "PixelOperations.hh"
-#include "enumerate.hh"
-#include <cstring>
+#include "xrange.hh"
 
 namespace openmsx {
 
@@ -50,15 +49,19 @@ Multiply32<uint16_t>::Multiply32(const PixelOperations<uint16_t>& pixelOps)
 	Bshift3 = (Bshift1 + 20) & 31;
 
 	factor = 0;
-	memset(tab, 0, sizeof(tab));
 }
 
 void Multiply32<uint16_t>::setFactor32(unsigned f)
 {
-	if (factor == f) return;
+	if ((factor == f) && !tab.empty()) return;
 	factor = f;
 
-	for (auto [p, t] : enumerate(tab)) {
+	// Only allocate the table (256kB) when it's actually used, scalers
+	// have several of these objects but (depending on the settings) not
+	// all of them get used.
+	if (tab.empty()) tab.resize(0x10000);
+	for (auto p : xrange(0x10000u)) {
+		auto& t = tab[p];
 		uint32_t r = rotLeft((p & Rmask1), Rshift1) |
 			     rotLeft((p & Rmask2), Rshift2);
 		uint32_t g = rotLeft((p & Gmask1), Gshift1) |
@@ -1,6 +1,7 @@
 #ifndef MULTIPLY32_HH
 #define MULTIPLY32_HH
 
+#include "MemBuffer.hh"
 #include <cstdint>
 
 namespace openmsx {
@@ -64,7 +65,7 @@ public:
 	}
 
 private:
-	uint32_t tab[0x10000];
+	MemBuffer<uint32_t> tab; // allocated on the first setFactor32() call
 	unsigned factor;
 	unsigned Rshift1, Gshift1, Bshift1;
 	unsigned Rshift2, Gshift2, Bshift2;
@@ -4,6 +4,7 @@
 #include "unreachable.hh"
 #include "build-info.hh"
 #include "components.hh"
+#include <algorithm>
 #include <cassert>
 #include <cstdint>
 
@@ -490,6 +491,41 @@ void V9990BitmapConverter<Pixel>::convertLine(
 	}
 }
 
+template<typename Pixel>
+bool V9990BitmapConverter<Pixel>::isCursorVisible(int cursorY, bool drawCursors)
+{
+	CursorInfo cursor0(vdp, vram, palette64_32768, 0x7fe00, 0x7ff00, cursorY, drawCursors);
+	CursorInfo cursor1(vdp, vram, palette64_32768, 0x7fe08, 0x7ff80, cursorY, drawCursors);
+	return cursor0.isVisible() || cursor1.isVisible();
+}
+
+template<typename Pixel>
+void V9990BitmapConverter<Pixel>::addLineBlocks(
+	unsigned x, unsigned y, int nrPixels, V9990VRAMBlocks& blocks) const
+{
+	unsigned bits = [&] {
+		switch (colorMode) {
+		case BD16: return 16;
+		case BP4:  return 4;
+		case BP2:  return 2;
+		default:   return 8; // also YJK and YUV modes
+		}
+	}();
+	// Conservative: the raster functions start at a multiple of 4 pixels
+	// and can draw (so read) a few pixels too many.
+	unsigned first = (((x & ~3) + y * vdp.getImageWidth()) * bits / 8) & 0x7FFFF;
+	unsigned num = ((nrPixels + 8) * bits) / 8;
+	// Even and odd addresses are stored in different halves of the VRAM,
+	// each half wraps separately.
+	unsigned start = first / 2;
+	unsigned half = num / 2 + 1;
+	unsigned part1 = std::min(half, 0x40000 - start);
+	for (unsigned base : {0x00000, 0x40000}) {
+		blocks.addRange(base + start, part1);
+		blocks.addRange(base, half - part1);
+	}
+}
+
 // Force template instantiation
 #if HAVE_16BPP
 template class V9990BitmapConverter<uint16_t>;
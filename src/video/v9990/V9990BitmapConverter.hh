@@ -9,6 +9,7 @@ namespace openmsx {
 
 class V9990;
 class V9990VRAM;
+class V9990VRAMBlocks;
 
 /** Utility class to convert VRAM content to host pixels.
   */
@@ -27,6 +28,17 @@ public:
 	void convertLine(Pixel* linePtr, unsigned x, unsigned y, int nrPixels,
 		         int cursorY, bool drawCursors);
 
+	/** Is one of the cursors visible on the given line? Only when not,
+	  * the result of convertLine() doesn't depend on the cursors.
+	  */
+	[[nodiscard]] bool isCursorVisible(int cursorY, bool drawCursors);
+
+	/** Add the VRAM blocks that convertLine() reads (for the bitmap, so
+	  * not for the cursors) to 'blocks'.
+	  */
+	void addLineBlocks(unsigned x, unsigned y, int nrPixels,
+	                   V9990VRAMBlocks& blocks) const;
+
 	/** Set a different rendering mode.
 	  */
 	void setColorMode(V9990ColorMode colorMode_, V9990DisplayMode display) {
@@ -12,8 +12,11 @@
 #include "likely.hh"
 #include "unreachable.hh"
 #include "xrange.hh"
+#include <algorithm>
 #include <cassert>
+#include <cstring>
 #include <iostream>
+#include <limits>
 
 namespace openmsx {
 
@@ -684,6 +687,113 @@ inline void V9990CmdEngine::V9990Bpp16::psetColor(
 	vram.writeVRAMDirect(addr + 0x40000, result >> 8);
 }
 
+// Runs of pixels ------------------------------------------------------
+//
+// The block commands spend most of their time in the common case of a plain
+// copy (logical operation IMP, no transparency, all bits enabled in the
+// write mask). In the 8bpp and 16bpp modes the pixels of (a part of) a line
+// are then stored in a contiguous range of (interleaved) VRAM, so they can
+// be handled with memset()/memmove() instead of pixel by pixel.
+
+[[nodiscard]] static inline bool isPlainCopy(word mask, byte op)
+{
+	return (mask == 0xFFFF) && ((op & 0x1F) == 0x0C);
+}
+
+// Get the range of VRAM addresses (in the CPU view of the Bx modes, so even
+// and odd addresses are in different halves of the VRAM) of the 'num' pixels
+// on line 'y' starting at (leftmost) pixel 'x'. Returns false when those
+// pixels are not contiguous (the run wraps around the line or the VRAM) or
+// when the mode is not supported.
+template<typename Mode>
+[[nodiscard]] static inline bool getLinearRun(
+	unsigned x, unsigned y, unsigned pitch, unsigned num,
+	unsigned& first, unsigned& size)
+{
+	x &= pitch - 1;
+	if ((x + num) > pitch) return false;
+	if constexpr (Mode::BITS_PER_PIXEL == 8) {
+		first = (x + y * pitch) & 0x7FFFF;
+		size = num;
+		return (first + size) <= 0x80000;
+	} else if constexpr (Mode::BITS_PER_PIXEL == 16) {
+		unsigned addr = (x + y * pitch) & 0x3FFFF;
+		first = 2 * addr; // low byte at even, high byte at odd address
+		size = 2 * num;
+		return (addr + num) <= 0x40000;
+	} else {
+		(void)y; (void)first; (void)size;
+		return false;
+	}
+}
+
+// The per-plane range of a range of (CPU view) Bx addresses.
+static constexpr unsigned PLANE1 = 0x40000;
+[[nodiscard]] static inline std::pair<unsigned, unsigned> evenRange(unsigned first, unsigned size)
+{
+	return {(first + 1) / 2, (first + size + 1) / 2};
+}
+[[nodiscard]] static inline std::pair<unsigned, unsigned> oddRange(unsigned first, unsigned size)
+{
+	return {first / 2, (first + size) / 2};
+}
+
+// Fill a range of Bx addresses: even addresses get the low byte of 'color',
+// odd addresses the high byte (this matches psetColor()).
+static void fillBx(V9990VRAM& vram, unsigned first, unsigned size, word color)
+{
+	auto [begin0, end0] = evenRange(first, size);
+	auto [begin1, end1] = oddRange (first, size);
+	if (begin0 != end0) {
+		memset(vram.getWriteBackdoorDirect(begin0, end0 - begin0),
+		       color & 0xFF, end0 - begin0);
+	}
+	if (begin1 != end1) {
+		memset(vram.getWriteBackdoorDirect(PLANE1 + begin1, end1 - begin1),
+		       color >> 8, end1 - begin1);
+	}
+}
+
+// Copy bytes in the same order as a pixel by pixel copy would (in 'forward'
+// or in backward direction). This only makes a difference when the regions
+// overlap in such a way that the copy reads bytes that it wrote before.
+static void copyBytes(byte* dst, const byte* src, unsigned num, bool forward)
+{
+	bool reread = forward ? ((src < dst) && (dst < (src + num)))
+	                      : ((dst < src) && (src < (dst + num)));
+	if (!reread) {
+		memmove(dst, src, num);
+	} else if (forward) {
+		for (auto i : xrange(num)) dst[i] = src[i];
+	} else {
+		for (unsigned i = num; i-- > 0; ) dst[i] = src[i];
+	}
+}
+
+// Copy a range of Bx addresses. Returns false when source and destination
+// have a different parity, then a plane of the destination gets data
+// from both planes of the source.
+[[nodiscard]] static bool copyBx(V9990VRAM& vram, unsigned dst, unsigned src,
+                                 unsigned size, bool forward)
+{
+	if ((dst ^ src) & 1) return false;
+	auto [dBegin0, dEnd0] = evenRange(dst, size);
+	auto [dBegin1, dEnd1] = oddRange (dst, size);
+	auto sBegin0 = evenRange(src, size).first;
+	auto sBegin1 = oddRange (src, size).first;
+	if (dBegin0 != dEnd0) {
+		copyBytes(vram.getWriteBackdoorDirect(dBegin0, dEnd0 - dBegin0),
+		          vram.getReadBackdoorDirect(sBegin0),
+		          dEnd0 - dBegin0, forward);
+	}
+	if (dBegin1 != dEnd1) {
+		copyBytes(vram.getWriteBackdoorDirect(PLANE1 + dBegin1, dEnd1 - dBegin1),
+		          vram.getReadBackdoorDirect(PLANE1 + sBegin1),
+		          dEnd1 - dBegin1, forward);
+	}
+	return true;
+}
+
 // ====================================================================
 /** Constructor
   */
@@ -1028,19 +1138,32 @@ void V9990CmdEngine::startLMMV(EmuTime::param time)
 template<typename Mode>
 void V9990CmdEngine::executeLMMV(EmuTime::param limit)
 {
-	// TODO can be optimized a lot
-
 	auto delta = getTiming(*this, LMMV_TIMING);
 	unsigned pitch = Mode::getPitch(vdp.getImageWidth());
 	int dx = (ARG & DIX) ? -1 : 1;
 	int dy = (ARG & DIY) ? -1 : 1;
 	const byte* lut = Mode::getLogOpLUT(LOG);
-	while (engineTime < limit) {
-		engineTime += delta;
-		Mode::psetColor(vram, DX, DY, pitch, fgCol, WM, lut, LOG);
+	bool plainCopy = isPlainCopy(WM, LOG);
+	unsigned steps = getStepsUntil(limit, delta);
+	while (steps) {
+		// handle (the remainder of) the current line in one go
+		unsigned num = std::min<unsigned>(steps, ANX);
+		unsigned first, size;
+		if (plainCopy &&
+		    getLinearRun<Mode>((dx > 0) ? DX : DX - (num - 1), DY, pitch, num, first, size)) {
+			fillBx(vram, first, size, fgCol);
+			DX += int(num) * dx;
+		} else {
+			repeat(num, [&] {
+				Mode::psetColor(vram, DX, DY, pitch, fgCol, WM, lut, LOG);
+				DX += dx;
+			});
+		}
+		engineTime += delta * num;
+		steps -= num;
 
-		DX += dx;
-		if (!--(ANX)) {
+		ANX -= num;
+		if (!ANX) {
 			DX -= (NX * dx);
 			DY += dy;
 			if (!--(ANY)) {
@@ -1120,22 +1243,37 @@ void V9990CmdEngine::startLMMM(EmuTime::param time)
 template<typename Mode>
 void V9990CmdEngine::executeLMMM(EmuTime::param limit)
 {
-	// TODO can be optimized a lot
-
 	auto delta = getTiming(*this, LMMM_TIMING);
 	unsigned pitch = Mode::getPitch(vdp.getImageWidth());
 	int dx = (ARG & DIX) ? -1 : 1;
 	int dy = (ARG & DIY) ? -1 : 1;
 	const byte* lut = Mode::getLogOpLUT(LOG);
-	while (engineTime < limit) {
-		engineTime += delta;
-		auto src = Mode::point(vram, SX, SY, pitch);
-		src = Mode::shift(src, SX, DX);
-		Mode::pset(vram, DX, DY, pitch, src, WM, lut, LOG);
+	bool plainCopy = isPlainCopy(WM, LOG);
+	unsigned steps = getStepsUntil(limit, delta);
+	while (steps) {
+		// handle (the remainder of) the current line in one go
+		unsigned num = std::min<unsigned>(steps, ANX);
+		unsigned dstFirst, srcFirst, size;
+		if (plainCopy &&
+		    getLinearRun<Mode>((dx > 0) ? DX : DX - (num - 1), DY, pitch, num, dstFirst, size) &&
+		    getLinearRun<Mode>((dx > 0) ? SX : SX - (num - 1), SY, pitch, num, srcFirst, size) &&
+		    copyBx(vram, dstFirst, srcFirst, size, dx > 0)) {
+			DX += int(num) * dx;
+			SX += int(num) * dx;
+		} else {
+			repeat(num, [&] {
+				auto src = Mode::point(vram, SX, SY, pitch);
+				src = Mode::shift(src, SX, DX);
+				Mode::pset(vram, DX, DY, pitch, src, WM, lut, LOG);
+				DX += dx;
+				SX += dx;
+			});
+		}
+		engineTime += delta * num;
+		steps -= num;
 
-		DX += dx;
-		SX += dx;
-		if (!--(ANX)) {
+		ANX -= num;
+		if (!ANX) {
 			DX -= (NX * dx);
 			SX -= (NX * dx);
 			DY += dy;
@@ -1764,6 +1902,15 @@ byte V9990CmdEngine::peekCmdData(EmuTime::param time) const
 	return (status & TR) ? data : 0xFF;
 }
 
+unsigned V9990CmdEngine::getStepsUntil(EmuTime::param limit, EmuDuration::param delta) const
+{
+	if (engineTime >= limit) return 0;
+	// broken (instantaneous) timing: run till the end of the command
+	if (delta == EmuDuration::zero()) return std::numeric_limits<unsigned>::max();
+	uint64_t steps = ((limit - engineTime).length() + delta.length() - 1) / delta.length();
+	return unsigned(std::min<uint64_t>(steps, std::numeric_limits<unsigned>::max()));
+}
+
 void V9990CmdEngine::cmdReady(EmuTime::param /*time*/)
 {
 	CMD = 0; // for deserialize
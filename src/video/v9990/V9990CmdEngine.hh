@@ -316,6 +316,13 @@ private:
 	 */
 	bool brokenTiming;
 
+	/** The number of steps (e.g. pixels) of the running command that can
+	  * be executed before 'limit' when each step takes 'delta'. Like in
+	  * a 'while (engineTime < limit) engineTime += delta;' loop, a step
+	  * that starts before 'limit' is counted.
+	  */
+	[[nodiscard]] unsigned getStepsUntil(EmuTime::param limit, EmuDuration::param delta) const;
+
 	/** The running command is complete. Perform necessary clean-up actions.
 	  */
 	void cmdReady(EmuTime::param time);
@@ -9,6 +9,7 @@
 #include "VideoSourceSetting.hh"
 #include "Event.hh"
 #include "RealTime.hh"
+#include "PerfTimers.hh"
 #include "Timer.hh"
 #include "EventDistributor.hh"
 #include "MSXMotherBoard.hh"
@@ -151,6 +152,7 @@ void V9990PixelRenderer::sync(EmuTime::param time, bool force)
 
 void V9990PixelRenderer::renderUntil(EmuTime::param time)
 {
+	PerfTimers::Scope perf(PerfTimers::VDP_RENDER);
 	// Translate time to pixel position
 	int limitTicks = vdp.getUCTicksThisFrame(time);
 	assert(limitTicks <=
@@ -34,6 +34,10 @@ struct P1Policy {
 	static byte readSpriteAttr(V9990VRAM& vram, unsigned addr) {
 		return vram.readVRAMP1(addr);
 	}
+	// Mark the VRAM blocks of a line (4 bytes) of a pattern as used.
+	static void markPattern(V9990VRAMBlocks& blocks, unsigned addr) {
+		blocks.add(V9990VRAM::transformP1(addr));
+	}
 	static unsigned spritePatOfst(byte spriteNo, byte spriteY) {
 		return (128 * ((spriteNo & 0xF0) + spriteY))
 		     + (  8 *  (spriteNo & 0x0F));
@@ -72,6 +76,11 @@ struct P2Policy {
 	static byte readSpriteAttr(V9990VRAM& vram, unsigned addr) {
 		return vram.readVRAMDirect(addr);
 	}
+	static void markPattern(V9990VRAMBlocks& blocks, unsigned addr) {
+		// even and odd bytes are in different halves of the VRAM
+		blocks.add(V9990VRAM::transformBx(addr + 0));
+		blocks.add(V9990VRAM::transformBx(addr + 1));
+	}
 	static unsigned spritePatOfst(byte spriteNo, byte spriteY) {
 		return (256 * (((spriteNo & 0xE0) >> 1) + spriteY))
 		     + (  8 *  (spriteNo & 0x1F));
@@ -92,7 +101,8 @@ struct P2Policy {
 
 template<typename Policy, bool ALIGNED>
 static unsigned getPatternAddress(
-	V9990VRAM& vram, unsigned nameAddr, unsigned patternBase, unsigned x, unsigned y)
+	V9990VRAM& vram, V9990VRAMBlocks& blocks,
+	unsigned nameAddr, unsigned patternBase, unsigned x, unsigned y)
 {
 	assert(!ALIGNED || ((x & 7) == 0));
 	unsigned patternNum = (Policy::readNameTable(vram, nameAddr + 0) +
@@ -100,7 +110,9 @@ static unsigned getPatternAddress(
 	constexpr auto PATTERN_PITCH = Policy::PATTERN_CHARS * 8 * (8 / 2);
 	unsigned x2 = (patternNum % Policy::PATTERN_CHARS) * 4 + (ALIGNED ? 0 : ((x & 7) / 2));
 	unsigned y2 = (patternNum / Policy::PATTERN_CHARS) * PATTERN_PITCH + y;
-	return patternBase + y2 + x2;
+	unsigned address = patternBase + y2 + x2;
+	Policy::markPattern(blocks, address);
+	return address;
 }
 
 template<typename Policy>
@@ -127,7 +139,8 @@ static void draw2(
 
 template<typename Policy, typename Pixel>
 static void renderPattern(
-	V9990VRAM& vram, Pixel* __restrict buffer, byte* __restrict info,
+	V9990VRAM& vram, V9990VRAMBlocks& blocks,
+	Pixel* __restrict buffer, byte* __restrict info,
 	Pixel bgCol, int width, unsigned x, unsigned y,
 	unsigned nameTable, unsigned patternBase, const Pixel* palette0, const Pixel* palette1)
 {
@@ -146,9 +159,12 @@ static void renderPattern(
 
 	unsigned nameAddr = nameTable + (((y / 8) * Policy::NAME_CHARS + (x / 8)) * 2);
 	y = (y & 7) * Policy::NAME_CHARS * 2;
+	// The name table is read directly (P2) or in the P1 layout (that's
+	// the same), and a row of names never crosses a block boundary.
+	blocks.add(nameAddr);
 
 	if (x & 7) {
-		unsigned address = getPatternAddress<Policy, false>(vram, nameAddr, patternBase, x, y);
+		unsigned address = getPatternAddress<Policy, false>(vram, blocks, nameAddr, patternBase, x, y);
 		if (x & 1) {
 			byte data = Policy::readPatternTable(vram, address);
 			Policy::draw1((address & 1) ? palette1 : palette0, buffer, info, data & 0x0F);
@@ -166,7 +182,7 @@ static void renderPattern(
 	}
 	assert((x & 7) == 0 || (width <= 0));
 	while ((width & ~7) > 0) {
-		unsigned address = getPatternAddress<Policy, true>(vram, nameAddr, patternBase, x, y);
+		unsigned address = getPatternAddress<Policy, true>(vram, blocks, nameAddr, patternBase, x, y);
 		draw2<Policy, false>(vram, palette0, buffer, info, address, width);
 		draw2<Policy, false>(vram, palette1, buffer, info, address, width);
 		draw2<Policy, false>(vram, palette0, buffer, info, address, width);
@@ -175,7 +191,7 @@ static void renderPattern(
 	}
 	assert(width < 8);
 	if (width > 0) {
-		unsigned address = getPatternAddress<Policy, true>(vram, nameAddr, patternBase, x, y);
+		unsigned address = getPatternAddress<Policy, true>(vram, blocks, nameAddr, patternBase, x, y);
 		do {
 			draw2<Policy, true>(vram, (address & 1) ? palette1 : palette0, buffer, info, address, width);
 		} while (width > 0);
@@ -184,12 +200,13 @@ static void renderPattern(
 
 template<typename Policy, typename Pixel> // only used for P1
 static void renderPattern2(
-	V9990VRAM& vram, Pixel* buffer, byte* info, Pixel bgCol, unsigned width1, unsigned width2,
+	V9990VRAM& vram, V9990VRAMBlocks& blocks,
+	Pixel* buffer, byte* info, Pixel bgCol, unsigned width1, unsigned width2,
 	unsigned displayAX, unsigned displayAY, unsigned nameA, unsigned patternA, const Pixel* palA,
 	unsigned displayBX, unsigned displayBY, unsigned nameB, unsigned patternB, const Pixel* palB)
 {
 	renderPattern<Policy>(
-		vram, buffer, info, bgCol, width1,
+		vram, blocks, buffer, info, bgCol, width1,
 		displayAX, displayAY, nameA, patternA, palA, palA);
 
 	buffer += width1;
@@ -198,7 +215,7 @@ static void renderPattern2(
 	displayBX = (displayBX + width1) & 511;
 
 	renderPattern<Policy>(
-		vram, buffer, info, bgCol, width2,
+		vram, blocks, buffer, info, bgCol, width2,
 		displayBX, displayBY, nameB, patternB, palB, palB);
 }
 
@@ -267,9 +284,9 @@ static void renderSprites(
 
 template<typename Pixel>
 void V9990P1Converter<Pixel>::convertLine(
-	Pixel* linePtr, unsigned displayX, unsigned displayWidth,
+	Pixel* linePtr, byte* info, unsigned displayX, unsigned displayWidth,
 	unsigned displayY, unsigned displayYA, unsigned displayYB,
-	bool drawSprites)
+	V9990VRAMBlocks& blocks)
 {
 	unsigned prioX = vdp.getPriorityControlX();
 	unsigned prioY = vdp.getPriorityControlY();
@@ -296,32 +313,35 @@ void V9990P1Converter<Pixel>::convertLine(
 	const Pixel* palA = palette64 + ((offset & 0x03) << 4);
 	const Pixel* palB = palette64 + ((offset & 0x0C) << 2);
 	renderPattern2<P1BackgroundPolicy>(
-		vram, linePtr, nullptr, bgCol, end1, displayWidth,
+		vram, blocks, linePtr, nullptr, bgCol, end1, displayWidth,
 		displayBX, displayBY, 0x7E000, 0x40000, palB,
 		displayAX, displayAY, 0x7C000, 0x00000, palA);
 
 	// foreground + fill-in 'info'
+	// 0->background, 1->foreground, 2->sprite (front or back)
 	assert(displayWidth <= 256);
-	byte info[256]; // left uninitialized
-	                // 0->background, 1->foreground, 2->sprite (front or back)
 	renderPattern2<P1ForegroundPolicy>(
-		vram, linePtr, info, bgCol, end1, displayWidth,
+		vram, blocks, linePtr, info, bgCol, end1, displayWidth,
 		displayAX, displayAY, 0x7C000, 0x00000, palA,
 		displayBX, displayBY, 0x7E000, 0x40000, palB);
+}
 
+template<typename Pixel>
+void V9990P1Converter<Pixel>::drawSprites(
+	Pixel* linePtr, byte* info, unsigned displayX, unsigned displayWidth,
+	unsigned displayY)
+{
 	// combined back+front sprite plane
-	if (drawSprites) {
-		unsigned spritePatternTable = vdp.getSpritePatternAddress(P1);
-		renderSprites<P1Policy>(
-			vram, spritePatternTable, palette64,
-			linePtr, info, displayX, displayEnd, displayY);
-	}
+	unsigned spritePatternTable = vdp.getSpritePatternAddress(P1);
+	renderSprites<P1Policy>(
+		vram, spritePatternTable, palette64,
+		linePtr, info, displayX, displayX + displayWidth, displayY);
 }
 
 template<typename Pixel>
 void V9990P2Converter<Pixel>::convertLine(
-	Pixel* linePtr, unsigned displayX, unsigned displayWidth,
-	unsigned displayY, unsigned displayYA, bool drawSprites)
+	Pixel* linePtr, byte* info, unsigned displayX, unsigned displayWidth,
+	unsigned displayYA, V9990VRAMBlocks& blocks)
 {
 	unsigned displayAX = (displayX + vdp.getScrollAX()) & 1023;
 
@@ -330,27 +350,28 @@ void V9990P2Converter<Pixel>::convertLine(
 	unsigned scrollYBase = scrollY & ~rollMask & 0x1FF;
 	unsigned displayAY = scrollYBase + ((displayYA + scrollY) & rollMask);
 
-	unsigned displayEnd = displayX + displayWidth;
-
 	// image plane + backdrop color + fill-in 'info'
+	// 0->background, 1->foreground, 2->sprite (front or back)
 	assert(displayWidth <= 512);
-	byte info[512]; // left uninitialized
-	                // 0->background, 1->foreground, 2->sprite (front or back)
 	Pixel bgCol = palette64[vdp.getBackDropColor()];
 	byte offset = vdp.getPaletteOffset();
 	const Pixel* palette0 = palette64 + ((offset & 0x03) << 4);
 	const Pixel* palette1 = palette64 + ((offset & 0x0C) << 2);
 	renderPattern<P2Policy>(
-		vram, linePtr, info, bgCol, displayWidth,
+		vram, blocks, linePtr, info, bgCol, displayWidth,
 		displayAX, displayAY, 0x7C000, 0x00000, palette0, palette1);
+}
 
+template<typename Pixel>
+void V9990P2Converter<Pixel>::drawSprites(
+	Pixel* linePtr, byte* info, unsigned displayX, unsigned displayWidth,
+	unsigned displayY)
+{
 	// combined back+front sprite plane
-	if (drawSprites) {
-		unsigned spritePatternTable = vdp.getSpritePatternAddress(P2);
-		renderSprites<P2Policy>(
-			vram, spritePatternTable, palette64,
-			linePtr, info, displayX, displayEnd, displayY);
-	}
+	unsigned spritePatternTable = vdp.getSpritePatternAddress(P2);
+	renderSprites<P2Policy>(
+		vram, spritePatternTable, palette64,
+		linePtr, info, displayX, displayX + displayWidth, displayY);
 }
 
 // Force template instantiation
@@ -1,10 +1,21 @@
 #ifndef V9990PXCONVERTER_HH
 #define V9990PXCONVERTER_HH
 
+#include "openmsx.hh"
+
 namespace openmsx {
 
 class V9990;
 class V9990VRAM;
+class V9990VRAMBlocks;
+
+// Both converters work in two steps, so that the result of the first
+// (more expensive) step can be reused as long as the VRAM and the registers
+// it depends on don't change:
+// - convertLine() renders the pattern layer(s) and the backdrop color, it
+//   adds the VRAM blocks it read to 'blocks' and fills in 'info' (one byte
+//   per pixel) for the next step.
+// - drawSprites() draws the sprites on top. This modifies 'info'.
 
 template<typename Pixel>
 class V9990P1Converter
@@ -13,9 +24,12 @@ public:
 	V9990P1Converter(V9990& vdp, const Pixel* palette64);
 
 	void convertLine(
-		Pixel* linePtr, unsigned displayX, unsigned displayWidth,
+		Pixel* linePtr, byte* info, unsigned displayX, unsigned displayWidth,
 		unsigned displayY, unsigned displayYA, unsigned displayYB,
-		bool drawSprites);
+		V9990VRAMBlocks& blocks);
+	void drawSprites(
+		Pixel* linePtr, byte* info, unsigned displayX, unsigned displayWidth,
+		unsigned displayY);
 
 private:
 	V9990& vdp;
@@ -30,8 +44,11 @@ public:
 	V9990P2Converter(V9990& vdp, const Pixel* palette64);
 
 	void convertLine(
-		Pixel* linePtr, unsigned displayX, unsigned displayWidth,
-		unsigned displayY, unsigned displayYA, bool drawSprites);
+		Pixel* linePtr, byte* info, unsigned displayX, unsigned displayWidth,
+		unsigned displayYA, V9990VRAMBlocks& blocks);
+	void drawSprites(
+		Pixel* linePtr, byte* info, unsigned displayX, unsigned displayWidth,
+		unsigned displayY);
 
 private:
 	V9990& vdp;
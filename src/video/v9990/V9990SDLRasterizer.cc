@@ -13,6 +13,7 @@
 #include "components.hh"
 #include <algorithm>
 #include <cstdint>
+#include <cstring>
 #include <memory>
 
 namespace openmsx {
@@ -23,7 +24,7 @@ V9990SDLRasterizer<Pixel>::V9990SDLRasterizer(
 		std::unique_ptr<PostProcessor> postProcessor_)
 	: vdp(vdp_), vram(vdp.getVRAM())
 	, screen(screen_)
-	, workFrame(std::make_unique<RawFrame>(screen.getPixelFormat(), 1280, 240))
+	, workFrame(std::make_shared<RawFrame>(screen.getPixelFormat(), 1280, 240))
 	, renderSettings(display.getRenderSettings())
 	, displayMode(P1) // dummy value
 	, colorMode(PP)   //   avoid UMR
@@ -31,10 +32,14 @@ V9990SDLRasterizer<Pixel>::V9990SDLRasterizer(
 	, bitmapConverter(vdp, palette64, palette64_32768, palette256, palette256_32768, palette32768)
 	, p1Converter(vdp, palette64)
 	, p2Converter(vdp, palette64)
+	, linePixels(CACHE_LINES * CACHE_LINE_WIDTH)
+	, lineInfo(CACHE_LINES * CACHE_INFO_WIDTH)
 {
 	// Fill palettes
 	preCalcPalettes();
 
+	vram.setObserver(this);
+
 	renderSettings.getGammaSetting()      .attach(*this);
 	renderSettings.getBrightnessSetting() .attach(*this);
 	renderSettings.getContrastSetting()   .attach(*this);
@@ -44,6 +49,9 @@ V9990SDLRasterizer<Pixel>::V9990SDLRasterizer(
 template<typename Pixel>
 V9990SDLRasterizer<Pixel>::~V9990SDLRasterizer()
 {
+	// a new rasterizer may already have replaced this one
+	if (vram.getObserver() == this) vram.setObserver(nullptr);
+
 	renderSettings.getColorMatrixSetting().detach(*this);
 	renderSettings.getGammaSetting()      .detach(*this);
 	renderSettings.getBrightnessSetting() .detach(*this);
@@ -60,8 +68,7 @@ template<typename Pixel>
 bool V9990SDLRasterizer<Pixel>::isActive()
 {
 	return postProcessor->needRender() &&
-	       vdp.getMotherBoard().isActive() &&
-	       !vdp.getMotherBoard().isFastForwarding();
+	       vdp.getMotherBoard().needRender();
 }
 
 template<typename Pixel>
@@ -90,6 +97,11 @@ void V9990SDLRasterizer<Pixel>::frameStart()
 	// but still 240 lines per frame.
 	lineRenderTop = verTiming.blank + verTiming.border1 +
 	                (verTiming.display - SCREEN_HEIGHT) / 2;
+
+	if (paletteDirty) {
+		paletteDirty = false;
+		preCalcPalettes();
+	}
 }
 
 template<typename Pixel>
@@ -219,11 +231,32 @@ void V9990SDLRasterizer<Pixel>::drawP1Mode(
 	int displayY, int displayYA, int displayYB,
 	int displayWidth, int displayHeight, bool drawSprites)
 {
+	// This is everything V9990P1Converter::convertLine() reads from the VDP.
+	LineState state = {
+		P1, unsigned(displayX), unsigned(displayWidth), 0, 0, 0,
+		vdp.getScrollAX(), vdp.getScrollBX(),
+		vdp.getScrollAY(), vdp.getScrollBY(), vdp.getRollMask(0x1FF),
+		vdp.getPriorityControlX(), vdp.getPriorityControlY(),
+		vdp.getBackDropColor(), vdp.getPaletteOffset(), 0,
+	};
 	while (displayHeight--) {
 		Pixel* pixelPtr = workFrame->getLinePtrDirect<Pixel>(fromY) + fromX;
-		p1Converter.convertLine(pixelPtr, displayX, displayWidth,
-		                        displayY, displayYA, displayYB,
-		                        drawSprites);
+		state[3] = displayY;
+		state[4] = displayYA;
+		state[5] = displayYB;
+		CachedLine* line;
+		if (!lookupLine(fromY, state, line)) {
+			p1Converter.convertLine(getCachedPixels(*line), getCachedInfo(*line),
+			                        displayX, displayWidth,
+			                        displayY, displayYA, displayYB,
+			                        line->blocks);
+		}
+		memcpy(pixelPtr, getCachedPixels(*line), displayWidth * sizeof(Pixel));
+		if (drawSprites) {
+			byte info[256];
+			memcpy(info, getCachedInfo(*line), displayWidth);
+			p1Converter.drawSprites(pixelPtr, info, displayX, displayWidth, displayY);
+		}
 		workFrame->setLineWidth(fromY, 320);
 		++fromY;
 		++displayY;
@@ -237,10 +270,28 @@ void V9990SDLRasterizer<Pixel>::drawP2Mode(
 	int fromX, int fromY, int displayX, int displayY, int displayYA,
 	int displayWidth, int displayHeight, bool drawSprites)
 {
+	// This is everything V9990P2Converter::convertLine() reads from the VDP.
+	LineState state = {
+		P2, unsigned(displayX), unsigned(displayWidth), 0,
+		vdp.getScrollAX(), vdp.getScrollAY(), vdp.getRollMask(0x1FF),
+		vdp.getBackDropColor(), vdp.getPaletteOffset(),
+		0, 0, 0, 0, 0, 0, 0,
+	};
 	while (displayHeight--) {
 		Pixel* pixelPtr = workFrame->getLinePtrDirect<Pixel>(fromY) + fromX;
-		p2Converter.convertLine(pixelPtr, displayX, displayWidth,
-		                        displayY, displayYA, drawSprites);
+		state[3] = displayYA;
+		CachedLine* line;
+		if (!lookupLine(fromY, state, line)) {
+			p2Converter.convertLine(getCachedPixels(*line), getCachedInfo(*line),
+			                        displayX, displayWidth, displayYA,
+			                        line->blocks);
+		}
+		memcpy(pixelPtr, getCachedPixels(*line), displayWidth * sizeof(Pixel));
+		if (drawSprites) {
+			byte info[512];
+			memcpy(info, getCachedInfo(*line), displayWidth);
+			p2Converter.drawSprites(pixelPtr, info, displayX, displayWidth, displayY);
+		}
 		workFrame->setLineWidth(fromY, 640);
 		++fromY;
 		++displayY;
@@ -269,6 +320,13 @@ void V9990SDLRasterizer<Pixel>::drawBxMode(
 	unsigned rollMask = vdp.getRollMask(0x1FFF);
 	unsigned scrollYBase = scrollY & ~rollMask & 0x1FFF;
 	int cursorY = displayY - vdp.getCursorYOffset();
+	// This is everything V9990BitmapConverter::convertLine() reads from
+	// the VDP (when no cursor is visible).
+	LineState state = {
+		unsigned(displayMode), unsigned(colorMode), x, 0, unsigned(displayWidth),
+		vdp.getImageWidth(), vdp.getPaletteOffset(), vdp.isSuperimposing(),
+		0, 0, 0, 0, 0, 0, 0, 0,
+	};
 	while (displayHeight--) {
 		// Note: convertLine() can draw up to 3 pixels too many. But
 		// that's ok, the buffer is big enough: buffer can hold 1280
@@ -277,8 +335,19 @@ void V9990SDLRasterizer<Pixel>::drawBxMode(
 		// plus 3 pixels cannot go beyond the end of the buffer.
 		unsigned y = scrollYBase + ((displayYA + scrollY) & rollMask);
 		Pixel* pixelPtr = workFrame->getLinePtrDirect<Pixel>(fromY) + fromX;
-		bitmapConverter.convertLine(pixelPtr, x, y, displayWidth,
-		                            cursorY, drawSprites);
+		if (drawSprites && bitmapConverter.isCursorVisible(cursorY, true)) {
+			bitmapConverter.convertLine(pixelPtr, x, y, displayWidth,
+			                            cursorY, true);
+		} else {
+			state[3] = y;
+			CachedLine* line;
+			if (!lookupLine(fromY, state, line)) {
+				bitmapConverter.addLineBlocks(x, y, displayWidth, line->blocks);
+				bitmapConverter.convertLine(getCachedPixels(*line), x, y,
+				                            displayWidth, cursorY, false);
+			}
+			memcpy(pixelPtr, getCachedPixels(*line), displayWidth * sizeof(Pixel));
+		}
 		workFrame->setLineWidth(fromY, vdp.getLineWidth());
 		++fromY;
 		displayYA += lineStep;
@@ -337,10 +406,14 @@ template<typename Pixel>
 void V9990SDLRasterizer<Pixel>::setPalette(int index,
                                            byte r, byte g, byte b, bool ys)
 {
-	auto idx32768 = ((g & 31) << 10) | ((r & 31) << 5) | ((b & 31) << 0);
+	int16_t idx32768 = ((g & 31) << 10) | ((r & 31) << 5) | ((b & 31) << 0);
+	Pixel newColor = ys ? screen.getKeyColor<Pixel>() : palette32768[idx32768];
+	if ((palette64_32768[index & 63] != idx32768) ||
+	    (palette64[index & 63] != newColor)) {
+		invalidateLineCache();
+	}
 	palette64_32768[index & 63] = idx32768; // TODO what with ys?
-	palette64[index & 63] = ys ? screen.getKeyColor<Pixel>()
-	                           : palette32768[idx32768];
+	palette64[index & 63] = newColor;
 }
 
 template<typename Pixel>
@@ -354,6 +427,7 @@ void V9990SDLRasterizer<Pixel>::resetPalette()
 	palette256[0] = vdp.isSuperimposing() ? screen.getKeyColor<Pixel>()
 	                                      : palette32768[0];
 	// TODO what with palette256_32768[0]?
+	invalidateLineCache();
 }
 
 template<typename Pixel>
@@ -375,10 +449,69 @@ void V9990SDLRasterizer<Pixel>::update(const Setting& setting) noexcept
 	                       &renderSettings.getBrightnessSetting(),
 	                       &renderSettings.getContrastSetting(),
 	                       &renderSettings.getColorMatrixSetting())) {
-		preCalcPalettes();
+		paletteDirty = true; // see SDLRasterizer::update()
+	}
+}
+
+template<typename Pixel>
+void V9990SDLRasterizer<Pixel>::updateVRAM(unsigned address, unsigned num)
+{
+	// Note: the rendering is not synchronized with VRAM writes (the
+	// converters read the VRAM content at the moment a line is drawn),
+	// so the exact time of the write doesn't matter either.
+	constexpr auto BITS = V9990VRAMBlocks::BLOCK_BITS;
+	unsigned first = address >> BITS;
+	unsigned last = std::min((address + num - 1) >> BITS,
+	                         V9990VRAMBlocks::NUM_BLOCKS - 1);
+	for (auto block : xrange(first, last + 1)) {
+		blockStamp[block] = vramStamp;
 	}
 }
 
+template<typename Pixel>
+bool V9990SDLRasterizer<Pixel>::lookupLine(
+	int screenY, const LineState& state, CachedLine*& line)
+{
+	// Separate entries for the even and odd field, in interlace and
+	// even/odd mode these show different lines.
+	bool odd = (vdp.isInterlaced() || vdp.isEvenOddEnabled()) && vdp.getEvenOdd();
+	assert((0 <= screenY) && (screenY < int(SCREEN_HEIGHT)));
+	line = &lineCache[screenY + (odd ? SCREEN_HEIGHT : 0)];
+
+	if (line->valid && (line->state == state)) {
+		bool changed = false;
+		line->blocks.forEach([&](unsigned block) {
+			changed |= blockStamp[block] > line->stamp;
+		});
+		if (!changed) return true;
+	}
+	// Nothing can write VRAM during the conversion, writes after it get
+	// a higher stamp.
+	line->state = state;
+	line->blocks.clear();
+	line->stamp = vramStamp++;
+	line->valid = true;
+	return false;
+}
+
+template<typename Pixel>
+Pixel* V9990SDLRasterizer<Pixel>::getCachedPixels(const CachedLine& line)
+{
+	return &linePixels[(&line - lineCache.data()) * CACHE_LINE_WIDTH];
+}
+
+template<typename Pixel>
+byte* V9990SDLRasterizer<Pixel>::getCachedInfo(const CachedLine& line)
+{
+	return &lineInfo[(&line - lineCache.data()) * CACHE_INFO_WIDTH];
+}
+
+template<typename Pixel>
+void V9990SDLRasterizer<Pixel>::invalidateLineCache()
+{
+	for (auto& line : lineCache) line.valid = false;
+}
+
 // Force template instantiation.
 #if HAVE_16BPP
 template class V9990SDLRasterizer<uint16_t>;
@@ -4,14 +4,17 @@
 #include "V9990Rasterizer.hh"
 #include "V9990BitmapConverter.hh"
 #include "V9990PxConverter.hh"
+#include "V9990VRAM.hh"
+#include "MemBuffer.hh"
 #include "Observer.hh"
+#include <array>
+#include <cstdint>
 #include <memory>
 
 namespace openmsx {
 
 class Display;
 class V9990;
-class V9990VRAM;
 class RawFrame;
 class OutputSurface;
 class RenderSettings;
@@ -22,6 +25,7 @@ class PostProcessor;
   */
 template<typename Pixel>
 class V9990SDLRasterizer final : public V9990Rasterizer
+                               , private V9990VRAMObserver
                                , private Observer<Setting>
 {
 public:
@@ -67,6 +71,35 @@ public:
 	void update(const Setting& setting) noexcept override;
 
 private:
+	// V9990VRAMObserver
+	void updateVRAM(unsigned address, unsigned num) override;
+
+	/** Everything (but the VRAM content) a converted line depends on.
+	  * Unused elements are zero.
+	  */
+	using LineState = std::array<unsigned, 16>;
+
+	struct CachedLine {
+		LineState state;
+		V9990VRAMBlocks blocks; // the VRAM that was read
+		uint64_t stamp; // value of 'vramStamp' when converted
+		bool valid = false;
+	};
+
+	/** Get the cache entry for the given screen line. Returns true when
+	  * it (still) contains the converted line for the given state. If not,
+	  * the caller must convert the line into getCachedPixels() and
+	  * getCachedInfo(), and add the VRAM it reads to 'line.blocks'.
+	  */
+	[[nodiscard]] bool lookupLine(int screenY, const LineState& state,
+	                              CachedLine*& line);
+	[[nodiscard]] Pixel* getCachedPixels(const CachedLine& line);
+	[[nodiscard]] byte*  getCachedInfo  (const CachedLine& line);
+
+	/** Mark all cached lines as invalid.
+	  */
+	void invalidateLineCache();
+
 	/** screen width for SDLLo
 	  */
 	static constexpr int SCREEN_WIDTH  = 320;
@@ -89,7 +122,7 @@ private:
 
 	/** The next frame as it is delivered by the VDP, work in progress.
 	  */
-	std::unique_ptr<RawFrame> workFrame;
+	std::shared_ptr<RawFrame> workFrame;
 
 	/** The current renderer settings (gamma, brightness, contrast)
 	  */
@@ -100,6 +133,11 @@ private:
 	  */
 	int lineRenderTop;
 
+	/** Gamma, brightness, contrast or color matrix changed, recalculate
+	  * the palettes at the start of the next frame.
+	  */
+	bool paletteDirty = false;
+
 	/** First display column to draw.  Since the width of the VDP lines <=
 	  * the screen width, colZero is <= 0. The non-displaying parts of the
 	  * screen will be filled as border.
@@ -136,6 +174,21 @@ private:
 	V9990BitmapConverter<Pixel> bitmapConverter;
 	V9990P1Converter<Pixel> p1Converter;
 	V9990P2Converter<Pixel> p2Converter;
+
+	/** Cache of converted display lines (without sprites or cursors, those
+	  * are drawn on top each time), one entry per screen line per field.
+	  * An entry is valid as long as its state matches and none of the VRAM
+	  * blocks it read was written since it was converted ('blockStamp'
+	  * holds the value of 'vramStamp' at the moment of the last write).
+	  */
+	static constexpr unsigned CACHE_LINES = 2 * SCREEN_HEIGHT;
+	static constexpr unsigned CACHE_LINE_WIDTH = 1024 + 8;
+	static constexpr unsigned CACHE_INFO_WIDTH = 512;
+	std::array<CachedLine, CACHE_LINES> lineCache;
+	MemBuffer<Pixel> linePixels;
+	MemBuffer<byte> lineInfo;
+	std::array<uint64_t, V9990VRAMBlocks::NUM_BLOCKS> blockStamp = {};
+	uint64_t vramStamp = 1;
 };
 
 } // namespace openmsx
@@ -10,6 +10,9 @@ V9990VRAM::V9990VRAM(V9990& vdp_, EmuTime::param /*time*/)
 	, data(vdp.getDeviceConfig2(), vdp.getName() + " VRAM",
 	       "V9990 Video RAM", VRAM_SIZE)
 {
+	data.setDebugWriteCallback([this](unsigned address) {
+		if (observer) observer->updateVRAM(address, 1);
+	});
 }
 
 void V9990VRAM::clear()
@@ -23,6 +26,7 @@ void V9990VRAM::clear()
 		memset(d, 0x00, 512); d += 512;
 		memset(d, 0xff, 512); d += 512;
 	}
+	if (observer) observer->updateVRAM(0, size);
 }
 
 unsigned V9990VRAM::mapAddress(unsigned address)
@@ -48,13 +52,16 @@ byte V9990VRAM::readVRAMCPU(unsigned address, EmuTime::param time)
 void V9990VRAM::writeVRAMCPU(unsigned address, byte value, EmuTime::param time)
 {
 	sync(time);
-	data.write(mapAddress(address), value);
+	writeVRAMDirect(mapAddress(address), value);
 }
 
 template<typename Archive>
 void V9990VRAM::serialize(Archive& ar, unsigned /*version*/)
 {
 	ar.serialize("data", data);
+	if constexpr (Archive::IS_LOADER) {
+		if (observer) observer->updateVRAM(0, VRAM_SIZE);
+	}
 }
 INSTANTIATE_SERIALIZE_METHODS(V9990VRAM);
 
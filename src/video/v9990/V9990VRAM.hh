@@ -4,12 +4,70 @@
 #include "V9990CmdEngine.hh"
 #include "TrackedRam.hh"
 #include "EmuTime.hh"
+#include "Math.hh"
 #include "openmsx.hh"
+#include "ranges.hh"
+#include <array>
+#include <cstdint>
 
 namespace openmsx {
 
 class V9990;
 
+/** Interface for objects that want to be notified about V9990 VRAM writes,
+  * e.g. to invalidate cached render results.
+  */
+class V9990VRAMObserver
+{
+public:
+	/** Called after 'num' bytes starting at (physical) VRAM address
+	  * 'address' changed (or might have changed).
+	  */
+	virtual void updateVRAM(unsigned address, unsigned num) = 0;
+
+protected:
+	~V9990VRAMObserver() = default;
+};
+
+/** A set of (1kB) blocks of V9990 VRAM, e.g. the part of VRAM that a
+  * rendered line depends on. Like V9990VRAMObserver, this works on physical
+  * addresses (not the CPU view of the current display mode).
+  */
+class V9990VRAMBlocks
+{
+public:
+	static constexpr unsigned BLOCK_BITS = 10;
+	static constexpr unsigned NUM_BLOCKS = (512 * 1024) >> BLOCK_BITS;
+
+	void clear() { ranges::fill(bits, 0); }
+
+	void add(unsigned address) {
+		unsigned block = (address & 0x7FFFF) >> BLOCK_BITS;
+		bits[block / 32] |= 1u << (block % 32);
+	}
+	void addRange(unsigned address, unsigned num) {
+		if (num == 0) return;
+		for (unsigned block = (address & 0x7FFFF) >> BLOCK_BITS,
+		              last = ((address + num - 1) & 0x7FFFF) >> BLOCK_BITS;
+		     ; block = (block + 1) % NUM_BLOCKS) {
+			bits[block / 32] |= 1u << (block % 32);
+			if (block == last) break;
+		}
+	}
+
+	/** Call 'op' for the index of each block in this set. */
+	template<typename Op> void forEach(Op op) const {
+		for (unsigned i = 0; i < bits.size(); ++i) {
+			for (uint32_t b = bits[i]; b; b &= b - 1) {
+				op(32 * i + Math::findFirstSet(b) - 1);
+			}
+		}
+	}
+
+private:
+	std::array<uint32_t, NUM_BLOCKS / 32> bits = {};
+};
+
 /** Video RAM for the V9990.
   */
 class V9990VRAM
@@ -62,13 +120,13 @@ public:
 	}
 
 	inline void writeVRAMBx(unsigned address, byte value) {
-		data.write(transformBx(address), value);
+		writeVRAMDirect(transformBx(address), value);
 	}
 	inline void writeVRAMP1(unsigned address, byte value) {
-		data.write(transformP1(address), value);
+		writeVRAMDirect(transformP1(address), value);
 	}
 	inline void writeVRAMP2(unsigned address, byte value) {
-		data.write(transformP2(address), value);
+		writeVRAMDirect(transformP2(address), value);
 	}
 
 	[[nodiscard]] inline byte readVRAMDirect(unsigned address) {
@@ -76,6 +134,16 @@ public:
 	}
 	inline void writeVRAMDirect(unsigned address, byte value) {
 		data.write(address, value);
+		if (observer) observer->updateVRAM(address, 1);
+	}
+	/** Bulk access for the command engine, see TrackedRam::getWriteBackdoor().
+	  */
+	[[nodiscard]] inline byte* getWriteBackdoorDirect(unsigned address, unsigned num) {
+		if (observer) observer->updateVRAM(address, num);
+		return data.getWriteBackdoor(address, num);
+	}
+	[[nodiscard]] inline const byte* getReadBackdoorDirect(unsigned address) const {
+		return &data[address];
 	}
 
 	[[nodiscard]] byte readVRAMCPU(unsigned address, EmuTime::param time);
@@ -83,6 +151,11 @@ public:
 
 	void setCmdEngine(V9990CmdEngine& cmdEngine_) { cmdEngine = &cmdEngine_; }
 
+	/** There can be (at most) one observer, the active renderer.
+	  */
+	void setObserver(V9990VRAMObserver* newObserver) { observer = newObserver; }
+	[[nodiscard]] V9990VRAMObserver* getObserver() const { return observer; }
+
 	template<typename Archive>
 	void serialize(Archive& ar, unsigned version);
 
@@ -96,6 +169,8 @@ private:
 
 	V9990CmdEngine* cmdEngine;
 
+	V9990VRAMObserver* observer = nullptr;
+
 	/** V9990 VRAM data.
 	  */
 	TrackedRam data;
@@ -15,8 +15,8 @@ namespace openmsx {
 
 Video9000::Video9000(const DeviceConfig& config)
 	: MSXDevice(config)
-	, VideoLayer(getMotherBoard(), getName())
-	, videoSourceSetting(getMotherBoard().getVideoSource())
+	, VideoLayer(MSXDevice::getMotherBoard(), getName())
+	, videoSourceSetting(MSXDevice::getMotherBoard().getVideoSource())
 {
 	EventDistributor& distributor = getReactor().getEventDistributor();
 	distributor.registerEventListener(EventType::FINISH_FRAME, *this);
@@ -122,13 +122,23 @@ void Video9000::paint(OutputSurface& output)
 	activeLayer->paint(output);
 }
 
-void Video9000::takeRawScreenShot(unsigned height, const std::string& filename)
+void Video9000::takeRawScreenShot(
+	unsigned height, const std::string& filename, const PNG::SaveOptions& options)
 {
 	auto* layer = dynamic_cast<VideoLayer*>(activeLayer);
 	if (!layer) {
 		throw CommandException("TODO");
 	}
-	layer->takeRawScreenShot(height, filename);
+	layer->takeRawScreenShot(height, filename, options);
+}
+
+uint32_t Video9000::getRawFrameHash(unsigned height)
+{
+	auto* layer = dynamic_cast<VideoLayer*>(activeLayer);
+	if (!layer) {
+		throw CommandException("Active video source can't be hashed");
+	}
+	return layer->getRawFrameHash(height);
 }
 
 int Video9000::signalEvent(const Event& event) noexcept
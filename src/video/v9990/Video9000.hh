@@ -39,7 +39,9 @@ private:
 
 	// VideoLayer
 	void paint(OutputSurface& output) override;
-	void takeRawScreenShot(unsigned height, const std::string& filename) override;
+	void takeRawScreenShot(unsigned height, const std::string& filename,
+	                       const PNG::SaveOptions& options) override;
+	[[nodiscard]] uint32_t getRawFrameHash(unsigned height) override;
 
 	// EventListener
 	int signalEvent(const Event& event) noexcept override;